@@ -177,11 +177,17 @@
   //   interpolation on a set of grid
   //   points
   //
+  //   Tabulated flux read from a text or     "file"
+  //   binary file
+  //
   //   ROOT TH1                               "th1"
   //
   //   ROOT TGraph                            "tgraph"
   //
-  // All of the source types also require the use of the "neutrino" key,
+  //   Combination of several of the above    "composite"
+  //   (possibly for different neutrinos)
+  //
+  // All of the source types except "composite" also require the use of the "neutrino" key,
   // which specifies the species of neutrino emitted by the source. Valid
   // values for the "neutrino" key are neutrino PDG codes (±12, ±14, ±16)
   // and the strings "ve", "vebar", "vu", "vubar", "vt", and "vtbar".
@@ -266,6 +272,31 @@
   //  (logarithmic in energy, linear in probability density).
   //
   //
+  //  FLUX FILE
+  //
+  //  source: {
+  //    type: "file",
+  //    neutrino: "vu",
+  //    file: "my_flux.dat",    // Name of the flux file (searched for
+  //                            // on the MARLEY search path)
+  //    format: "text",         // "text" (default) or "binary"
+  //    rule: "linlin",         // Interpolation rule ("linlin" default)
+  //    energy_column: 0,       // Zero-based index of the energy column
+  //                            // (text files only, default 0)
+  //    flux_column: 1,         // Zero-based index of the flux column
+  //                            // (text files only, default 1)
+  //  },
+  //
+  //  This source type is intended for large tabulated fluxes (e.g., from
+  //  a beamline simulation). Text files contain one grid point per line
+  //  with columns separated by whitespace or commas. Blank lines and lines
+  //  beginning with '#' are ignored. Binary files contain consecutive
+  //  pairs of native-endian doubles giving the energy (MeV) and the flux.
+  //  The energies must be strictly increasing, and the flux values do not
+  //  need to be normalized. Only the "linlin" and "const" interpolation
+  //  rules are allowed. With "const", each flux value applies until the
+  //  next grid point, so the final value is ignored.
+  //
   //  TH1
   //
   //  source: {
@@ -291,6 +322,31 @@
   //                                 // retrieve it from the ROOT file)
   //  },
   //
+  //  COMPOSITE
+  //
+  //  source: {
+  //    type: "composite",
+  //    components: [
+  //      { weight: 1, type: "fermi-dirac", neutrino: "ve", Emin: 0,
+  //        Emax: 60, temperature: 3.5 },
+  //      { weight: 1, type: "fermi-dirac", neutrino: "vebar", Emin: 0,
+  //        Emax: 60, temperature: 5 },
+  //      { weight: 4, type: "fermi-dirac", neutrino: "vu", Emin: 0,
+  //        Emax: 60, temperature: 6 },
+  //    ],
+  //  },
+  //
+  //  Each element of the "components" array is a source specification of
+  //  any of the other types. The optional "weight" key (default 1) gives the
+  //  component's share of the total neutrino flux. The weights are
+  //  normalized automatically. The neutrino type and energy are sampled
+  //  together for each event using the flavor-specific cross sections, and
+  //  all components share a single Generator. The contribution of each
+  //  neutrino type to the flux-averaged total cross section (and thus its
+  //  expected fraction of the events) is written to the log. Monoenergetic
+  //  components may only be combined with other monoenergetic components
+  //  of the same energy.
+  //
   //
   // In this example configuration file, we've chosen a monoenergetic source.
   //
@@ -300,6 +356,257 @@
     energy: 15.0,          // MeV
   },
 
+  // REACTION TABLE (optional)
+  //
+  // By default, MARLEY evaluates the total cross section of every
+  // configured reaction each time it tries a reacting neutrino energy. For
+  // configurations with many reactions (e.g., detector materials with
+  // several target atoms), the "reaction_table_bins" key may be used to
+  // sample the energy and the reaction together from a table instead. The
+  // range of neutrino energies covered by the source is divided into the
+  // requested number of bins, and an upper bound on the flux-weighted cross
+  // section of each reaction is tabulated in each bin. A (bin, reaction)
+  // pair is chosen from the table, an energy is sampled uniformly within
+  // the bin, and the result is accepted or rejected using the exact cross
+  // section of that reaction alone. The distributions are the same as
+  // without the table, but the events produced for a given seed differ.
+  //
+  // More bins give tighter bounds (and fewer rejections) at the cost of a
+  // longer setup. A warning is printed if a bound turns out to be too low.
+  // The table is not used for monoenergetic sources or if the source
+  // sets "weight_flux" to false. A value of 0 (the default) disables it.
+  //
+  // reaction_table_bins: 200,
+
+  // PRIMARY EVENT CUTS (optional)
+  //
+  // The "primary_cuts" JSON object selects events based on the kinematics
+  // of the initial two-two scattering reaction. Rejected events are
+  // discarded before the (relatively expensive) nuclear de-excitation is
+  // simulated, which can greatly speed up jobs that only need events in a
+  // limited region of phase space. When cuts are used, each de-excitation
+  // is simulated with its own random number sub-stream, and the residue is
+  // rotated to the projectile direction before it decays. The accepted
+  // events therefore differ from the events of a run without cuts that
+  // uses the same seed, although they follow the same distributions. If
+  // "do_deexcitations" is false, then the accepted events are exactly the
+  // events from a run without cuts that pass them.
+  //
+  // Each cut is given as a two-element array [ min, max ]. Either bound
+  // may be null. The available variables are
+  //
+  //   - projectile_KE: Kinetic energy of the projectile (MeV)
+  //   - ejectile_KE: Kinetic energy of the ejectile (MeV)
+  //   - ejectile_cos_theta: Cosine of the angle between the ejectile and
+  //                         the projectile
+  //   - Ex: Excitation energy of the residue just after the two-two
+  //         scatter (MeV)
+  //
+  // The fraction of events that pass the cuts is estimated at startup by
+  // sampling "pilot_events" primary events (default 100000) with a separate
+  // random number stream. The flux-averaged total cross section written to
+  // the output files is multiplied by this efficiency.
+  //
+  // primary_cuts: {
+  //   ejectile_KE: [ 5.0, null ],
+  //   ejectile_cos_theta: [ 0.5, 1.0 ],
+  //   pilot_events: 100000,
+  // },
+
+  // SYSTEMATIC UNIVERSES (optional)
+  //
+  // The "universes" JSON array requests a set of alternate physics models
+  // ("universes") for which an event weight is computed alongside each
+  // generated event. The events themselves are always sampled using the
+  // nominal model, so enabling universes does not change them. The weight
+  // for a universe is the ratio of the probability of the sampled history
+  // in that universe to its probability in the nominal model. Each element
+  // of the array is a JSON object describing either a single universe or a
+  // group of randomly thrown universes.
+  //
+  // A single universe accepts the following keys, all of which are
+  // optional:
+  //
+  //   - name: A unique label without whitespace (default "universe_<i>",
+  //           where <i> is the position in the array)
+  //   - gt_scale: Multiplies the strength of Gamow-Teller transitions
+  //   - fermi_scale: Multiplies the strength of Fermi transitions
+  //   - coulomb_mode: Alternate Coulomb correction for charged-current
+  //                   reactions ("none", "Fermi", "EMA", "MEMA",
+  //                   "Fermi-EMA", or "Fermi-MEMA")
+  //   - width_scales: Object that multiplies the partial decay widths for
+  //                   emission of each fragment. Allowed keys are "gamma",
+  //                   "n", "p", "d", "t", "he3", and "alpha".
+  //   - continuum_scale: Multiplies all partial decay widths to the
+  //                      unbound continuum
+  //   - level_density_slope: Multiplies the level density in the unbound
+  //                          continuum by exp[k*(Ex - Ec)], where k is the
+  //                          value of this key (MeV^(-1), default 0) and Ec
+  //                          is the energy at which the continuum begins.
+  //                          This changes the shape of the excitation
+  //                          energy spectrum, much like a change in the
+  //                          nuclear temperature. Each continuum decay step
+  //                          is weighted by the ratio of the differential
+  //                          widths at the sampled energy. Universes that
+  //                          use this key roughly double the cost of each
+  //                          Hauser-Feshbach decay step, since the partial
+  //                          widths to the continuum must be recomputed.
+  //
+  // A group of random universes is requested using the "throws" key. Each
+  // scale factor listed in the "sigma" object is drawn independently as
+  // max(0, 1 + sigma*N(0,1)) using a dedicated random number stream seeded
+  // by "seed" (default 1). The level_density_slope is drawn as
+  // sigma*N(0,1). The universes are named "<name>_<j>", where the name
+  // defaults to "random".
+  //
+  // The weights are saved in every output format except "hepevt" (HEPEVT
+  // readers would treat any extra entries in a record as particles). For
+  // "root" files, they are stored as part of each marley::Event object.
+  //
+  // universes: [
+  //   { name: "gt_up", gt_scale: 1.1 },
+  //   { name: "mema", coulomb_mode: "Fermi-MEMA" },
+  //   { name: "n_up", width_scales: { n: 1.2 } },
+  //   { name: "hotter", level_density_slope: -0.1 },
+  //   { throws: 100, seed: 123, name: "rand",
+  //     sigma: { gt_scale: 0.1, width_scales: { n: 0.2, gamma: 0.1 } } },
+  // ],
+
+  // TABULATED LEVEL DENSITIES (optional)
+  //
+  // By default, MARLEY computes nuclear level densities in the continuum
+  // using the back-shifted Fermi gas model. The "level_density_tables" JSON
+  // array may be used to replace that model for particular nuclides with
+  // microscopic level densities rho(Ex, J, Pi) read from files in the format
+  // of the RIPL-3 (and TALYS) Hartree-Fock-Bogoliubov tables, e.g., z018.tab
+  // for argon isotopes. Each element is a JSON object with the following
+  // keys:
+  //
+  //   - file: The name of the level density table file. It is located
+  //           using the MARLEY search path in the same way as the reaction
+  //           input files.
+  //
+  //   - nuclides: An array of PDG codes for the nuclides whose level
+  //               densities should be taken from the file
+  //
+  // The tables are interpolated logarithmically in Ex. The back-shifted Fermi
+  // gas model is still used outside of the tabulated excitation energy range
+  // and for spins beyond the last tabulated one.
+  //
+  // level_density_tables: [
+  //   { file: "z017.tab", nuclides: [ 1000170390, 1000170400 ] },
+  //   { file: "z019.tab", nuclides: [ 1000190390, 1000190400 ] },
+  // ],
+
+  // NUMERICAL RESOLUTION (optional)
+  //
+  // The following keys control the accuracy (and cost) of the
+  // Hauser-Feshbach calculations used to simulate decays to the unbound
+  // continuum:
+  //
+  //   - fragment_lmax: Maximum orbital angular momentum for fragment
+  //                    emission (default 5)
+  //
+  //   - gamma_lmax: Maximum multipolarity for gamma-ray emission (default 5)
+  //
+  //   - numerov_step_size: Step size (fm) used to integrate the
+  //                        Schrodinger equation when computing optical model
+  //                        transmission coefficients (default 0.1)
+  //
+  //   - continuum_quadrature_order: Total decay widths to the continuum are
+  //                                 integrated using 2N + 1 Clenshaw-Curtis
+  //                                 points, where N is the value of this key
+  //                                 (default 50)
+  //
+  //   - continuum_chebyshev_points: Number of Chebyshev points used to
+  //                                 approximate the distribution of final
+  //                                 excitation energies in the continuum
+  //                                 (default 64)
+  //
+  //   - continuum_sampling_tolerance: Bisection tolerance (MeV) used when
+  //                                   sampling final excitation energies
+  //                                   in the continuum (default 1e-12)
+  //
+  // Good values depend on the target nucleus and on the neutrino energies
+  // of interest. The martune program runs a short pilot calculation for a
+  // configuration file, compares cheaper settings to a high-resolution
+  // reference, and writes a copy of the configuration that uses the fastest
+  // settings that meet a requested tolerance.
+  //
+  // numerov_step_size: 0.1,
+  // continuum_quadrature_order: 50,
+  // continuum_chebyshev_points: 64,
+  // continuum_sampling_tolerance: 1e-12,
+
+  // TRANSMISSION COEFFICIENT TABLES (optional)
+  //
+  // Most of the time spent simulating nuclear de-excitations goes into
+  // computing optical model transmission coefficients for fragment
+  // emission. If the "transmission_tables" JSON object is present, the first
+  // request for the coefficients of a given fragment and final nucleus
+  // queues the construction of a lookup table on low-priority background
+  // threads. MARLEY keeps using the direct calculation until the table is
+  // finished and then switches to it. Progress is shown in the status
+  // display of the marley executable. The available keys are
+  //
+  //   - tolerance: Relative tolerance for the tabulated coefficients
+  //                (default 1e-3). The energy grid of each table is refined
+  //                until this tolerance is met. Coefficients that still
+  //                miss it on the finest grid are computed directly.
+  //
+  //   - max_energy: Maximum fragment kinetic energy in the CM frame (MeV)
+  //                 to tabulate (default 100). The direct calculation is
+  //                 used at higher energies.
+  //
+  //   - threads: Number of background threads (default 1)
+  //
+  // The tables only run on CPU time that event generation leaves idle. Since
+  // the point at which each table is first used depends on timing, events
+  // are reproducible from the random number seed only up to the stated
+  // tolerance when this option is enabled. For that reason, it may not be
+  // combined with virtual output files, job queues, or projectile streams,
+  // which promise exactly reproducible events.
+  //
+  // transmission_tables: { tolerance: 1e-3, max_energy: 100., threads: 1 },
+
+  // DECAY-ONLY MODE (optional)
+  //
+  // If the "initial_states" key is present, the marley executable skips the
+  // simulation of neutrino reactions and instead applies the nuclear
+  // de-excitation model to nuclei prepared in the listed initial states. The
+  // "reactions" and "source" keys are not needed in this mode, and the
+  // flux-averaged total cross section written to the output files is zero.
+  //
+  // Each element of the "initial_states" array is a JSON object with the
+  // following keys:
+  //
+  //   - nuclide: The PDG code of the excited nucleus
+  //
+  //   - Ex: The excitation energy (MeV). This may be a single number or a
+  //         two-element array [ Ex_min, Ex_max ]. In the latter case,
+  //         excitation energies are sampled uniformly from the range.
+  //
+  //   - twoJ: Two times the nuclear spin
+  //
+  //   - parity: The nuclear parity ("+", "-", 1, or -1)
+  //
+  //   - weight: The relative probability of choosing this initial state
+  //             (optional, default 1)
+  //
+  // Initial states below the unbound threshold are moved to the closest
+  // discrete nuclear level, whose spin and parity are then used instead of
+  // the ones given here. In each event, the excited nucleus appears as both
+  // the target and the residue, while the projectile and ejectile are dummy
+  // particles with a PDG code of zero. The events are produced in parallel
+  // (see the "threads" key in the executable settings), and a table of
+  // branching ratios for each decay channel is logged at the end of the run.
+  //
+  // initial_states: [
+  //   { nuclide: 1000190400, Ex: 15.0, twoJ: 2, parity: "+" },
+  //   { nuclide: 1000190400, Ex: [ 8.0, 20.0 ], twoJ: 2, parity: "-",
+  //     weight: 0.5 },
+  // ],
+
   // EXECUTABLE SETTINGS (optional)
   //
   // The entries within the executable_settings JSON object are used to
@@ -318,6 +625,196 @@
     // If this key is omitted, a value of 1000 will be assumed.
     events: 100000,
 
+    // THREADS (optional)
+    //
+    // Number of threads used to produce events in decay-only mode (see the
+    // "initial_states" key above). A value of zero uses all available
+    // hardware threads, which is also the default. The sequence of events
+    // depends on both the random number seed and the number of threads.
+    // This key is currently ignored for ordinary reaction simulations.
+    //
+    // threads: 4,
+
+    // TIMELINE TRACE (optional)
+    //
+    // If present, the marley executable records the time spent in each
+    // stage of event generation (reaction sampling, the two-two scattering,
+    // rotation, each Hauser-Feshbach decay step, the gamma-ray cascade, and
+    // output) and writes it to a JSON file in the Chrome trace-event format
+    // at the end of the run. The file may be viewed by loading it into
+    // chrome://tracing or https://ui.perfetto.dev. The spans for each
+    // Hauser-Feshbach step show the PDG code, excitation energy, spin, and
+    // parity of the decaying nucleus. A "Cascade memory arena" counter
+    // shows the scratch memory used by each traced cascade and the memory
+    // reserved for it on that thread.
+    //
+    //   - file: Name of the trace file (default "marley_trace.json")
+    //
+    //   - event_fraction: Fraction of events to trace, between zero
+    //                     (exclusive) and one (default). Events are chosen
+    //                     at regular intervals. Tracing about 1% of events
+    //                     has little effect on the generation speed.
+    //
+    //   - max_spans: Maximum number of spans to store for each thread
+    //                (default 1000000). Later spans are discarded.
+    //
+    // trace: { file: "marley_trace.json", event_fraction: 0.01 },
+
+    // STARTUP PROFILE (optional)
+    //
+    // If present, the marley executable records the resources used by each
+    // phase of the job start-up: parsing the configuration file, loading
+    // the mass table, spin-parity table, structure data, and reaction data
+    // files, normalizing the neutrino source and energy PDF, and generating
+    // the first event (which includes the search for the maximum of the
+    // energy PDF). The wall-clock time, CPU time, number of memory
+    // allocations, and number of bytes read (on Linux) are recorded for each
+    // phase. Nested phases are included in the totals for the phases that
+    // contain them. After the first event, the profile is printed as a table
+    // in the log and written as a JSON array to the named file.
+    //
+    // startup_profile: "marley_startup.json",
+
+    // JOB QUEUE (optional)
+    //
+    // Lets any number of marley processes (e.g., batch jobs on different
+    // nodes) share the work of a single run. The events are divided into
+    // work units that are handed out through a directory on a shared file
+    // system. Each process claims units until none are left, so faster
+    // nodes simply generate more of them, and processes may join at any
+    // time. Unit i is generated using random number stream i, so the
+    // merged output does not depend on how many processes took part or
+    // which units each of them generated. It is identical to the output of a
+    // single process that also writes a virtual output file with
+    // "events_per_block" equal to "events_per_unit".
+    //
+    // Every process must use the same job configuration file. If it does
+    // not contain a seed, the process that creates the queue chooses one
+    // for all of them. The last process to finish concatenates the unit
+    // output files into the files listed under the "output" key. Only the
+    // "ascii" and "hepevt" formats are supported, without compression or
+    // sharding. The other formats, including "hepmc3", are not allowed
+    // because their files cannot be merged by concatenation. The "stopping",
+    // "trace", and "startup_profile" keys may not be used together with a
+    // job queue, and neither may the top-level "transmission_tables" key.
+    //
+    //   - directory: Shared directory that holds the queue (created if
+    //                needed). Use a new directory for each run.
+    //
+    //   - events_per_unit: Number of events in each work unit (default:
+    //                      1000)
+    //
+    //   - timeout: Time (s) after which a unit claimed by a process that
+    //              stopped sending heartbeats (e.g., because its node
+    //              crashed) is returned to the queue. This should be much
+    //              longer than any clock skew between the nodes.
+    //              (default: 600)
+    //
+    // job_queue: { directory: "/shared/marley_queue", events_per_unit: 1000,
+    //   timeout: 600 },
+
+    // PROJECTILE STREAM (optional)
+    //
+    // Creates one event for each projectile record supplied by another
+    // program (e.g., a supernova burst or background simulation) instead
+    // of sampling the projectiles from the neutrino source. Each record
+    // gives the projectile PDG code, its kinetic energy (MeV), the PDG code
+    // of the target atom, the projectile direction, and optionally a time.
+    // The time is accepted so that existing record lists may be used
+    // unchanged, but it is not stored since MARLEY events have no vertex
+    // time. The events are written in the same order as the records, so
+    // they may be matched up afterwards.
+    //
+    // In the text format, each line holds the whitespace-separated values
+    //
+    //   pdg_a KEa pdg_atom dir_x dir_y dir_z [time]
+    //
+    // Blank lines and lines that begin with '#' are skipped. In the binary
+    // format, each record is 48 bytes long (native byte order): two int32
+    // values (pdg_a, pdg_atom) followed by five float64 values (KEa, dir_x,
+    // dir_y, dir_z, time).
+    //
+    // A reader thread parses the input while several worker threads create
+    // the events. The records are divided into batches, each of which is
+    // handled by a single thread using its own random number stream. The
+    // events thus depend only on the configuration, the records, and the
+    // batch size. Records are passed along as soon as they arrive, so the
+    // input may be a pipe or FIFO that is still being written.
+    //
+    // The output files default to a single ascii-format stream written to
+    // the standard output. Use the file name "stdout" to select it
+    // explicitly. Log messages are then sent to the standard error. Existing
+    // output files are never replaced unless "force" is true since the
+    // standard input may hold the records. The "virtual" format, sharding,
+    // and the "append" and "resume" modes may not be used. The "events" and
+    // "direction" keys are ignored, and the "source" is used only for the
+    // flux-averaged cross section written to the output. The "stopping",
+    // "trace", and "startup_profile" keys may not be used.
+    //
+    //   - input: Name of the file (or FIFO) that holds the records. Use
+    //            "stdin" (the default) for the standard input.
+    //
+    //   - format: Either "text" (default) or "binary"
+    //
+    //   - threads: Number of worker threads (default: 0, which uses one
+    //              per hardware thread)
+    //
+    //   - batch_size: Number of records in each batch (default: 256)
+    //
+    // projectile_stream: { input: "stdin", format: "text", threads: 4 },
+
+    // PRECISION-TARGETED STOPPING (optional)
+    //
+    // Instead of always producing the number of events given by the
+    // "events" key, the marley executable may end the run as soon as the
+    // statistical uncertainties on a set of observables are small enough.
+    // The "events" value then acts as an upper limit. At the end of the run,
+    // the estimated value and achieved relative uncertainty for each target
+    // are written to the log.
+    //
+    //   - targets: Array of precision targets (at least one is required).
+    //              Each is a JSON object with the following keys:
+    //
+    //       - observable: Either "fraction" (fraction of events satisfying
+    //                     a condition) or "mean" (mean value of a quantity)
+    //
+    //       - particle: PDG code of a final-state particle. For fractions,
+    //                   the condition is that the event contains at least
+    //                   one such particle. For means, the quantity is the
+    //                   total kinetic energy (MeV) of these particles.
+    //
+    //       - variable: Instead of "particle", the name of a primary event
+    //                   variable. The choices are the same as for the
+    //                   "primary_cuts" key above.
+    //
+    //       - range: Required for fractions that use a variable. The
+    //                condition is that the variable lies in the closed
+    //                interval [ min, max ] (e.g., a histogram bin).
+    //
+    //       - precision: Desired relative statistical uncertainty
+    //
+    //       - name: Optional label for the target in log messages
+    //
+    //   - max_time: Optional limit (in seconds) on the time spent generating
+    //               events. Zero (the default) means no limit.
+    //
+    //   - check_interval: Number of events between checks of the targets
+    //                     and time limit (default 1000)
+    //
+    // The targets are never considered met before 100 events have been
+    // produced.
+    //
+    // stopping: {
+    //   targets: [
+    //     { name: "neutron emission", observable: "fraction",
+    //       particle: 2112, precision: 0.01 },
+    //     { observable: "mean", variable: "ejectile_KE", precision: 0.005 },
+    //     { observable: "fraction", variable: "Ex", range: [ 0, 5 ],
+    //       precision: 0.02 },
+    //   ],
+    //   max_time: 3600,
+    // },
+
     // EVENT OUTPUT (optional)
     //
     // The "output" JSON array contains a list of JSON objects representing
@@ -331,14 +828,16 @@
     //           supported.
     //
     //   - format: The format to use when storing the events in the file.
-    //             Valid values are "ascii", "hepevt", "json", and "root".
+    //             Valid values are "ascii", "hepevt", "hepmc3", "json", and
+    //             "root".
     //             Details about the format options are given below.
     //
     //   - mode: The file I/O mode to use when writing to this file. For
     //           the "ascii" and "hepevt" formats, valid values are
     //           "overwrite" (erase any previously existing file contents)
     //           and "append" (continue output immediately after any
-    //           existing file contents). For the "json" and "root" formats,
+    //           existing file contents). The "hepmc3" format supports only
+    //           "overwrite". For the "json" and "root" formats,
     //           valid values are "overwrite" and "resume". If the "resume"
     //           mode is chosen, the generator will restore its previous state
     //           from an incomplete run (e.g., a run that was interrupted
@@ -357,6 +856,90 @@
     //             behavior results in the most compact JSON-format output
     //             files.
     //
+    //   - event_fields: Array of event-level quantities to write. Valid
+    //                   entries are "Ex", "twoJ", and "parity". If this key
+    //                   is omitted, all of them will be written. Used only
+    //                   for the "ascii" and "json" formats.
+    //
+    //   - particle_fields: Array of particle quantities to write. Valid
+    //                      entries are "pdg", "E", "px", "py", "pz", "mass",
+    //                      and "charge". The PDG code is always written. If
+    //                      this key is omitted, all of them will be written.
+    //                      Used only for the "ascii" and "json" formats.
+    //
+    //   - initial_particles: Boolean value indicating whether the initial
+    //                        particles (projectile and target) should be
+    //                        written. Used only for the "ascii" and "json"
+    //                        formats. If this key is omitted, a value of
+    //                        true is assumed.
+    //
+    //   - precision: Floating-point precision to use for the event output.
+    //                Valid values are "double" (default) and "single". Used
+    //                only for the "ascii", "hepevt", and "hepmc3" formats.
+    //
+    //   When reading files written using the last four options, the
+    //   marley::EventFileReader class fills in default values for any
+    //   omitted quantities. Masses are taken from the mass table, total
+    //   energies are computed from the 3-momentum and mass, and everything
+    //   else is set to zero (or to a positive parity). Dummy particles are
+    //   used for the initial state when it is omitted.
+    //
+    //   - compression: Either "none" (default) or "gzip". Compressed files
+    //                  are written as a series of independent gzip blocks
+    //                  that are compressed in parallel. They may be read
+    //                  using standard tools like zcat, and the
+    //                  marley::EventFileReader class decompresses them
+    //                  transparently. Only available if MARLEY was built
+    //                  with zlib. May not be used with the "root" format.
+    //
+    //   - compression_level: zlib compression level (1-9). If this key is
+    //                        omitted, zlib's default level (6) is used.
+    //
+    //   - compression_threads: Maximum number of blocks to compress at
+    //                          once. Defaults to the number of available
+    //                          CPU cores.
+    //
+    //   - compression_block_size: Minimum size (in bytes) of the
+    //                             uncompressed data in each block. Blocks
+    //                             always end between events. Defaults to
+    //                             1048576 (1 MiB).
+    //
+    //   - shards: Number of shard files that will receive the events. The
+    //             events are distributed round-robin among the shards,
+    //             each of which is written by its own thread (except for
+    //             the "root" format). Shard files are named by inserting a
+    //             four-digit index before the extension (e.g.,
+    //             events_0000.ascii, events_0001.ascii, ...).
+    //
+    //   - max_events_per_shard: Start a new shard file once the current
+    //                           one contains this many events.
+    //
+    //   - max_bytes_per_shard: Start a new shard file once roughly this
+    //                          many bytes have been written to the current
+    //                          one.
+    //
+    //   If any of the last three keys is present, then each shard is a
+    //   complete output file in the requested format, and only the
+    //   "overwrite" mode may be used. When the run ends, a JSON manifest
+    //   (e.g., events.ascii.manifest) listing the shards, the flux-averaged
+    //   total cross section, and the final generator state is also written.
+    //   Events are distributed round-robin among the shards that are
+    //   written at the same time, so each shard entry gives the zero-based
+    //   index of its first event ("first_event") and the spacing between
+    //   the indices of its events ("stride"). Passing the manifest to
+    //   marley::EventFileReader will read the events from all of the shards
+    //   in their original order.
+    //
+    //   - events_per_block: Used only for the "virtual" format. Number of
+    //                       events generated using each random number
+    //                       stream (default 1000).
+    //
+    //   - summary: Used only for the "virtual" format. Array of variable
+    //              names ("projectile_KE", "ejectile_KE",
+    //              "ejectile_cos_theta", and/or "Ex", as for the primary
+    //              event cuts) whose values should be stored for every
+    //              event to allow for fast event selection.
+    //
     // The allowed output file formats are
     //
     //   - "ascii": The native format for MARLEY events. Files written in
@@ -368,6 +951,19 @@
     //               (http://tinyurl.com/StdHepManual) for a description
     //               of the HEPEVT format.
     //
+    //   - "hepmc3": Each event is described by a HepMC3 ASCII (Asciiv3)
+    //               GenEvent record, so the files can be read by the HepMC3
+    //               library (and tools built on it) without any conversion.
+    //               The HepMC3 library is not needed to write them. All
+    //               particles share a single vertex at the origin, and the
+    //               HEPEVT status codes are used (3 for the initial particles
+    //               and 1 for the final particles). Momenta and masses are
+    //               given in GeV. The flux-averaged total cross section is
+    //               stored in the GenCrossSection attribute of every event
+    //               (in pb) and in the "flux_avg_xsec" run attribute (in
+    //               MeV^(-2)). The residue properties are stored in the "Ex",
+    //               "twoJ", and "parity" event attributes.
+    //
     //   - "json": The events are stored as an array of JSON objects. The
     //             state of the generator is also written to the file when
     //             execution terminates (either because the desired number
@@ -379,6 +975,17 @@
     //             TTree. This format is only available if MARLEY has been
     //             built with ROOT support.
     //
+    //   - "virtual": Stores only the information needed to regenerate the
+    //                events: the MARLEY version, the job configuration
+    //                (including the seed that was used), checksums of the
+    //                data files, and the random number stream used for each
+    //                block of events. marley::EventFileReader regenerates the
+    //                events in parallel when the file is read, and it can
+    //                seek to any event. Only the "overwrite" mode may be
+    //                used, and the compression and sharding settings are not
+    //                allowed. Virtual output files may not be used in
+    //                decay-only mode.
+    //
     // If this key is omitted, then the following configuration
     // is assumed:
     //
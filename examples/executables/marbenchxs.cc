@@ -0,0 +1,283 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// MARLEY includes
+#include "marley/ChebyshevInterpolatingFunction.hh"
+#include "marley/Error.hh"
+#include "marley/Generator.hh"
+#include "marley/InterpolationGrid.hh"
+#include "marley/JSON.hh"
+#include "marley/marley_simd.hh"
+#include "marley/marley_utils.hh"
+
+#ifdef USE_ROOT
+  #include "marley/RootJSONConfig.hh"
+#else
+  #include "marley/JSONConfig.hh"
+#endif
+
+namespace {
+  // Default settings for the projectile kinetic energy grid. These match
+  // those used by mardumpxs.
+  constexpr double DEFAULT_KE_MIN = 0.;
+  constexpr double DEFAULT_KE_MAX = 100.;
+  constexpr int DEFAULT_NUM_STEPS = 10000;
+  constexpr int DEFAULT_PDG = marley_utils::ELECTRON_NEUTRINO;
+
+  // Minimum wall-clock time (s) to spend on each benchmark
+  constexpr double MIN_BENCH_TIME = 1.;
+
+  // Retrieves an optional numerical parameter from the job configuration
+  void get_bench_param( const marley::JSON& json,
+    const std::string& param_key, double& value )
+  {
+    if ( !json.has_key(param_key) ) return;
+
+    const auto& temp_js = json.at( param_key );
+    bool ok = false;
+    value = temp_js.to_double( ok );
+    if ( !ok ) throw marley::Error("Unrecognized " + param_key
+      + " value " + temp_js.to_string() + " encountered in the"
+      " job configuration file.");
+  }
+
+  // Repeatedly evaluates a full pass over the energy grid until at least
+  // MIN_BENCH_TIME has elapsed. Returns the number of cross section
+  // evaluations (one per energy) per second.
+  double run_benchmark( const std::function<void()>& pass, size_t num_energies )
+  {
+    using Clock = std::chrono::steady_clock;
+    long passes = 0;
+    double elapsed = 0.;
+    auto start = Clock::now();
+    while ( elapsed < MIN_BENCH_TIME ) {
+      pass();
+      ++passes;
+      elapsed = std::chrono::duration<double>( Clock::now() - start ).count();
+    }
+    return passes * num_energies / elapsed;
+  }
+
+  void print_result( const std::string& label, double rate,
+    double reference_rate )
+  {
+    std::cout << "  " << label << ": " << rate << " energies/s ("
+      << rate / reference_rate << "x)\n";
+  }
+}
+
+int main(int argc, char* argv[]) {
+
+  // If the user has not supplied enough command-line arguments, display the
+  // standard help message and exit
+  if ( argc <= 1 ) {
+    std::cout << "Usage: " << argv[0] << " CONFIG_FILE [NUM_THREADS]\n";
+    return 1;
+  }
+
+  std::string config_file_name( argv[1] );
+
+  int num_threads = std::thread::hardware_concurrency();
+  if ( argc > 2 ) num_threads = std::stoi( argv[2] );
+  if ( num_threads < 1 ) num_threads = 1;
+
+  // Configure a new Generator object
+  #ifdef USE_ROOT
+    marley::RootJSONConfig config( config_file_name );
+  #else
+    marley::JSONConfig config( config_file_name );
+  #endif
+  const marley::Generator gen = config.create_generator();
+
+  // The energy grid and projectile may be customized using the same
+  // configuration file keys as mardumpxs
+  const marley::JSON& json = config.get_json();
+  double KEmin = DEFAULT_KE_MIN;
+  double KEmax = DEFAULT_KE_MAX;
+  double num_steps = DEFAULT_NUM_STEPS;
+  double projectile_pdg = DEFAULT_PDG;
+
+  get_bench_param( json, "xsec_dump_KEmin", KEmin );
+  get_bench_param( json, "xsec_dump_KEmax", KEmax );
+  get_bench_param( json, "xsec_dump_steps", num_steps );
+  get_bench_param( json, "xsec_dump_pdg", projectile_pdg );
+
+  int pdg = static_cast<int>( projectile_pdg );
+  size_t num_energies = static_cast<size_t>( num_steps );
+  if ( num_energies == 0u ) throw marley::Error( "The energy grid used by"
+    " marbenchxs must contain at least one step." );
+
+  std::vector<double> energies( num_energies );
+  double delta_KE_step = ( KEmax - KEmin ) / num_steps;
+  for ( size_t s = 0u; s < num_energies; ++s ) {
+    energies.at( s ) = KEmin + ( s + 1 ) * delta_KE_step;
+  }
+
+  size_t num_reacts = gen.get_reactions().size();
+  size_t num_atoms = gen.get_target().atom_fraction_map().size();
+
+  std::vector<double> scalar_xs( num_energies );
+  std::vector<double> batch_xs( num_energies );
+  std::vector<double> reaction_xs( num_energies * num_reacts );
+  std::vector<double> target_xs( num_energies * num_atoms );
+
+  // Check that both interfaces agree before timing them
+  double max_rel_diff = 0.;
+  gen.total_xs( pdg, energies.data(), num_energies, batch_xs.data() );
+  for ( size_t s = 0u; s < num_energies; ++s ) {
+    scalar_xs.at( s ) = gen.total_xs( pdg, energies.at(s) );
+    double diff = std::abs( scalar_xs.at(s) - batch_xs.at(s) );
+    if ( diff > 0. ) max_rel_diff = std::max( max_rel_diff,
+      diff / std::abs(scalar_xs.at(s)) );
+  }
+
+  std::cout << "Benchmarking total cross sections for projectile " << pdg
+    << " at " << num_energies << " energies between " << KEmin << " and "
+    << KEmax << " MeV\n";
+  std::cout << "  " << num_reacts << " reaction(s), " << num_atoms
+    << " target nuclide(s), maximum relative difference between scalar and"
+    " batch results = " << max_rel_diff << '\n';
+
+  double scalar_rate = run_benchmark( [&]() {
+    for ( size_t s = 0u; s < num_energies; ++s ) {
+      scalar_xs[ s ] = gen.total_xs( pdg, energies[s] );
+    }
+  }, num_energies );
+  print_result( "scalar total_xs()", scalar_rate, scalar_rate );
+
+  double batch_rate = run_benchmark( [&]() {
+    gen.total_xs( pdg, energies.data(), num_energies, batch_xs.data() );
+  }, num_energies );
+  print_result( "batch total", batch_rate, scalar_rate );
+
+  double full_rate = run_benchmark( [&]() {
+    gen.total_xs( pdg, energies.data(), num_energies, batch_xs.data(),
+      reaction_xs.data(), target_xs.data() );
+  }, num_energies );
+  print_result( "batch total + per-reaction + per-target", full_rate,
+    scalar_rate );
+
+  // Each thread evaluates the full grid using its own output buffer. The
+  // Generator is shared between all of them.
+  std::vector<double> rates( num_threads );
+  std::vector<std::thread> threads;
+  for ( int t = 0; t < num_threads; ++t ) {
+    threads.emplace_back( [&, t]() {
+      std::vector<double> out( num_energies );
+      rates.at( t ) = run_benchmark( [&]() {
+        gen.total_xs( pdg, energies.data(), num_energies, out.data() );
+      }, num_energies );
+    } );
+  }
+  for ( auto& th : threads ) th.join();
+
+  double threaded_rate = 0.;
+  for ( double r : rates ) threaded_rate += r;
+  print_result( "batch total using " + std::to_string(num_threads)
+    + " thread(s)", threaded_rate, scalar_rate );
+
+  // Compare the scalar and batch versions of InterpolationGrid::interpolate()
+  // for tables of the total cross section. The second table uses quadratic
+  // spacing in kinetic energy, so its bins are found by binary searches.
+  // The lookups are made in a random order, as they are when sampling.
+  std::vector<double> lookup_energies( energies );
+  std::shuffle( lookup_energies.begin(), lookup_energies.end(),
+    std::mt19937_64(12345) );
+  std::vector<double> lookup_xs( num_energies );
+  std::vector<double> batch_lookup_xs( num_energies );
+
+  for ( bool uniform : { true, false } ) {
+    std::vector<double> table_KEs( num_energies );
+    std::vector<double> table_xs( num_energies );
+    for ( size_t s = 0u; s < num_energies; ++s ) {
+      double frac = ( s + 1. ) / num_energies;
+      if ( !uniform ) frac *= frac;
+      table_KEs.at( s ) = KEmin + ( KEmax - KEmin ) * frac;
+      table_xs.at( s ) = gen.total_xs( pdg, table_KEs.at(s) );
+    }
+    marley::InterpolationGrid<double> table( table_KEs, table_xs );
+
+    std::cout << "Benchmarking lookups in a table of the total cross section"
+      " with " << ( uniform ? "uniform" : "quadratic" ) << " spacing\n";
+
+    double scalar_lookup_rate = run_benchmark( [&]() {
+      for ( size_t s = 0u; s < num_energies; ++s ) {
+        lookup_xs[ s ] = table.interpolate( lookup_energies[s] );
+      }
+    }, num_energies );
+    print_result( "scalar interpolate()", scalar_lookup_rate,
+      scalar_lookup_rate );
+
+    double batch_lookup_rate = run_benchmark( [&]() {
+      table.interpolate( lookup_energies.data(), batch_lookup_xs.data(),
+        num_energies );
+    }, num_energies );
+    std::string label = "batch interpolate()";
+    if ( batch_lookup_xs != lookup_xs ) label += " (differs from scalar)";
+    print_result( label, batch_lookup_rate, scalar_lookup_rate );
+  }
+
+  // Compare the variants of the vectorized interpolation kernel that are
+  // supported on this machine
+  marley_simd::Level selected = marley_simd::active_level();
+  std::cout << "Benchmarking Chebyshev interpolation of the total cross"
+    " section (selected SIMD level: " << marley_simd::level_name( selected )
+    << ")\n";
+
+  marley::ChebyshevInterpolatingFunction cheb( [&]( double KE ) -> double
+    { return gen.total_xs( pdg, KE ); }, KEmin, KEmax,
+    marley::DEFAULT_N_CHEBYSHEV );
+
+  std::vector<double> generic_values( num_energies );
+  std::vector<double> values( num_energies );
+  double generic_rate = 0.;
+  for ( auto level : { marley_simd::Level::GENERIC,
+    marley_simd::Level::SSE4_2, marley_simd::Level::AVX2,
+    marley_simd::Level::AVX512 } )
+  {
+    if ( level > marley_simd::detected_level() ) break;
+    marley_simd::set_level( level );
+
+    double rate = run_benchmark( [&]() {
+      for ( size_t s = 0u; s < num_energies; ++s ) {
+        values[ s ] = cheb.evaluate( energies[s] );
+      }
+    }, num_energies );
+
+    if ( level == marley_simd::Level::GENERIC ) {
+      generic_rate = rate;
+      generic_values = values;
+    }
+
+    std::string label = marley_simd::level_name( level );
+    if ( values != generic_values ) label += " (differs from generic)";
+    print_result( label, rate, generic_rate );
+  }
+  marley_simd::set_level( selected );
+
+  return 0;
+}
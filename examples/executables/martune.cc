@@ -0,0 +1,443 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+// MARLEY includes
+#include "marley/ChebyshevInterpolatingFunction.hh"
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/ExitChannel.hh"
+#include "marley/Generator.hh"
+#include "marley/HauserFeshbachDecay.hh"
+#include "marley/JSON.hh"
+#include "marley/Logger.hh"
+#include "marley/MassTable.hh"
+#include "marley/StructureDatabase.hh"
+
+#ifdef USE_ROOT
+  #include "marley/RootJSONConfig.hh"
+  using Config = marley::RootJSONConfig;
+#else
+  #include "marley/JSONConfig.hh"
+  using Config = marley::JSONConfig;
+#endif
+
+namespace {
+
+  constexpr double DEFAULT_TOLERANCE = 1e-3;
+  constexpr int DEFAULT_NUM_STATES = 8;
+  const std::string DEFAULT_OUTPUT_FILE = "tuned_config.js";
+
+  // Maximum number of primary events to generate while looking for
+  // compound nuclear states in the unbound continuum
+  constexpr int MAX_PILOT_EVENTS_PER_STATE = 1000;
+
+  // Number of energies at which the cumulative distributions of final
+  // excitation energies are compared
+  constexpr int NUM_CDF_POINTS = 33;
+
+  // Number of final excitation energies sampled for each continuum channel.
+  // The same random numbers are used for every candidate setting.
+  constexpr int NUM_EXF_SAMPLES = 64;
+  constexpr uint_fast64_t EXF_SAMPLING_SEED = 123456789u;
+
+  // Number of times each candidate is timed. The shortest time is used.
+  constexpr int NUM_TIMING_REPEATS = 3;
+
+  // Numerical resolution settings for the continuum decay calculations
+  struct Settings {
+    int fragment_l_max;
+    int gamma_l_max;
+    double numerov_step_size;
+    int quadrature_order;
+    int chebyshev_points;
+    double sampling_tolerance;
+  };
+
+  // Settings used to compute the reference values of the observables
+  constexpr Settings REFERENCE_SETTINGS = { 7, 5, 0.025, 100, 128, 1e-12 };
+
+  // A compound nuclear state sampled during the pilot run
+  struct PilotState {
+    marley::Particle nucleus;
+    double Ex;
+    int twoJ;
+    marley::Parity Pi;
+  };
+
+  // Observables computed for a single pilot state
+  struct Observables {
+    double total_width;
+    std::vector<double> branching_fractions;
+    // CDFs for the final excitation energy (NUM_CDF_POINTS - 1 values
+    // per continuum channel, empty for the others). Each one is normalized
+    // to the branching fraction for its channel.
+    std::vector< std::vector<double> > Exf_cdfs;
+    // Final excitation energies sampled for each continuum channel (empty
+    // for the others), expressed as fractions of the allowed range
+    std::vector< std::vector<double> > Exf_samples;
+  };
+
+  // Largest discrepancies between a set of observables and the reference
+  struct Discrepancy {
+    double width = 0.;
+    double branching = 0.;
+    double cdf = 0.;
+    double sampling = 0.;
+    inline double max() const
+      { return std::max({ width, branching, cdf, sampling }); }
+  };
+
+  // Builds a StructureDatabase that uses the given settings. The remaining
+  // nuclear structure options (e.g., tabulated level densities) are taken
+  // from the job configuration.
+  std::unique_ptr<marley::Generator> make_generator( const Config& config,
+    const Settings& s )
+  {
+    auto gen = std::make_unique<marley::Generator>();
+    config.prepare_structure( *gen );
+    auto& sdb = gen->get_structure_db();
+    sdb.set_fragment_l_max( s.fragment_l_max );
+    sdb.set_gamma_l_max( s.gamma_l_max );
+    sdb.set_numerov_step_size( s.numerov_step_size );
+    sdb.set_continuum_quadrature_order( s.quadrature_order );
+    sdb.set_continuum_chebyshev_points( s.chebyshev_points );
+    sdb.set_continuum_sampling_tolerance( s.sampling_tolerance );
+    return gen;
+  }
+
+  // Performs the calculations needed for a Hauser-Feshbach decay step of
+  // each pilot state using the given settings, including the sampling of
+  // final excitation energies. Returns the shortest elapsed time (s) from
+  // NUM_TIMING_REPEATS repetitions and loads the observables.
+  double evaluate( const Config& config, const Settings& s,
+    const std::vector<PilotState>& states, std::vector<Observables>& obs )
+  {
+    using Clock = std::chrono::steady_clock;
+
+    auto gen = make_generator( config, s );
+    auto& sdb = gen->get_structure_db();
+
+    double best_time = std::numeric_limits<double>::infinity();
+    for ( int rep = 0; rep < NUM_TIMING_REPEATS; ++rep ) {
+      obs.clear();
+      auto start = Clock::now();
+      for ( const auto& state : states ) {
+
+        marley::HauserFeshbachDecay hfd( state.nucleus, state.Ex, state.twoJ,
+          state.Pi, sdb );
+
+        Observables o;
+        o.total_width = 0.;
+        for ( const auto& ec : hfd.exit_channels() ) {
+          o.total_width += ec->width();
+        }
+
+        for ( const auto& ec : hfd.exit_channels() ) {
+          double bf = 0.;
+          if ( o.total_width > 0. ) bf = ec->width() / o.total_width;
+          o.branching_fractions.push_back( bf );
+
+          std::vector<double> cdf_values;
+          std::vector<double> samples;
+          const auto* cec = dynamic_cast<const marley::ContinuumExitChannel*>(
+            ec.get() );
+          if ( cec && bf > 0. ) {
+            // Build the same approximation to the excitation energy CDF
+            // that is used by ContinuumExitChannel::sample_Exf()
+            double Emin = cec->E_c_min();
+            double Emax = cec->E_c_max();
+            marley::ChebyshevInterpolatingFunction pdf( [cec](double Exf)
+              -> double { return cec->differential_width(Exf); }, Emin, Emax,
+              sdb.get_continuum_chebyshev_points() );
+            auto cdf = pdf.cdf();
+            double norm = cdf.evaluate( Emax ) / bf;
+            for ( int p = 1; p < NUM_CDF_POINTS; ++p ) {
+              double Exf = Emin + p * ( Emax - Emin ) / NUM_CDF_POINTS;
+              cdf_values.push_back( cdf.evaluate(Exf) / norm );
+            }
+
+            // Sample final excitation energies in the same way
+            gen->reseed( EXF_SAMPLING_SEED );
+            for ( int k = 0; k < NUM_EXF_SAMPLES; ++k ) {
+              double Exf = gen->inverse_transform_sample( cdf, Emin, Emax,
+                sdb.get_continuum_sampling_tolerance() );
+              samples.push_back( (Exf - Emin) / (Emax - Emin) );
+            }
+          }
+          o.Exf_cdfs.push_back( std::move(cdf_values) );
+          o.Exf_samples.push_back( std::move(samples) );
+        }
+
+        obs.push_back( std::move(o) );
+      }
+
+      best_time = std::min( best_time, std::chrono::duration<double>(
+        Clock::now() - start ).count() );
+    }
+
+    return best_time;
+  }
+
+  Discrepancy compare( const std::vector<Observables>& obs,
+    const std::vector<Observables>& ref )
+  {
+    Discrepancy d;
+    for ( size_t s = 0u; s < obs.size(); ++s ) {
+      const auto& o = obs.at( s );
+      const auto& r = ref.at( s );
+      if ( r.total_width > 0. ) d.width = std::max( d.width,
+        std::abs(o.total_width - r.total_width) / r.total_width );
+
+      size_t num_channels = std::min( o.branching_fractions.size(),
+        r.branching_fractions.size() );
+      for ( size_t c = 0u; c < num_channels; ++c ) {
+        d.branching = std::max( d.branching,
+          std::abs(o.branching_fractions.at(c) - r.branching_fractions.at(c)) );
+
+        // A channel that is closed in one calculation but not in the other
+        // already shows up as a difference in the branching fractions
+        const auto& ocdf = o.Exf_cdfs.at( c );
+        const auto& rcdf = r.Exf_cdfs.at( c );
+        if ( ocdf.size() != rcdf.size() ) continue;
+        for ( size_t p = 0u; p < ocdf.size(); ++p ) {
+          d.cdf = std::max( d.cdf, std::abs(ocdf.at(p) - rcdf.at(p)) );
+        }
+
+        // Differences between the sampled energies are weighted by the
+        // branching fraction, like the CDFs
+        const auto& osamp = o.Exf_samples.at( c );
+        const auto& rsamp = r.Exf_samples.at( c );
+        if ( osamp.size() != rsamp.size() ) continue;
+        for ( size_t k = 0u; k < osamp.size(); ++k ) {
+          d.sampling = std::max( d.sampling, r.branching_fractions.at(c)
+            * std::abs(osamp.at(k) - rsamp.at(k)) );
+        }
+      }
+    }
+    return d;
+  }
+
+  // Describes one of the settings adjusted by the tuner. Candidate values
+  // are listed from the cheapest to the most expensive.
+  struct Knob {
+    std::string key;
+    bool is_integer;
+    std::vector<double> candidates;
+    void (*apply)( Settings&, double );
+    double (*get)( const Settings& );
+  };
+
+  void print_usage( const char* name ) {
+    std::cout << "Usage: " << name << " CONFIG_FILE [-t TOLERANCE]"
+      " [-n NUM_STATES] [-o OUTPUT_FILE]\n";
+  }
+}
+
+int main( int argc, char* argv[] ) {
+
+  if ( argc <= 1 ) {
+    print_usage( argv[0] );
+    return 1;
+  }
+
+  std::string config_file_name( argv[1] );
+  double tolerance = DEFAULT_TOLERANCE;
+  int num_states = DEFAULT_NUM_STATES;
+  std::string output_file_name = DEFAULT_OUTPUT_FILE;
+
+  for ( int a = 2; a < argc; ++a ) {
+    std::string arg( argv[a] );
+    if ( a + 1 >= argc ) {
+      print_usage( argv[0] );
+      return 1;
+    }
+    std::string value( argv[++a] );
+    if ( arg == "-t" ) tolerance = std::stod( value );
+    else if ( arg == "-n" ) num_states = std::stoi( value );
+    else if ( arg == "-o" ) output_file_name = value;
+    else {
+      print_usage( argv[0] );
+      return 1;
+    }
+  }
+
+  if ( !(tolerance > 0.) ) throw marley::Error( "The tolerance passed to"
+    " martune must be positive" );
+  if ( num_states < 1 ) throw marley::Error( "At least one pilot state is"
+    " needed by martune" );
+
+  // Background table construction would distort the timing measurements,
+  // so the tuner always uses the direct calculations
+  Config full_config( config_file_name );
+  marley::JSON tune_json = marley::JSON::make( marley::JSON::DataType::Object );
+  for ( const auto& pair : full_config.get_json().object_range() ) {
+    if ( pair.first == "transmission_tables" ) continue;
+    tune_json[ pair.first ] = pair.second;
+  }
+  Config config( tune_json, false );
+
+  // Sample compound nuclear states in the unbound continuum using the
+  // neutrino reactions from the job configuration. The Hauser-Feshbach
+  // cascade is followed so that states reached after the first decay step
+  // are also included.
+  marley::Generator gen = config.create_generator();
+  const auto& mt = marley::MassTable::Instance();
+
+  std::vector<PilotState> states;
+  int max_events = MAX_PILOT_EVENTS_PER_STATE * num_states;
+  for ( int e = 0; e < max_events
+    && states.size() < static_cast<size_t>(num_states); ++e )
+  {
+    marley::Event ev = gen.create_primary_event();
+    PilotState state = { ev.residue(), ev.Ex(), ev.twoJ(), ev.parity() };
+
+    bool continuum = state.Ex > mt.unbound_threshold(
+      state.nucleus.pdg_code() );
+    while ( continuum && states.size() < static_cast<size_t>(num_states) ) {
+
+      // Primary events often populate the same discrete levels, so skip
+      // states that are already being used
+      bool duplicate = std::any_of( states.cbegin(), states.cend(),
+        [&state](const PilotState& other) -> bool {
+          return other.nucleus.pdg_code() == state.nucleus.pdg_code()
+            && other.Ex == state.Ex && other.twoJ == state.twoJ
+            && other.Pi == state.Pi; } );
+      if ( !duplicate ) states.push_back( state );
+
+      marley::HauserFeshbachDecay hfd( state.nucleus, state.Ex, state.twoJ,
+        state.Pi, gen.get_structure_db() );
+      marley::Particle emitted, residual;
+      continuum = hfd.do_decay( state.Ex, state.twoJ, state.Pi, emitted,
+        residual, gen );
+      state.nucleus = residual;
+    }
+  }
+
+  if ( states.empty() ) throw marley::Error( "No unbound compound nuclear"
+    " states were produced during the pilot run. There is nothing to tune"
+    " for this configuration." );
+
+  std::cout << "Tuning numerical settings using " << states.size()
+    << " unbound compound nuclear state(s) and a tolerance of " << tolerance
+    << '\n';
+
+  // The tuner evaluates the same calculations many times. Silence the
+  // logging that would otherwise be repeated for each of them.
+  bool log_enabled = marley::Logger::Instance().is_enabled();
+  marley::Logger::Instance().disable();
+
+  std::vector<Observables> ref_obs, obs;
+  double ref_time = evaluate( config, REFERENCE_SETTINGS, states, ref_obs );
+
+  const marley::StructureDatabase default_sdb;
+  Settings defaults = { default_sdb.get_fragment_l_max(),
+    default_sdb.get_gamma_l_max(), default_sdb.get_numerov_step_size(),
+    default_sdb.get_continuum_quadrature_order(),
+    default_sdb.get_continuum_chebyshev_points(),
+    default_sdb.get_continuum_sampling_tolerance() };
+  double default_time = evaluate( config, defaults, states, obs );
+  Discrepancy default_diff = compare( obs, ref_obs );
+
+  std::cout << "  reference settings: " << ref_time << " s\n";
+  std::cout << "  default settings: " << default_time << " s, largest"
+    " discrepancy " << default_diff.max() << '\n';
+
+  const std::vector<Knob> knobs = {
+    { "fragment_lmax", true, { 1, 2, 3, 4, 5, 6, 7 },
+      [](Settings& s, double v) { s.fragment_l_max = static_cast<int>(v); },
+      [](const Settings& s) -> double { return s.fragment_l_max; } },
+    { "gamma_lmax", true, { 1, 2, 3, 4, 5 },
+      [](Settings& s, double v) { s.gamma_l_max = static_cast<int>(v); },
+      [](const Settings& s) -> double { return s.gamma_l_max; } },
+    { "numerov_step_size", false, { 0.2, 0.15, 0.1, 0.075, 0.05, 0.025 },
+      [](Settings& s, double v) { s.numerov_step_size = v; },
+      [](const Settings& s) -> double { return s.numerov_step_size; } },
+    { "continuum_quadrature_order", true, { 8, 12, 16, 24, 32, 50, 75, 100 },
+      [](Settings& s, double v) { s.quadrature_order = static_cast<int>(v); },
+      [](const Settings& s) -> double { return s.quadrature_order; } },
+    { "continuum_chebyshev_points", true,
+      { 8, 12, 16, 24, 32, 48, 64, 96, 128 },
+      [](Settings& s, double v) { s.chebyshev_points = static_cast<int>(v); },
+      [](const Settings& s) -> double { return s.chebyshev_points; } },
+    { "continuum_sampling_tolerance", false,
+      { 1e-3, 1e-4, 1e-5, 1e-6, 1e-8, 1e-10, 1e-12 },
+      [](Settings& s, double v) { s.sampling_tolerance = v; },
+      [](const Settings& s) -> double { return s.sampling_tolerance; } },
+  };
+
+  // Tune one setting at a time, keeping the values already chosen for the
+  // others. Every candidate is timed, and the fastest one that meets the
+  // tolerance is kept. Since every comparison is made against the
+  // reference, the final profile meets the tolerance as a whole.
+  Settings tuned = REFERENCE_SETTINGS;
+  double tuned_time = ref_time;
+  for ( const auto& knob : knobs ) {
+    std::cout << "  " << knob.key << ":";
+    Settings best = tuned;
+    double best_time = std::numeric_limits<double>::infinity();
+    for ( double value : knob.candidates ) {
+      Settings trial = tuned;
+      knob.apply( trial, value );
+      double time = evaluate( config, trial, states, obs );
+      Discrepancy diff = compare( obs, ref_obs );
+      std::cout << ' ' << value << " (" << time << " s, " << diff.max()
+        << ')';
+      if ( diff.max() <= tolerance && time < best_time ) {
+        best = trial;
+        best_time = time;
+      }
+    }
+    if ( best_time < std::numeric_limits<double>::infinity() ) {
+      tuned = best;
+      tuned_time = best_time;
+    }
+    std::cout << " -> " << knob.get( tuned ) << '\n';
+  }
+
+  marley::Logger::Instance().enable( log_enabled );
+
+  std::cout << "Tuned settings: " << tuned_time << " s (" << default_time
+    / tuned_time << "x faster than the defaults)\n";
+
+  // Write a copy of the original job configuration that includes the tuned
+  // settings
+  marley::JSON out_json = full_config.get_json();
+  for ( const auto& knob : knobs ) {
+    double value = knob.get( tuned );
+    if ( knob.is_integer ) out_json[ knob.key ] = static_cast<long>( value );
+    else out_json[ knob.key ] = value;
+  }
+
+  std::ofstream out_file( output_file_name );
+  out_file << out_json.dump_string( 2 ) << '\n';
+  std::cout << "Wrote the tuned configuration to " << output_file_name
+    << '\n';
+
+  return 0;
+}
@@ -0,0 +1,196 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace marley {
+
+  /// @brief Resettable monotonic memory pool for short-lived objects
+  /// @details Memory is carved sequentially from a list of chunks.
+  /// Individual deallocations only update the count of live allocations.
+  /// The space is reclaimed all at once by reset(), which keeps the chunks
+  /// for reuse. Each thread owns its own Arena (see thread_arena()). The
+  /// thread Arenas are registered so that their usage can be summarized
+  /// across threads (see combined_statistics()).
+  /// Classes opt into using it by forwarding their allocations to
+  /// scoped_allocate() and scoped_deallocate(). These draw from the
+  /// thread's Arena only while an Arena::Scope is active, so persistent
+  /// objects of the same types still live on the global heap.
+  class Arena {
+
+    public:
+
+      /// @brief Usage statistics for an Arena
+      struct Statistics {
+        /// @brief Bytes allocated since the last call to reset()
+        size_t bytes_in_use = 0u;
+        /// @brief Largest value of bytes_in_use seen so far
+        size_t peak_bytes = 0u;
+        /// @brief Total size (bytes) of the chunks owned by the Arena
+        size_t capacity = 0u;
+        /// @brief Total bytes allocated over the lifetime of the Arena
+        double total_bytes = 0.;
+        /// @brief Number of calls to reset()
+        long resets = 0;
+
+        /// @brief Average number of bytes allocated between resets
+        inline double bytes_per_reset() const
+          { return resets > 0 ? total_bytes / resets : 0.; }
+      };
+
+      /// @brief Activates the Arena owned by the current thread for the
+      /// lifetime of this object
+      /// @details Scopes may be nested
+      class Scope {
+        public:
+          /// @param activate If false, this Scope has no effect
+          explicit Scope( bool activate = true );
+          ~Scope();
+
+          Scope( const Scope& ) = delete;
+          Scope& operator=( const Scope& ) = delete;
+
+        private:
+          bool active_;
+      };
+
+      /// @param chunk_size Size (bytes) of the first chunk to allocate
+      explicit Arena( size_t chunk_size = DEFAULT_CHUNK_SIZE );
+
+      ~Arena();
+
+      Arena( const Arena& ) = delete;
+      Arena& operator=( const Arena& ) = delete;
+
+      /// @brief Allocates memory from the Arena
+      /// @param bytes Number of bytes to allocate
+      /// @param alignment Required alignment (must be a power of two no
+      /// larger than that of std::max_align_t)
+      void* allocate( size_t bytes,
+        size_t alignment = alignof(std::max_align_t) );
+
+      /// @brief Releases memory obtained from allocate()
+      /// @details The memory itself is not reused until reset() is called
+      void deallocate( const void* ptr );
+
+      /// @brief Checks whether a pointer refers to memory in this Arena
+      bool owns( const void* ptr ) const;
+
+      /// @brief Makes all memory in the Arena available again
+      /// @details If the Arena holds more than one chunk, they are replaced by
+      /// a single chunk large enough for all of them, so that later cycles
+      /// do not need to allocate chunks. Nothing is done if any allocations
+      /// have not been released yet.
+      /// @return Whether the Arena was reset
+      bool reset();
+
+      /// @brief Get the usage statistics for this Arena
+      inline const Statistics& statistics() const { return stats_; }
+
+      /// @brief Get the Arena owned by the current thread
+      static Arena& thread_arena();
+
+      /// @brief Get the usage statistics of all thread Arenas, including
+      /// those of threads that have already exited
+      /// @details Each thread Arena reports its statistics whenever it is
+      /// reset, so the result does not include allocations made since the
+      /// last reset on each thread. The peak_bytes value is the sum of the
+      /// peaks for the individual threads.
+      /// @param[out] num_threads If not nullptr, this is loaded with the
+      /// number of threads whose Arena has been used
+      static Statistics combined_statistics( size_t* num_threads = nullptr );
+
+      /// @brief Returns true if an Arena::Scope is active on the current
+      /// thread
+      static bool scope_active();
+
+      /// @brief Allocates memory from the thread's Arena if an Arena::Scope
+      /// is active, or from the global heap otherwise
+      static void* scoped_allocate( size_t bytes,
+        size_t alignment = alignof(std::max_align_t) );
+
+      /// @brief Releases memory obtained from scoped_allocate()
+      static void scoped_deallocate( void* ptr );
+
+      /// @brief Default size (bytes) of the first chunk
+      static constexpr size_t DEFAULT_CHUNK_SIZE = 65536u;
+
+    private:
+
+      /// @brief Adds a new chunk that can hold at least min_bytes
+      void add_chunk( size_t min_bytes );
+
+      /// @brief Copies the statistics of a registered Arena to the list
+      /// used by combined_statistics()
+      void publish_statistics() const;
+
+      struct Chunk {
+        std::unique_ptr<char[]> data;
+        size_t size;
+      };
+
+      /// @brief Memory owned by the Arena. Allocations are made from the
+      /// last chunk.
+      std::vector<Chunk> chunks_;
+
+      /// @brief Offset (bytes) of the first unused byte in the last chunk
+      size_t offset_ = 0u;
+
+      /// @brief Size of the next chunk to create
+      size_t next_chunk_size_;
+
+      /// @brief Number of allocations that have not yet been released
+      long live_allocations_ = 0;
+
+      /// @brief Whether this Arena belongs to a thread and is included in
+      /// combined_statistics()
+      bool registered_ = false;
+
+      Statistics stats_;
+  };
+
+  /// @brief Standard library allocator that uses
+  /// Arena::scoped_allocate() and Arena::scoped_deallocate()
+  template <typename T> class ArenaAllocator {
+    public:
+
+      using value_type = T;
+
+      ArenaAllocator() = default;
+
+      template <typename U> ArenaAllocator( const ArenaAllocator<U>& ) {}
+
+      inline T* allocate( size_t n ) {
+        return static_cast<T*>( Arena::scoped_allocate(n * sizeof(T),
+          alignof(T)) );
+      }
+
+      inline void deallocate( T* ptr, size_t ) {
+        Arena::scoped_deallocate( ptr );
+      }
+  };
+
+  template <typename T, typename U> inline bool operator==(
+    const ArenaAllocator<T>&, const ArenaAllocator<U>& ) { return true; }
+
+  template <typename T, typename U> inline bool operator!=(
+    const ArenaAllocator<T>&, const ArenaAllocator<U>& ) { return false; }
+
+}
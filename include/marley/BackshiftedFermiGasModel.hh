@@ -43,20 +43,26 @@ namespace marley {
       BackshiftedFermiGasModel(int Z, int A);
 
       /// @copydoc marley::LevelDensityModel::level_density(double)
-      virtual double level_density(double Ex) override;
+      virtual double level_density(double Ex) const override;
 
       /// @copydoc marley::LevelDensityModel::level_density(double, int)
-      virtual double level_density(double Ex, int two_J) override;
+      virtual double level_density(double Ex, int two_J) const override;
 
       /// @copydoc LevelDensityModel::level_density(double, int, marley::Parity)
       /// @details The current implementation assumes parity equipartition.
       virtual double level_density(double Ex, int two_J, marley::Parity Pi)
-        override;
+        const override;
+
+      /// @copydoc LevelDensityModel::level_densities()
+      /// @details The total level density and the spin cut-off parameter are
+      /// computed only once for all of the spins
+      virtual void level_densities(double Ex, int two_J_min, size_t num_spins,
+        marley::Parity Pi, double* rhos) const override;
 
     protected:
 
       /// Helper function used when evaluating the spin cutoff parameter
-      inline double compute_sigma_F2(double Ex, double a) {
+      inline double compute_sigma_F2(double Ex, double a) const {
         double U = Ex - Delta_BFM_;
 
         double sigma_F2 = 0.01389 * std::pow(A_, 5.0/3.0)
@@ -65,11 +71,19 @@ namespace marley {
         return sigma_F2;
       }
 
+      /// @brief Computes the total level density
+      /// @param Ex Excitation energy in MeV
+      /// @param[out] sigma Spin cut-off parameter at Ex
+      /// @return %Level density in MeV<sup> -1</sup>
+      double total_level_density(double Ex, double& sigma) const;
+
+      /// @brief Spin-dependent factor that converts the total level density
+      /// into the density for a single spin
+      double spin_factor(int two_J, double sigma) const;
+
       int Z_; ///< atomic number for this nuclide
       int A_; ///< mass number for this nuclide
 
-      double sigma_; ///< spin cut-off parameter
-
       double a_tilde_; ///< asymptotic level density parameter (MeV<sup> -1</sup>)
       double gamma_; ///< damping parameter (MeV<sup> -1</sup>)
       double delta_W_; ///< shell correction energy (MeV)
@@ -18,6 +18,8 @@
 #include <functional>
 #include <vector>
 
+#include "marley/Arena.hh"
+#include "marley/marley_simd.hh"
 #include "marley/marley_utils.hh"
 
 namespace marley {
@@ -30,30 +32,37 @@ namespace marley {
 
     public:
 
+      /// @brief Container type used for the grid and the work arrays
+      /// @details Objects that are created while an Arena::Scope is active
+      /// store these in the current thread's marley::Arena
+      template <typename T> using Vector = std::vector<T,
+        marley::ArenaAllocator<T> >;
+
+      /// @brief ChebyshevInterpolatingFunction objects are placed in the
+      /// current thread's marley::Arena while an Arena::Scope is active
+      inline static void* operator new( size_t bytes )
+        { return marley::Arena::scoped_allocate( bytes ); }
+
+      inline static void operator delete( void* ptr )
+        { marley::Arena::scoped_deallocate( ptr ); }
+
       // N = 0 triggers adaptive grid sizing
       ChebyshevInterpolatingFunction(const std::function<double(double)>& func,
         double x_min, double x_max, size_t N = 0);
 
       /// @brief Approximates the represented function using the barycentric
       /// formula
+      /// @details The sums are computed by a kernel chosen at run time (see
+      /// marley_simd::barycentric_sums())
       inline double evaluate(double x) const {
-        double numer = 0.;
-        double denom = 0.;
-        double w_j = -1.;
-        for ( size_t j = 0; j <= N_; ++j ) {
-          w_j = -w_j; // w_j = (-1)^(j)
-          double x_j = Xs_.at( j );
-          double f_j = Fs_.at( j );
-          // If the requested x value is exactly equal to one
-          // of the grid points where we previously evaluated the
-          // function, then just return that
-          if ( x_j == x ) return f_j;
-
-          double temp = w_j / ( x - x_j );
-          if ( j == 0 || j == N_ ) temp /= 2.;
-          denom += temp;
-          numer += temp * f_j;
-        }
+        double numer, denom;
+        size_t j = marley_simd::barycentric_sums( Xs_.data(), Ws_.data(),
+          Fs_.data(), N_ + 1, x, numer, denom );
+
+        // If the requested x value is exactly equal to one
+        // of the grid points where we previously evaluated the
+        // function, then just return that
+        if ( j <= N_ ) return Fs_[ j ];
 
         double px = numer / denom;
         return px;
@@ -63,13 +72,13 @@ namespace marley {
       // x_max_]
       inline double integral() const { return integral_; };
 
-      inline const std::vector<double>& chebyshev_coeffs() const
+      inline const Vector<double>& chebyshev_coeffs() const
         { return chebyshev_coeffs_; }
 
-      inline const std::vector<double>& Fs() const
+      inline const Vector<double>& Fs() const
         { return Fs_; }
 
-      inline const std::vector<double>& Xs() const
+      inline const Vector<double>& Xs() const
         { return Xs_; }
 
       inline int N() const { return N_; }
@@ -97,17 +106,20 @@ namespace marley {
       double integral_;
 
       /// @brief Chebyshev points at which the function was evaluated
-      std::vector<double> Xs_;
+      Vector<double> Xs_;
 
       /// @brief Function values at the grid points
-      std::vector<double> Fs_;
+      Vector<double> Fs_;
+
+      /// @brief Barycentric interpolation weights for the grid points
+      Vector<double> Ws_;
 
       /// @brief Coefficients of the Chebyshev expansion of this function
-      std::vector<double> chebyshev_coeffs_;
+      Vector<double> chebyshev_coeffs_;
 
       // Helper arrays for discrete cosine transforms calculated using FFTPACK4
-      std::vector<double> wsave_;
-      std::vector<int> ifac_;
+      Vector<double> wsave_;
+      Vector<int> ifac_;
 
       /// @brief For a given N, returns the x position of the
       /// jth Chebyshev point (of the second kind)
@@ -122,6 +134,9 @@ namespace marley {
       }
 
       void compute_integral();
+
+      /// @brief Fills the Ws_ vector
+      void compute_weights();
   };
 
 }
@@ -0,0 +1,277 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+
+// standard library includes
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace marley {
+
+  class JSON;
+
+  /// @brief Settings used to compress the contents of an output file
+  /// @details Compressed files are written as a sequence of independent
+  /// gzip members ("blocks"), so they may be decompressed by standard tools
+  /// such as gunzip. Each block header stores the compressed size of the
+  /// block in an extra field, which allows marley::GzipInputBuffer to
+  /// locate and decompress the blocks in parallel and to seek between them.
+  class CompressionSettings {
+
+    public:
+
+      /// @brief Create settings that disable compression
+      CompressionSettings();
+
+      /// @brief Create settings using the values given in a JSON object
+      /// @details The keys "compression" ("none" or "gzip"),
+      /// "compression_level", "compression_threads", and
+      /// "compression_block_size" are used if present. All other keys are
+      /// ignored, which allows an output file specification from the job
+      /// configuration file to be passed directly to this constructor.
+      explicit CompressionSettings(const marley::JSON& json);
+
+      /// @brief Returns true if output should be compressed
+      inline bool enabled() const { return enabled_; }
+
+      /// @brief zlib compression level (1-9, or -1 for the default)
+      inline int level() const { return level_; }
+
+      /// @brief Maximum number of blocks that may be compressed concurrently
+      inline unsigned threads() const { return threads_; }
+
+      /// @brief Minimum size of an uncompressed block (bytes)
+      inline size_t block_size() const { return block_size_; }
+
+      /// @brief Returns true if MARLEY was built with zlib support
+      static bool available();
+
+      /// @brief Default minimum size of an uncompressed block (bytes)
+      static constexpr size_t DEFAULT_BLOCK_SIZE = 1u << 20;
+
+    protected:
+
+      bool enabled_ = false;
+      int level_ = -1;
+      unsigned threads_;
+      size_t block_size_ = DEFAULT_BLOCK_SIZE;
+  };
+
+  /// @brief Fixed set of worker threads that compress or decompress blocks
+  /// @details Tasks are queued in the order that they are submitted. If the
+  /// queue is full, submit() blocks until a worker takes the next task.
+  class BlockWorkerPool {
+
+    public:
+
+      /// @param num_threads Number of worker threads to start
+      /// @param max_queued Maximum number of tasks that may wait for a
+      /// worker
+      BlockWorkerPool(unsigned num_threads, size_t max_queued);
+
+      /// @brief Discards any tasks that have not been started, then waits
+      /// for the workers to finish their current tasks
+      ~BlockWorkerPool();
+
+      /// @brief Queues a task and returns a future that will hold its
+      /// result
+      std::future<std::string> submit(std::function<std::string()> task);
+
+    protected:
+
+      /// @brief Body of each worker thread
+      void run();
+
+      std::vector<std::thread> threads_;
+      std::deque< std::packaged_task<std::string()> > queue_;
+      size_t max_queued_;
+      bool stop_ = false;
+      std::mutex mutex_;
+      std::condition_variable cv_;
+  };
+
+  /// @brief std::streambuf that compresses everything written to it
+  /// in independent gzip blocks
+  /// @details Data are accumulated in memory until end_record() is called
+  /// with at least CompressionSettings::block_size() bytes pending. The
+  /// block is then compressed by a marley::BlockWorkerPool with
+  /// CompressionSettings::threads() workers while new data are accepted.
+  /// Compressed blocks are written to the destination stream in order by
+  /// the thread that uses this buffer. Blocks therefore always end at
+  /// record (e.g., event) boundaries.
+  class GzipOutputBuffer : public std::streambuf {
+
+    public:
+
+      /// @param out Stream that will receive the compressed blocks
+      /// @param settings Compression settings to use
+      GzipOutputBuffer(std::ostream& out,
+        const marley::CompressionSettings& settings);
+
+      virtual ~GzipOutputBuffer();
+
+      /// @brief Marks the end of a record. If enough data are pending,
+      /// a new block will be started.
+      void end_record();
+
+      /// @brief Compresses any pending data and waits until every block has
+      /// been written to the destination stream
+      void finish();
+
+      /// @brief Number of uncompressed bytes not yet written as a block
+      inline size_t pending_bytes() const { return block_.size(); }
+
+    protected:
+
+      virtual int_type overflow(int_type ch) override;
+      virtual std::streamsize xsputn(const char* s,
+        std::streamsize count) override;
+
+      /// @brief Starts compressing the pending data as a new block
+      void submit_block();
+
+      /// @brief Writes completed blocks to the destination stream
+      /// @param wait If true, wait for every block to be completed
+      void write_blocks(bool wait);
+
+      std::ostream& out_;
+      marley::CompressionSettings settings_;
+
+      /// @brief Uncompressed data for the next block
+      std::string block_;
+
+      /// @brief Blocks being compressed (in the order that they should be
+      /// written)
+      std::deque< std::future<std::string> > pending_;
+
+      /// @brief Threads that compress the blocks (created when the first
+      /// block is submitted)
+      std::unique_ptr<marley::BlockWorkerPool> workers_;
+  };
+
+  /// @brief std::streambuf that reads a gzip-compressed file
+  /// @details Files written by marley::GzipOutputBuffer are indexed when
+  /// they are opened, and upcoming blocks are decompressed in parallel.
+  /// Seeking to any position in the uncompressed data is supported for
+  /// these files. Other gzip files (including those with several members)
+  /// are decompressed sequentially, and seeking is limited to the start of
+  /// the file and to positions within the most recently decompressed chunk.
+  class GzipInputBuffer : public std::streambuf {
+
+    public:
+
+      /// @param file_name Name of the file to read
+      /// @param threads Maximum number of blocks to decompress concurrently
+      GzipInputBuffer(const std::string& file_name, unsigned threads = 0);
+
+      virtual ~GzipInputBuffer();
+
+      /// @brief Returns true if the given file begins with the gzip
+      /// magic bytes
+      static bool is_gzip_file(const std::string& file_name);
+
+    protected:
+
+      virtual int_type underflow() override;
+
+      virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+        std::ios_base::openmode which = std::ios_base::in) override;
+
+      virtual pos_type seekpos(pos_type pos,
+        std::ios_base::openmode which = std::ios_base::in) override;
+
+      /// @brief Location of a block in the file
+      struct BlockInfo {
+        /// @brief Offset of the block in the compressed file (bytes)
+        int_fast64_t offset_;
+        /// @brief Size of the compressed block (bytes)
+        int_fast64_t size_;
+        /// @brief Offset of the block in the uncompressed data (bytes)
+        int_fast64_t data_offset_;
+      };
+
+      /// @brief Builds the block index if the file was written by
+      /// marley::GzipOutputBuffer
+      /// @return True if the index was built, or false otherwise
+      bool build_index();
+
+      /// @brief Moves to the block with the given index and starts
+      /// decompressing the blocks after it
+      void start_at_block(size_t index);
+
+      /// @brief Reads the next block that has not yet been submitted and
+      /// queues it for decompression
+      void submit_next_block();
+
+      /// @brief Decompresses the next chunk of a file that could not be
+      /// indexed
+      bool read_next_chunk();
+
+      /// @brief Resets decompression to the start of a file that could not
+      /// be indexed
+      void restart();
+
+      std::string file_name_;
+      std::ifstream in_;
+      unsigned threads_;
+
+      /// @brief Uncompressed data currently exposed by the get area
+      std::string data_;
+
+      /// @brief Offset of data_ in the uncompressed data (bytes)
+      int_fast64_t data_offset_ = 0;
+
+      /// @brief Index of the blocks in the file (empty if the file could not
+      /// be indexed)
+      std::vector<BlockInfo> blocks_;
+
+      /// @brief Index of the block that will be moved to data_ next
+      size_t next_block_ = 0;
+
+      /// @brief Index of the next block to start decompressing
+      size_t next_submitted_block_ = 0;
+
+      /// @brief Blocks being decompressed
+      std::deque< std::future<std::string> > pending_;
+
+      /// @brief Threads that decompress the blocks (null for files that
+      /// could not be indexed)
+      std::unique_ptr<marley::BlockWorkerPool> workers_;
+
+      /// @brief Compressed input for files that could not be indexed
+      std::string compressed_;
+
+      /// @brief zlib stream used to read files that could not be indexed
+      /// (stored as an opaque pointer to avoid including zlib.h here)
+      void* zstream_ = nullptr;
+
+      /// @brief Whether the end of a file that could not be indexed
+      /// has been reached
+      bool at_eof_ = false;
+  };
+
+}
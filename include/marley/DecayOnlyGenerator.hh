@@ -0,0 +1,165 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+
+// standard library includes
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// MARLEY includes
+#include "marley/Event.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/NucleusDecayer.hh"
+#include "marley/Parity.hh"
+
+namespace marley {
+
+  class JSONConfig;
+
+  /// @brief Simulates de-excitations of nuclei prepared in user-specified
+  /// initial states without simulating any neutrino reactions
+  /// @details The initial states are read from the "initial_states" array
+  /// in the job configuration. Each element gives a nuclide (as a PDG code),
+  /// an excitation energy (or a uniform range of them), a spin, a parity,
+  /// and an optional relative weight. Initial states that lie below the
+  /// unbound threshold are snapped to the closest discrete level, whose
+  /// spin-parity is then used. Above the threshold, the cascade begins with
+  /// a Hauser-Feshbach decay from the continuum.
+  ///
+  /// Events are produced by a pool of worker threads. Each worker owns a
+  /// separate Generator (seeded with the configured seed plus the worker
+  /// index) and a NucleusDecayer that caches the first Hauser-Feshbach step
+  /// for each distinct initial state. Events are handed out round-robin
+  /// from the workers, so the sequence of events is reproducible for a
+  /// given seed and number of threads.
+  ///
+  /// In each Event, the excited nucleus appears as both the target and the
+  /// residue (before the de-excitation cascade is applied). The projectile
+  /// and ejectile are dummy particles with PDG code zero.
+  class DecayOnlyGenerator {
+
+    public:
+
+      /// @brief Description of a distribution of initial nuclear states
+      struct InitialState {
+        int pdg; ///< PDG code of the nucleus
+        double Ex_min; ///< Minimum excitation energy (MeV)
+        double Ex_max; ///< Maximum excitation energy (MeV)
+        int twoJ; ///< Two times the nuclear spin
+        marley::Parity parity; ///< Nuclear parity
+        double weight; ///< Relative probability of choosing this state
+      };
+
+      /// @param config Job configuration that contains the "initial_states"
+      /// array. It is used to create a Generator for each worker thread.
+      /// @param num_threads Number of worker threads to use. A value of
+      /// zero selects the number of hardware threads. With a single thread,
+      /// events are produced by the calling thread.
+      DecayOnlyGenerator( const marley::JSONConfig& config,
+        int num_threads = 0 );
+
+      ~DecayOnlyGenerator();
+
+      DecayOnlyGenerator( const DecayOnlyGenerator& ) = delete;
+      DecayOnlyGenerator& operator=( const DecayOnlyGenerator& ) = delete;
+
+      /// @brief Returns true if the job configuration requests a decay-only
+      /// run, or false otherwise
+      static bool is_requested( const marley::JSON& config );
+
+      /// @brief Parse the "initial_states" array from a job configuration
+      static std::vector<InitialState> parse_initial_states(
+        const marley::JSON& config );
+
+      /// @brief Get the next de-excitation event
+      marley::Event create_event();
+
+      /// @brief Get the number of worker threads
+      inline int num_threads() const;
+
+      /// @brief Get the number of events returned so far by create_event()
+      /// for each decay channel
+      /// @details Channels are labeled by the emitted nuclear fragments
+      /// (&gamma;-rays are ignored) and the final nucleus, e.g.,
+      /// "n + 39K". Events in which only &gamma;-rays were emitted are
+      /// labeled like "&gamma; + 40K".
+      inline const std::map<std::string, long>& channel_counts() const;
+
+      /// @brief Print a table of branching ratios for each decay channel
+      /// seen so far
+      void print_branching_ratios( std::ostream& out ) const;
+
+    private:
+
+      /// @brief Per-thread state used to produce events
+      struct Worker {
+        std::unique_ptr<marley::Generator> gen;
+        marley::NucleusDecayer decayer{ true };
+        std::discrete_distribution<size_t> state_dist;
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<marley::Event> queue;
+        std::exception_ptr error;
+      };
+
+      /// @brief Prepares an initial state, then applies the de-excitation
+      /// cascade to it using the resources owned by a worker
+      marley::Event decay_initial_state( Worker& worker );
+
+      /// @brief Loop executed by each worker thread
+      void run_worker( Worker& worker );
+
+      /// @brief Updates channel_counts_ using a newly-created event
+      void tally( const marley::Event& ev );
+
+      /// @brief Maximum number of finished events waiting in each worker's
+      /// queue
+      static constexpr size_t MAX_QUEUED_EVENTS_ = 256;
+
+      std::vector<InitialState> initial_states_;
+      std::vector< std::unique_ptr<Worker> > workers_;
+
+      /// @brief Index of the worker that will supply the next event
+      size_t next_worker_ = 0;
+
+      /// @brief Tells the worker threads to stop
+      std::atomic<bool> stop_;
+
+      std::map<std::string, long> channel_counts_;
+      long event_count_ = 0;
+  };
+
+  // Inline function definitions
+  inline int DecayOnlyGenerator::num_threads() const
+    { return static_cast<int>( workers_.size() ); }
+
+  inline const std::map<std::string, long>&
+    DecayOnlyGenerator::channel_counts() const { return channel_counts_; }
+}
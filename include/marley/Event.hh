@@ -35,12 +35,21 @@ namespace marley {
   /// @brief HEPEVT status code for a dummy particle that
   /// encodes MARLEY-specific information in a HEPEVT record
   constexpr int HEPEVT_MARLEY_INFO_STATUS_CODE = 11;
+  /// @brief HEPEVT status code for dummy particles that store the
+  /// systematic weights of an event in a HEPEVT record
+  /// @details These are not written by marley::Event::write_hepevt(), but
+  /// marley::Event::read_hepevt() still accepts them. Each one holds up to
+  /// five weights in its four-momentum and mass slots. The JMOHEP1 and
+  /// JMOHEP2 fields give the index of the first weight and the number of
+  /// weights.
+  constexpr int HEPEVT_MARLEY_WEIGHTS_STATUS_CODE = 12;
 
   // Forward declare the JSON class so that we can define a function that
   // creates a JSON representation of a Event. Hide the JSON class from
   // rootcint so that we won't have issues using marley::Event objects with
   // ROOT 5.
   class JSON;
+  class EventProjection;
   #endif
 
   /// @brief Container for ingoing and outgoing momentum 4-vectors from a
@@ -160,6 +169,35 @@ namespace marley {
       /// initial two-body reaction
       inline marley::Parity parity() const;
 
+      /// @brief Returns true if the de-excitation of the residue has been
+      /// deferred and not yet applied
+      /// @details See marley::Generator::create_primary_event() and
+      /// marley::Generator::resolve_deexcitation()
+      inline bool deexcitation_pending() const;
+
+      /// @brief Get the seed of the random number sub-stream that will be
+      /// used to de-excite the residue
+      inline unsigned long long deexcitation_seed() const;
+
+      /// @brief Marks the de-excitation of the residue as pending
+      /// @param seed Seed of the random number sub-stream to use when the
+      /// residue is de-excited
+      inline void defer_deexcitation( unsigned long long seed );
+
+      /// @brief Marks the de-excitation of the residue as no longer pending
+      inline void clear_pending_deexcitation();
+
+      /// @brief Get a const reference to the systematic weights of the
+      /// event
+      /// @details This vector holds one weight per systematic universe (see
+      /// marley::SystematicUniverses). It is empty if no universes were
+      /// configured when the event was created.
+      inline const std::vector<double>& weights() const;
+
+      /// @brief Get a non-const reference to the systematic weights of the
+      /// event
+      inline std::vector<double>& weights();
+
       /// @brief Add a Particle to the vector of initial particles
       void add_initial_particle(const marley::Particle& p);
 
@@ -184,6 +222,8 @@ namespace marley {
         std::ostream& out) const;
 
       /// @brief Print this event to a std::ostream
+      /// @details The systematic weights are not written. Use an
+      /// EventProjection with weight names to include them.
       /// @param out The std::ostream to which this event will be written
       void print(std::ostream& out) const;
 
@@ -213,6 +253,9 @@ namespace marley {
       ///     with status code HEPEVT_FINAL_STATE_STATUS_CODE
       ///   - Zero of the particles with status code
       ///     HEPEVT_FINAL_STATE_STATUS_CODE are ions
+      ///   - A particle with status code HEPEVT_MARLEY_WEIGHTS_STATUS_CODE
+      ///     refers to a weight index beyond five times the number of
+      ///     particles in the record
       /// @return True if the input stream was in a good state after attempting
       /// to read in the full HEPEVT record, or false otherwise. This
       /// behavior is designed to enable the return value of this function to
@@ -221,17 +264,89 @@ namespace marley {
       /// object contents will have been cleared by this function.
       bool read_hepevt(std::istream& in, double* flux_avg_tot_xsec = nullptr);
 
-      /// @brief Deletes all particles from the event and resets
-      /// the nuclear excitation energy to zero
+      /// @brief Read in this event from a std::istream, assuming that it
+      /// will appear there as a HepMC3 ASCII (Asciiv3) record like those
+      /// written by write_hepmc3(). Any previous contents of this event will
+      /// be deleted.
+      /// @details Header lines and anything else before the next "E" line are
+      /// skipped. The particles are identified using the HEPEVT status codes,
+      /// and the same checks are made as in read_hepevt().
+      /// @param in The std::istream from which the event will be read
+      /// @param flux_avg_tot_xsec If not null, loaded with the flux-averaged
+      /// total cross section (MeV<sup> -2</sup>) from the GenCrossSection
+      /// attribute (if there is one)
+      /// @return False if no further event records were found, or true
+      /// otherwise
+      bool read_hepmc3(std::istream& in, double* flux_avg_tot_xsec = nullptr);
+
+      /// @brief Deletes all particles and systematic weights from the
+      /// event and resets the nuclear excitation energy to zero
       void clear();
 
       #ifndef __MAKECINT__
       /// @brief Create a JSON representation of this event
       marley::JSON to_json() const;
 
+      /// @brief Create a JSON representation of this event that includes
+      /// only the fields selected by an EventProjection
+      marley::JSON to_json(const marley::EventProjection& proj) const;
+
       /// @brief Replace the existing event contents with those read
       /// from a JSON representation
+      /// @details All keys written by to_json() const (except for the
+      /// optional systematic weights) are required
       void from_json(const marley::JSON& json);
+
+      /// @brief Replace the existing event contents with those read from a
+      /// JSON representation created using
+      /// to_json(const marley::EventProjection&) const
+      /// @details Only the keys omitted by the projection may be missing.
+      /// They are given default values as described in the documentation
+      /// for marley::EventProjection.
+      void from_json(const marley::JSON& json,
+        const marley::EventProjection& proj);
+
+      /// @brief Print the fields of this event selected by an
+      /// EventProjection to a std::ostream
+      /// @details If the projection keeps all fields at full precision, then
+      /// the output is identical to that of print(std::ostream&) const
+      void print(std::ostream& out, const marley::EventProjection& proj)
+        const;
+
+      /// @brief Read in an event that was written using
+      /// print(std::ostream&, const marley::EventProjection&) const
+      /// @details Fields omitted by the projection are given default values
+      /// as described in the documentation for marley::EventProjection
+      void read(std::istream& in, const marley::EventProjection& proj);
+
+      /// @brief Version of write_hepevt() that uses the precision setting
+      /// from an EventProjection
+      /// @details The HEPEVT format has a fixed layout, so the field
+      /// selections stored in the projection are ignored. The systematic
+      /// weights are not written, since HEPEVT readers such as Geant4's
+      /// G4HEPEvtInterface would treat any extra dummy entries as particles.
+      void write_hepevt(size_t event_num, double flux_avg_tot_xsec,
+        std::ostream& out, const marley::EventProjection& proj) const;
+
+      /// @brief Write a
+      /// <a href="https://arxiv.org/abs/1912.08005">HepMC3</a> ASCII
+      /// (Asciiv3) GenEvent record for this event to a std::ostream
+      /// @details All particles are attached to a single vertex at the
+      /// spacetime origin. The initial particles are incoming and the final
+      /// particles are outgoing. They are labeled using the HEPEVT status
+      /// codes defined above. The flux-averaged total cross section is
+      /// stored (in pb) in the GenCrossSection attribute, and the residue
+      /// properties Ex (MeV), twoJ, and parity are stored as event
+      /// attributes. Any systematic weights follow a nominal weight of one
+      /// on the W line. Momenta and masses are written in GeV. Only the
+      /// precision setting of the projection is used.
+      /// @param[in] event_num The event number to use in the record
+      /// @param[in] flux_avg_tot_xsec The flux-averaged total reaction
+      /// cross section (MeV<sup> -2</sup>)
+      /// @param[out] out The std::ostream to which the record will be written
+      /// @param[in] proj Projection whose precision setting will be used
+      void write_hepmc3(size_t event_num, double flux_avg_tot_xsec,
+        std::ostream& out, const marley::EventProjection& proj) const;
       #endif
 
     protected:
@@ -256,6 +371,18 @@ namespace marley {
       /// scattering reaction
       Parity parity_;
 
+      /// @brief Systematic weights for each configured universe
+      std::vector<double> weights_;
+
+      /// @brief Whether the de-excitation of the residue has been deferred
+      /// @note This member is not saved in output files
+      bool deexcitation_pending_ = false; //!
+
+      /// @brief Seed of the random number sub-stream used to de-excite the
+      /// residue
+      /// @note This member is not saved in output files
+      unsigned long long deexcitation_seed_ = 0; //!
+
       /// @brief Helper function for write_hepevt()
       /// @param p Particle to write to the HEPEVT record
       /// @param os std::ostream being written to
@@ -268,6 +395,13 @@ namespace marley {
       void dump_hepevt_particle(const marley::Particle& p, std::ostream& os,
         int status, int jmohep1 = 0, int jmohep2 = 0) const;
 
+      /// @brief Helper function for read_hepevt() and read_hepmc3() that
+      /// checks the particles read from a record, puts the projectile,
+      /// target, ejectile, and residue in their expected places, and sets
+      /// the ion charges
+      /// @param format Name of the input format (used in error messages)
+      void finish_reading_record(const std::string& format);
+
       /// @brief Deletes all owned Particle objects and clears the
       /// vectors of initial and final particles
       void delete_particles();
@@ -278,6 +412,25 @@ namespace marley {
   inline int Event::twoJ() const { return twoJ_; }
   inline marley::Parity Event::parity() const { return parity_; }
 
+  inline bool Event::deexcitation_pending() const
+    { return deexcitation_pending_; }
+
+  inline unsigned long long Event::deexcitation_seed() const
+    { return deexcitation_seed_; }
+
+  inline void Event::defer_deexcitation( unsigned long long seed ) {
+    deexcitation_pending_ = true;
+    deexcitation_seed_ = seed;
+  }
+
+  inline void Event::clear_pending_deexcitation()
+    { deexcitation_pending_ = false; }
+
+  inline const std::vector<double>& Event::weights() const
+    { return weights_; }
+
+  inline std::vector<double>& Event::weights() { return weights_; }
+
   inline const std::vector<marley::Particle*>& Event::get_initial_particles()
     const { return initial_particles_; }
 
@@ -17,20 +17,35 @@
 #pragma once
 #include <deque>
 #include <fstream>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "marley/Compression.hh"
+#include "marley/EventProjection.hh"
+#include "marley/EventRegenerator.hh"
 #include "marley/JSON.hh"
 #include "marley/OutputFile.hh"
 
 namespace marley {
 
-  // Forward-declare the Event class
+  // Forward-declare the Event and Generator classes
   class Event;
+  class Generator;
 
   /// @brief Object that parses MARLEY output files written in any of the
   /// available formats, except for ROOT format
-  /// @details For a version of this class that can also handle ROOT-format
-  /// output files, see the RootEventFileReader class
+  /// @details Files compressed using gzip (see marley::CompressionSettings)
+  /// are decompressed transparently. The manifest written for a sharded
+  /// output file (see marley::ShardedOutputFile) may also be opened. In
+  /// that case, the events from all of the listed shards are read in the
+  /// order in which they were generated.
+  /// Events described by a virtual output file (see
+  /// marley::VirtualOutputFile) are regenerated on demand using several
+  /// threads. The MARLEY version and the data files are checked against
+  /// those used to write the file before any events are regenerated.
+  /// For a version of this class that can also handle ROOT-format output
+  /// files, see the RootEventFileReader class
   class EventFileReader {
 
     public:
@@ -63,6 +78,31 @@ namespace marley {
         return *this;
       }
 
+      /// @brief Returns the projection that was used to write the file
+      /// @details Fields omitted from the file by the projection will be
+      /// given default values in the events returned by next_event()
+      const marley::EventProjection& projection();
+
+      /// @brief Moves to the event with the given (zero-based) index
+      /// @details The next call to next_event() will load that event.
+      /// Seeking is currently supported only for virtual event files. A
+      /// marley::Error will be thrown for other formats.
+      /// @return False if the index is out of range, or true otherwise
+      bool seek_event( long event_index );
+
+      /// @brief Returns the per-event values of the summary fields stored
+      /// in a virtual event file
+      /// @details The result is a JSON object whose keys are the field
+      /// names. Each value is an array containing one entry per event. The
+      /// object is empty if no summary fields are available.
+      const marley::JSON& summary();
+
+      /// @brief Set the maximum number of threads used to regenerate the
+      /// events in a virtual event file
+      /// @details This function must be called before any events are read.
+      /// A value of zero (the default) uses all available hardware threads.
+      void set_num_threads( int num_threads );
+
       /// @brief Implicit boolean conversion allows the state of the
       /// input stream (or ROOT file) to be tested for readiness to
       /// read in another event
@@ -79,8 +119,25 @@ namespace marley {
       /// deduce_file_format() and does not need to be specified by the user
       OutputFile::Format format_;
 
+      /// @brief Buffer used to read uncompressed files
+      std::filebuf file_buf_;
+
+      /// @brief Buffer used to read gzip-compressed files
+      std::unique_ptr<marley::GzipInputBuffer> gzip_buf_;
+
       /// @brief Input stream used to read from textual output formats
-      std::ifstream in_;
+      /// @details This stream reads from either file_buf_ or gzip_buf_
+      std::istream in_;
+
+      /// @brief Selection of the event fields present in the file
+      /// @details For ASCII-format files, this is read from an optional
+      /// header line. For JSON-format files, missing fields are detected
+      /// automatically.
+      marley::EventProjection projection_;
+
+      /// @brief Position of the first event record (or of the flux-averaged
+      /// total cross section preceding it) in ASCII-format files
+      std::streampos ascii_start_ = 0;
 
       /// @brief Used to parse events from JSON-format files
       marley::JSON json_event_array_;
@@ -96,6 +153,44 @@ namespace marley {
       /// format
       double flux_avg_tot_xs_ = 0.;
 
+      /// @brief Whether the header of a HepMC3-format file supplied the
+      /// flux-averaged total cross section
+      bool hepmc3_run_xsec_ = false;
+
+      /// @brief A shard file listed in a manifest
+      struct Shard {
+        std::string file_name_;
+        /// @brief Index of the first event stored in the shard
+        long first_event_ = 0;
+        /// @brief Spacing between the indices of consecutive events
+        long stride_ = 1;
+        long num_events_ = 0;
+        /// @brief Number of events read from the shard so far
+        long num_read_ = 0;
+        /// @brief Reader for the shard (null unless it is being read)
+        std::unique_ptr<EventFileReader> reader_;
+      };
+
+      /// @brief Shard files listed in a manifest (empty if the file being
+      /// read is not a manifest)
+      std::vector<Shard> shards_;
+
+      /// @brief Index of the next event to read from the shards
+      long next_shard_event_ = 0;
+
+      /// @brief Whether every event listed in the manifest has been read
+      bool shards_done_ = false;
+
+      /// @brief Regenerates the events described by a virtual event file
+      /// (null for other formats)
+      std::unique_ptr<marley::EventRegenerator> regenerator_;
+
+      /// @brief Per-event summary fields stored in a virtual event file
+      marley::JSON summary_ = marley::JSON::object();
+
+      /// @brief Maximum number of threads used to regenerate events
+      int num_threads_ = 0;
+
       /// @brief Flag that indicates whether initialize() has been called or not
       /// @details To avoid problems with using virtual functions in the constructor,
       /// we defer nearly all of the initialization to the first call to
@@ -109,6 +204,30 @@ namespace marley {
       /// @brief Prepares the file for reading the events
       virtual void initialize();
 
+      /// @brief Opens the file for reading via in_
+      void open_input();
+
+      /// @brief Loads the list of shard files from a manifest
+      void load_manifest(const marley::JSON& manifest);
+
+      /// @brief Reads the next event (in the original order) from the shard
+      /// files listed in a manifest
+      /// @return False if all of the events have been read
+      bool next_shard_event(marley::Event& ev);
+
+      /// @brief Creates a reader for one of the shards listed in a manifest
+      /// @details Derived classes should override this function so that
+      /// shards written in the formats that they support may be read
+      virtual std::unique_ptr<EventFileReader> open_shard(
+        const std::string& file_name) const;
+
+      /// @brief Creates a Generator using the job configuration stored in a
+      /// virtual event file
+      /// @details Derived classes may override this function to support
+      /// configurations that require extra features (e.g., ROOT)
+      virtual std::unique_ptr<marley::Generator> create_generator(
+        const marley::JSON& config) const;
+
       /// @brief This function should be called at the beginning of all public
       /// member functions of EventFileReader that interact with data in
       /// the file
@@ -0,0 +1,133 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace marley {
+
+  class JSON;
+
+  /// @brief Selection of the marley::Event and marley::Particle fields that
+  /// should be written to an output file
+  /// @details By default, every field is written using full double
+  /// precision. When an output file is configured to omit some fields,
+  /// the EventFileReader class will fill in default values for them when
+  /// reading the file:
+  ///   - Ex, twoJ, and parity: zero, zero, and positive, respectively
+  ///   - Initial particles: two dummy particles (see marley::Event::Event())
+  ///   - Momentum components: zero
+  ///   - Mass: looked up in the marley::MassTable based on the PDG code
+  ///     (and charge) of the particle, or zero if it cannot be found
+  ///   - Charge: the value returned by marley_utils::get_particle_charge()
+  ///   - Total energy: computed using the 3-momentum and mass
+  ///
+  /// The PDG code of each particle is always written. If the projection
+  /// has weight names, then the systematic weights of each event (see
+  /// marley::SystematicUniverses) are also written.
+  class EventProjection {
+
+    public:
+
+      /// @brief Fields of a marley::Event (or of each marley::Particle that
+      /// it owns) that may be omitted from the output
+      enum class Field : unsigned int {
+        Ex = 1u << 0, twoJ = 1u << 1, parity = 1u << 2,
+        E = 1u << 3, px = 1u << 4, py = 1u << 5, pz = 1u << 6,
+        mass = 1u << 7, charge = 1u << 8
+      };
+
+      /// @brief Create a projection that keeps every field at full precision
+      EventProjection();
+
+      /// @brief Create a projection using the settings given in a JSON object
+      /// @details The keys "event_fields", "particle_fields",
+      /// "initial_particles", "precision", and "weight_names" are used if
+      /// present. All other
+      /// keys are ignored, which allows an output file specification from
+      /// the job configuration file to be passed directly to this
+      /// constructor.
+      explicit EventProjection(const marley::JSON& json);
+
+      /// @brief Returns true if the field should be written
+      inline bool has(Field f) const
+        { return (field_mask_ & static_cast<unsigned int>(f)) != 0u; }
+
+      /// @brief Returns true if initial particles should be written
+      inline bool initial_particles() const { return initial_particles_; }
+
+      /// @brief Returns true if floating-point values should be stored
+      /// using single precision
+      inline bool single_precision() const { return single_precision_; }
+
+      /// @brief Write a floating-point value to a text stream, preceded by
+      /// a space
+      /// @details The value is rounded to single precision first if
+      /// requested. The Event and Particle classes both use this function
+      /// so that their values are always formatted in the same way.
+      inline void print_value(std::ostream& out, double value) const {
+        out << ' ';
+        if (single_precision_) out << static_cast<float>(value);
+        else out << value;
+      }
+
+      /// @brief Get the names of the systematic weights to write for each
+      /// event
+      inline const std::vector<std::string>& weight_names() const
+        { return weight_names_; }
+
+      /// @brief Set the names of the systematic weights to write for each
+      /// event
+      /// @details Every event written using this projection must have the
+      /// same number of weights as there are names
+      inline void set_weight_names(const std::vector<std::string>& names)
+        { weight_names_ = names; }
+
+      /// @brief Returns true if this projection keeps every field at full
+      /// precision and adds no weights (i.e., if it has no effect)
+      bool is_complete() const;
+
+      /// @brief Returns true if this projection drops any fields (ignoring
+      /// the precision setting)
+      bool drops_fields() const;
+
+      /// @brief Number of significant digits needed to write floating-point
+      /// values to text without losing information at the selected precision
+      int digits() const;
+
+      /// @brief Create a JSON representation of this projection that can
+      /// be passed back to EventProjection(const marley::JSON&)
+      marley::JSON to_json() const;
+
+    protected:
+
+      /// @brief Bitwise OR of the Field values that should be written
+      unsigned int field_mask_;
+
+      /// @brief Whether initial particles should be written
+      bool initial_particles_ = true;
+
+      /// @brief Whether floating-point values should be stored using
+      /// single precision
+      bool single_precision_ = false;
+
+      /// @brief Names of the systematic weights to write for each event
+      std::vector<std::string> weight_names_;
+  };
+
+}
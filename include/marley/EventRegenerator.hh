@@ -0,0 +1,144 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+
+// standard library includes
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+// MARLEY includes
+#include "marley/Event.hh"
+#include "marley/JSON.hh"
+
+namespace marley {
+
+  class Generator;
+
+  /// @brief Regenerates the events described by a file written using
+  /// marley::VirtualOutputFile
+  /// @details Each block of events is regenerated by restarting the random
+  /// number stream that was used to create it. Several blocks are
+  /// regenerated in parallel (each using its own marley::Generator) ahead
+  /// of the block that is currently being read.
+  class EventRegenerator {
+
+    public:
+
+      /// @brief Function used to create a Generator from the job
+      /// configuration stored in the file
+      using GeneratorFactory = std::function< std::unique_ptr<
+        marley::Generator>(const marley::JSON&) >;
+
+      /// @param info The JSON object stored under the "virtual" key in
+      /// the file
+      /// @param factory Function used to create each Generator
+      /// @param num_threads Maximum number of blocks to regenerate
+      /// concurrently. If this is zero, then the number of available
+      /// hardware threads will be used.
+      EventRegenerator(const marley::JSON& info, GeneratorFactory factory,
+        int num_threads = 0);
+
+      ~EventRegenerator();
+
+      /// @brief Checks that the MARLEY version and the data files match
+      /// those used to write the file
+      /// @details A marley::Error is thrown if a mismatch is found
+      static void verify(const marley::JSON& info);
+
+      /// @brief Load the next regenerated event
+      /// @return False if all events have already been read, or true
+      /// otherwise
+      bool next_event(marley::Event& ev);
+
+      /// @brief Move to the event with the given (zero-based) index
+      /// @details The next call to next_event() will load that event. An
+      /// index equal to num_events() is allowed and moves past the end
+      /// of the file.
+      /// @return False if the index is out of range, or true otherwise
+      bool seek(long event_index);
+
+      /// @brief Total number of events described by the file
+      inline long num_events() const { return num_events_; }
+
+      /// @brief Index of the event that will be loaded by the next call
+      /// to next_event()
+      inline long tell() const { return position_; }
+
+      /// @brief Returns true if there are more events to read
+      inline bool has_more_events() const { return position_ < num_events_; }
+
+      /// @brief Returns false if the most recent call to next_event()
+      /// failed to load an event
+      /// @details Like the state of a std::istream, this remains true
+      /// after the last event has been read successfully
+      inline bool good() const { return good_; }
+
+    protected:
+
+      /// @brief Range of events created using a single random number stream
+      struct Block {
+        long first_event;
+        long num_events;
+        uint_fast64_t stream;
+      };
+
+      /// @brief Starts the regeneration of the next block that has not
+      /// yet been launched
+      void launch_next_block();
+
+      /// @brief Waits for every block that is being regenerated
+      void wait_for_pending_blocks();
+
+      /// @brief Moves to the requested block, starting the regeneration of
+      /// it and of the blocks that follow as needed
+      void load_block(size_t block_index);
+
+      marley::JSON config_;
+      GeneratorFactory factory_;
+      std::vector<Block> blocks_;
+      long num_events_ = 0;
+
+      /// @brief Generators used to regenerate blocks (created as needed)
+      /// @details Block b is always regenerated by Generator
+      /// b % generators_.size()
+      std::vector< std::unique_ptr<marley::Generator> > generators_;
+
+      /// @brief Blocks whose regeneration has been started but whose
+      /// events have not yet been retrieved
+      std::deque< std::future< std::vector<marley::Event> > > pending_;
+
+      /// @brief Index of the next block to launch
+      size_t next_launch_ = 0;
+
+      /// @brief Index of the block currently held in current_events_
+      /// (equal to blocks_.size() if there is none)
+      size_t current_block_;
+
+      std::vector<marley::Event> current_events_;
+
+      /// @brief Index of the next event to read
+      long position_ = 0;
+
+      /// @brief Whether the most recent call to next_event() succeeded
+      bool good_ = true;
+  };
+
+}
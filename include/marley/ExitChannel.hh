@@ -21,6 +21,7 @@
 #include <vector>
 
 // MARLEY includes
+#include "marley/Arena.hh"
 #include "marley/ChebyshevInterpolatingFunction.hh"
 #include "marley/Fragment.hh"
 #include "marley/Generator.hh"
@@ -59,6 +60,14 @@ namespace marley {
         one_over_two_pi_rho_i_ = std::pow( 2. * marley_utils::pi * rho_i, -1 );
       }
 
+      /// @brief ExitChannel objects are placed in the current thread's
+      /// marley::Arena while an Arena::Scope is active
+      inline static void* operator new( size_t bytes )
+        { return marley::Arena::scoped_allocate( bytes ); }
+
+      inline static void operator delete( void* ptr )
+        { marley::Arena::scoped_deallocate( ptr ); }
+
       virtual ~ExitChannel() = default;
 
       /// @brief Returns true if this channel accesses the particle-unbound
@@ -287,8 +296,23 @@ namespace marley {
         double diff_width; ///< Partial differential decay width (MeV)
       };
 
+      /// @brief Container type used for the spin-parity width table
+      using SpinParityWidthTable = std::vector<SpinParityWidth,
+        marley::ArenaAllocator<SpinParityWidth> >;
+
       double sample_Exf(marley::Generator& gen) const;
 
+      /// @brief Computes the partial widths obtained when the differential
+      /// width is multiplied by @f$ \exp[k (E_{xf} - E_{c,\min})] @f$ for
+      /// several values of the slope @f$ k @f$ (MeV<sup> -1</sup>)
+      /// @details The same quadrature rule is used as for width(), and the
+      /// differential width is evaluated only once at each sampling point.
+      /// A slope of zero gives width() exactly.
+      /// @param[in] slopes Values of the slope
+      /// @param[out] widths Partial width (MeV) for each slope
+      void tilted_widths(const std::vector<double>& slopes,
+        std::vector<double>& widths) const;
+
       void sample_spin_parity(double Exf, int& two_Jf, marley::Parity& Pf,
         marley::Generator& gen) const;
 
@@ -310,7 +334,11 @@ namespace marley {
 
       /// @brief Table of possible final-state spin-parities together
       /// with their partial differential decay widths
-      mutable std::vector<SpinParityWidth> jpi_widths_table_;
+      mutable SpinParityWidthTable jpi_widths_table_;
+
+      /// @brief Scratch storage for the level densities evaluated by
+      /// differential_width()
+      mutable std::vector<double, marley::ArenaAllocator<double> > rhos_;
 
       /// @brief Flag that allows skipping the sampling of a final
       /// nuclear spin-parity (useful only for testing purposes)
@@ -392,6 +420,14 @@ namespace marley {
 
       inline virtual double E_c_max() const final override
         { return this->max_Exf(); }
+
+    protected:
+
+      // Scratch storage for the partial waves considered by
+      // differential_width() and their transmission coefficients
+      mutable std::vector<int, marley::ArenaAllocator<int> > two_js_;
+      mutable std::vector<int, marley::ArenaAllocator<int> > ls_;
+      mutable std::vector<double, marley::ArenaAllocator<double> > Tljs_;
   };
 
   /// @brief %Gamma emission exit channel that leads to the unbound continuum
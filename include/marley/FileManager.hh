@@ -16,6 +16,8 @@
 
 #pragma once
 #include <functional>
+#include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -102,6 +104,15 @@ namespace marley {
       /// @brief Returns the path to the root MARLEY folder
       inline std::string marley_dir() const { return marley_dir_; }
 
+      /// @brief Get the data files that have been located by searching
+      /// one or more directories using find_file()
+      /// @details This is used to record checksums of the data files that
+      /// were needed to generate events (see marley::VirtualOutputFile).
+      /// @return A map whose keys are the names that were passed to
+      /// find_file() and whose values are the full paths of the files
+      /// that were found
+      std::map<std::string, std::string> located_files() const;
+
     protected:
 
       /// @brief Create the singleton FileManager object
@@ -127,6 +138,14 @@ namespace marley {
       /// @brief Stores the value of the MARLEY environment variable
       /// (which points to the root folder of the source code distribution)
       std::string marley_dir_;
+
+      /// @brief Data files found so far by find_file()
+      /// @details Keys are the requested names, and values are the full
+      /// paths to the files
+      mutable std::map<std::string, std::string> located_files_;
+
+      /// @brief Mutex that protects located_files_
+      mutable std::mutex located_files_mutex_;
   };
 
 }
@@ -0,0 +1,115 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+
+// standard library includes
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace marley {
+
+  class EventFileReader;
+
+  /// @brief Converts MARLEY events into the flat per-event summary used by
+  /// marsum, but without any dependence on ROOT
+  /// @details The summary is written to a simple columnar binary file (and
+  /// optionally to a CSV file). Several input files are read in parallel,
+  /// but the events are always written in the order of the input files.
+  ///
+  /// The binary file has the following layout. All integers and
+  /// floating-point values use the byte order given in the footer (the
+  /// native one for the machine that wrote the file).
+  ///
+  ///   - The 8-byte magic string "MARFLAT1"
+  ///
+  ///   - One or more blocks of events. Each block begins with two uint64
+  ///     values: the number of events and the total number of
+  ///     de-excitation products in the block. These are followed by the
+  ///     values for each column (listed in the footer) in order. Event
+  ///     columns have one value per event, and product columns have one
+  ///     value per product. The products of each event are stored
+  ///     consecutively, with the count given by the "np" column.
+  ///
+  ///   - A JSON footer that lists the columns (name, type, and length), the
+  ///     offset and size of each block, the total number of events, and the
+  ///     input file names
+  ///
+  ///   - A uint64 giving the size of the footer in bytes, followed by the
+  ///     magic string again
+  class FlatSummaryWriter {
+
+    public:
+
+      /// @brief Function used to open each input file
+      using ReaderFactory = std::function< std::unique_ptr<
+        marley::EventFileReader>( const std::string& file_name ) >;
+
+      /// @brief Outcome of the conversion for a single input file
+      struct FileResult {
+        uint64_t num_events = 0u; ///< Number of events written
+        std::string error; ///< Description of any failure (or empty)
+      };
+
+      /// @brief Default number of events in each block of the output file
+      static constexpr size_t DEFAULT_EVENTS_PER_BLOCK = 65536u;
+
+      /// @param input_files Names of the event files to convert
+      /// @param num_threads Total number of threads to use. Any that are
+      /// not needed to read the input files are used to regenerate the
+      /// events in virtual event files.
+      /// @param events_per_block Number of events in each block of the
+      /// output file
+      /// @param make_reader Function used to open each input file. If it is
+      /// empty, a marley::EventFileReader is used.
+      FlatSummaryWriter( const std::vector<std::string>& input_files,
+        int num_threads = 1, size_t events_per_block
+        = DEFAULT_EVENTS_PER_BLOCK, ReaderFactory make_reader = nullptr );
+
+      /// @brief Converts the input files
+      /// @details Input files that cannot be read are skipped (after any
+      /// of their events that were read successfully). Their errors are
+      /// reported by file_results().
+      /// @param out Stream to which the binary summary will be written
+      /// @param csv Stream to which a CSV copy of the summary will be
+      /// written, or nullptr if none is needed. The values of the
+      /// de-excitation products in each row are separated by semicolons.
+      /// @return The total number of events written
+      uint64_t write( std::ostream& out, std::ostream* csv = nullptr );
+
+      /// @brief Get the outcome of the last call to write() for each input
+      /// file
+      inline const std::vector<FileResult>& file_results() const;
+
+    private:
+
+      std::vector<std::string> input_files_;
+      int num_threads_;
+      size_t events_per_block_;
+      ReaderFactory make_reader_;
+      std::vector<FileResult> file_results_;
+  };
+
+  // Inline function definitions
+  inline const std::vector<FlatSummaryWriter::FileResult>&
+    FlatSummaryWriter::file_results() const { return file_results_; }
+
+}
@@ -27,6 +27,8 @@ namespace marley {
   /// unavailable. In particular, the HauserFeshbachDecay class uses instances
   /// of GammaStrengthFunctionModel to model the competition between gamma-ray
   /// emission and particle evaporation for highly-excited nuclear states.
+  /// Like the other nuclear model classes, they are immutable after
+  /// construction and may be shared between threads.
   class GammaStrengthFunctionModel {
 
     public:
@@ -49,7 +51,7 @@ namespace marley {
       /// @param l Multipolarity of the transition
       /// @param e_gamma Gamma-ray energy (MeV)
       virtual double strength_function(TransitionType type, int l,
-        double e_gamma) = 0;
+        double e_gamma) const = 0;
 
       /// @brief Returns the gamma-ray transmission coefficient (dimensionless)
       /// for the requested gamma energy and multipolarity
@@ -64,7 +66,7 @@ namespace marley {
       /// @param l Multipolarity of the transition
       /// @param e_gamma Gamma-ray energy (MeV)
       virtual double transmission_coefficient(TransitionType type, int l,
-        double e_gamma) = 0;
+        double e_gamma) const = 0;
 
     protected:
 
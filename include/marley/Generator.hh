@@ -16,6 +16,7 @@
 
 #pragma once
 #include <limits>
+#include <map>
 #include <memory>
 #include <random>
 #include <sstream>
@@ -27,9 +28,11 @@
 #include "marley/LevelDensityModel.hh"
 #include "marley/OpticalModel.hh"
 #include "marley/Parity.hh"
+#include "marley/PrimaryEventFilter.hh"
 #include "marley/ProjectileDirectionRotator.hh"
 #include "marley/RotationMatrix.hh"
 #include "marley/StructureDatabase.hh"
+#include "marley/SystematicUniverses.hh"
 #include "marley/Target.hh"
 #include "marley/marley_utils.hh"
 
@@ -52,14 +55,87 @@ namespace marley {
 
       /// @brief Create an Event using the NeutrinoSource, Target, Reaction,
       /// and StructureDatabase objects owned by this Generator
+      /// @details If primary event cuts have been configured, then this is
+      /// equivalent to calling create_primary_event() followed by
+      /// resolve_deexcitation(). Otherwise, the nuclear de-excitation is
+      /// simulated right away using the main random number stream.
       marley::Event create_event();
 
+      /// @brief Create an Event that passes the configured primary event
+      /// cuts, but defer the simulation of the nuclear de-excitation
+      /// @details Primary events are sampled until one is accepted by the
+      /// PrimaryEventFilter. The returned Event contains only the
+      /// two-two scattering products (rotated to match the projectile
+      /// direction). If de-excitations are enabled, the Event is marked as
+      /// having a pending de-excitation, together with the seed of a
+      /// dedicated random number sub-stream that will be used to simulate
+      /// it. Passing the Event to resolve_deexcitation() then gives
+      /// exactly the same result as create_event() would have if cuts are
+      /// in use.
+      marley::Event create_primary_event();
+
+      /// @brief Simulate the nuclear de-excitation for an Event created by
+      /// create_primary_event()
+      /// @details The random number sub-stream stored in the Event is used,
+      /// so the result does not depend on when this function is called or
+      /// on how many other events were created in the meantime. Events
+      /// without a pending de-excitation are left unchanged.
+      void resolve_deexcitation(marley::Event& ev);
+
+      /// @brief Set the cuts applied to primary events
+      /// @details If the filter has any cuts, then the fraction of primary
+      /// events that pass them is estimated using a separate random number
+      /// stream (so that the state of this Generator is not altered). The
+      /// estimate is made right away (or, while the Generator is still being
+      /// configured, when the neutrino energy PDF is normalized) and again
+      /// whenever the energy PDF changes. It is folded into the
+      /// flux-averaged total cross section.
+      /// @param filter The cuts to apply
+      /// @param pilot_events Number of primary events to sample when
+      /// estimating the cut efficiency
+      void set_primary_filter( const marley::PrimaryEventFilter& filter,
+        long pilot_events = DEFAULT_PILOT_EVENTS_ );
+
+      /// @brief Get the cuts applied to primary events
+      inline const marley::PrimaryEventFilter& get_primary_filter() const;
+
+      /// @brief Set the universes for which systematic weights are computed
+      /// @details Every Event created afterwards carries one weight per
+      /// universe. The weights do not affect the random number stream, so
+      /// the events themselves are unchanged.
+      inline void set_universes( const marley::SystematicUniverses& su );
+
+      /// @brief Get the universes for which systematic weights are computed
+      inline const marley::SystematicUniverses& get_universes() const;
+
+      /// @brief Get the estimated fraction of primary events that pass
+      /// the configured cuts
+      inline double cut_efficiency() const;
+
+      /// @brief Get the number of primary events sampled by
+      /// create_primary_event() so far
+      inline long primary_events_sampled() const;
+
+      /// @brief Get the number of primary events accepted by
+      /// create_primary_event() so far
+      inline long primary_events_accepted() const;
+
       /// @brief Get the seed used to initialize this Generator
       inline uint_fast64_t get_seed() const;
 
       /// @brief Reseeds the Generator
       void reseed(uint_fast64_t seed);
 
+      /// @brief Restart the random number stream used to create events
+      /// @details The random number generator is reseeded using both the
+      /// initial seed and the stream index, and the estimated maximum of
+      /// the energy PDF is reset to its default value. The events created
+      /// afterwards thus depend only on the configuration, the seed, and the
+      /// stream index, which allows blocks of events to be regenerated
+      /// independently (see marley::VirtualOutputFile).
+      /// @param stream Index of the random number stream to use
+      void start_event_stream(uint_fast64_t stream);
+
       /// @brief Use a string to set this Generator's internal state
       /// @details This function is typically used to restore a Generator
       /// to a state saved using get_state_string().
@@ -130,6 +206,24 @@ namespace marley {
       /// @return Reference to the sampled Reaction owned by this Generator
       marley::Reaction& sample_reaction(double& E);
 
+      /// @brief Set the number of energy bins in the table used to sample
+      /// reactions
+      /// @details If the number of bins is positive, then the reacting
+      /// neutrino energy and the Reaction are sampled together from a table
+      /// of upper bounds on each flux-weighted reaction cross section in
+      /// each energy bin. The sampled pair is accepted or rejected using the
+      /// exact cross section of that Reaction alone, so the cost per event
+      /// does not grow with the number of configured reactions. The table is
+      /// used only when the flux is weighted by the cross sections and the
+      /// source is not monoenergetic. A value of zero (the default) disables
+      /// the table. The events for a given seed depend on this setting.
+      /// @param bins The number of energy bins (zero or positive)
+      void set_reaction_table_bins( int bins );
+
+      /// @brief Get the number of energy bins in the table used to sample
+      /// reactions (zero if the table is disabled)
+      inline int reaction_table_bins() const;
+
       /// @brief Probability density function that describes the distribution
       /// of reacting neutrino energies
       /// @details This function computes the cross-section weighted neutrino
@@ -189,6 +283,18 @@ namespace marley {
         return rnd(rand_gen_, params);
       }
 
+      /// @brief Sample an index from a discrete distribution
+      /// @details The probability of choosing each index is proportional to
+      /// the corresponding weight. Unlike std::discrete_distribution, no
+      /// memory is allocated, and the result does not depend on the
+      /// standard library implementation. No random number is drawn when
+      /// there are fewer than two weights.
+      /// @param begin Iterator to the first (nonnegative) weight
+      /// @param end Iterator one past the last weight
+      /// @return The zero-based index of the sampled weight
+      template <typename Iterator> size_t sample_discrete( Iterator begin,
+        Iterator end );
+
       /// @brief Sets the direction of the incident neutrinos to use when
       /// generating events
       /// @param dir_vec Vector that points in the direction of the incident
@@ -216,10 +322,22 @@ namespace marley {
       /// enabled neutrino reactions, taking target atom fractions into
       /// account as appropriate
       /// @details If flux weighting is disabled (via a call to
-      /// set_weight_flux()) then this function will return zero
+      /// set_weight_flux()) then this function will return zero. If
+      /// primary event cuts are configured, then the result is multiplied
+      /// by the estimated cut efficiency.
       /// @return Total cross section (MeV<sup> -2</sup>)
       double flux_averaged_total_xs() const;
 
+      /// @brief Computes the contribution of a single neutrino type to
+      /// flux_averaged_total_xs()
+      /// @details The contributions of all neutrino types produced by the
+      /// source sum to flux_averaged_total_xs(), so dividing the two gives
+      /// the expected fraction of events initiated by the neutrino type
+      /// pdg_a. The overall primary event cut efficiency is applied.
+      /// @param pdg_a PDG code of the neutrino type
+      /// @return Total cross section (MeV<sup> -2</sup>)
+      double flux_averaged_total_xs( int pdg_a ) const;
+
       /// @brief Computes the total cross section at fixed energy for all
       /// configured reactions involving a particular target atom.
       /// @details Atom fractions in the owned Target are ignored by this
@@ -246,6 +364,47 @@ namespace marley {
       /// @return Abundance-weighted total cross section (MeV<sup> -2</sup> / atom)
       double total_xs(int pdg_a, double KEa) const;
 
+      /// @brief Computes total cross sections for a span of projectile
+      /// energies in a single call
+      /// @details This is the vectorized counterpart of the two
+      /// single-energy total_xs() overloads. The outer loop runs over the
+      /// configured reactions, so the reaction matching and target atom
+      /// fraction lookups are done once per call rather than once per
+      /// energy. The function does not modify the Generator and may be
+      /// called concurrently from multiple threads.
+      /// @note This function is not used as part of the normal MARLEY
+      /// workflow. It serves as part of an API that enables MARLEY to be
+      /// interfaced with external fitters and flux drivers.
+      /// @param pdg_a The PDG code for the projectile
+      /// @param KEa Array of projectile kinetic energies (MeV)
+      /// @param num_energies Number of elements in KEa
+      /// @param[out] total Array of num_energies elements that will be loaded
+      /// with the abundance-weighted total cross section
+      /// (MeV<sup> -2</sup> / atom), i.e., with the values returned by
+      /// total_xs(int, double). May be nullptr.
+      /// @param[out] per_reaction Array of num_energies * R elements, where
+      /// R is the size of get_reactions(), that will be loaded with the total
+      /// cross section (MeV<sup> -2</sup>) for a single target atom for each
+      /// Reaction. Element i*R + j holds the value for the i-th energy and
+      /// j-th Reaction. May be nullptr.
+      /// @param[out] per_target Array of num_energies * N elements, where
+      /// N is the number of nuclides in the owned Target, that will be loaded
+      /// with the values returned by total_xs(int, double, int). Element
+      /// i*N + k holds the value for the i-th energy and the k-th nuclide in
+      /// the order of Target::atom_fraction_map(). May be nullptr.
+      void total_xs(int pdg_a, const double* KEa, size_t num_energies,
+        double* total, double* per_reaction = nullptr,
+        double* per_target = nullptr) const;
+
+      /// @brief Computes total cross sections for a span of projectiles
+      /// @details Identical to total_xs(int, const double*, size_t, double*,
+      /// double*, double*) except that the projectile PDG code may differ
+      /// for each element of KEa
+      /// @param pdg_a Array of num_energies projectile PDG codes
+      void total_xs(const int* pdg_a, const double* KEa, size_t num_energies,
+        double* total, double* per_reaction = nullptr,
+        double* per_target = nullptr) const;
+
       /// @brief Creates an event object for a fixed projectile species,
       /// kinetic energy, and atomic target
       /// @details If no energetically-accessible reaction is available for
@@ -275,6 +434,38 @@ namespace marley {
       /// use in E_pdf()
       void normalize_E_pdf();
 
+      /// @brief Helper function that rebuilds reaction_index_
+      void update_reaction_index();
+
+      /// @brief Sample a double uniformly on [0, 1) using the 53 most
+      /// significant bits of a single draw from rand_gen_
+      double random_fraction();
+
+      /// @brief Rebuilds the table used by sample_reaction_from_table()
+      void build_reaction_table();
+
+      /// @brief Rebuilds the alias table used to choose a cell of the
+      /// reaction table
+      void build_reaction_alias_table();
+
+      /// @brief Implementation of sample_reaction() that uses the reaction
+      /// table
+      marley::Reaction& sample_reaction_from_table( double& E );
+
+      /// @brief Creates a primary event without applying any cuts
+      /// @details The event is rotated to match the projectile direction.
+      /// @param defer If true, a pending de-excitation is recorded in the
+      /// event instead of being simulated right away
+      marley::Event sample_primary_event( bool defer );
+
+      /// @brief Estimates the fraction of primary events that pass the
+      /// configured cuts
+      void update_cut_efficiency();
+
+      /// @brief Default number of primary events used to estimate the cut
+      /// efficiency
+      static constexpr long DEFAULT_PILOT_EVENTS_ = 100000;
+
       /// @brief Print the MARLEY logo (called once during construction of
       /// the first Generator object) to any active Logger streams
       void print_logo();
@@ -305,14 +496,66 @@ namespace marley {
       /// @brief Reaction(s) used to sample reacting neutrino energies
       std::vector< std::unique_ptr<marley::Reaction> > reactions_;
 
+      /// @brief PDG codes of the neutrino types produced by source_
+      std::vector<int> source_pdgs_;
+
+      /// @brief Information about a Reaction that is cached for the
+      /// evaluation of E_pdf()
+      struct ReactionChannel {
+        size_t index; ///< Position of the Reaction in reactions_
+        double weight; ///< Target atom fraction for the Reaction
+        double threshold; ///< Projectile kinetic energy threshold (MeV)
+      };
+
+      /// @brief Reactions that involve an atom present in the Target, indexed
+      /// by projectile PDG code
+      /// @details Entries for each projectile are stored in the same order
+      /// as reactions_. This index is rebuilt by update_reaction_index()
+      /// whenever the configured reactions or the Target change.
+      std::map< int, std::vector<ReactionChannel> > reaction_index_;
+
       /// @brief Total cross section values to use as weights for sampling a
       /// Reaction in sample_reaction()
       /// @details These total cross section values are energy dependent. They
-      /// are therefore updated with every call to E_pdf().
+      /// are therefore updated with every call to E_pdf(). Only reactions
+      /// that are open at the current energy are included.
       std::vector<double> total_xs_values_;
 
-      /// @brief Discrete distribution used for Reaction sampling
-      std::discrete_distribution<size_t> r_index_dist_;
+      /// @brief Positions in reactions_ of the Reaction objects whose
+      /// cross sections are stored in total_xs_values_
+      std::vector<size_t> open_reactions_;
+
+      /// @brief Number of energy bins in the reaction table
+      int reaction_table_bins_ = 0;
+
+      /// @brief Energy bin of the reaction table for a single projectile
+      /// and Reaction
+      struct ReactionCell {
+        size_t index; ///< Position of the Reaction in reactions_
+        int pdg_a; ///< PDG code of the projectile
+        double weight; ///< Target atom fraction for the Reaction
+        double E_low; ///< Lower edge of the energy bin (MeV)
+        double width; ///< Width of the energy bin (MeV)
+        /// @brief Upper bound on the flux-weighted total cross section
+        /// within the bin
+        double bound;
+      };
+
+      /// @brief Flux-weighted total cross section used by the reaction table
+      /// @param cell The cell that gives the projectile and Reaction
+      /// @param E Total energy of the reacting neutrino
+      double reaction_cell_pdf( const ReactionCell& cell, double E ) const;
+
+      /// @brief Cells of the reaction table with nonzero upper bounds
+      /// @details This is empty whenever the table is not used.
+      std::vector<ReactionCell> reaction_cells_;
+
+      /// @brief Probability of keeping each cell when it is chosen from the
+      /// alias table (Walker's alias method)
+      std::vector<double> cell_cutoffs_;
+
+      /// @brief Cell to use instead when a cell is not kept
+      std::vector<size_t> cell_aliases_;
 
       /// @brief Whether the generator should weight the incident
       /// neutrino spectrum by the reaction cross section(s)
@@ -356,6 +599,25 @@ namespace marley {
       /// circumstances
       bool do_deexcitations_ = true;
 
+      /// @brief Cuts applied to primary events by create_primary_event()
+      marley::PrimaryEventFilter primary_filter_;
+
+      /// @brief Universes for which systematic weights are computed
+      marley::SystematicUniverses universes_;
+
+      /// @brief Number of primary events to use when estimating the
+      /// cut efficiency
+      long pilot_events_ = DEFAULT_PILOT_EVENTS_;
+
+      /// @brief Estimated fraction of primary events that pass the cuts
+      double cut_efficiency_ = 1.;
+
+      /// @brief Number of primary events sampled by create_primary_event()
+      long primaries_sampled_ = 0;
+
+      /// @brief Number of primary events accepted by create_primary_event()
+      long primaries_accepted_ = 0;
+
       /// @brief Computes the total cross section at fixed energy for all
       /// configured reactions involving a particular target atom.
       /// @details Atom fractions in the owned Target are ignored by this
@@ -377,9 +639,42 @@ namespace marley {
       /// @return Total cross section (MeV<sup> -2</sup>)
       double total_xs(int pdg_a, double KEa, int pdg_atom,
         std::vector<size_t>* index_vec, std::vector<double>* xsec_vec) const;
+
+      /// @brief Helper function for the public vectorized total_xs()
+      /// overloads
+      /// @param pdg_a Array of projectile PDG codes
+      /// @param pdg_stride Spacing between elements of pdg_a to use for
+      /// consecutive energies (zero if all projectiles are the same)
+      void total_xs(const int* pdg_a, size_t pdg_stride, const double* KEa,
+        size_t num_energies, double* total, double* per_reaction,
+        double* per_target) const;
   };
 
   // Inline function definitions
+  template <typename Iterator> size_t Generator::sample_discrete(
+    Iterator begin, Iterator end )
+  {
+    size_t num_weights = 0u;
+    double sum = 0.;
+    for ( Iterator iter = begin; iter != end; ++iter ) {
+      sum += *iter;
+      ++num_weights;
+    }
+    if ( num_weights < 2u ) return 0u;
+
+    // Walk through the cumulative weights until they pass a uniformly
+    // sampled fraction of the total. The last index is chosen if rounding
+    // errors prevent this.
+    double target = this->random_fraction() * sum;
+    double cumulative = 0.;
+    size_t index = 0u;
+    for ( Iterator iter = begin; index + 1u < num_weights; ++iter, ++index ) {
+      cumulative += *iter;
+      if ( cumulative > target ) return index;
+    }
+    return index;
+  }
+
   inline uint_fast64_t Generator::get_seed() const { return seed_; }
 
   inline const std::vector<std::unique_ptr<marley::Reaction> >&
@@ -390,4 +685,24 @@ namespace marley {
 
   inline void Generator::set_do_deexcitations( bool do_them )
     { do_deexcitations_ = do_them; }
+
+  inline const marley::PrimaryEventFilter& Generator::get_primary_filter()
+    const { return primary_filter_; }
+
+  inline double Generator::cut_efficiency() const { return cut_efficiency_; }
+
+  inline int Generator::reaction_table_bins() const
+    { return reaction_table_bins_; }
+
+  inline void Generator::set_universes(
+    const marley::SystematicUniverses& su ) { universes_ = su; }
+
+  inline const marley::SystematicUniverses& Generator::get_universes() const
+    { return universes_; }
+
+  inline long Generator::primary_events_sampled() const
+    { return primaries_sampled_; }
+
+  inline long Generator::primary_events_accepted() const
+    { return primaries_accepted_; }
 }
@@ -18,6 +18,7 @@
 #include <memory>
 #include <ostream>
 
+#include "marley/Arena.hh"
 #include "marley/ExitChannel.hh"
 #include "marley/Parity.hh"
 
@@ -42,6 +43,14 @@ namespace marley {
         double Exi, int twoJi, marley::Parity Pi,
         marley::StructureDatabase& sdb );
 
+      /// @brief HauserFeshbachDecay objects are placed in the current
+      /// thread's marley::Arena while an Arena::Scope is active
+      inline static void* operator new( size_t bytes )
+        { return marley::Arena::scoped_allocate( bytes ); }
+
+      inline static void operator delete( void* ptr )
+        { marley::Arena::scoped_deallocate( ptr ); }
+
       /// @brief Simulates a decay of the compound nucleus
       /// @param[out] Exf Final nuclear excitation energy (MeV)
       /// @param[out] twoJf Two times the final nuclear spin
@@ -50,10 +59,14 @@ namespace marley {
       /// fragment or &gamma;-ray emitted during the decay
       /// @param[out] residual_nucleus Particle object representing the
       /// final-state nucleus
-      /// param gen Generator to use for random sampling
+      /// @param gen Generator to use for random sampling
+      /// @param[in,out] weights If this pointer is not null and the vector
+      /// is not empty, then its elements are multiplied by the likelihood
+      /// ratios for the sampled exit channel in each of the systematic
+      /// universes owned by gen
       bool do_decay( double& Exf, int& twoJf, marley::Parity& Pf,
         marley::Particle& emitted_particle, marley::Particle& residual_nucleus,
-        marley::Generator& gen );
+        marley::Generator& gen, std::vector<double>* weights = nullptr );
 
       /// @brief Print information about the possible decay channels to a
       /// std::ostream
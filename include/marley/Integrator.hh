@@ -41,6 +41,18 @@ namespace marley {
       double num_integrate(const std::function<double(double)>& f,
         double a, double b) const;
 
+      /// @brief Get the sampling points and weights used by num_integrate()
+      /// @details The sum of weights[k] * f(points[k]) over all k is equal
+      /// (up to rounding) to num_integrate(f, a, b). This allows several
+      /// integrands that share an expensive factor to be integrated using
+      /// the same evaluations of it.
+      /// @param[in] a Lower bound of the integration interval
+      /// @param[in] b Upper bound of the integration interval
+      /// @param[out] points Sampling points in [a,b]
+      /// @param[out] weights Weight for each sampling point
+      void get_sampling_points(double a, double b,
+        std::vector<double>& points, std::vector<double>& weights) const;
+
     private:
 
       /// @brief use 2N_ sampling points to perform numerical integration
@@ -474,9 +474,10 @@ namespace marley {
         // Use max_digits10 for outputting double-precision floating-point
         // numbers. This ensures that repeated input/output via JSON will
         // not result in any loss of precision. For more information, please
-        // see http://tinyurl.com/p8wyhnn
-        static std::ostringstream out_float;
-        static bool set_precision = false;
+        // see http://tinyurl.com/p8wyhnn. The formatting stream is
+        // thread-local so that events may be serialized concurrently.
+        static thread_local std::ostringstream out_float;
+        static thread_local bool set_precision = false;
         if (!set_precision) {
           out_float.precision(std::numeric_limits<double>::max_digits10);
           set_precision = true;
@@ -33,7 +33,12 @@ namespace marley {
       using InterpMethod = marley::InterpolationGrid<double>
         ::InterpolationMethod;
 
-      explicit JSONConfig(const marley::JSON& object);
+      /// @param object JSON object containing the job configuration
+      /// @param configure_logger Whether the marley::Logger should be set
+      /// up according to the "log" key (or its default). Passing false
+      /// leaves the current Logger settings untouched.
+      explicit JSONConfig(const marley::JSON& object,
+        bool configure_logger = true);
       explicit JSONConfig(const std::string& json_filename);
 
       marley::Generator create_generator() const;
@@ -62,6 +67,13 @@ namespace marley {
 
     protected:
 
+      /// @brief Creates a NeutrinoSource from its JSON specification
+      /// @param source_spec JSON object describing the source
+      /// @param allow_composite Whether a composite source (which combines
+      /// several other sources) may be created
+      std::unique_ptr<marley::NeutrinoSource> create_neutrino_source(
+        const marley::JSON& source_spec, bool allow_composite = true) const;
+
       /// @brief Helper function for loading strings from the JSON
       /// configuration
       std::string source_get(const char* name, const marley::JSON& source_spec,
@@ -0,0 +1,157 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <string>
+#include <vector>
+
+#include "marley/JSON.hh"
+
+namespace marley {
+
+  /// @brief Work queue kept in a shared directory that allows any number of
+  /// processes to cooperate on a single run
+  /// @details A run of num_events() events is divided into work units of
+  /// events_per_unit() consecutive events each. Unit @f$ i @f$ is generated
+  /// using random number stream @f$ i @f$ (see
+  /// marley::Generator::start_event_stream()), so its contents do not
+  /// depend on which process generates it. Each unit is represented by a
+  /// file that moves between the following subfolders of the queue
+  /// directory:
+  ///
+  ///   - todo: Units that are waiting to be claimed
+  ///   - claimed: Units being generated. The name of each file ends with
+  ///     an identifier for the process that claimed it.
+  ///   - done: Units whose output files have been published
+  ///
+  /// All state changes are made by renaming files, which is atomic on POSIX
+  /// file systems (including NFS), so no locking or external services are
+  /// needed. A process that claims a unit refreshes the modification time of
+  /// its file with heartbeat(). Units that go without a heartbeat for longer
+  /// than the timeout are assumed to be abandoned and are returned to the
+  /// todo folder by claim(). Once every unit is done, one of the processes
+  /// concatenates the unit output files using merge().
+  class JobQueue {
+
+    public:
+
+      /// @brief A range of events to be generated by one process
+      struct Unit {
+        long index; ///< Unit index (also used as the random number stream)
+        long first_event; ///< Zero-based index of the first event
+        long num_events; ///< Number of events in the unit
+      };
+
+      /// @brief Opens the queue in a directory, creating it if needed
+      /// @details If the queue does not exist yet, it is created from the
+      /// given description. Otherwise the stored description is used. If
+      /// several processes try to create the queue at the same time, only
+      /// one of them succeeds and the others use its description.
+      /// @param directory Name of the shared queue directory
+      /// @param description JSON object with the keys "events" (total
+      /// number of events) and "events_per_unit". Any other keys (e.g., the
+      /// job configuration) are stored unchanged.
+      /// @param timeout Time (s) after which a claimed unit without a
+      /// heartbeat is considered abandoned
+      JobQueue( const std::string& directory,
+        const marley::JSON& description, double timeout );
+
+      /// @brief Returns the description that was used to create the queue
+      inline const marley::JSON& description() const { return description_; }
+
+      inline long num_events() const { return num_events_; }
+      inline long events_per_unit() const { return events_per_unit_; }
+      inline long num_units() const { return num_units_; }
+
+      /// @brief Returns the identifier used for this process in file names
+      inline const std::string& owner() const { return owner_; }
+
+      /// @brief Claims the next available unit
+      /// @details If no units are waiting, abandoned units are reclaimed
+      /// first
+      /// @param[out] unit The unit that was claimed
+      /// @return False if there are no units left to claim
+      bool claim( Unit& unit );
+
+      /// @brief Marks a claimed unit as still being worked on
+      void heartbeat( const Unit& unit ) const;
+
+      /// @brief Returns a claimed unit to the queue without completing it
+      void release( const Unit& unit ) const;
+
+      /// @brief Name of the temporary file to which the output of a unit
+      /// should be written
+      /// @param unit The claimed unit
+      /// @param file_index Index of the output file (for runs that write
+      /// several files)
+      std::string unit_output_name( const Unit& unit,
+        size_t file_index ) const;
+
+      /// @brief Publishes the output files for a unit and marks it as done
+      /// @param unit The claimed unit
+      /// @param header_bytes Size of the header at the start of each
+      /// output file. The header is only kept for the first unit when the
+      /// files are merged.
+      void complete( const Unit& unit,
+        const std::vector<long>& header_bytes ) const;
+
+      /// @brief Returns the number of units that are done
+      long num_done() const;
+
+      /// @brief Returns true if every unit is done
+      inline bool finished() const { return num_done() == num_units_; }
+
+      /// @brief Returns true if the unit output files have been merged
+      bool merged() const;
+
+      /// @brief Concatenates the output files of all units
+      /// @details Only one process performs the merge. The others return
+      /// false immediately.
+      /// @param file_names Names of the merged output files (one for each
+      /// file index passed to unit_output_name())
+      /// @return True if this process performed the merge
+      bool merge( const std::vector<std::string>& file_names ) const;
+
+    private:
+
+      /// @brief Creates the queue directory layout and unit files, or
+      /// loads the description of an existing queue
+      void initialize( const marley::JSON& description );
+
+      std::string unit_name( long index ) const;
+      std::string path( const std::string& folder,
+        const std::string& name = "" ) const;
+      Unit make_unit( long index ) const;
+
+      /// @brief Returns the names of the files in a queue subfolder
+      std::vector<std::string> list( const std::string& folder ) const;
+
+      /// @brief Returns the age (s) of a file, or a negative value if it
+      /// does not exist
+      double age( const std::string& file_name ) const;
+
+      std::string directory_;
+      std::string job_directory_;
+      marley::JSON description_;
+      double timeout_;
+      std::string owner_;
+      long num_events_ = 0;
+      long events_per_unit_ = 0;
+      long num_units_ = 0;
+  };
+
+}
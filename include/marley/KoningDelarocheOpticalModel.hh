@@ -38,6 +38,14 @@ namespace marley {
 
     public:
 
+      /// @brief Default step size (fm) for computing transmission coefficients
+      /// via the
+      /// <a href="https://en.wikipedia.org/wiki/Numerov%27s_method">Numerov
+      /// method</a>
+      /// @details The step size used by the StructureDatabase may be changed
+      /// using the "numerov_step_size" configuration file key
+      static constexpr double DEFAULT_NUMEROV_STEP_SIZE_ = 0.1;
+
       /// @param Z Atomic number of the desired nuclide
       /// @param A Mass number of the desired nuclide
       /// @param step_size Step size (fm) to use for numerical integration of
@@ -45,50 +53,49 @@ namespace marley {
       KoningDelarocheOpticalModel(int Z, int A, double step_size
         = DEFAULT_NUMEROV_STEP_SIZE_);
 
+      using OpticalModel::optical_model_potential;
+      using OpticalModel::transmission_coefficient;
+      using OpticalModel::total_cross_section;
+
       virtual std::complex<double> optical_model_potential(double r,
         double fragment_KE_lab, int fragment_pdg, int two_j, int l, int two_s,
-        int target_charge = 0) override;
+        int target_charge, Workspace& ws) const override;
 
       virtual double transmission_coefficient(double total_KE_CM,
-        int fragment_pdg, int two_j, int l, int two_s, int target_charge = 0)
-        override;
+        int fragment_pdg, int two_j, int l, int two_s, int target_charge,
+        Workspace& ws) const override;
+
+      /// @details The kinematic variables are computed only once for all of
+      /// the partial waves
+      virtual void transmission_coefficients(double total_KE_CM,
+        int fragment_pdg, int two_s, const int* two_js, const int* ls,
+        size_t num_waves, int target_charge, double* Ts, Workspace& ws)
+        const override;
 
       virtual double total_cross_section(double fragment_KE_lab,
-        int fragment_pdg, int two_s, size_t l_max, int target_charge = 0)
-        override;
+        int fragment_pdg, int two_s, size_t l_max, int target_charge,
+        Workspace& ws) const override;
 
     private:
 
-      /// Total CM frame kinetic energy of both particles
-      double total_CM_frame_KE_;
-      /// Mass of the fragment
-      double fragment_mass_;
-      /// Fragment kinetic energy in the laboratory frame (rest frame of the
-      /// target nucleus represented by this optical potential)
-      double fragment_KE_lab_;
-      /// 3-momentum of either particle in the CM frame
-      double CM_frame_momentum_squared_;
-
-      // Storage for the mass of the nuclear target represented by this
-      // optical model potential. Its value will be adjusted based on
-      // the ionization state of the target.
-      double target_mass_;
-
       // Helper function for computing optical model transmission coefficients
       // and cross sections
       std::complex<double> s_matrix_element(int fragment_pdg, int two_j,
-        int l, int two_s);
+        int l, int two_s, Workspace& ws) const;
+
+      // Converts an S-matrix element into a transmission coefficient
+      double transmission_from_s_matrix(const std::complex<double>& S) const;
 
       // Helper functions for computing the optical model potential
       void calculate_om_parameters(int fragment_pdg, int two_j, int l,
-        int two_s);
+        int two_s, Workspace& ws) const;
 
       // Compute the optical model potential at radius r
-      std::complex<double> omp(double r) const;
+      std::complex<double> omp(double r, const Workspace& ws) const;
 
       // Computes the optical model potential minus the Coulomb potential at
       // radius r
-      std::complex<double> omp_minus_Vc(double r) const;
+      std::complex<double> omp_minus_Vc(double r, const Workspace& ws) const;
 
       // Woods-Saxon shape
       double f(double r, double R, double a) const;
@@ -102,11 +109,12 @@ namespace marley {
 
       // Non-derivative radial Schrödinger equation terms to use for computing
       // transmission coefficients via the Numerov method
-      std::complex<double> a(double r, int l);
+      std::complex<double> a(double r, int l, const Workspace& ws) const;
 
       // Version of Schrodinger equation terms with the optical model potential
       // U pre-computed
-      std::complex<double> a(double r, int l, std::complex<double> U) const;
+      std::complex<double> a(double r, int l, std::complex<double> U,
+        const Workspace& ws) const;
 
       // Neutron parameters
       double v1n, v2n, v3n, v4n, w1n, w2n, d1n, d2n, d3n, vso1n, vso2n;
@@ -123,12 +131,6 @@ namespace marley {
       static constexpr double lambda_piplus2 = (marley_utils::hbar_c
         / mpiplus) * (marley_utils::hbar_c / mpiplus); // fm
 
-      // Temporary storage for optical model calculations
-      double Rv, av, Rd, ad, Rso, aso; // Geometrical parameters
-      double Vv, Wv, Wd, Vso, Wso; // Energy-dependent terms in the potential
-      double spin_orbit_eigenvalue; // Eigenvalue of the spin-orbit operator
-      int z; // Fragment atomic number
-
       // Threshold for abs(U - Vc) used to find a suitable matching radius for
       // computing transmission coefficients.
       static constexpr double MATCHING_RADIUS_THRESHOLD = 1e-3;
@@ -137,17 +139,15 @@ namespace marley {
       /// equation using the Numerov method
       double step_size_ = DEFAULT_NUMEROV_STEP_SIZE_;
 
-      /// @brief Default step size (fm) for computing transmission coefficients
-      /// via the
-      /// <a href="https://en.wikipedia.org/wiki/Numerov%27s_method">Numerov
-      /// method</a>
-      /// @todo Make this a user-controlled value specified in the
-      /// configuration file
-      static constexpr double DEFAULT_NUMEROV_STEP_SIZE_ = 0.1;
-
       // More helper functions
-      void calculate_kinematic_variables(double KE_tot_CM, int fragment_pdg);
-      void update_target_mass(int target_charge);
+      void calculate_kinematic_variables(double KE_tot_CM, int fragment_pdg,
+        Workspace& ws) const;
+      void update_target_mass(int target_charge, Workspace& ws) const;
+
+      // Total CM frame kinetic energy corresponding to a lab frame fragment
+      // kinetic energy. The target mass in ws must already be set.
+      double total_KE_CM(double fragment_KE_lab, int fragment_pdg,
+        const Workspace& ws) const;
   };
 
 }
@@ -15,11 +15,15 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 #pragma once
+#include <cstddef>
+
 #include "marley/Parity.hh"
 
 namespace marley {
 
   /// @brief Abstract base class for models of nuclear level densities
+  /// @details LevelDensityModel objects are immutable after construction, so
+  /// a single instance may be used concurrently by multiple threads
   class LevelDensityModel {
 
     public:
@@ -30,13 +34,13 @@ namespace marley {
       /// parities.
       /// @param Ex Excitation energy in MeV
       /// @return %Level density in MeV<sup> -1</sup>
-      virtual double level_density(double Ex) = 0;
+      virtual double level_density(double Ex) const = 0;
 
       /// %Level density @f$ \rho(E_x, J) @f$ for a specific nuclear spin.
       /// @param Ex Excitation energy in MeV
       /// @param two_J Two times the nuclear spin
       /// @return %Level density in MeV<sup> -1</sup>
-      virtual double level_density(double Ex, int two_J) = 0;
+      virtual double level_density(double Ex, int two_J) const = 0;
 
       /// %Level density @f$ \rho(E_x, J, \Pi) @f$ for a specific nuclear spin
       /// and parity.
@@ -44,6 +48,31 @@ namespace marley {
       /// @param two_J Two times the nuclear spin
       /// @param Pi The nuclear parity
       /// @return %Level density in MeV<sup> -1</sup>
-      virtual double level_density(double Ex, int two_J, marley::Parity Pi) = 0;
+      virtual double level_density(double Ex, int two_J, marley::Parity Pi)
+        const = 0;
+
+      /// %Level densities @f$ \rho(E_x, J, \Pi) @f$ for a range of nuclear
+      /// spins at a single excitation energy
+      /// @details The default implementation calls level_density(double, int,
+      /// marley::Parity) for each spin. Derived classes may override it to
+      /// share the work that does not depend on the spin.
+      /// @param Ex Excitation energy in MeV
+      /// @param two_J_min Two times the lowest nuclear spin
+      /// @param num_spins Number of spins. Two times the k-th spin is
+      /// two_J_min + 2k.
+      /// @param Pi The nuclear parity
+      /// @param[out] rhos Array of num_spins elements that will be loaded
+      /// with the level densities (MeV<sup> -1</sup>)
+      virtual void level_densities(double Ex, int two_J_min, size_t num_spins,
+        marley::Parity Pi, double* rhos) const;
   };
+
+  inline void LevelDensityModel::level_densities(double Ex, int two_J_min,
+    size_t num_spins, marley::Parity Pi, double* rhos) const
+  {
+    for ( size_t k = 0u; k < num_spins; ++k ) {
+      rhos[ k ] = this->level_density( Ex, two_J_min + 2*static_cast<int>(k),
+        Pi );
+    }
+  }
 }
@@ -16,8 +16,10 @@
 
 #pragma once
 #include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <vector>
 
@@ -141,23 +143,33 @@ namespace marley {
       /// @brief Temporary object used for forming logger messages
       /// @details Upon destruction, a newline is appended to the message. This
       /// is based on a trick from https://stackoverflow.com/a/57553824
+      ///
+      /// The Message holds the Logger's lock until it is destroyed, so
+      /// messages logged by different threads are never interleaved. A
+      /// Message created without the lock (because no stream would receive
+      /// it) ignores its contents.
       class Message {
         public:
-          Message(OutStreamVector& vec) : osvec_( vec ) {}
+          Message(OutStreamVector& vec,
+            std::unique_lock<std::recursive_mutex>&& lock)
+            : osvec_( vec ), lock_( std::move(lock) ) {}
+
+          Message(Message&&) = default;
 
           inline ~Message() {
-            osvec_ << '\n';
+            if ( lock_.owns_lock() ) osvec_ << '\n';
           }
 
           template<typename OutputType> Message&&
             operator<<(const OutputType& ot)
           {
-            osvec_ << ot;
+            if ( lock_.owns_lock() ) osvec_ << ot;
             return std::move( *this );
           }
 
         protected:
           OutStreamVector& osvec_;
+          std::unique_lock<std::recursive_mutex> lock_;
       };
 
       /// @brief Create the singleton Logger
@@ -200,6 +212,14 @@ namespace marley {
       /// @brief Disable the Logger
       inline void disable();
 
+      /// @brief Returns true if the Logger is enabled, or false otherwise
+      inline bool is_enabled() const;
+
+      /// @brief Returns true if a message at the given logging level could
+      /// be written to at least one stream
+      /// @details This check is cheap and does not lock the Logger
+      inline bool is_enabled(LogLevel lev) const;
+
       /// @brief Flush all output streams associated with the Logger
       void flush();
 
@@ -213,6 +233,7 @@ namespace marley {
 
       /// @brief Prepare the Logger to receive a log message via
       /// the << stream operator
+      /// @details This function may be called by several threads at once
       /// @param lev marley::Logger::LogLevel of the incoming message
       Message log(LogLevel lev = LogLevel::WARNING);
 
@@ -249,12 +270,23 @@ namespace marley {
       // it has been added to the Logger, or nullptr otherwise.
       OutStream* get_stream(const std::ostream* os);
 
+      /// @brief Recomputes max_level_ after the streams have changed
+      void update_max_level();
+
       /// @brief Vector of wrapped std::ostream objects that will
       /// receive the log messages
       OutStreamVector streams_;
 
       /// @brief Whether the Logger is currently enabled
-      bool enabled_;
+      std::atomic<bool> enabled_;
+
+      /// @brief Highest logging level used by any of the streams
+      std::atomic<LogLevel> max_level_{ LogLevel::DISABLED };
+
+      /// @brief Lock that serializes access to the streams
+      /// @details A recursive mutex is used so that values streamed to a
+      /// Message may themselves be computed by code that logs
+      mutable std::recursive_mutex mutex_;
 
       /// @brief LogLevel of the last log message
       LogLevel old_level_;
@@ -265,6 +297,11 @@ namespace marley {
 // Inline function definitions
 inline void marley::Logger::disable() { enable(false); }
 
+inline bool marley::Logger::is_enabled() const { return enabled_; }
+
+inline bool marley::Logger::is_enabled(LogLevel lev) const
+  { return enabled_ && lev <= max_level_; }
+
 template<typename OutputType> marley::Logger::OutStreamVector&
   marley::Logger::OutStreamVector::operator<<(const OutputType& ot)
 {
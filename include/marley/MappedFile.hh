@@ -0,0 +1,56 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace marley {
+
+  /// @brief Read-only memory mapping of an entire file
+  /// @details Large input files (e.g., tabulated neutrino fluxes) can be
+  /// parsed in place through data() without first being copied into a
+  /// separate buffer. The mapping is released when the object is destroyed.
+  class MappedFile {
+
+    public:
+
+      /// @param file_name Name of the file to map
+      explicit MappedFile(const std::string& file_name);
+
+      ~MappedFile();
+
+      MappedFile(const MappedFile&) = delete;
+      MappedFile& operator=(const MappedFile&) = delete;
+
+      /// @brief Get a pointer to the first byte of the file contents
+      /// @details Returns nullptr for an empty file
+      inline const char* data() const { return data_; }
+
+      /// @brief Get the size of the file in bytes
+      inline size_t size() const { return size_; }
+
+      /// @brief Get the name of the mapped file
+      inline const std::string& file_name() const { return file_name_; }
+
+    private:
+
+      std::string file_name_;
+      const char* data_ = nullptr;
+      size_t size_ = 0u;
+  };
+
+}
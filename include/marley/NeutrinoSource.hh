@@ -16,7 +16,11 @@
 
 #pragma once
 #include <functional>
+#include <memory>
 #include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "marley/marley_utils.hh"
 #include "marley/InterpolationGrid.hh"
@@ -56,6 +60,10 @@ namespace marley {
       /// source
       inline virtual int get_pid() const;
 
+      /// @brief Get the PDG particle IDs for all neutrino types produced by
+      /// this source
+      inline virtual std::vector<int> get_pids() const;
+
       /// @brief Probability density function describing the incident neutrino
       /// energy distribution
       /// @details The neutrino spectrum produced by this source will be folded
@@ -65,6 +73,14 @@ namespace marley {
       /// @return Probability density (MeV<sup> -1</sup>)
       virtual double pdf(double E) const = 0;
 
+      /// @brief Contribution of a single neutrino type to pdf()
+      /// @details Summing the return value over all neutrino types given by
+      /// get_pids() yields pdf(E)
+      /// @param pdg PDG code of the neutrino type
+      /// @param E neutrino energy (MeV)
+      /// @return Probability density (MeV<sup> -1</sup>)
+      virtual double flavor_pdf(int pdg, double E) const;
+
       /// Returns true if the Particle Data Group code passed to the function
       /// is allowed to be used by a neutrino source object, and returns false
       /// otherwise.
@@ -83,6 +99,20 @@ namespace marley {
       virtual double sample_incident_neutrino(int& pdg,
         marley::Generator& gen) const;
 
+      /// @brief Integrates the product of pdf() and a weight function over
+      /// the full range of neutrino energies produced by this source
+      /// @details The default implementation uses
+      /// marley_utils::num_integrate(). Sources that store a tabulated
+      /// spectrum may override this function to integrate bin by bin.
+      /// @param weight Function of the neutrino energy (MeV) to fold with
+      /// the spectrum
+      virtual double integrate(const std::function<double(double)>& weight)
+        const;
+
+      /// @brief Returns true if integrate() works directly from tabulated
+      /// moments of the spectrum rather than by numerical quadrature
+      inline virtual bool has_integral_table() const;
+
     protected:
 
       int pid_; ///< PDG particle ID for the neutrinos produced by this source
@@ -259,6 +289,11 @@ namespace marley {
       inline GridNeutrinoSource(const Grid& g, int particle_id
         = marley_utils::ELECTRON_NEUTRINO);
 
+      /// @brief Version of the constructor above that takes ownership of
+      /// the grid instead of copying it
+      inline GridNeutrinoSource(Grid&& g, int particle_id
+        = marley_utils::ELECTRON_NEUTRINO);
+
       /// @param Es vector of neutrino energy gridpoints (MeV)
       /// @param PDs vector of probability densities (MeV<sup> -1</sup>)
       /// @param particle_id PDG particle ID for the neutrinos produced by this
@@ -285,10 +320,180 @@ namespace marley {
       void check_for_errors();
   };
 
+  /// @brief Neutrino source whose spectrum is read from a (possibly very
+  /// large) tabulated flux file
+  /// @details The file is memory-mapped and parsed in place. It may either
+  /// be a text file with whitespace- or comma-separated columns or a binary
+  /// file containing consecutive (energy, flux) pairs of native-endian
+  /// doubles. The energies must be strictly increasing. The flux values
+  /// need not be normalized. While the file is read, the cumulative
+  /// integrals of the flux and of the energy-weighted flux are tabulated.
+  /// These tables allow incident neutrino energies to be sampled by
+  /// inversion and allow integrate() to fold the spectrum with a smooth
+  /// weight (e.g., a total cross section) exactly bin by bin. The cost of
+  /// both operations is thus independent of how finely the flux is binned.
+  class FluxFileNeutrinoSource : public GridNeutrinoSource {
+    public:
+
+      /// @brief Layout of the data in a flux file
+      enum class Format { Text, Binary };
+
+      /// @param file_name Name of the flux file
+      /// @param particle_id PDG particle ID for the neutrinos produced by this
+      /// source
+      /// @param format Layout of the data in the file
+      /// @param method Interpolation rule to use between grid points. Only
+      /// InterpolationMethod::LinearLinear and InterpolationMethod::Constant
+      /// are supported.
+      /// @param energy_column Zero-based index of the column (text files
+      /// only) that contains the neutrino energies (MeV)
+      /// @param flux_column Zero-based index of the column (text files
+      /// only) that contains the flux values
+      FluxFileNeutrinoSource(const std::string& file_name, int particle_id
+        = marley_utils::ELECTRON_NEUTRINO, Format format = Format::Text,
+        Method method = Method::LinearLinear, size_t energy_column = 0u,
+        size_t flux_column = 1u);
+
+      virtual double sample_incident_neutrino(int& pdg,
+        marley::Generator& gen) const override;
+
+      /// @details The weight function is evaluated at no more than
+      /// MAX_INTEGRATION_NODES energies and linearly interpolated between
+      /// them. For tables with fewer grid points than that, the nodes
+      /// include every grid point, and each bin is subdivided evenly so
+      /// that coarse tables are still integrated accurately. Each interval
+      /// between the nodes is then folded with the tabulated flux exactly
+      /// using its zeroth and first moments.
+      virtual double integrate(const std::function<double(double)>& weight)
+        const override;
+
+      inline virtual bool has_integral_table() const override;
+
+      /// @brief Get the integral of the flux values stored in the file
+      /// (before they were normalized to produce pdf())
+      inline double total_flux() const;
+
+      /// @brief Get the number of grid points read from the file
+      inline size_t num_points() const;
+
+      /// @brief Maximum number of energies at which integrate() evaluates
+      /// its weight function
+      static constexpr size_t MAX_INTEGRATION_NODES = 1024u;
+
+    protected:
+
+      /// @brief Grid points read from a flux file, together with the
+      /// cumulative tables computed from them
+      struct FluxTable {
+        std::vector<double> Es; ///< Grid point energies (MeV)
+        std::vector<double> PDs; ///< Normalized probability densities
+        std::vector<double> cdf; ///< Values for cdf_
+        std::vector<double> first_moment; ///< Values for first_moment_
+        double total_flux; ///< Integral of the unnormalized flux
+      };
+
+      /// @brief Takes ownership of the contents of a flux file that has
+      /// already been read
+      FluxFileNeutrinoSource(FluxTable&& table, int particle_id,
+        Method method);
+
+      /// @brief Reads a flux file, verifies that its contents are valid,
+      /// and tabulates the cumulative integrals of the normalized flux
+      /// @details The tables are filled as the memory-mapped file is parsed,
+      /// so the grid points are copied only once more (into grid_)
+      static FluxTable read_flux_file(const std::string& file_name,
+        Format format, Method method, size_t energy_column,
+        size_t flux_column);
+
+      /// @brief Computes the zeroth and first moments of the normalized flux
+      /// over the interval [a, b]
+      /// @param[out] m0 Integral of pdf(E) over the interval
+      /// @param[out] m1 Integral of (E - a) * pdf(E) over the interval
+      void moments(double a, double b, double& m0, double& m1) const;
+
+      /// @brief Computes the moments over part of a single grid bin
+      /// @details The flux values PDs are given at the energies Es, and
+      /// the remaining arguments are as for moments(). The interval [a, b]
+      /// must lie within the bin that begins at grid point j.
+      static void bin_moments(const std::vector<double>& Es,
+        const std::vector<double>& PDs, Method method, size_t j, double a,
+        double b, double& m0, double& m1);
+
+      std::vector<double> Es_; ///< Grid point energies (MeV)
+      std::vector<double> PDs_; ///< Normalized probability densities
+
+      /// @brief Cumulative integral of pdf(E) up to each grid point
+      std::vector<double> cdf_;
+
+      /// @brief Cumulative integral of (E - Emin) * pdf(E) up to each grid
+      /// point
+      std::vector<double> first_moment_;
+
+      double total_flux_; ///< Integral of the unnormalized flux
+  };
+
+  /// @brief Neutrino source that combines the spectra of several other
+  /// sources, which may produce different neutrino types
+  /// @details Each component spectrum is normalized to unity and weighted by
+  /// the component's share of the total neutrino flux. Sampling reacting
+  /// neutrinos from this source thus selects the neutrino type and energy
+  /// jointly according to the flavor-specific cross sections.
+  class CompositeNeutrinoSource : public NeutrinoSource {
+    public:
+      /// @param components Sources whose spectra should be combined
+      /// @param weights Relative neutrino flux for each component. The
+      /// weights are automatically normalized to sum to unity.
+      CompositeNeutrinoSource(
+        std::vector< std::unique_ptr<NeutrinoSource> >&& components,
+        const std::vector<double>& weights);
+
+      inline virtual double get_Emax() const override;
+
+      inline virtual double get_Emin() const override;
+
+      inline virtual std::vector<int> get_pids() const override;
+
+      virtual double pdf(double E) const override;
+
+      virtual double flavor_pdf(int pdg, double E) const override;
+
+      virtual double sample_incident_neutrino(int& pdg,
+        marley::Generator& gen) const override;
+
+      /// @brief Get the fraction of the total flux due to neutrinos with
+      /// the given PDG code
+      double flux_fraction(int pdg) const;
+
+    protected:
+
+      /// @brief Probability density of a single component, weighted
+      /// by its share of the total flux
+      double component_pdf(size_t c, double E) const;
+
+      /// @brief Sources whose spectra are combined by this object
+      std::vector< std::unique_ptr<NeutrinoSource> > components_;
+
+      /// @brief Fraction of the total flux due to each component
+      std::vector<double> fractions_;
+
+      /// @brief Factors that convert each component pdf() into a
+      /// contribution to the normalized composite spectrum
+      std::vector<double> scales_;
+
+      /// @brief PDG codes of the neutrinos produced by the components,
+      /// without duplicates
+      std::vector<int> flavors_;
+
+      double Emin_; ///< minimum neutrino energy (MeV)
+      double Emax_; ///< maximum neutrino energy (MeV)
+  };
+
   // Inline function definitions
   inline int NeutrinoSource::get_pid() const { return pid_; }
+  inline std::vector<int> NeutrinoSource::get_pids() const { return { pid_ }; }
   inline bool NeutrinoSource::pdg_is_allowed(const int pdg)
     { return (pids_.count(pdg) > 0); }
+  inline bool NeutrinoSource::has_integral_table() const { return false; }
 
   inline MonoNeutrinoSource::MonoNeutrinoSource(int particle_id, double E)
     : NeutrinoSource(particle_id), energy_(E) {}
@@ -313,6 +518,11 @@ namespace marley {
   inline double DecayAtRestNeutrinoSource::get_Emax() const { return Emax_; }
   inline double DecayAtRestNeutrinoSource::get_Emin() const { return Emin_; }
 
+  inline double CompositeNeutrinoSource::get_Emax() const { return Emax_; }
+  inline double CompositeNeutrinoSource::get_Emin() const { return Emin_; }
+  inline std::vector<int> CompositeNeutrinoSource::get_pids() const
+    { return flavors_; }
+
   inline double GridNeutrinoSource::get_Emax() const
     { return grid_.back().first; }
   inline double GridNeutrinoSource::get_Emin() const
@@ -323,8 +533,18 @@ namespace marley {
   inline GridNeutrinoSource::GridNeutrinoSource(const Grid& g, int particle_id)
     : NeutrinoSource(particle_id), grid_(g) { check_for_errors(); }
 
+  inline GridNeutrinoSource::GridNeutrinoSource(Grid&& g, int particle_id)
+    : NeutrinoSource(particle_id), grid_(std::move(g)) { check_for_errors(); }
+
   inline GridNeutrinoSource::GridNeutrinoSource(const std::vector<double>& Es,
     const std::vector<double>& prob_densities, int particle_id, Method method)
     : NeutrinoSource(particle_id), grid_(Es, prob_densities, method)
     { check_for_errors(); }
+
+  inline bool FluxFileNeutrinoSource::has_integral_table() const
+    { return true; }
+  inline double FluxFileNeutrinoSource::total_flux() const
+    { return total_flux_; }
+  inline size_t FluxFileNeutrinoSource::num_points() const
+    { return Es_.size(); }
 }
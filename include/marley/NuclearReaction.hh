@@ -137,6 +137,14 @@ namespace marley {
       /// (dimensionless)
       double coulomb_correction_factor(double beta_rel_cd) const;
 
+      /// Computes a Coulomb correction factor using a given method instead
+      /// of the one configured for this reaction
+      /// @param beta_rel_cd The relative speed of the final particles c and d
+      /// (dimensionless)
+      /// @param mode The method to use
+      double coulomb_correction_factor(double beta_rel_cd, CoulombMode mode)
+        const;
+
       /// Computes a Coulomb correction factor according to the effective
       /// momentum approximation. See J. Engel, Phys. Rev. C 57, 2004 (1998)
       /// @param beta_rel_cd The relative speed of the final particles c and d
@@ -214,6 +222,28 @@ namespace marley {
       double summed_xs_helper(int pdg_a, double KEa, double cos_theta_c_cm,
         std::vector<double>* level_xsecs, bool differential) const;
 
+      /// @brief Computes the level-independent CM frame kinematic quantities
+      /// needed by level_xs()
+      /// @param KEa Lab-frame projectile kinetic energy (MeV)
+      /// @param[out] s Mandelstam s (MeV<sup>2</sup>)
+      /// @param[out] sqrt_s Total CM frame energy (MeV)
+      /// @param[out] Eb_cm CM frame total energy of the target (MeV)
+      void cm_kinematics(double KEa, double& s, double& sqrt_s,
+        double& Eb_cm) const;
+
+      /// @brief Total cross section (MeV<sup> -2</sup>) for a given final
+      /// nuclear level, assumed to be kinematically accessible
+      /// @details This is the workhorse behind the public total_xs() and
+      /// summed_xs_helper(). Sharing the output of cm_kinematics() lets the
+      /// latter avoid recomputing it for every level in the sum.
+      /// @param me MatrixElement object describing the transition
+      /// @param s Mandelstam s (MeV<sup>2</sup>)
+      /// @param sqrt_s Total CM frame energy (MeV)
+      /// @param Eb_cm CM frame total energy of the target (MeV)
+      /// @param[out] beta_c_cm CM frame speed of the ejectile
+      double level_xs(const marley::MatrixElement& me, double s,
+        double sqrt_s, double Eb_cm, double& beta_c_cm) const;
+
       /// @brief Creates the description string based on the
       /// PDG code values for the initial and final particles
       void set_description();
@@ -238,6 +268,18 @@ namespace marley {
       /// for this reaction
       CoulombMode coulomb_mode_ = CoulombMode::FERMI_AND_MEMA;
 
+      /// @brief Approximate radius of the residue (MeV<sup> -1</sup>) used
+      /// when computing Coulomb corrections
+      double R_nuc_;
+
+      /// @brief The parameter @f$ s = \sqrt{1 - (\alpha Z_f)^2} @f$ that
+      /// appears in the Fermi function
+      double fermi_s_;
+
+      /// @brief Squared value of @f$ \Gamma(1 + 2s) @f$, which appears in the
+      /// denominator of the Fermi function
+      double fermi_b2_;
+
       /// @brief Matrix elements representing all of the possible nuclear
       /// transitions that may be caused by this reaction
       std::shared_ptr< std::vector<marley::MatrixElement> > matrix_elements_;
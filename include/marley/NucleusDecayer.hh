@@ -14,22 +14,70 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+// Standard library includes
+#include <map>
+#include <memory>
+#include <tuple>
+
 // MARLEY includes
 #include "marley/EventProcessor.hh"
+#include "marley/HauserFeshbachDecay.hh"
+#include "marley/Parity.hh"
 
 namespace marley {
 
+  // Forward-declare the Particle and StructureDatabase classes
+  class Particle;
+  class StructureDatabase;
+
   /// @brief EventProcessor that handles nuclear de-excitations
   class NucleusDecayer : public EventProcessor {
 
     public:
 
-      inline NucleusDecayer() {}
+      /// @param cache_first_step Whether to keep the HauserFeshbachDecay
+      /// objects built for the first step of continuum cascades so that
+      /// they can be reused by later events
+      /// @details The cache is only consulted for a nucleus at rest. It
+      /// only helps when many events begin from exactly the same initial
+      /// state, as in decay-only jobs with fixed excitation energies.
+      inline NucleusDecayer( bool cache_first_step = false )
+        : cache_first_step_( cache_first_step ) {}
 
       inline virtual ~NucleusDecayer() = default;
 
       virtual void process_event( marley::Event& event,
         marley::Generator& gen ) override;
+
+      /// @brief Get the number of HauserFeshbachDecay objects currently
+      /// held in the first-step cache
+      inline size_t cached_decay_count() const { return hf_cache_.size(); }
+
+    private:
+
+      /// @brief Retrieves (building it if necessary) the cached
+      /// HauserFeshbachDecay object for a compound nucleus at rest
+      /// @return A pointer to the cached object, or nullptr if the cache is
+      /// full and no matching entry was found
+      marley::HauserFeshbachDecay* cached_decay(
+        const marley::Particle& compound_nucleus, double Ex, int twoJ,
+        marley::Parity P, marley::StructureDatabase& sdb );
+
+      /// @brief Maximum number of entries to store in the first-step cache
+      static constexpr size_t MAX_CACHED_DECAYS_ = 1024;
+
+      /// @brief Whether the first-step cache is enabled
+      bool cache_first_step_;
+
+      /// @brief Key type for the first-step cache. Holds the nuclear PDG
+      /// code, net charge, excitation energy (MeV), two times the spin, and
+      /// parity of the compound nucleus.
+      using CacheKey = std::tuple<int, int, double, int, bool>;
+
+      /// @brief HauserFeshbachDecay objects for previously-seen initial
+      /// compound nucleus states
+      std::map< CacheKey, std::unique_ptr<marley::HauserFeshbachDecay> >
+        hf_cache_;
   };
 
 }
@@ -16,14 +16,47 @@
 
 #pragma once
 #include <complex>
+#include <cstddef>
 
 namespace marley {
 
   /// @brief Abstract base class for nuclear optical model implementations
+  /// @details OpticalModel objects are immutable after construction. All
+  /// quantities that depend on the fragment energy and angular momenta are
+  /// kept in a Workspace supplied by the caller, so a single model may be
+  /// shared by several threads as long as each uses its own Workspace.
   class OpticalModel {
 
     public:
 
+      /// @brief Scratch storage for optical model evaluations
+      /// @details A Workspace holds the kinematic variables and the
+      /// energy-dependent parameters of a spherical optical model potential
+      /// for the evaluation in progress. Its contents are overwritten by each
+      /// call that receives it. Reusing one Workspace for many evaluations
+      /// avoids reinitializing it each time.
+      struct Workspace {
+        /// Total CM frame kinetic energy of both particles (MeV)
+        double total_KE_CM = 0.;
+        /// Mass of the fragment (MeV)
+        double fragment_mass = 0.;
+        /// Fragment kinetic energy in the rest frame of the target (MeV)
+        double fragment_KE_lab = 0.;
+        /// Squared 3-momentum of either particle in the CM frame (MeV<sup>2</sup>)
+        double CM_momentum_squared = 0.;
+        /// Mass of the target atom, adjusted for its charge state (MeV)
+        double target_mass = 0.;
+        /// Fragment atomic number
+        int z = 0;
+
+        // Geometrical parameters (fm)
+        double Rv = 0., av = 0., Rd = 0., ad = 0., Rso = 0., aso = 0.;
+        // Energy-dependent terms in the potential (MeV)
+        double Vv = 0., Wv = 0., Wd = 0., Vso = 0., Wso = 0.;
+        /// Eigenvalue of the spin-orbit operator
+        double spin_orbit_eigenvalue = 0.;
+      };
+
       /// @param Z Atomic number of the desired nuclide
       /// @param A Mass number of the desired nuclide
       OpticalModel(int Z, int A) : Z_(Z), A_(A) {}
@@ -39,10 +72,17 @@ namespace marley {
       /// @param l Orbital angular momentum of the fragment
       /// @param two_s Two times the spin of the fragment
       /// @param target_charge Net charge of the target atom
+      /// @param ws Workspace to use for the calculation
       /// @returns Complex-valued optical model potential (MeV)
       virtual std::complex<double> optical_model_potential(double r,
         double fragment_KE_lab, int fragment_pdg, int two_j, int l, int two_s,
-        int target_charge = 0) = 0;
+        int target_charge, Workspace& ws) const = 0;
+
+      /// @brief Calculate the optical model potential using a temporary
+      /// Workspace
+      inline std::complex<double> optical_model_potential(double r,
+        double fragment_KE_lab, int fragment_pdg, int two_j, int l, int two_s,
+        int target_charge = 0) const;
 
       /// @brief Calculate the transmission coefficient for a nuclear fragment
       /// @param total_KE_CM Total CM frame kinetic energy (MeV)
@@ -51,8 +91,36 @@ namespace marley {
       /// @param l Orbital angular momentum of the fragment
       /// @param two_s Two times the spin of the fragment
       /// @param target_charge Net charge of the target atom
-      virtual double transmission_coefficient(double total_KE_CM, int fragment_pdg,
-        int two_j, int l, int two_s, int target_charge = 0) = 0;
+      /// @param ws Workspace to use for the calculation
+      virtual double transmission_coefficient(double total_KE_CM,
+        int fragment_pdg, int two_j, int l, int two_s, int target_charge,
+        Workspace& ws) const = 0;
+
+      /// @brief Calculate a transmission coefficient using a temporary
+      /// Workspace
+      inline double transmission_coefficient(double total_KE_CM,
+        int fragment_pdg, int two_j, int l, int two_s, int target_charge = 0)
+        const;
+
+      /// @brief Calculate transmission coefficients for several partial
+      /// waves at a single energy
+      /// @details The default implementation calls transmission_coefficient()
+      /// for each partial wave. Derived classes may override it to share the
+      /// work that does not depend on the angular momenta.
+      /// @param total_KE_CM Total CM frame kinetic energy (MeV)
+      /// @param fragment_pdg PDG code of the fragment
+      /// @param two_s Two times the spin of the fragment
+      /// @param two_js Array of num_waves values of two times the total
+      /// angular momentum of the fragment
+      /// @param ls Array of num_waves orbital angular momenta
+      /// @param num_waves Number of partial waves
+      /// @param target_charge Net charge of the target atom
+      /// @param[out] Ts Array of num_waves elements that will be loaded with
+      /// the transmission coefficients
+      /// @param ws Workspace to use for the calculation
+      virtual void transmission_coefficients(double total_KE_CM,
+        int fragment_pdg, int two_s, const int* two_js, const int* ls,
+        size_t num_waves, int target_charge, double* Ts, Workspace& ws) const;
 
       /// @brief Compute the energy-averaged total cross section
       /// (MeV<sup> -2</sup>) for a nuclear fragment projectile
@@ -75,9 +143,17 @@ namespace marley {
       /// @param target_charge Net charge of the target atom (used to adjust the
       /// atomic mass by the appropriate number of electron masses if the target
       /// is ionized)
+      /// @param ws Workspace to use for the calculation
       /// @returns Energy-averaged total scattering cross section (MeV<sup> -2</sup>)
       virtual double total_cross_section(double fragment_KE_lab,
-        int fragment_pdg, int two_s, size_t l_max, int target_charge = 0) = 0;
+        int fragment_pdg, int two_s, size_t l_max, int target_charge,
+        Workspace& ws) const = 0;
+
+      /// @brief Compute the energy-averaged total cross section using a
+      /// temporary Workspace
+      inline double total_cross_section(double fragment_KE_lab,
+        int fragment_pdg, int two_s, size_t l_max, int target_charge = 0)
+        const;
 
       /// @brief Get the atomic number
       inline int Z() const;
@@ -95,4 +171,29 @@ namespace marley {
   inline int OpticalModel::Z() const { return Z_; }
 
   inline int OpticalModel::A() const { return A_; }
+
+  inline std::complex<double> OpticalModel::optical_model_potential(double r,
+    double fragment_KE_lab, int fragment_pdg, int two_j, int l, int two_s,
+    int target_charge) const
+  {
+    Workspace ws;
+    return optical_model_potential( r, fragment_KE_lab, fragment_pdg, two_j,
+      l, two_s, target_charge, ws );
+  }
+
+  inline double OpticalModel::transmission_coefficient(double total_KE_CM,
+    int fragment_pdg, int two_j, int l, int two_s, int target_charge) const
+  {
+    Workspace ws;
+    return transmission_coefficient( total_KE_CM, fragment_pdg, two_j, l,
+      two_s, target_charge, ws );
+  }
+
+  inline double OpticalModel::total_cross_section(double fragment_KE_lab,
+    int fragment_pdg, int two_s, size_t l_max, int target_charge) const
+  {
+    Workspace ws;
+    return total_cross_section( fragment_KE_lab, fragment_pdg, two_s, l_max,
+      target_charge, ws );
+  }
 }
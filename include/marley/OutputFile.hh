@@ -18,8 +18,14 @@
 
 // standard library includes
 #include <fstream>
+#include <memory>
+#include <streambuf>
 #include <string>
 
+// MARLEY includes
+#include "marley/Compression.hh"
+#include "marley/EventProjection.hh"
+
 namespace marley {
 
   class Generator;
@@ -41,6 +47,13 @@ namespace marley {
 
       const std::string& name() const { return name_; }
 
+      /// @brief Returns true if the given file name selects the standard
+      /// output instead of a file on disk
+      /// @details The special name "stdout" is used for this purpose, as
+      /// for log files
+      static inline bool is_standard_output(const std::string& name)
+        { return name == "stdout"; }
+
       /// @brief Load a marley::Generator object whose configuration and state
       /// were saved to the metadata in a ROOT or JSON format output file.
       /// @param[out] num_previous_events The number of events previously
@@ -67,8 +80,32 @@ namespace marley {
 
       bool mode_is_resume() const { return mode_ == Mode::RESUME; }
 
-      /// @brief If needed (for the HEPEVT and ASCII formats), write the
-      /// flux-averaged total cross section to the file.
+      /// @brief Select the event and particle fields to write to this file
+      /// @details This function should be called before any events or
+      /// the flux-averaged total cross section are written. A marley::Error
+      /// will be thrown if the projection is not supported by the file
+      /// format. The HEPEVT format supports only the precision setting, and
+      /// the JSON format supports only the field selections. The ROOT format
+      /// does not support projections.
+      void set_projection(const marley::EventProjection& proj);
+
+      /// @brief Set the names of the systematic weights to write for each
+      /// event (see marley::SystematicUniverses)
+      /// @details Like set_projection(), this function should be called
+      /// before anything is written. The weights are stored in the ASCII,
+      /// HepMC3, and JSON formats. For the ROOT format, they are saved with
+      /// the rest of each marley::Event, and virtual files regenerate them,
+      /// so the names are ignored for those formats. The HEPEVT format has
+      /// no place for the weights, so a warning is logged if any are
+      /// requested for it.
+      void set_weight_names(const std::vector<std::string>& names);
+
+      /// @brief Get the projection used when writing events to this file
+      inline const marley::EventProjection& projection() const
+        { return projection_; }
+
+      /// @brief If needed (for the HEPEVT, HepMC3, and ASCII formats), write
+      /// the flux-averaged total cross section to the file.
       /// @details This function is a no-op unless we're
       /// at the beginning of the output stream.
       virtual void write_flux_avg_tot_xsec(double avg_tot_xsec) = 0;
@@ -77,8 +114,12 @@ namespace marley {
       // every event format that MARLEY knows how to write. The "ASCII" format
       // is MARLEY's native format for textual input and output of
       // marley::Event objects (via the << and >> operators on std::ostream and
-      // std::istream objects).
-      enum class Format { ROOT, HEPEVT, JSON, ASCII };
+      // std::istream objects). The "VIRTUAL" format stores only the
+      // information needed to regenerate the events (see
+      // marley::VirtualOutputFile). The "HEPMC3" format is the HepMC3 ASCII
+      // (Asciiv3) format, which is written without using the HepMC3
+      // library.
+      enum class Format { ROOT, HEPEVT, JSON, ASCII, VIRTUAL, HEPMC3 };
 
     protected:
 
@@ -126,6 +167,45 @@ namespace marley {
       // Whether to force the current output mode without prompting the user.
       // Currently only used when setting the OVERWRITE output mode.
       bool force_;
+
+      /// @brief Selection of the event fields to write to the file
+      marley::EventProjection projection_;
+  };
+
+  /// @brief Stream buffer that passes its output to another one while
+  /// counting the bytes written
+  /// @details This allows the size of output sent to the standard output
+  /// (which may be a pipe) to be reported
+  class CountingOutputBuffer : public std::streambuf {
+
+    public:
+
+      CountingOutputBuffer(std::streambuf* destination)
+        : destination_(destination) {}
+
+      /// @brief Get the number of bytes written so far
+      inline int_fast64_t count() const { return count_; }
+
+    protected:
+
+      int overflow(int ch) override {
+        if (ch == traits_type::eof()) return traits_type::not_eof(ch);
+        if (destination_->sputc(traits_type::to_char_type(ch))
+          == traits_type::eof()) return traits_type::eof();
+        ++count_;
+        return ch;
+      }
+
+      std::streamsize xsputn(const char* s, std::streamsize n) override {
+        std::streamsize written = destination_->sputn(s, n);
+        count_ += written;
+        return written;
+      }
+
+      int sync() override { return destination_->pubsync(); }
+
+      std::streambuf* destination_;
+      int_fast64_t count_ = 0;
   };
 
   class TextOutputFile : public OutputFile {
@@ -135,9 +215,45 @@ namespace marley {
       // current indent level. Writes the result to a std::ostream.
       void start_json_output(bool start_array);
 
+      // Recreates the compression buffer (if needed) for the current
+      // contents of stream_
+      void start_compression();
+
+      // Writes any pending compressed data, then closes stream_
+      void close_stream();
+
       // Stream used to read and write from the output file as needed
       std::fstream stream_;
 
+      /// @brief Settings used to compress the file contents
+      marley::CompressionSettings compression_;
+
+      /// @brief Buffer that forwards output to the standard output (null
+      /// unless the file name selects it)
+      std::unique_ptr<marley::CountingOutputBuffer> stdout_buf_;
+
+      /// @brief Stream that writes to stdout_buf_
+      std::unique_ptr<std::ostream> stdout_stream_;
+
+      // The compression buffer writes to base_out_ (either stream_ or
+      // stdout_stream_), so it must be declared after both of them. Data
+      // members are destroyed in reverse order.
+
+      /// @brief Buffer that compresses data before they are written to
+      /// base_out_ (null if compression is disabled)
+      std::unique_ptr<marley::GzipOutputBuffer> gzip_buf_;
+
+      /// @brief Stream that writes to gzip_buf_
+      std::unique_ptr<std::ostream> gzip_stream_;
+
+      /// @brief Stream that receives the (possibly compressed) file contents
+      /// (either stream_ or stdout_stream_)
+      std::ostream* base_out_ = &stream_;
+
+      /// @brief Stream that receives the file contents (either base_out_ or
+      /// gzip_stream_)
+      std::ostream* out_ = &stream_;
+
       // Flag used to see if we need a comma in front of the current
       // JSON event or not. Unused by the other formats.
       bool needs_comma_ = false;
@@ -150,16 +266,23 @@ namespace marley {
       int_fast64_t byte_count_ = 0;
 
       /// @brief Persistent storage for the flux-averaged total cross
-      /// section value (needed for the HEPEVT output format, which includes
-      /// it in every event)
+      /// section value (needed for the HEPEVT and HepMC3 output formats,
+      /// which include it in every event)
       double flux_avg_tot_xsec_ = 0.;
 
+      /// @brief Event number to use for the next HepMC3 event record
+      size_t hepmc3_event_number_ = 0u;
+
     public:
 
       TextOutputFile(const std::string& name, const std::string& format,
-        const std::string& mode, bool force = false, int indent = -1);
+        const std::string& mode, bool force = false, int indent = -1,
+        const marley::CompressionSettings& compression
+        = marley::CompressionSettings());
 
-      virtual ~TextOutputFile() = default;
+      /// @brief Writes any pending compressed data before the output
+      /// streams are destroyed
+      virtual ~TextOutputFile();
 
       inline void set_indent(int indent) { indent_ = indent; }
 
@@ -26,6 +26,7 @@ namespace marley {
   // rootcint so that we won't have issues using marley::Particle objects with
   // ROOT 5.
   class JSON;
+  class EventProjection;
   #endif
 
   /// @brief Momentum four-vector for a simulated particle
@@ -133,9 +134,37 @@ namespace marley {
       /// @brief Create a JSON representation of this Particle
       marley::JSON to_json() const;
 
+      /// @brief Create a JSON representation of this Particle that
+      /// includes only the fields selected by an EventProjection
+      marley::JSON to_json(const marley::EventProjection& proj) const;
+
+      /// @brief Print the fields of this particle selected by an
+      /// EventProjection to a std::ostream
+      /// @details If single precision is requested, floating-point values
+      /// are rounded to float before they are written. The caller is
+      /// responsible for the precision setting of the std::ostream.
+      void print(std::ostream& out, const marley::EventProjection& proj)
+        const;
+
+      /// @brief Read in a particle that was written using
+      /// print(std::ostream&, const marley::EventProjection&) const
+      /// @details Fields omitted by the projection are given default values
+      /// as described in the documentation for marley::EventProjection
+      void read(std::istream& in, const marley::EventProjection& proj);
+
       /// @brief Replaces the existing object contents with new ones
       /// loaded from a JSON representation of a Particle
+      /// @details All keys written by to_json() const are required
       void from_json(const marley::JSON& json);
+
+      /// @brief Replaces the existing object contents with new ones loaded
+      /// from a JSON representation created using
+      /// to_json(const marley::EventProjection&) const
+      /// @details Only the keys omitted by the projection may be missing.
+      /// They are given default values as described in the documentation for
+      /// marley::EventProjection.
+      void from_json(const marley::JSON& json,
+        const marley::EventProjection& proj);
       #endif
 
       /// @brief Resets all data members to zero
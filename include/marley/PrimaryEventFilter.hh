@@ -0,0 +1,98 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace marley {
+
+  class Event;
+  class JSON;
+
+  /// @brief Set of cuts applied to the primary (two-two scattering) part of
+  /// each event before the nuclear de-excitation is simulated
+  /// @details Each cut requires a kinematic variable of the primary event
+  /// to lie within a closed interval. The available variables are
+  ///   - "projectile_KE": Kinetic energy of the projectile (MeV)
+  ///   - "ejectile_KE": Kinetic energy of the ejectile (MeV)
+  ///   - "ejectile_cos_theta": Cosine of the angle between the ejectile and
+  ///     projectile 3-momenta
+  ///   - "Ex": Excitation energy of the residue (MeV)
+  ///
+  /// All of these are unaffected by the de-excitation cascade and by the
+  /// rotation applied to match the projectile direction.
+  class PrimaryEventFilter {
+
+    public:
+
+      /// @brief Create a filter that accepts every event
+      PrimaryEventFilter() {}
+
+      /// @brief Create a filter using the settings in a JSON object
+      /// @details Each key that names a variable should have a two-element
+      /// array [ min, max ] as its value. Either bound may be null, in
+      /// which case it is not applied. Other keys are ignored.
+      explicit PrimaryEventFilter(const marley::JSON& json);
+
+      /// @brief Returns true if the event passes all of the cuts
+      bool accepts(const marley::Event& ev) const;
+
+      /// @brief Returns true if this filter has no cuts (and thus accepts
+      /// every event)
+      inline bool empty() const { return cuts_.empty(); }
+
+      /// @brief Get a description of the cuts suitable for logging
+      std::string to_string() const;
+
+      /// @brief Computes the value of one of the variables listed above
+      /// for an event
+      /// @details A marley::Error is thrown if the variable name is not
+      /// recognized
+      static double evaluate(const std::string& variable,
+        const marley::Event& ev);
+
+      /// @brief Returns true if the name refers to one of the variables
+      /// listed above
+      static bool is_variable(const std::string& variable);
+
+    private:
+
+      /// @brief Kinematic variables that may be used in cuts
+      enum class Variable { ProjectileKE, EjectileKE, EjectileCosTheta, Ex };
+
+      struct Cut {
+        Variable variable;
+        std::string name;
+        bool has_min;
+        double min;
+        bool has_max;
+        double max;
+      };
+
+      /// @brief Names of the available variables
+      static const std::vector< std::pair<std::string, Variable> >&
+        variables();
+
+      /// @brief Computes the value of a variable for an event
+      static double evaluate(Variable var, const marley::Event& ev);
+
+      std::vector<Cut> cuts_;
+  };
+
+}
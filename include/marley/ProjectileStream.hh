@@ -0,0 +1,217 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+
+// standard library includes
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// MARLEY includes
+#include "marley/Event.hh"
+#include "marley/Generator.hh"
+
+namespace marley {
+
+  class JSONConfig;
+
+  /// @brief Creates events for a stream of projectile records supplied by
+  /// an external program
+  /// @details Each record gives the projectile PDG code, its kinetic energy
+  /// (MeV), the PDG code of the target atom, the projectile direction, and
+  /// (optionally) a time. The records are passed to
+  /// marley::Generator::create_event(int, double, int, const
+  /// std::array<double, 3>&). MARLEY events have no vertex time, so the
+  /// time is checked but otherwise ignored. Events are returned in the same
+  /// order as the records.
+  ///
+  /// In the text format, each line holds the values
+  ///
+  ///   pdg_a KEa pdg_atom dir_x dir_y dir_z [time]
+  ///
+  /// separated by whitespace. Blank lines and lines that begin with '#' are
+  /// skipped. In the binary format, each record occupies RECORD_BYTES bytes
+  /// in the native byte order: two int32 values (pdg_a, pdg_atom) followed
+  /// by five float64 values (KEa, dir_x, dir_y, dir_z, time).
+  ///
+  /// A reader thread parses the input while a pool of worker threads
+  /// creates the events. The records are divided into batches of a fixed
+  /// size, and each batch is handled by a single worker using its own
+  /// random number stream (see marley::Generator::start_event_stream()).
+  /// The events thus depend only on the configuration, the input records,
+  /// and the batch size, not on the number of threads. When no more input
+  /// is immediately available (e.g., while waiting on a pipe), the records
+  /// already read are passed along without waiting for the batch to fill.
+  class ProjectileStream {
+
+    public:
+
+      /// @brief Encoding used for the projectile records
+      enum class Format { TEXT, BINARY };
+
+      /// @brief Initial-state parameters for a single event
+      struct Record {
+        int pdg_a; ///< PDG code of the projectile
+        double KEa; ///< Kinetic energy of the projectile (MeV)
+        int pdg_atom; ///< PDG code of the target atom
+        std::array<double, 3> dir_vec; ///< Direction of the projectile
+        double time; ///< Time supplied with the record (or zero)
+      };
+
+      /// @brief Size of each record in the binary format
+      static constexpr size_t RECORD_BYTES = 2*sizeof(int32_t)
+        + 5*sizeof(double);
+
+      /// @brief Default number of records in each batch
+      static constexpr size_t DEFAULT_BATCH_SIZE = 256;
+
+      /// @param config Job configuration used to create a Generator for
+      /// each worker thread
+      /// @param in Stream from which the records will be read
+      /// @param format Encoding used for the records
+      /// @param num_threads Number of worker threads to use. A value of
+      /// zero selects the number of hardware threads.
+      /// @param batch_size Number of records in each batch
+      ProjectileStream( const marley::JSONConfig& config,
+        std::unique_ptr<std::istream> in, Format format, int num_threads = 0,
+        size_t batch_size = DEFAULT_BATCH_SIZE );
+
+      ~ProjectileStream();
+
+      ProjectileStream( const ProjectileStream& ) = delete;
+      ProjectileStream& operator=( const ProjectileStream& ) = delete;
+
+      /// @brief Opens a file (or FIFO) of projectile records for reading
+      /// @param name File name to use. The special name "stdin" selects the
+      /// standard input.
+      /// @param format Encoding used for the records
+      static std::unique_ptr<std::istream> open_input(
+        const std::string& name, Format format );
+
+      /// @brief Converts the name of a record format ("text" or "binary")
+      /// into a Format value
+      static Format parse_format( const std::string& name );
+
+      /// @brief Reads the next projectile record from a stream
+      /// @details A marley::Error is thrown if the record is malformed
+      /// @param in Stream from which the record will be read
+      /// @param format Encoding used for the record
+      /// @param[out] rec Record that will be loaded
+      /// @param[in,out] line_number Number of lines (text format) or
+      /// records (binary format) read so far. Used for error messages.
+      /// @return False if the end of the input was reached before a record
+      /// could be read, or true otherwise
+      static bool read_record( std::istream& in, Format format, Record& rec,
+        long& line_number );
+
+      /// @brief Get the event created for the next projectile record
+      /// @details Errors encountered while reading the input or creating
+      /// the events are rethrown here after all of the earlier events have
+      /// been returned
+      /// @return False if all records have been used, or true otherwise
+      bool next_event( marley::Event& ev );
+
+      /// @brief Get the number of events returned so far by next_event()
+      inline long num_events() const;
+
+      /// @brief Get the number of worker threads
+      inline int num_threads() const;
+
+      /// @brief Get the Generator used by the first worker thread
+      /// @details This is used when finalizing output files, which save
+      /// the generator configuration
+      inline const marley::Generator& generator() const;
+
+    private:
+
+      /// @brief Group of consecutive records handled by a single worker
+      /// @details A batch may be handed to its worker in several parts if
+      /// the input arrives slowly
+      struct Part {
+        long first_record; ///< Zero-based index of the first record
+        std::vector<Record> records;
+        std::vector<marley::Event> events;
+        std::exception_ptr error; ///< Failure that ended the part early
+      };
+
+      /// @brief Per-thread state used to create events
+      struct Worker {
+        std::unique_ptr<marley::Generator> gen;
+        std::thread thread;
+        std::deque<Part> input; ///< Parts waiting to be processed
+        std::deque<Part> output; ///< Finished parts
+      };
+
+      /// @brief State shared with the reader thread
+      /// @details The reader may remain blocked on its input after the
+      /// ProjectileStream is destroyed. It is detached in that case, and
+      /// this state is kept alive until it exits.
+      struct SharedState {
+        std::unique_ptr<std::istream> in;
+        Format format;
+        size_t batch_size;
+        std::vector< std::unique_ptr<Worker> > workers;
+        std::mutex mutex;
+        std::condition_variable cv;
+
+        /// @brief Indices of the workers that received each part, in the
+        /// order of the input records
+        std::deque<size_t> part_workers;
+
+        bool input_done = false;
+        std::exception_ptr input_error;
+        bool stop = false;
+      };
+
+      /// @brief Loop executed by the reader thread
+      static void read_input( std::shared_ptr<SharedState> state );
+
+      /// @brief Loop executed by each worker thread
+      void run_worker( Worker& worker );
+
+      /// @brief Maximum number of parts that have been read but not yet
+      /// returned by next_event() (per worker thread)
+      static constexpr size_t MAX_QUEUED_PARTS_ = 16;
+
+      std::shared_ptr<SharedState> state_;
+      std::thread reader_;
+
+      /// @brief Part whose events are currently being returned
+      Part current_;
+      size_t next_index_ = 0;
+
+      long event_count_ = 0;
+  };
+
+  // Inline function definitions
+  inline long ProjectileStream::num_events() const { return event_count_; }
+
+  inline int ProjectileStream::num_threads() const
+    { return static_cast<int>( state_->workers.size() ); }
+
+  inline const marley::Generator& ProjectileStream::generator() const
+    { return *state_->workers.front()->gen; }
+}
@@ -64,6 +64,12 @@ namespace marley {
 
       virtual bool deduce_file_format() override;
       virtual void initialize() override;
+
+      virtual std::unique_ptr<EventFileReader> open_shard(
+        const std::string& file_name) const override;
+
+      virtual std::unique_ptr<marley::Generator> create_generator(
+        const marley::JSON& config) const override;
   };
 
 }
@@ -25,8 +25,9 @@ namespace marley {
 
     public:
 
-      explicit RootJSONConfig(const marley::JSON& object)
-        : JSONConfig(object) {}
+      explicit RootJSONConfig(const marley::JSON& object,
+        bool configure_logger = true)
+        : JSONConfig(object, configure_logger) {}
 
       explicit RootJSONConfig(const std::string& json_filename)
         : JSONConfig(json_filename) {}
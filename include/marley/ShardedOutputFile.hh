@@ -0,0 +1,209 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+
+// standard library includes
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// MARLEY includes
+#include "marley/Event.hh"
+#include "marley/JSON.hh"
+#include "marley/OutputFile.hh"
+
+namespace marley {
+
+  /// @brief OutputFile that splits its events among several shard files
+  /// @details Events are distributed round-robin among a fixed number of
+  /// "lanes." Each lane writes to one shard file at a time using its own
+  /// writer thread (except for ROOT-format shards, which are written by the
+  /// calling thread). A lane rolls over to a new shard file whenever a limit
+  /// on the number of events or bytes per shard is reached. Every shard is a
+  /// complete, self-contained output file in the requested format.
+  ///
+  /// When the file is closed, a JSON manifest listing the shards, the
+  /// flux-averaged total cross section, and the final generator state is
+  /// written. Because of the round-robin assignment, the events in a shard
+  /// are not contiguous. Each shard entry in the manifest therefore gives
+  /// the zero-based index of its first event ("first_event") together with
+  /// the spacing between the indices of its consecutive events ("stride",
+  /// equal to the number of lanes). The manifest may be opened using
+  /// marley::EventFileReader to read all of the shards as a single logical
+  /// dataset in the original event order.
+  class ShardedOutputFile : public OutputFile {
+
+    public:
+
+      /// @brief Function used to create each shard file
+      /// @details The argument is the name of the new shard file
+      using ShardFactory = std::function< std::unique_ptr<marley::OutputFile>(
+        const std::string&) >;
+
+      /// @param name Base name of the output file. Shard file names are
+      /// obtained by inserting a four-digit shard index before the
+      /// extension (e.g., events.ascii becomes events_0000.ascii,
+      /// events_0001.ascii, ...). The manifest is written to a file whose
+      /// name is obtained by appending ".manifest" (e.g.,
+      /// events.ascii.manifest).
+      /// @param format Format to use for every shard file
+      /// @param mode Output mode. Only "overwrite" is supported.
+      /// @param force Whether existing files should be overwritten without
+      /// prompting the user
+      /// @param factory Function used to create each shard file
+      /// @param num_shards Number of shards written concurrently
+      /// @param max_events_per_shard Roll over to a new shard after this
+      /// many events have been written to the current one. Zero disables
+      /// the limit.
+      /// @param max_bytes_per_shard Roll over to a new shard once at least
+      /// this many bytes have been written to the current one. Zero disables
+      /// the limit.
+      ShardedOutputFile(const std::string& name, const std::string& format,
+        const std::string& mode, bool force, ShardFactory factory,
+        int num_shards, long max_events_per_shard = 0,
+        int_fast64_t max_bytes_per_shard = 0);
+
+      virtual ~ShardedOutputFile();
+
+      /// @brief Provide the generator and job configuration used to write
+      /// the metadata when a shard is closed during a rollover
+      /// @details This function must be called before the first event
+      /// is written.
+      void set_generator(const marley::JSON& json_config,
+        const marley::Generator& gen);
+
+      /// @brief Resuming a previous run is not supported for sharded output
+      virtual bool resume(std::unique_ptr<marley::Generator>& gen,
+        long& num_previous_events) override;
+
+      virtual void close(const marley::JSON& json_config,
+        const marley::Generator& gen, const long num_events) override;
+
+      /// @brief Total number of bytes written to all shards
+      virtual int_fast64_t bytes_written() override;
+
+      virtual void write_event(const marley::Event* event) override;
+
+      virtual void write_flux_avg_tot_xsec(double avg_tot_xsec) override;
+
+      /// @brief Name of the shard file with the given index
+      std::string shard_name(size_t index) const;
+
+      /// @brief Name of the manifest file
+      inline const std::string& manifest_name() const { return name_; }
+
+    protected:
+
+      /// @brief Bookkeeping for a shard file that has been opened
+      struct ShardInfo {
+        std::string file_name_;
+        long first_event_ = 0; ///< Index of the first event in the shard
+        long num_events_ = 0;
+        int_fast64_t num_bytes_ = 0;
+      };
+
+      /// @brief A sequence of shard files written by a single writer thread
+      struct Lane {
+        /// @brief Shard file currently receiving events
+        std::unique_ptr<marley::OutputFile> file_;
+        /// @brief Index of the current shard file
+        size_t shard_index_ = 0;
+        /// @brief Number of events sent to the current shard file
+        long num_events_ = 0;
+        /// @brief Bytes written to the current shard file so far
+        std::atomic<int_fast64_t> num_bytes_{0};
+
+        // Members below are shared with the writer thread
+        std::thread thread_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::deque<marley::Event> queue_;
+        bool busy_ = false;
+        bool stop_ = false;
+        std::exception_ptr error_;
+      };
+
+      /// @brief Writes the manifest file
+      virtual void write_generator_state(const marley::JSON& json_config,
+        const marley::Generator& gen, const long num_events) override;
+
+      /// @brief Starts the lanes (if needed)
+      virtual void open() override;
+
+      /// @brief Body of each writer thread
+      void write_events(Lane& lane);
+
+      /// @brief Blocks until the writer thread for a lane has written every
+      /// queued event
+      void drain(Lane& lane);
+
+      /// @brief Stops the writer thread for a lane
+      void stop(Lane& lane);
+
+      /// @brief Opens a new shard file for a lane
+      /// @param first_event Index of the first event that will be written
+      /// to the new shard
+      void open_shard(Lane& lane, long first_event);
+
+      /// @brief Closes the current shard file for a lane
+      void close_shard(Lane& lane, const marley::JSON& json_config,
+        const marley::Generator& gen);
+
+      /// @brief Rethrows any exception caught by a lane's writer thread
+      void check_for_errors(Lane& lane);
+
+      ShardFactory factory_;
+      long max_events_per_shard_;
+      int_fast64_t max_bytes_per_shard_;
+
+      /// @brief Whether writer threads are used (false for ROOT format)
+      bool threaded_;
+
+      std::vector< std::unique_ptr<Lane> > lanes_;
+      std::vector<ShardInfo> shards_;
+
+      /// @brief Index of the lane that will receive the next event
+      size_t next_lane_ = 0;
+
+      /// @brief Total number of events passed to write_event() so far
+      long num_events_written_ = 0;
+
+      /// @brief Bytes written to shard files that have already been closed
+      int_fast64_t closed_bytes_ = 0;
+
+      double flux_avg_tot_xsec_ = 0.;
+
+      /// @brief Stem and extension of the file name passed to the
+      /// constructor (used to build the shard file names)
+      std::string stem_;
+      std::string extension_;
+
+      const marley::Generator* gen_ = nullptr;
+      marley::JSON json_config_;
+
+      /// @brief Maximum number of events waiting in each lane's queue
+      static constexpr size_t MAX_QUEUED_EVENTS_ = 64;
+  };
+
+}
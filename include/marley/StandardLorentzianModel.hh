@@ -113,15 +113,15 @@ namespace marley {
       StandardLorentzianModel(int Z, int A);
 
       virtual double strength_function(TransitionType type, int l,
-        double e_gamma) override;
+        double e_gamma) const override;
 
       virtual double transmission_coefficient(TransitionType type, int l,
-        double e_gamma) override;
+        double e_gamma) const override;
 
     private:
 
       double strength_function_coefficient(TransitionType type,
-        int l, double e_gamma);
+        int l, double e_gamma) const;
 
       /// @todo Consider other more elegant ways of storing these parameters
       double e_E1_; ///< E1 giant resonance energy (MeV)
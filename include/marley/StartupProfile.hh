@@ -0,0 +1,123 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace marley {
+
+  class JSON;
+
+  /// @brief Optional breakdown of the work done while a job starts up
+  /// @details While the profile is enabled, StartupProfile::Phase objects
+  /// record the wall-clock time, CPU time, number of memory allocations,
+  /// and number of bytes read from files during the code regions that they
+  /// enclose. Phases may be nested. The results may be printed as a table
+  /// or exported as JSON to help decide which start-up work is worth
+  /// caching or parallelizing.
+  class StartupProfile {
+
+    public:
+
+      /// @brief Snapshot of the resource usage counters
+      struct Sample {
+        std::chrono::steady_clock::time_point wall; ///< Wall-clock time
+        double cpu; ///< Process CPU time (s)
+        long allocations; ///< Allocations made so far by this thread
+        long bytes_read; ///< Bytes read so far by this process
+      };
+
+      /// @brief Resources used by a single phase
+      struct Record {
+        std::string name; ///< Name of the phase
+        int depth; ///< Number of enclosing phases
+        double wall; ///< Elapsed wall-clock time (s)
+        double cpu; ///< Elapsed process CPU time (s)
+        long allocations; ///< Number of allocations (or -1 if unknown)
+        long bytes_read; ///< Number of bytes read (or -1 if unknown)
+      };
+
+      /// @brief Records a phase that lasts for the lifetime of this object
+      class Phase {
+
+        public:
+
+          /// @param name Name of the phase
+          explicit Phase( const std::string& name );
+
+          ~Phase();
+
+          Phase( const Phase& ) = delete;
+          Phase& operator=( const Phase& ) = delete;
+
+        private:
+
+          /// @brief Index of the record for this phase, or -1 if the
+          /// profile is disabled
+          long index_ = -1;
+          Sample start_;
+      };
+
+      /// @brief Function that returns the number of memory allocations made
+      /// so far by the calling thread
+      using AllocationCounter = long (*)();
+
+      /// @brief Starts recording phases
+      static void enable();
+
+      /// @brief Stops recording phases
+      /// @details Phases that were already recorded are kept
+      static void disable();
+
+      /// @brief Returns true if the profile is enabled
+      static bool enabled();
+
+      /// @brief Supplies a function used to count memory allocations
+      /// @details The MARLEY library does not replace the global operator
+      /// new, so programs that want allocation counts must provide their
+      /// own. Without a counter, allocation counts are reported as unknown.
+      static void set_allocation_counter( AllocationCounter counter );
+
+      /// @brief Takes a snapshot of the resource usage counters
+      /// @details This may be called before the profile is enabled, which
+      /// allows work done before that point to be recorded using record()
+      static Sample sample();
+
+      /// @brief Adds a phase that began and ended at the given snapshots
+      /// @details The phase is placed at the current nesting depth
+      static void record( const std::string& name, const Sample& start,
+        const Sample& stop );
+
+      /// @brief Returns the phases recorded so far in the order that they
+      /// started
+      static std::vector<Record> records();
+
+      /// @brief Prints the recorded phases as a table
+      static void print( std::ostream& out );
+
+      /// @brief Returns the recorded phases as a JSON array
+      static marley::JSON to_json();
+
+      /// @brief Writes the recorded phases to a JSON file
+      static void write( const std::string& file_name );
+  };
+
+}
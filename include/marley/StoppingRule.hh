@@ -0,0 +1,139 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <string>
+#include <vector>
+
+namespace marley {
+
+  class Event;
+  class JSON;
+
+  /// @brief Criteria for ending a run once the statistical uncertainties on
+  /// a set of event observables are small enough
+  /// @details Each target estimates one observable from the generated events
+  /// and requests a maximum relative statistical uncertainty for it. The
+  /// available observables are
+  ///   - "fraction": Fraction of events that contain at least one final
+  ///     particle with a given PDG code ("particle" key), or whose value of
+  ///     a variable lies within a closed interval ("variable" and "range"
+  ///     keys, e.g., for a histogram bin)
+  ///   - "mean": Mean value of a variable ("variable" key), or mean total
+  ///     kinetic energy (MeV) of the final particles with a given PDG code
+  ///     ("particle" key)
+  ///
+  /// The variables are those understood by
+  /// marley::PrimaryEventFilter::evaluate(). The estimates are updated
+  /// online via add_event(). Copies of a StoppingRule may be filled
+  /// independently (e.g., one per thread) and later combined using merge().
+  class StoppingRule {
+
+    public:
+
+      /// @brief Running mean and variance of a sequence of values
+      struct Accumulator {
+
+        /// @brief Adds a value to the sequence
+        void add(double x);
+
+        /// @brief Combines the statistics of two sequences
+        void merge(const Accumulator& other);
+
+        /// @brief Sample variance of the values
+        double variance() const;
+
+        /// @brief Statistical uncertainty on the mean
+        double std_error() const;
+
+        /// @brief Statistical uncertainty on the mean divided by its
+        /// magnitude (infinite if the mean vanishes)
+        double relative_error() const;
+
+        long count = 0;
+        double mean = 0.;
+        /// @brief Sum of squared deviations from the mean
+        double m2 = 0.;
+      };
+
+      /// @brief Create a StoppingRule that has no targets
+      StoppingRule() {}
+
+      /// @brief Create a StoppingRule using the settings in a JSON object
+      /// @details The "targets" key should contain an array of objects, each
+      /// of which describes an observable (see above) and gives the desired
+      /// relative uncertainty via the "precision" key. An optional "name"
+      /// key labels the target in log messages. The optional "max_time" key
+      /// sets a limit (s) on the wall-clock time, and "check_interval" sets
+      /// the number of events between checks of the targets.
+      explicit StoppingRule(const marley::JSON& json);
+
+      /// @brief Returns true if there are no precision targets
+      inline bool empty() const { return targets_.empty(); }
+
+      /// @brief Updates the estimates using a new event
+      void add_event(const marley::Event& ev);
+
+      /// @brief Adds the events seen by another copy of this StoppingRule
+      void merge(const StoppingRule& other);
+
+      /// @brief Returns true if every precision target has been met
+      bool targets_met() const;
+
+      /// @brief Number of events that have been added
+      long num_events() const;
+
+      /// @brief Maximum wall-clock time (s) for the run, or zero if there
+      /// is no limit
+      inline double max_time() const { return max_time_; }
+
+      /// @brief Number of events between checks of the targets
+      inline long check_interval() const { return check_interval_; }
+
+      /// @brief Get a description of the achieved precision suitable for
+      /// logging
+      std::string summary() const;
+
+      /// @brief Minimum number of events needed before the targets are
+      /// considered to be met
+      static constexpr long MIN_EVENTS = 100;
+
+    private:
+
+      enum class Kind { Fraction, Mean };
+
+      struct Target {
+        std::string name;
+        Kind kind;
+        std::string variable; ///< Empty when a PDG code is used instead
+        int pdg;
+        double min;
+        double max;
+        double precision;
+        Accumulator acc;
+      };
+
+      /// @brief Computes the value of a target's observable for an event
+      static double value(const Target& target, const marley::Event& ev);
+
+      std::vector<Target> targets_;
+
+      double max_time_ = 0.;
+      long check_interval_ = 1000;
+  };
+
+}
@@ -17,11 +17,14 @@
 #pragma once
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <unordered_map>
 
 #include "marley/DecayScheme.hh"
+#include "marley/Integrator.hh"
+#include "marley/TableBuilder.hh"
 
 namespace marley {
 
@@ -94,40 +97,55 @@ namespace marley {
 
       /// @brief Retrieves an optical model object from the database, creating
       /// it if one did not already exist
+      /// @details The model objects are immutable, and this function may be
+      /// called concurrently from multiple threads. The same is true of
+      /// get_level_density_model() and get_gamma_strength_function_model().
       /// @param particle_id PDG particle ID for the desired nuclide
-      marley::OpticalModel& get_optical_model(int nucleus_pid);
+      const marley::OpticalModel& get_optical_model(int nucleus_pid);
 
       /// @brief Retrieves an optical model object from the database, creating
       /// it if one did not already exist
       /// @param Z atomic number
       /// @param A mass number
-      marley::OpticalModel& get_optical_model(const int Z,
+      const marley::OpticalModel& get_optical_model(const int Z,
         const int A);
 
       /// @brief Retrieves a level density model object from the database,
       /// creating it if one did not already exist
       /// @param nucleus_pid PDG particle ID for the desired nucleus
-      marley::LevelDensityModel& get_level_density_model(const int nucleus_pid);
+      const marley::LevelDensityModel& get_level_density_model(
+        const int nucleus_pid);
 
       /// @brief Retrieves a level density model object from the database,
       /// creating it if one did not already exist
       /// @param Z atomic number
       /// @param A mass number
-      marley::LevelDensityModel& get_level_density_model(const int Z,
+      const marley::LevelDensityModel& get_level_density_model(const int Z,
         const int A);
 
+      /// @brief Adds a level density model to the database, to be used
+      /// instead of the default one for a specific nuclide
+      /// @details This function must be called before the level density model
+      /// for the nuclide is first retrieved. A marley::Error is thrown if
+      /// the database already contains one.
+      /// @param nucleus_pid PDG particle ID for the desired nucleus
+      /// @param ldm A unique_ptr to the LevelDensityModel object to move
+      /// into the database
+      void add_level_density_model(int nucleus_pid,
+        std::unique_ptr<marley::LevelDensityModel> ldm);
+
       /// @brief Retrieves a gamma-ray strength function model object from the
       /// database, creating it if one did not already exist
       /// @param Z atomic number
       /// @param A mass number
-      marley::GammaStrengthFunctionModel& get_gamma_strength_function_model(
-        const int Z, const int A);
+      const marley::GammaStrengthFunctionModel&
+        get_gamma_strength_function_model(const int Z, const int A);
 
       /// @brief Retrieves a gamma-ray strength function model object from the
       /// database, creating it if one did not already exist
       /// @param nuc_pdg PDG code for the nuclide of interest
-      marley::GammaStrengthFunctionModel& get_gamma_strength_function_model(
-        const int nuc_pdg);
+      const marley::GammaStrengthFunctionModel&
+        get_gamma_strength_function_model(const int nuc_pdg);
 
       /// Retrieves a const reference to the table of DecayScheme objects
       inline const std::unordered_map<int,
@@ -171,6 +189,70 @@ namespace marley {
       /// gamma-ray emission to the continuum
       inline void set_gamma_l_max( int ell ) { gamma_l_max_ = ell; }
 
+      /// @brief Returns the step size (fm) used to integrate the
+      /// Schr&ouml;dinger equation in the optical model
+      inline double get_numerov_step_size() const
+        { return numerov_step_size_; }
+
+      /// @brief Sets the step size (fm) used to integrate the
+      /// Schr&ouml;dinger equation in the optical model
+      /// @details Only optical models created after this function is called
+      /// are affected
+      void set_numerov_step_size( double step_size );
+
+      /// @brief Returns half the number of Clenshaw-Curtis sampling points
+      /// used to integrate differential decay widths over the continuum
+      inline int get_continuum_quadrature_order() const
+        { return continuum_quadrature_order_; }
+
+      /// @brief Sets half the number of Clenshaw-Curtis sampling points
+      /// used to integrate differential decay widths over the continuum
+      void set_continuum_quadrature_order( int order );
+
+      /// @brief Returns the Integrator used to compute total decay widths for
+      /// transitions to the continuum
+      inline const marley::Integrator& get_continuum_integrator() const
+        { return continuum_integrator_; }
+
+      /// @brief Returns the number of Chebyshev points used to approximate
+      /// the final excitation energy distribution for transitions to the
+      /// continuum
+      inline int get_continuum_chebyshev_points() const
+        { return continuum_chebyshev_points_; }
+
+      /// @brief Sets the number of Chebyshev points used to approximate
+      /// the final excitation energy distribution for transitions to the
+      /// continuum
+      void set_continuum_chebyshev_points( int num_points );
+
+      /// @brief Returns the bisection tolerance (MeV) used when sampling
+      /// final excitation energies in the continuum
+      inline double get_continuum_sampling_tolerance() const
+        { return continuum_sampling_tolerance_; }
+
+      /// @brief Sets the bisection tolerance (MeV) used when sampling
+      /// final excitation energies in the continuum
+      /// @details This is passed to Generator::inverse_transform_sample()
+      void set_continuum_sampling_tolerance( double tolerance );
+
+      /// @brief Serve fragment transmission coefficients from lookup tables
+      /// that are built in the background
+      /// @details Optical models created after this function is called are
+      /// wrapped in a TabulatedOpticalModel. The tables cover orbital angular
+      /// momenta up to the current value of get_fragment_l_max(). An
+      /// exception is thrown if the tables have already been enabled.
+      /// @param tolerance Relative tolerance for the tabulated values
+      /// @param E_max Maximum total CM frame kinetic energy (MeV) to tabulate
+      /// @param num_threads Number of low-priority threads that will build
+      /// the tables
+      void enable_transmission_tables( double tolerance, double E_max,
+        int num_threads );
+
+      /// @brief Returns the service that builds transmission coefficient
+      /// tables, or nullptr if they are not enabled
+      inline const marley::TableBuilder* table_builder() const
+        { return table_builder_.get(); }
+
       /// @brief Looks up the ground-state spin-parity for a particular nuclide
       /// @param[in] nuc_pdg PDG code for the nuclide of interest
       /// @param[out] twoJ Two times the ground-state nuclear spin
@@ -210,6 +292,10 @@ namespace marley {
       std::unordered_map<int, std::unique_ptr<
         marley::GammaStrengthFunctionModel> > gamma_strength_function_table_;
 
+      /// @brief Guards the creation of new entries in the optical model,
+      /// level density, and gamma-ray strength function tables
+      std::mutex models_mutex_;
+
       /// @brief Lookup table for nuclear fragments that will be considered
       /// when modeling de-excitations in the unbound continuum
       static std::map<int, marley::Fragment> fragment_table_;
@@ -230,6 +316,32 @@ namespace marley {
       /// object) for decays to the unbound continuum via gamma-ray emission
       int gamma_l_max_ = DEFAULT_GAMMA_L_MAX;
 
+      /// @brief Default value of continuum_quadrature_order_
+      static constexpr int DEFAULT_CONTINUUM_QUADRATURE_ORDER = 50;
+
+      /// @brief Step size (fm) for the Numerov method used by the
+      /// KoningDelarocheOpticalModel
+      double numerov_step_size_;
+
+      /// @brief Half the number of sampling points used by
+      /// continuum_integrator_
+      int continuum_quadrature_order_ = DEFAULT_CONTINUUM_QUADRATURE_ORDER;
+
+      /// @brief Clenshaw-Curtis integrator for total continuum decay widths
+      marley::Integrator continuum_integrator_;
+
+      /// @brief Number of Chebyshev points used to build the cumulative
+      /// distribution of final excitation energies in the continuum
+      int continuum_chebyshev_points_;
+
+      /// @brief Default value of continuum_sampling_tolerance_
+      static constexpr double DEFAULT_CONTINUUM_SAMPLING_TOLERANCE = 1e-12;
+
+      /// @brief Bisection tolerance (MeV) used to sample final excitation
+      /// energies in the continuum
+      double continuum_sampling_tolerance_
+        = DEFAULT_CONTINUUM_SAMPLING_TOLERANCE;
+
       /// @brief Flag that indicates whether the ground-state spin-parities
       /// have already been loaded from the relevant data file
       static bool initialized_gs_spin_parity_table_;
@@ -259,6 +371,17 @@ namespace marley {
       /// @brief Helper function that initializes the file index for
       /// loading nuclear structure data
       void load_structure_index();
+
+      /// @brief Relative tolerance for transmission coefficient tables
+      double table_tolerance_ = 0.;
+
+      /// @brief Maximum energy (MeV) for transmission coefficient tables
+      double table_E_max_ = 0.;
+
+      /// @brief Builds transmission coefficient tables in the background
+      /// @details This member is declared last so that its worker threads
+      /// are stopped before any of the models that they use are destroyed.
+      std::unique_ptr<marley::TableBuilder> table_builder_;
   };
 
 }
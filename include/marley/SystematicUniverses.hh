@@ -0,0 +1,173 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <array>
+#include <string>
+#include <vector>
+
+#include "marley/MatrixElement.hh"
+#include "marley/NuclearReaction.hh"
+
+namespace marley {
+
+  class ExitChannel;
+  class HauserFeshbachDecay;
+  class JSON;
+
+  /// @brief Alternate sets of nuclear model parameters ("universes") used
+  /// to compute systematic weights for each event during generation
+  /// @details Events are always sampled using the nominal model. For each
+  /// universe, a likelihood ratio is accumulated from the choices made
+  /// while creating the event:
+  ///   - The nuclear transition: the partial cross section for the sampled
+  ///     level is scaled by gt_scale or fermi_scale (which rescale the
+  ///     B(GT) and B(F) strengths from the reaction data), and, for CC
+  ///     reactions, by the ratio of the Coulomb correction factors obtained
+  ///     using the universe's coulomb_mode and the nominal one.
+  ///   - Each Hauser-Feshbach exit channel: the partial decay widths are
+  ///     scaled by a factor for the emitted particle (width_scales) times an
+  ///     extra factor (continuum_scale) for decays to the continuum. These
+  ///     factors stand in for changes to the optical model and gamma-ray
+  ///     strength function.
+  ///   - Each final excitation energy in the continuum: the level density
+  ///     of the residual nucleus is multiplied by
+  ///     @f$ \exp[k (E_{xf} - E_{c,\min})] @f$, where @f$ k @f$ is the
+  ///     universe's level_density_slope and @f$ E_{c,\min} @f$ is the
+  ///     onset of the continuum. This changes the shape of the continuum
+  ///     spectrum (as does a change in the nuclear temperature) while
+  ///     keeping the level density matched to the discrete levels. The
+  ///     sampled @f$ E_{xf} @f$ is weighted by the ratio of the
+  ///     differential widths, and the partial widths to the continuum are
+  ///     recomputed with the reshaped spectrum.
+  ///
+  /// Because the angular distributions and the sampling of spin-parities
+  /// within an exit channel do not depend on these parameters, the product
+  /// of the ratios is the full event weight. The mean weight over a sample
+  /// is the ratio of the flux-averaged total cross section in the universe
+  /// to the nominal one.
+  class SystematicUniverses {
+
+    public:
+
+      using CoulombMode = marley::NuclearReaction::CoulombMode;
+
+      /// @brief Number of kinds of particles that may be emitted during a
+      /// Hauser-Feshbach decay step (a gamma-ray and six nuclear fragments)
+      static constexpr size_t NUM_EMITTED_ = 7;
+
+      /// @brief Parameters for a single universe
+      struct Universe {
+        std::string name; ///< Label used in output files
+        double gt_scale = 1.; ///< Scale factor for B(GT) strengths
+        double fermi_scale = 1.; ///< Scale factor for B(F) strengths
+        /// @brief Whether coulomb_mode overrides the nominal setting
+        bool has_coulomb_mode = false;
+        /// @brief Coulomb correction method to use for CC reactions
+        CoulombMode coulomb_mode = CoulombMode::FERMI_AND_MEMA;
+        /// @brief Partial width scale factors for each emitted particle
+        /// (in the order given by emitted_pdgs())
+        std::array<double, NUM_EMITTED_> width_scales;
+        /// @brief Extra scale factor for partial widths to the continuum
+        double continuum_scale = 1.;
+        /// @brief Change (MeV<sup> -1</sup>) to the logarithmic slope of the
+        /// level density in the continuum
+        double level_density_slope = 0.;
+
+        Universe() { width_scales.fill( 1. ); }
+      };
+
+      /// @brief Create an empty set of universes
+      SystematicUniverses() {}
+
+      /// @brief Create a set of universes from a JSON array
+      /// @details Each element of the array is an object that describes
+      /// either a single universe (using the keys "name", "gt_scale",
+      /// "fermi_scale", "coulomb_mode", "width_scales", "continuum_scale",
+      /// and "level_density_slope") or a group of random universes (using
+      /// the keys "throws", "seed", "name", and "sigma"). See the annotated
+      /// example job configuration file for details.
+      explicit SystematicUniverses(const marley::JSON& json);
+
+      /// @brief Get the number of universes
+      inline size_t size() const { return universes_.size(); }
+
+      /// @brief Returns true if no universes are defined
+      inline bool empty() const { return universes_.empty(); }
+
+      /// @brief Get the parameters for each universe
+      inline const std::vector<Universe>& universes() const
+        { return universes_; }
+
+      /// @brief Get the names of the universes (in order)
+      std::vector<std::string> names() const;
+
+      /// @brief Multiply each weight by the likelihood ratio for a
+      /// transition to a nuclear level in a NuclearReaction
+      /// @param nr Reaction that created the event
+      /// @param me MatrixElement for the sampled transition
+      /// @param beta_rel_cd Relative speed of the ejectile and residue
+      /// @param[in,out] weights Vector holding one weight per universe
+      void weight_transition(const marley::NuclearReaction& nr,
+        const marley::MatrixElement& me, double beta_rel_cd,
+        std::vector<double>& weights) const;
+
+      /// @brief Multiply each weight by the likelihood ratio for the choice
+      /// of an exit channel (and, for the continuum, of a final excitation
+      /// energy) in a Hauser-Feshbach decay
+      /// @param hfd Decay whose exit channel was sampled
+      /// @param chosen Sampled exit channel (owned by hfd)
+      /// @param Exf Final excitation energy (MeV) sampled in the chosen
+      /// channel
+      /// @param[in,out] weights Vector holding one weight per universe
+      void weight_decay(const marley::HauserFeshbachDecay& hfd,
+        const marley::ExitChannel& chosen, double Exf,
+        std::vector<double>& weights) const;
+
+      /// @brief PDG codes of the particles that may be emitted during a
+      /// Hauser-Feshbach decay step
+      static const std::array<int, NUM_EMITTED_>& emitted_pdgs();
+
+    private:
+
+      /// @brief Adds a universe described by a JSON object
+      void add_universe(const marley::JSON& json, size_t index);
+
+      /// @brief Adds a group of random universes described by a JSON object
+      void add_throws(const marley::JSON& json);
+
+      /// @brief Index of an exit channel class in channel_scales_
+      static size_t channel_class(const marley::ExitChannel& ec);
+
+      /// @brief Number of exit channel classes (discrete and continuum
+      /// decays for each kind of emitted particle)
+      static constexpr size_t NUM_CLASSES_ = 2u * NUM_EMITTED_;
+
+      std::vector<Universe> universes_;
+
+      /// @brief Overall partial width scale factor for each universe and
+      /// exit channel class (stored universe by universe)
+      std::vector<double> channel_scales_;
+
+      /// @brief Level density slope for each universe
+      std::vector<double> slopes_;
+
+      /// @brief Whether any universe has a nonzero level density slope
+      bool has_slopes_ = false;
+  };
+
+}
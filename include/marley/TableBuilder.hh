@@ -0,0 +1,104 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace marley {
+
+  /// @brief Background service that builds lookup tables on low-priority
+  /// worker threads
+  /// @details Objects that can speed up a calculation with a lookup table
+  /// submit a job that builds it the first time the table is needed. They
+  /// keep answering requests using the direct calculation until the job
+  /// publishes the finished table. The worker threads are given the lowest
+  /// available scheduling priority, so table construction only uses CPU time
+  /// that event generation leaves idle.
+  class TableBuilder {
+
+    public:
+
+      /// @brief A job that builds a table
+      /// @details The job returns true if the table was published, or false
+      /// if it could not be built (in which case the direct calculation
+      /// remains in use). Long jobs should poll stopping() and give up once
+      /// it returns true.
+      using Job = std::function<bool()>;
+
+      /// @param num_threads Number of worker threads
+      explicit TableBuilder( int num_threads = 1 );
+
+      /// @brief Discards any jobs that have not started yet and waits for
+      /// the running ones to finish
+      ~TableBuilder();
+
+      TableBuilder( const TableBuilder& ) = delete;
+      TableBuilder& operator=( const TableBuilder& ) = delete;
+
+      /// @brief Queues a job for execution by the worker threads
+      void submit( Job job );
+
+      /// @brief Blocks until every job submitted so far has finished
+      void wait();
+
+      /// @brief Returns true once running jobs should give up early
+      inline bool stopping() const { return stop_.load(); }
+
+      /// @brief Get the number of jobs submitted so far
+      inline size_t num_submitted() const { return num_submitted_.load(); }
+
+      /// @brief Get the number of jobs that published their tables
+      inline size_t num_built() const { return num_built_.load(); }
+
+      /// @brief Get the number of jobs that finished without publishing
+      /// their tables
+      inline size_t num_failed() const { return num_failed_.load(); }
+
+      /// @brief Get the number of worker threads
+      inline int num_threads() const
+        { return static_cast<int>( threads_.size() ); }
+
+    private:
+
+      /// @brief Loop executed by each worker thread
+      void run_worker();
+
+      std::vector<std::thread> threads_;
+      std::deque<Job> jobs_;
+      std::mutex mutex_;
+
+      /// @brief Signals the workers that a job was queued (or that they
+      /// should stop)
+      std::condition_variable job_cv_;
+
+      /// @brief Signals wait() that a job finished
+      std::condition_variable done_cv_;
+
+      std::atomic<bool> stop_;
+      std::atomic<size_t> num_submitted_;
+      std::atomic<size_t> num_built_;
+      std::atomic<size_t> num_failed_;
+  };
+
+}
@@ -0,0 +1,139 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <string>
+#include <vector>
+
+#include "marley/BackshiftedFermiGasModel.hh"
+#include "marley/LevelDensityModel.hh"
+
+namespace marley {
+
+  /// @brief %Level density model that interpolates microscopic
+  /// @f$ \rho(E_x, J, \Pi) @f$ tables
+  /// @details The tables are read from files in the format used by the
+  /// Hartree-Fock-Bogoliubov level densities distributed with <a
+  /// href="http://www-nds.iaea.org/RIPL-3/">RIPL-3</a> and <a
+  /// href="http://talys.eu">TALYS</a>. Each nuclide is described by a
+  /// "Positive-Parity" and a "Negative-Parity" block (or by a single
+  /// parity-summed block, which is split evenly between the two parities),
+  /// whose rows list the excitation energy U followed by the T, NCUMUL, RHOOBS,
+  /// and RHOTOT columns and the spin-dependent level densities. For even-A
+  /// nuclides the k-th spin column corresponds to J = k, while for odd-A
+  /// nuclides it corresponds to J = k + 1/2.
+  ///
+  /// On construction, the logarithms of the tabulated level densities are
+  /// resampled onto a uniform excitation energy grid whose spacing is the
+  /// smallest one used in the file. Lookups then need only a single
+  /// multiplication to find the grid cell. Since the RIPL-3 energy nodes all
+  /// lie on a common 0.25 MeV grid, the resampled table reproduces the
+  /// log-linear interpolation of the original one exactly. Outside of the
+  /// tabulated energy range, and for spins beyond the last tabulated one, a
+  /// BackshiftedFermiGasModel is used instead.
+  class TabulatedLevelDensityModel : public LevelDensityModel {
+
+    public:
+
+      /// @brief Create a tabulated level density model for a specific nuclide
+      /// @param file_name Name of the level density table file
+      /// @param Z atomic number of the desired nuclide
+      /// @param A mass number of the desired nuclide
+      TabulatedLevelDensityModel(const std::string& file_name, int Z, int A);
+
+      /// @copydoc marley::LevelDensityModel::level_density(double)
+      virtual double level_density(double Ex) const override;
+
+      /// @copydoc marley::LevelDensityModel::level_density(double, int)
+      virtual double level_density(double Ex, int two_J) const override;
+
+      /// @copydoc LevelDensityModel::level_density(double, int, marley::Parity)
+      virtual double level_density(double Ex, int two_J, marley::Parity Pi)
+        const override;
+
+      /// @copydoc LevelDensityModel::level_densities()
+      /// @details The grid cell and interpolation weight are computed only
+      /// once for all of the spins
+      virtual void level_densities(double Ex, int two_J_min, size_t num_spins,
+        marley::Parity Pi, double* rhos) const override;
+
+      /// @brief Lowest tabulated excitation energy (MeV)
+      inline double Ex_min() const { return Ex_min_; }
+
+      /// @brief Highest tabulated excitation energy (MeV)
+      inline double Ex_max() const { return Ex_max_; }
+
+      /// @brief Number of nodes in the resampled energy grid
+      inline size_t num_nodes() const { return num_nodes_; }
+
+      /// @brief Number of tabulated spins for each parity
+      inline int num_spins() const { return num_spins_; }
+
+    protected:
+
+      /// @brief Upper limit on the number of nodes in the resampled energy
+      /// grid
+      static constexpr size_t MAX_NODES = 100000u;
+
+      /// @brief Finds the grid cell containing an excitation energy
+      /// @param[in] Ex Excitation energy (MeV)
+      /// @param[out] i Index of the lower edge of the grid cell
+      /// @param[out] t Interpolation weight of the upper edge
+      /// @return False if Ex lies outside of the tabulated range, true
+      /// otherwise
+      bool locate(double Ex, size_t& i, double& t) const;
+
+      /// @brief Interpolates between two logarithms of level densities
+      /// @details Linear interpolation in the level density itself is used
+      /// when either end point vanishes
+      static double interpolate(double ln_rho_0, double ln_rho_1, double t);
+
+      /// @brief Returns the column of a spin in the resampled table, or -1 if
+      /// it is not tabulated
+      int spin_column(int two_J, marley::Parity Pi) const;
+
+      /// @brief Level density for a spin that has no column in the table
+      /// @details Spins that cannot occur in this nuclide have a vanishing
+      /// level density. Spins beyond the last tabulated one use the
+      /// fallback model.
+      double untabulated_level_density(double Ex, int two_J,
+        marley::Parity Pi) const;
+
+      int Z_; ///< atomic number for this nuclide
+      int A_; ///< mass number for this nuclide
+
+      double Ex_min_; ///< first node of the resampled energy grid (MeV)
+      double Ex_max_; ///< last node of the resampled energy grid (MeV)
+      double inv_dEx_; ///< inverse spacing of the resampled grid (MeV<sup> -1</sup>)
+      size_t num_nodes_; ///< number of nodes in the resampled energy grid
+      int num_spins_; ///< number of tabulated spins for each parity
+
+      /// @brief Number of entries stored for each energy node
+      /// @details Each node holds the logarithms of the total level density,
+      /// then of the positive-parity densities for each spin, then of the
+      /// negative-parity ones
+      size_t stride_;
+
+      /// @brief Logarithms of the resampled level densities
+      std::vector<double> ln_rhos_;
+
+      /// @brief Model used outside of the tabulated energy range and for
+      /// spins that are not tabulated
+      marley::BackshiftedFermiGasModel fallback_;
+  };
+
+}
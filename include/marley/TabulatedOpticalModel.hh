@@ -0,0 +1,197 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "marley/OpticalModel.hh"
+
+namespace marley {
+
+  class TableBuilder;
+
+  /// @brief Optical model that serves transmission coefficients from lookup
+  /// tables built in the background
+  /// @details A TabulatedOpticalModel wraps another OpticalModel that
+  /// performs the direct calculation. The first time that a transmission
+  /// coefficient is requested for a given nuclear fragment, a job that
+  /// tabulates the coefficients for every partial wave up to a maximum
+  /// orbital angular momentum is submitted to a TableBuilder. Until the job
+  /// publishes the table, all requests are answered by the direct
+  /// calculation.
+  ///
+  /// The tables use a grid that is uniform in the logarithm of the total CM
+  /// frame kinetic energy, and the logarithms of the coefficients are
+  /// interpolated linearly. This reproduces the power-law behavior of the
+  /// coefficients near threshold. The grid is refined until the interpolated
+  /// values agree with the direct calculation at the midpoint of every cell
+  /// to within a relative tolerance, or until it has MAX_CELLS cells.
+  /// Coefficients smaller than MIN_RELEVANT_T are only required to agree to
+  /// within an absolute tolerance of tolerance * MIN_RELEVANT_T. Any
+  /// coefficient that still fails the check in a cell of the final grid is
+  /// computed directly whenever it is needed in that cell.
+  ///
+  /// Energies outside of the range [MIN_ENERGY, E_max], angular momenta
+  /// above the maximum one, nonzero target charges, and all other optical
+  /// model quantities are always handled by the direct calculation.
+  class TabulatedOpticalModel : public OpticalModel {
+
+    public:
+
+      /// @param direct OpticalModel used for the direct calculation
+      /// @param builder TableBuilder that will construct the tables. It must
+      /// be destroyed before this object.
+      /// @param l_max Maximum orbital angular momentum to tabulate
+      /// @param E_max Maximum total CM frame kinetic energy (MeV) to
+      /// tabulate
+      /// @param tolerance Relative tolerance for the interpolated values
+      TabulatedOpticalModel( std::unique_ptr<marley::OpticalModel> direct,
+        marley::TableBuilder& builder, int l_max, double E_max,
+        double tolerance );
+
+      using OpticalModel::optical_model_potential;
+      using OpticalModel::transmission_coefficient;
+      using OpticalModel::total_cross_section;
+
+      /// @copydoc marley::OpticalModel::optical_model_potential()
+      virtual std::complex<double> optical_model_potential(double r,
+        double fragment_KE_lab, int fragment_pdg, int two_j, int l, int two_s,
+        int target_charge, Workspace& ws) const override;
+
+      /// @copydoc marley::OpticalModel::transmission_coefficient()
+      virtual double transmission_coefficient(double total_KE_CM,
+        int fragment_pdg, int two_j, int l, int two_s, int target_charge,
+        Workspace& ws) const override;
+
+      /// @copydoc marley::OpticalModel::transmission_coefficients()
+      /// @details The grid cell is found only once for all partial waves
+      virtual void transmission_coefficients(double total_KE_CM,
+        int fragment_pdg, int two_s, const int* two_js, const int* ls,
+        size_t num_waves, int target_charge, double* Ts, Workspace& ws)
+        const override;
+
+      /// @copydoc marley::OpticalModel::total_cross_section()
+      virtual double total_cross_section(double fragment_KE_lab,
+        int fragment_pdg, int two_s, size_t l_max, int target_charge,
+        Workspace& ws) const override;
+
+      /// @brief Returns true if the table for a fragment has been published,
+      /// or false otherwise
+      bool has_table( int fragment_pdg ) const;
+
+      /// @brief Get the number of grid cells in the published table for a
+      /// fragment (zero if it has not been published)
+      size_t num_cells( int fragment_pdg ) const;
+
+      /// @brief Get the OpticalModel used for the direct calculation
+      inline const marley::OpticalModel& direct_model() const
+        { return *direct_; }
+
+      /// @brief Number of grid cells used in the first attempt to build a
+      /// table
+      static constexpr size_t INITIAL_CELLS = 64u;
+
+      /// @brief Largest number of grid cells allowed in a table
+      static constexpr size_t MAX_CELLS = 4096u;
+
+      /// @brief Lowest tabulated energy (MeV)
+      static constexpr double MIN_ENERGY = 1e-3;
+
+      /// @brief Transmission coefficients below this value are held to an
+      /// absolute (rather than relative) tolerance
+      static constexpr double MIN_RELEVANT_T = 1e-8;
+
+    protected:
+
+      /// @brief Transmission coefficients for one fragment
+      /// @details Node k (counting from zero) lies at the energy
+      /// MIN_ENERGY * exp(k * du). Each node stores the logarithms of the
+      /// coefficients for every partial wave, using the slots given by
+      /// slot().
+      struct Table {
+        double inv_du; ///< Inverse grid spacing in ln(E)
+        size_t num_cells; ///< Number of grid cells
+        std::vector<double> ln_Ts; ///< Logarithms of the coefficients
+
+        /// @brief Flags (one per cell and slot) for the coefficients that
+        /// must be computed directly
+        std::vector<unsigned char> use_direct;
+      };
+
+      /// @brief Bookkeeping for the table belonging to a fragment
+      struct Entry {
+        int fragment_pdg; ///< PDG code of the fragment
+        int two_s; ///< Two times the spin of the fragment
+
+        /// @brief Set to true when the table is first requested
+        std::atomic<bool> requested{ false };
+
+        /// @brief Owns the table once it has been built
+        std::unique_ptr<Table> table;
+
+        /// @brief The published table, or nullptr if it is not available
+        std::atomic<const Table*> published{ nullptr };
+      };
+
+      /// @brief Returns the published table for a fragment, submitting the
+      /// job that builds it if needed. Returns nullptr if the direct
+      /// calculation should be used.
+      const Table* find_table( int fragment_pdg, int two_s,
+        int target_charge ) const;
+
+      /// @brief Finds the grid cell containing an energy
+      /// @param[in] table Table to use
+      /// @param[in] total_KE_CM Total CM frame kinetic energy (MeV)
+      /// @param[out] k Index of the grid cell
+      /// @param[out] t Interpolation weight of the upper node of the cell
+      /// @return False if the energy lies outside of the table, true
+      /// otherwise
+      bool locate( const Table& table, double total_KE_CM, size_t& k,
+        double& t ) const;
+
+      /// @brief Interpolates a coefficient within a grid cell
+      /// @return False if the coefficient must be computed directly, true
+      /// otherwise
+      bool lookup( const Table& table, size_t k, double t, int s,
+        size_t stride, double& T ) const;
+
+      /// @brief Returns the slot used by a partial wave in each node, or -1
+      /// if it is not tabulated
+      int slot( int two_j, int l, int two_s ) const;
+
+      /// @brief Number of slots in each node
+      inline size_t num_slots( int two_s ) const
+        { return static_cast<size_t>( (l_max_ + 1)*(two_s + 1) ); }
+
+      /// @brief Builds and publishes the table for a fragment
+      /// @return True if the table was published, false otherwise
+      bool build_table( Entry& entry ) const;
+
+      std::unique_ptr<marley::OpticalModel> direct_;
+      marley::TableBuilder& builder_;
+
+      int l_max_; ///< Maximum tabulated orbital angular momentum
+      double E_max_; ///< Maximum tabulated energy (MeV)
+      double tolerance_; ///< Relative tolerance for the tables
+
+      /// @brief Table bookkeeping for each known nuclear fragment
+      std::vector< std::unique_ptr<Entry> > entries_;
+  };
+
+}
@@ -0,0 +1,124 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <initializer_list>
+#include <string>
+
+namespace marley {
+
+  /// @brief Optional timeline tracing of the event generation stages
+  /// @details While tracing is enabled, Tracer::Span objects record the
+  /// start time and duration of the code regions that they enclose.
+  /// Each thread stores its spans in its own buffer, so recording never
+  /// takes a lock. A sampling decision is made for each new event by
+  /// begin_event(). Spans are only recorded for the sampled events. The
+  /// spans are written to a file in the Chrome trace-event JSON format
+  /// (readable by chrome://tracing and https://ui.perfetto.dev) by write().
+  class Tracer {
+
+    public:
+
+      /// @brief Maximum number of numerical arguments that may be attached
+      /// to a Span
+      static constexpr size_t MAX_ARGUMENTS = 4;
+
+      /// @brief Default maximum number of spans stored for each thread
+      static constexpr size_t DEFAULT_MAX_SPANS = 1000000;
+
+      /// @brief Named numerical value shown together with a Span
+      struct Argument {
+        const char* name; ///< Argument name (must be a string literal)
+        double value; ///< Argument value
+      };
+
+      /// @brief Records a span for the current event (if it was sampled)
+      /// that lasts for the lifetime of this object
+      class Span {
+
+        public:
+
+          /// @param name Name of the span (must be a string literal)
+          inline explicit Span( const char* name ) : name_( name ) {
+            if ( Tracer::event_traced() ) this->start();
+          }
+
+          /// @param name Name of the span (must be a string literal)
+          /// @param args Numerical arguments to attach to the span. Any
+          /// beyond the first MAX_ARGUMENTS are ignored.
+          Span( const char* name, std::initializer_list<Argument> args );
+
+          inline ~Span() { if ( active_ ) this->stop(); }
+
+          Span( const Span& ) = delete;
+          Span& operator=( const Span& ) = delete;
+
+        private:
+
+          void start();
+          void stop();
+
+          const char* name_;
+          bool active_ = false;
+          size_t num_args_ = 0;
+          Argument args_[ MAX_ARGUMENTS ];
+          std::chrono::steady_clock::time_point start_time_;
+      };
+
+      /// @brief Starts recording spans
+      /// @param file_name Name of the file to create in write()
+      /// @param event_fraction Fraction of events (0, 1] to trace. Events
+      /// are selected at regular intervals (e.g., every 100th event for a
+      /// fraction of 0.01), beginning with the first one on each thread.
+      /// @param max_spans Maximum number of spans to store for each thread.
+      /// Spans beyond this limit are counted but discarded.
+      static void enable( const std::string& file_name,
+        double event_fraction = 1., size_t max_spans = DEFAULT_MAX_SPANS );
+
+      /// @brief Returns true if tracing is enabled
+      static bool enabled();
+
+      /// @brief Notifies the Tracer that the current thread is starting to
+      /// work on a new event
+      /// @details This decides whether the spans that follow (until the
+      /// next call to begin_event() on the same thread) will be recorded
+      static void begin_event();
+
+      /// @brief Returns true if the current event on this thread is
+      /// being traced
+      static bool event_traced();
+
+      /// @brief Records the current values of one or more counters (if the
+      /// current event is being traced)
+      /// @details Trace viewers show each counter name as a separate track
+      /// @param name Name of the counter (must be a string literal)
+      /// @param values Values to record. Any beyond the first MAX_ARGUMENTS
+      /// are ignored.
+      static void counter( const char* name,
+        std::initializer_list<Argument> values );
+
+      /// @brief Writes all recorded spans to the trace file and stops
+      /// tracing
+      /// @details This should be called only after all other threads that
+      /// record spans have finished
+      /// @return The number of spans (and sets of counter values) written
+      static size_t write();
+  };
+
+}
@@ -0,0 +1,115 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+
+// standard library includes
+#include <fstream>
+#include <string>
+#include <vector>
+
+// MARLEY includes
+#include "marley/JSON.hh"
+#include "marley/OutputFile.hh"
+
+namespace marley {
+
+  /// @brief OutputFile that stores the information needed to regenerate
+  /// events instead of the events themselves
+  /// @details Events are generated in blocks of a fixed size. Each block
+  /// begins a new random number stream (see
+  /// marley::Generator::start_event_stream()), so the events that it
+  /// contains can be regenerated exactly and independently of all other
+  /// blocks. When the file is closed, a JSON object is written that
+  /// contains the MARLEY version, the job configuration (with the seed
+  /// that was actually used), checksums of all data files that were
+  /// needed to generate the events, and a descriptor of the random number
+  /// stream used for each block. Values of a few kinematic variables (see
+  /// marley::PrimaryEventFilter) may optionally be stored for each event
+  /// to allow for fast event selection.
+  ///
+  /// The file may be read using marley::EventFileReader, which
+  /// regenerates the events on demand.
+  class VirtualOutputFile : public OutputFile {
+
+    public:
+
+      /// @param name Name of the output file
+      /// @param mode Output mode. Only "overwrite" is supported.
+      /// @param force Whether an existing file should be overwritten
+      /// without prompting the user
+      /// @param events_per_block Number of events generated using each
+      /// random number stream
+      /// @param summary_fields Names of the variables whose values should
+      /// be stored for each event
+      VirtualOutputFile(const std::string& name, const std::string& mode,
+        bool force = false, long events_per_block = DEFAULT_EVENTS_PER_BLOCK,
+        const std::vector<std::string>& summary_fields = {});
+
+      virtual ~VirtualOutputFile() = default;
+
+      /// @brief Resuming a previous run is not supported for virtual output
+      virtual bool resume(std::unique_ptr<marley::Generator>& gen,
+        long& num_previous_events) override;
+
+      virtual void close(const marley::JSON& json_config,
+        const marley::Generator& gen, const long num_events) override;
+
+      virtual int_fast64_t bytes_written() override;
+
+      /// @brief Records the summary fields (if any) for the event
+      /// @details The marley::Generator used to create the events must
+      /// start a new event stream at the beginning of each block (see
+      /// events_per_block())
+      virtual void write_event(const marley::Event* event) override;
+
+      virtual void write_flux_avg_tot_xsec(double avg_tot_xsec) override;
+
+      /// @brief Number of events generated using each random number stream
+      inline long events_per_block() const { return events_per_block_; }
+
+      /// @brief Default number of events in each block
+      static constexpr long DEFAULT_EVENTS_PER_BLOCK = 1000;
+
+    protected:
+
+      virtual void open() override;
+
+      /// @brief Writes the JSON object that describes the events
+      virtual void write_generator_state(const marley::JSON& json_config,
+        const marley::Generator& gen, const long num_events) override;
+
+      /// @brief Stream used to write the file
+      std::ofstream stream_;
+
+      long events_per_block_;
+
+      /// @brief Number of events passed to write_event()
+      long event_count_ = 0;
+
+      std::vector<std::string> summary_fields_;
+
+      /// @brief Values of each summary field for every event
+      std::vector< std::vector<double> > summary_values_;
+
+      double flux_avg_tot_xsec_ = 0.;
+
+      /// @brief Storage for the number of bytes written to disk
+      int_fast64_t byte_count_ = 0;
+  };
+
+}
@@ -57,16 +57,17 @@ namespace marley {
       /// strength functions are independent of the gamma energy, and so the
       /// parameter e_gamma is ignored by this function.
       virtual double strength_function(TransitionType type, int l,
-        double e_gamma) override;
+        double e_gamma) const override;
 
       virtual double transmission_coefficient(TransitionType type, int l,
-        double e_gamma) override;
+        double e_gamma) const override;
 
     private:
 
       double D0_; // Level spacing parameter (MeV)
 
-      double partial_decay_width(TransitionType type, int l, double e_gamma);
+      double partial_decay_width(TransitionType type, int l, double e_gamma)
+        const;
   };
 
 }
@@ -0,0 +1,70 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace marley_simd {
+
+  /// @brief Instruction set extensions targeted by the vectorized kernels
+  enum class Level { GENERIC = 0, SSE4_2, AVX2, AVX512 };
+
+  /// @brief Returns the best Level supported by the current CPU
+  Level detected_level();
+
+  /// @brief Returns the Level used by the kernels
+  /// @details By default, this is Level::GENERIC, which gives results
+  /// identical to those of MARLEY versions that predate the vectorized
+  /// kernels. A different Level may be chosen by setting the MARLEY_SIMD
+  /// environment variable to "sse4.2", "avx2", or "avx512" before the
+  /// first kernel is called. The value "native" selects the
+  /// detected_level(). Levels not supported by the CPU are rejected.
+  Level active_level();
+
+  /// @brief Selects the Level used by the kernels
+  /// @details An error is thrown if the CPU does not support the Level
+  void set_level(Level level);
+
+  /// @brief Returns a lower-case name for a Level
+  std::string level_name(Level level);
+
+  /// @brief Parses a Level name (as returned by level_name())
+  /// @details The name "native" is also accepted. It refers to the
+  /// detected_level().
+  Level level_from_name(const std::string& name);
+
+  /// @brief Computes the sums used by the barycentric interpolation formula
+  /// @details For j = 0, ..., n - 1, this accumulates
+  /// @f$ t_j = w_j / (x - x_j) @f$ into the denominator and
+  /// @f$ t_j f_j @f$ into the numerator. Level::GENERIC adds the terms
+  /// sequentially. The vectorized levels instead add term j to partial
+  /// sum j % 8 and combine the eight partial sums at the end. They give
+  /// results identical to each other, but these can differ in the last
+  /// few bits from those of Level::GENERIC.
+  /// @param[in] xs Array of n grid points
+  /// @param[in] ws Array of n barycentric weights
+  /// @param[in] fs Array of n function values at the grid points
+  /// @param[in] n Number of grid points
+  /// @param[in] x Point at which to interpolate
+  /// @param[out] numer Numerator sum
+  /// @param[out] denom Denominator sum
+  /// @return The index of the first grid point equal to x, or n if
+  /// there is none. The sums are not meaningful in the former case.
+  size_t barycentric_sums(const double* xs, const double* ws,
+    const double* fs, size_t n, double x, double& numer, double& denom);
+}
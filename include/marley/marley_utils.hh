@@ -227,6 +227,10 @@ namespace marley_utils {
   // Efficiently read in an entire file as a std::string
   std::string get_file_contents(std::string filename);
 
+  // Compute a checksum (64-bit FNV-1a hash, written as 16 hexadecimal
+  // digits) of the contents of a file
+  std::string file_checksum(const std::string& filename);
+
   // Advance to the next line of an ifstream that either matches (match == true)
   // or does not match (match == false) a given regular expression
   std::string get_next_line(std::ifstream &file_in, const std::regex &rx,
@@ -0,0 +1,194 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <new>
+
+#include "marley/Arena.hh"
+#include "marley/Error.hh"
+
+namespace {
+
+  // Depth of the Arena::Scope objects that are active on the current thread
+  thread_local int arena_scope_depth = 0;
+
+  // Rounds an offset up to the given power-of-two alignment
+  inline size_t align_up( size_t offset, size_t alignment ) {
+    return ( offset + alignment - 1u ) & ~( alignment - 1u );
+  }
+
+  // Statistics reported by the thread Arenas. Each Arena owns its entry
+  // in the map until it is destroyed, at which point the entry is folded
+  // into the totals for the threads that have exited.
+  struct ArenaRegistry {
+    std::mutex mutex;
+    std::map<const marley::Arena*, marley::Arena::Statistics> live;
+    marley::Arena::Statistics retired;
+    size_t num_retired = 0u;
+  };
+
+  ArenaRegistry& arena_registry() {
+    static ArenaRegistry registry;
+    return registry;
+  }
+
+  void add_statistics( marley::Arena::Statistics& sum,
+    const marley::Arena::Statistics& stats )
+  {
+    sum.bytes_in_use += stats.bytes_in_use;
+    sum.peak_bytes += stats.peak_bytes;
+    sum.capacity += stats.capacity;
+    sum.total_bytes += stats.total_bytes;
+    sum.resets += stats.resets;
+  }
+
+}
+
+constexpr size_t marley::Arena::DEFAULT_CHUNK_SIZE;
+
+marley::Arena::Scope::Scope( bool activate ) : active_( activate ) {
+  if ( active_ ) ++arena_scope_depth;
+}
+
+marley::Arena::Scope::~Scope() {
+  if ( active_ ) --arena_scope_depth;
+}
+
+marley::Arena::Arena( size_t chunk_size )
+  : next_chunk_size_( std::max<size_t>(chunk_size, 1u) )
+{
+}
+
+marley::Arena::~Arena() {
+  if ( !registered_ ) return;
+  auto& registry = arena_registry();
+  std::lock_guard<std::mutex> lock( registry.mutex );
+  registry.live.erase( this );
+  add_statistics( registry.retired, stats_ );
+  ++registry.num_retired;
+}
+
+void marley::Arena::publish_statistics() const {
+  auto& registry = arena_registry();
+  std::lock_guard<std::mutex> lock( registry.mutex );
+  registry.live[ this ] = stats_;
+}
+
+void marley::Arena::add_chunk( size_t min_bytes ) {
+  size_t size = std::max( next_chunk_size_, min_bytes );
+  // Chunks come from the global operator new[], so their first byte has the
+  // strictest fundamental alignment
+  chunks_.push_back( Chunk{ std::unique_ptr<char[]>(new char[size]), size } );
+  stats_.capacity += size;
+  next_chunk_size_ = 2u * size;
+  offset_ = 0u;
+}
+
+void* marley::Arena::allocate( size_t bytes, size_t alignment ) {
+  if ( alignment > alignof(std::max_align_t) ) throw marley::Error(
+    "Unsupported alignment requested from a marley::Arena" );
+
+  size_t start = align_up( offset_, alignment );
+  if ( chunks_.empty() || start + bytes > chunks_.back().size ) {
+    this->add_chunk( bytes );
+    start = 0u;
+  }
+
+  offset_ = start + bytes;
+  ++live_allocations_;
+
+  stats_.bytes_in_use += bytes;
+  stats_.total_bytes += bytes;
+  stats_.peak_bytes = std::max( stats_.peak_bytes, stats_.bytes_in_use );
+
+  return chunks_.back().data.get() + start;
+}
+
+void marley::Arena::deallocate( const void* ptr ) {
+  if ( ptr ) --live_allocations_;
+}
+
+bool marley::Arena::owns( const void* ptr ) const {
+  const char* p = static_cast<const char*>( ptr );
+  for ( const auto& chunk : chunks_ ) {
+    const char* begin = chunk.data.get();
+    if ( p >= begin && p < begin + chunk.size ) return true;
+  }
+  return false;
+}
+
+bool marley::Arena::reset() {
+  if ( live_allocations_ != 0 ) return false;
+
+  ++stats_.resets;
+  stats_.bytes_in_use = 0u;
+  offset_ = 0u;
+
+  if ( chunks_.size() > 1u ) {
+    size_t capacity = stats_.capacity;
+    chunks_.clear();
+    stats_.capacity = 0u;
+    next_chunk_size_ = capacity;
+    this->add_chunk( capacity );
+  }
+
+  if ( registered_ ) this->publish_statistics();
+  return true;
+}
+
+marley::Arena& marley::Arena::thread_arena() {
+  static thread_local marley::Arena arena;
+  if ( !arena.registered_ ) {
+    arena.registered_ = true;
+    arena.publish_statistics();
+  }
+  return arena;
+}
+
+marley::Arena::Statistics marley::Arena::combined_statistics(
+  size_t* num_threads )
+{
+  auto& registry = arena_registry();
+  std::lock_guard<std::mutex> lock( registry.mutex );
+
+  Statistics sum = registry.retired;
+  for ( const auto& pair : registry.live ) add_statistics( sum, pair.second );
+
+  if ( num_threads ) *num_threads = registry.num_retired
+    + registry.live.size();
+  return sum;
+}
+
+bool marley::Arena::scope_active() {
+  return arena_scope_depth > 0;
+}
+
+void* marley::Arena::scoped_allocate( size_t bytes, size_t alignment ) {
+  if ( arena_scope_depth > 0 ) {
+    return thread_arena().allocate( bytes, alignment );
+  }
+  return ::operator new( bytes );
+}
+
+void marley::Arena::scoped_deallocate( void* ptr ) {
+  if ( !ptr ) return;
+  auto& arena = thread_arena();
+  if ( arena.owns(ptr) ) arena.deallocate( ptr );
+  else ::operator delete( ptr );
+}
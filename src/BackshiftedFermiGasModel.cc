@@ -59,23 +59,46 @@ marley::BackshiftedFermiGasModel::BackshiftedFermiGasModel(int Z, int A)
 
 // rho(Ex, J, Pi) assuming equipartition of parity (the parameter Pi is unused)
 double marley::BackshiftedFermiGasModel::level_density(double Ex, int two_J,
-  marley::Parity /*Pi*/)
+  marley::Parity /*Pi*/) const
 {
   return 0.5 * level_density(Ex, two_J);
 }
 
-double marley::BackshiftedFermiGasModel::level_density(double Ex, int two_J) {
-  double rho = level_density(Ex);
-  // Spin-cutoff parameter sigma_ is updated by previous call to
-  // this->level_density(Ex)
-  double two_sigma2 = 2 * std::pow(sigma_, 2);
+double marley::BackshiftedFermiGasModel::level_density(double Ex, int two_J)
+  const
+{
+  double sigma;
+  double rho = total_level_density(Ex, sigma);
+  return spin_factor(two_J, sigma) * rho;
+}
+
+void marley::BackshiftedFermiGasModel::level_densities(double Ex,
+  int two_J_min, size_t num_spins, marley::Parity /*Pi*/, double* rhos) const
+{
+  double sigma;
+  double rho = total_level_density(Ex, sigma);
+  for ( size_t k = 0u; k < num_spins; ++k ) {
+    int two_J = two_J_min + 2*static_cast<int>( k );
+    rhos[ k ] = 0.5 * ( spin_factor(two_J, sigma) * rho );
+  }
+}
+
+double marley::BackshiftedFermiGasModel::spin_factor(int two_J, double sigma)
+  const
+{
+  double two_sigma2 = 2 * std::pow(sigma, 2);
   return ((two_J + 1) / two_sigma2) * std::exp(-0.25 * std::pow(two_J + 1, 2)
-    / two_sigma2) * rho;
+    / two_sigma2);
 }
 
-/// @note Calls to this function update the spin cut-off parameter sigma_
-double marley::BackshiftedFermiGasModel::level_density(double Ex) {
+double marley::BackshiftedFermiGasModel::level_density(double Ex) const {
+  double sigma;
+  return total_level_density(Ex, sigma);
+}
 
+double marley::BackshiftedFermiGasModel::total_level_density(double Ex,
+  double& sigma) const
+{
   // Effective excitation energy
   double U = Ex - Delta_BFM_;
 
@@ -93,7 +116,7 @@ double marley::BackshiftedFermiGasModel::level_density(double Ex) {
   /// TALYS
   const double Ed = 0.;
 
-  // Compute the spin cut-off parameter sigma_
+  // Compute the spin cut-off parameter sigma
 
   // To avoid numerical problems, we will always use the discrete spin cutoff
   // parameter for U <= Ed.
@@ -101,12 +124,12 @@ double marley::BackshiftedFermiGasModel::level_density(double Ex) {
   // change. The actual TALYS code may make this same choice.
   /// @todo Reconsider method used for handling spin cut-off parameter
   /// calculation for U <= Ed.
-  if (U <= Ed) sigma_ = sigma_d_global_;
+  if (U <= Ed) sigma = sigma_d_global_;
   else {
 
     if (Ex >= Sn_) {
       double sigma_F2 = compute_sigma_F2(Ex, a);
-      sigma_ = std::sqrt(sigma_F2);
+      sigma = std::sqrt(sigma_F2);
     }
     else {
 
@@ -115,7 +138,7 @@ double marley::BackshiftedFermiGasModel::level_density(double Ex) {
 
       // Ed < Ex < Sn_
       double sigma_d2 = std::pow(sigma_d_global_, 2);
-      sigma_ = std::sqrt(sigma_d2 + (Ex - Ed)
+      sigma = std::sqrt(sigma_d2 + (Ex - Ed)
         * (sigma_F2_Sn - sigma_d2) / (Sn_ - Ed));
     }
   }
@@ -124,11 +147,11 @@ double marley::BackshiftedFermiGasModel::level_density(double Ex) {
   // level density as U -> 0 to prevent numerical issues.
   if (U <= 0) {
     static const double exp1 = std::exp(1);
-    return exp1 * a / (12 * sigma_);
+    return exp1 * a / (12 * sigma);
   }
 
   double aU = a * U;
   double sqrt_aU = std::sqrt(aU);
-  return std::pow(12 * sigma_ * (std::sqrt(2 * sqrt_aU)*U*std::exp(-2 * sqrt_aU)
+  return std::pow(12 * sigma * (std::sqrt(2 * sqrt_aU)*U*std::exp(-2 * sqrt_aU)
     + std::exp(-aU - 1)/a), -1);
 }
@@ -67,8 +67,8 @@ marley::ChebyshevInterpolatingFunction::ChebyshevInterpolatingFunction(
     }
 
     chebyshev_coeffs_ = Fs_;
-    wsave_ = std::vector<double>(3*Fs_.size() + 15, 0.);
-    ifac_ = std::vector<int>(Fs_.size() / 2, 0);
+    wsave_.assign( 3*Fs_.size() + 15, 0. );
+    ifac_.assign( Fs_.size() / 2, 0 );
 
     int my_size = Fs_.size();
     costi( &my_size, wsave_.data(), ifac_.data() );
@@ -99,6 +99,19 @@ marley::ChebyshevInterpolatingFunction::ChebyshevInterpolatingFunction(
   for (double& d : chebyshev_coeffs_) d /= N_;
 
   compute_integral();
+  compute_weights();
+}
+
+void marley::ChebyshevInterpolatingFunction::compute_weights() {
+  // For Chebyshev points of the second kind, the weights alternate in sign
+  // and are halved at the endpoints
+  Ws_.assign( N_ + 1, 0. );
+  double w_j = -1.;
+  for ( size_t j = 0; j <= N_; ++j ) {
+    w_j = -w_j; // w_j = (-1)^(j)
+    Ws_[ j ] = w_j;
+    if ( j == 0 || j == N_ ) Ws_[ j ] /= 2.;
+  }
 }
 
 void marley::ChebyshevInterpolatingFunction::compute_integral() {
@@ -154,9 +167,8 @@ marley::ChebyshevInterpolatingFunction
     result.Xs_.push_back( x );
   }
 
-  result.wsave_ = std::vector<double>(
-    3*result.chebyshev_coeffs_.size() + 15, 0.);
-  result.ifac_ = std::vector<int>(result.chebyshev_coeffs_.size() / 2, 0);
+  result.wsave_.assign( 3*result.chebyshev_coeffs_.size() + 15, 0. );
+  result.ifac_.assign( result.chebyshev_coeffs_.size() / 2, 0 );
 
   int my_size = result.chebyshev_coeffs_.size();
   result.Fs_ = result.chebyshev_coeffs_;
@@ -164,5 +176,7 @@ marley::ChebyshevInterpolatingFunction
   cost( &my_size, result.Fs_.data(), result.wsave_.data(), result.ifac_.data() );
   for (double& d : result.Fs_) d *= 0.5;
 
+  result.compute_weights();
+
   return result;
 }
@@ -0,0 +1,623 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// standard library includes
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+#ifdef USE_ZLIB
+  #include <zlib.h>
+#endif
+
+// MARLEY includes
+#include "marley/Compression.hh"
+#include "marley/Error.hh"
+#include "marley/JSON.hh"
+
+namespace {
+
+  // Every block written by marley::GzipOutputBuffer is a gzip member
+  // whose header includes a single extra subfield. The subfield has the
+  // identifier "MB" and stores the total size of the member (in bytes) as
+  // a 32-bit little-endian integer.
+  constexpr unsigned char GZIP_ID1 = 0x1f;
+  constexpr unsigned char GZIP_ID2 = 0x8b;
+  constexpr unsigned char GZIP_CM_DEFLATE = 8;
+  constexpr unsigned char GZIP_FLAG_EXTRA = 4;
+  constexpr unsigned char GZIP_OS_UNKNOWN = 255;
+  constexpr unsigned char BLOCK_SUBFIELD_ID1 = 'M';
+  constexpr unsigned char BLOCK_SUBFIELD_ID2 = 'B';
+  constexpr size_t BLOCK_HEADER_SIZE = 20;
+  constexpr size_t BLOCK_TRAILER_SIZE = 8;
+
+  // Size of the chunks decompressed at a time for gzip files that could
+  // not be indexed
+  constexpr size_t CHUNK_SIZE = 1u << 20;
+
+  unsigned default_threads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return ( n > 0u ) ? n : 1u;
+  }
+
+  uint_fast64_t get_little_endian(const char* p, int num_bytes) {
+    uint_fast64_t result = 0u;
+    for ( int b = 0; b < num_bytes; ++b ) {
+      result |= static_cast<uint_fast64_t>( static_cast<unsigned char>(p[b]) )
+        << (8*b);
+    }
+    return result;
+  }
+
+  #ifdef USE_ZLIB
+
+  void put_little_endian(std::string& s, size_t pos, uint_fast64_t value,
+    int num_bytes)
+  {
+    for ( int b = 0; b < num_bytes; ++b ) {
+      s[pos + b] = static_cast<char>( (value >> (8*b)) & 0xffu );
+    }
+  }
+
+  // Compresses a block of data into a gzip member
+  std::string compress_block(const std::string& data, int level) {
+    if ( data.size() > std::numeric_limits<uInt>::max() ) {
+      throw marley::Error("Block too large to compress");
+    }
+
+    z_stream zs;
+    std::memset( &zs, 0, sizeof(zs) );
+    if ( deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS, 8,
+      Z_DEFAULT_STRATEGY) != Z_OK )
+    {
+      throw marley::Error("Failed to initialize zlib compression");
+    }
+
+    size_t bound = deflateBound( &zs, data.size() );
+    std::string block( BLOCK_HEADER_SIZE + bound + BLOCK_TRAILER_SIZE, '\0' );
+
+    zs.next_in = reinterpret_cast<Bytef*>( const_cast<char*>(data.data()) );
+    zs.avail_in = static_cast<uInt>( data.size() );
+    zs.next_out = reinterpret_cast<Bytef*>( &block[BLOCK_HEADER_SIZE] );
+    zs.avail_out = static_cast<uInt>( bound );
+
+    int status = deflate( &zs, Z_FINISH );
+    size_t deflated_size = zs.total_out;
+    deflateEnd( &zs );
+    if ( status != Z_STREAM_END ) throw marley::Error("zlib compression"
+      " failed");
+
+    size_t block_size = BLOCK_HEADER_SIZE + deflated_size
+      + BLOCK_TRAILER_SIZE;
+    block.resize( block_size );
+
+    block[0] = static_cast<char>( GZIP_ID1 );
+    block[1] = static_cast<char>( GZIP_ID2 );
+    block[2] = static_cast<char>( GZIP_CM_DEFLATE );
+    block[3] = static_cast<char>( GZIP_FLAG_EXTRA );
+    put_little_endian( block, 4, 0u, 4 ); // modification time
+    block[8] = 0; // extra flags
+    block[9] = static_cast<char>( GZIP_OS_UNKNOWN );
+    put_little_endian( block, 10, 8u, 2 ); // length of the extra field
+    block[12] = static_cast<char>( BLOCK_SUBFIELD_ID1 );
+    block[13] = static_cast<char>( BLOCK_SUBFIELD_ID2 );
+    put_little_endian( block, 14, 4u, 2 ); // length of the subfield
+    put_little_endian( block, 16, block_size, 4 );
+
+    uLong crc = crc32( 0L, Z_NULL, 0 );
+    crc = crc32( crc, reinterpret_cast<const Bytef*>(data.data()),
+      static_cast<uInt>(data.size()) );
+
+    size_t trailer = BLOCK_HEADER_SIZE + deflated_size;
+    put_little_endian( block, trailer, crc, 4 );
+    put_little_endian( block, trailer + 4, data.size() & 0xffffffffu, 4 );
+
+    return block;
+  }
+
+  // Decompresses a gzip member written by compress_block()
+  std::string decompress_block(const std::string& block) {
+    size_t deflated_size = block.size() - BLOCK_HEADER_SIZE
+      - BLOCK_TRAILER_SIZE;
+    const char* trailer = block.data() + BLOCK_HEADER_SIZE + deflated_size;
+    uint_fast64_t expected_crc = get_little_endian( trailer, 4 );
+    size_t data_size = get_little_endian( trailer + 4, 4 );
+
+    std::string data( data_size, '\0' );
+
+    z_stream zs;
+    std::memset( &zs, 0, sizeof(zs) );
+    if ( inflateInit2(&zs, -MAX_WBITS) != Z_OK ) {
+      throw marley::Error("Failed to initialize zlib decompression");
+    }
+
+    zs.next_in = reinterpret_cast<Bytef*>( const_cast<char*>(
+      block.data() + BLOCK_HEADER_SIZE) );
+    zs.avail_in = static_cast<uInt>( deflated_size );
+    zs.next_out = reinterpret_cast<Bytef*>( &data[0] );
+    zs.avail_out = static_cast<uInt>( data_size );
+
+    int status = inflate( &zs, Z_FINISH );
+    inflateEnd( &zs );
+
+    uLong crc = crc32( 0L, Z_NULL, 0 );
+    crc = crc32( crc, reinterpret_cast<const Bytef*>(data.data()),
+      static_cast<uInt>(data.size()) );
+
+    if ( status != Z_STREAM_END || zs.total_out != data_size
+      || crc != expected_crc )
+    {
+      throw marley::Error("Encountered a corrupted block while"
+        " decompressing a gzip file");
+    }
+
+    return data;
+  }
+
+  #endif
+
+}
+
+marley::CompressionSettings::CompressionSettings()
+  : threads_( default_threads() )
+{
+}
+
+marley::CompressionSettings::CompressionSettings(const marley::JSON& json)
+  : threads_( default_threads() )
+{
+  if ( json.has_key("compression") ) {
+    std::string type = json.at( "compression" ).to_string();
+    if ( type == "gzip" ) enabled_ = true;
+    else if ( type != "none" ) throw marley::Error("Invalid compression"
+      " type \"" + type + "\" given in an output file specification");
+  }
+
+  // Reads an optional positive integer setting
+  auto get_setting = [&json](const std::string& key, long min, long max,
+    long default_value) -> long
+  {
+    if ( !json.has_key(key) ) return default_value;
+    const auto& value = json.at( key );
+    bool ok;
+    long result = value.to_long( ok );
+    if ( !ok || result < min || result > max ) {
+      throw marley::Error("Invalid value " + value.dump_string()
+        + " given for the \"" + key + "\" key in an output file"
+        " specification");
+    }
+    return result;
+  };
+
+  level_ = static_cast<int>( get_setting("compression_level", 1, 9,
+    level_) );
+  threads_ = static_cast<unsigned>( get_setting("compression_threads", 1,
+    std::numeric_limits<int>::max(), threads_) );
+  block_size_ = static_cast<size_t>( get_setting("compression_block_size",
+    1, std::numeric_limits<int>::max(), block_size_) );
+
+  if ( enabled_ && !available() ) throw marley::Error("Compressed output"
+    " files require MARLEY to be built with zlib support");
+}
+
+bool marley::CompressionSettings::available() {
+  #ifdef USE_ZLIB
+    return true;
+  #else
+    return false;
+  #endif
+}
+
+marley::BlockWorkerPool::BlockWorkerPool(unsigned num_threads,
+  size_t max_queued) : max_queued_( std::max<size_t>(max_queued, 1u) )
+{
+  for ( unsigned t = 0; t < std::max(num_threads, 1u); ++t ) {
+    threads_.emplace_back( [this]() { this->run(); } );
+  }
+}
+
+marley::BlockWorkerPool::~BlockWorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    stop_ = true;
+    queue_.clear();
+  }
+  cv_.notify_all();
+  for ( auto& thread : threads_ ) thread.join();
+}
+
+std::future<std::string> marley::BlockWorkerPool::submit(
+  std::function<std::string()> task)
+{
+  std::packaged_task<std::string()> pt( std::move(task) );
+  std::future<std::string> result = pt.get_future();
+  {
+    std::unique_lock<std::mutex> lock( mutex_ );
+    cv_.wait( lock, [this]() { return queue_.size() < max_queued_; } );
+    queue_.push_back( std::move(pt) );
+  }
+  cv_.notify_all();
+  return result;
+}
+
+void marley::BlockWorkerPool::run() {
+  for (;;) {
+    std::packaged_task<std::string()> task;
+    {
+      std::unique_lock<std::mutex> lock( mutex_ );
+      cv_.wait( lock, [this]() { return stop_ || !queue_.empty(); } );
+      if ( stop_ ) return;
+      task = std::move( queue_.front() );
+      queue_.pop_front();
+    }
+    // Let submit() know that there is space in the queue
+    cv_.notify_all();
+
+    // Any exception is stored in the future
+    task();
+  }
+}
+
+marley::GzipOutputBuffer::GzipOutputBuffer(std::ostream& out,
+  const marley::CompressionSettings& settings)
+  : std::streambuf(), out_( out ), settings_( settings )
+{
+  if ( !marley::CompressionSettings::available() ) throw marley::Error(
+    "Compressed output files require MARLEY to be built with zlib support");
+  block_.reserve( settings_.block_size() );
+}
+
+marley::GzipOutputBuffer::~GzipOutputBuffer() {
+  // Avoid losing any pending data if finish() was not called
+  try {
+    this->finish();
+  }
+  catch ( ... ) { }
+}
+
+marley::GzipOutputBuffer::int_type marley::GzipOutputBuffer::overflow(
+  int_type ch)
+{
+  if ( traits_type::eq_int_type(ch, traits_type::eof()) ) {
+    return traits_type::not_eof( ch );
+  }
+  block_.push_back( traits_type::to_char_type(ch) );
+  return ch;
+}
+
+std::streamsize marley::GzipOutputBuffer::xsputn(const char* s,
+  std::streamsize count)
+{
+  block_.append( s, count );
+  return count;
+}
+
+void marley::GzipOutputBuffer::end_record() {
+  if ( block_.size() >= settings_.block_size() ) this->submit_block();
+}
+
+void marley::GzipOutputBuffer::submit_block() {
+  if ( block_.empty() ) return;
+
+  #ifdef USE_ZLIB
+    std::string data;
+    data.swap( block_ );
+    block_.reserve( settings_.block_size() );
+
+    if ( !workers_ ) {
+      workers_ = std::make_unique<marley::BlockWorkerPool>(
+        settings_.threads(), settings_.threads() );
+    }
+
+    int level = settings_.level();
+    auto shared_data = std::make_shared<std::string>( std::move(data) );
+    pending_.push_back( workers_->submit( [shared_data, level]()
+      { return compress_block(*shared_data, level); }) );
+  #endif
+
+  this->write_blocks( false );
+}
+
+void marley::GzipOutputBuffer::write_blocks(bool wait) {
+  while ( !pending_.empty() ) {
+    // Unless we were asked to wait for every block, only block the calling
+    // thread if too many blocks are being compressed at once
+    auto& front = pending_.front();
+    if ( !wait && pending_.size() <= settings_.threads()
+      && front.wait_for(std::chrono::seconds(0))
+      != std::future_status::ready ) break;
+
+    std::string block = front.get();
+    pending_.pop_front();
+    out_.write( block.data(), block.size() );
+  }
+}
+
+void marley::GzipOutputBuffer::finish() {
+  this->submit_block();
+  this->write_blocks( true );
+  out_.flush();
+}
+
+marley::GzipInputBuffer::GzipInputBuffer(const std::string& file_name,
+  unsigned threads) : std::streambuf(), file_name_( file_name ),
+  in_( file_name, std::ios::in | std::ios::binary ),
+  threads_( threads > 0u ? threads : default_threads() )
+{
+  #ifndef USE_ZLIB
+    throw marley::Error("Cannot read the compressed file \"" + file_name_
+      + "\". MARLEY was built without zlib support.");
+  #else
+    if ( !in_ ) throw marley::Error("Could not read from the file \""
+      + file_name_ + '\"');
+
+    if ( this->build_index() ) this->start_at_block( 0 );
+    else {
+      z_stream* zs = new z_stream;
+      std::memset( zs, 0, sizeof(z_stream) );
+      // Adding 32 to the window bits enables automatic detection of the
+      // gzip header
+      if ( inflateInit2(zs, MAX_WBITS + 32) != Z_OK ) {
+        delete zs;
+        throw marley::Error("Failed to initialize zlib decompression");
+      }
+      zstream_ = zs;
+      compressed_.resize( CHUNK_SIZE );
+      this->restart();
+    }
+  #endif
+}
+
+marley::GzipInputBuffer::~GzipInputBuffer() {
+  #ifdef USE_ZLIB
+    if ( zstream_ ) {
+      z_stream* zs = static_cast<z_stream*>( zstream_ );
+      inflateEnd( zs );
+      delete zs;
+    }
+  #endif
+}
+
+bool marley::GzipInputBuffer::is_gzip_file(const std::string& file_name) {
+  std::ifstream in( file_name, std::ios::in | std::ios::binary );
+  char magic[2];
+  if ( !in.read(magic, 2) ) return false;
+  return static_cast<unsigned char>( magic[0] ) == GZIP_ID1
+    && static_cast<unsigned char>( magic[1] ) == GZIP_ID2;
+}
+
+bool marley::GzipInputBuffer::build_index() {
+  in_.clear();
+  in_.seekg( 0, std::ios::end );
+  int_fast64_t file_size = in_.tellg();
+
+  int_fast64_t offset = 0;
+  int_fast64_t data_offset = 0;
+  char header[ BLOCK_HEADER_SIZE ];
+  char isize[ 4 ];
+
+  while ( offset < file_size ) {
+    in_.seekg( offset );
+    if ( !in_.read(header, BLOCK_HEADER_SIZE) ) break;
+
+    bool ok = static_cast<unsigned char>( header[0] ) == GZIP_ID1
+      && static_cast<unsigned char>( header[1] ) == GZIP_ID2
+      && static_cast<unsigned char>( header[2] ) == GZIP_CM_DEFLATE
+      && static_cast<unsigned char>( header[3] ) == GZIP_FLAG_EXTRA
+      && get_little_endian( header + 10, 2 ) == 8u
+      && static_cast<unsigned char>( header[12] ) == BLOCK_SUBFIELD_ID1
+      && static_cast<unsigned char>( header[13] ) == BLOCK_SUBFIELD_ID2
+      && get_little_endian( header + 14, 2 ) == 4u;
+    if ( !ok ) break;
+
+    int_fast64_t size = get_little_endian( header + 16, 4 );
+    if ( size < static_cast<int_fast64_t>(BLOCK_HEADER_SIZE
+      + BLOCK_TRAILER_SIZE) || offset + size > file_size ) break;
+
+    in_.seekg( offset + size - 4 );
+    if ( !in_.read(isize, 4) ) break;
+
+    blocks_.push_back( { offset, size, data_offset } );
+    offset += size;
+    data_offset += get_little_endian( isize, 4 );
+  }
+
+  in_.clear();
+  if ( offset != file_size ) {
+    blocks_.clear();
+    return false;
+  }
+  return true;
+}
+
+void marley::GzipInputBuffer::start_at_block(size_t index) {
+  // Discard any blocks that are still being decompressed
+  pending_.clear();
+
+  data_.clear();
+  setg( nullptr, nullptr, nullptr );
+  data_offset_ = ( index < blocks_.size() ) ? blocks_.at( index ).data_offset_
+    : 0;
+
+  next_block_ = index;
+  next_submitted_block_ = index;
+
+  #ifdef USE_ZLIB
+    while ( next_submitted_block_ < blocks_.size()
+      && pending_.size() < threads_ ) this->submit_next_block();
+  #endif
+}
+
+void marley::GzipInputBuffer::submit_next_block() {
+  #ifdef USE_ZLIB
+    if ( !workers_ ) {
+      workers_ = std::make_unique<marley::BlockWorkerPool>( threads_,
+        threads_ );
+    }
+
+    const auto& info = blocks_.at( next_submitted_block_ );
+    auto block = std::make_shared<std::string>( info.size_, '\0' );
+    in_.seekg( info.offset_ );
+    in_.read( &(*block)[0], info.size_ );
+    pending_.push_back( workers_->submit( [block]()
+      { return decompress_block(*block); }) );
+    ++next_submitted_block_;
+  #endif
+}
+
+marley::GzipInputBuffer::int_type marley::GzipInputBuffer::underflow() {
+  if ( gptr() < egptr() ) return traits_type::to_int_type( *gptr() );
+
+  do {
+    if ( !blocks_.empty() ) {
+      if ( next_block_ >= blocks_.size() ) return traits_type::eof();
+
+      std::string data = pending_.front().get();
+      pending_.pop_front();
+      data_offset_ = blocks_.at( next_block_ ).data_offset_;
+      data_.swap( data );
+      ++next_block_;
+
+      // Keep the decompression threads busy with the upcoming blocks
+      if ( next_submitted_block_ < blocks_.size() ) {
+        this->submit_next_block();
+      }
+    }
+    else if ( !this->read_next_chunk() ) return traits_type::eof();
+  } while ( data_.empty() );
+
+  setg( &data_[0], &data_[0], &data_[0] + data_.size() );
+  return traits_type::to_int_type( *gptr() );
+}
+
+bool marley::GzipInputBuffer::read_next_chunk() {
+  #ifdef USE_ZLIB
+    if ( at_eof_ ) return false;
+
+    z_stream* zs = static_cast<z_stream*>( zstream_ );
+    data_offset_ += data_.size();
+
+    std::string out( CHUNK_SIZE, '\0' );
+    size_t have = 0;
+    while ( have < out.size() ) {
+      if ( zs->avail_in == 0 ) {
+        in_.read( &compressed_[0], compressed_.size() );
+        std::streamsize count = in_.gcount();
+        if ( count <= 0 ) {
+          at_eof_ = true;
+          break;
+        }
+        zs->next_in = reinterpret_cast<Bytef*>( &compressed_[0] );
+        zs->avail_in = static_cast<uInt>( count );
+      }
+
+      zs->next_out = reinterpret_cast<Bytef*>( &out[have] );
+      zs->avail_out = static_cast<uInt>( out.size() - have );
+      int status = inflate( zs, Z_NO_FLUSH );
+      have = out.size() - zs->avail_out;
+
+      // Another gzip member may follow the one that just ended
+      if ( status == Z_STREAM_END ) inflateReset( zs );
+      else if ( status != Z_OK && status != Z_BUF_ERROR ) {
+        throw marley::Error("Failed to decompress the file \""
+          + file_name_ + '\"');
+      }
+    }
+
+    out.resize( have );
+    data_.swap( out );
+    return !data_.empty();
+  #else
+    return false;
+  #endif
+}
+
+void marley::GzipInputBuffer::restart() {
+  #ifdef USE_ZLIB
+    z_stream* zs = static_cast<z_stream*>( zstream_ );
+    inflateReset( zs );
+    zs->next_in = Z_NULL;
+    zs->avail_in = 0;
+  #endif
+  in_.clear();
+  in_.seekg( 0 );
+  at_eof_ = false;
+  data_.clear();
+  data_offset_ = 0;
+  setg( nullptr, nullptr, nullptr );
+}
+
+marley::GzipInputBuffer::pos_type marley::GzipInputBuffer::seekoff(
+  off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+  if ( !(which & std::ios_base::in) ) return pos_type( off_type(-1) );
+
+  int_fast64_t current = data_offset_ + ( gptr() - eback() );
+  if ( dir == std::ios_base::cur ) {
+    if ( off == 0 ) return pos_type( current );
+    return this->seekpos( pos_type(current + off), which );
+  }
+  else if ( dir == std::ios_base::beg ) {
+    return this->seekpos( pos_type(off), which );
+  }
+
+  // Seeking relative to the end of the file is not supported
+  return pos_type( off_type(-1) );
+}
+
+marley::GzipInputBuffer::pos_type marley::GzipInputBuffer::seekpos(
+  pos_type pos, std::ios_base::openmode which)
+{
+  const pos_type failure( off_type(-1) );
+  if ( !(which & std::ios_base::in) ) return failure;
+
+  int_fast64_t p = static_cast<int_fast64_t>( pos );
+  if ( p < 0 ) return failure;
+
+  // Seeks within the current chunk of uncompressed data are easy
+  auto seek_in_data = [this, p]() -> bool {
+    int_fast64_t size = data_.size();
+    if ( p < data_offset_ || p > data_offset_ + size ) return false;
+    char* base = data_.empty() ? nullptr : &data_[0];
+    setg( base, base + (p - data_offset_), base + size );
+    return true;
+  };
+
+  if ( seek_in_data() ) return pos;
+
+  if ( !blocks_.empty() ) {
+    // Find the last block that starts at or before the requested position
+    auto iter = std::upper_bound( blocks_.begin(), blocks_.end(), p,
+      [](int_fast64_t value, const BlockInfo& info)
+      { return value < info.data_offset_; } );
+    if ( iter == blocks_.begin() ) return failure;
+    --iter;
+
+    this->start_at_block( std::distance(blocks_.begin(), iter) );
+    if ( traits_type::eq_int_type(this->underflow(), traits_type::eof()) ) {
+      return failure;
+    }
+    if ( seek_in_data() ) return pos;
+  }
+  else if ( p == 0 ) {
+    this->restart();
+    return pos;
+  }
+
+  return failure;
+}
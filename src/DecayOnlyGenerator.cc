@@ -0,0 +1,355 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// standard library includes
+#include <algorithm>
+#include <utility>
+
+// MARLEY includes
+#include "marley/marley_utils.hh"
+#include "marley/DecayOnlyGenerator.hh"
+#include "marley/DecayScheme.hh"
+#include "marley/Error.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/Level.hh"
+#include "marley/Logger.hh"
+#include "marley/MassTable.hh"
+#include "marley/StructureDatabase.hh"
+#include "marley/TargetAtom.hh"
+#include "marley/Tracer.hh"
+
+namespace {
+
+  // Throws a marley::Error describing an invalid value in one of the
+  // elements of the "initial_states" array
+  void complain( const std::string& key, const marley::JSON& value,
+    int index )
+  {
+    throw marley::Error( "Invalid value " + value.dump_string()
+      + " given for the \"" + key + "\" key in element "
+      + std::to_string(index) + " of the \"initial_states\" array" );
+  }
+
+  marley::Parity parse_parity( const marley::JSON& spec, int index ) {
+    if ( spec.is_string() ) {
+      std::string p_str = spec.to_string();
+      if ( p_str == "+" ) return marley::Parity( true );
+      else if ( p_str == "-" ) return marley::Parity( false );
+    }
+    else {
+      bool ok;
+      long p_int = spec.to_long( ok );
+      if ( ok && p_int == 1 ) return marley::Parity( true );
+      else if ( ok && p_int == -1 ) return marley::Parity( false );
+    }
+    complain( "parity", spec, index );
+    return marley::Parity(); // We shouldn't ever get here
+  }
+
+}
+
+marley::DecayOnlyGenerator::DecayOnlyGenerator(
+  const marley::JSONConfig& config, int num_threads )
+  : initial_states_( parse_initial_states(config.get_json()) ), stop_( false )
+{
+  if ( num_threads < 0 ) throw marley::Error( "Negative number of threads"
+    " requested in marley::DecayOnlyGenerator::DecayOnlyGenerator()" );
+
+  if ( num_threads == 0 ) {
+    num_threads = std::max( 1u, std::thread::hardware_concurrency() );
+  }
+
+  std::vector<double> weights;
+  for ( const auto& is : initial_states_ ) weights.push_back( is.weight );
+
+  // Each worker needs its own Generator since the Generator (and the
+  // StructureDatabase that it owns) is not thread-safe. Suppress the
+  // duplicate logging messages produced while configuring them.
+  auto& logger = marley::Logger::Instance();
+  bool log_enabled = logger.is_enabled();
+  logger.disable();
+
+  try {
+    for ( int t = 0; t < num_threads; ++t ) {
+      auto worker = std::make_unique<Worker>();
+      worker->gen = std::make_unique<marley::Generator>(
+        config.create_generator() );
+      worker->gen->reseed( worker->gen->get_seed() + t );
+      worker->state_dist = std::discrete_distribution<size_t>(
+        weights.begin(), weights.end() );
+
+      // Load the structure data for the initial nuclei up front. This also
+      // fills the (static) table of ground-state spin-parities, which may
+      // not be initialized concurrently by the worker threads.
+      auto& sdb = worker->gen->get_structure_db();
+      for ( const auto& is : initial_states_ ) sdb.get_decay_scheme( is.pdg );
+      marley::StructureDatabase::fragments();
+      workers_.push_back( std::move(worker) );
+    }
+  }
+  catch ( ... ) {
+    logger.enable( log_enabled );
+    throw;
+  }
+
+  logger.enable( log_enabled );
+
+  MARLEY_LOG_INFO() << "Simulating de-excitations of " << initial_states_.size()
+    << " initial nuclear state(s) using " << num_threads << " thread(s)";
+
+  // A single worker is run by the calling thread, so don't bother to
+  // launch any others
+  if ( num_threads > 1 ) {
+    for ( auto& worker : workers_ ) {
+      Worker* w = worker.get();
+      w->thread = std::thread( [this, w]() { this->run_worker( *w ); } );
+    }
+  }
+}
+
+marley::DecayOnlyGenerator::~DecayOnlyGenerator() {
+  stop_ = true;
+  for ( auto& worker : workers_ ) {
+    {
+      std::lock_guard<std::mutex> lock( worker->mutex );
+    }
+    worker->cv.notify_all();
+  }
+  for ( auto& worker : workers_ ) {
+    if ( worker->thread.joinable() ) worker->thread.join();
+  }
+}
+
+bool marley::DecayOnlyGenerator::is_requested( const marley::JSON& config ) {
+  return config.has_key( "initial_states" );
+}
+
+std::vector<marley::DecayOnlyGenerator::InitialState>
+  marley::DecayOnlyGenerator::parse_initial_states(
+  const marley::JSON& config )
+{
+  if ( !config.has_key("initial_states") ) throw marley::Error( "Missing"
+    " \"initial_states\" key in the job configuration" );
+
+  const auto& states = config.at( "initial_states" );
+  if ( !states.is_array() || states.length() < 1 ) throw marley::Error(
+    "The \"initial_states\" key must have a value that is a non-empty"
+    " JSON array" );
+
+  std::vector<InitialState> result;
+  double total_weight = 0.;
+  for ( int i = 0; i < states.length(); ++i ) {
+
+    const auto& spec = states.at( i );
+    if ( !spec.is_object() ) throw marley::Error( "Element "
+      + std::to_string(i) + " of the \"initial_states\" array is not"
+      " a JSON object" );
+
+    for ( const auto& key : { "nuclide", "Ex", "twoJ", "parity" } ) {
+      if ( !spec.has_key(key) ) throw marley::Error( std::string("Missing \"")
+        + key + "\" key in element " + std::to_string(i)
+        + " of the \"initial_states\" array" );
+    }
+
+    InitialState is;
+    bool ok;
+
+    const auto& nuc = spec.at( "nuclide" );
+    is.pdg = nuc.to_long( ok );
+    if ( !ok || !marley_utils::is_ion(is.pdg) ) complain( "nuclide", nuc, i );
+
+    // The excitation energy may be given either as a single value or as
+    // a two-element array [ Ex_min, Ex_max ] describing a uniform
+    // distribution
+    const auto& ex = spec.at( "Ex" );
+    if ( ex.is_array() ) {
+      if ( ex.length() != 2 ) complain( "Ex", ex, i );
+      bool ok2;
+      is.Ex_min = ex.at( 0 ).to_double( ok );
+      is.Ex_max = ex.at( 1 ).to_double( ok2 );
+      if ( !ok || !ok2 || is.Ex_max < is.Ex_min ) complain( "Ex", ex, i );
+    }
+    else {
+      is.Ex_min = ex.to_double( ok );
+      is.Ex_max = is.Ex_min;
+      if ( !ok ) complain( "Ex", ex, i );
+    }
+    if ( is.Ex_min < 0. ) complain( "Ex", ex, i );
+
+    const auto& tj = spec.at( "twoJ" );
+    is.twoJ = tj.to_long( ok );
+    if ( !ok || is.twoJ < 0 ) complain( "twoJ", tj, i );
+
+    is.parity = parse_parity( spec.at("parity"), i );
+
+    is.weight = 1.;
+    if ( spec.has_key("weight") ) {
+      const auto& w = spec.at( "weight" );
+      is.weight = w.to_double( ok );
+      if ( !ok || is.weight < 0. ) complain( "weight", w, i );
+    }
+    total_weight += is.weight;
+
+    result.push_back( is );
+  }
+
+  if ( total_weight <= 0. ) throw marley::Error( "At least one element of"
+    " the \"initial_states\" array must have a positive weight" );
+
+  return result;
+}
+
+marley::Event marley::DecayOnlyGenerator::decay_initial_state(
+  Worker& worker )
+{
+  marley::Tracer::Span span( "DecayOnlyGenerator::decay_initial_state" );
+
+  auto& gen = *worker.gen;
+  const auto& mt = marley::MassTable::Instance();
+
+  size_t index = gen.sample_from_distribution( worker.state_dist );
+  const InitialState& is = initial_states_.at( index );
+
+  double Ex = is.Ex_min;
+  if ( is.Ex_max > is.Ex_min ) {
+    Ex = gen.uniform_random_double( is.Ex_min, is.Ex_max, true );
+  }
+  int twoJ = is.twoJ;
+  marley::Parity P = is.parity;
+
+  // Bound states must coincide with a discrete level. Use the closest one
+  // if level data are available for this nucleus.
+  auto* ds = gen.get_structure_db().get_decay_scheme( is.pdg );
+  if ( ds && Ex <= mt.unbound_threshold(is.pdg) ) {
+    const marley::Level* lev = ds->get_pointer_to_closest_level( Ex );
+    if ( lev ) {
+      Ex = lev->energy();
+      twoJ = lev->twoJ();
+      P = lev->parity();
+    }
+  }
+
+  // Use a neutral atom at rest for the excited nucleus
+  marley::Particle nucleus( is.pdg, mt.get_atomic_mass(is.pdg) + Ex, 0 );
+
+  marley::Event ev( marley::Particle(), nucleus, marley::Particle(), nucleus,
+    Ex, twoJ, P );
+
+  // Only the Hauser-Feshbach decay contributes to the systematic weights
+  ev.weights().assign( gen.get_universes().size(), 1. );
+
+  worker.decayer.process_event( ev, gen );
+
+  return ev;
+}
+
+void marley::DecayOnlyGenerator::run_worker( Worker& worker ) {
+  try {
+    while ( !stop_ ) {
+      marley::Tracer::begin_event();
+      marley::Event ev = this->decay_initial_state( worker );
+
+      std::unique_lock<std::mutex> lock( worker.mutex );
+      worker.cv.wait( lock, [this, &worker]() {
+        return stop_ || worker.queue.size() < MAX_QUEUED_EVENTS_; } );
+      if ( stop_ ) return;
+
+      worker.queue.push_back( std::move(ev) );
+      worker.cv.notify_all();
+    }
+  }
+  catch ( ... ) {
+    std::lock_guard<std::mutex> lock( worker.mutex );
+    worker.error = std::current_exception();
+    worker.cv.notify_all();
+  }
+}
+
+marley::Event marley::DecayOnlyGenerator::create_event() {
+
+  marley::Tracer::begin_event();
+
+  Worker& worker = *workers_.at( next_worker_ );
+  next_worker_ = ( next_worker_ + 1 ) % workers_.size();
+
+  marley::Event ev;
+  if ( !worker.thread.joinable() ) ev = this->decay_initial_state( worker );
+  else {
+    std::unique_lock<std::mutex> lock( worker.mutex );
+    worker.cv.wait( lock, [&worker]() {
+      return !worker.queue.empty() || worker.error; } );
+
+    // Report a failure only after the events that were finished before it
+    // have been handed out
+    if ( worker.queue.empty() ) std::rethrow_exception( worker.error );
+
+    ev = std::move( worker.queue.front() );
+    worker.queue.pop_front();
+    worker.cv.notify_all();
+  }
+
+  this->tally( ev );
+  return ev;
+}
+
+void marley::DecayOnlyGenerator::tally( const marley::Event& ev ) {
+
+  // Count the emitted nuclear fragments by PDG code. The first two final
+  // particles are the (dummy) ejectile and the residue.
+  std::map<int, int> fragments;
+  const auto& finals = ev.get_final_particles();
+  for ( size_t i = 2; i < finals.size(); ++i ) {
+    int pdg = finals.at( i )->pdg_code();
+    if ( pdg != marley_utils::PHOTON ) ++fragments[ pdg ];
+  }
+
+  std::string label;
+  for ( const auto& pair : fragments ) {
+    if ( pair.second > 1 ) label += std::to_string( pair.second );
+    auto iter = marley_utils::particle_symbols.find( pair.first );
+    if ( iter != marley_utils::particle_symbols.end() ) label += iter->second;
+    else label += std::to_string( pair.first );
+    label += " + ";
+  }
+  if ( fragments.empty() && finals.size() > 2 ) {
+    label += marley_utils::particle_symbols.at( marley_utils::PHOTON )
+      + " + ";
+  }
+  label += marley::TargetAtom( ev.residue().pdg_code() ).to_string();
+
+  ++channel_counts_[ label ];
+  ++event_count_;
+}
+
+void marley::DecayOnlyGenerator::print_branching_ratios(
+  std::ostream& out ) const
+{
+  // Sort the channels in order of decreasing frequency
+  std::vector< std::pair<std::string, long> > channels(
+    channel_counts_.cbegin(), channel_counts_.cend() );
+  std::stable_sort( channels.begin(), channels.end(),
+    []( const std::pair<std::string, long>& a,
+    const std::pair<std::string, long>& b ) { return a.second > b.second; } );
+
+  out << "Decay channel branching ratios (" << event_count_ << " events)";
+  for ( const auto& ch : channels ) {
+    double ratio = 0.;
+    if ( event_count_ > 0 ) ratio = static_cast<double>( ch.second )
+      / event_count_;
+    out << "\n  " << ch.first << ": " << ratio << " (" << ch.second << ')';
+  }
+}
@@ -14,13 +14,17 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
-#include <algorithm> // std::iter_swap
+#include <algorithm> // std::iter_swap, std::min
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <string>
+#include <utility>
 
 #include "marley/Error.hh"
 #include "marley/Event.hh"
+#include "marley/EventProjection.hh"
 #include "marley/JSON.hh"
 #include "marley/MassTable.hh"
 #include "marley/marley_utils.hh"
@@ -36,10 +40,18 @@ namespace {
   constexpr size_t EJECTILE_INDEX = 0u;
   constexpr size_t RESIDUE_INDEX = 1u;
 
+  // Number of systematic weights stored in each dummy particle of a HEPEVT
+  // record (one for each of the four-momentum components and the mass)
+  constexpr size_t HEPEVT_WEIGHTS_PER_LINE = 5u;
+
   // Conversion factor for converting GeV to MeV (the latter of which
   // is used in MARLEY natural units)
   constexpr double GEV_TO_MEV = 1000.;
 
+  // Conversion factor for expressing cross sections (fm^2) in pb, the unit
+  // used by HepMC3
+  constexpr double FM2_TO_PB = 1e10;
+
   // Helper function for Event::print_human_readable()
   void print_particle_info( std::ostream& out, const marley::Particle& p ) {
     out << "  particle with PDG code = " << p.pdg_code()
@@ -81,7 +93,9 @@ marley::Event::Event(const marley::Event& other_event)
   : initial_particles_(other_event.initial_particles_.size()),
   final_particles_(other_event.final_particles_.size()),
   Ex_(other_event.Ex_), twoJ_(other_event.twoJ_),
-  parity_(other_event.parity_)
+  parity_(other_event.parity_), weights_(other_event.weights_),
+  deexcitation_pending_(other_event.deexcitation_pending_),
+  deexcitation_seed_(other_event.deexcitation_seed_)
 {
   for (size_t i = 0; i < other_event.initial_particles_.size(); ++i) {
     initial_particles_[i] = new marley::Particle(
@@ -99,9 +113,13 @@ marley::Event::Event(marley::Event&& other_event)
   : initial_particles_(other_event.initial_particles_.size()),
   final_particles_(other_event.final_particles_.size()),
   Ex_(other_event.Ex_), twoJ_(other_event.twoJ_),
-  parity_(other_event.parity_)
+  parity_(other_event.parity_), weights_(std::move(other_event.weights_)),
+  deexcitation_pending_(other_event.deexcitation_pending_),
+  deexcitation_seed_(other_event.deexcitation_seed_)
 {
   other_event.Ex_ = 0.;
+  other_event.weights_.clear();
+  other_event.deexcitation_pending_ = false;
   for (size_t i = 0; i < other_event.initial_particles_.size(); ++i) {
     initial_particles_[i] = other_event.initial_particles_[i];
   }
@@ -117,6 +135,9 @@ marley::Event& marley::Event::operator=(const marley::Event& other_event) {
   Ex_ = other_event.Ex_;
   twoJ_ = other_event.twoJ_;
   parity_ = other_event.parity_;
+  weights_ = other_event.weights_;
+  deexcitation_pending_ = other_event.deexcitation_pending_;
+  deexcitation_seed_ = other_event.deexcitation_seed_;
 
   // Delete the old particle objects owned by this event
   this->delete_particles();
@@ -148,6 +169,14 @@ marley::Event& marley::Event::operator=(marley::Event&& other_event) {
   parity_ = other_event.parity_;
   other_event.parity_ = marley::Parity( true );
 
+  weights_ = std::move( other_event.weights_ );
+  other_event.weights_.clear();
+
+  deexcitation_pending_ = other_event.deexcitation_pending_;
+  other_event.deexcitation_pending_ = false;
+
+  deexcitation_seed_ = other_event.deexcitation_seed_;
+
   // Delete the old particle objects owned by this event
   this->delete_particles();
 
@@ -214,6 +243,8 @@ void marley::Event::clear() {
   Ex_ = 0.;
   twoJ_ = 0;
   parity_ = marley::Parity( true );
+  weights_.clear();
+  deexcitation_pending_ = false;
 }
 
 void marley::Event::delete_particles() {
@@ -312,12 +343,20 @@ void marley::Event::dump_hepevt_particle(const marley::Particle& p,
 
 void marley::Event::write_hepevt(size_t event_num, double flux_avg_tot_xsec,
   std::ostream& out) const
+{
+  this->write_hepevt( event_num, flux_avg_tot_xsec, out,
+    marley::EventProjection() );
+}
+
+void marley::Event::write_hepevt(size_t event_num, double flux_avg_tot_xsec,
+  std::ostream& out, const marley::EventProjection& proj) const
 {
   // Use an temporary ostringstream object so that we can ensure all
-  // floating-point values are output with full precision without disturbing
-  // the user's settings in the "out" stream.
+  // floating-point values are output with full precision (or the reduced
+  // precision requested by the projection) without disturbing the user's
+  // settings in the "out" stream.
   std::ostringstream temp;
-  temp.precision( std::numeric_limits<double>::max_digits10 );
+  temp.precision( proj.digits() );
   temp << std::scientific;
 
   // Create a dummy particle that encodes extra MARLEY-specific information in
@@ -346,6 +385,11 @@ void marley::Event::write_hepevt(size_t event_num, double flux_avg_tot_xsec,
   dump_hepevt_particle( dummy_particle, temp, HEPEVT_MARLEY_INFO_STATUS_CODE,
     twoJ_, static_cast<int>(parity_) );
 
+  // The systematic weights are not written. Programs that read HEPEVT
+  // records (e.g., Geant4's G4HEPEvtInterface) treat every entry counted in
+  // the header as a particle, so further dummy entries would be mistaken for
+  // real ones.
+
   // Write the final particles to the event record
   for (const auto f : final_particles_) dump_hepevt_particle(*f, temp,
     HEPEVT_FINAL_STATE_STATUS_CODE);
@@ -363,6 +407,11 @@ marley::JSON marley::Event::to_json() const {
   event["initial_particles"] = marley::JSON::array();
   event["final_particles"] = marley::JSON::array();
 
+  if ( !weights_.empty() ) {
+    event["weights"] = marley::JSON::array();
+    for ( double w : weights_ ) event.at("weights").append( w );
+  }
+
   for (const auto ip : initial_particles_)
     event.at("initial_particles").append(ip->to_json());
 
@@ -372,6 +421,155 @@ marley::JSON marley::Event::to_json() const {
   return event;
 }
 
+marley::JSON marley::Event::to_json(const marley::EventProjection& proj)
+  const
+{
+  using Field = marley::EventProjection::Field;
+
+  marley::JSON event = marley::JSON::object();
+
+  if ( proj.has(Field::Ex) ) event["Ex"] = Ex_;
+  if ( proj.has(Field::twoJ) ) event["twoJ"] = twoJ_;
+  if ( proj.has(Field::parity) ) event["parity"] = static_cast<int>( parity_ );
+
+  if ( !weights_.empty() ) {
+    event["weights"] = marley::JSON::array();
+    for ( double w : weights_ ) event.at("weights").append( w );
+  }
+
+  if ( proj.initial_particles() ) {
+    event["initial_particles"] = marley::JSON::array();
+    for (const auto ip : initial_particles_)
+      event.at("initial_particles").append(ip->to_json(proj));
+  }
+
+  event["final_particles"] = marley::JSON::array();
+  for (const auto fp : final_particles_)
+    event.at("final_particles").append(fp->to_json(proj));
+
+  return event;
+}
+
+void marley::Event::print(std::ostream& out,
+  const marley::EventProjection& proj) const
+{
+  using Field = marley::EventProjection::Field;
+
+  if ( proj.is_complete() ) {
+    this->print( out );
+    return;
+  }
+
+  // See the comments in print(std::ostream&)
+  std::ostringstream temp;
+  temp << std::scientific;
+  temp.precision( proj.digits() );
+
+  // The initial particle count is written as zero if they are omitted
+  size_t num_initial = proj.initial_particles()
+    ? initial_particles_.size() : 0u;
+
+  temp << num_initial << ' ' << final_particles_.size();
+  if ( proj.has(Field::Ex) ) proj.print_value( temp, Ex_ );
+  if ( proj.has(Field::twoJ) ) temp << ' ' << twoJ_;
+  if ( proj.has(Field::parity) ) temp << ' ' << parity_;
+
+  // The systematic weights (if any) are appended to the header line
+  size_t num_weights = proj.weight_names().size();
+  if ( num_weights > 0u && num_weights != weights_.size() ) {
+    throw marley::Error("Cannot print an event with "
+      + std::to_string(weights_.size()) + " systematic weights using a"
+      " projection that expects " + std::to_string(num_weights));
+  }
+  for ( size_t w = 0u; w < num_weights; ++w ) {
+    proj.print_value( temp, weights_[w] );
+  }
+  temp << '\n';
+
+  if ( proj.initial_particles() ) {
+    for (const auto i : initial_particles_) {
+      i->print( temp, proj );
+      temp << '\n';
+    }
+  }
+  for (const auto f : final_particles_) {
+    f->print( temp, proj );
+    temp << '\n';
+  }
+
+  out << temp.str();
+}
+
+void marley::Event::read(std::istream& in,
+  const marley::EventProjection& proj)
+{
+  using Field = marley::EventProjection::Field;
+
+  // Reduced precision doesn't change the layout of the event record
+  size_t num_weights = proj.weight_names().size();
+  if ( !proj.drops_fields() && num_weights == 0u ) {
+    this->read( in );
+    return;
+  }
+
+  this->clear();
+
+  int num_initial;
+  int num_final;
+
+  in >> num_initial >> num_final;
+  if ( proj.has(Field::Ex) ) in >> Ex_;
+  if ( proj.has(Field::twoJ) ) in >> twoJ_;
+  if ( proj.has(Field::parity) ) in >> parity_;
+
+  weights_.resize( num_weights );
+  for ( auto& w : weights_ ) in >> w;
+
+  // If reading the event header line failed for some
+  // reason, just return without trying to do anything else.
+  if ( !in ) return;
+
+  // Check the particle counts as in read(std::istream&). If the initial
+  // particles were omitted, then none should be present.
+  int min_initial = proj.initial_particles() ? 2 : 0;
+  if ( num_initial < min_initial || static_cast<size_t>(num_initial)
+    > initial_particles_.max_size()
+    || (!proj.initial_particles() && num_initial != 0) )
+  {
+    throw marley::Error("Invalid number of initial state particles ("
+      + std::to_string(num_initial) + ") encountered in marley::Event::read()");
+  }
+  else if ( num_final < 2 || static_cast<size_t>(num_final)
+    > final_particles_.max_size() )
+  {
+    throw marley::Error("Invalid number of final state particles ("
+      + std::to_string(num_final) + ") encountered in marley::Event::read()");
+  }
+
+  for (int i = 0; i < num_initial; ++i) {
+    marley::Particle* p = new marley::Particle;
+    p->read( in, proj );
+    initial_particles_.push_back( p );
+    if ( !in ) throw marley::Error("Parse error while reading initial"
+      " particle #" + std::to_string(i) + " from an ASCII-format event"
+      " record");
+  }
+  for (int f = 0; f < num_final; ++f) {
+    marley::Particle* p = new marley::Particle;
+    p->read( in, proj );
+    final_particles_.push_back( p );
+    if ( !in ) throw marley::Error("Parse error while reading final"
+      " particle #" + std::to_string(f) + " from an ASCII-format event"
+      " record");
+  }
+
+  // Use dummy initial particles if they were omitted
+  if ( !proj.initial_particles() ) {
+    initial_particles_.push_back( new marley::Particle );
+    initial_particles_.push_back( new marley::Particle );
+  }
+}
+
 // Reconstructs a marley::Event object from an input HEPEVT-format event record
 // in an input stream. Returns a boolean that reflects whether the input stream
 // state was still good at the end of the attempt to read the HEPEVT record.
@@ -388,22 +586,6 @@ bool marley::Event::read_hepevt(std::istream& in, double* flux_avg_tot_xsec)
   // Remove any pre-existing contents in this event
   this->clear();
 
-  // Check that the event contains exactly two initial-state particles
-  size_t initial_state_particles = 0u;
-  // Check that one of the initial-state particles is an atom (ion)
-  size_t initial_state_ions = 0u;
-  // Check that the event contains exactly one final-state lepton
-  size_t final_state_leptons = 0u;
-  // Check that the event contains at least one final-state ion
-  size_t final_state_ions = 0u;
-
-  // Initial indices of the final lepton and largest final ion (as judged
-  // by the mass number A) in the final_particles_
-  // vector. These will be used below to move them into the correct order.
-  size_t final_lepton_idx = 0u;
-  size_t largest_final_ion_idx = 0u;
-  int largest_A = 0;
-
   int event_num; // HEPEVT event number (ignored)
   int num_particles; // Total number of particles stored in the event
   in >> event_num  >> num_particles;
@@ -467,6 +649,28 @@ bool marley::Event::read_hepevt(std::istream& in, double* flux_avg_tot_xsec)
       parity_ = jmohep2;
     }
 
+    // Dummy particles with this status code store some of the systematic
+    // weights for the event
+    if ( status_code == HEPEVT_MARLEY_WEIGHTS_STATUS_CODE ) {
+      if ( jmohep1 < 0 || jmohep2 < 0 || static_cast<size_t>(jmohep2)
+        > HEPEVT_WEIGHTS_PER_LINE ) throw marley::Error("Invalid systematic"
+        " weight indices encountered while reading a HEPEVT-format event"
+        " record");
+
+      // Each line holds at most HEPEVT_WEIGHTS_PER_LINE weights, so the
+      // indices cannot exceed the number allowed by the particle count
+      double values[] = { px, py, pz, Etot, M };
+      size_t first = jmohep1;
+      size_t count = jmohep2;
+      if ( first + count > HEPEVT_WEIGHTS_PER_LINE * num_particles ) {
+        throw marley::Error("Systematic weight index " + std::to_string(first)
+          + " is out of range for a HEPEVT-format event record with "
+          + std::to_string(num_particles) + " particles");
+      }
+      if ( weights_.size() < first + count ) weights_.resize( first + count );
+      for ( size_t w = 0u; w < count; ++w ) weights_[first + w] = values[w];
+    }
+
     // If the particle has a status code other than the two used by
     // MARLEY, then don't bother to record the particle in the event object
     if ( status_code != HEPEVT_INITIAL_STATE_STATUS_CODE
@@ -483,43 +687,75 @@ bool marley::Event::read_hepevt(std::istream& in, double* flux_avg_tot_xsec)
     // We already checked that the particle has a status code recognized
     // by MARLEY above, so store it in the event object in the appropriate
     // place.
+    auto* particle = new marley::Particle( pdg, Etot, px, py, pz, M );
     if ( status_code == HEPEVT_INITIAL_STATE_STATUS_CODE ) {
-      initial_particles_.push_back(
-        new marley::Particle(pdg, Etot, px, py, pz, M) );
-      ++initial_state_particles;
-      if ( marley_utils::is_ion(pdg) ) ++initial_state_ions;
+      initial_particles_.push_back( particle );
     }
-    else {
-      // status_code == HEPEVT_FINAL_STATE_STATUS_CODE
-      final_particles_.push_back(
-        new marley::Particle(pdg, Etot, px, py, pz, M) );
-      if ( marley_utils::is_lepton(pdg) ) {
-        ++final_state_leptons;
-        final_lepton_idx = final_particles_.size() - 1;
-      }
-      if ( marley_utils::is_ion(pdg) ) {
-        ++final_state_ions;
-        // Update the index of the largest final ion
-        int A = marley_utils::get_particle_A( pdg ); // mass number
-        if ( A > largest_A ) {
-          largest_A = A;
-          largest_final_ion_idx = final_particles_.size() - 1;
-        }
+    else final_particles_.push_back( particle );
+  }
+
+  this->finish_reading_record( "HEPEVT" );
+
+  // Everything was read in successfully. We're done!
+  return true;
+}
+
+void marley::Event::finish_reading_record(const std::string& format) {
+
+  // Check that the event contains exactly two initial-state particles
+  size_t initial_state_particles = initial_particles_.size();
+  // Check that one of the initial-state particles is an atom (ion)
+  size_t initial_state_ions = 0u;
+  // Check that the event contains exactly one final-state lepton
+  size_t final_state_leptons = 0u;
+  // Check that the event contains at least one final-state ion
+  size_t final_state_ions = 0u;
+
+  for ( const auto* ip : initial_particles_ ) {
+    if ( marley_utils::is_ion(ip->pdg_code()) ) ++initial_state_ions;
+  }
+
+  // Initial indices of the final lepton and largest final ion (as judged
+  // by the mass number A) in the final_particles_
+  // vector. These will be used below to move them into the correct order.
+  size_t final_lepton_idx = 0u;
+  size_t largest_final_ion_idx = 0u;
+  int largest_A = 0;
+
+  for ( size_t f = 0u; f < final_particles_.size(); ++f ) {
+    int pdg = final_particles_.at( f )->pdg_code();
+    if ( marley_utils::is_lepton(pdg) ) {
+      ++final_state_leptons;
+      final_lepton_idx = f;
+    }
+    if ( marley_utils::is_ion(pdg) ) {
+      ++final_state_ions;
+      // Update the index of the largest final ion
+      int A = marley_utils::get_particle_A( pdg ); // mass number
+      if ( A > largest_A ) {
+        largest_A = A;
+        largest_final_ion_idx = f;
       }
     }
   }
 
+  // Elastic scattering on atomic electrons involves no ions. The
+  // particles of these events are already stored in the expected order,
+  // and their charges are those of the bare particles.
+  if ( initial_state_particles == 2u && initial_state_ions == 0u
+    && final_state_ions == 0u && final_particles_.size() >= 2u ) return;
+
   // Check that the event satisfies the criteria needed for a reasonable
   // marley::Event
   if ( initial_state_particles != 2u ) throw marley::Error(
     std::to_string(initial_state_particles) + " initial-state particles"
-    " encountered while reading HEPEVT input");
+    " encountered while reading " + format + " input");
   else if ( initial_state_ions != 1u ) throw marley::Error("Multiple"
-    " initial-state ions encountered while reading HEPEVT input");
+    " initial-state ions encountered while reading " + format + " input");
   else if ( final_state_leptons != 1u ) throw marley::Error("Multiple"
-    " final-state leptons encountered while reading HEPEVT input");
+    " final-state leptons encountered while reading " + format + " input");
   else if ( final_state_ions < 1u ) throw marley::Error("Zero"
-    " final-state ions encountered while reading HEPEVT input");
+    " final-state ions encountered while reading " + format + " input");
 
   // Reorder (if needed) the initial particle list to ensure that the target
   // (the initial atom) appears in the correct position. This is required
@@ -566,57 +802,273 @@ bool marley::Event::read_hepevt(std::istream& in, double* flux_avg_tot_xsec)
     if ( marley_utils::is_ion(pdg_f) ) sum_Q_final_ions += fp->charge();
   }
   this->residue().set_charge( Qf_ion - sum_Q_final_ions );
+}
+
+void marley::Event::write_hepmc3(size_t event_num, double flux_avg_tot_xsec,
+  std::ostream& out, const marley::EventProjection& proj) const
+{
+  // As in write_hepevt(), build the record in a temporary stream so that the
+  // precision settings of "out" are left alone and the record is written
+  // using a single call
+  std::ostringstream temp;
+  temp.precision( proj.digits() );
+  temp << std::scientific;
+
+  // A single vertex joins the initial particles to the final ones
+  size_t num_particles = initial_particles_.size() + final_particles_.size();
+  temp << "E " << event_num << " 1 " << num_particles << '\n';
+  temp << "U GEV MM\n";
+
+  // The nominal weight (one) comes first, followed by the systematic
+  // weights (see write_flux_avg_tot_xsec() in marley::TextOutputFile)
+  if ( !weights_.empty() ) {
+    temp << "W 1";
+    for ( double w : weights_ ) temp << ' ' << w;
+    temp << '\n';
+  }
+
+  // HepMC3 expects the cross section in pb. The accepted and attempted
+  // event counts are unknown.
+  temp << "A 0 GenCrossSection " << flux_avg_tot_xsec * marley_utils::hbar_c2
+    * FM2_TO_PB << " 0 -1 -1\n";
+
+  // Store the residue properties that cannot be recovered from the
+  // particle four-momenta
+  temp << "A 0 Ex " << Ex_ << '\n';
+  temp << "A 0 twoJ " << twoJ_ << '\n';
+  temp << "A 0 parity " << static_cast<int>( parity_ ) << '\n';
+
+  // Particles are numbered starting from one. Initial particles have no
+  // production vertex (0), while the final particles come from vertex -1.
+  int id = 0;
+  auto write_particle = [&temp, &id]( const marley::Particle& p,
+    int vertex, int status )
+  {
+    temp << "P " << ++id << ' ' << vertex << ' ' << p.pdg_code() << ' '
+      << p.px() / GEV_TO_MEV << ' ' << p.py() / GEV_TO_MEV << ' '
+      << p.pz() / GEV_TO_MEV << ' ' << p.total_energy() / GEV_TO_MEV << ' '
+      << p.mass() / GEV_TO_MEV << ' ' << status << '\n';
+  };
+
+  for ( const auto i : initial_particles_ ) write_particle( *i, 0,
+    HEPEVT_INITIAL_STATE_STATUS_CODE );
+
+  // The vertex lists its incoming particles. It is placed at the origin, so
+  // no position is written.
+  temp << "V -1 0 [";
+  for ( size_t i = 1u; i <= initial_particles_.size(); ++i ) {
+    if ( i > 1u ) temp << ',';
+    temp << i;
+  }
+  temp << "]\n";
+
+  for ( const auto f : final_particles_ ) write_particle( *f, -1,
+    HEPEVT_FINAL_STATE_STATUS_CODE );
+
+  out << temp.str();
+}
+
+bool marley::Event::read_hepmc3(std::istream& in, double* flux_avg_tot_xsec)
+{
+  // Remove any pre-existing contents in this event
+  this->clear();
+
+  // Skip the header lines (and anything else) that appear before the next
+  // event record
+  std::string line;
+  bool found_event = false;
+  while ( std::getline(in, line) ) {
+    if ( line.compare(0, 2, "E ") == 0 ) {
+      found_event = true;
+      break;
+    }
+  }
+  if ( !found_event ) return false;
+
+  long event_num; // HepMC3 event number (ignored)
+  int num_vertices, num_particles;
+  std::istringstream event_line( line.substr(2) );
+  event_line >> event_num >> num_vertices >> num_particles;
+  if ( !event_line || num_vertices < 0 || num_particles < 0 ) {
+    throw marley::Error("Invalid event line \"" + line + "\" encountered"
+      " while reading HepMC3 input");
+  }
+
+  // Factor that converts the momentum units used in the file to MeV
+  double momentum_unit = GEV_TO_MEV;
+
+  // Any attribute lines precede the vertices and particles, so the record
+  // ends once all of them have been read
+  int vertices_read = 0;
+  int particles_read = 0;
+  while ( vertices_read < num_vertices || particles_read < num_particles ) {
+
+    if ( !std::getline(in, line) ) throw marley::Error("Unexpected end of"
+      " input encountered while reading HepMC3 event "
+      + std::to_string(event_num));
+
+    std::istringstream line_in( line );
+    char type = '\0';
+    line_in >> type;
+
+    if ( type == 'U' ) {
+      std::string momentum_unit_name;
+      line_in >> momentum_unit_name;
+      if ( momentum_unit_name == "GEV" ) momentum_unit = GEV_TO_MEV;
+      else if ( momentum_unit_name == "MEV" ) momentum_unit = 1.;
+      else throw marley::Error("Unrecognized momentum unit \""
+        + momentum_unit_name + "\" encountered while reading HepMC3"
+        " input");
+    }
+    else if ( type == 'A' ) {
+      // Only event attributes (with an id of zero) are used
+      int id;
+      std::string name;
+      line_in >> id >> name;
+      if ( id != 0 ) continue;
+
+      if ( name == "Ex" ) line_in >> Ex_;
+      else if ( name == "twoJ" ) line_in >> twoJ_;
+      else if ( name == "parity" ) {
+        int parity;
+        line_in >> parity;
+        parity_ = parity;
+      }
+      else if ( name == "GenCrossSection" && flux_avg_tot_xsec ) {
+        double xsec_pb;
+        line_in >> xsec_pb;
+        *flux_avg_tot_xsec = xsec_pb / FM2_TO_PB / marley_utils::hbar_c2;
+      }
+      if ( !line_in ) throw marley::Error("Invalid attribute line \""
+        + line + "\" encountered while reading HepMC3 input");
+    }
+    else if ( type == 'W' ) {
+      // Skip the nominal weight. Any others are systematic weights.
+      double nominal;
+      line_in >> nominal;
+      double w;
+      while ( line_in >> w ) weights_.push_back( w );
+    }
+    else if ( type == 'V' ) ++vertices_read;
+    else if ( type == 'P' ) {
+      int id, parent, pdg, status_code;
+      double px, py, pz, Etot, M;
+      line_in >> id >> parent >> pdg >> px >> py >> pz >> Etot >> M
+        >> status_code;
+      if ( !line_in ) throw marley::Error("Parse error while reading"
+        " particle #" + std::to_string(particles_read) + " from a"
+        " HepMC3-format event record");
+      ++particles_read;
+
+      // Use the same status codes as for the HEPEVT format
+      if ( status_code != HEPEVT_INITIAL_STATE_STATUS_CODE
+        && status_code != HEPEVT_FINAL_STATE_STATUS_CODE ) continue;
+
+      auto* particle = new marley::Particle( pdg, Etot * momentum_unit,
+        px * momentum_unit, py * momentum_unit, pz * momentum_unit,
+        M * momentum_unit );
+      if ( status_code == HEPEVT_INITIAL_STATE_STATUS_CODE ) {
+        initial_particles_.push_back( particle );
+      }
+      else final_particles_.push_back( particle );
+    }
+  }
+
+  this->finish_reading_record( "HepMC3" );
 
-  // Everything was read in successfully. We're done!
   return true;
 }
 
 void marley::Event::from_json(const marley::JSON& json) {
+  // The default projection keeps every field, so all keys are required
+  this->from_json( json, marley::EventProjection() );
+}
+
+void marley::Event::from_json(const marley::JSON& json,
+  const marley::EventProjection& proj)
+{
+  using Field = marley::EventProjection::Field;
 
   // TODO: reduce code duplication in this function
 
   // Remove any existing contents from this event
   this->clear();
 
-  if ( !json.has_key("Ex") ) throw marley::Error("Missing"
-    " nuclear excitation energy key in input JSON-format event");
-
+  // The Ex, twoJ, parity, and initial_particles keys may only be missing if
+  // they were omitted by the EventProjection. If so, keep the default values
+  // set by clear().
   bool ok = false;
-  const auto& temp_Ex = json.at("Ex");
-  Ex_ = temp_Ex.to_double( ok );
-  if ( !ok ) throw marley::Error("Invalid nuclear excitation energy"
-    + temp_Ex.to_string() + " encountered in input JSON-format event");
-
-  if ( !json.has_key("twoJ") ) throw marley::Error("Missing"
-    " twoJ key in input JSON-format event");
-
-  ok = false;
-  const auto& temp_twoJ = json.at("twoJ");
-  twoJ_ = temp_twoJ.to_long( ok );
-  if ( !ok ) throw marley::Error("Invalid \"twoJ\" value"
-    + temp_twoJ.to_string() + " encountered in input JSON-format event");
-
-  ok = false;
-  const auto& temp_parity = json.at("parity");
-  parity_ = temp_parity.to_long( ok );
-  if ( !ok ) throw marley::Error("Invalid parity value"
-    + temp_parity.to_string() + " encountered in input JSON-format event");
-
-  // Retrieve and load the array of initial particles
-  if ( !json.has_key("initial_particles") ) throw marley::Error("Missing"
-    " initial particle array in input JSON-format event");
-
-  const auto& temp_ip = json.at("initial_particles");
-  if ( !temp_ip.is_array() ) throw marley::Error("Invalid initial"
-    " particle array " + temp_ip.to_string() + " encountered in input"
-    " JSON-format event");
+  if ( proj.has(Field::Ex) || json.has_key("Ex") ) {
+    if ( !json.has_key("Ex") ) throw marley::Error("Missing"
+      " nuclear excitation energy key in input JSON-format event");
+
+    const auto& temp_Ex = json.at("Ex");
+    Ex_ = temp_Ex.to_double( ok );
+    if ( !ok ) throw marley::Error("Invalid nuclear excitation energy"
+      + temp_Ex.to_string() + " encountered in input JSON-format event");
+  }
 
-  for ( const auto& p_object : temp_ip.array_range() ) {
-    if ( !p_object.is_object() ) throw marley::Error("Invalid particle"
-      " object " + p_object.to_string() + " encountered while parsing a"
-      " JSON-format particle array");
+  if ( proj.has(Field::twoJ) || json.has_key("twoJ") ) {
+    if ( !json.has_key("twoJ") ) throw marley::Error("Missing"
+      " twoJ key in input JSON-format event");
+
+    ok = false;
+    const auto& temp_twoJ = json.at("twoJ");
+    twoJ_ = temp_twoJ.to_long( ok );
+    if ( !ok ) throw marley::Error("Invalid \"twoJ\" value"
+      + temp_twoJ.to_string() + " encountered in input JSON-format event");
+  }
+
+  if ( proj.has(Field::parity) || json.has_key("parity") ) {
+    if ( !json.has_key("parity") ) throw marley::Error("Missing"
+      " parity key in input JSON-format event");
+
+    ok = false;
+    const auto& temp_parity = json.at("parity");
+    parity_ = temp_parity.to_long( ok );
+    if ( !ok ) throw marley::Error("Invalid parity value"
+      + temp_parity.to_string() + " encountered in input JSON-format event");
+  }
+
+  // Systematic weights are only present if universes were configured
+  if ( json.has_key("weights") ) {
+    const auto& temp_w = json.at("weights");
+    if ( !temp_w.is_array() ) throw marley::Error("Invalid systematic"
+      " weight array " + temp_w.dump_string() + " encountered in input"
+      " JSON-format event");
+
+    for ( const auto& w : temp_w.array_range() ) {
+      ok = false;
+      weights_.push_back( w.to_double(ok) );
+      if ( !ok ) throw marley::Error("Invalid systematic weight "
+        + w.dump_string() + " encountered in input JSON-format event");
+    }
+  }
+  else if ( !proj.weight_names().empty() ) throw marley::Error("Missing"
+    " systematic weight array in input JSON-format event");
+
+  // Retrieve and load the array of initial particles. Use dummy particles
+  // if the projection omitted it.
+  if ( !json.has_key("initial_particles") ) {
+    if ( proj.initial_particles() ) throw marley::Error("Missing"
+      " initial particle array in input JSON-format event");
+
+    initial_particles_.push_back( new marley::Particle );
     initial_particles_.push_back( new marley::Particle );
-    initial_particles_.back()->from_json( p_object );
+  }
+  else {
+    const auto& temp_ip = json.at("initial_particles");
+    if ( !temp_ip.is_array() ) throw marley::Error("Invalid initial"
+      " particle array " + temp_ip.to_string() + " encountered in input"
+      " JSON-format event");
+
+    for ( const auto& p_object : temp_ip.array_range() ) {
+      if ( !p_object.is_object() ) throw marley::Error("Invalid particle"
+        " object " + p_object.to_string() + " encountered while parsing a"
+        " JSON-format particle array");
+      initial_particles_.push_back( new marley::Particle );
+      initial_particles_.back()->from_json( p_object, proj );
+    }
   }
 
   // Retrieve and load the array of final particles
@@ -633,7 +1085,7 @@ void marley::Event::from_json(const marley::JSON& json) {
       " object " + p_object.to_string() + " encountered while parsing a"
       " JSON-format particle array");
     final_particles_.push_back( new marley::Particle );
-    final_particles_.back()->from_json( p_object );
+    final_particles_.back()->from_json( p_object, proj );
   }
 
 }
@@ -653,6 +1105,12 @@ void marley::Event::print_human_readable(std::ostream& out, int num) const {
   else out << twoJ / 2;
   out << this->parity() << '\n';
 
+  if ( !weights_.empty() ) {
+    out << "Systematic weights:";
+    for ( double w : weights_ ) out << ' ' << w;
+    out << '\n';
+  }
+
   out << "Initial particles" << '\n';
   marley::Particle* p = NULL;
   for (size_t i = 0u; i < this->get_initial_particles().size(); ++i) {
@@ -22,9 +22,11 @@
 #include "marley/Event.hh"
 #include "marley/FileManager.hh"
 #include "marley/EventFileReader.hh"
+#include "marley/Generator.hh"
+#include "marley/JSONConfig.hh"
 
 marley::EventFileReader::EventFileReader(
-  const std::string& file_name) : file_name_(file_name),
+  const std::string& file_name) : file_name_(file_name), in_(nullptr),
   json_event_array_(),
   json_event_array_wrapper_( json_event_array_.array_range() ),
   json_event_iter_( json_event_array_wrapper_.end() )
@@ -56,7 +58,7 @@ bool marley::EventFileReader::deduce_file_format() {
 
   // If the first character in the file is '{', then
   // assume that the file is a JSON output file
-  in_.open( file_name_ );
+  this->open_input();
   char temp_char;
   if ( in_ >> temp_char && temp_char == '{' ) {
     format_ = marley::OutputFile::Format::JSON;
@@ -66,15 +68,44 @@ bool marley::EventFileReader::deduce_file_format() {
     return true;
   }
 
+  // HepMC3 ASCII files begin with a line that identifies the format
+  in_.clear();
+  in_.seekg(0);
+  std::string first_line;
+  if ( std::getline(in_, first_line)
+    && first_line.compare(0, 7, "HepMC::") == 0 )
+  {
+    format_ = marley::OutputFile::Format::HEPMC3;
+    marley::Error::set_logging_status( log_marley_errors );
+    in_.seekg(0);
+    return true;
+  }
+
+  // ASCII-format files written using a marley::EventProjection begin with
+  // a header line that starts with '#' and describes the projection
+  in_.clear();
+  in_.seekg(0);
+  ascii_start_ = 0;
+  if ( in_ >> temp_char && temp_char == '#' ) {
+    std::string header;
+    std::getline( in_, header );
+    try {
+      projection_ = marley::EventProjection( marley::JSON::load(header) );
+      ascii_start_ = in_.tellg();
+    }
+    catch (const marley::Error&) { }
+  }
+
   // If we can read in a marley::Event from the file via the input stream
   // operator, then assume that the file is in ASCII format
   // Reopen the file to reset the state flags and the stream cursor position
   in_.clear();
-  in_.seekg(0);
+  in_.seekg(ascii_start_);
   try {
-    if ( in_ >> flux_avg_tot_xs_ >> temp_event ) {
+    if ( in_ >> flux_avg_tot_xs_ ) temp_event.read( in_, projection_ );
+    if ( in_ ) {
       format_ = marley::OutputFile::Format::ASCII;
-      in_.seekg(0);
+      in_.seekg(ascii_start_);
       return true;
     }
   }
@@ -117,6 +148,25 @@ void marley::EventFileReader::initialize() {
       // No further preparation is needed to read the HEPEVT format
       break;
 
+    case marley::OutputFile::Format::HEPMC3: {
+      // Files written by MARLEY store the flux-averaged total cross section
+      // in natural units as a run attribute in the header. Read it, then
+      // return to the start of the first event record.
+      std::string line;
+      std::streampos event_start = in_.tellg();
+      while ( std::getline(in_, line) && line.compare(0, 2, "E ") != 0 ) {
+        const std::string key = "A flux_avg_xsec ";
+        if ( line.compare(0, key.size(), key) == 0 ) {
+          flux_avg_tot_xs_ = std::stod( line.substr(key.size()) );
+          hepmc3_run_xsec_ = true;
+        }
+        event_start = in_.tellg();
+      }
+      in_.clear();
+      in_.seekg( event_start );
+      break;
+    }
+
     case marley::OutputFile::Format::JSON: {
 
       // Turn off auto-logging of marley::Error objects so that
@@ -124,19 +174,40 @@ void marley::EventFileReader::initialize() {
       bool log_marley_errors = marley::Error::logging_status();
       marley::Error::set_logging_status( false );
 
+      marley::JSON virtual_info;
       try {
         auto json = marley::JSON::load( in_ );
 
-        flux_avg_tot_xs_ = json.at("gen_state").at("flux_avg_xsec")
-          .to_double();
-
-        json_event_array_ = json.at("events");
-        json_event_array_wrapper_ = json_event_array_.array_range();
-        json_event_iter_ = json_event_array_wrapper_.begin();
-        // Move the iterator to "one before the beginning" so that
-        // we get the correct behavior in next_event() and
-        // operator bool()
-        --json_event_iter_;
+        // Virtual event files are handled after parsing is complete (see
+        // below)
+        if ( json.has_key("virtual") ) {
+          virtual_info = json.at( "virtual" );
+          flux_avg_tot_xs_ = virtual_info.at( "flux_avg_xsec" ).to_double();
+          if ( virtual_info.has_key("summary") ) {
+            summary_ = virtual_info.at( "summary" );
+          }
+        }
+        // The manifest for a sharded output file lists the files that
+        // contain the events
+        else if ( json.has_key("manifest") ) {
+          this->load_manifest( json.at("manifest") );
+        }
+        else {
+          const auto& gen_state = json.at("gen_state");
+          flux_avg_tot_xs_ = gen_state.at("flux_avg_xsec").to_double();
+          if ( gen_state.has_key("projection") ) {
+            projection_ = marley::EventProjection(
+              gen_state.at("projection") );
+          }
+
+          json_event_array_ = json.at("events");
+          json_event_array_wrapper_ = json_event_array_.array_range();
+          json_event_iter_ = json_event_array_wrapper_.begin();
+          // Move the iterator to "one before the beginning" so that
+          // we get the correct behavior in next_event() and
+          // operator bool()
+          --json_event_iter_;
+        }
       }
       catch (const std::exception& err) {
         // Rethrow the error after adding commentary
@@ -148,6 +219,15 @@ void marley::EventFileReader::initialize() {
       // Restore the previous marley::Error logging behavior now that
       // we're done with our mischief
       marley::Error::set_logging_status( log_marley_errors );
+
+      // Virtual event files store the information needed to regenerate
+      // the events rather than the events themselves
+      if ( !virtual_info.is_null() ) {
+        format_ = marley::OutputFile::Format::VIRTUAL;
+        regenerator_ = std::make_unique<marley::EventRegenerator>(
+          virtual_info, [this]( const marley::JSON& config )
+          { return this->create_generator( config ); }, num_threads_ );
+      }
       break;
     }
 
@@ -170,7 +250,7 @@ bool marley::EventFileReader::next_event( marley::Event& ev )
       break;
 
     case marley::OutputFile::Format::ASCII:
-      in_ >> ev;
+      ev.read( in_, projection_ );
       if ( in_ ) return true;
       break;
 
@@ -178,14 +258,29 @@ bool marley::EventFileReader::next_event( marley::Event& ev )
       if ( ev.read_hepevt(in_, &flux_avg_tot_xs_) ) return true;
       break;
 
+    case marley::OutputFile::Format::HEPMC3:
+      // Prefer the exact value from the header when it is available
+      if ( ev.read_hepmc3(in_, hepmc3_run_xsec_ ? nullptr
+        : &flux_avg_tot_xs_) ) return true;
+      break;
+
     case marley::OutputFile::Format::JSON:
+      if ( !shards_.empty() ) {
+        if ( this->next_shard_event(ev) ) return true;
+        shards_done_ = true;
+        break;
+      }
       ++json_event_iter_;
       if ( json_event_iter_ != json_event_array_wrapper_.end() ) {
-        ev.from_json( *json_event_iter_ );
+        ev.from_json( *json_event_iter_, projection_ );
         return true;
       }
       break;
 
+    case marley::OutputFile::Format::VIRTUAL:
+      if ( regenerator_->next_event(ev) ) return true;
+      break;
+
     default:
       throw marley::Error("Unrecognized file format encountered in"
         " marley::EventFileReader::next_event()");
@@ -205,13 +300,19 @@ marley::EventFileReader::operator bool() const {
 
     case marley::OutputFile::Format::ASCII:
     case marley::OutputFile::Format::HEPEVT:
+    case marley::OutputFile::Format::HEPMC3:
       return static_cast<bool>( in_ );
       break;
 
     case marley::OutputFile::Format::JSON:
+      if ( !shards_.empty() ) return !shards_done_;
       return ( json_event_iter_ != json_event_array_wrapper_.end() );
       break;
 
+    case marley::OutputFile::Format::VIRTUAL:
+      return regenerator_ && regenerator_->good();
+      break;
+
     default:
       throw marley::Error("Unrecognized file format encountered in"
         " marley::EventFileReader::operator bool()");
@@ -220,6 +321,87 @@ marley::EventFileReader::operator bool() const {
   return false;
 }
 
+void marley::EventFileReader::open_input() {
+  if ( marley::GzipInputBuffer::is_gzip_file(file_name_) ) {
+    gzip_buf_ = std::make_unique<marley::GzipInputBuffer>( file_name_ );
+    in_.rdbuf( gzip_buf_.get() );
+  }
+  else {
+    file_buf_.open( file_name_, std::ios::in );
+    in_.rdbuf( &file_buf_ );
+  }
+}
+
+void marley::EventFileReader::load_manifest(const marley::JSON& manifest)
+{
+  // Relative shard file names are interpreted with respect to the directory
+  // that contains the manifest
+  std::string dir;
+  size_t slash_pos = file_name_.find_last_of('/');
+  if ( slash_pos != std::string::npos ) {
+    dir = file_name_.substr( 0, slash_pos + 1 );
+  }
+
+  flux_avg_tot_xs_ = manifest.at("flux_avg_xsec").to_double();
+
+  if ( manifest.has_key("projection") ) {
+    projection_ = marley::EventProjection( manifest.at("projection") );
+  }
+
+  for ( const auto& shard : manifest.at("shards").array_range() ) {
+    Shard s;
+    s.file_name_ = shard.at("file").to_string();
+    if ( !s.file_name_.empty() && s.file_name_.front() != '/' ) {
+      s.file_name_ = dir + s.file_name_;
+    }
+    for ( const char* key : { "num_events", "first_event", "stride" } ) {
+      if ( !shard.has_key(key) ) throw marley::Error("Missing \""
+        + std::string(key) + "\" key for the shard file \""
+        + s.file_name_ + "\" in the manifest \"" + file_name_ + '\"');
+    }
+    s.num_events_ = shard.at("num_events").to_long();
+    s.first_event_ = shard.at("first_event").to_long();
+    s.stride_ = shard.at("stride").to_long();
+
+    if ( s.first_event_ < 0 || s.stride_ < 1 || s.num_events_ < 0 ) {
+      throw marley::Error("Invalid entry for the shard file \""
+        + s.file_name_ + "\" encountered in the manifest \"" + file_name_
+        + '\"');
+    }
+    shards_.push_back( std::move(s) );
+  }
+}
+
+bool marley::EventFileReader::next_shard_event(marley::Event& ev) {
+  // Find the shard that holds the next event
+  const long index = next_shard_event_;
+  for ( auto& s : shards_ ) {
+    long offset = index - s.first_event_;
+    if ( offset < 0 || offset % s.stride_ != 0
+      || offset / s.stride_ >= s.num_events_ ) continue;
+
+    if ( offset / s.stride_ != s.num_read_ ) throw marley::Error("The"
+      " shard file \"" + s.file_name_ + "\" cannot be read in order");
+
+    if ( !s.reader_ ) s.reader_ = this->open_shard( s.file_name_ );
+    if ( !s.reader_->next_event(ev) ) throw marley::Error("The shard file \""
+      + s.file_name_ + "\" contains fewer events than listed in the manifest"
+      " \"" + file_name_ + '\"');
+
+    // Close each shard once all of its events have been read
+    if ( ++s.num_read_ == s.num_events_ ) s.reader_.reset();
+    ++next_shard_event_;
+    return true;
+  }
+  return false;
+}
+
+std::unique_ptr<marley::EventFileReader> marley::EventFileReader::open_shard(
+  const std::string& file_name) const
+{
+  return std::make_unique<marley::EventFileReader>( file_name );
+}
+
 void marley::EventFileReader::ensure_initialized() {
   if ( !initialized_ ) {
     if ( !this->deduce_file_format() ) throw marley::Error("Could not"
@@ -230,6 +412,11 @@ void marley::EventFileReader::ensure_initialized() {
   }
 }
 
+const marley::EventProjection& marley::EventFileReader::projection() {
+  this->ensure_initialized();
+  return projection_;
+}
+
 double marley::EventFileReader::flux_averaged_xsec( bool natural_units ) {
   this->ensure_initialized();
   if ( natural_units ) return flux_avg_tot_xs_;
@@ -237,3 +424,33 @@ double marley::EventFileReader::flux_averaged_xsec( bool natural_units ) {
     * marley_utils::fm2_to_minus40_cm2 * 1e2; // 10^{-42} cm^2
   return result;
 }
+
+bool marley::EventFileReader::seek_event( long event_index ) {
+  this->ensure_initialized();
+  if ( format_ != marley::OutputFile::Format::VIRTUAL ) {
+    throw marley::Error("Seeking is supported only for virtual event files."
+      " It cannot be used to read the file \"" + file_name_ + '\"');
+  }
+  return regenerator_->seek( event_index );
+}
+
+const marley::JSON& marley::EventFileReader::summary() {
+  this->ensure_initialized();
+  return summary_;
+}
+
+void marley::EventFileReader::set_num_threads( int num_threads ) {
+  if ( initialized_ ) throw marley::Error("The number of threads must be"
+    " set before reading events from the file \"" + file_name_ + '\"');
+  if ( num_threads < 0 ) throw marley::Error("Negative number of threads"
+    " passed to marley::EventFileReader::set_num_threads()");
+  num_threads_ = num_threads;
+}
+
+std::unique_ptr<marley::Generator> marley::EventFileReader::create_generator(
+  const marley::JSON& config ) const
+{
+  // Leave the Logger settings chosen by the user alone
+  marley::JSONConfig jc( config, false );
+  return std::make_unique<marley::Generator>( jc.create_generator() );
+}
@@ -0,0 +1,176 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <limits>
+#include <utility>
+#include <vector>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/EventProjection.hh"
+#include "marley/JSON.hh"
+
+using Field = marley::EventProjection::Field;
+
+namespace {
+
+  // Names of the event and particle fields (matching the keys used by
+  // marley::Event::to_json() and marley::Particle::to_json())
+  const std::vector< std::pair<std::string, Field> > event_field_names = {
+    { "Ex", Field::Ex }, { "twoJ", Field::twoJ }, { "parity", Field::parity }
+  };
+
+  const std::vector< std::pair<std::string, Field> > particle_field_names = {
+    { "E", Field::E }, { "px", Field::px }, { "py", Field::py },
+    { "pz", Field::pz }, { "mass", Field::mass }, { "charge", Field::charge }
+  };
+
+  // Bitmask that selects all of the fields in a list
+  unsigned int all_fields(
+    const std::vector< std::pair<std::string, Field> >& names)
+  {
+    unsigned int mask = 0u;
+    for ( const auto& pair : names ) {
+      mask |= static_cast<unsigned int>( pair.second );
+    }
+    return mask;
+  }
+
+  // Converts a JSON array of field names into a bitmask
+  unsigned int parse_fields( const marley::JSON& array, const std::string& key,
+    const std::vector< std::pair<std::string, Field> >& names,
+    bool allow_pdg )
+  {
+    if ( !array.is_array() ) throw marley::Error("The \"" + key + "\" key"
+      " in an output file specification must have a value that is a JSON"
+      " array of field names");
+
+    unsigned int mask = 0u;
+    for ( const auto& el : array.array_range() ) {
+      std::string name = el.to_string();
+
+      // The PDG code is always written, so it is allowed but redundant
+      // in the list of particle fields
+      if ( allow_pdg && name == "pdg" ) continue;
+
+      bool found = false;
+      for ( const auto& pair : names ) {
+        if ( pair.first == name ) {
+          mask |= static_cast<unsigned int>( pair.second );
+          found = true;
+          break;
+        }
+      }
+
+      if ( !found ) throw marley::Error("Unrecognized field name \""
+        + name + "\" given for the \"" + key + "\" key in an output file"
+        " specification");
+    }
+    return mask;
+  }
+
+}
+
+marley::EventProjection::EventProjection()
+  : field_mask_( all_fields(event_field_names)
+  | all_fields(particle_field_names) )
+{
+}
+
+marley::EventProjection::EventProjection( const marley::JSON& json )
+  : EventProjection()
+{
+  if ( json.has_key("event_fields") ) {
+    field_mask_ &= ~all_fields( event_field_names );
+    field_mask_ |= parse_fields( json.at("event_fields"), "event_fields",
+      event_field_names, false );
+  }
+
+  if ( json.has_key("particle_fields") ) {
+    field_mask_ &= ~all_fields( particle_field_names );
+    field_mask_ |= parse_fields( json.at("particle_fields"),
+      "particle_fields", particle_field_names, true );
+  }
+
+  if ( json.has_key("initial_particles") ) {
+    bool ok = false;
+    initial_particles_ = json.at( "initial_particles" ).to_bool( ok );
+    if ( !ok ) throw marley::Error("Invalid value "
+      + json.at("initial_particles").dump_string() + " given for the"
+      " \"initial_particles\" key in an output file specification");
+  }
+
+  if ( json.has_key("precision") ) {
+    std::string precision = json.at( "precision" ).to_string();
+    if ( precision == "double" ) single_precision_ = false;
+    else if ( precision == "single" ) single_precision_ = true;
+    else throw marley::Error("Invalid value \"" + precision + "\" given for"
+      " the \"precision\" key in an output file specification. Allowed"
+      " values are \"double\" and \"single\".");
+  }
+
+  if ( json.has_key("weight_names") ) {
+    const auto& names = json.at( "weight_names" );
+    if ( !names.is_array() ) throw marley::Error("The \"weight_names\" key"
+      " must have a value that is a JSON array of strings");
+    for ( const auto& el : names.array_range() ) {
+      weight_names_.push_back( el.to_string() );
+    }
+  }
+}
+
+bool marley::EventProjection::drops_fields() const {
+  return !initial_particles_ || field_mask_ != ( all_fields(event_field_names)
+    | all_fields(particle_field_names) );
+}
+
+bool marley::EventProjection::is_complete() const {
+  return !single_precision_ && !drops_fields() && weight_names_.empty();
+}
+
+int marley::EventProjection::digits() const {
+  if ( single_precision_ ) return std::numeric_limits<float>::max_digits10;
+  return std::numeric_limits<double>::max_digits10;
+}
+
+marley::JSON marley::EventProjection::to_json() const {
+  marley::JSON json = marley::JSON::object();
+
+  marley::JSON event_fields = marley::JSON::array();
+  for ( const auto& pair : event_field_names ) {
+    if ( this->has(pair.second) ) event_fields.append( pair.first );
+  }
+
+  marley::JSON particle_fields = marley::JSON::array();
+  particle_fields.append( std::string("pdg") );
+  for ( const auto& pair : particle_field_names ) {
+    if ( this->has(pair.second) ) particle_fields.append( pair.first );
+  }
+
+  json["event_fields"] = event_fields;
+  json["particle_fields"] = particle_fields;
+  json["initial_particles"] = initial_particles_;
+  json["precision"] = std::string( single_precision_ ? "single" : "double" );
+
+  if ( !weight_names_.empty() ) {
+    marley::JSON names = marley::JSON::array();
+    for ( const auto& name : weight_names_ ) names.append( name );
+    json["weight_names"] = names;
+  }
+
+  return json;
+}
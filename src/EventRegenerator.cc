@@ -0,0 +1,198 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// standard library includes
+#include <algorithm>
+#include <thread>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/EventRegenerator.hh"
+#include "marley/FileManager.hh"
+#include "marley/Generator.hh"
+#include "marley/Logger.hh"
+#include "marley/StructureDatabase.hh"
+#include "marley/marley_utils.hh"
+
+marley::EventRegenerator::EventRegenerator(const marley::JSON& info,
+  GeneratorFactory factory, int num_threads) : factory_(factory)
+{
+  if ( num_threads < 0 ) throw marley::Error( "Negative number of threads"
+    " requested in marley::EventRegenerator::EventRegenerator()" );
+
+  verify( info );
+
+  config_ = info.at( "config" );
+  num_events_ = info.at( "event_count" ).to_long();
+
+  // Check that the blocks cover all of the events without any gaps
+  long expected_first = 0;
+  for ( const auto& b : info.at("blocks").array_range() ) {
+    Block block;
+    block.first_event = b.at( "first_event" ).to_long();
+    block.num_events = b.at( "num_events" ).to_long();
+    block.stream = static_cast<uint_fast64_t>( b.at("stream").to_long() );
+    if ( block.first_event != expected_first || block.num_events < 1 ) {
+      throw marley::Error( "Invalid event block descriptor "
+        + b.dump_string() + " encountered in a virtual event file" );
+    }
+    expected_first += block.num_events;
+    blocks_.push_back( block );
+  }
+
+  if ( expected_first != num_events_ ) throw marley::Error( "The event"
+    " blocks listed in a virtual event file do not match its event count" );
+
+  if ( num_threads == 0 ) {
+    num_threads = std::max( 1u, std::thread::hardware_concurrency() );
+  }
+  size_t num_generators = std::min( static_cast<size_t>(num_threads),
+    std::max( blocks_.size(), size_t(1) ) );
+  generators_.resize( num_generators );
+
+  current_block_ = blocks_.size();
+}
+
+marley::EventRegenerator::~EventRegenerator() {
+  this->wait_for_pending_blocks();
+}
+
+void marley::EventRegenerator::verify(const marley::JSON& info) {
+
+  std::string version = info.at( "marley_version" ).to_string();
+  if ( version != MARLEY_VERSION ) throw marley::Error( "The virtual event"
+    " file was written using MARLEY version " + version + ", but this is"
+    " version " + MARLEY_VERSION + ". The events cannot be regenerated"
+    " reliably." );
+
+  const auto& fm = marley::FileManager::Instance();
+  for ( const auto& file : info.at("data_files").array_range() ) {
+    // Look for the file on the MARLEY search path first. If it isn't
+    // there (e.g., because it was originally found in another directory),
+    // then try the full path that was recorded.
+    std::string name = file.at( "file" ).to_string();
+    std::string full_name = fm.find_file( name );
+    if ( full_name.empty() && file.has_key("path") ) {
+      full_name = fm.find_file( file.at("path").to_string() );
+    }
+    if ( full_name.empty() ) throw marley::Error( "Could not find the data"
+      " file " + name + " needed to regenerate the events in a virtual"
+      " event file" );
+
+    std::string checksum = marley_utils::file_checksum( full_name );
+    if ( checksum != file.at("checksum").to_string() ) {
+      throw marley::Error( "The data file " + full_name + " has changed"
+        " since the virtual event file was written (checksum " + checksum
+        + " instead of " + file.at("checksum").to_string() + ')' );
+    }
+  }
+}
+
+void marley::EventRegenerator::launch_next_block() {
+
+  const Block& block = blocks_.at( next_launch_ );
+  auto& gen = generators_.at( next_launch_ % generators_.size() );
+
+  // Generators are created on the calling thread since their configuration
+  // is not thread-safe. Suppress the duplicate logging messages produced
+  // while configuring them.
+  if ( !gen ) {
+    auto& logger = marley::Logger::Instance();
+    bool log_enabled = logger.is_enabled();
+    logger.disable();
+    try {
+      gen = factory_( config_ );
+      // Initialize the static tables shared by all Generators before any
+      // of them are used concurrently
+      marley::StructureDatabase::fragments();
+    }
+    catch ( ... ) {
+      logger.enable( log_enabled );
+      throw;
+    }
+    logger.enable( log_enabled );
+  }
+
+  marley::Generator* g = gen.get();
+  pending_.push_back( std::async( std::launch::async, [g, block]() {
+    g->start_event_stream( block.stream );
+    std::vector<marley::Event> events;
+    events.reserve( block.num_events );
+    for ( long e = 0; e < block.num_events; ++e ) {
+      events.push_back( g->create_event() );
+    }
+    return events;
+  } ) );
+
+  ++next_launch_;
+}
+
+void marley::EventRegenerator::wait_for_pending_blocks() {
+  for ( auto& future : pending_ ) future.wait();
+  pending_.clear();
+}
+
+void marley::EventRegenerator::load_block(size_t block_index) {
+
+  if ( block_index == current_block_ ) return;
+
+  // If the requested block isn't the next one being regenerated (e.g.,
+  // because we are seeking), then abandon the blocks that were started
+  // and begin again from the requested one
+  size_t first_pending = next_launch_ - pending_.size();
+  if ( pending_.empty() || first_pending != block_index ) {
+    this->wait_for_pending_blocks();
+    next_launch_ = block_index;
+  }
+
+  // Block b is regenerated by Generator b % generators_.size(), so a new
+  // block may be started only after the one that previously used the
+  // same Generator has been retrieved
+  while ( pending_.size() < generators_.size()
+    && next_launch_ < blocks_.size() ) this->launch_next_block();
+
+  current_block_ = blocks_.size();
+  current_events_ = pending_.front().get();
+  pending_.pop_front();
+  current_block_ = block_index;
+
+  if ( next_launch_ < blocks_.size() ) this->launch_next_block();
+}
+
+bool marley::EventRegenerator::next_event(marley::Event& ev) {
+
+  good_ = ( position_ >= 0 && position_ < num_events_ );
+  if ( !good_ ) return false;
+
+  // Find the block that contains the requested event
+  auto iter = std::upper_bound( blocks_.cbegin(), blocks_.cend(), position_,
+    []( long index, const Block& b ) { return index < b.first_event; } );
+  size_t block_index = std::distance( blocks_.cbegin(), iter ) - 1;
+
+  this->load_block( block_index );
+
+  ev = current_events_.at( position_ - blocks_.at(block_index).first_event );
+  ++position_;
+  return true;
+}
+
+bool marley::EventRegenerator::seek(long event_index) {
+  if ( event_index < 0 || event_index > num_events_ ) return false;
+  position_ = event_index;
+  good_ = true;
+  return true;
+}
@@ -14,6 +14,10 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+// Standard library includes
+#include <cmath>
+
+// MARLEY includes
 #include "marley/marley_utils.hh"
 #include "marley/ExitChannel.hh"
 #include "marley/GammaStrengthFunctionModel.hh"
@@ -81,7 +85,8 @@ double marley::FragmentExitChannel::max_Exf() const {
 void marley::FragmentDiscreteExitChannel::compute_total_width() {
 
   int remnant_pdg = this->final_nucleus_pdg();
-  marley::OpticalModel& om = sdb_->get_optical_model( remnant_pdg );
+  const marley::OpticalModel& om = sdb_->get_optical_model( remnant_pdg );
+  marley::OpticalModel::Workspace ws;
 
   // Get information about the emitted fragment
   const marley::Fragment& f = *sdb_->get_fragment( fragment_pdg_ );
@@ -127,7 +132,7 @@ void marley::FragmentDiscreteExitChannel::compute_total_width() {
       if ( Pi_ == P_final_state ) {
 
         double Tlj = om.transmission_coefficient( total_KE_CM_frame,
-          fragment_pdg_, two_j, l, two_s );
+          fragment_pdg_, two_j, l, two_s, 0, ws );
 
         double partial_width = one_over_two_pi_rho_i_ * Tlj;
 
@@ -166,7 +171,7 @@ void marley::GammaDiscreteExitChannel::compute_total_width() {
 
   // Retrieve the gamma strength function model used to compute transmission
   // coefficients
-  marley::GammaStrengthFunctionModel& gsfm
+  const marley::GammaStrengthFunctionModel& gsfm
     = sdb_->get_gamma_strength_function_model( pdgi_ );
 
   // Get properties of the final nuclear level
@@ -214,8 +219,9 @@ double marley::FragmentContinuumExitChannel::differential_width( double Exf,
   if ( store_jpi_widths ) jpi_widths_table_.clear();
 
   int remnant_pdg = this->final_nucleus_pdg();
-  marley::OpticalModel& om = sdb_->get_optical_model( remnant_pdg );
-  marley::LevelDensityModel& ldm = sdb_->get_level_density_model( remnant_pdg );
+  const marley::OpticalModel& om = sdb_->get_optical_model( remnant_pdg );
+  const marley::LevelDensityModel& ldm = sdb_->get_level_density_model(
+    remnant_pdg );
 
   // Get the maximum accessible final excitation energy
   double Exf_max = this->max_Exf();
@@ -248,19 +254,48 @@ double marley::FragmentContinuumExitChannel::differential_width( double Exf,
   // the loop.
   if (Pi_ == Pa) Pf = 1;
   else Pf = -1;
+
+  // Compute the transmission coefficients for all partial waves at once.
+  // They do not depend on the final nuclear spin.
+  two_js_.clear();
+  ls_.clear();
+  for (int l = 0; l <= l_max_; ++l) {
+    int two_l = 2*l;
+    for (int two_j = std::abs(two_l - two_s);
+      two_j <= two_l + two_s; two_j += 2)
+    {
+      two_js_.push_back( two_j );
+      ls_.push_back( l );
+    }
+  }
+  Tljs_.resize( two_js_.size() );
+  marley::OpticalModel::Workspace ws;
+  om.transmission_coefficients( total_KE_CM_frame, fragment_pdg_, two_s,
+    two_js_.data(), ls_.data(), two_js_.size(), 0, Tljs_.data(), ws );
+
+  // Also tabulate the level densities for every accessible final spin and
+  // both parities
+  int twoJf_min = ( twoJi_ + two_s ) % 2;
+  int twoJf_max = twoJi_ + 2*l_max_ + two_s;
+  size_t num_spins = ( twoJf_max - twoJf_min ) / 2 + 1;
+  rhos_.resize( 2u * num_spins );
+  ldm.level_densities( Exf, twoJf_min, num_spins, Pf, rhos_.data() );
+  ldm.level_densities( Exf, twoJf_min, num_spins, -Pf,
+    rhos_.data() + num_spins );
+
   // For each new iteration, increment l and flip the final-state parity
+  size_t wave = 0u;
   for (int l = 0; l <= l_max_; ++l, !Pf) {
     int two_l = 2*l;
+    const double* rhos_Pf = rhos_.data() + ( (l % 2) ? num_spins : 0u );
     for (int two_j = std::abs(two_l - two_s);
-      two_j <= two_l + two_s; two_j += 2)
+      two_j <= two_l + two_s; two_j += 2, ++wave)
     {
+      double Tlj = Tljs_[ wave ];
       for (int twoJf = std::abs(twoJi_ - two_j);
         twoJf <= twoJi_ + two_j; twoJf += 2)
       {
-        double Tlj = om.transmission_coefficient( total_KE_CM_frame,
-          fragment_pdg_, two_j, l, two_s );
-
-        double rho_f = ldm.level_density( Exf, twoJf, Pf );
+        double rho_f = rhos_Pf[ (twoJf - twoJf_min) / 2 ];
 
         double term = one_over_two_pi_rho_i_ * Tlj * rho_f;
 
@@ -296,7 +331,8 @@ void marley::ContinuumExitChannel::compute_total_width() {
 
   // Numerically integrate over the bounds of the continuum using the
   // function object prepared above
-  width_ = marley_utils::num_integrate( dw, E_c_min_, Ec_max );
+  width_ = sdb_->get_continuum_integrator().num_integrate( dw, E_c_min_,
+    Ec_max );
 
   // TODO: consider switching to doing the integration with a
   // ChebyshevInterpolatingFunction object. This avoids needing to create one
@@ -308,8 +344,8 @@ double marley::GammaContinuumExitChannel::differential_width( double Exf,
 {
   if ( store_jpi_widths ) jpi_widths_table_.clear();
 
-  auto& ldm = sdb_->get_level_density_model( pdgi_ );
-  auto& gsfm = sdb_->get_gamma_strength_function_model( pdgi_ );
+  const auto& ldm = sdb_->get_level_density_model( pdgi_ );
+  const auto& gsfm = sdb_->get_gamma_strength_function_model( pdgi_ );
 
   // Initialize the return value to zero
   double diff_width = 0.;
@@ -332,6 +368,17 @@ double marley::GammaContinuumExitChannel::differential_width( double Exf,
   constexpr std::array<marley::Parity, 2>
     parities = { marley::Parity(true), marley::Parity(false) };
 
+  // Tabulate the level densities for every accessible final spin and both
+  // parities
+  int twoJf_min = twoJi_ % 2;
+  int twoJf_max = twoJi_ + 2*l_max_;
+  size_t num_spins = ( twoJf_max - twoJf_min ) / 2 + 1;
+  rhos_.resize( 2u * num_spins );
+  for ( size_t p = 0u; p < parities.size(); ++p ) {
+    ldm.level_densities( Exf, twoJf_min, num_spins, parities[ p ],
+      rhos_.data() + p*num_spins );
+  }
+
   // Sum over multipolarities. There is no monopole radiation, so
   // the sum begins at mpol = 1.
   for ( int mpol = 1; mpol <= l_max_; ++mpol ) {
@@ -341,7 +388,9 @@ double marley::GammaContinuumExitChannel::differential_width( double Exf,
     for ( int twoJf = std::abs(twoJi_ - two_mpol); twoJf <= twoJi_ + two_mpol;
       twoJf += 2 )
     {
-      for ( const auto& Pf : parities ) {
+      for ( size_t p = 0u; p < parities.size(); ++p ) {
+
+        const auto& Pf = parities[ p ];
 
         // Use the multipolarity and final-state nuclear parity to determine
         // whether the current partial differential width represents an
@@ -349,7 +398,7 @@ double marley::GammaContinuumExitChannel::differential_width( double Exf,
         TrType type = this->get_transition_type( mpol, Pf );
 
         double Txl = gsfm.transmission_coefficient( type, mpol, E_gamma );
-        double rho_f = ldm.level_density(Exf, twoJf, Pf);
+        double rho_f = rhos_[ p*num_spins + (twoJf - twoJf_min) / 2 ];
 
         double term = one_over_two_pi_rho_i_ * Txl * rho_f;
 
@@ -418,6 +467,37 @@ void marley::ExitChannel::prepare_products(
     residual_nucleus, cos_theta_emitted_particle, phi_emitted_particle );
 }
 
+void marley::ContinuumExitChannel::tilted_widths(
+  const std::vector<double>& slopes, std::vector<double>& widths) const
+{
+  widths.assign( slopes.size(), width_ );
+  if ( width_ <= 0. ) return;
+
+  double Ec_max = this->E_c_max();
+  std::vector<double> points, weights;
+  sdb_->get_continuum_integrator().get_sampling_points( E_c_min_, Ec_max,
+    points, weights );
+
+  std::vector<double> dws( points.size() );
+  double nominal = 0.;
+  for ( size_t k = 0u; k < points.size(); ++k ) {
+    dws[ k ] = weights[ k ] * this->differential_width( points[k] );
+    nominal += dws[ k ];
+  }
+  if ( !(nominal > 0.) ) return;
+
+  // Rescale width_ by the ratio of the two quadrature sums so that the
+  // results are consistent with it
+  for ( size_t s = 0u; s < slopes.size(); ++s ) {
+    if ( slopes[s] == 0. ) continue;
+    double tilted = 0.;
+    for ( size_t k = 0u; k < points.size(); ++k ) {
+      tilted += dws[ k ] * std::exp( slopes[s] * (points[k] - E_c_min_) );
+    }
+    widths[ s ] = width_ * tilted / nominal;
+  }
+}
+
 double marley::ContinuumExitChannel::sample_Exf(marley::Generator& gen) const
 {
   // The maximum accessible excitation energy for this exit channel. It
@@ -431,7 +511,7 @@ double marley::ContinuumExitChannel::sample_Exf(marley::Generator& gen) const
     // final nuclear excitation energy
     marley::ChebyshevInterpolatingFunction pdf_cheb( [this](double Exf)
       -> double { return this->differential_width(Exf); }, E_c_min_, Emax,
-      marley::DEFAULT_N_CHEBYSHEV );
+      sdb_->get_continuum_chebyshev_points() );
 
     // Store the cumulative density function for possible re-use
     Exf_cdf_ = std::make_unique<marley::ChebyshevInterpolatingFunction>(
@@ -440,7 +520,8 @@ double marley::ContinuumExitChannel::sample_Exf(marley::Generator& gen) const
 
   // Sample a final nuclear excitation energy using the Chebyshev polynomial
   // approximant to the CDF
-  double Exf = gen.inverse_transform_sample( *Exf_cdf_, E_c_min_, Emax );
+  double Exf = gen.inverse_transform_sample( *Exf_cdf_, E_c_min_, Emax,
+    sdb_->get_continuum_sampling_tolerance() );
   return Exf;
 }
 
@@ -479,17 +560,16 @@ void marley::ContinuumExitChannel::sample_spin_parity(double Exf, int& twoJ,
 
   // Sample a final spin and parity
   const auto begin = marley::IteratorToMember<
-    std::vector<SpinParityWidth>::const_iterator,
+    SpinParityWidthTable::const_iterator,
     const double>( jpi_widths_table_.cbegin(),
     &SpinParityWidth::diff_width );
 
   const auto end = marley::IteratorToMember<
-    std::vector<SpinParityWidth>::const_iterator,
+    SpinParityWidthTable::const_iterator,
     const double>( jpi_widths_table_.cend(),
     &SpinParityWidth::diff_width );
 
-  std::discrete_distribution<size_t> jpi_dist( begin, end );
-  size_t jpi_index = gen.sample_from_distribution( jpi_dist );
+  size_t jpi_index = gen.sample_discrete( begin, end );
 
   // Store the results
   const SpinParityWidth& Jpi = jpi_widths_table_.at( jpi_index );
@@ -106,8 +106,16 @@ std::string marley::FileManager::find_file(const std::string& base_name,
 
   // First check if we can find the file just using base_name. We can
   // avoid the search if it's already accessible (e.g., because the
-  // full path was supplied instead of the base name)
-  if ( file_exists(base_name) ) return base_name;
+  // full path was supplied instead of the base name). Lookups that don't
+  // involve any search directories (e.g., for event files) are not
+  // recorded in located_files_.
+  if ( file_exists(base_name) ) {
+    if ( !search_dirs.empty() ) {
+      std::lock_guard<std::mutex> lock( located_files_mutex_ );
+      located_files_[ base_name ] = base_name;
+    }
+    return base_name;
+  }
 
   // Search the directories in the order listed. In each directory,
   // compare all regular file names to the given base name. If a match
@@ -131,9 +139,21 @@ std::string marley::FileManager::find_file(const std::string& base_name,
     if ( file_found ) break;
   }
 
+  if ( !full_path_to_file.empty() ) {
+    std::lock_guard<std::mutex> lock( located_files_mutex_ );
+    located_files_[ base_name ] = full_path_to_file;
+  }
+
   return full_path_to_file;
 }
 
+std::map<std::string, std::string>
+  marley::FileManager::located_files() const
+{
+  std::lock_guard<std::mutex> lock( located_files_mutex_ );
+  return located_files_;
+}
+
 std::vector<std::string> marley::FileManager::list_all_files(
   const std::string& search_path) const
 {
@@ -0,0 +1,397 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// standard library includes
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/EventFileReader.hh"
+#include "marley/FlatSummaryWriter.hh"
+#include "marley/JSON.hh"
+#include "marley/Particle.hh"
+
+namespace {
+
+  // Index of the first final-state particle that is not the
+  // ejectile or residue (first de-excitation product). This matches
+  // the value used by marsum.
+  constexpr size_t FIRST_PROD_IDX = 2u;
+
+  // Maximum number of finished blocks that may wait to be written for
+  // files other than the one currently being written
+  constexpr size_t MAX_QUEUED_BLOCKS = 16u;
+
+  const char MAGIC[] = "MARFLAT1";
+  constexpr size_t MAGIC_SIZE = 8u;
+
+  enum class ColumnType { Int32, Float64 };
+
+  // Each column holds either one value per event or one value per
+  // de-excitation product
+  struct Column {
+    std::string name;
+    ColumnType type;
+    bool per_product;
+  };
+
+  // The columns have the same names and meanings as the branches of the
+  // marsum summary tree
+  const std::vector<Column> COLUMNS = {
+    { "pdgv", ColumnType::Int32, false },
+    { "Ev", ColumnType::Float64, false },
+    { "KEv", ColumnType::Float64, false },
+    { "pxv", ColumnType::Float64, false },
+    { "pyv", ColumnType::Float64, false },
+    { "pzv", ColumnType::Float64, false },
+    { "pdgt", ColumnType::Int32, false },
+    { "Mt", ColumnType::Float64, false },
+    { "pdgl", ColumnType::Int32, false },
+    { "El", ColumnType::Float64, false },
+    { "KEl", ColumnType::Float64, false },
+    { "pxl", ColumnType::Float64, false },
+    { "pyl", ColumnType::Float64, false },
+    { "pzl", ColumnType::Float64, false },
+    { "pdgr", ColumnType::Int32, false },
+    { "Er", ColumnType::Float64, false },
+    { "KEr", ColumnType::Float64, false },
+    { "pxr", ColumnType::Float64, false },
+    { "pyr", ColumnType::Float64, false },
+    { "pzr", ColumnType::Float64, false },
+    { "Ex", ColumnType::Float64, false },
+    { "twoJ", ColumnType::Int32, false },
+    { "parity", ColumnType::Int32, false },
+    { "np", ColumnType::Int32, false },
+    { "pdgp", ColumnType::Int32, true },
+    { "Ep", ColumnType::Float64, true },
+    { "KEp", ColumnType::Float64, true },
+    { "pxp", ColumnType::Float64, true },
+    { "pyp", ColumnType::Float64, true },
+    { "pzp", ColumnType::Float64, true },
+    { "xsec", ColumnType::Float64, false },
+  };
+
+  // Index of the "np" column (used to split the product columns by event)
+  constexpr size_t NP_COLUMN = 23u;
+
+  size_t value_size( ColumnType type ) {
+    return type == ColumnType::Int32 ? sizeof(int32_t) : sizeof(double);
+  }
+
+  // Summary values for a contiguous range of events from one input file
+  struct Block {
+    uint64_t num_events = 0u;
+    uint64_t num_products = 0u;
+    std::vector< std::vector<char> > columns
+      = std::vector< std::vector<char> >( COLUMNS.size() );
+
+    template <typename T> void put( size_t column, T value ) {
+      auto& data = columns.at( column );
+      size_t old_size = data.size();
+      data.resize( old_size + sizeof(T) );
+      std::memcpy( data.data() + old_size, &value, sizeof(T) );
+    }
+
+    template <typename T> T get( size_t column, size_t index ) const {
+      T value;
+      std::memcpy( &value, columns.at(column).data() + index * sizeof(T),
+        sizeof(T) );
+      return value;
+    }
+
+    // Adds the summary values for an event. The order of the calls matches
+    // the order of COLUMNS.
+    void add_event( const marley::Event& ev, double xsec ) {
+      size_t c = 0u;
+      auto add_particle = [this, &c]( const marley::Particle& p,
+        bool kinematics )
+      {
+        put<int32_t>( c++, p.pdg_code() );
+        if ( !kinematics ) return;
+        put<double>( c++, p.total_energy() );
+        put<double>( c++, p.kinetic_energy() );
+        put<double>( c++, p.px() );
+        put<double>( c++, p.py() );
+        put<double>( c++, p.pz() );
+      };
+
+      add_particle( ev.projectile(), true );
+      add_particle( ev.target(), false );
+      put<double>( c++, ev.target().mass() );
+      add_particle( ev.ejectile(), true );
+      add_particle( ev.residue(), true );
+
+      put<double>( c++, ev.Ex() );
+      put<int32_t>( c++, ev.twoJ() );
+      put<int32_t>( c++, static_cast<int>(ev.parity()) );
+
+      const auto& fparts = ev.get_final_particles();
+      int32_t np = fparts.size() - FIRST_PROD_IDX;
+      put<int32_t>( c++, np );
+      for ( size_t j = FIRST_PROD_IDX; j < fparts.size(); ++j ) {
+        const auto* fp = fparts.at( j );
+        put<int32_t>( c, fp->pdg_code() );
+        put<double>( c + 1, fp->total_energy() );
+        put<double>( c + 2, fp->kinetic_energy() );
+        put<double>( c + 3, fp->px() );
+        put<double>( c + 4, fp->py() );
+        put<double>( c + 5, fp->pz() );
+      }
+      c += 6;
+
+      put<double>( c++, xsec );
+
+      ++num_events;
+      num_products += np;
+    }
+
+    // Writes one row per event to a CSV file. The values for the
+    // de-excitation products are separated by semicolons.
+    void write_csv( std::ostream& out ) const {
+      size_t first_product = 0u;
+      for ( size_t e = 0u; e < num_events; ++e ) {
+        int32_t np = get<int32_t>( NP_COLUMN, e );
+        for ( size_t c = 0u; c < COLUMNS.size(); ++c ) {
+          if ( c > 0u ) out << ',';
+          const auto& col = COLUMNS.at( c );
+          size_t begin = col.per_product ? first_product : e;
+          size_t end = col.per_product ? first_product + np : e + 1u;
+          for ( size_t i = begin; i < end; ++i ) {
+            if ( i > begin ) out << ';';
+            if ( col.type == ColumnType::Int32 ) out << get<int32_t>( c, i );
+            else out << get<double>( c, i );
+          }
+        }
+        out << '\n';
+        first_product += np;
+      }
+    }
+  };
+
+  // Finished blocks for one input file, in order
+  struct FileBlocks {
+    std::deque< std::unique_ptr<Block> > blocks;
+    bool done = false;
+    std::string error;
+  };
+
+  // Shared state for the threads that read the input files
+  struct ConversionState {
+    std::vector<std::string> input_files;
+    std::vector<FileBlocks> results;
+    std::atomic<size_t> next_file{ 0u };
+    size_t current_file = 0u; // File whose blocks are being written
+    size_t queued_blocks = 0u; // Blocks waiting for other files
+    size_t events_per_block = 0u;
+    int reader_threads = 0;
+    marley::FlatSummaryWriter::ReaderFactory make_reader;
+    std::mutex mutex;
+    std::condition_variable cv;
+  };
+
+  // Hands a finished block to the writer. Blocks for files after the one
+  // being written wait in memory, so the reader pauses if too many of them
+  // have accumulated.
+  void publish( ConversionState& state, size_t file,
+    std::unique_ptr<Block> block )
+  {
+    std::unique_lock<std::mutex> lock( state.mutex );
+    state.cv.wait( lock, [&state, file]() { return file
+      == state.current_file || state.queued_blocks < MAX_QUEUED_BLOCKS; } );
+    if ( file != state.current_file ) ++state.queued_blocks;
+    state.results.at( file ).blocks.push_back( std::move(block) );
+    state.cv.notify_all();
+  }
+
+  void convert_files( ConversionState& state ) {
+    size_t file;
+    while ( (file = state.next_file++) < state.input_files.size() ) {
+      try {
+        auto reader_ptr = state.make_reader( state.input_files.at(file) );
+        auto& reader = *reader_ptr;
+        reader.set_num_threads( state.reader_threads );
+
+        auto block = std::make_unique<Block>();
+        marley::Event ev;
+        while ( reader >> ev ) {
+          block->add_event( ev, reader.flux_averaged_xsec() );
+          if ( block->num_events == state.events_per_block ) {
+            publish( state, file, std::move(block) );
+            block = std::make_unique<Block>();
+          }
+        }
+        if ( block->num_events > 0u ) publish( state, file, std::move(block) );
+      }
+      catch ( const std::exception& err ) {
+        std::lock_guard<std::mutex> lock( state.mutex );
+        state.results.at( file ).error = err.what();
+      }
+
+      std::lock_guard<std::mutex> lock( state.mutex );
+      state.results.at( file ).done = true;
+      state.cv.notify_all();
+    }
+  }
+
+  void write_value( std::ostream& out, uint64_t value ) {
+    out.write( reinterpret_cast<const char*>(&value), sizeof(value) );
+  }
+}
+
+constexpr size_t marley::FlatSummaryWriter::DEFAULT_EVENTS_PER_BLOCK;
+
+marley::FlatSummaryWriter::FlatSummaryWriter(
+  const std::vector<std::string>& input_files, int num_threads,
+  size_t events_per_block, ReaderFactory make_reader )
+  : input_files_( input_files ), num_threads_( num_threads ),
+  events_per_block_( events_per_block ), make_reader_( make_reader )
+{
+  if ( events_per_block_ == 0u ) throw marley::Error( "The number of events"
+    " in each block of a flat summary file must be positive" );
+  if ( !make_reader_ ) make_reader_ = []( const std::string& file_name ) {
+    return std::make_unique<marley::EventFileReader>( file_name );
+  };
+}
+
+uint64_t marley::FlatSummaryWriter::write( std::ostream& out,
+  std::ostream* csv )
+{
+  ConversionState state;
+  state.input_files = input_files_;
+  state.events_per_block = events_per_block_;
+  state.make_reader = make_reader_;
+
+  if ( csv ) {
+    csv->precision( std::numeric_limits<double>::max_digits10 );
+    for ( size_t c = 0u; c < COLUMNS.size(); ++c ) {
+      if ( c > 0u ) *csv << ',';
+      *csv << COLUMNS.at( c ).name;
+    }
+    *csv << '\n';
+  }
+
+  // Divide the available threads among the input files. Any that are left
+  // over are used to regenerate the events in virtual event files.
+  int num_threads = std::max( 1, num_threads_ );
+  size_t num_readers = std::min<size_t>( num_threads,
+    state.input_files.size() );
+  state.reader_threads = std::max<int>( 1, num_threads / num_readers );
+  state.results = std::vector<FileBlocks>( state.input_files.size() );
+
+  std::vector<std::thread> readers;
+  for ( size_t t = 0u; t < num_readers; ++t ) {
+    readers.emplace_back( convert_files, std::ref(state) );
+  }
+
+  out.write( MAGIC, MAGIC_SIZE );
+
+  marley::JSON blocks_json = marley::JSON::array();
+  uint64_t total_events = 0u;
+  file_results_ = std::vector<FileResult>( state.input_files.size() );
+
+  // Write the blocks in the same order that marsum would write the events
+  for ( size_t file = 0u; file < state.input_files.size(); ++file ) {
+    uint64_t file_events = 0u;
+    while ( true ) {
+      std::unique_ptr<Block> block;
+      {
+        std::unique_lock<std::mutex> lock( state.mutex );
+        auto& result = state.results.at( file );
+        state.cv.wait( lock, [&result]() { return !result.blocks.empty()
+          || result.done; } );
+        if ( result.blocks.empty() ) break;
+        block = std::move( result.blocks.front() );
+        result.blocks.pop_front();
+      }
+
+      uint64_t offset = static_cast<uint64_t>( out.tellp() );
+      write_value( out, block->num_events );
+      write_value( out, block->num_products );
+      for ( const auto& data : block->columns ) {
+        out.write( data.data(), data.size() );
+      }
+
+      marley::JSON block_json = marley::JSON::object();
+      block_json[ "offset" ] = offset;
+      block_json[ "size" ] = static_cast<uint64_t>( out.tellp() ) - offset;
+      block_json[ "events" ] = block->num_events;
+      block_json[ "products" ] = block->num_products;
+      blocks_json.append( block_json );
+
+      if ( csv ) block->write_csv( *csv );
+      file_events += block->num_events;
+    }
+
+    file_results_.at( file ).num_events = file_events;
+    file_results_.at( file ).error = state.results.at( file ).error;
+    total_events += file_events;
+
+    // Blocks that were waiting for this file to finish may now be
+    // written, so the reader threads no longer need to count them
+    std::lock_guard<std::mutex> lock( state.mutex );
+    state.current_file = file + 1u;
+    if ( state.current_file < state.results.size() ) {
+      state.queued_blocks -= state.results.at( state.current_file )
+        .blocks.size();
+    }
+    state.cv.notify_all();
+  }
+
+  for ( auto& reader : readers ) reader.join();
+
+  // Describe the contents of the file in a JSON footer
+  uint16_t byte_order_test = 1u;
+  bool little_endian = *reinterpret_cast<const char*>( &byte_order_test )
+    == 1;
+
+  marley::JSON footer = marley::JSON::object();
+  footer[ "format" ] = std::string( "marflat" );
+  footer[ "version" ] = 1;
+  footer[ "byte_order" ] = std::string( little_endian ? "little" : "big" );
+  footer[ "num_events" ] = total_events;
+  marley::JSON columns_json = marley::JSON::array();
+  for ( const auto& col : COLUMNS ) {
+    marley::JSON col_json = marley::JSON::object();
+    col_json[ "name" ] = col.name;
+    col_json[ "type" ] = std::string( col.type == ColumnType::Int32
+      ? "int32" : "float64" );
+    col_json[ "length" ] = std::string( col.per_product ? "products"
+      : "events" );
+    col_json[ "value_size" ] = value_size( col.type );
+    columns_json.append( col_json );
+  }
+  footer[ "columns" ] = columns_json;
+  footer[ "blocks" ] = blocks_json;
+  marley::JSON inputs_json = marley::JSON::array();
+  for ( const auto& name : state.input_files ) inputs_json.append( name );
+  footer[ "input_files" ] = inputs_json;
+
+  std::string footer_string = footer.dump_string();
+  out << footer_string;
+  write_value( out, footer_string.size() );
+  out.write( MAGIC, MAGIC_SIZE );
+
+  return total_events;
+}
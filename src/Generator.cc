@@ -14,10 +14,13 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <limits>
+#include <numeric>
 #include <string>
+#include <utility>
 
 #include "marley/ChebyshevInterpolatingFunction.hh"
 #include "marley/Error.hh"
@@ -25,9 +28,18 @@
 #include "marley/Logger.hh"
 #include "marley/NucleusDecayer.hh"
 #include "marley/Reaction.hh"
+#include "marley/StartupProfile.hh"
 #include "marley/StructureDatabase.hh"
+#include "marley/Tracer.hh"
+#include "marley/marley_simd.hh"
 #include "marley/marley_utils.hh"
 
+namespace {
+  // Factor by which the upper bounds in the reaction table exceed the
+  // largest flux-weighted cross section found in each energy bin
+  constexpr double REACTION_TABLE_SAFETY_FACTOR = 1.1;
+}
+
 // The default constructor uses the system time as the seed and a
 // default-constructured monoenergetic neutrino source. No reactions are
 // defined, so the user must call add_reaction() at least once before using a
@@ -37,6 +49,7 @@ marley::Generator::Generator()
   source_(new marley::MonoNeutrinoSource),
   structure_db_(new marley::StructureDatabase)
 {
+  source_pdgs_ = source_->get_pids();
   print_logo();
   reseed(seed_);
 }
@@ -47,6 +60,7 @@ marley::Generator::Generator(uint_fast64_t seed)
   : seed_(seed), source_(new marley::MonoNeutrinoSource),
   structure_db_(new marley::StructureDatabase)
 {
+  source_pdgs_ = source_->get_pids();
   print_logo();
   reseed(seed_);
 }
@@ -60,34 +74,184 @@ void marley::Generator::print_logo() {
       << " gonna be all right.\n-- Bob, \"Three Little Birds\"\n\n"
       << "Model of Argon Reaction Low Energy Yields\n"
       << "version " << MARLEY_VERSION << '\n';
+    MARLEY_LOG_INFO() << "Using " << marley_simd::level_name(
+      marley_simd::active_level() ) << " SIMD kernels";
     printed_logo = true;
   }
 }
 
 marley::Event marley::Generator::create_event() {
+  marley::Tracer::begin_event();
+  marley::Tracer::Span span( "Generator::create_event" );
+
+  // Without any primary event cuts, simulate the de-excitation right away.
+  // This keeps the event sequence for a given seed the same as in earlier
+  // versions.
+  if ( primary_filter_.empty() ) return this->sample_primary_event( false );
+
+  marley::Event ev = this->create_primary_event();
+  this->resolve_deexcitation( ev );
+  return ev;
+}
+
+marley::Event marley::Generator::sample_primary_event( bool defer ) {
 
   // (1) Select a reacting neutrino energy and reaction using the
   // flux-weighted total cross section(s)
   double E_nu;
-  marley::Reaction& r = sample_reaction( E_nu );
+  marley::Reaction* r = nullptr;
+  {
+    marley::Tracer::Span span( "Generator::sample_reaction" );
+    r = &sample_reaction( E_nu );
+  }
 
   // (2) Create the prompt two-two scattering event using the
   // sampled reaction object
-  marley::Event ev = r.create_event( source_->get_pid(), E_nu, *this );
+  marley::Event ev = [&]() {
+    marley::Tracer::Span span( "Reaction::create_event", { {"E_nu", E_nu} } );
+    return r->create_event( r->pdg_a(), E_nu, *this );
+  }();
+
+  // Reactions that don't depend on the nuclear model parameters varied by
+  // the systematic universes leave the weights unset. Use unit weights.
+  if ( ev.weights().empty() ) ev.weights().assign( universes_.size(), 1. );
 
   // (3) If needed, de-excite the final-state residue
-  if ( do_deexcitations_ ) {
+  if ( do_deexcitations_ && !defer ) {
+    marley::Tracer::Span span( "NucleusDecayer::process_event" );
     marley::NucleusDecayer nd;
     nd.process_event( ev, *this );
   }
 
   // (4) If needed, rotate the event to match the desired projectile direction
-  rotator_.process_event( ev, *this );
+  {
+    marley::Tracer::Span span( "ProjectileDirectionRotator::process_event" );
+    rotator_.process_event( ev, *this );
+  }
+
+  // (5) If the de-excitation was deferred, set aside a random number
+  // sub-stream for it. Drawing its seed here (whether or not the event
+  // is eventually accepted) keeps the main stream independent of the
+  // de-excitation cascade.
+  if ( do_deexcitations_ && defer ) ev.defer_deexcitation( rand_gen_() );
 
-  // Return the completed event object
   return ev;
 }
 
+marley::Event marley::Generator::create_primary_event() {
+
+  // Keep sampling primary events until one passes the cuts
+  while ( true ) {
+    marley::Event ev = this->sample_primary_event( true );
+    ++primaries_sampled_;
+    if ( primary_filter_.accepts(ev) ) {
+      ++primaries_accepted_;
+      return ev;
+    }
+  }
+}
+
+void marley::Generator::resolve_deexcitation( marley::Event& ev ) {
+
+  if ( !ev.deexcitation_pending() ) return;
+
+  // Residues left in their ground state don't need any further work
+  if ( ev.Ex() == 0. ) {
+    ev.clear_pending_deexcitation();
+    return;
+  }
+
+  // Use the sub-stream assigned to this event in place of the main random
+  // number generator, then restore the main one (even if an exception is
+  // thrown)
+  std::seed_seq seed_sequence{ ev.deexcitation_seed() };
+  std::mt19937_64 sub_stream( seed_sequence );
+  std::swap( rand_gen_, sub_stream );
+
+  try {
+    marley::Tracer::Span span( "Generator::resolve_deexcitation" );
+    marley::NucleusDecayer nd;
+    nd.process_event( ev, *this );
+  }
+  catch ( ... ) {
+    std::swap( rand_gen_, sub_stream );
+    throw;
+  }
+
+  std::swap( rand_gen_, sub_stream );
+  ev.clear_pending_deexcitation();
+}
+
+void marley::Generator::set_primary_filter(
+  const marley::PrimaryEventFilter& filter, long pilot_events )
+{
+  if ( pilot_events < 1 ) throw marley::Error( "The number of events used"
+    " to estimate the primary event cut efficiency must be positive" );
+
+  primary_filter_ = filter;
+  pilot_events_ = pilot_events;
+  cut_efficiency_ = 1.;
+
+  // If the energy PDF is not ready yet, then the efficiency will be
+  // estimated when it is normalized
+  if ( !dont_normalize_E_pdf_ && source_ && !reactions_.empty() ) {
+    this->update_cut_efficiency();
+  }
+}
+
+void marley::Generator::update_cut_efficiency() {
+
+  cut_efficiency_ = 1.;
+  if ( primary_filter_.empty() ) return;
+
+  // Sample the pilot events using a separate random number stream so that
+  // the main one is left untouched. Also restore the estimated maximum of
+  // the energy PDF and the bounds in any reaction table afterwards, since
+  // they affect the sampling of neutrino energies.
+  constexpr uint_fast64_t PILOT_STREAM_ID = 0x70696c6f74ull;
+  std::seed_seq seed_sequence{ seed_, PILOT_STREAM_ID };
+  std::mt19937_64 pilot_stream( seed_sequence );
+  std::swap( rand_gen_, pilot_stream );
+  double saved_E_pdf_max = E_pdf_max_;
+  auto saved_cells = reaction_cells_;
+  auto saved_cutoffs = cell_cutoffs_;
+  auto saved_aliases = cell_aliases_;
+  auto restore = [&]() {
+    std::swap( rand_gen_, pilot_stream );
+    E_pdf_max_ = saved_E_pdf_max;
+    reaction_cells_ = std::move( saved_cells );
+    cell_cutoffs_ = std::move( saved_cutoffs );
+    cell_aliases_ = std::move( saved_aliases );
+  };
+
+  long accepted = 0;
+  try {
+    for ( long e = 0; e < pilot_events_; ++e ) {
+      if ( primary_filter_.accepts(this->sample_primary_event(true)) ) {
+        ++accepted;
+      }
+    }
+  }
+  catch ( ... ) {
+    restore();
+    throw;
+  }
+  restore();
+
+  if ( accepted == 0 ) {
+    throw marley::Error( "None of the "
+    + std::to_string(pilot_events_) + " primary events sampled while"
+    " estimating the cut efficiency passed the cuts "
+    + primary_filter_.to_string() );
+  }
+
+  cut_efficiency_ = static_cast<double>( accepted ) / pilot_events_;
+
+  MARLEY_LOG_INFO() << "Estimated primary event cut efficiency: "
+    << cut_efficiency_ << " (" << accepted << " of " << pilot_events_
+    << " events passed the cuts " << primary_filter_.to_string() << ')';
+}
+
 void marley::Generator::seed_using_state_string(
   const std::string& state_string)
 {
@@ -107,6 +271,17 @@ void marley::Generator::reseed(uint_fast64_t seed) {
   MARLEY_LOG_INFO() << "Seeded random number generator with " << seed_;
 }
 
+void marley::Generator::start_event_stream(uint_fast64_t stream) {
+  // Use every bit of both the seed and the stream index (std::seed_seq
+  // keeps only the lowest 32 bits of each input value)
+  constexpr uint_fast64_t EVENT_STREAM_ID = 0x73747265ull;
+  constexpr uint_fast64_t LOW_BITS = 0xffffffffull;
+  std::seed_seq seed_sequence{ seed_ & LOW_BITS, seed_ >> 32,
+    EVENT_STREAM_ID, stream & LOW_BITS, stream >> 32 };
+  rand_gen_.seed( seed_sequence );
+  E_pdf_max_ = E_PDF_MAX_DEFAULT_;
+}
+
 std::string marley::Generator::get_state_string() const {
   std::stringstream ss;
   ss << rand_gen_;
@@ -120,6 +295,8 @@ void marley::Generator::normalize_E_pdf() {
   // normalize_E_pdf() as the Generator is being constructed
   if ( dont_normalize_E_pdf_ ) return;
 
+  marley::StartupProfile::Phase phase( "Normalize neutrino energy PDF" );
+
   // This function is called whenever the reacting neutrino energy PDF changes,
   // so reset the estimated maximum PDF value to its default. We will update
   // this during rejection sampling.
@@ -151,10 +328,21 @@ void marley::Generator::normalize_E_pdf() {
     norm_ = 1.;
 
     // Update the normalization factor for use with the reacting neutrino
-    // energy probability density function
-    norm_ = marley_utils::num_integrate( [this](double E)
-      -> double { return this->E_pdf(E); }, source_->get_Emin(),
-      source_->get_Emax() );
+    // energy probability density function. Sources that tabulate the
+    // moments of their spectrum can fold it with the total cross section
+    // bin by bin, which avoids quadrature over finely binned fluxes.
+    if ( source_->has_integral_table() && weight_flux_
+      && source_pdgs_.size() == 1u )
+    {
+      int pdg_a = source_pdgs_.front();
+      norm_ = source_->integrate( [this, pdg_a](double E)
+        -> double { return this->total_xs( pdg_a, E ); } );
+    }
+    else {
+      norm_ = marley_utils::num_integrate( [this](double E)
+        -> double { return this->E_pdf(E); }, source_->get_Emin(),
+        source_->get_Emax() );
+    }
 
     if ( norm_ <= 0. || std::isnan(norm_) ) {
       throw marley::Error( "The integral of the cross-section-weighted"
@@ -163,6 +351,13 @@ void marley::Generator::normalize_E_pdf() {
         " threshold(s)." );
     }
   }
+
+  // Rebuild the table of upper bounds used to sample reactions (if needed)
+  this->build_reaction_table();
+
+  // The fraction of events passing the primary event cuts depends on the
+  // energy PDF, so estimate it again
+  this->update_cut_efficiency();
 }
 
 // Sample a random double uniformly between min and max using the class
@@ -176,8 +371,9 @@ double marley::Generator::uniform_random_double(double min, double max,
   // Defaults to sampling from [0,1). We will always
   // explicitly supply the upper and lower bounds to
   // this distribution, so we won't worry about the
-  // default setting.
-  static std::uniform_real_distribution<double> udist;
+  // default setting. Each thread gets its own copy so that separate
+  // Generator objects may be used concurrently.
+  static thread_local std::uniform_real_distribution<double> udist;
 
   double max_to_use;
 
@@ -230,6 +426,8 @@ double marley::Generator::rejection_sample(const std::function<double(double)>&
     // a required parameter of marley_utils::maximize
     double x_at_max;
 
+    marley::StartupProfile::Phase phase( "Search for PDF maximum" );
+
     // Maximize the function and multiply by a safety factor just
     // in case we didn't quite find the exact peak
     fmax = marley_utils::maximize(f, xmin, xmax, max_search_tolerance,
@@ -269,35 +467,65 @@ double marley::Generator::E_pdf(double E) {
   // Initialize the return value to zero
   double pdf = 0.;
 
-  // Sum all of the reaction total cross sections, saving
-  // each individual value along the way. Take weighting
-  // by atom fraction in the target material into account.
-  for ( size_t j = 0, s = reactions_.size(); j < s; ++j ) {
+  total_xs_values_.clear();
+  open_reactions_.clear();
 
-    // Get the current reaction
-    const auto& react = reactions_.at( j );
+  // Sum the total cross sections of all reactions that can be initiated by
+  // each of the source's projectiles, saving each individual value along the
+  // way. Reactions are skipped entirely when their target atom is absent or
+  // when E lies below threshold, since their cross section must vanish in
+  // those cases. Weighting by atom fraction in the target material is taken
+  // into account.
+  bool multi_flavor = ( source_pdgs_.size() > 1u );
+  for ( int pdg_a : source_pdgs_ ) {
 
-    // Compute the total cross section for the current reaction for a single
-    // target atom
-    double tot_xs = react->total_xs( source_->get_pid(), E );
+    size_t first_value = total_xs_values_.size();
+    double flavor_xs = 0.;
 
-    // If the target_ member has not been initialized, don't bother doing any
-    // weighting by atom fraction (equivalent to a weight of unity for all
-    // target atoms)
-    if ( target_ ) {
-      // If it has been configured, then apply the appropriate atom fraction
-      // weight from the target as appropriate.
-      tot_xs *= target_->atom_fraction( react->atomic_target() );
+    auto iter = reaction_index_.find( pdg_a );
+    if ( iter != reaction_index_.end() ) {
+      for ( const auto& channel : iter->second ) {
+
+        if ( E < channel.threshold ) continue;
+
+        const auto& react = reactions_[ channel.index ];
+
+        // Compute the total cross section for the current reaction for a
+        // single target atom, then apply the atom fraction weight
+        double tot_xs = react->total_xs( pdg_a, E ) * channel.weight;
+
+        // Cache the atom-fraction-weighted total cross section for sampling
+        // a reaction mode later
+        open_reactions_.push_back( channel.index );
+        total_xs_values_.push_back( tot_xs );
+
+        // Add the weighted total cross section value to the total
+        flavor_xs += tot_xs;
+      }
     }
 
-    // Cache the atom-fraction-weighted total cross section for sampling a
-    // reaction mode later
-    total_xs_values_.at( j ) = tot_xs;
+    if ( !multi_flavor ) {
+      pdf = flavor_xs;
+      break;
+    }
 
-    // Add the weighted total cross section value to the total
-    pdf += tot_xs;
+    // When the source produces more than one kind of neutrino, each flavor
+    // contributes according to its own part of the spectrum. Scale the
+    // cached reaction weights to match so that sample_reaction() chooses the
+    // flavor and the reaction jointly.
+    double flux = source_->flavor_pdf( pdg_a, E );
+    double scale = flux;
+    if ( !weight_flux_ ) scale = ( flavor_xs > 0. ) ? flux / flavor_xs : 0.;
+
+    for ( size_t k = first_value; k < total_xs_values_.size(); ++k ) {
+      total_xs_values_[ k ] *= scale;
+    }
+    pdf += flavor_xs * scale;
   }
 
+  // The flux has already been folded in for multi-flavor sources
+  if ( multi_flavor ) return pdf / norm_;
+
   // Normally, we want to fold the flux with the reaction cross section(s)
   // in order to obtain the distribution of reacting neutrino energies
   if ( weight_flux_ ) {
@@ -324,6 +552,10 @@ marley::Reaction& marley::Generator::sample_reaction(double& E) {
     " a reaction in marley::Generator::sample_reaction(). The vector of"
     " marley::Reaction objects owned by this generator is empty.");
 
+  if ( !reaction_cells_.empty() && weight_flux_ ) {
+    return this->sample_reaction_from_table( E );
+  }
+
   // Store the "old" value of E_pdf_max_, i.e., the one we had before calling
   // rejection_sample(). This will be used to check for problems.
   double old_max = E_pdf_max_;
@@ -366,11 +598,182 @@ marley::Reaction& marley::Generator::sample_reaction(double& E) {
 
   // The atom-fraction-weighted total cross section values have already been
   // updated by the final call to E_pdf() during rejection sampling, so we can
-  // now sample a reaction type using our discrete distribution object.
-  std::discrete_distribution<size_t>::param_type
-    params( total_xs_values_.begin(), total_xs_values_.end() );
-  size_t r_index = r_index_dist_( rand_gen_, params );
-  return *reactions_.at( r_index );
+  // now use them to sample a reaction. Only the reactions that are open at
+  // the sampled energy are listed.
+  if ( total_xs_values_.empty() ) throw marley::Error( "No reactions are"
+    " open at the sampled neutrino energy " + std::to_string(E) + " MeV" );
+
+  if ( reactions_.size() < 2u ) {
+    return *reactions_.at( open_reactions_.front() );
+  }
+
+  // Whenever more than one reaction is configured, draw exactly one uniform
+  // random number, even if only a single reaction is open at this energy.
+  // That keeps the random number stream independent of the thresholds.
+  double sum = std::accumulate( total_xs_values_.begin(),
+    total_xs_values_.end(), 0. );
+  double target = this->random_fraction() * sum;
+
+  size_t last = total_xs_values_.size() - 1u;
+  double cumulative_xs = 0.;
+  for ( size_t k = 0u; k < last; ++k ) {
+    cumulative_xs += total_xs_values_[ k ];
+    if ( cumulative_xs > target ) return *reactions_.at( open_reactions_[k] );
+  }
+  return *reactions_.at( open_reactions_[last] );
+}
+
+marley::Reaction& marley::Generator::sample_reaction_from_table( double& E )
+{
+  size_t num_cells = reaction_cells_.size();
+  while ( true ) {
+
+    // Choose a cell with probability proportional to the integral of its
+    // upper bound over the energy bin
+    size_t c = std::min( static_cast<size_t>(this->random_fraction()
+      * num_cells), num_cells - 1u );
+    if ( this->random_fraction() >= cell_cutoffs_[c] ) c = cell_aliases_[c];
+    ReactionCell& cell = reaction_cells_[ c ];
+
+    // Sample an energy uniformly within the bin, then accept or reject it
+    // using the exact flux-weighted cross section for the chosen Reaction
+    E = cell.E_low + cell.width * this->random_fraction();
+    double y = cell.bound * this->random_fraction();
+    double pdf = this->reaction_cell_pdf( cell, E );
+
+    if ( pdf > cell.bound ) {
+      MARLEY_LOG_WARNING() << "The flux-weighted total cross section "
+        << pdf << " at E = " << E << " MeV exceeded its estimated maximum "
+        << cell.bound << " in the reaction table. Using more energy bins"
+        << " (see the \"reaction_table_bins\" key) may avoid biasing the"
+        << " distribution of reacting neutrino energies.";
+      cell.bound = pdf * REACTION_TABLE_SAFETY_FACTOR;
+      this->build_reaction_alias_table();
+    }
+
+    if ( y < pdf ) return *reactions_.at( cell.index );
+  }
+}
+
+double marley::Generator::reaction_cell_pdf( const ReactionCell& cell,
+  double E ) const
+{
+  // Multi-flavor sources give the flux of each neutrino type separately
+  double flux;
+  if ( source_pdgs_.size() > 1u ) flux = source_->flavor_pdf( cell.pdg_a, E );
+  else flux = source_->pdf( E );
+  if ( flux <= 0. ) return 0.;
+
+  return flux * reactions_[ cell.index ]->total_xs( cell.pdg_a, E )
+    * cell.weight;
+}
+
+void marley::Generator::set_reaction_table_bins( int bins ) {
+  if ( bins < 0 ) throw marley::Error( "The number of energy bins in the"
+    " reaction table may not be negative" );
+  reaction_table_bins_ = bins;
+
+  // Don't bother to rebuild the table if there are no reactions defined yet
+  if ( reactions_.empty() || !source_ ) return;
+  this->normalize_E_pdf();
+}
+
+void marley::Generator::build_reaction_table() {
+
+  reaction_cells_.clear();
+  cell_cutoffs_.clear();
+  cell_aliases_.clear();
+
+  double E_min = source_->get_Emin();
+  double E_max = source_->get_Emax();
+  if ( reaction_table_bins_ < 1 || !weight_flux_ || E_min >= E_max ) return;
+
+  marley::StartupProfile::Phase phase( "Build reaction table" );
+
+  // Each upper bound is the largest value found at evenly spaced points
+  // within the bin (including its edges), multiplied by a safety factor
+  constexpr int NUM_PROBES = 8;
+
+  double width = ( E_max - E_min ) / reaction_table_bins_;
+  for ( int b = 0; b < reaction_table_bins_; ++b ) {
+    double E_low = E_min + b*width;
+    for ( int pdg_a : source_pdgs_ ) {
+
+      auto iter = reaction_index_.find( pdg_a );
+      if ( iter == reaction_index_.end() ) continue;
+
+      for ( const auto& channel : iter->second ) {
+        if ( E_low + width < channel.threshold ) continue;
+
+        ReactionCell cell{ channel.index, pdg_a, channel.weight, E_low,
+          width, 0. };
+        for ( int p = 0; p <= NUM_PROBES; ++p ) {
+          double E = E_low + ( width * p ) / NUM_PROBES;
+          cell.bound = std::max( cell.bound,
+            this->reaction_cell_pdf(cell, E) );
+        }
+
+        if ( cell.bound <= 0. ) continue;
+        cell.bound *= REACTION_TABLE_SAFETY_FACTOR;
+        reaction_cells_.push_back( cell );
+      }
+    }
+  }
+
+  if ( reaction_cells_.empty() ) throw marley::Error( "The flux-weighted"
+    " total cross section vanished everywhere while building the reaction"
+    " table. Please try using more energy bins." );
+
+  this->build_reaction_alias_table();
+
+  MARLEY_LOG_INFO() << "Built a reaction table with " << reaction_table_bins_
+    << " energy bins (" << reaction_cells_.size() << " nonempty cells)";
+}
+
+void marley::Generator::build_reaction_alias_table() {
+
+  // Set up the alias table using Vose's method. See, e.g., M. D. Vose,
+  // IEEE Trans. Softw. Eng. 17, 972 (1991).
+  size_t num_cells = reaction_cells_.size();
+  double total = 0.;
+  for ( const auto& cell : reaction_cells_ ) total += cell.bound * cell.width;
+
+  cell_cutoffs_.resize( num_cells );
+  cell_aliases_.resize( num_cells );
+
+  std::vector<size_t> small;
+  std::vector<size_t> large;
+  for ( size_t c = 0u; c < num_cells; ++c ) {
+    const auto& cell = reaction_cells_[ c ];
+    cell_cutoffs_[ c ] = cell.bound * cell.width * num_cells / total;
+    cell_aliases_[ c ] = c;
+    if ( cell_cutoffs_[c] < 1. ) small.push_back( c );
+    else large.push_back( c );
+  }
+
+  while ( !small.empty() && !large.empty() ) {
+    size_t s = small.back();
+    small.pop_back();
+    size_t l = large.back();
+
+    cell_aliases_[ s ] = l;
+    cell_cutoffs_[ l ] -= 1. - cell_cutoffs_[ s ];
+    if ( cell_cutoffs_[l] < 1. ) {
+      large.pop_back();
+      small.push_back( l );
+    }
+  }
+
+  // Any cells that remain differ from unit probability only because of
+  // rounding errors
+  for ( size_t c : small ) cell_cutoffs_[ c ] = 1.;
+  for ( size_t c : large ) cell_cutoffs_[ c ] = 1.;
+}
+
+double marley::Generator::random_fraction() {
+  // Unlike std::generate_canonical(), this gives the same result with every
+  // implementation of the standard library
+  return std::ldexp( static_cast<double>(rand_gen_() >> 11), -53 );
 }
 
 const marley::NeutrinoSource& marley::Generator::get_source() const {
@@ -393,6 +796,7 @@ void marley::Generator::set_source(
     // Transfer ownership of the neutrino source the generator, leaving
     // the std::unique_ptr passed to this function null afterwards.
     source_.reset( source.release() );
+    source_pdgs_ = source_->get_pids();
 
     // Don't bother to renormalize if there are no reactions defined yet
     if ( reactions_.empty() ) return;
@@ -411,9 +815,7 @@ void marley::Generator::add_reaction(std::unique_ptr<marley::Reaction> reaction)
     // Transfer ownership to a new unique_ptr in the reactions vector, leaving
     // the original empty
     reactions_.push_back( std::move(reaction) );
-
-    // Add a new entry in the reaction cross sections vector
-    total_xs_values_.push_back( 0. );
+    this->update_reaction_index();
 
     // TODO: consider adding a check to see whether source_ is non-null.
     // Right now, this shouldn't be possible, but an explicit check might
@@ -428,6 +830,11 @@ void marley::Generator::add_reaction(std::unique_ptr<marley::Reaction> reaction)
 void marley::Generator::clear_reactions() {
   reactions_.clear();
   total_xs_values_.clear();
+  open_reactions_.clear();
+  reaction_index_.clear();
+  reaction_cells_.clear();
+  cell_cutoffs_.clear();
+  cell_aliases_.clear();
   // Reset the normalization factor to 1. We don't need it until we define
   // one or more new reactions.
   norm_ = 1.;
@@ -525,14 +932,68 @@ double marley::Generator::flux_averaged_total_xs() const {
     avg_total_xs = norm_ / source_->pdf( Emin );
   }
   else {
-    double source_norm = marley_utils::num_integrate(
-      [this](double Ev) -> double { return this->source_->pdf(Ev); },
-      Emin, Emax);
+    double source_norm = source_->integrate( [](double) -> double
+      { return 1.; } );
 
     // Use the precomputed integral of the reacting neutrino energy PDF
     avg_total_xs = norm_ / source_norm;
   }
-  return avg_total_xs;
+
+  // Only events that pass the primary event cuts are produced
+  return avg_total_xs * this->cut_efficiency();
+}
+
+double marley::Generator::flux_averaged_total_xs( int pdg_a ) const {
+  if ( !weight_flux_ ) return 0.;
+
+  double avg_total_xs = 0.;
+
+  double Emin = source_->get_Emin();
+  double Emax = source_->get_Emax();
+  if ( Emin == Emax ) {
+    avg_total_xs = this->total_xs( pdg_a, Emin )
+      * source_->flavor_pdf( pdg_a, Emin ) / source_->pdf( Emin );
+  }
+  else {
+    double flavor_integral = 0.;
+    if ( source_->has_integral_table() && source_->get_pids().size() == 1u ) {
+      if ( pdg_a == source_->get_pid() ) {
+        flavor_integral = source_->integrate( [this, pdg_a](double Ev)
+          -> double { return this->total_xs( pdg_a, Ev ); } );
+      }
+    }
+    else {
+      flavor_integral = marley_utils::num_integrate(
+        [this, pdg_a](double Ev) -> double {
+          return this->source_->flavor_pdf( pdg_a, Ev )
+            * this->total_xs( pdg_a, Ev );
+        }, Emin, Emax );
+    }
+
+    double source_norm = source_->integrate( [](double) -> double
+      { return 1.; } );
+
+    avg_total_xs = flavor_integral / source_norm;
+  }
+
+  return avg_total_xs * this->cut_efficiency();
+}
+
+void marley::Generator::update_reaction_index() {
+  reaction_index_.clear();
+  for ( size_t j = 0u; j < reactions_.size(); ++j ) {
+    const auto& react = reactions_.at( j );
+
+    // If the target_ member has not been initialized, don't bother doing any
+    // weighting by atom fraction (equivalent to a weight of unity for all
+    // target atoms)
+    double weight = 1.;
+    if ( target_ ) weight = target_->atom_fraction( react->atomic_target() );
+    if ( weight == 0. ) continue;
+
+    reaction_index_[ react->pdg_a() ].push_back( ReactionChannel{ j, weight,
+      react->threshold_kinetic_energy() } );
+  }
 }
 
 void marley::Generator::set_target( std::unique_ptr<marley::Target> target )
@@ -542,6 +1003,7 @@ void marley::Generator::set_target( std::unique_ptr<marley::Target> target )
     // Transfer ownership of the neutrino target to the generator, leaving
     // the std::unique_ptr passed to this function null afterwards.
     target_.reset( target.release() );
+    this->update_reaction_index();
 
     // Don't bother to renormalize if there are no reactions defined yet
     if ( reactions_.empty() ) return;
@@ -593,6 +1055,9 @@ double marley::Generator::total_xs( int pdg_a, double KEa, int pdg_atom,
 marley::Event marley::Generator::create_event( int pdg_a, double KEa,
   int pdg_atom, const std::array<double, 3>& dir_vec )
 {
+  marley::Tracer::begin_event();
+  marley::Tracer::Span span( "Generator::create_event" );
+
   // (1) Sample a reaction mode from all configured reactions that can handle
   // the given initial-state parameters
   std::vector<size_t> indices;
@@ -614,23 +1079,34 @@ marley::Event marley::Generator::create_event( int pdg_a, double KEa,
 
   // (2) Create the prompt two-two scattering event using the sampled reaction
   // object
-  marley::Event ev = r->create_event( pdg_a, KEa, *this );
+  marley::Event ev = [&]() {
+    marley::Tracer::Span span( "Reaction::create_event", { {"E_nu", KEa} } );
+    return r->create_event( pdg_a, KEa, *this );
+  }();
+
+  // Use unit weights if needed (see sample_primary_event())
+  if ( ev.weights().empty() ) ev.weights().assign( universes_.size(), 1. );
 
   // Do the usual post-processing
 
   // (3) If needed, de-excite the final-state residue
   if ( do_deexcitations_ ) {
+    marley::Tracer::Span span( "NucleusDecayer::process_event" );
     marley::NucleusDecayer nd;
     nd.process_event( ev, *this );
   }
 
   // (4) If needed, rotate the event to match the desired projectile direction
-  // Set the incident neutrino direction for this event
-  static marley::ProjectileDirectionRotator my_rotator;
+  // Set the incident neutrino direction for this event. Each thread keeps
+  // its own rotator since Generators may be used concurrently.
+  thread_local marley::ProjectileDirectionRotator my_rotator;
   my_rotator.set_projectile_direction( dir_vec );
 
   // Rotate the coordinate system of the event if needed
-  my_rotator.process_event( ev, *this );
+  {
+    marley::Tracer::Span span( "ProjectileDirectionRotator::process_event" );
+    my_rotator.process_event( ev, *this );
+  }
 
   // Return the completed event object
   return ev;
@@ -666,3 +1142,74 @@ double marley::Generator::total_xs( int pdg_a, double KEa ) const {
 
   return tot_xsec;
 }
+
+void marley::Generator::total_xs( int pdg_a, const double* KEa,
+  size_t num_energies, double* total, double* per_reaction,
+  double* per_target ) const
+{
+  this->total_xs( &pdg_a, 0u, KEa, num_energies, total, per_reaction,
+    per_target );
+}
+
+void marley::Generator::total_xs( const int* pdg_a, const double* KEa,
+  size_t num_energies, double* total, double* per_reaction,
+  double* per_target ) const
+{
+  this->total_xs( pdg_a, 1u, KEa, num_energies, total, per_reaction,
+    per_target );
+}
+
+void marley::Generator::total_xs( const int* pdg_a, size_t pdg_stride,
+  const double* KEa, size_t num_energies, double* total, double* per_reaction,
+  double* per_target ) const
+{
+  if ( per_target && !target_ ) throw marley::Error( "Per-target total"
+    " cross sections were requested from a Generator without a Target" );
+
+  size_t num_reacts = reactions_.size();
+  size_t num_atoms = target_ ? target_->atom_fraction_map().size() : 0u;
+
+  if ( total ) std::fill( total, total + num_energies, 0. );
+  if ( per_reaction ) std::fill( per_reaction,
+    per_reaction + num_energies*num_reacts, 0. );
+  if ( per_target ) std::fill( per_target,
+    per_target + num_energies*num_atoms, 0. );
+
+  for ( size_t j = 0u; j < num_reacts; ++j ) {
+
+    const auto& r = reactions_.at( j );
+    int r_pdg_a = r->pdg_a();
+
+    // Look up the abundance weight and the position of the reaction's
+    // target atom in the atom fraction map once for all energies. As in the
+    // single-energy total_xs(), the weight is unity when no Target has been
+    // configured.
+    double weight = 1.;
+    size_t atom_idx = num_atoms;
+    if ( target_ ) {
+      const auto& fractions = target_->atom_fraction_map();
+      auto iter = fractions.find( r->atomic_target() );
+      if ( iter != fractions.end() ) {
+        weight = iter->second;
+        atom_idx = std::distance( fractions.begin(), iter );
+      }
+      else weight = 0.;
+    }
+
+    for ( size_t i = 0u; i < num_energies; ++i ) {
+
+      // Reactions return a vanishing cross section for other projectiles,
+      // so don't bother to call them
+      int pdg = pdg_a[ i*pdg_stride ];
+      if ( pdg != r_pdg_a ) continue;
+
+      double xsec = r->total_xs( pdg, KEa[i] );
+
+      if ( total ) total[i] += xsec * weight;
+      if ( per_reaction ) per_reaction[ i*num_reacts + j ] = xsec;
+      if ( per_target && atom_idx < num_atoms && xsec > 0. ) {
+        per_target[ i*num_atoms + atom_idx ] += xsec;
+      }
+    }
+  }
+}
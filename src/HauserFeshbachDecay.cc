@@ -46,7 +46,8 @@ void marley::HauserFeshbachDecay::build_exit_channels(
   // factor when computing exit channel decay widths. This isn't strictly
   // needed for MC sampling, but it's helpful to work with physically
   // meaningful units when possible.
-  marley::LevelDensityModel& ldm = sdb.get_level_density_model( Zi, Ai );
+  const marley::LevelDensityModel& ldm = sdb.get_level_density_model( Zi,
+    Ai );
   double rho_i = ldm.level_density( Exi_, twoJi_, Pi_ );
 
   total_width_ = 0.; // total compound nucleus decay width
@@ -192,13 +193,18 @@ void marley::HauserFeshbachDecay::build_exit_channels(
 
 bool marley::HauserFeshbachDecay::do_decay(double& Exf, int& twoJf,
   marley::Parity& Pf, marley::Particle& emitted_particle,
-  marley::Particle& residual_nucleus, marley::Generator& gen)
+  marley::Particle& residual_nucleus, marley::Generator& gen,
+  std::vector<double>* weights)
 {
   const auto& ec = this->sample_exit_channel( gen );
 
   ec->do_decay( Exf, twoJf, Pf, compound_nucleus_, emitted_particle,
     residual_nucleus, gen );
 
+  if ( weights && !weights->empty() ) {
+    gen.get_universes().weight_decay( *this, *ec, Exf, *weights );
+  }
+
   bool discrete_level = !ec->is_continuum();
   return !discrete_level;
 }
@@ -243,16 +249,14 @@ const std::unique_ptr<marley::ExitChannel>&
   if ( total_width_ <= 0. ) throw marley::Error("Cannot sample an exit channel"
     " for a Hauser-Feshbach decay. All partial decay widths are zero.");
 
-  // Sample an exit channel using a std::discrete distribution and a table of
-  // partial decay widths
+  // Sample an exit channel using the table of partial decay widths
   const auto widths_begin
     = marley::ExitChannel::make_width_iterator( exit_channels_.cbegin() );
   const auto widths_end
     = marley::ExitChannel::make_width_iterator( exit_channels_.cend() );
 
-  std::discrete_distribution<size_t> exit_channel_dist(widths_begin,
-    widths_end);
-  size_t exit_channel_index = gen.sample_from_distribution( exit_channel_dist );
+  size_t exit_channel_index = gen.sample_discrete( widths_begin,
+    widths_end );
 
   const auto& ec = exit_channels_.at( exit_channel_index );
   return ec;
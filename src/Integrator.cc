@@ -62,3 +62,29 @@ double marley::Integrator::num_integrate(const std::function<double(double)>& f,
 
   return A * integral;
 }
+
+void marley::Integrator::get_sampling_points(double a, double b,
+  std::vector<double>& points, std::vector<double>& weights) const
+{
+  double A = (b - a) / 2.;
+  double B = (b + a) / 2.;
+
+  points.clear();
+  weights.clear();
+
+  // Same terms as in num_integrate()
+  points.push_back( a );
+  weights.push_back( A * weights_[0] / 2. );
+  points.push_back( b );
+  weights.push_back( A * weights_[0] / 2. );
+  points.push_back( B );
+  weights.push_back( A * weights_[N_] );
+
+  for (size_t n = 1; n < N_; ++n) {
+    double epoint = A * offsets_[n - 1];
+    points.push_back( B + epoint );
+    weights.push_back( A * weights_[n] );
+    points.push_back( B - epoint );
+    weights.push_back( A * weights_[n] );
+  }
+}
@@ -15,10 +15,12 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 // standard library includes
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <vector>
 
 // MARLEY includes
@@ -29,7 +31,10 @@
 #include "marley/NeutrinoSource.hh"
 #include "marley/NuclearReaction.hh"
 #include "marley/Logger.hh"
+#include "marley/StartupProfile.hh"
 #include "marley/StructureDatabase.hh"
+#include "marley/SystematicUniverses.hh"
+#include "marley/TabulatedLevelDensityModel.hh"
 
 using InterpMethod = marley::InterpolationGrid<double>::InterpolationMethod;
 using ProcType = marley::Reaction::ProcessType;
@@ -38,6 +43,10 @@ using CMode = marley::NuclearReaction::CoulombMode;
 // anonymous namespace for helper functions, etc.
 namespace {
 
+  // Default settings for transmission coefficient tables
+  constexpr double DEFAULT_TABLE_TOLERANCE = 1e-3;
+  constexpr double DEFAULT_TABLE_MAX_ENERGY = 100.; // MeV
+
   void source_check_positive(double x, const char* description,
     const char* source_type)
   {
@@ -97,9 +106,10 @@ namespace {
 
 }
 
-marley::JSONConfig::JSONConfig(const marley::JSON& json) : json_(json)
+marley::JSONConfig::JSONConfig(const marley::JSON& json,
+  bool configure_logger) : json_(json)
 {
-  update_logger_settings();
+  if ( configure_logger ) update_logger_settings();
 }
 
 marley::JSONConfig::JSONConfig(const std::string& json_filename)
@@ -140,6 +150,8 @@ int marley::JSONConfig::neutrino_pdg(const std::string& nu) const {
 
 marley::Generator marley::JSONConfig::create_generator() const
 {
+  marley::StartupProfile::Phase phase( "Create generator" );
+
   uint_fast64_t seed;
   if (json_.has_key("seed")) {
     bool ok;
@@ -158,10 +170,24 @@ marley::Generator marley::JSONConfig::create_generator() const
 
   // Use the JSON settings to update the generator's parameters
   prepare_direction( gen );
-  prepare_structure( gen );
-  prepare_neutrino_source( gen );
-  prepare_reactions( gen );
-  prepare_target( gen );
+  {
+    marley::StartupProfile::Phase structure_phase( "Configure structure"
+      " data" );
+    prepare_structure( gen );
+  }
+  {
+    marley::StartupProfile::Phase source_phase( "Configure neutrino"
+      " source" );
+    prepare_neutrino_source( gen );
+  }
+  {
+    marley::StartupProfile::Phase reactions_phase( "Configure reactions" );
+    prepare_reactions( gen );
+  }
+  {
+    marley::StartupProfile::Phase target_phase( "Configure target" );
+    prepare_target( gen );
+  }
 
   // If the user has disabled nuclear de-excitations, then set the
   // flag appropriately.
@@ -176,6 +202,52 @@ marley::Generator marley::JSONConfig::create_generator() const
     }
   }
 
+  // If the user has requested it, sample the reactions using a table of
+  // upper bounds on the flux-weighted cross sections. The table is built
+  // when the energy PDF is normalized below.
+  if ( json_.has_key("reaction_table_bins") ) {
+    bool ok;
+    const auto& rtb = json_.at("reaction_table_bins");
+    long bins = rtb.to_long( ok );
+    if ( !ok || bins < 0 || bins > std::numeric_limits<int>::max() ) {
+      handle_json_error("reaction_table_bins", rtb);
+    }
+    gen.set_reaction_table_bins( static_cast<int>(bins) );
+  }
+
+  // If the user has requested cuts on the primary (two-two scattering)
+  // events, then configure them. The cut efficiency will be estimated when
+  // the energy PDF is normalized below.
+  if ( json_.has_key("primary_cuts") ) {
+    const auto& cuts = json_.at("primary_cuts");
+    marley::PrimaryEventFilter filter( cuts );
+
+    long pilot_events = marley::Generator::DEFAULT_PILOT_EVENTS_;
+    if ( cuts.has_key("pilot_events") ) {
+      bool ok;
+      const auto& pe = cuts.at("pilot_events");
+      pilot_events = pe.to_long( ok );
+      if ( !ok || pilot_events < 1 ) handle_json_error("pilot_events", pe);
+    }
+
+    gen.set_primary_filter( filter, pilot_events );
+    if ( !filter.empty() ) {
+      MARLEY_LOG_INFO() << "Primary event cuts: " << filter.to_string();
+    }
+  }
+
+  // If the user has defined systematic universes, then configure them. This
+  // is done before the early returns below so that the universes also
+  // apply to decay-only jobs.
+  if ( json_.has_key("universes") ) {
+    marley::SystematicUniverses universes( json_.at("universes") );
+    gen.set_universes( universes );
+    if ( !universes.empty() ) {
+      MARLEY_LOG_INFO() << "Systematic weights will be computed for "
+        << universes.size() << " universes";
+    }
+  }
+
   // Skip the rest of initialization if we've disabled all reactions.
   // This can be used to partially initialize the Generator in unusual
   // situations.
@@ -188,6 +260,11 @@ marley::Generator marley::JSONConfig::create_generator() const
     }
   }
 
+  // Decay-only jobs (see marley::DecayOnlyGenerator) start from a list of
+  // excited nuclear states rather than from neutrino reactions, so the
+  // remaining checks do not apply to them.
+  if ( json_.has_key("initial_states") ) return gen;
+
   // Set the method to use for computing Coulomb corrections in all reactions.
   // If the user gave an explicit setting for this, use that.
   // Otherwise, interpolate between the Fermi function and the modified
@@ -228,14 +305,30 @@ marley::Generator marley::JSONConfig::create_generator() const
 
   // Now that the reactions and source are both prepared, check that a neutrino
   // from the source can interact via at least one of the enabled reactions
+  std::vector<int> source_pdgs = gen.get_source().get_pids();
+  auto source_produces = [&source_pdgs](int pdg) -> bool {
+    return std::find( source_pdgs.begin(), source_pdgs.end(), pdg )
+      != source_pdgs.end();
+  };
+
   bool found_matching_pdg = false;
-  int source_pdg = gen.get_source().get_pid();
-  for ( const auto& react : gen.get_reactions() ) {
-    if ( source_pdg == react->pdg_a() ) found_matching_pdg = true;
+  for ( int source_pdg : source_pdgs ) {
+    bool found_this_pdg = false;
+    for ( const auto& react : gen.get_reactions() ) {
+      if ( source_pdg == react->pdg_a() ) found_this_pdg = true;
+    }
+    // Neutrino types from a composite source that can't interact are merely
+    // wasted flux
+    if ( !found_this_pdg && source_pdgs.size() > 1u ) {
+      MARLEY_LOG_WARNING() << "The neutrino source produces "
+        << marley_utils::get_particle_symbol( source_pdg ) << ", which cannot"
+        << " participate in any of the configured reactions.";
+    }
+    found_matching_pdg = found_matching_pdg || found_this_pdg;
   }
   // If neutrinos from the source can never interact, then complain about it
   if ( !found_matching_pdg ) throw marley::Error("The neutrino source"
-    " produces " + marley_utils::get_particle_symbol(source_pdg)
+    " produces " + marley_utils::get_particle_symbol(source_pdgs.front())
     + ", which cannot participate in any of the configured reactions.");
 
   // Before returning the newly-created Generator object, print logging
@@ -246,7 +339,7 @@ marley::Generator marley::JSONConfig::create_generator() const
     const marley::TargetAtom ta = r->atomic_target();
     double atom_frac = gen.get_target().atom_fraction( ta );
 
-    if ( r->pdg_a() == source_pdg && atom_frac > 0. ) {
+    if ( source_produces(r->pdg_a()) && atom_frac > 0. ) {
 
       std::string proc_type_str;
       if ( r->process_type() == ProcType::NeutrinoCC
@@ -295,6 +388,18 @@ marley::Generator marley::JSONConfig::create_generator() const
     << marley_utils::hbar_c2 * avg_tot_xs * marley_utils::fm2_to_minus40_cm2
     << " * 10^(-40) cm^2";
 
+  // For sources that produce more than one kind of neutrino, also report the
+  // contribution of each one
+  if ( source_pdgs.size() > 1u && avg_tot_xs > 0. ) {
+    for ( int pdg : source_pdgs ) {
+      double flavor_xs = gen.flux_averaged_total_xs( pdg );
+      MARLEY_LOG_INFO() << "  " << marley_utils::get_particle_symbol( pdg )
+        << ": " << marley_utils::hbar_c2 * flavor_xs
+        * marley_utils::fm2_to_minus40_cm2 << " * 10^(-40) cm^2 ("
+        << 100. * flavor_xs / avg_tot_xs << "% of events)";
+    }
+  }
+
   return gen;
 }
 
@@ -434,6 +539,9 @@ void marley::JSONConfig::prepare_reactions(marley::Generator& gen) const {
     handle_json_error("reactions", rs);
   }
 
+  // Decay-only jobs don't need any reactions
+  if ( json_.has_key("initial_states") ) return;
+
   throw marley::Error("Missing \"reactions\" key in the MARLEY configuration"
     " file.");
 }
@@ -483,6 +591,141 @@ void marley::JSONConfig::prepare_structure(marley::Generator& gen) const
       << " differential decay widths set to l_max = " << g_lmax;
   }
 
+  // Numerical resolution settings for the continuum decay calculations.
+  // These are normally chosen with the help of the martune program.
+  std::string numerov_key( "numerov_step_size" );
+  if ( json_.has_key(numerov_key) ) {
+    bool ok;
+    const marley::JSON& step_json = json_.at( numerov_key );
+    double step_size = step_json.to_double( ok );
+    if ( !ok ) handle_json_error( numerov_key.c_str(), step_json );
+
+    sdb.set_numerov_step_size( step_size );
+
+    MARLEY_LOG_INFO() << "Optical model Numerov step size set to "
+      << step_size << " fm";
+  }
+
+  std::string quad_key( "continuum_quadrature_order" );
+  if ( json_.has_key(quad_key) ) {
+    bool ok;
+    const marley::JSON& quad_json = json_.at( quad_key );
+    int order = quad_json.to_long( ok );
+    if ( !ok ) handle_json_error( quad_key.c_str(), quad_json );
+
+    sdb.set_continuum_quadrature_order( order );
+
+    MARLEY_LOG_INFO() << "Continuum decay widths will be integrated using "
+      << 2*order + 1 << " quadrature points";
+  }
+
+  std::string cheb_key( "continuum_chebyshev_points" );
+  if ( json_.has_key(cheb_key) ) {
+    bool ok;
+    const marley::JSON& cheb_json = json_.at( cheb_key );
+    int num_points = cheb_json.to_long( ok );
+    if ( !ok ) handle_json_error( cheb_key.c_str(), cheb_json );
+
+    sdb.set_continuum_chebyshev_points( num_points );
+
+    MARLEY_LOG_INFO() << "Continuum excitation energy distributions will be"
+      << " approximated using " << num_points << " Chebyshev points";
+  }
+
+  std::string sampling_key( "continuum_sampling_tolerance" );
+  if ( json_.has_key(sampling_key) ) {
+    bool ok;
+    const marley::JSON& sampling_json = json_.at( sampling_key );
+    double tolerance = sampling_json.to_double( ok );
+    if ( !ok ) handle_json_error( sampling_key.c_str(), sampling_json );
+
+    sdb.set_continuum_sampling_tolerance( tolerance );
+
+    MARLEY_LOG_INFO() << "Continuum excitation energies will be sampled"
+      << " with a bisection tolerance of " << tolerance << " MeV";
+  }
+
+  // Build tables of fragment transmission coefficients in the background
+  // if requested
+  std::string tt_key( "transmission_tables" );
+  if ( json_.has_key(tt_key) ) {
+    const marley::JSON& tt = json_.at( tt_key );
+    if ( !tt.is_object() ) throw marley::Error( "The value given for the"
+      " \"" + tt_key + "\" key must be a JSON object" );
+
+    double tolerance = DEFAULT_TABLE_TOLERANCE;
+    double E_max = DEFAULT_TABLE_MAX_ENERGY;
+    long num_threads = 1;
+    bool ok = true;
+    if ( tt.has_key("tolerance") ) tolerance = tt.at( "tolerance" )
+      .to_double( ok );
+    if ( !ok ) handle_json_error( "transmission_tables.tolerance",
+      tt.at("tolerance") );
+    if ( tt.has_key("max_energy") ) E_max = tt.at( "max_energy" )
+      .to_double( ok );
+    if ( !ok ) handle_json_error( "transmission_tables.max_energy",
+      tt.at("max_energy") );
+    if ( tt.has_key("threads") ) num_threads = tt.at( "threads" )
+      .to_long( ok );
+    if ( !ok ) handle_json_error( "transmission_tables.threads",
+      tt.at("threads") );
+
+    sdb.enable_transmission_tables( tolerance, E_max, num_threads );
+
+    MARLEY_LOG_INFO() << "Transmission coefficients up to " << E_max
+      << " MeV will be tabulated in the background using " << num_threads
+      << " thread(s) (relative tolerance " << tolerance << ')';
+  }
+
+  // Replace the default level density model by tabulated microscopic level
+  // densities for the requested nuclides
+  std::string ldt_key( "level_density_tables" );
+  if ( json_.has_key(ldt_key) ) {
+    const marley::JSON& tables = json_.at( ldt_key );
+    if ( !tables.is_array() ) throw marley::Error( "The value given for the"
+      " \"" + ldt_key + "\" key must be a JSON array" );
+
+    const auto& fm = marley::FileManager::Instance();
+
+    for ( const auto& table : tables.array_range() ) {
+      if ( !table.is_object() || !table.has_key("file")
+        || !table.has_key("nuclides") )
+      {
+        throw marley::Error( "Invalid level density table specification "
+          + table.dump_string() + ". The \"file\" and \"nuclides\" keys"
+          " are required." );
+      }
+
+      std::string file_name = table.at( "file" ).to_string();
+      std::string full_file_name = fm.find_file( file_name );
+      if ( full_file_name.empty() ) throw marley::Error( "Could not locate"
+        " the level density table file " + file_name + ". Please check"
+        " that the file name is spelled correctly and that the file is in"
+        " a folder on the MARLEY search path." );
+
+      const marley::JSON& nuclides = table.at( "nuclides" );
+      if ( !nuclides.is_array() ) throw marley::Error( "Invalid"
+        " \"nuclides\" array given in the level density table"
+        " specification " + table.dump_string() );
+
+      for ( const auto& nuc : nuclides.array_range() ) {
+        bool ok = false;
+        int nuc_pdg = nuc.to_long( ok );
+        if ( !ok ) handle_json_error( "nuclides", nuc );
+
+        int Z = marley_utils::get_particle_Z( nuc_pdg );
+        int A = marley_utils::get_particle_A( nuc_pdg );
+
+        sdb.add_level_density_model( nuc_pdg,
+          std::make_unique<marley::TabulatedLevelDensityModel>(
+          full_file_name, Z, A) );
+
+        MARLEY_LOG_INFO() << "Loaded tabulated level densities for "
+          << marley::TargetAtom( nuc_pdg ) << " from "
+          << full_file_name;
+      }
+    }
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -549,11 +792,33 @@ void marley::JSONConfig::prepare_neutrino_source(marley::Generator& gen) const
     return;
   }
 
+  std::unique_ptr<marley::NeutrinoSource> source
+    = this->create_neutrino_source( source_spec );
+
+  // If the user has specified whether to weight the incident neutrino spectrum
+  // by the reaction cross section(s), then set the weight_flux_ flag in the
+  // new Generator object accordingly
+  if ( source_spec.has_key("weight_flux") ) {
+    bool ok = false;
+    bool should_we_weight = source_spec.at("weight_flux").to_bool(ok);
+    if (!ok) handle_json_error("source.weight_flux",
+      source_spec.at("weight_flux"));
+    gen.set_weight_flux(should_we_weight);
+  }
+
+  // Load the generator with the new source object
+  gen.set_source( std::move(source) );
+
+}
+
+std::unique_ptr<marley::NeutrinoSource>
+  marley::JSONConfig::create_neutrino_source(
+  const marley::JSON& source_spec, bool allow_composite) const
+{
   // Complain if the user didn't specify a source type
   if ( !source_spec.has_key("type") ) {
     throw marley::Error(std::string("Missing \"type\" key in")
       + " neutrino source specification.");
-    return;
   }
 
   // Get the neutrino source type
@@ -561,11 +826,48 @@ void marley::JSONConfig::prepare_neutrino_source(marley::Generator& gen) const
   std::string type = source_spec.at("type").to_string(ok);
   if ( !ok ) handle_json_error("source.type", source_spec.at("type"));
 
+  // A composite source combines several other sources, each of which is
+  // configured just like a standalone one
+  if ( type == "composite" ) {
+    if ( !allow_composite ) throw marley::Error( "Composite neutrino"
+      " sources may not be nested" );
+
+    if ( !source_spec.has_key("components") ) throw marley::Error(
+      "Missing \"components\" key in composite neutrino source"
+      " specification." );
+
+    const marley::JSON& comp_specs = source_spec.at( "components" );
+    if ( !comp_specs.is_array() ) throw marley::Error( "The value given"
+      " for the components key for a composite source should be an array." );
+
+    std::vector< std::unique_ptr<marley::NeutrinoSource> > components;
+    std::vector<double> weights;
+    for ( const auto& comp_spec : comp_specs.array_range() ) {
+      double weight = 1.;
+      if ( comp_spec.has_key("weight") ) weight = source_get_double( "weight",
+        comp_spec, "composite" );
+      source_check_positive( weight, "weight", "composite" );
+
+      components.push_back( this->create_neutrino_source(comp_spec, false) );
+      weights.push_back( weight );
+    }
+
+    auto composite = std::make_unique<marley::CompositeNeutrinoSource>(
+      std::move(components), weights );
+
+    MARLEY_LOG_INFO() << "Created composite source with flux fractions";
+    for ( int pdg : composite->get_pids() ) {
+      MARLEY_LOG_INFO() << "  " << marley_utils::get_particle_symbol( pdg )
+        << ": " << composite->flux_fraction( pdg );
+    }
+
+    return composite;
+  }
+
   // Complain if the user didn't specify a neutrino type
   if (!source_spec.has_key("neutrino")) {
     throw marley::Error(std::string("Missing \"neutrino\" key in")
       + " neutrino source specification.");
-    return;
   }
   // Get the neutrino type
   std::string nu = source_spec.at("neutrino").to_string(ok);
@@ -691,25 +993,53 @@ void marley::JSONConfig::prepare_neutrino_source(marley::Generator& gen) const
     MARLEY_LOG_INFO() << "Created grid "
       << marley_utils::get_particle_symbol(pdg) << " source";
   }
+  else if (type == "file") {
+    std::string file_name = source_get("file", source_spec, "flux file",
+      nullptr);
+    std::string format_str = source_get("format", source_spec, "flux file",
+      "text");
+    std::string rule = source_get("rule", source_spec, "flux file",
+      "linlin");
+
+    using Format = marley::FluxFileNeutrinoSource::Format;
+    Format format = Format::Text;
+    if ( format_str == "binary" ) format = Format::Binary;
+    else if ( format_str != "text" ) throw marley::Error( "Invalid format \""
+      + format_str + "\" given for a flux file neutrino source. Allowed"
+      " values are \"text\" and \"binary\"." );
+
+    // Zero-based column indices used when reading a text file
+    size_t columns[2] = { 0u, 1u };
+    const char* column_keys[2] = { "energy_column", "flux_column" };
+    for ( size_t k = 0u; k < 2u; ++k ) {
+      if ( !source_spec.has_key(column_keys[k]) ) continue;
+      long col = source_spec.at( column_keys[k] ).to_long( ok );
+      if ( !ok || col < 0 ) throw marley::Error( std::string("Invalid value"
+        " given for source.") + column_keys[k] + " key for flux file"
+        " source" );
+      columns[k] = static_cast<size_t>( col );
+    }
+
+    const auto& fm = marley::FileManager::Instance();
+    std::string full_file_name = fm.find_file( file_name );
+    if ( full_file_name.empty() ) throw marley::Error( "Could not locate"
+      " the neutrino flux file " + file_name );
+
+    auto file_source = std::make_unique<marley::FluxFileNeutrinoSource>(
+      full_file_name, pdg, format, get_interpolation_method(rule),
+      columns[0], columns[1] );
+    MARLEY_LOG_INFO() << "Created "
+      << marley_utils::get_particle_symbol(pdg) << " source from the flux"
+      << " file " << full_file_name << " (" << file_source->num_points()
+      << " grid points)";
+    source = std::move( file_source );
+  }
   else if (!process_extra_source_types(type, source_spec, pdg, source)) {
     throw marley::Error(std::string("Unrecognized MARLEY neutrino source")
       + " type '" + type + "'");
   }
 
-  // If the user has specified whether to weight the incident neutrino spectrum
-  // by the reaction cross section(s), then set the weight_flux_ flag in the
-  // new Generator object accordingly
-  if ( source_spec.has_key("weight_flux") ) {
-    bool ok = false;
-    bool should_we_weight = source_spec.at("weight_flux").to_bool(ok);
-    if (!ok) handle_json_error("source.weight_flux",
-      source_spec.at("weight_flux"));
-    gen.set_weight_flux(should_we_weight);
-  }
-
-  // Load the generator with the new source object
-  gen.set_source( std::move(source) );
-
+  return source;
 }
 
 void marley::JSONConfig::prepare_target( marley::Generator& gen ) const {
@@ -0,0 +1,354 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+// POSIX includes
+#include "dirent.h"
+#include "fcntl.h"
+#include "sys/stat.h"
+#include "unistd.h"
+#include "utime.h"
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/JobQueue.hh"
+#include "marley/Logger.hh"
+
+namespace {
+
+  // Name of the subfolder of the queue directory that holds the job state.
+  // It is created by renaming a fully prepared staging folder, which
+  // ensures that only one process initializes the queue.
+  const std::string JOB_FOLDER = "job";
+
+  const std::string DESCRIPTION_FILE = "queue.json";
+  const std::string MERGE_LOCK_FILE = "merge.lock";
+  const std::string MERGED_FILE = "merged";
+
+  const std::vector<std::string> SUBFOLDERS = { "todo", "claimed", "done",
+    "output" };
+
+  void make_directory( const std::string& name ) {
+    if ( ::mkdir( name.c_str(), 0777 ) != 0 && errno != EEXIST ) {
+      throw marley::Error( "Could not create the job queue folder \""
+        + name + "\": " + std::strerror(errno) );
+    }
+  }
+
+  bool file_exists( const std::string& name ) {
+    struct stat info;
+    return ::stat( name.c_str(), &info ) == 0;
+  }
+
+  // Creates an empty file (or updates its modification time if it already
+  // exists)
+  void touch( const std::string& name ) {
+    int fd = ::open( name.c_str(), O_WRONLY | O_CREAT, 0666 );
+    if ( fd < 0 ) throw marley::Error( "Could not create the job queue"
+      " file \"" + name + "\": " + std::strerror(errno) );
+    ::close( fd );
+  }
+
+  void rename_or_throw( const std::string& from, const std::string& to ) {
+    if ( ::rename(from.c_str(), to.c_str()) != 0 ) {
+      throw marley::Error( "Could not rename \"" + from + "\" to \"" + to
+        + "\": " + std::strerror(errno) );
+    }
+  }
+
+  long get_positive_long( const marley::JSON& json, const std::string& key )
+  {
+    bool ok = json.has_key( key );
+    long value = 0;
+    if ( ok ) value = json.at( key ).to_long( ok );
+    if ( !ok || value <= 0 ) throw marley::Error( "The job queue"
+      " description must contain a positive integer value for the \""
+      + key + "\" key" );
+    return value;
+  }
+
+  std::string get_owner_id() {
+    char host[ 256 ];
+    if ( ::gethostname(host, sizeof(host)) != 0 ) std::strcpy( host,
+      "unknown" );
+    host[ sizeof(host) - 1 ] = '\0';
+    return std::string( host ) + '-' + std::to_string( ::getpid() );
+  }
+}
+
+marley::JobQueue::JobQueue( const std::string& directory,
+  const marley::JSON& description, double timeout )
+  : directory_( directory ), job_directory_( directory + '/' + JOB_FOLDER ),
+  timeout_( timeout ), owner_( get_owner_id() )
+{
+  if ( !(timeout_ > 0.) ) throw marley::Error( "The timeout for abandoned"
+    " job queue units must be positive" );
+
+  make_directory( directory_ );
+  this->initialize( description );
+}
+
+void marley::JobQueue::initialize( const marley::JSON& description ) {
+
+  std::string description_file = path( "", DESCRIPTION_FILE );
+
+  if ( !file_exists(description_file) ) {
+
+    num_events_ = get_positive_long( description, "events" );
+    events_per_unit_ = get_positive_long( description, "events_per_unit" );
+    num_units_ = ( num_events_ + events_per_unit_ - 1 ) / events_per_unit_;
+
+    // Prepare the complete queue in a private staging folder, then publish
+    // it with a single rename
+    std::string staging = directory_ + "/.staging." + owner_;
+    make_directory( staging );
+    for ( const auto& sub : SUBFOLDERS ) make_directory( staging + '/' + sub );
+
+    std::ofstream out( staging + '/' + DESCRIPTION_FILE );
+    out << description.dump_string() << '\n';
+    out.close();
+    if ( !out ) throw marley::Error( "Could not write the job queue"
+      " description to " + staging );
+
+    for ( long u = 0; u < num_units_; ++u ) {
+      touch( staging + "/todo/" + unit_name(u) );
+    }
+
+    if ( ::rename(staging.c_str(), job_directory_.c_str()) == 0 ) {
+      MARLEY_LOG_INFO() << "Created job queue with " << num_units_
+        << " work units in " << directory_;
+    }
+    else {
+      // Another process created the queue first, so discard the staging
+      // folder and use theirs
+      for ( long u = 0; u < num_units_; ++u ) {
+        ::unlink( (staging + "/todo/" + unit_name(u)).c_str() );
+      }
+      ::unlink( (staging + '/' + DESCRIPTION_FILE).c_str() );
+      for ( const auto& sub : SUBFOLDERS ) {
+        ::rmdir( (staging + '/' + sub).c_str() );
+      }
+      ::rmdir( staging.c_str() );
+    }
+  }
+
+  description_ = marley::JSON::load_file( description_file );
+  num_events_ = get_positive_long( description_, "events" );
+  events_per_unit_ = get_positive_long( description_, "events_per_unit" );
+  num_units_ = ( num_events_ + events_per_unit_ - 1 ) / events_per_unit_;
+}
+
+std::string marley::JobQueue::unit_name( long index ) const {
+  std::ostringstream oss;
+  oss << "unit_" << std::setw( 10 ) << std::setfill( '0' ) << index;
+  return oss.str();
+}
+
+std::string marley::JobQueue::path( const std::string& folder,
+  const std::string& name ) const
+{
+  std::string result = job_directory_;
+  if ( !folder.empty() ) result += '/' + folder;
+  if ( !name.empty() ) result += '/' + name;
+  return result;
+}
+
+marley::JobQueue::Unit marley::JobQueue::make_unit( long index ) const {
+  long first = index * events_per_unit_;
+  return { index, first, std::min(events_per_unit_, num_events_ - first) };
+}
+
+std::vector<std::string> marley::JobQueue::list(
+  const std::string& folder ) const
+{
+  std::vector<std::string> names;
+  std::string dir_name = path( folder );
+  DIR* dir = ::opendir( dir_name.c_str() );
+  if ( !dir ) throw marley::Error( "Could not read the job queue folder \""
+    + dir_name + "\": " + std::strerror(errno) );
+
+  while ( const dirent* entry = ::readdir(dir) ) {
+    // Skip ".", "..", and temporary files
+    if ( entry->d_name[0] == '.' ) continue;
+    names.emplace_back( entry->d_name );
+  }
+  ::closedir( dir );
+
+  std::sort( names.begin(), names.end() );
+  return names;
+}
+
+double marley::JobQueue::age( const std::string& file_name ) const {
+  struct stat info;
+  if ( ::stat(file_name.c_str(), &info) != 0 ) return -1.;
+  return std::difftime( std::time(nullptr), info.st_mtime );
+}
+
+bool marley::JobQueue::claim( Unit& unit ) {
+
+  while ( true ) {
+    for ( const auto& name : list("todo") ) {
+      // Renaming fails if another process claimed the unit first
+      std::string claimed = path( "claimed", name + '.' + owner_ );
+      if ( ::rename(path("todo", name).c_str(), claimed.c_str()) != 0 ) {
+        continue;
+      }
+
+      // The rename keeps the old modification time, so update it
+      // right away to avoid looking abandoned
+      ::utime( claimed.c_str(), nullptr );
+
+      long index = std::stol( name.substr(name.find('_') + 1) );
+      unit = make_unit( index );
+      return true;
+    }
+
+    // Return any abandoned units to the queue and try again
+    bool reclaimed = false;
+    for ( const auto& name : list("claimed") ) {
+      std::string claimed = path( "claimed", name );
+      if ( age(claimed) <= timeout_ ) continue;
+
+      std::string base = name.substr( 0, name.find('.') );
+      if ( ::rename(claimed.c_str(), path("todo", base).c_str()) == 0 ) {
+        MARLEY_LOG_WARNING() << "Returned the abandoned work unit " << base
+          << " (claimed by " << name.substr( base.size() + 1 ) << ") to the"
+          << " job queue";
+        reclaimed = true;
+      }
+    }
+
+    if ( !reclaimed ) return false;
+  }
+}
+
+void marley::JobQueue::heartbeat( const Unit& unit ) const {
+  // If this fails, the unit was already reclaimed by another process.
+  // Since units are generated deterministically, finishing it anyway is
+  // harmless.
+  std::string claimed = path( "claimed", unit_name(unit.index) + '.'
+    + owner_ );
+  ::utime( claimed.c_str(), nullptr );
+}
+
+void marley::JobQueue::release( const Unit& unit ) const {
+  std::string name = unit_name( unit.index );
+  ::rename( path("claimed", name + '.' + owner_).c_str(),
+    path("todo", name).c_str() );
+}
+
+std::string marley::JobQueue::unit_output_name( const Unit& unit,
+  size_t file_index ) const
+{
+  return path( "output", '.' + unit_name(unit.index) + ".f"
+    + std::to_string(file_index) + '.' + owner_ );
+}
+
+void marley::JobQueue::complete( const Unit& unit,
+  const std::vector<long>& header_bytes ) const
+{
+  std::string name = unit_name( unit.index );
+
+  marley::JSON info = marley::JSON::object();
+  info[ "events" ] = unit.num_events;
+  info[ "owner" ] = marley::JSON( owner_ );
+  marley::JSON headers = marley::JSON::array();
+  for ( size_t f = 0u; f < header_bytes.size(); ++f ) {
+    headers.append( header_bytes.at(f) );
+    rename_or_throw( unit_output_name(unit, f), path("output", name + ".f"
+      + std::to_string(f)) );
+  }
+  info[ "header_bytes" ] = headers;
+
+  std::string temp_done = path( "done", '.' + name + '.' + owner_ );
+  std::ofstream out( temp_done );
+  out << info.dump_string() << '\n';
+  out.close();
+  if ( !out ) throw marley::Error( "Could not write the job queue file \""
+    + temp_done + '\"' );
+  rename_or_throw( temp_done, path("done", name) );
+
+  ::unlink( path("claimed", name + '.' + owner_).c_str() );
+}
+
+long marley::JobQueue::num_done() const {
+  return static_cast<long>( list("done").size() );
+}
+
+bool marley::JobQueue::merged() const {
+  return file_exists( path("", MERGED_FILE) );
+}
+
+bool marley::JobQueue::merge( const std::vector<std::string>& file_names )
+  const
+{
+  if ( !this->finished() ) throw marley::Error( "Cannot merge the job queue"
+    " output files in " + directory_ + " before all units are done" );
+
+  // Only one process may hold the merge lock. A lock left behind by a
+  // process that died during the merge is removed after the timeout.
+  std::string lock = path( "", MERGE_LOCK_FILE );
+  int fd = ::open( lock.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666 );
+  if ( fd < 0 && errno == EEXIST && !merged() && age(lock) > timeout_ ) {
+    ::unlink( lock.c_str() );
+    fd = ::open( lock.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666 );
+  }
+  if ( fd < 0 ) return false;
+  ::close( fd );
+
+  for ( size_t f = 0u; f < file_names.size(); ++f ) {
+    const std::string& final_name = file_names.at( f );
+    std::string temp_name = final_name + ".tmp." + owner_;
+    std::ofstream out( temp_name, std::ios::binary );
+    if ( !out ) throw marley::Error( "Could not open the merged output"
+      " file \"" + temp_name + '\"' );
+
+    for ( long u = 0; u < num_units_; ++u ) {
+      std::string name = unit_name( u );
+      std::ifstream in( path("output", name + ".f" + std::to_string(f)),
+        std::ios::binary );
+      if ( !in ) throw marley::Error( "Missing output file for job queue"
+        " unit " + name );
+
+      // Keep the header (e.g., the flux-averaged total cross section) only
+      // for the first unit
+      if ( u > 0 ) {
+        marley::JSON info = marley::JSON::load_file( path("done", name) );
+        in.seekg( info.at("header_bytes").at(f).to_long() );
+      }
+      if ( in.peek() != std::ifstream::traits_type::eof() ) out << in.rdbuf();
+
+      ::utime( lock.c_str(), nullptr );
+    }
+
+    out.close();
+    if ( !out ) throw marley::Error( "Could not write the merged output"
+      " file \"" + temp_name + '\"' );
+    rename_or_throw( temp_name, final_name );
+  }
+
+  touch( path("", MERGED_FILE) );
+  return true;
+}
@@ -14,6 +14,8 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+#include <algorithm>
+
 #include "marley/marley_utils.hh"
 #include "marley/HauserFeshbachDecay.hh"
 #include "marley/Logger.hh"
@@ -24,49 +26,53 @@
 std::complex<double>
 marley::KoningDelarocheOpticalModel::optical_model_potential(double r,
   double fragment_KE_lab, int fragment_pdg, int two_j, int l, int two_s,
-  int target_charge)
+  int target_charge, Workspace& ws) const
 {
-  update_target_mass( target_charge );
+  update_target_mass( target_charge, ws );
+  double KE_tot_CM = total_KE_CM( fragment_KE_lab, fragment_pdg, ws );
+  calculate_kinematic_variables( KE_tot_CM, fragment_pdg, ws );
+  calculate_om_parameters( fragment_pdg, two_j, l, two_s, ws );
+  return omp( r, ws );
+}
 
-  // The calculate_kinematic_variables() function will set the fragment_mass_
-  // member variable, but we need that value in advance in order to provide the total
-  // CM frame kinetic energy as input. To get around this, retrieve the fragment mass
-  // directly from the mass table instead
-  /// @todo TODO: find a better way of doing this!
+double marley::KoningDelarocheOpticalModel::total_KE_CM(
+  double fragment_KE_lab, int fragment_pdg, const Workspace& ws) const
+{
+  // The calculate_kinematic_variables() function will set the fragment mass
+  // in the workspace, but we need that value in advance in order to provide
+  // the total CM frame kinetic energy as input. To get around this, retrieve
+  // the fragment mass directly from the mass table instead
   const auto& mt = marley::MassTable::Instance();
   double m_fragment = mt.get_particle_mass( fragment_pdg );
 
-  double KE_tot_CM = std::max(0., marley_utils::real_sqrt(
-    std::pow(target_mass_ + m_fragment, 2)
-    + 2.*target_mass_*fragment_KE_lab) - m_fragment - target_mass_);
-
-  calculate_kinematic_variables( KE_tot_CM, fragment_pdg );
-  calculate_om_parameters(fragment_pdg, two_j, l, two_s);
-  return omp(r);
+  return std::max(0., marley_utils::real_sqrt(
+    std::pow(ws.target_mass + m_fragment, 2)
+    + 2.*ws.target_mass*fragment_KE_lab) - m_fragment - ws.target_mass);
 }
 
 // Finish an optical model potential calculation by taking the r
 // dependence into account. Don't add in the Coulomb potential.
 std::complex<double>
-marley::KoningDelarocheOpticalModel::omp_minus_Vc(double r) const
+marley::KoningDelarocheOpticalModel::omp_minus_Vc(double r,
+  const Workspace& ws) const
 {
-  double f_v = f(r, Rv, av);
-  double dfdr_d = dfdr(r, Rd, ad);
+  double f_v = f(r, ws.Rv, ws.av);
+  double dfdr_d = dfdr(r, ws.Rd, ws.ad);
 
-  double temp_Vv = Vv * f_v;
-  double temp_Wv = Wv * f_v;
-  double temp_Wd = -4 * Wd * ad * dfdr_d;
+  double temp_Vv = ws.Vv * f_v;
+  double temp_Wv = ws.Wv * f_v;
+  double temp_Wd = -4 * ws.Wd * ws.ad * dfdr_d;
 
   double temp_Vso = 0;
   double temp_Wso = 0;
 
-  if (spin_orbit_eigenvalue != 0) {
+  if (ws.spin_orbit_eigenvalue != 0) {
 
-    double factor_so = lambda_piplus2 * dfdr(r, Rso, aso)
-      * spin_orbit_eigenvalue / r;
+    double factor_so = lambda_piplus2 * dfdr(r, ws.Rso, ws.aso)
+      * ws.spin_orbit_eigenvalue / r;
 
-    temp_Vso = Vso * factor_so;
-    temp_Wso = Wso * factor_so;
+    temp_Vso = ws.Vso * factor_so;
+    temp_Wso = ws.Wso * factor_so;
   }
 
   return std::complex<double>(-temp_Vv + temp_Vso,
@@ -74,43 +80,44 @@ marley::KoningDelarocheOpticalModel::omp_minus_Vc(double r) const
 }
 
 // Compute all of the pieces of the optical model that depend on the fragment's
-// kinetic energy in the lab frame fragment_KE_lab but not on its distance from
-// the origin r. Store them in the appropriate class members.
+// kinetic energy in the lab frame but not on its distance from the origin r.
+// Store them in the workspace.
 void marley::KoningDelarocheOpticalModel::calculate_om_parameters(
-  int fragment_pdg, int two_j, int l, int two_s)
+  int fragment_pdg, int two_j, int l, int two_s, Workspace& ws) const
 {
   // Fragment atomic, mass, and neutron numbers
-  z = marley_utils::get_particle_Z(fragment_pdg);
+  int z = marley_utils::get_particle_Z(fragment_pdg);
+  ws.z = z;
   int a = marley_utils::get_particle_A(fragment_pdg);
   int n = a - z;
 
   // Abbreviate the variable name here for simplicity
-  const double E = fragment_KE_lab_;
+  const double E = ws.fragment_KE_lab;
 
   // Eigenvalue of the spin-orbit operator
   // 2*(l.s) = j*(j + 1)  - l*(l + 1) -  s*(s + 1)
   // = 0.25*((2j - 2s)*(2j + 2s + 2)) - l*(l+1)
   // (to keep the units right we take hbar = 1).
   bool spin_zero = two_s == 0;
-  if (spin_zero) spin_orbit_eigenvalue = 0;
-  else spin_orbit_eigenvalue = 0.25*((two_j - two_s)
+  if (spin_zero) ws.spin_orbit_eigenvalue = 0;
+  else ws.spin_orbit_eigenvalue = 0.25*((two_j - two_s)
     * (two_j + two_s + 2)) - l*(l + 1);
 
 
   // Geometrical parameters
-  Rv = 0;
-  av = 0;
-  Rd = 0;
-  ad = 0;
-  Rso = 0;
-  aso = 0;
+  ws.Rv = 0;
+  ws.av = 0;
+  ws.Rd = 0;
+  ws.ad = 0;
+  ws.Rso = 0;
+  ws.aso = 0;
 
   // Terms in the spherical optical model potential
-  Vv = 0;
-  Wv = 0;
-  Wd = 0;
-  Vso = 0;
-  Wso = 0;
+  ws.Vv = 0;
+  ws.Wv = 0;
+  ws.Wd = 0;
+  ws.Vso = 0;
+  ws.Wso = 0;
 
   // Energy to use when computing folded potentials
   double E_eff = E / a;
@@ -120,23 +127,23 @@ void marley::KoningDelarocheOpticalModel::calculate_om_parameters(
     double Ediff_n2 = std::pow(Ediff_n, 2);
     double Ediff_n3 = std::pow(Ediff_n, 3);
 
-    Vv += n * v1n * (1 - v2n*Ediff_n + v3n*Ediff_n2 - v4n*Ediff_n3);
-    Wv += n * w1n * Ediff_n2 / (Ediff_n2 + std::pow(w2n, 2));
-    Wd += n * d1n * Ediff_n2 * std::exp(-d2n * Ediff_n)
+    ws.Vv += n * v1n * (1 - v2n*Ediff_n + v3n*Ediff_n2 - v4n*Ediff_n3);
+    ws.Wv += n * w1n * Ediff_n2 / (Ediff_n2 + std::pow(w2n, 2));
+    ws.Wd += n * d1n * Ediff_n2 * std::exp(-d2n * Ediff_n)
       / (Ediff_n2 + std::pow(d3n, 2));
 
-    Rv += n * Rvn;
-    av += n * avn;
-    Rd += n * Rdn;
-    ad += n * adn;
-    Rso += n * Rso_n;
-    aso += n * aso_n;
+    ws.Rv += n * Rvn;
+    ws.av += n * avn;
+    ws.Rd += n * Rdn;
+    ws.ad += n * adn;
+    ws.Rso += n * Rso_n;
+    ws.aso += n * aso_n;
 
     if (!spin_zero) {
       double Ediff_so_n = E - Efn;
       double Ediff_so_n2 = std::pow(Ediff_so_n, 2);
-      Vso += vso1n * std::exp(-vso2n * Ediff_so_n);
-      Wso += wso1n * Ediff_so_n2 / (Ediff_so_n2 + std::pow(wso2n, 2));
+      ws.Vso += vso1n * std::exp(-vso2n * Ediff_so_n);
+      ws.Wso += wso1n * Ediff_so_n2 / (Ediff_so_n2 + std::pow(wso2n, 2));
     }
   }
 
@@ -145,34 +152,34 @@ void marley::KoningDelarocheOpticalModel::calculate_om_parameters(
     double Ediff_p2 = std::pow(Ediff_p, 2);
     double Ediff_p3 = std::pow(Ediff_p, 3);
 
-    Vv += z * v1p * (1 - v2p*Ediff_p + v3p*Ediff_p2 - v4p*Ediff_p3
+    ws.Vv += z * v1p * (1 - v2p*Ediff_p + v3p*Ediff_p2 - v4p*Ediff_p3
       + Vcbar_p*(v2p - 2*v3p*Ediff_p + 3*v4p*Ediff_p2));
-    Wv += z * w1p * Ediff_p2 / (Ediff_p2 + std::pow(w2p, 2));
-    Wd += z * d1p * Ediff_p2 * std::exp(-d2p * Ediff_p)
+    ws.Wv += z * w1p * Ediff_p2 / (Ediff_p2 + std::pow(w2p, 2));
+    ws.Wd += z * d1p * Ediff_p2 * std::exp(-d2p * Ediff_p)
       / (Ediff_p2 + std::pow(d3p, 2));
 
-    Rv += z * Rvp;
-    av += z * avp;
-    Rd += z * Rdp;
-    ad += z * adp;
-    Rso += z * Rso_p;
-    aso += z * aso_p;
+    ws.Rv += z * Rvp;
+    ws.av += z * avp;
+    ws.Rd += z * Rdp;
+    ws.ad += z * adp;
+    ws.Rso += z * Rso_p;
+    ws.aso += z * aso_p;
 
     if (!spin_zero) {
       double Ediff_so_p = E - Efp;
       double Ediff_so_p2 = std::pow(Ediff_so_p, 2);
-      Vso += vso1p * std::exp(-vso2p * Ediff_so_p);
-      Wso += wso1p * Ediff_so_p2 / (Ediff_so_p2 + std::pow(wso2p, 2));
+      ws.Vso += vso1p * std::exp(-vso2p * Ediff_so_p);
+      ws.Wso += wso1p * Ediff_so_p2 / (Ediff_so_p2 + std::pow(wso2p, 2));
     }
   }
 
   if (a > 1) {
-    Rv /= a;
-    av /= a;
-    Rd /= a;
-    ad /= a;
-    Rso /= a;
-    aso /= a;
+    ws.Rv /= a;
+    ws.av /= a;
+    ws.Rd /= a;
+    ws.ad /= a;
+    ws.Rso /= a;
+    ws.aso /= a;
 
     // Apply folding factor for composite particle spin-orbit potentials
     if (!spin_zero) {
@@ -185,8 +192,8 @@ void marley::KoningDelarocheOpticalModel::calculate_om_parameters(
       else if (z_odd != n_odd) factor = 1.0; // even-odd
       factor /= 2*a;
 
-      Vso *= factor;
-      Wso *= factor;
+      ws.Vso *= factor;
+      ws.Wso *= factor;
     }
   }
 }
@@ -194,9 +201,6 @@ void marley::KoningDelarocheOpticalModel::calculate_om_parameters(
 marley::KoningDelarocheOpticalModel::KoningDelarocheOpticalModel(int Z,
   int A, double step_size) : marley::OpticalModel(Z, A), step_size_(step_size)
 {
-  const auto& mt = marley::MassTable::Instance();
-  target_mass_ = mt.get_atomic_mass(Z, A);
-
   int N = A_ - Z_; // Neutron number
 
   double A_to_the_one_third = std::pow(A_, 1.0/3.0);
@@ -255,23 +259,11 @@ marley::KoningDelarocheOpticalModel::KoningDelarocheOpticalModel(int Z,
 
 double marley::KoningDelarocheOpticalModel::total_cross_section(
   double fragment_KE_lab, int fragment_pdg, int two_s, size_t l_max,
-  int target_charge)
+  int target_charge, Workspace& ws) const
 {
-  update_target_mass( target_charge );
-
-  // The calculate_kinematic_variables() function will set the fragment_mass_
-  // member variable, but we need that value in advance in order to provide the total
-  // CM frame kinetic energy as input. To get around this, retrieve the fragment mass
-  // directly from the mass table instead
-  /// @todo TODO: find a better way of doing this!
-  const auto& mt = marley::MassTable::Instance();
-  double m_fragment = mt.get_particle_mass( fragment_pdg );
-
-  double KE_tot_CM = std::max(0., marley_utils::real_sqrt(
-    std::pow(target_mass_ + m_fragment, 2)
-    + 2.*target_mass_*fragment_KE_lab) - m_fragment - target_mass_);
-
-  calculate_kinematic_variables( KE_tot_CM, fragment_pdg );
+  update_target_mass( target_charge, ws );
+  double KE_tot_CM = total_KE_CM( fragment_KE_lab, fragment_pdg, ws );
+  calculate_kinematic_variables( KE_tot_CM, fragment_pdg, ws );
 
   double sum = 0.;
   for (size_t l = 0; l <= l_max; ++l) {
@@ -279,25 +271,52 @@ double marley::KoningDelarocheOpticalModel::total_cross_section(
     for (int two_j = std::abs(two_l - two_s);
       two_j <= two_l + two_s; two_j += 2)
     {
-      std::complex<double> S = s_matrix_element(fragment_pdg, two_j, l, two_s);
+      std::complex<double> S = s_matrix_element(fragment_pdg, two_j, l, two_s,
+        ws);
       sum += (two_j + 1) * (1 - S.real());
     }
   }
 
   // Compute the cross section in natural units (MeV^(-2))
-  double xs = marley_utils::two_pi * sum / ((two_s + 1) * CM_frame_momentum_squared_);
+  double xs = marley_utils::two_pi * sum / ((two_s + 1)
+    * ws.CM_momentum_squared);
   return xs;
 }
 
 double marley::KoningDelarocheOpticalModel::transmission_coefficient(
   double total_KE_CM, int fragment_pdg, int two_j, int l, int two_s,
-  int target_charge)
+  int target_charge, Workspace& ws) const
 {
   if ( total_KE_CM <= 0. ) return 0.;
-  update_target_mass( target_charge );
-  calculate_kinematic_variables( total_KE_CM, fragment_pdg );
-  std::complex<double> S = s_matrix_element(fragment_pdg, two_j, l, two_s);
+  update_target_mass( target_charge, ws );
+  calculate_kinematic_variables( total_KE_CM, fragment_pdg, ws );
+  std::complex<double> S = s_matrix_element(fragment_pdg, two_j, l, two_s,
+    ws);
+  return transmission_from_s_matrix( S );
+}
+
+void marley::KoningDelarocheOpticalModel::transmission_coefficients(
+  double total_KE_CM, int fragment_pdg, int two_s, const int* two_js,
+  const int* ls, size_t num_waves, int target_charge, double* Ts,
+  Workspace& ws) const
+{
+  if ( total_KE_CM <= 0. ) {
+    std::fill( Ts, Ts + num_waves, 0. );
+    return;
+  }
 
+  update_target_mass( target_charge, ws );
+  calculate_kinematic_variables( total_KE_CM, fragment_pdg, ws );
+  for ( size_t w = 0u; w < num_waves; ++w ) {
+    std::complex<double> S = s_matrix_element( fragment_pdg, two_js[ w ],
+      ls[ w ], two_s, ws );
+    Ts[ w ] = transmission_from_s_matrix( S );
+  }
+}
+
+double marley::KoningDelarocheOpticalModel::transmission_from_s_matrix(
+  const std::complex<double>& S) const
+{
   // Guard against ±inf or NaN values that can occur in edge cases when the
   // Coulomb wavefunctions get huge, e.g., for low-energy alpha emission.
   // Numerical precision problems can lead to wrong answers, such as S == (inf,
@@ -323,11 +342,11 @@ double marley::KoningDelarocheOpticalModel::transmission_coefficient(
 
 std::complex<double>
 marley::KoningDelarocheOpticalModel::s_matrix_element(int fragment_pdg,
-  int two_j, int l, int two_s)
+  int two_j, int l, int two_s, Workspace& ws) const
 {
-  // Update the optical model parameters stored in this object for the
+  // Update the optical model parameters stored in the workspace for the
   // given fragment, energy, and angular momenta
-  calculate_om_parameters(fragment_pdg, two_j, l, two_s);
+  calculate_om_parameters(fragment_pdg, two_j, l, two_s, ws);
 
   double step_size2_over_twelve = std::pow(step_size_, 2) / 12.0;
 
@@ -339,7 +358,7 @@ marley::KoningDelarocheOpticalModel::s_matrix_element(int fragment_pdg,
   // we're saved by the boundary condition that u(0) = 0. We just need
   // something finite here, but we might as well make it zero.
   std::complex<double> a_n_minus_one = 0;
-  std::complex<double> a_n = a(step_size_, l);
+  std::complex<double> a_n = a(step_size_, l, ws);
 
   std::complex<double> u_n_minus_two;
   // Boundary condition that the wavefunction vanishes at the origin (the
@@ -362,9 +381,9 @@ marley::KoningDelarocheOpticalModel::s_matrix_element(int fragment_pdg,
     a_n_minus_two = a_n_minus_one;
     a_n_minus_one = a_n;
 
-    U_minus_Vc = omp_minus_Vc(r),
-    U = U_minus_Vc + Vc(r, Rc, z, Z_);
-    a_n = a(r, l, U);
+    U_minus_Vc = omp_minus_Vc(r, ws),
+    U = U_minus_Vc + Vc(r, Rc, ws.z, Z_);
+    a_n = a(r, l, U, ws);
 
     u_n_minus_two = u_n_minus_one;
     u_n_minus_one = u_n;
@@ -389,7 +408,7 @@ marley::KoningDelarocheOpticalModel::s_matrix_element(int fragment_pdg,
     r += step_size_;
     a_n_minus_two = a_n_minus_one;
     a_n_minus_one = a_n;
-    a_n = a(r, l);
+    a_n = a(r, l, ws);
 
     u_n_minus_two = u_n_minus_one;
     u_n_minus_one = u_n;
@@ -406,21 +425,21 @@ marley::KoningDelarocheOpticalModel::s_matrix_element(int fragment_pdg,
   // Coulomb (Sommerfeld) parameter
   // Note that the relative (dimensionless) speed of the two particles
   // is just the speed of the fragment in the lab frame
-  double beta_rel = marley_utils::real_sqrt( std::pow(fragment_KE_lab_, 2)
-    + 2.*fragment_KE_lab_*fragment_mass_ ) / ( fragment_KE_lab_
-    + fragment_mass_);
+  double beta_rel = marley_utils::real_sqrt( std::pow(ws.fragment_KE_lab, 2)
+    + 2.*ws.fragment_KE_lab*ws.fragment_mass ) / ( ws.fragment_KE_lab
+    + ws.fragment_mass);
 
   // If beta_rel == 0, then eta blows up, so use a really small value
   /// @todo TODO: revisit this to see if you want to do something else
   if (beta_rel <= 0) beta_rel = 1e-8;
 
-  double eta = Z_ * z * marley_utils::alpha / beta_rel;
+  double eta = Z_ * ws.z * marley_utils::alpha / beta_rel;
 
   // Compute the Coulomb wavefunctions at the matching radii
   std::complex<double> Hplus1, Hminus1, Hplus2, Hminus2;
 
   // Fragment's CM frame wavenumber
-  double k = marley_utils::real_sqrt( CM_frame_momentum_squared_ )
+  double k = marley_utils::real_sqrt( ws.CM_momentum_squared )
     / marley_utils::hbar_c;
 
   Hplus1 = coulomb_H_plus(l, eta, k*r_match_1);
@@ -440,19 +459,20 @@ marley::KoningDelarocheOpticalModel::s_matrix_element(int fragment_pdg,
 // Version of Schrodinger equation terms with the optical model potential
 // U pre-computed
 std::complex<double> marley::KoningDelarocheOpticalModel::a(double r,
-  int l, std::complex<double> U) const
+  int l, std::complex<double> U, const Workspace& ws) const
 {
   return (-l*(l+1) / std::pow(r, 2)) +
-    (1. - (U / total_CM_frame_KE_)) * CM_frame_momentum_squared_
+    (1. - (U / ws.total_KE_CM)) * ws.CM_momentum_squared
     / marley_utils::hbar_c2;
 }
 
 // Non-derivative radial Schrödinger equation terms to use for computing
 // transmission coefficients via the Numerov method
-std::complex<double> marley::KoningDelarocheOpticalModel::a(double r, int l)
+std::complex<double> marley::KoningDelarocheOpticalModel::a(double r, int l,
+  const Workspace& ws) const
 {
   return (-l*(l+1) / std::pow(r, 2)) +
-    (1. - (omp(r) / total_CM_frame_KE_)) * CM_frame_momentum_squared_
+    (1. - (omp(r, ws) / ws.total_KE_CM)) * ws.CM_momentum_squared
     / marley_utils::hbar_c2;
 }
 
@@ -475,9 +495,10 @@ double marley::KoningDelarocheOpticalModel::f(double r, double R, double a)
 }
 
 // Compute the optical model potential at radius r
-std::complex<double> marley::KoningDelarocheOpticalModel::omp(double r) const
+std::complex<double> marley::KoningDelarocheOpticalModel::omp(double r,
+  const Workspace& ws) const
 {
-  return omp_minus_Vc(r) + Vc(r, Rc, z, Z_);
+  return omp_minus_Vc(r, ws) + Vc(r, Rc, ws.z, Z_);
 }
 
 // Partial derivative with respect to r of the Woods-Saxon shape
@@ -495,30 +516,31 @@ double marley::KoningDelarocheOpticalModel::dfdr(double r, double R, double a) c
 }
 
 void marley::KoningDelarocheOpticalModel::calculate_kinematic_variables(
-  double KE_tot_CM, int fragment_pdg)
+  double KE_tot_CM, int fragment_pdg, Workspace& ws) const
 {
   // Store the total kinetic energy in the CM frame
-  total_CM_frame_KE_ = KE_tot_CM;
+  ws.total_KE_CM = KE_tot_CM;
 
   // Calculate the lab frame kinetic energy of the fragment from the
   // total CM frame kinetic energy
   const auto& mt = marley::MassTable::Instance();
-  fragment_mass_ = mt.get_particle_mass( fragment_pdg );
-  fragment_KE_lab_ = total_CM_frame_KE_ * (
-    2.*(fragment_mass_ + target_mass_) + total_CM_frame_KE_ )
-    / (2. * target_mass_);
+  ws.fragment_mass = mt.get_particle_mass( fragment_pdg );
+  ws.fragment_KE_lab = ws.total_KE_CM * (
+    2.*(ws.fragment_mass + ws.target_mass) + ws.total_KE_CM )
+    / (2. * ws.target_mass);
 
   // Calculate the square of the CM frame 3-momentum of either particle
-  CM_frame_momentum_squared_ = std::pow(target_mass_, 2) * fragment_KE_lab_
-    * (2.*fragment_mass_ + fragment_KE_lab_)
-    / ( std::pow(fragment_mass_ + target_mass_, 2)
-    + 2.*target_mass_*fragment_KE_lab_ );
+  ws.CM_momentum_squared = std::pow(ws.target_mass, 2) * ws.fragment_KE_lab
+    * (2.*ws.fragment_mass + ws.fragment_KE_lab)
+    / ( std::pow(ws.fragment_mass + ws.target_mass, 2)
+    + 2.*ws.target_mass*ws.fragment_KE_lab );
 }
 
-void marley::KoningDelarocheOpticalModel::update_target_mass(int target_charge)
+void marley::KoningDelarocheOpticalModel::update_target_mass(
+  int target_charge, Workspace& ws) const
 {
   // Update the target mass based on its charge state
   const auto& mt = marley::MassTable::Instance();
-  target_mass_ = mt.get_atomic_mass(Z_, A_)
+  ws.target_mass = mt.get_atomic_mass(Z_, A_)
    - target_charge*mt.get_particle_mass( marley_utils::ELECTRON );
 }
@@ -77,14 +77,18 @@ marley::Logger::OutStreamVector&
 }
 
 void marley::Logger::flush() {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   for (auto s : streams_) if (s.enabled_ && s.stream_) s.stream_->flush();
 }
 
 void marley::Logger::newline() {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   for (auto s : streams_) if (s.enabled_ && s.stream_) (*s.stream_) << '\n';
 }
 
 void marley::Logger::clear_streams() {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+
   // Empty the vector of output streams for the Logger
   streams_.clear();
 
@@ -112,6 +116,7 @@ marley::Logger& marley::Logger::Instance() {
 }
 
 bool marley::Logger::has_stream(const std::ostream& os) const {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   auto stream = get_stream(&os);
   if (stream) return true;
   // A nullptr was returned, so the stream couldn't be found
@@ -158,23 +163,36 @@ marley::Logger::OutStream* marley::Logger::find_stream(const std::ostream* os,
 void marley::Logger::add_stream(std::shared_ptr<std::ostream> stream,
   LogLevel level)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+
   // Check to see whether we have already added this stream to the logger
   bool enabled;
   marley::Logger::OutStream* os = find_stream(stream.get(), enabled, level);
 
   if (!os) streams_.emplace_back(stream, level, enabled);
+  update_max_level();
 }
 
 void marley::Logger::add_stream(std::ostream& stream, LogLevel level)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+
   // Check to see whether we have already added this stream to the logger
   bool enabled;
   marley::Logger::OutStream* os = find_stream(&stream, enabled, level);
 
   if (!os) streams_.emplace_back(stream, level, enabled);
+  update_max_level();
+}
+
+void marley::Logger::update_max_level() {
+  LogLevel max_level = LogLevel::DISABLED;
+  for (const auto& s : streams_) max_level = std::max(max_level, s.level_);
+  max_level_ = max_level;
 }
 
 void marley::Logger::enable(bool log_enabled) {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   enabled_ = log_enabled;
   for (auto& s : streams_) s.enabled_ = enabled_ && (s.level_ >= old_level_);
 }
@@ -184,6 +202,13 @@ marley::Logger::Message marley::Logger::log(LogLevel lev)
   if (lev == LogLevel::DISABLED) throw marley::Error("marley::Logger::log()"
     " may not be called for the DISABLED logging level.");
 
+  // Skip locking entirely if no stream would receive the message (e.g.,
+  // for debugging output from the worker threads during a typical run)
+  if (!is_enabled(lev)) return marley::Logger::Message( streams_,
+    std::unique_lock<std::recursive_mutex>() );
+
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+
   bool level_changed = (lev != old_level_);
 
   if (enabled_) {
@@ -206,5 +231,5 @@ marley::Logger::Message marley::Logger::log(LogLevel lev)
     // Update the old logging level
     old_level_ = lev;
   }
-  return marley::Logger::Message( streams_ );
+  return marley::Logger::Message( streams_, std::move(lock) );
 }
@@ -0,0 +1,67 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <cerrno>
+#include <cstring>
+
+// POSIX includes
+#include "fcntl.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "unistd.h"
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/MappedFile.hh"
+
+marley::MappedFile::MappedFile(const std::string& file_name)
+  : file_name_( file_name )
+{
+  int fd = ::open( file_name.c_str(), O_RDONLY );
+  if ( fd < 0 ) throw marley::Error( "Could not open the file "
+    + file_name + ": " + std::strerror(errno) );
+
+  struct stat info;
+  if ( ::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) ) {
+    ::close( fd );
+    throw marley::Error( "Could not map the file " + file_name
+      + " because it is not a regular file" );
+  }
+
+  size_ = static_cast<size_t>( info.st_size );
+
+  // Zero-length mappings are not allowed, so leave data_ null in that case
+  if ( size_ > 0u ) {
+    void* addr = ::mmap( nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if ( addr == MAP_FAILED ) {
+      int err = errno;
+      ::close( fd );
+      throw marley::Error( "Could not map the file " + file_name + ": "
+        + std::strerror(err) );
+    }
+    // The contents are normally parsed front to back in a single pass
+    ::madvise( addr, size_, MADV_SEQUENTIAL );
+    data_ = static_cast<const char*>( addr );
+  }
+
+  // The mapping remains valid after the descriptor is closed
+  ::close( fd );
+}
+
+marley::MappedFile::~MappedFile() {
+  if ( data_ ) ::munmap( const_cast<char*>(data_), size_ );
+}
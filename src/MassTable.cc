@@ -20,6 +20,7 @@
 #include "marley/FileManager.hh"
 #include "marley/JSON.hh"
 #include "marley/MassTable.hh"
+#include "marley/StartupProfile.hh"
 #include "marley/StructureDatabase.hh"
 #include "marley/marley_utils.hh"
 
@@ -28,6 +29,8 @@ const std::string marley::MassTable::data_file_name_ = "mass_table.js";
 
 marley::MassTable::MassTable() {
 
+  marley::StartupProfile::Phase phase( "Load mass table" );
+
   // Instantiate the file manager and use it to find
   // the mass table data file
   const auto& fm = marley::FileManager::Instance();
@@ -14,10 +14,26 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <limits>
 
 #include "marley/Generator.hh"
+#include "marley/MappedFile.hh"
 #include "marley/NeutrinoSource.hh"
+#include "marley/StartupProfile.hh"
+
+namespace {
+
+  // Returns true for characters that separate the columns of a text flux
+  // file
+  inline bool is_column_separator(char c) {
+    return c == ' ' || c == '\t' || c == ',' || c == '\r';
+  }
+
+}
 
 marley::NeutrinoSource::NeutrinoSource(int particle_id) {
   if (!pdg_is_allowed(particle_id)) throw marley::Error(
@@ -47,11 +63,20 @@ double marley::NeutrinoSource::sample_incident_neutrino(int& pdg,
     -> double { return this->pdf(E); }, get_Emin(), get_Emax(), max);
 }
 
+double marley::NeutrinoSource::integrate(
+  const std::function<double(double)>& weight) const
+{
+  return marley_utils::num_integrate( [this, &weight](double E)
+    -> double { return this->pdf(E) * weight(E); }, get_Emin(), get_Emax() );
+}
+
 marley::FermiDiracNeutrinoSource::FermiDiracNeutrinoSource(int particle_id,
   double Emin, double Emax, double temp, double eta)
   : NeutrinoSource(particle_id), Emin_(Emin), Emax_(Emax), temperature_(temp),
   eta_(eta), C_(1.)
 {
+  marley::StartupProfile::Phase phase( "Normalize Fermi-Dirac source" );
+
   // Normalize the source spectrum (not strictly necessary, but having the
   // spectrum approximately normalized makes the default rejection sampling
   // tolerance of 1e-8 reliable for finding the maximum of the spectrum)
@@ -167,4 +192,440 @@ void marley::GridNeutrinoSource::check_for_errors() {
 
   if (sum_of_PDs <= 0.) throw marley::Error(std::string("All probability")
     + " density grid point values are zero for the neutrino source");
+
+  // Grid points may have been adjusted above, so refresh the lookup tables
+  // used for fast interpolation
+  grid_.rebuild_lookup();
+}
+
+marley::FluxFileNeutrinoSource::FluxFileNeutrinoSource(
+  const std::string& file_name, int particle_id, Format format, Method method,
+  size_t energy_column, size_t flux_column)
+  : FluxFileNeutrinoSource( read_flux_file(file_name, format, method,
+    energy_column, flux_column), particle_id, method )
+{
+}
+
+marley::FluxFileNeutrinoSource::FluxFileNeutrinoSource( FluxTable&& table,
+  int particle_id, Method method )
+  : GridNeutrinoSource( Grid(table.Es, table.PDs, method), particle_id ),
+  Es_( std::move(table.Es) ), PDs_( std::move(table.PDs) ),
+  cdf_( std::move(table.cdf) ), first_moment_( std::move(table.first_moment) ),
+  total_flux_( table.total_flux )
+{
+}
+
+marley::FluxFileNeutrinoSource::FluxTable
+  marley::FluxFileNeutrinoSource::read_flux_file(
+  const std::string& file_name, Format format, Method method,
+  size_t energy_column, size_t flux_column)
+{
+  if ( method != Method::LinearLinear && method != Method::Constant ) {
+    throw marley::Error( "Flux file neutrino sources support only the"
+      " linear-linear and constant (histogram) interpolation rules" );
+  }
+
+  marley::MappedFile file( file_name );
+  const char* data = file.data();
+  size_t size = file.size();
+
+  FluxTable table;
+  std::vector<double>& Es = table.Es;
+  std::vector<double>& fluxes = table.PDs;
+
+  // Checks each point as it is read. The location function describes where
+  // the point appears in the file for use in error messages.
+  auto add_point = [&Es, &fluxes, &file_name](double E, double flux,
+    const std::function<std::string()>& location)
+  {
+    if ( !std::isfinite(E) || E < 0. ) throw marley::Error( "Invalid"
+      " neutrino energy " + std::to_string(E) + " MeV found on "
+      + location() + " of the flux file " + file_name );
+
+    if ( !Es.empty() && E <= Es.back() ) throw marley::Error( "The"
+      " neutrino energies in the flux file " + file_name + " are not"
+      " strictly increasing (E = " + std::to_string(E) + " MeV on "
+      + location() + " follows E = " + std::to_string(Es.back()) + " MeV)" );
+
+    if ( !std::isfinite(flux) || flux < 0. ) throw marley::Error( "Invalid"
+      " flux value " + std::to_string(flux) + " found on " + location()
+      + " of the flux file " + file_name );
+
+    // Prevent actually sampling an energy value of zero by advancing to
+    // the next representable double value (as GridNeutrinoSource does)
+    if ( E == 0. ) E = std::nextafter( 0., marley_utils::infinity );
+
+    Es.push_back( E );
+    fluxes.push_back( flux );
+  };
+
+  if ( format == Format::Binary ) {
+
+    constexpr size_t POINT_SIZE = 2u * sizeof(double);
+    if ( size % POINT_SIZE != 0u ) throw marley::Error( "The size of the"
+      " binary flux file " + file_name + " is not a multiple of "
+      + std::to_string(POINT_SIZE) + " bytes" );
+
+    size_t num_points = size / POINT_SIZE;
+    Es.reserve( num_points );
+    fluxes.reserve( num_points );
+
+    for ( size_t j = 0u; j < num_points; ++j ) {
+      double E, flux;
+      const char* point = data + j * POINT_SIZE;
+      std::memcpy( &E, point, sizeof(double) );
+      std::memcpy( &flux, point + sizeof(double), sizeof(double) );
+      add_point( E, flux, [j]() -> std::string
+        { return "record " + std::to_string(j); } );
+    }
+  }
+  else {
+
+    size_t num_columns = std::max( energy_column, flux_column ) + 1u;
+    const char* end = data + size;
+    const char* line = data;
+    size_t line_number = 0u;
+
+    // Fields are copied here before conversion since the mapped file
+    // contents are not null-terminated
+    std::string field;
+
+    while ( line < end ) {
+
+      ++line_number;
+      auto location = [line_number]() -> std::string
+        { return "line " + std::to_string(line_number); };
+
+      const char* eol = static_cast<const char*>(
+        std::memchr(line, '\n', end - line) );
+      if ( !eol ) eol = end;
+
+      const char* c = line;
+      line = ( eol == end ) ? end : eol + 1;
+
+      // Skip blank lines and comments
+      while ( c < eol && is_column_separator(*c) ) ++c;
+      if ( c == eol || *c == '#' ) continue;
+
+      double E = 0.;
+      double flux = 0.;
+      size_t column = 0u;
+      while ( c < eol && column < num_columns ) {
+
+        const char* field_end = c;
+        while ( field_end < eol && !is_column_separator(*field_end) ) {
+          ++field_end;
+        }
+
+        if ( column == energy_column || column == flux_column ) {
+          field.assign( c, field_end );
+          char* parse_end = nullptr;
+          double value = std::strtod( field.c_str(), &parse_end );
+          if ( parse_end != field.c_str() + field.size() ) {
+            throw marley::Error( "Invalid numerical value \"" + field
+              + "\" found on " + location() + " of the flux file "
+              + file_name );
+          }
+          if ( column == energy_column ) E = value;
+          if ( column == flux_column ) flux = value;
+        }
+
+        ++column;
+        c = field_end;
+        while ( c < eol && is_column_separator(*c) ) ++c;
+      }
+
+      if ( column < num_columns ) throw marley::Error( "Expected at least "
+        + std::to_string(num_columns) + " columns on " + location()
+        + " of the flux file " + file_name );
+
+      add_point( E, flux, location );
+    }
+  }
+
+  size_t num_points = Es.size();
+  if ( num_points < 2u ) throw marley::Error( "The flux file " + file_name
+    + " contains fewer than two grid points" );
+
+  // Accumulate the zeroth and first moments of the flux bin by bin
+  double Emin = Es.front();
+  table.cdf.assign( num_points, 0. );
+  table.first_moment.assign( num_points, 0. );
+  for ( size_t j = 1u; j < num_points; ++j ) {
+    double m0, m1;
+    bin_moments( Es, fluxes, method, j - 1u, Es[ j - 1u ], Es[ j ], m0, m1 );
+    table.cdf[ j ] = table.cdf[ j - 1u ] + m0;
+    table.first_moment[ j ] = table.first_moment[ j - 1u ] + m1
+      + ( Es[ j - 1u ] - Emin ) * m0;
+  }
+
+  table.total_flux = table.cdf.back();
+  if ( !(table.total_flux > 0.) || !std::isfinite(table.total_flux) ) {
+    throw marley::Error( "The integral of the flux tabulated in the file "
+      + file_name + " is not a positive finite number" );
+  }
+
+  // Normalize the spectrum so that pdf() is a proper probability density
+  for ( size_t j = 0u; j < num_points; ++j ) {
+    fluxes[ j ] /= table.total_flux;
+    table.cdf[ j ] /= table.total_flux;
+    table.first_moment[ j ] /= table.total_flux;
+  }
+
+  return table;
+}
+
+void marley::FluxFileNeutrinoSource::bin_moments(
+  const std::vector<double>& Es, const std::vector<double>& PDs,
+  Method method, size_t j, double a, double b, double& m0, double& m1)
+{
+  // The flux is linear within each bin (or constant, for a histogram), so
+  // its values at the endpoints determine both moments
+  double fa = PDs[ j ];
+  double fb = fa;
+  if ( method == Method::LinearLinear ) {
+    double slope = ( PDs[ j + 1u ] - PDs[ j ] ) / ( Es[ j + 1u ] - Es[ j ] );
+    fa += slope * ( a - Es[ j ] );
+    fb += slope * ( b - Es[ j ] );
+  }
+
+  double width = b - a;
+  m0 = 0.5 * width * ( fa + fb );
+  m1 = width * width * ( fa + 2.*fb ) / 6.;
+}
+
+void marley::FluxFileNeutrinoSource::moments(double a, double b,
+  double& m0, double& m1) const
+{
+  m0 = 0.;
+  m1 = 0.;
+
+  double Emin = Es_.front();
+  double Emax = Es_.back();
+  a = std::max( a, Emin );
+  b = std::min( b, Emax );
+  if ( b <= a ) return;
+
+  // Find the bins that contain each endpoint of the interval
+  size_t last_bin = Es_.size() - 2u;
+  size_t ja = std::upper_bound( Es_.cbegin(), Es_.cend(), a ) - Es_.cbegin();
+  ja = std::min( ja - 1u, last_bin );
+  size_t jb = std::lower_bound( Es_.cbegin(), Es_.cend(), b ) - Es_.cbegin();
+  jb = std::max<size_t>( jb, 1u ) - 1u;
+
+  Method method = grid_.interpolation_method();
+  if ( ja >= jb ) {
+    bin_moments( Es_, PDs_, method, ja, a, b, m0, m1 );
+    return;
+  }
+
+  // Partial bin at the low end of the interval
+  bin_moments( Es_, PDs_, method, ja, a, Es_[ ja + 1u ], m0, m1 );
+
+  // Complete bins in the middle, taken from the cumulative tables
+  double c0 = cdf_[ jb ] - cdf_[ ja + 1u ];
+  double c1 = first_moment_[ jb ] - first_moment_[ ja + 1u ]
+    - ( a - Emin ) * c0;
+
+  // Partial bin at the high end of the interval
+  double t0, t1;
+  bin_moments( Es_, PDs_, method, jb, Es_[ jb ], b, t0, t1 );
+  t1 += ( Es_[ jb ] - a ) * t0;
+
+  m0 += c0 + t0;
+  m1 += c1 + t1;
+}
+
+double marley::FluxFileNeutrinoSource::integrate(
+  const std::function<double(double)>& weight) const
+{
+  // If there aren't too many grid points, use them as nodes and divide each
+  // bin into equal pieces no wider than a common maximum spacing. The
+  // spacing is chosen so that no more than MAX_INTEGRATION_NODES nodes are
+  // used in total. This keeps the linear approximation of the weight
+  // function accurate even for coarse tables. For finer tables, space the
+  // nodes evenly across the spectrum instead.
+  std::vector<double> nodes;
+  size_t num_points = Es_.size();
+  double Emin = Es_.front();
+  double Emax = Es_.back();
+  if ( num_points <= MAX_INTEGRATION_NODES ) {
+    size_t num_extra = MAX_INTEGRATION_NODES - num_points;
+    double max_spacing = ( Emax - Emin ) / std::max<size_t>( num_extra, 1u );
+    nodes.reserve( MAX_INTEGRATION_NODES );
+    for ( size_t j = 0u; j + 1u < num_points; ++j ) {
+      double width = Es_[ j + 1u ] - Es_[ j ];
+      size_t pieces = std::max<size_t>( 1u,
+        static_cast<size_t>(std::ceil(width / max_spacing)) );
+      nodes.push_back( Es_[ j ] );
+      for ( size_t k = 1u; k < pieces; ++k ) {
+        nodes.push_back( Es_[ j ] + k * width / pieces );
+      }
+    }
+    nodes.push_back( Emax );
+  }
+  else {
+    nodes.resize( MAX_INTEGRATION_NODES );
+    double step = ( Emax - Emin ) / ( MAX_INTEGRATION_NODES - 1u );
+    for ( size_t k = 0u; k < MAX_INTEGRATION_NODES; ++k ) {
+      nodes[ k ] = Emin + k * step;
+    }
+    nodes.back() = Emax;
+  }
+
+  // Fold each linear piece of the weight function with the flux exactly
+  double result = 0.;
+  double w0 = weight( nodes.front() );
+  for ( size_t k = 1u; k < nodes.size(); ++k ) {
+    double w1 = weight( nodes[ k ] );
+    double m0, m1;
+    moments( nodes[ k - 1u ], nodes[ k ], m0, m1 );
+    result += w0 * m0 + ( w1 - w0 ) * m1 / ( nodes[ k ] - nodes[ k - 1u ] );
+    w0 = w1;
+  }
+
+  return result;
+}
+
+double marley::FluxFileNeutrinoSource::sample_incident_neutrino(int& pdg,
+  marley::Generator& gen) const
+{
+  pdg = pid_;
+
+  // Choose a bin by inverting the cumulative table
+  double r = gen.uniform_random_double( 0., cdf_.back(), false );
+  size_t j = std::upper_bound( cdf_.cbegin(), cdf_.cend(), r )
+    - cdf_.cbegin();
+  j = std::min( std::max<size_t>(j, 1u), cdf_.size() - 1u ) - 1u;
+
+  // Invert the integral of the flux within the bin
+  double x0 = Es_[ j ];
+  double width = Es_[ j + 1u ] - x0;
+  double f0 = PDs_[ j ];
+  double slope = 0.;
+  if ( grid_.interpolation_method() == Method::LinearLinear ) {
+    slope = ( PDs_[ j + 1u ] - f0 ) / width;
+  }
+
+  // Solve f0*t + slope*t^2/2 = r - cdf_[j] for the offset t in a form that
+  // remains accurate when the slope is small
+  double area = r - cdf_[ j ];
+  double disc = std::max( f0*f0 + 2.*slope*area, 0. );
+  double t = 2.*area / ( f0 + std::sqrt(disc) );
+  if ( !(t > 0.) ) t = 0.;
+
+  return x0 + std::min( t, width );
+}
+
+double marley::NeutrinoSource::flavor_pdf(int pdg, double E) const {
+  if ( pdg != this->get_pid() ) return 0.;
+  return this->pdf( E );
+}
+
+marley::CompositeNeutrinoSource::CompositeNeutrinoSource(
+  std::vector< std::unique_ptr<marley::NeutrinoSource> >&& components,
+  const std::vector<double>& weights)
+  : NeutrinoSource( components.empty() ? marley_utils::ELECTRON_NEUTRINO
+    : components.front()->get_pid() ), components_( std::move(components) ),
+  fractions_( weights )
+{
+  if ( components_.empty() ) throw marley::Error( "A composite neutrino"
+    " source must have at least one component" );
+
+  if ( fractions_.size() != components_.size() ) throw marley::Error(
+    "The number of weights given for a composite neutrino source does not"
+    " match the number of components" );
+
+  double weight_sum = 0.;
+  for ( double w : fractions_ ) {
+    if ( !(w > 0.) ) throw marley::Error( "Invalid component weight "
+      + std::to_string(w) + " given for a composite neutrino source" );
+    weight_sum += w;
+  }
+
+  Emin_ = components_.front()->get_Emin();
+  Emax_ = components_.front()->get_Emax();
+  bool mono = ( Emin_ == Emax_ );
+
+  for ( size_t c = 0u; c < components_.size(); ++c ) {
+    const auto& comp = components_.at( c );
+    fractions_.at( c ) /= weight_sum;
+
+    // Monoenergetic spectra can't be integrated together with continuous
+    // ones, so only allow them if every component uses the same energy
+    double Emin = comp->get_Emin();
+    double Emax = comp->get_Emax();
+    bool comp_mono = ( Emin == Emax );
+    if ( mono || comp_mono ) {
+      if ( !mono || !comp_mono || Emin != Emin_ ) throw marley::Error(
+        "Monoenergetic components of a composite neutrino source may only be"
+        " combined with other monoenergetic components of the same energy" );
+    }
+    Emin_ = std::min( Emin_, Emin );
+    Emax_ = std::max( Emax_, Emax );
+
+    // Normalize each component spectrum so that the weights correspond to
+    // shares of the total flux
+    double integral = 1.;
+    if ( !comp_mono ) integral = marley_utils::num_integrate(
+      [&comp](double E) -> double { return comp->pdf(E); }, Emin, Emax );
+
+    if ( !(integral > 0.) ) throw marley::Error( "The spectrum of a"
+      " component of a composite neutrino source integrates to zero" );
+
+    scales_.push_back( fractions_.at(c) / integral );
+
+    int pdg = comp->get_pid();
+    if ( std::find(flavors_.begin(), flavors_.end(), pdg) == flavors_.end() )
+    {
+      flavors_.push_back( pdg );
+    }
+  }
+}
+
+double marley::CompositeNeutrinoSource::component_pdf(size_t c, double E)
+  const
+{
+  const auto& comp = components_[ c ];
+  if ( E < comp->get_Emin() || E > comp->get_Emax() ) return 0.;
+  return scales_[ c ] * comp->pdf( E );
+}
+
+double marley::CompositeNeutrinoSource::pdf(double E) const {
+  double result = 0.;
+  for ( size_t c = 0u; c < components_.size(); ++c ) {
+    result += this->component_pdf( c, E );
+  }
+  return result;
+}
+
+double marley::CompositeNeutrinoSource::flavor_pdf(int pdg, double E) const {
+  double result = 0.;
+  for ( size_t c = 0u; c < components_.size(); ++c ) {
+    if ( components_[c]->get_pid() != pdg ) continue;
+    result += this->component_pdf( c, E );
+  }
+  return result;
+}
+
+double marley::CompositeNeutrinoSource::flux_fraction(int pdg) const {
+  double result = 0.;
+  for ( size_t c = 0u; c < components_.size(); ++c ) {
+    if ( components_.at(c)->get_pid() == pdg ) result += fractions_.at( c );
+  }
+  return result;
+}
+
+double marley::CompositeNeutrinoSource::sample_incident_neutrino(int& pdg,
+  marley::Generator& gen) const
+{
+  // Choose a component according to its share of the flux, then sample
+  // from its spectrum
+  double r = gen.uniform_random_double( 0., 1., false );
+  size_t c = 0u;
+  double cumulative = fractions_.front();
+  while ( r >= cumulative && c + 1 < components_.size() ) {
+    cumulative += fractions_.at( ++c );
+  }
+  return components_.at( c )->sample_incident_neutrino( pdg, gen );
 }
@@ -110,6 +110,13 @@ marley::NuclearReaction::NuclearReaction(ProcType pt, int pdg_a, int pdg_b,
   KEa_threshold_ = (std::pow(mc_ + md_gs_, 2)
     - std::pow(ma_ + mb_, 2))/(2.*mb_);
 
+  // Precompute the energy-independent factors that appear in the Coulomb
+  // corrections. These would otherwise be recomputed (using comparatively
+  // expensive special functions) for every level at every projectile energy.
+  R_nuc_ = nuclear_radius_natural_units( Af_ );
+  fermi_s_ = std::sqrt(1. - std::pow(marley_utils::alpha * Zf_, 2));
+  fermi_b2_ = std::pow(std::tgamma(1 + 2*fermi_s_), 2);
+
   this->set_description();
 }
 
@@ -128,10 +135,9 @@ double marley::NuclearReaction::fermi_function(double beta_c) const {
   // Lorentz factor gamma for particle c
   double gamma_c = std::pow(1. - beta_c*beta_c, -marley_utils::ONE_HALF);
 
-  double s = std::sqrt(1. - std::pow(marley_utils::alpha * Zf_, 2));
-
-  // Estimate the nuclear radius (in MeV^(-1))
-  double rho = nuclear_radius_natural_units( Af_ );
+  // Energy-independent parameters (see the constructor)
+  double s = fermi_s_;
+  double rho = R_nuc_;
 
   // Sommerfeld parameter
   double eta = marley_utils::alpha * Zf_ / beta_c;
@@ -142,11 +148,10 @@ double marley::NuclearReaction::fermi_function(double beta_c) const {
 
   // Complex variable for the gamma function
   std::complex<double> a(s, eta);
-  double b = std::tgamma(1 + 2*s);
 
   return 2 * (1 + s) * std::pow(2*beta_c*gamma_c*rho*mc_, 2*s-2)
     * std::exp(marley_utils::pi*eta) * std::norm(marley_utils::gamma(a))
-    / std::pow(b, 2);
+    / fermi_b2_;
 }
 
 // Return the maximum residue excitation energy E_level that can
@@ -328,7 +333,7 @@ marley::Event marley::NuclearReaction::create_event(int pdg_a, double KEa,
         std::vector<int> allowed_twoJs;
         std::vector<double> ld_weights;
 
-        auto& ldm = sdb.get_level_density_model( pdg_d_ );
+        const auto& ldm = sdb.get_level_density_model( pdg_d_ );
 
         for ( int myTwoJ = std::abs(twoJ_gs - 2); myTwoJ <= twoJ_gs + 2;
           myTwoJ += 2 )
@@ -360,6 +365,20 @@ marley::Event marley::NuclearReaction::create_event(int pdg_a, double KEa,
   marley::Event event = make_event_object( KEa, pc_cm, cos_theta_c_cm, phi_c_cm,
     Ec_cm, Ed_cm, E_level, twoJ, P );
 
+  // If systematic universes are configured, then start their weights using
+  // the likelihood ratio for the sampled transition. This depends on the
+  // relative speed of the ejectile and residue (computed as in level_xs()).
+  const auto& universes = gen.get_universes();
+  if ( !universes.empty() ) {
+    double pc_dot_pd = Ed_cm*Ec_cm + std::pow(pc_cm, 2);
+    double beta_rel_cd = marley_utils::real_sqrt(
+      std::pow(pc_dot_pd, 2) - mc_*mc_*md_*md_) / pc_dot_pd;
+
+    event.weights().assign( universes.size(), 1. );
+    universes.weight_transition( *this, sampled_matrix_el, beta_rel_cd,
+      event.weights() );
+  }
+
   // Return the preliminary event object (to be processed later by the
   // NucleusDecayer class)
   return event;
@@ -420,6 +439,12 @@ double marley::NuclearReaction::summed_xs_helper(int pdg_a, double KEa,
   if ( level_xsecs ) level_xsecs->clear();
 
   double max_E_level = max_level_energy( KEa );
+
+  // The level-independent CM frame kinematic quantities only need to be
+  // computed once for the entire sum
+  double s, sqrt_s, Eb_cm;
+  cm_kinematics( KEa, s, sqrt_s, Eb_cm );
+
   double xsec = 0.;
   for ( const auto& mat_el : *matrix_elements_ ) {
 
@@ -434,12 +459,11 @@ double marley::NuclearReaction::summed_xs_helper(int pdg_a, double KEa,
     // computing the total xs.
     if ( mat_el.strength() != 0. ) {
 
-      // Set the check_max_E_level flag to false when calculating the total
-      // cross section for this level (we've already verified that the
-      // current level is kinematically accessible in the check against
-      // max_E_level above)
+      // We've already verified that the current level is kinematically
+      // accessible in the check against max_E_level above, so skip
+      // straight to the level cross section calculation
       double beta_c_cm = 0.;
-      double partial_xsec = total_xs(mat_el, KEa, beta_c_cm, false);
+      double partial_xsec = level_xs( mat_el, s, sqrt_s, Eb_cm, beta_c_cm );
 
       // If a differential cross section (d\sigma / d\cos\theta_{CM})
       // is desired, then multiply by the appropriate angular factor
@@ -487,17 +511,32 @@ double marley::NuclearReaction::total_xs(const marley::MatrixElement& me,
     if ( me.level_energy() > max_E_level ) return 0.;
   }
 
+  double s, sqrt_s, Eb_cm;
+  cm_kinematics( KEa, s, sqrt_s, Eb_cm );
+
+  return level_xs( me, s, sqrt_s, Eb_cm, beta_c_cm );
+}
+
+void marley::NuclearReaction::cm_kinematics(double KEa, double& s,
+  double& sqrt_s, double& Eb_cm) const
+{
+  // Compute Mandelstam s (the square of the total CM frame energy)
+  s = std::pow(ma_ + mb_, 2) + 2.*mb_*KEa;
+  sqrt_s = std::sqrt(s);
+
+  // CM frame total energy of the target
+  Eb_cm = (s + mb_*mb_ - ma_*ma_) / (2. * sqrt_s);
+}
+
+double marley::NuclearReaction::level_xs(const marley::MatrixElement& me,
+  double s, double sqrt_s, double Eb_cm, double& beta_c_cm) const
+{
   // The final nuclear mass (before nuclear de-excitations) is the sum of the
   // ground state residue mass plus the excitation energy of the accessed level
   double md2 = std::pow(md_gs_ + me.level_energy(), 2);
 
-  // Compute Mandelstam s (the square of the total CM frame energy)
-  double s = std::pow(ma_ + mb_, 2) + 2.*mb_*KEa;
-  double sqrt_s = std::sqrt(s);
-
-  // Compute CM frame total energies for two of the particles. Also
-  // compute the magnitude of the ejectile CM frame momentum.
-  double Eb_cm = (s + mb_*mb_ - ma_*ma_) / (2. * sqrt_s);
+  // Compute the CM frame total energy of the ejectile. Also
+  // compute the magnitude of its CM frame momentum.
   double Ec_cm = (s + mc_*mc_ - md2) / (2. * sqrt_s);
   double pc_cm = marley_utils::real_sqrt(std::pow(Ec_cm, 2) - mc_*mc_);
 
@@ -591,20 +630,26 @@ marley::Event marley::NuclearReaction::make_event_object(double KEa,
 
 double marley::NuclearReaction::coulomb_correction_factor(double beta_rel_cd)
   const
+{
+  return this->coulomb_correction_factor( beta_rel_cd, coulomb_mode_ );
+}
+
+double marley::NuclearReaction::coulomb_correction_factor(double beta_rel_cd,
+  CoulombMode mode) const
 {
   // Don't do anything if Coulomb corrections are switched off
-  if ( coulomb_mode_ == CoulombMode::NO_CORRECTION ) return 1.;
+  if ( mode == CoulombMode::NO_CORRECTION ) return 1.;
 
   // Fermi function approach to the Coulomb correction
   double fermi_func = fermi_function( beta_rel_cd );
 
   // Unconditionally return the value of the Fermi function if the user
   // has configured things this way
-  if ( coulomb_mode_ == CoulombMode::FERMI_FUNCTION ) return fermi_func;
+  if ( mode == CoulombMode::FERMI_FUNCTION ) return fermi_func;
 
   bool use_mema = false;
-  if ( coulomb_mode_ == CoulombMode::MEMA
-    || coulomb_mode_ == CoulombMode::FERMI_AND_MEMA )
+  if ( mode == CoulombMode::MEMA
+    || mode == CoulombMode::FERMI_AND_MEMA )
   {
     use_mema = true;
   }
@@ -613,18 +658,18 @@ double marley::NuclearReaction::coulomb_correction_factor(double beta_rel_cd)
   bool EMA_ok = false;
   double factor_EMA = ema_factor( beta_rel_cd, EMA_ok, use_mema );
 
-  if ( coulomb_mode_ == CoulombMode::EMA || coulomb_mode_ == CoulombMode::MEMA ) {
+  if ( mode == CoulombMode::EMA || mode == CoulombMode::MEMA ) {
     if ( EMA_ok ) return factor_EMA;
     else {
       std::string model_name( "EMA" );
-      if ( coulomb_mode_ == CoulombMode::MEMA ) model_name = "MEMA";
+      if ( mode == CoulombMode::MEMA ) model_name = "MEMA";
       throw marley::Error( "Invalid " + model_name + " factor encountered"
         " in marley::NuclearReaction::coulomb_correction_factor()" );
     }
   }
 
-  if ( coulomb_mode_ != CoulombMode::FERMI_AND_EMA
-    && coulomb_mode_ != CoulombMode::FERMI_AND_MEMA )
+  if ( mode != CoulombMode::FERMI_AND_EMA
+    && mode != CoulombMode::FERMI_AND_MEMA )
   {
     throw marley::Error( "Unrecognized Coulomb correction mode encountered"
       " in marley::NuclearReaction::coulomb_correction_factor()" );
@@ -655,7 +700,7 @@ double marley::NuclearReaction::ema_factor(double beta_rel_cd, bool& ok,
   bool minus_c = (pdg_c_ > 0);
 
   // Approximate nuclear radius (MeV^(-1))
-  double R_nuc = nuclear_radius_natural_units( Af_ );
+  double R_nuc = R_nuc_;
 
   // Approximate Coulomb potential
   double Vc = ( -3. * Zf_ * marley_utils::alpha ) / ( 2. * R_nuc );
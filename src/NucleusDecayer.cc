@@ -15,6 +15,7 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 #include "marley/marley_utils.hh"
+#include "marley/Arena.hh"
 #include "marley/Error.hh"
 #include "marley/Event.hh"
 #include "marley/Generator.hh"
@@ -24,6 +25,7 @@
 #include "marley/MatrixElement.hh"
 #include "marley/NucleusDecayer.hh"
 #include "marley/Parity.hh"
+#include "marley/Tracer.hh"
 
 using ME_Type = marley::MatrixElement::TransitionType;
 
@@ -133,16 +135,46 @@ void marley::NucleusDecayer::process_event( marley::Event& event,
     // during the de-excitation cascade
     marley::Particle first, second;
 
+    // Only the first step of the cascade can reuse a cached
+    // HauserFeshbachDecay object. Later steps involve a recoiling
+    // nucleus at a continuous excitation energy.
+    bool first_step = true;
+
     // The selected level is unbound, so handle its de-excitation using
     // the Hauser-Feshbach statistical model.
     while ( continuum && Ex > CONTINUUM_GS_CUTOFF ) {
 
+      marley::Tracer::Span span( "HauserFeshbachDecay step",
+        { {"pdg", static_cast<double>(residue.pdg_code())}, {"Ex", Ex},
+        {"twoJ", static_cast<double>(twoJ)}, {"parity", P ? 1. : -1.} } );
+
       auto& sdb = gen.get_structure_db();
 
-      marley::HauserFeshbachDecay hfd( residue, Ex, twoJ, P, sdb );
-      MARLEY_LOG_DEBUG() << hfd;
+      marley::HauserFeshbachDecay* hfd = nullptr;
+      std::unique_ptr<marley::HauserFeshbachDecay> temp_hfd;
 
-      continuum = hfd.do_decay( Ex, twoJ, P, first, second, gen );
+      bool at_rest = residue.px() == 0. && residue.py() == 0.
+        && residue.pz() == 0.;
+      if ( first_step && cache_first_step_ && at_rest ) {
+        hfd = this->cached_decay( residue, Ex, twoJ, P, sdb );
+      }
+      first_step = false;
+
+      // Temporary HauserFeshbachDecay objects (together with their exit
+      // channels) are only needed for a single step of the cascade. Carve
+      // them out of the thread's memory arena, which is recycled once the
+      // cascade is complete. Cached objects must stay on the global heap.
+      marley::Arena::Scope arena_scope( !hfd );
+
+      if ( !hfd ) {
+        temp_hfd = std::make_unique<marley::HauserFeshbachDecay>( residue,
+          Ex, twoJ, P, sdb );
+        hfd = temp_hfd.get();
+      }
+      MARLEY_LOG_DEBUG() << *hfd;
+
+      continuum = hfd->do_decay( Ex, twoJ, P, first, second, gen,
+        &event.weights() );
 
       MARLEY_LOG_DEBUG() << "Hauser-Feshbach decay to " << first.pdg_code()
         << " and " << second.pdg_code();
@@ -152,6 +184,16 @@ void marley::NucleusDecayer::process_event( marley::Event& event,
       residue = second;
       event.add_final_particle( first );
     }
+
+    // Record how much of the arena the cascade used before recycling it
+    auto& arena = marley::Arena::thread_arena();
+    if ( marley::Tracer::event_traced() ) {
+      const auto& stats = arena.statistics();
+      marley::Tracer::counter( "Cascade memory arena", {
+        { "bytes_used", static_cast<double>(stats.bytes_in_use) },
+        { "bytes_reserved", static_cast<double>(stats.capacity) } } );
+    }
+    arena.reset();
   }
 
   if ( !continuum ) {
@@ -184,7 +226,30 @@ void marley::NucleusDecayer::process_event( marley::Event& event,
       }
     }
 
+    marley::Tracer::Span span( "DecayScheme::do_cascade",
+      { {"pdg", static_cast<double>(residue.pdg_code())},
+      {"Ex", lev->energy()} } );
     dec_scheme->do_cascade( *lev, event, gen, residue.charge() );
   }
 
 }
+
+marley::HauserFeshbachDecay* marley::NucleusDecayer::cached_decay(
+  const marley::Particle& compound_nucleus, double Ex, int twoJ,
+  marley::Parity P, marley::StructureDatabase& sdb )
+{
+  CacheKey key( compound_nucleus.pdg_code(), compound_nucleus.charge(), Ex,
+    twoJ, static_cast<bool>( P ) );
+
+  auto iter = hf_cache_.find( key );
+  if ( iter != hf_cache_.end() ) return iter->second.get();
+
+  // Don't let the cache grow without bound when the initial states vary
+  // from event to event
+  if ( hf_cache_.size() >= MAX_CACHED_DECAYS_ ) return nullptr;
+
+  auto& entry = hf_cache_[ key ];
+  entry = std::make_unique<marley::HauserFeshbachDecay>( compound_nucleus,
+    Ex, twoJ, P, sdb );
+  return entry.get();
+}
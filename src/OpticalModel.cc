@@ -0,0 +1,27 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include "marley/OpticalModel.hh"
+
+void marley::OpticalModel::transmission_coefficients(double total_KE_CM,
+  int fragment_pdg, int two_s, const int* two_js, const int* ls,
+  size_t num_waves, int target_charge, double* Ts, Workspace& ws) const
+{
+  for ( size_t w = 0u; w < num_waves; ++w ) {
+    Ts[ w ] = this->transmission_coefficient( total_KE_CM, fragment_pdg,
+      two_js[ w ], ls[ w ], two_s, target_charge, ws );
+  }
+}
@@ -14,6 +14,9 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+// standard library includes
+#include <iostream>
+
 // MARLEY includes
 #include "marley/Generator.hh"
 #include "marley/Error.hh"
@@ -24,14 +27,22 @@
   #include "marley/RootJSONConfig.hh"
 #endif
 
+namespace {
+  // Version of the HepMC3 ASCII format specification that the HepMC3 output
+  // files follow
+  const std::string HEPMC3_FORMAT_VERSION = "3.02.06";
+}
+
 marley::OutputFile::OutputFile(const std::string& name,
   const std::string& format, const std::string& mode,
   bool force) : name_(name), force_(force)
 {
   if (format == "root") format_ = Format::ROOT;
   else if (format == "hepevt") format_ = Format::HEPEVT;
+  else if (format == "hepmc3") format_ = Format::HEPMC3;
   else if (format == "json") format_ = Format::JSON;
   else if (format == "ascii") format_ = Format::ASCII;
+  else if (format == "virtual") format_ = Format::VIRTUAL;
   else throw marley::Error("Invalid output file format \"" + format
     + "\" given in an output file specification");
 
@@ -52,6 +63,48 @@ marley::OutputFile::OutputFile(const std::string& name,
     + "\" given in an output file specification");
 }
 
+void marley::OutputFile::set_projection(const marley::EventProjection& proj)
+{
+  if ( format_ == Format::ROOT && !proj.is_complete() ) {
+    throw marley::Error("Event projections (including single-precision"
+      " output) are not supported for the ROOT output file \"" + name_
+      + "\". ROOT files always store complete marley::Event objects.");
+  }
+  else if ( format_ == Format::HEPEVT && proj.drops_fields() ) {
+    throw marley::Error("The HEPEVT output file \"" + name_ + "\" uses a"
+      " fixed event layout. Only the \"precision\" setting may be used"
+      " to reduce its size.");
+  }
+  else if ( format_ == Format::HEPMC3 && proj.drops_fields() ) {
+    throw marley::Error("The HepMC3 output file \"" + name_ + "\" uses a"
+      " fixed event layout. Only the \"precision\" setting may be used"
+      " to reduce its size.");
+  }
+  else if ( format_ == Format::VIRTUAL && !proj.is_complete() ) {
+    throw marley::Error("Event projections are not supported for the"
+      " virtual output file \"" + name_ + "\". Regenerated events always"
+      " include every field.");
+  }
+  else if ( format_ == Format::JSON && proj.single_precision() ) {
+    throw marley::Error("Single-precision output is not supported for the"
+      " JSON output file \"" + name_ + '\"');
+  }
+
+  projection_ = proj;
+}
+
+void marley::OutputFile::set_weight_names(
+  const std::vector<std::string>& names)
+{
+  if ( format_ == Format::ROOT || format_ == Format::VIRTUAL ) return;
+  if ( format_ == Format::HEPEVT ) {
+    if ( !names.empty() ) MARLEY_LOG_WARNING() << "Systematic weights are"
+      << " not saved in the HEPEVT output file \"" << name_ << '\"';
+    return;
+  }
+  projection_.set_weight_names( names );
+}
+
 std::unique_ptr<marley::Generator> marley::OutputFile::restore_generator(
   const marley::JSON& config)
 {
@@ -65,8 +118,10 @@ std::unique_ptr<marley::Generator> marley::OutputFile::restore_generator(
 }
 
 marley::TextOutputFile::TextOutputFile(const std::string& name,
-  const std::string& format, const std::string& mode, bool force, int indent)
-  : marley::OutputFile(name, format, mode, force), indent_(indent)
+  const std::string& format, const std::string& mode, bool force, int indent,
+  const marley::CompressionSettings& compression)
+  : marley::OutputFile(name, format, mode, force), compression_(compression),
+  indent_(indent)
 {
   this->open();
 }
@@ -75,26 +130,42 @@ void marley::TextOutputFile::start_json_output(bool start_array) {
   if (format_ != Format::JSON) throw marley::Error("TextOutputFile"
     "::start_json_output() called for a non-JSON file format");
 
-  stream_ << '{';
+  *out_ << '{';
   if (indent_ >= 0) {
-    stream_ << '\n';
-    for (int k = 0; k < indent_; ++k) stream_ << ' ';
+    *out_ << '\n';
+    for (int k = 0; k < indent_; ++k) *out_ << ' ';
   }
-  stream_ << "\"events\"";
-  if (indent_ >= 0) stream_ << ' ';
-  stream_ << ':';
-  if (indent_ >= 0) stream_ << ' ';
+  *out_ << "\"events\"";
+  if (indent_ >= 0) *out_ << ' ';
+  *out_ << ':';
+  if (indent_ >= 0) *out_ << ' ';
 
   if (!start_array) return;
 
-  stream_ << '[';
+  *out_ << '[';
   if (indent_ >= 0) {
-    stream_ << '\n';
-    for (int k = 0; k < 2*indent_; ++k) stream_ << ' ';
+    *out_ << '\n';
+    for (int k = 0; k < 2*indent_; ++k) *out_ << ' ';
   }
 }
 
 void marley::TextOutputFile::open() {
+
+  // Events may be sent to the standard output instead of a file (e.g., so
+  // that they can be piped to another program)
+  if (is_standard_output(name_)) {
+    if (mode_ != Mode::OVERWRITE) throw marley::Error("Only the"
+      " \"overwrite\" mode may be used when writing events to the standard"
+      " output");
+    stdout_buf_ = std::make_unique<marley::CountingOutputBuffer>(
+      std::cout.rdbuf());
+    stdout_stream_ = std::make_unique<std::ostream>(stdout_buf_.get());
+    base_out_ = stdout_stream_.get();
+    start_compression();
+    if (format_ == Format::JSON) start_json_output(true);
+    return;
+  }
+
   bool file_exists = check_if_file_exists(name_);
 
   auto open_mode_flag = std::ios::out | std::ios::trunc;
@@ -125,7 +196,9 @@ void marley::TextOutputFile::open() {
     throw marley::Error("Unrecognized file mode encountered in"
       " TextOutputFile::open()");
 
+  if (compression_.enabled()) open_mode_flag |= std::ios::binary;
   stream_.open(name_, open_mode_flag);
+  start_compression();
 
   // Get the event array started if we're writing a fresh JSON file
   if (format_ == Format::JSON && mode_ == Mode::OVERWRITE) {
@@ -154,10 +227,21 @@ bool marley::TextOutputFile::resume(std::unique_ptr<marley::Generator>& gen,
     << name_;
 
   // Get the JSON objects from the file
-  stream_.close();
-  stream_.open(name_, std::ios::in);
-  marley::JSON temp_json = marley::JSON::load(stream_);
-  stream_.close();
+  close_stream();
+  marley::JSON temp_json;
+  if (compression_.enabled()) {
+    marley::GzipInputBuffer temp_buf(name_, compression_.threads());
+    std::istream temp_in(&temp_buf);
+    temp_json = marley::JSON::load(temp_in);
+  }
+  else {
+    stream_.open(name_, std::ios::in);
+    temp_json = marley::JSON::load(stream_);
+    stream_.close();
+  }
+
+  auto binary_flag = compression_.enabled() ? std::ios::binary
+    : std::ios::openmode();
 
   if (!temp_json.has_key("gen_state")) {
     throw marley::Error("Missing generator configuration in JSON"
@@ -207,7 +291,8 @@ bool marley::TextOutputFile::resume(std::unique_ptr<marley::Generator>& gen,
 
   // We've loaded all the metadata we need, so erase the file,
   // and write out all the previous events to it again.
-  stream_.open(name_, std::ios::out | std::ios::trunc);
+  stream_.open(name_, std::ios::out | std::ios::trunc | binary_flag);
+  start_compression();
 
   start_json_output(true);
 
@@ -218,12 +303,12 @@ bool marley::TextOutputFile::resume(std::unique_ptr<marley::Generator>& gen,
   auto end = evt_array.end();
 
   for (auto iter = begin; iter != end; ++iter) {
-    if (iter != begin) stream_ << ',';
-    if (indent_ < 0) stream_ << iter->dump_string();
+    if (iter != begin) *out_ << ',';
+    if (indent_ < 0) *out_ << iter->dump_string();
     else {
-      stream_ << '\n';
-      for (int i = 0; i < 2*indent_; ++i) stream_ << ' ';
-      iter->print(stream_, indent_, true, 2*indent_);
+      *out_ << '\n';
+      for (int i = 0; i < 2*indent_; ++i) *out_ << ' ';
+      iter->print(*out_, indent_, true, 2*indent_);
     }
   }
 
@@ -233,8 +318,9 @@ bool marley::TextOutputFile::resume(std::unique_ptr<marley::Generator>& gen,
   else needs_comma_ = false;
 
   // Close the file and re-open it, this time appending to the end
-  stream_.close();
-  stream_.open(name_, std::ios::out | std::ios::app);
+  close_stream();
+  stream_.open(name_, std::ios::out | std::ios::app | binary_flag);
+  start_compression();
 
   return true;
 }
@@ -242,39 +328,78 @@ bool marley::TextOutputFile::resume(std::unique_ptr<marley::Generator>& gen,
 int_fast64_t marley::TextOutputFile::bytes_written() {
   // If the stream is open, then update the byte count. Otherwise, just
   // use the saved value.
-  if (stream_.is_open()) {
+  if (stdout_buf_) {
+    stdout_stream_->flush();
+    byte_count_ = stdout_buf_->count();
+  }
+  else if (stream_.is_open()) {
     stream_.flush();
     byte_count_ = static_cast<int_fast64_t>( stream_.tellp() );
   }
   return byte_count_;
 }
 
+void marley::TextOutputFile::start_compression() {
+  gzip_stream_.reset();
+  gzip_buf_.reset();
+  out_ = base_out_;
+
+  if (compression_.enabled()) {
+    gzip_buf_ = std::make_unique<marley::GzipOutputBuffer>(*base_out_,
+      compression_);
+    gzip_stream_ = std::make_unique<std::ostream>(gzip_buf_.get());
+    out_ = gzip_stream_.get();
+  }
+}
+
+marley::TextOutputFile::~TextOutputFile() {
+  // Flush the last compressed block while its destination is still alive
+  if (gzip_buf_) {
+    try {
+      gzip_buf_->finish();
+    }
+    catch (...) { }
+  }
+}
+
+void marley::TextOutputFile::close_stream() {
+  if (gzip_buf_) gzip_buf_->finish();
+
+  // Update the byte count before closing the file
+  this->bytes_written();
+  stream_.close();
+}
+
 void marley::TextOutputFile::write_event(const marley::Event* event) {
   if (!event) throw marley::Error("Null pointer passed to"
     " TextOutputFile::write_event()");
 
   switch (format_) {
     case Format::ASCII:
-      stream_ << *event;
+      event->print( *out_, projection_ );
       break;
     case Format::JSON:
       if (needs_comma_) {
-        stream_ << ',';
+        *out_ << ',';
         if (indent_ > 0) {
-          stream_ << '\n';
-          for (int k = 0; k < 2*indent_; ++k) stream_ << ' ';
+          *out_ << '\n';
+          for (int k = 0; k < 2*indent_; ++k) *out_ << ' ';
         }
       }
       else needs_comma_ = true;
-      if (indent_ == -1) stream_ << event->to_json();
+      if (indent_ == -1) *out_ << event->to_json(projection_);
       else {
-        event->to_json().print(stream_, indent_, true, 2*indent_);
+        event->to_json(projection_).print(*out_, indent_, true, 2*indent_);
       }
       break;
     case Format::HEPEVT:
       // TODO: consider incrementing event numbers each time instead of
       // just writing a zero
-      event->write_hepevt(0, flux_avg_tot_xsec_, stream_);
+      event->write_hepevt(0, flux_avg_tot_xsec_, *out_, projection_);
+      break;
+    case Format::HEPMC3:
+      event->write_hepmc3(hepmc3_event_number_++, flux_avg_tot_xsec_, *out_,
+        projection_);
       break;
     case Format::ROOT:
       throw marley::Error("ROOT format encountered in TextOutputFile::"
@@ -284,6 +409,9 @@ void marley::TextOutputFile::write_event(const marley::Event* event) {
       throw marley::Error("Invalid format value encountered in"
         " TextOutputFile::write_event()");
   }
+
+  // Compressed blocks may only end between events
+  if (gzip_buf_) gzip_buf_->end_record();
 }
 
 void marley::TextOutputFile::write_generator_state(
@@ -293,15 +421,15 @@ void marley::TextOutputFile::write_generator_state(
   if (format_ != Format::JSON) throw marley::Error("TextOutputFile::"
     "write_generator_state() should only be used with the JSON format");
 
-  stream_ << ',';
+  *out_ << ',';
   if (indent_ > 0) {
-    stream_ << '\n';
-    for (int k = 0; k < indent_; ++k) stream_ << ' ';
+    *out_ << '\n';
+    for (int k = 0; k < indent_; ++k) *out_ << ' ';
   }
-  stream_ << "\"gen_state\"";
-  if (indent_ > 0) stream_ << ' ';
-  stream_ << ':';
-  if (indent_ > 0) stream_ << ' ';
+  *out_ << "\"gen_state\"";
+  if (indent_ > 0) *out_ << ' ';
+  *out_ << ':';
+  if (indent_ > 0) *out_ << ' ';
 
   marley::JSON temp = marley::JSON::object();
 
@@ -311,8 +439,12 @@ void marley::TextOutputFile::write_generator_state(
   temp["event_count"] = num_events;
   temp["flux_avg_xsec"] = gen.flux_averaged_total_xs();
 
-  if (indent_ < 0) stream_ << temp.dump_string();
-  else temp.print(stream_, indent_, true, indent_);
+  // Describe the projection (if any) so that marley::EventFileReader knows
+  // which event keys may legitimately be missing
+  if ( !projection_.is_complete() ) temp["projection"] = projection_.to_json();
+
+  if (indent_ < 0) *out_ << temp.dump_string();
+  else temp.print(*out_, indent_, true, indent_);
 }
 
 void marley::TextOutputFile::close(const marley::JSON& json_config,
@@ -321,21 +453,24 @@ void marley::TextOutputFile::close(const marley::JSON& json_config,
   if (format_ == Format::JSON) {
     // End the JSON array of event objects
     if (indent_ > 0) {
-      stream_ << '\n';
-      for (int k = 0; k < indent_; ++k) stream_ << ' ';
+      *out_ << '\n';
+      for (int k = 0; k < indent_; ++k) *out_ << ' ';
     }
-    stream_ << ']';
+    *out_ << ']';
 
     // Save the current state of the generator to the JSON file in case
     // we want to resume a run later
     write_generator_state(json_config, gen, num_events);
 
     // Terminate the JSON file with a closing curly brace
-    if (indent_ > 0) stream_ << '\n';
-    stream_ << '}';
+    if (indent_ > 0) *out_ << '\n';
+    *out_ << '}';
+  }
+  else if (format_ == Format::HEPMC3) {
+    *out_ << "HepMC::Asciiv3-END_EVENT_LISTING\n\n";
   }
 
-  stream_.close();
+  close_stream();
 }
 
 void marley::TextOutputFile::write_flux_avg_tot_xsec(double avg_tot_xsec)
@@ -348,10 +483,21 @@ void marley::TextOutputFile::write_flux_avg_tot_xsec(double avg_tot_xsec)
   // the user not to mix events with different flux-averaged cross sections
   // in these file formats.
   /// @todo Consider other ways of handling this
+  int_fast64_t position = stdout_buf_ ? stdout_buf_->count()
+    : static_cast<int_fast64_t>( stream_.tellp() );
+  bool at_start_of_file = position == 0
+    && ( !gzip_buf_ || gzip_buf_->pending_bytes() == 0 );
+
   if (format_ == Format::ASCII) {
-    bool at_start_of_file = stream_.tellp() == 0;
     if ( !at_start_of_file ) return;
 
+    // If some fields will be omitted from the events, then begin the file
+    // with a header line that describes the projection. This allows the
+    // marley::EventFileReader class to parse the file later.
+    if ( !projection_.is_complete() ) {
+      *out_ << '#' << projection_.to_json().dump_string() << '\n';
+    }
+
     // Use the same trick as in marley::Event::print() to preserve
     // full numerical precision in the output text
     std::ostringstream temp;
@@ -359,7 +505,31 @@ void marley::TextOutputFile::write_flux_avg_tot_xsec(double avg_tot_xsec)
     temp.precision(std::numeric_limits<double>::max_digits10);
 
     temp << avg_tot_xsec;
-    stream_ << temp.str() << '\n';
+    *out_ << temp.str() << '\n';
+  }
+  else if (format_ == Format::HEPMC3 && at_start_of_file) {
+    // HepMC3 files begin with a header that identifies the format. It is
+    // followed by the run information: the generator (stored as a tool
+    // with its name, version, and description separated by "\|") and a run
+    // attribute that holds the cross section in MARLEY natural units.
+    std::ostringstream temp;
+    temp << std::scientific;
+    temp.precision(std::numeric_limits<double>::max_digits10);
+
+    temp << "HepMC::Version " << HEPMC3_FORMAT_VERSION << '\n'
+      << "HepMC::Asciiv3-START_EVENT_LISTING\n"
+      << "T MARLEY\\|" << MARLEY_VERSION << "\\|Model of Argon Reaction"
+      << " Low Energy Yields\n"
+      << "A flux_avg_xsec " << avg_tot_xsec << '\n';
+
+    // Name the event weights. The nominal one is always first.
+    const auto& weight_names = projection_.weight_names();
+    if ( !weight_names.empty() ) {
+      temp << "W nominal";
+      for ( const auto& name : weight_names ) temp << ' ' << name;
+      temp << '\n';
+    }
+    *out_ << temp.str();
   }
 
   // Store the value for later (it is needed for the HEPEVT format)
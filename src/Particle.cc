@@ -17,7 +17,9 @@
 #include <cmath>
 
 #include "marley/marley_utils.hh"
+#include "marley/EventProjection.hh"
 #include "marley/JSON.hh"
+#include "marley/MassTable.hh"
 #include "marley/Particle.hh"
 
 namespace {
@@ -52,6 +54,38 @@ namespace {
     return result;
   }
 
+  // Assigns default values to fields of a particle that were omitted
+  // from an output file by a marley::EventProjection. The 3-momentum
+  // and PDG code are assumed to be already set.
+  void fill_missing_fields( marley::Particle& p, bool has_E, bool has_mass,
+    bool has_charge )
+  {
+    int pdg = p.pdg_code();
+    if ( !has_charge ) p.set_charge( marley_utils::get_particle_charge(pdg) );
+
+    if ( !has_mass ) {
+      const auto& mt = marley::MassTable::Instance();
+      double mass = 0.;
+      try {
+        if ( marley_utils::is_ion(pdg) ) {
+          // Account for any missing electrons based on the net charge
+          mass = mt.get_atomic_mass( pdg ) - p.charge()
+            * mt.get_particle_mass( marley_utils::ELECTRON );
+        }
+        else mass = mt.get_particle_mass( pdg );
+      }
+      // If the mass table doesn't know about this particle, leave the
+      // mass equal to zero
+      catch ( const std::exception& ) { }
+      p.set_mass( mass );
+    }
+
+    if ( !has_E ) {
+      p.set_total_energy( std::sqrt(std::pow(p.mass(), 2)
+        + std::pow(p.momentum_magnitude(), 2)) );
+    }
+  }
+
 }
 
 marley::Particle::Particle() : four_momentum_{0., 0., 0., 0.} {}
@@ -146,3 +180,86 @@ void marley::Particle::from_json(const marley::JSON& json) {
   four_momentum_[3] = read_JSON_double( "pz", json );
   mass_ = read_JSON_double( "mass", json );
 }
+
+void marley::Particle::from_json(const marley::JSON& json,
+  const marley::EventProjection& proj)
+{
+  using Field = marley::EventProjection::Field;
+
+  this->clear();
+  pdg_code_ = read_JSON_integer( "pdg", json );
+
+  // Keys may only be missing if the projection omits them. Otherwise,
+  // read_JSON_integer() and read_JSON_double() will complain.
+  auto present = [&json, &proj]( Field f, const char* key ) -> bool
+    { return proj.has( f ) || json.has_key( key ); };
+
+  bool has_charge = present( Field::charge, "charge" );
+  bool has_E = present( Field::E, "E" );
+  bool has_mass = present( Field::mass, "mass" );
+
+  if ( has_charge ) charge_ = read_JSON_integer( "charge", json );
+  if ( has_E ) four_momentum_[0] = read_JSON_double( "E", json );
+  if ( present(Field::px, "px") ) {
+    four_momentum_[1] = read_JSON_double( "px", json );
+  }
+  if ( present(Field::py, "py") ) {
+    four_momentum_[2] = read_JSON_double( "py", json );
+  }
+  if ( present(Field::pz, "pz") ) {
+    four_momentum_[3] = read_JSON_double( "pz", json );
+  }
+  if ( has_mass ) mass_ = read_JSON_double( "mass", json );
+
+  fill_missing_fields( *this, has_E, has_mass, has_charge );
+}
+
+marley::JSON marley::Particle::to_json(
+  const marley::EventProjection& proj) const
+{
+  using Field = marley::EventProjection::Field;
+
+  marley::JSON particle = marley::JSON::object();
+  particle["pdg"] = pdg_code_;
+  if ( proj.has(Field::E) ) particle["E"] = four_momentum_[0];
+  if ( proj.has(Field::px) ) particle["px"] = four_momentum_[1];
+  if ( proj.has(Field::py) ) particle["py"] = four_momentum_[2];
+  if ( proj.has(Field::pz) ) particle["pz"] = four_momentum_[3];
+  if ( proj.has(Field::mass) ) particle["mass"] = mass_;
+  if ( proj.has(Field::charge) ) particle["charge"] = charge_;
+  return particle;
+}
+
+void marley::Particle::print(std::ostream& out,
+  const marley::EventProjection& proj) const
+{
+  using Field = marley::EventProjection::Field;
+
+  out << pdg_code_;
+  if ( proj.has(Field::E) ) proj.print_value( out, four_momentum_[0] );
+  if ( proj.has(Field::px) ) proj.print_value( out, four_momentum_[1] );
+  if ( proj.has(Field::py) ) proj.print_value( out, four_momentum_[2] );
+  if ( proj.has(Field::pz) ) proj.print_value( out, four_momentum_[3] );
+  if ( proj.has(Field::mass) ) proj.print_value( out, mass_ );
+  if ( proj.has(Field::charge) ) out << ' ' << charge_;
+}
+
+void marley::Particle::read(std::istream& in,
+  const marley::EventProjection& proj)
+{
+  using Field = marley::EventProjection::Field;
+
+  this->clear();
+  in >> pdg_code_;
+  if ( proj.has(Field::E) ) in >> four_momentum_[0];
+  if ( proj.has(Field::px) ) in >> four_momentum_[1];
+  if ( proj.has(Field::py) ) in >> four_momentum_[2];
+  if ( proj.has(Field::pz) ) in >> four_momentum_[3];
+  if ( proj.has(Field::mass) ) in >> mass_;
+  if ( proj.has(Field::charge) ) in >> charge_;
+
+  if ( !in ) return;
+
+  fill_missing_fields( *this, proj.has(Field::E), proj.has(Field::mass),
+    proj.has(Field::charge) );
+}
@@ -0,0 +1,154 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <cmath>
+#include <sstream>
+#include <utility>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/JSON.hh"
+#include "marley/PrimaryEventFilter.hh"
+
+marley::PrimaryEventFilter::PrimaryEventFilter(const marley::JSON& json)
+{
+  if ( !json.is_object() ) throw marley::Error("The primary event cuts must"
+    " be given as a JSON object");
+
+  for ( const auto& pair : variables() ) {
+    const std::string& name = pair.first;
+    if ( !json.has_key(name) ) continue;
+
+    const marley::JSON& range = json.at( name );
+    if ( !range.is_array() || range.length() != 2 ) {
+      throw marley::Error("Invalid range " + range.dump_string() + " given"
+        " for the primary event cut on " + name + ". Expected an array"
+        " of the form [ min, max ].");
+    }
+
+    Cut cut{ pair.second, name, false, 0., false, 0. };
+
+    const marley::JSON& min = range.at( 0 );
+    if ( !min.is_null() ) {
+      cut.min = min.to_double( cut.has_min );
+      if ( !cut.has_min ) throw marley::Error("Invalid minimum value "
+        + min.dump_string() + " given for the primary event cut on "
+        + name);
+    }
+
+    const marley::JSON& max = range.at( 1 );
+    if ( !max.is_null() ) {
+      cut.max = max.to_double( cut.has_max );
+      if ( !cut.has_max ) throw marley::Error("Invalid maximum value "
+        + max.dump_string() + " given for the primary event cut on "
+        + name);
+    }
+
+    if ( cut.has_min && cut.has_max && cut.max < cut.min ) {
+      throw marley::Error("The maximum value is less than the minimum value"
+        " for the primary event cut on " + name);
+    }
+
+    if ( cut.has_min || cut.has_max ) cuts_.push_back( cut );
+  }
+}
+
+const std::vector< std::pair<std::string,
+  marley::PrimaryEventFilter::Variable> >&
+  marley::PrimaryEventFilter::variables()
+{
+  static const std::vector< std::pair<std::string, Variable> > vars = {
+    { "projectile_KE", Variable::ProjectileKE },
+    { "ejectile_KE", Variable::EjectileKE },
+    { "ejectile_cos_theta", Variable::EjectileCosTheta },
+    { "Ex", Variable::Ex },
+  };
+  return vars;
+}
+
+double marley::PrimaryEventFilter::evaluate(const std::string& variable,
+  const marley::Event& ev)
+{
+  for ( const auto& pair : variables() ) {
+    if ( pair.first == variable ) return evaluate( pair.second, ev );
+  }
+  throw marley::Error("Unrecognized event variable \"" + variable + '\"');
+  return 0.;
+}
+
+bool marley::PrimaryEventFilter::is_variable(const std::string& variable)
+{
+  for ( const auto& pair : variables() ) {
+    if ( pair.first == variable ) return true;
+  }
+  return false;
+}
+
+double marley::PrimaryEventFilter::evaluate(Variable var,
+  const marley::Event& ev)
+{
+  switch ( var ) {
+
+    case Variable::ProjectileKE:
+      return ev.projectile().kinetic_energy();
+
+    case Variable::EjectileKE:
+      return ev.ejectile().kinetic_energy();
+
+    case Variable::EjectileCosTheta: {
+      const auto& a = ev.projectile();
+      const auto& c = ev.ejectile();
+      double p_a = a.momentum_magnitude();
+      double p_c = c.momentum_magnitude();
+      if ( p_a <= 0. || p_c <= 0. ) return 1.;
+      return ( a.px()*c.px() + a.py()*c.py() + a.pz()*c.pz() ) / ( p_a * p_c );
+    }
+
+    case Variable::Ex:
+      return ev.Ex();
+  }
+
+  throw marley::Error("Unrecognized variable encountered in"
+    " marley::PrimaryEventFilter::evaluate()");
+  return 0.;
+}
+
+bool marley::PrimaryEventFilter::accepts(const marley::Event& ev) const
+{
+  for ( const auto& cut : cuts_ ) {
+    double value = evaluate( cut.variable, ev );
+    if ( cut.has_min && value < cut.min ) return false;
+    if ( cut.has_max && value > cut.max ) return false;
+  }
+  return true;
+}
+
+std::string marley::PrimaryEventFilter::to_string() const
+{
+  std::ostringstream out;
+  bool first = true;
+  for ( const auto& cut : cuts_ ) {
+    if ( !first ) out << ", ";
+    first = false;
+    if ( cut.has_min ) out << cut.min << " <= ";
+    out << cut.name;
+    if ( cut.has_max ) out << " <= " << cut.max;
+  }
+  return out.str();
+}
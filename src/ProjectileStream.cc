@@ -0,0 +1,345 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// standard library includes
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/Logger.hh"
+#include "marley/ProjectileStream.hh"
+#include "marley/StructureDatabase.hh"
+
+constexpr size_t marley::ProjectileStream::RECORD_BYTES;
+constexpr size_t marley::ProjectileStream::DEFAULT_BATCH_SIZE;
+constexpr size_t marley::ProjectileStream::MAX_QUEUED_PARTS_;
+
+namespace {
+
+  // Checks the values in a record that the Generator would otherwise
+  // accept silently
+  bool record_is_valid( const marley::ProjectileStream::Record& rec ) {
+    if ( !std::isfinite(rec.KEa) || !std::isfinite(rec.time) ) return false;
+    bool nonzero_dir = false;
+    for ( double d : rec.dir_vec ) {
+      if ( !std::isfinite(d) ) return false;
+      if ( d != 0. ) nonzero_dir = true;
+    }
+    return nonzero_dir;
+  }
+
+}
+
+marley::ProjectileStream::ProjectileStream( const marley::JSONConfig& config,
+  std::unique_ptr<std::istream> in, Format format, int num_threads,
+  size_t batch_size ) : state_( std::make_shared<SharedState>() )
+{
+  if ( !in ) throw marley::Error( "Null input stream passed to"
+    " marley::ProjectileStream::ProjectileStream()" );
+  if ( num_threads < 0 ) throw marley::Error( "Negative number of threads"
+    " requested in marley::ProjectileStream::ProjectileStream()" );
+  if ( batch_size < 1 ) throw marley::Error( "The batch size for a"
+    " projectile stream must be positive" );
+
+  if ( num_threads == 0 ) {
+    num_threads = std::max( 1u, std::thread::hardware_concurrency() );
+  }
+
+  state_->in = std::move( in );
+  state_->format = format;
+  state_->batch_size = batch_size;
+
+  // Each worker needs its own Generator since the Generator (and the
+  // StructureDatabase that it owns) is not thread-safe. Suppress the
+  // duplicate logging messages produced while configuring them.
+  auto& logger = marley::Logger::Instance();
+  bool log_enabled = logger.is_enabled();
+
+  try {
+    for ( int t = 0; t < num_threads; ++t ) {
+      auto worker = std::make_unique<Worker>();
+      worker->gen = std::make_unique<marley::Generator>(
+        config.create_generator() );
+      state_->workers.push_back( std::move(worker) );
+      logger.disable();
+    }
+
+    // Fill the (static) table of ground-state spin-parities, which may
+    // not be initialized concurrently by the worker threads
+    marley::StructureDatabase::fragments();
+  }
+  catch ( ... ) {
+    logger.enable( log_enabled );
+    throw;
+  }
+
+  logger.enable( log_enabled );
+
+  MARLEY_LOG_INFO() << "Creating events for a stream of projectile records"
+    << " using " << num_threads << " thread(s)";
+
+  for ( auto& worker : state_->workers ) {
+    Worker* w = worker.get();
+    w->thread = std::thread( [this, w]() { this->run_worker( *w ); } );
+  }
+  reader_ = std::thread( read_input, state_ );
+}
+
+marley::ProjectileStream::~ProjectileStream() {
+  bool input_done;
+  {
+    std::lock_guard<std::mutex> lock( state_->mutex );
+    state_->stop = true;
+    input_done = state_->input_done;
+  }
+  state_->cv.notify_all();
+
+  for ( auto& worker : state_->workers ) {
+    if ( worker->thread.joinable() ) worker->thread.join();
+  }
+
+  // The reader may be waiting for more input that will never arrive. Let
+  // it finish on its own in that case.
+  if ( reader_.joinable() ) {
+    if ( input_done ) reader_.join();
+    else reader_.detach();
+  }
+}
+
+std::unique_ptr<std::istream> marley::ProjectileStream::open_input(
+  const std::string& name, Format format )
+{
+  // Use a separate file stream even for the standard input. Unlike
+  // std::cin, it reports how much input can be read without blocking.
+  std::string file_name = ( name == "stdin" ) ? "/dev/stdin" : name;
+
+  auto mode = std::ios::in;
+  if ( format == Format::BINARY ) mode |= std::ios::binary;
+
+  auto in = std::make_unique<std::ifstream>( file_name, mode );
+  if ( !in->good() ) throw marley::Error( "Could not open the projectile"
+    " record file \"" + name + '\"' );
+  return in;
+}
+
+marley::ProjectileStream::Format marley::ProjectileStream::parse_format(
+  const std::string& name )
+{
+  if ( name == "text" ) return Format::TEXT;
+  else if ( name == "binary" ) return Format::BINARY;
+  throw marley::Error( "Invalid projectile record format \"" + name
+    + "\". Allowed values are \"text\" and \"binary\"." );
+}
+
+bool marley::ProjectileStream::read_record( std::istream& in, Format format,
+  Record& rec, long& line_number )
+{
+  if ( format == Format::BINARY ) {
+    char buffer[ RECORD_BYTES ];
+    in.read( buffer, RECORD_BYTES );
+    if ( in.gcount() == 0 ) return false;
+    ++line_number;
+    if ( static_cast<size_t>(in.gcount()) != RECORD_BYTES ) {
+      throw marley::Error( "Incomplete binary projectile record "
+        + std::to_string(line_number) + " found at the end of the input" );
+    }
+
+    int32_t pdgs[ 2 ];
+    double values[ 5 ];
+    std::memcpy( pdgs, buffer, sizeof(pdgs) );
+    std::memcpy( values, buffer + sizeof(pdgs), sizeof(values) );
+    rec = { pdgs[0], values[0], pdgs[1], { values[1], values[2], values[3] },
+      values[4] };
+
+    if ( !record_is_valid(rec) ) throw marley::Error( "Invalid values"
+      " found in binary projectile record " + std::to_string(line_number) );
+    return true;
+  }
+
+  std::string line;
+  while ( std::getline(in, line) ) {
+    ++line_number;
+
+    // Skip blank lines and comments
+    size_t first = line.find_first_not_of( " \t\r" );
+    if ( first == std::string::npos || line.at(first) == '#' ) continue;
+
+    std::istringstream iss( line );
+    rec.time = 0.;
+    bool ok = static_cast<bool>( iss >> rec.pdg_a >> rec.KEa >> rec.pdg_atom
+      >> rec.dir_vec[0] >> rec.dir_vec[1] >> rec.dir_vec[2] );
+
+    // The time is optional, but nothing may follow it
+    std::string extra;
+    if ( ok && (iss >> extra) ) {
+      std::istringstream time_iss( extra );
+      ok = static_cast<bool>( time_iss >> rec.time ) && time_iss.eof()
+        && !( iss >> extra );
+    }
+
+    if ( !ok || !record_is_valid(rec) ) throw marley::Error( "Invalid"
+      " projectile record on line " + std::to_string(line_number)
+      + " of the input: \"" + line + '\"' );
+    return true;
+  }
+  return false;
+}
+
+void marley::ProjectileStream::read_input(
+  std::shared_ptr<SharedState> state )
+{
+  std::istream& in = *state->in;
+  size_t num_workers = state->workers.size();
+  long line_number = 0;
+  long num_records = 0;
+  bool at_end = false;
+
+  while ( !at_end ) {
+
+    // Fill the current batch with as many records as are available
+    // without waiting
+    Part part;
+    part.first_record = num_records;
+    size_t batch_remaining = state->batch_size
+      - num_records % state->batch_size;
+    std::exception_ptr error;
+    try {
+      Record rec;
+      while ( part.records.size() < batch_remaining ) {
+        if ( !read_record(in, state->format, rec, line_number) ) {
+          at_end = true;
+          break;
+        }
+        part.records.push_back( rec );
+        if ( in.rdbuf()->in_avail() <= 0 ) break;
+      }
+    }
+    catch ( ... ) {
+      error = std::current_exception();
+      at_end = true;
+    }
+
+    std::unique_lock<std::mutex> lock( state->mutex );
+    if ( !part.records.empty() ) {
+      state->cv.wait( lock, [&state, num_workers]() { return state->stop
+        || state->part_workers.size() < MAX_QUEUED_PARTS_ * num_workers; } );
+      if ( state->stop ) break;
+
+      size_t w = ( num_records / state->batch_size ) % num_workers;
+      num_records += part.records.size();
+      state->workers.at( w )->input.push_back( std::move(part) );
+      state->part_workers.push_back( w );
+    }
+    if ( at_end ) state->input_error = error;
+    if ( state->stop ) break;
+    state->cv.notify_all();
+  }
+
+  std::lock_guard<std::mutex> lock( state->mutex );
+  state->input_done = true;
+  state->cv.notify_all();
+}
+
+void marley::ProjectileStream::run_worker( Worker& worker ) {
+  auto& state = *state_;
+  while ( true ) {
+
+    Part part;
+    {
+      std::unique_lock<std::mutex> lock( state.mutex );
+      state.cv.wait( lock, [&state, &worker]() { return state.stop
+        || !worker.input.empty() || state.input_done; } );
+      if ( state.stop || worker.input.empty() ) return;
+      part = std::move( worker.input.front() );
+      worker.input.pop_front();
+    }
+
+    // Each batch uses its own random number stream
+    if ( part.first_record % state.batch_size == 0 ) {
+      worker.gen->start_event_stream( part.first_record / state.batch_size );
+    }
+
+    part.events.reserve( part.records.size() );
+    for ( size_t r = 0; r < part.records.size(); ++r ) {
+      const Record& rec = part.records.at( r );
+      try {
+        part.events.push_back( worker.gen->create_event(rec.pdg_a, rec.KEa,
+          rec.pdg_atom, rec.dir_vec) );
+      }
+      catch ( const std::exception& err ) {
+        part.error = std::make_exception_ptr( marley::Error( "Could not"
+          " create an event for projectile record "
+          + std::to_string(part.first_record + r + 1) + ": " + err.what() ) );
+        break;
+      }
+    }
+    part.records.clear();
+
+    std::lock_guard<std::mutex> lock( state.mutex );
+    worker.output.push_back( std::move(part) );
+    state.cv.notify_all();
+  }
+}
+
+bool marley::ProjectileStream::next_event( marley::Event& ev ) {
+
+  while ( next_index_ >= current_.events.size() ) {
+
+    // Report a failure only after the events that were created before it
+    // have been handed out
+    if ( current_.error ) {
+      auto error = current_.error;
+      current_.error = nullptr;
+      std::rethrow_exception( error );
+    }
+
+    auto& state = *state_;
+    std::unique_lock<std::mutex> lock( state.mutex );
+    state.cv.wait( lock, [&state]() {
+      if ( state.part_workers.empty() ) return state.input_done;
+      return !state.workers.at( state.part_workers.front() )
+        ->output.empty();
+    } );
+
+    if ( state.part_workers.empty() ) {
+      if ( state.input_error ) {
+        auto error = state.input_error;
+        state.input_error = nullptr;
+        std::rethrow_exception( error );
+      }
+      return false;
+    }
+
+    auto& worker = *state.workers.at( state.part_workers.front() );
+    state.part_workers.pop_front();
+    current_ = std::move( worker.output.front() );
+    worker.output.pop_front();
+    next_index_ = 0;
+    state.cv.notify_all();
+  }
+
+  ev = std::move( current_.events.at(next_index_) );
+  ++next_index_;
+  ++event_count_;
+  return true;
+}
@@ -24,6 +24,7 @@
 #include "marley/MatrixElement.hh"
 #include "marley/NuclearReaction.hh"
 #include "marley/Reaction.hh"
+#include "marley/StartupProfile.hh"
 #include "marley/StructureDatabase.hh"
 #include "marley/marley_kinematics.hh"
 #include "marley/marley_utils.hh"
@@ -288,6 +289,9 @@ std::vector< std::unique_ptr<marley::Reaction> >
   marley::Reaction::load_from_file(const std::string& filename,
   marley::StructureDatabase& db)
 {
+  marley::StartupProfile::Phase phase( "Load reaction data from "
+    + filename.substr(filename.find_last_of('/') + 1) );
+
   // Create an empty vector to start
   std::vector< std::unique_ptr<marley::Reaction> > loaded_reactions;
 
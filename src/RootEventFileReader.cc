@@ -21,7 +21,9 @@
 #include "TParameter.h"
 
 // MARLEY includes
+#include "marley/Generator.hh"
 #include "marley/RootEventFileReader.hh"
+#include "marley/RootJSONConfig.hh"
 
 marley::RootEventFileReader::RootEventFileReader(const std::string& file_name)
   : marley::EventFileReader(file_name)
@@ -96,6 +98,21 @@ bool marley::RootEventFileReader::next_event( marley::Event& ev )
   else return marley::EventFileReader::next_event( ev );
 }
 
+std::unique_ptr<marley::EventFileReader>
+  marley::RootEventFileReader::open_shard(const std::string& file_name) const
+{
+  return std::make_unique<marley::RootEventFileReader>( file_name );
+}
+
+std::unique_ptr<marley::Generator>
+  marley::RootEventFileReader::create_generator(
+  const marley::JSON& config) const
+{
+  // Leave the Logger settings chosen by the user alone
+  marley::RootJSONConfig jc( config, false );
+  return std::make_unique<marley::Generator>( jc.create_generator() );
+}
+
 marley::RootEventFileReader::operator bool() const {
   if ( format_ == marley::OutputFile::Format::ROOT ) {
     return ( tfile_ && ttree_ && event_num_ < ttree_->GetEntries() );
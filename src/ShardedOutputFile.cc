@@ -0,0 +1,362 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// standard library includes
+#include <iomanip>
+#include <sstream>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Generator.hh"
+#include "marley/Logger.hh"
+#include "marley/ShardedOutputFile.hh"
+#include "marley/marley_utils.hh"
+
+namespace {
+
+  std::string format_to_string(marley::OutputFile::Format format) {
+    switch ( format ) {
+      case marley::OutputFile::Format::ROOT: return "root";
+      case marley::OutputFile::Format::HEPEVT: return "hepevt";
+      case marley::OutputFile::Format::HEPMC3: return "hepmc3";
+      case marley::OutputFile::Format::JSON: return "json";
+      case marley::OutputFile::Format::ASCII: return "ascii";
+      case marley::OutputFile::Format::VIRTUAL: return "virtual";
+    }
+    return "";
+  }
+
+  // Returns the name of a file without any leading directories
+  std::string strip_directories(const std::string& file_name) {
+    size_t slash_pos = file_name.find_last_of('/');
+    if ( slash_pos == std::string::npos ) return file_name;
+    return file_name.substr( slash_pos + 1 );
+  }
+
+  // Returns the size of a file on disk, or zero if it cannot be opened
+  int_fast64_t file_size(const std::string& file_name) {
+    std::ifstream in( file_name, std::ios::in | std::ios::binary
+      | std::ios::ate );
+    if ( !in ) return 0;
+    return static_cast<int_fast64_t>( in.tellg() );
+  }
+
+}
+
+marley::ShardedOutputFile::ShardedOutputFile(const std::string& name,
+  const std::string& format, const std::string& mode, bool force,
+  ShardFactory factory, int num_shards, long max_events_per_shard,
+  int_fast64_t max_bytes_per_shard)
+  : marley::OutputFile(name, format, mode, force), factory_(factory),
+  max_events_per_shard_(max_events_per_shard),
+  max_bytes_per_shard_(max_bytes_per_shard)
+{
+  if ( mode_ != Mode::OVERWRITE ) throw marley::Error("The output mode \""
+    + mode + "\" is not allowed for the sharded output file \"" + name
+    + "\". Only \"overwrite\" may be used.");
+
+  if ( num_shards < 1 ) throw marley::Error("Invalid number of shards "
+    + std::to_string(num_shards) + " requested for the output file \""
+    + name + '\"');
+
+  if ( max_events_per_shard_ < 0 || max_bytes_per_shard_ < 0 ) {
+    throw marley::Error("Negative shard size limit given for the output"
+      " file \"" + name + '\"');
+  }
+
+  // Split the file name into a stem and an extension. The extension begins
+  // at the first period in the last component of the path (so that, e.g.,
+  // ".ascii.gz" is kept intact).
+  size_t slash_pos = name_.find_last_of('/');
+  size_t base_pos = ( slash_pos == std::string::npos ) ? 0 : slash_pos + 1;
+  size_t dot_pos = name_.find( '.', base_pos + 1 );
+  if ( dot_pos != std::string::npos ) {
+    stem_ = name_.substr( 0, dot_pos );
+    extension_ = name_.substr( dot_pos );
+  }
+  else stem_ = name_;
+
+  // Use the manifest file name as the name of this OutputFile
+  name_ += ".manifest";
+
+  // ROOT files are written on the calling thread
+  threaded_ = ( format_ != Format::ROOT );
+
+  for ( int s = 0; s < num_shards; ++s ) {
+    lanes_.push_back( std::make_unique<Lane>() );
+  }
+
+  this->open();
+}
+
+marley::ShardedOutputFile::~ShardedOutputFile() {
+  for ( auto& lane : lanes_ ) this->stop( *lane );
+}
+
+void marley::ShardedOutputFile::open() {
+  bool file_exists = check_if_file_exists( name_ );
+  if ( file_exists && !force_ ) {
+    bool overwrite = marley_utils::prompt_yes_no("Overwrite file "
+      + name_);
+    if ( !overwrite ) throw marley::Error("Cancelling overwrite of the"
+      " manifest file \"" + name_ + '\"');
+  }
+
+  if ( !threaded_ ) return;
+  for ( auto& lane : lanes_ ) {
+    Lane* l = lane.get();
+    l->thread_ = std::thread( [this, l]() { this->write_events(*l); } );
+  }
+}
+
+std::string marley::ShardedOutputFile::shard_name(size_t index) const {
+  std::ostringstream temp;
+  temp << stem_ << '_' << std::setw(4) << std::setfill('0') << index
+    << extension_;
+  return temp.str();
+}
+
+void marley::ShardedOutputFile::set_generator(
+  const marley::JSON& json_config, const marley::Generator& gen)
+{
+  json_config_ = json_config;
+  gen_ = &gen;
+}
+
+bool marley::ShardedOutputFile::resume(std::unique_ptr<marley::Generator>&,
+  long&)
+{
+  throw marley::Error("Cannot resume a previous run using the sharded"
+    " output file \"" + name_ + '\"');
+  return false;
+}
+
+void marley::ShardedOutputFile::write_events(Lane& lane) {
+  std::deque<marley::Event> batch;
+  bool failed = false;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock( lane.mutex_ );
+      lane.busy_ = false;
+      lane.cv_.notify_all();
+      lane.cv_.wait( lock, [&lane]()
+        { return lane.stop_ || !lane.queue_.empty(); } );
+      if ( lane.queue_.empty() ) return;
+      batch.swap( lane.queue_ );
+      lane.busy_ = true;
+    }
+    // Wake up the generator thread if it is waiting for space in the queue
+    lane.cv_.notify_all();
+
+    if ( !failed ) {
+      try {
+        for ( const auto& ev : batch ) lane.file_->write_event( &ev );
+        lane.num_bytes_ = lane.file_->bytes_written();
+      }
+      catch ( ... ) {
+        failed = true;
+        std::lock_guard<std::mutex> lock( lane.mutex_ );
+        lane.error_ = std::current_exception();
+      }
+    }
+    batch.clear();
+  }
+}
+
+void marley::ShardedOutputFile::drain(Lane& lane) {
+  if ( !threaded_ ) return;
+  std::unique_lock<std::mutex> lock( lane.mutex_ );
+  lane.cv_.wait( lock, [&lane]()
+    { return lane.queue_.empty() && !lane.busy_; } );
+}
+
+void marley::ShardedOutputFile::stop(Lane& lane) {
+  if ( !lane.thread_.joinable() ) return;
+  {
+    std::lock_guard<std::mutex> lock( lane.mutex_ );
+    lane.stop_ = true;
+  }
+  lane.cv_.notify_all();
+  lane.thread_.join();
+}
+
+void marley::ShardedOutputFile::check_for_errors(Lane& lane) {
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock( lane.mutex_ );
+    error = lane.error_;
+  }
+  if ( error ) std::rethrow_exception( error );
+}
+
+void marley::ShardedOutputFile::open_shard(Lane& lane, long first_event) {
+  lane.shard_index_ = shards_.size();
+  ShardInfo info;
+  info.file_name_ = this->shard_name( lane.shard_index_ );
+  info.first_event_ = first_event;
+
+  auto file = factory_( info.file_name_ );
+  file->set_projection( projection_ );
+  file->write_flux_avg_tot_xsec( flux_avg_tot_xsec_ );
+
+  shards_.push_back( info );
+  lane.num_events_ = 0;
+  lane.num_bytes_ = file->bytes_written();
+
+  // Hand the new file to the writer thread
+  std::lock_guard<std::mutex> lock( lane.mutex_ );
+  lane.file_ = std::move( file );
+}
+
+void marley::ShardedOutputFile::close_shard(Lane& lane,
+  const marley::JSON& json_config, const marley::Generator& gen)
+{
+  this->drain( lane );
+  this->check_for_errors( lane );
+
+  // The writer thread is idle, so we may safely use the file here
+  lane.file_->close( json_config, gen, lane.num_events_ );
+
+  ShardInfo& info = shards_.at( lane.shard_index_ );
+  info.num_events_ = lane.num_events_;
+  info.num_bytes_ = file_size( info.file_name_ );
+  closed_bytes_ += info.num_bytes_;
+
+  std::lock_guard<std::mutex> lock( lane.mutex_ );
+  lane.file_.reset();
+  lane.num_events_ = 0;
+  lane.num_bytes_ = 0;
+}
+
+void marley::ShardedOutputFile::write_event(const marley::Event* event) {
+  if ( !event ) throw marley::Error("Null pointer passed to"
+    " ShardedOutputFile::write_event()");
+
+  Lane& lane = *lanes_.at( next_lane_ );
+  next_lane_ = ( next_lane_ + 1 ) % lanes_.size();
+
+  this->check_for_errors( lane );
+
+  // Roll over to a new shard file if the current one is full
+  if ( lane.file_ ) {
+    bool full = ( max_events_per_shard_ > 0
+      && lane.num_events_ >= max_events_per_shard_ )
+      || ( max_bytes_per_shard_ > 0
+      && lane.num_bytes_ >= max_bytes_per_shard_ );
+
+    if ( full ) {
+      if ( !gen_ ) throw marley::Error("ShardedOutputFile::set_generator()"
+        " must be called before events are written to the sharded output"
+        " file \"" + name_ + '\"');
+      this->close_shard( lane, json_config_, *gen_ );
+    }
+  }
+
+  if ( !lane.file_ ) this->open_shard( lane, num_events_written_ );
+  ++lane.num_events_;
+  ++num_events_written_;
+
+  if ( !threaded_ ) {
+    lane.file_->write_event( event );
+    if ( max_bytes_per_shard_ > 0 ) {
+      lane.num_bytes_ = lane.file_->bytes_written();
+    }
+    return;
+  }
+
+  // Wait for space in the queue, then pass a copy of the event to the
+  // writer thread
+  std::unique_lock<std::mutex> lock( lane.mutex_ );
+  lane.cv_.wait( lock, [&lane]()
+    { return lane.queue_.size() < MAX_QUEUED_EVENTS_ || lane.error_; } );
+  lane.queue_.push_back( *event );
+  lock.unlock();
+  lane.cv_.notify_all();
+}
+
+void marley::ShardedOutputFile::write_flux_avg_tot_xsec(double avg_tot_xsec)
+{
+  flux_avg_tot_xsec_ = avg_tot_xsec;
+}
+
+int_fast64_t marley::ShardedOutputFile::bytes_written() {
+  int_fast64_t result = closed_bytes_;
+  for ( const auto& lane : lanes_ ) {
+    if ( threaded_ ) result += lane->num_bytes_;
+    else if ( lane->file_ ) result += lane->file_->bytes_written();
+  }
+  return result;
+}
+
+void marley::ShardedOutputFile::close(const marley::JSON& json_config,
+  const marley::Generator& gen, const long num_events)
+{
+  for ( auto& lane : lanes_ ) {
+    this->drain( *lane );
+    this->stop( *lane );
+    this->check_for_errors( *lane );
+    if ( lane->file_ ) this->close_shard( *lane, json_config, gen );
+  }
+
+  this->write_generator_state( json_config, gen, num_events );
+}
+
+void marley::ShardedOutputFile::write_generator_state(
+  const marley::JSON& json_config, const marley::Generator& gen,
+  const long num_events)
+{
+  // Events are assigned to the lanes round-robin, so the events in each
+  // shard have indices first_event, first_event + stride, etc.
+  long stride = static_cast<long>( lanes_.size() );
+  marley::JSON shard_array = marley::JSON::array();
+  long event_count = 0;
+  for ( const auto& info : shards_ ) {
+    marley::JSON shard = marley::JSON::object();
+    shard["file"] = strip_directories( info.file_name_ );
+    shard["first_event"] = info.first_event_;
+    shard["stride"] = stride;
+    shard["num_events"] = info.num_events_;
+    shard["bytes"] = info.num_bytes_;
+    shard_array.append( shard );
+    event_count += info.num_events_;
+  }
+
+  marley::JSON manifest = marley::JSON::object();
+  manifest["format"] = format_to_string( format_ );
+  manifest["event_count"] = event_count;
+  manifest["flux_avg_xsec"] = gen.flux_averaged_total_xs();
+  if ( !projection_.is_complete() ) {
+    manifest["projection"] = projection_.to_json();
+  }
+  manifest["shards"] = shard_array;
+
+  marley::JSON gen_state = marley::JSON::object();
+  gen_state["config"] = json_config;
+  gen_state["generator_state_string"] = gen.get_state_string();
+  gen_state["seed"] = std::to_string( gen.get_seed() );
+  gen_state["event_count"] = num_events;
+  gen_state["flux_avg_xsec"] = gen.flux_averaged_total_xs();
+
+  marley::JSON temp = marley::JSON::object();
+  temp["manifest"] = manifest;
+  temp["gen_state"] = gen_state;
+
+  std::ofstream out( name_ );
+  temp.print( out, 2, true );
+  out << '\n';
+  if ( !out ) throw marley::Error("Failed to write the manifest file \""
+    + name_ + '\"');
+}
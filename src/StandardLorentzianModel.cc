@@ -68,7 +68,7 @@ marley::StandardLorentzianModel::StandardLorentzianModel(int Z, int A)
 }
 
 double marley::StandardLorentzianModel::strength_function_coefficient(
-  TrType type, int l, double e_gamma)
+  TrType type, int l, double e_gamma) const
 {
   check_multipolarity(l);
 
@@ -131,14 +131,14 @@ double marley::StandardLorentzianModel::strength_function_coefficient(
 }
 
 double marley::StandardLorentzianModel::strength_function(TrType type, int l,
-  double e_gamma)
+  double e_gamma) const
 {
   return std::pow(e_gamma, 3 - 2*l)
     * strength_function_coefficient(type, l, e_gamma);
 }
 
 double marley::StandardLorentzianModel::transmission_coefficient(TrType type,
-  int l, double e_gamma)
+  int l, double e_gamma) const
 {
   // Eg^4 = (Eg^[2l + 1] * Eg^[3 - 2l]
   return 2. * marley_utils::pi * strength_function_coefficient(type, l, e_gamma)
@@ -0,0 +1,218 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+#include "fcntl.h"
+#include "unistd.h"
+
+#include "marley/Error.hh"
+#include "marley/JSON.hh"
+#include "marley/StartupProfile.hh"
+
+namespace {
+
+  using Clock = std::chrono::steady_clock;
+  using Record = marley::StartupProfile::Record;
+  using Sample = marley::StartupProfile::Sample;
+
+  std::atomic<bool> profile_enabled( false );
+  std::atomic<marley::StartupProfile::AllocationCounter>
+    allocation_counter( nullptr );
+
+  std::mutex records_mutex;
+  std::vector<Record> phase_records;
+
+  thread_local int phase_depth = 0;
+
+  // Bytes obtained by the reads of /proc/self/io done below. These are
+  // subtracted so that the profile does not count its own I/O. The value
+  // reported by each read does not yet include the bytes that it returns.
+  std::atomic<long> own_bytes_read( 0 );
+
+  // Returns the number of bytes read so far by this process, or -1 if this
+  // information is not available (e.g., on systems other than Linux). The
+  // POSIX I/O functions are used to avoid memory allocations.
+  long process_bytes_read() {
+    int fd = open( "/proc/self/io", O_RDONLY );
+    if ( fd < 0 ) return -1;
+
+    char buffer[ 512 ];
+    ssize_t num_read = read( fd, buffer, sizeof(buffer) - 1 );
+    close( fd );
+    if ( num_read <= 0 ) return -1;
+
+    long own = own_bytes_read.fetch_add( num_read );
+    buffer[ num_read ] = '\0';
+
+    const char* rchar = std::strstr( buffer, "rchar:" );
+    if ( !rchar ) return -1;
+    return std::strtol( rchar + std::strlen("rchar:"), nullptr, 10 ) - own;
+  }
+
+  // Differences between two counter values, either of which may be unknown
+  long counter_difference( long start, long stop ) {
+    if ( start < 0 || stop < 0 ) return -1;
+    return stop - start;
+  }
+
+  void fill_record( Record& rec, const Sample& start, const Sample& stop ) {
+    rec.wall = std::chrono::duration<double>( stop.wall - start.wall ).count();
+    rec.cpu = stop.cpu - start.cpu;
+    rec.allocations = counter_difference( start.allocations,
+      stop.allocations );
+    rec.bytes_read = counter_difference( start.bytes_read, stop.bytes_read );
+  }
+}
+
+marley::StartupProfile::Phase::Phase( const std::string& name ) {
+  if ( !profile_enabled.load(std::memory_order_relaxed) ) return;
+
+  // Reserve the record before taking the first snapshot so that the
+  // bookkeeping isn't included in the totals for this phase
+  {
+    std::lock_guard<std::mutex> lock( records_mutex );
+    index_ = static_cast<long>( phase_records.size() );
+    phase_records.push_back( { name, phase_depth, 0., 0., 0, 0 } );
+  }
+  ++phase_depth;
+  start_ = StartupProfile::sample();
+}
+
+marley::StartupProfile::Phase::~Phase() {
+  if ( index_ < 0 ) return;
+  Sample stop = StartupProfile::sample();
+  --phase_depth;
+  std::lock_guard<std::mutex> lock( records_mutex );
+  fill_record( phase_records.at(index_), start_, stop );
+}
+
+void marley::StartupProfile::enable() {
+  profile_enabled.store( true );
+}
+
+void marley::StartupProfile::disable() {
+  profile_enabled.store( false );
+}
+
+bool marley::StartupProfile::enabled() {
+  return profile_enabled.load( std::memory_order_relaxed );
+}
+
+void marley::StartupProfile::set_allocation_counter(
+  AllocationCounter counter )
+{
+  allocation_counter.store( counter );
+}
+
+marley::StartupProfile::Sample marley::StartupProfile::sample() {
+  Sample s;
+  s.bytes_read = process_bytes_read();
+  AllocationCounter counter = allocation_counter.load();
+  s.allocations = counter ? counter() : -1;
+  s.cpu = static_cast<double>( std::clock() ) / CLOCKS_PER_SEC;
+  s.wall = Clock::now();
+  return s;
+}
+
+void marley::StartupProfile::record( const std::string& name,
+  const Sample& start, const Sample& stop )
+{
+  if ( !enabled() ) return;
+  Record rec = { name, phase_depth, 0., 0., 0, 0 };
+  fill_record( rec, start, stop );
+  std::lock_guard<std::mutex> lock( records_mutex );
+  phase_records.push_back( rec );
+}
+
+std::vector<marley::StartupProfile::Record>
+  marley::StartupProfile::records()
+{
+  std::lock_guard<std::mutex> lock( records_mutex );
+  return phase_records;
+}
+
+void marley::StartupProfile::print( std::ostream& out ) {
+  auto recs = StartupProfile::records();
+
+  constexpr int INDENT = 2;
+  size_t name_width = std::strlen( "Phase" );
+  for ( const auto& rec : recs ) {
+    name_width = std::max( name_width, rec.name.size() + INDENT*rec.depth );
+  }
+
+  // Prints a counter value, or a dash if it is unknown
+  auto counter = []( long value ) -> std::string {
+    return value < 0 ? std::string( "-" ) : std::to_string( value );
+  };
+
+  std::ostringstream oss;
+  oss << std::left << std::setw( name_width ) << "Phase" << std::right
+    << std::setw( 12 ) << "Wall (s)" << std::setw( 12 ) << "CPU (s)"
+    << std::setw( 14 ) << "Allocations" << std::setw( 14 ) << "Bytes read"
+    << '\n';
+  oss << std::fixed << std::setprecision( 4 );
+
+  double total_wall = 0.;
+  double total_cpu = 0.;
+  for ( const auto& rec : recs ) {
+    oss << std::left << std::setw( name_width )
+      << std::string( INDENT*rec.depth, ' ' ) + rec.name << std::right
+      << std::setw( 12 ) << rec.wall << std::setw( 12 ) << rec.cpu
+      << std::setw( 14 ) << counter( rec.allocations ) << std::setw( 14 )
+      << counter( rec.bytes_read ) << '\n';
+    if ( rec.depth == 0 ) {
+      total_wall += rec.wall;
+      total_cpu += rec.cpu;
+    }
+  }
+
+  oss << std::left << std::setw( name_width ) << "Total" << std::right
+    << std::setw( 12 ) << total_wall << std::setw( 12 ) << total_cpu << '\n';
+
+  out << oss.str();
+}
+
+marley::JSON marley::StartupProfile::to_json() {
+  marley::JSON phases = marley::JSON::array();
+  for ( const auto& rec : StartupProfile::records() ) {
+    marley::JSON phase = marley::JSON::make( marley::JSON::DataType::Object );
+    phase[ "name" ] = marley::JSON( rec.name );
+    phase[ "depth" ] = rec.depth;
+    phase[ "wall_time" ] = rec.wall;
+    phase[ "cpu_time" ] = rec.cpu;
+    if ( rec.allocations >= 0 ) phase[ "allocations" ] = rec.allocations;
+    if ( rec.bytes_read >= 0 ) phase[ "bytes_read" ] = rec.bytes_read;
+    phases.append( phase );
+  }
+  return phases;
+}
+
+void marley::StartupProfile::write( const std::string& file_name ) {
+  std::ofstream out( file_name );
+  if ( !out ) throw marley::Error( "Could not open the startup profile"
+    " file \"" + file_name + '\"' );
+  out << StartupProfile::to_json().dump_string( 2 ) << '\n';
+}
@@ -0,0 +1,237 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/JSON.hh"
+#include "marley/PrimaryEventFilter.hh"
+#include "marley/StoppingRule.hh"
+
+constexpr long marley::StoppingRule::MIN_EVENTS;
+
+void marley::StoppingRule::Accumulator::add(double x) {
+  // Welford's algorithm
+  ++count;
+  double delta = x - mean;
+  mean += delta / count;
+  m2 += delta * ( x - mean );
+}
+
+void marley::StoppingRule::Accumulator::merge(const Accumulator& other) {
+  if ( other.count == 0 ) return;
+  if ( count == 0 ) {
+    *this = other;
+    return;
+  }
+
+  long n = count + other.count;
+  double delta = other.mean - mean;
+  mean += delta * other.count / n;
+  m2 += other.m2 + delta * delta * count * other.count / n;
+  count = n;
+}
+
+double marley::StoppingRule::Accumulator::variance() const {
+  if ( count < 2 ) return 0.;
+  return m2 / ( count - 1 );
+}
+
+double marley::StoppingRule::Accumulator::std_error() const {
+  if ( count < 2 ) return std::numeric_limits<double>::infinity();
+  return std::sqrt( variance() / count );
+}
+
+double marley::StoppingRule::Accumulator::relative_error() const {
+  if ( mean == 0. ) return std::numeric_limits<double>::infinity();
+  return std_error() / std::abs( mean );
+}
+
+marley::StoppingRule::StoppingRule(const marley::JSON& json) {
+
+  if ( !json.is_object() ) throw marley::Error("The stopping rule settings"
+    " must be given as a JSON object");
+
+  if ( !json.has_key("targets") || !json.at("targets").is_array() ) {
+    throw marley::Error("The stopping rule settings must include a"
+      " \"targets\" array");
+  }
+
+  // Without any precision targets, the rule would be satisfied right away
+  if ( json.at("targets").length() == 0 ) throw marley::Error("The"
+    " \"targets\" array in the stopping rule settings may not be empty");
+
+  for ( const auto& tj : json.at("targets").array_range() ) {
+
+    if ( !tj.is_object() ) throw marley::Error("Invalid precision target "
+      + tj.dump_string() + ". Each target must be a JSON object.");
+
+    Target target{ "", Kind::Fraction, "", 0, 0., 0., 0., Accumulator() };
+
+    std::string kind = tj.has_key( "observable" )
+      ? tj.at( "observable" ).to_string() : "";
+    if ( kind == "fraction" ) target.kind = Kind::Fraction;
+    else if ( kind == "mean" ) target.kind = Kind::Mean;
+    else throw marley::Error("Invalid observable \"" + kind + "\" given for"
+      " the precision target " + tj.dump_string() + ". Valid choices are"
+      " \"fraction\" and \"mean\".");
+
+    bool has_particle = tj.has_key( "particle" );
+    bool has_variable = tj.has_key( "variable" );
+    if ( has_particle == has_variable ) throw marley::Error("Exactly one of"
+      " the \"particle\" and \"variable\" keys must be given for the"
+      " precision target " + tj.dump_string());
+
+    if ( has_particle ) {
+      bool ok;
+      target.pdg = tj.at( "particle" ).to_long( ok );
+      if ( !ok ) throw marley::Error("Invalid PDG code "
+        + tj.at("particle").dump_string() + " given for a precision"
+        " target");
+    }
+    else {
+      target.variable = tj.at( "variable" ).to_string();
+      if ( !marley::PrimaryEventFilter::is_variable(target.variable) ) {
+        throw marley::Error("Unrecognized variable \"" + target.variable
+          + "\" given for a precision target");
+      }
+    }
+
+    // Fractions of events based on a variable (e.g., histogram bins)
+    // need a range of values
+    bool needs_range = ( target.kind == Kind::Fraction && has_variable );
+    if ( needs_range != tj.has_key("range") ) throw marley::Error("A"
+      " \"range\" must be given for (and only for) fraction targets that"
+      " use a variable. Check the precision target " + tj.dump_string());
+
+    if ( needs_range ) {
+      const marley::JSON& range = tj.at( "range" );
+      bool ok_min = false, ok_max = false;
+      if ( range.is_array() && range.length() == 2 ) {
+        target.min = range.at( 0 ).to_double( ok_min );
+        target.max = range.at( 1 ).to_double( ok_max );
+      }
+      if ( !ok_min || !ok_max || target.max < target.min ) {
+        throw marley::Error("Invalid range " + range.dump_string()
+          + " given for a precision target. Expected an array of the form"
+          " [ min, max ].");
+      }
+    }
+
+    bool ok = false;
+    if ( tj.has_key("precision") ) {
+      target.precision = tj.at( "precision" ).to_double( ok );
+    }
+    if ( !ok || target.precision <= 0. ) throw marley::Error("A positive"
+      " relative uncertainty must be given using the \"precision\" key for"
+      " the precision target " + tj.dump_string());
+
+    if ( tj.has_key("name") ) target.name = tj.at( "name" ).to_string();
+    else {
+      std::ostringstream name;
+      name << ( target.kind == Kind::Fraction ? "fraction" : "mean" );
+      if ( has_particle ) name << " (particle " << target.pdg << ')';
+      else {
+        name << " (" << target.variable;
+        if ( needs_range ) name << " in [" << target.min << ", "
+          << target.max << ']';
+        name << ')';
+      }
+      target.name = name.str();
+    }
+
+    targets_.push_back( target );
+  }
+
+  if ( json.has_key("max_time") ) {
+    bool ok;
+    max_time_ = json.at( "max_time" ).to_double( ok );
+    if ( !ok || max_time_ < 0. ) throw marley::Error("Invalid maximum time "
+      + json.at("max_time").dump_string() + " given for the stopping rule");
+  }
+
+  if ( json.has_key("check_interval") ) {
+    bool ok;
+    check_interval_ = json.at( "check_interval" ).to_long( ok );
+    if ( !ok || check_interval_ <= 0 ) throw marley::Error("Invalid check"
+      " interval " + json.at("check_interval").dump_string() + " given for"
+      " the stopping rule");
+  }
+}
+
+double marley::StoppingRule::value(const Target& target,
+  const marley::Event& ev)
+{
+  if ( target.variable.empty() ) {
+    double KE_sum = 0.;
+    bool found = false;
+    for ( const auto* p : ev.get_final_particles() ) {
+      if ( p->pdg_code() != target.pdg ) continue;
+      found = true;
+      KE_sum += p->kinetic_energy();
+    }
+    if ( target.kind == Kind::Fraction ) return found ? 1. : 0.;
+    return KE_sum;
+  }
+
+  double x = marley::PrimaryEventFilter::evaluate( target.variable, ev );
+  if ( target.kind == Kind::Mean ) return x;
+  return ( x >= target.min && x <= target.max ) ? 1. : 0.;
+}
+
+void marley::StoppingRule::add_event(const marley::Event& ev) {
+  for ( auto& target : targets_ ) target.acc.add( value(target, ev) );
+}
+
+void marley::StoppingRule::merge(const StoppingRule& other) {
+  if ( other.targets_.size() != targets_.size() ) throw marley::Error(
+    "Cannot merge StoppingRule objects that have different targets");
+  for ( size_t t = 0u; t < targets_.size(); ++t ) {
+    targets_.at( t ).acc.merge( other.targets_.at(t).acc );
+  }
+}
+
+bool marley::StoppingRule::targets_met() const {
+  if ( this->num_events() < MIN_EVENTS ) return false;
+  for ( const auto& target : targets_ ) {
+    if ( !(target.acc.relative_error() <= target.precision) ) return false;
+  }
+  return true;
+}
+
+long marley::StoppingRule::num_events() const {
+  if ( targets_.empty() ) return 0;
+  return targets_.front().acc.count;
+}
+
+std::string marley::StoppingRule::summary() const {
+  std::ostringstream out;
+  out << "Precision targets after " << this->num_events() << " events:";
+  for ( const auto& target : targets_ ) {
+    double rel_err = target.acc.relative_error();
+    out << "\n  " << target.name << " = " << target.acc.mean << " +/- "
+      << target.acc.std_error() << " (relative uncertainty " << rel_err
+      << ", target " << target.precision << ", "
+      << ( rel_err <= target.precision ? "met" : "NOT met" ) << ')';
+  }
+  return out.str();
+}
@@ -22,13 +22,16 @@
 // MARLEY includes
 #include "marley/marley_utils.hh"
 #include "marley/BackshiftedFermiGasModel.hh"
+#include "marley/ChebyshevInterpolatingFunction.hh"
 #include "marley/Error.hh"
 #include "marley/FileManager.hh"
 #include "marley/Fragment.hh"
 #include "marley/KoningDelarocheOpticalModel.hh"
 #include "marley/Logger.hh"
 #include "marley/StandardLorentzianModel.hh"
+#include "marley/StartupProfile.hh"
 #include "marley/StructureDatabase.hh"
+#include "marley/TabulatedOpticalModel.hh"
 #include "marley/TargetAtom.hh"
 
 // Define static data members of the StructureDatabase class
@@ -47,7 +50,48 @@ const std::string marley::StructureDatabase
 // been loaded
 bool marley::StructureDatabase::initialized_gs_spin_parity_table_ = false;
 
-marley::StructureDatabase::StructureDatabase() {}
+marley::StructureDatabase::StructureDatabase()
+  : numerov_step_size_( marley::KoningDelarocheOpticalModel
+  ::DEFAULT_NUMEROV_STEP_SIZE_ ), continuum_integrator_(
+  DEFAULT_CONTINUUM_QUADRATURE_ORDER ), continuum_chebyshev_points_(
+  marley::DEFAULT_N_CHEBYSHEV )
+{
+}
+
+void marley::StructureDatabase::set_numerov_step_size( double step_size )
+{
+  if ( !(step_size > 0.) ) throw marley::Error( "Invalid Numerov step size "
+    + std::to_string(step_size) + " fm passed to marley::StructureDatabase"
+    "::set_numerov_step_size()" );
+  numerov_step_size_ = step_size;
+}
+
+void marley::StructureDatabase::set_continuum_quadrature_order( int order )
+{
+  if ( order < 2 ) throw marley::Error( "Invalid continuum quadrature order "
+    + std::to_string(order) + " passed to marley::StructureDatabase"
+    "::set_continuum_quadrature_order()" );
+  continuum_quadrature_order_ = order;
+  continuum_integrator_ = marley::Integrator( order );
+}
+
+void marley::StructureDatabase::set_continuum_chebyshev_points(
+  int num_points )
+{
+  if ( num_points < 2 ) throw marley::Error( "Invalid number of continuum"
+    " Chebyshev points " + std::to_string(num_points) + " passed to"
+    " marley::StructureDatabase::set_continuum_chebyshev_points()" );
+  continuum_chebyshev_points_ = num_points;
+}
+
+void marley::StructureDatabase::set_continuum_sampling_tolerance(
+  double tolerance )
+{
+  if ( !(tolerance > 0.) ) throw marley::Error( "Invalid continuum sampling"
+    " tolerance " + std::to_string(tolerance) + " MeV passed to"
+    " marley::StructureDatabase::set_continuum_sampling_tolerance()" );
+  continuum_sampling_tolerance_ = tolerance;
+}
 
 void marley::StructureDatabase::add_decay_scheme(int pdg,
   std::unique_ptr<marley::DecayScheme>& ds)
@@ -148,6 +192,8 @@ marley::DecayScheme* marley::StructureDatabase::get_decay_scheme(
     std::string ds_file_name = ds_file_iter->second;
     auto& fm = marley::FileManager::Instance();
     std::string full_ds_file_name = fm.find_file( ds_file_name );
+    marley::StartupProfile::Phase phase( "Load structure data from "
+      + ds_file_name );
     std::ifstream ds_data_file( full_ds_file_name );
     bool found_it = false;
     auto temp_ds = std::make_unique< marley::DecayScheme >();
@@ -189,45 +235,63 @@ marley::DecayScheme* marley::StructureDatabase::get_decay_scheme(const int Z,
   return get_decay_scheme( particle_id );
 }
 
-marley::OpticalModel& marley::StructureDatabase::get_optical_model(
+const marley::OpticalModel& marley::StructureDatabase::get_optical_model(
   int nucleus_pid)
 {
   /// @todo add check for invalid nucleus particle ID value
+  std::lock_guard<std::mutex> lock( models_mutex_ );
   auto iter = optical_model_table_.find(nucleus_pid);
 
   if (iter == optical_model_table_.end()) {
-    // The requested level density model wasn't found, so create it and add it
-    // to the table, returning a reference to the stored level density model
+    // The requested optical model wasn't found, so create it and add it
+    // to the table, returning a reference to the stored optical model
     // afterwards.
     int Z = marley_utils::get_particle_Z(nucleus_pid);
     int A = marley_utils::get_particle_A(nucleus_pid);
+    std::unique_ptr<marley::OpticalModel> om
+      = std::make_unique<marley::KoningDelarocheOpticalModel>( Z, A,
+      numerov_step_size_ );
+    if ( table_builder_ ) {
+      om = std::make_unique<marley::TabulatedOpticalModel>( std::move(om),
+        *table_builder_, fragment_l_max_, table_E_max_, table_tolerance_ );
+    }
     return *(optical_model_table_.emplace(nucleus_pid,
-      std::make_unique<marley::KoningDelarocheOpticalModel>(Z, A)).first
-      ->second.get());
+      std::move(om)).first->second.get());
   }
   else return *(iter->second.get());
 }
 
-marley::OpticalModel& marley::StructureDatabase::get_optical_model(
+void marley::StructureDatabase::enable_transmission_tables(
+  double tolerance, double E_max, int num_threads)
+{
+  if ( !(tolerance > 0.) ) throw marley::Error( "Invalid transmission"
+    " coefficient table tolerance " + std::to_string(tolerance) );
+
+  if ( !(E_max > 0.) ) throw marley::Error( "Invalid transmission"
+    " coefficient table maximum energy " + std::to_string(E_max) );
+
+  // Optical models that were already created keep a reference to the
+  // existing TableBuilder, so it may not be replaced
+  std::lock_guard<std::mutex> lock( models_mutex_ );
+  if ( table_builder_ ) throw marley::Error( "Transmission coefficient"
+    " tables have already been enabled for this structure database" );
+
+  table_tolerance_ = tolerance;
+  table_E_max_ = E_max;
+  table_builder_ = std::make_unique<marley::TableBuilder>( num_threads );
+}
+
+const marley::OpticalModel& marley::StructureDatabase::get_optical_model(
   const int Z, const int A)
 {
   int nucleus_pid = marley_utils::get_nucleus_pid(Z, A);
-  auto iter = optical_model_table_.find(nucleus_pid);
-
-  if (iter == optical_model_table_.end()) {
-    // The requested level density model wasn't found, so create it and add it
-    // to the table, returning a reference to the stored level density model
-    // afterwards.
-    return *(optical_model_table_.emplace(nucleus_pid,
-      std::make_unique<marley::KoningDelarocheOpticalModel>(Z, A)).first
-      ->second.get());
-  }
-  else return *(iter->second.get());
+  return this->get_optical_model( nucleus_pid );
 }
 
-marley::LevelDensityModel& marley::StructureDatabase::get_level_density_model(
-  int nucleus_pid)
+const marley::LevelDensityModel&
+  marley::StructureDatabase::get_level_density_model(int nucleus_pid)
 {
+  std::lock_guard<std::mutex> lock( models_mutex_ );
   auto iter = level_density_table_.find(nucleus_pid);
 
   if (iter == level_density_table_.end()) {
@@ -243,14 +307,29 @@ marley::LevelDensityModel& marley::StructureDatabase::get_level_density_model(
   else return *(iter->second.get());
 }
 
-marley::LevelDensityModel& marley::StructureDatabase::get_level_density_model(
-  const int Z, const int A)
+void marley::StructureDatabase::add_level_density_model(int nucleus_pid,
+  std::unique_ptr<marley::LevelDensityModel> ldm)
+{
+  std::lock_guard<std::mutex> lock( models_mutex_ );
+
+  // References to existing models may already have been handed out, so
+  // refuse to replace them
+  bool added = level_density_table_.emplace( nucleus_pid,
+    std::move(ldm) ).second;
+
+  if ( !added ) throw marley::Error( "A level density model for the nuclide"
+    " with PDG code " + std::to_string(nucleus_pid) + " has already been"
+    " loaded" );
+}
+
+const marley::LevelDensityModel&
+  marley::StructureDatabase::get_level_density_model(const int Z, const int A)
 {
   int pid = marley_utils::get_nucleus_pid(Z, A);
   return this->get_level_density_model( pid );
 }
 
-marley::GammaStrengthFunctionModel&
+const marley::GammaStrengthFunctionModel&
   marley::StructureDatabase::get_gamma_strength_function_model(
   const int nuc_pdg)
 {
@@ -259,12 +338,13 @@ marley::GammaStrengthFunctionModel&
   return this->get_gamma_strength_function_model( Z, A );
 }
 
-marley::GammaStrengthFunctionModel&
+const marley::GammaStrengthFunctionModel&
   marley::StructureDatabase::get_gamma_strength_function_model(const int Z,
   const int A)
 {
   int pid = marley_utils::get_nucleus_pid(Z, A);
 
+  std::lock_guard<std::mutex> lock( models_mutex_ );
   auto iter = gamma_strength_function_table_.find(pid);
 
   if (iter == gamma_strength_function_table_.end()) {
@@ -329,6 +409,8 @@ void marley::StructureDatabase::get_gs_spin_parity(int nuc_pdg,
 
 void marley::StructureDatabase::initialize_jpi_table() {
 
+  marley::StartupProfile::Phase phase( "Load ground-state spin-parities" );
+
   // Instantiate the file manager and use it to find
   // the data file containing the ground-state spin-parities
   // for many nuclei
@@ -386,6 +468,8 @@ void marley::StructureDatabase::initialize_jpi_table() {
 
 void marley::StructureDatabase::load_structure_index() {
 
+  marley::StartupProfile::Phase phase( "Load structure data index" );
+
   // Instantiate the file manager and use it to find
   // the index to the decay scheme data files
   const auto& fm = marley::FileManager::Instance();
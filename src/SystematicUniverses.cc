@@ -0,0 +1,395 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <random>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/ExitChannel.hh"
+#include "marley/HauserFeshbachDecay.hh"
+#include "marley/JSON.hh"
+#include "marley/SystematicUniverses.hh"
+#include "marley/marley_utils.hh"
+
+using CMode = marley::NuclearReaction::CoulombMode;
+using ME_Type = marley::MatrixElement::TransitionType;
+using ProcType = marley::Reaction::ProcessType;
+
+constexpr size_t marley::SystematicUniverses::NUM_EMITTED_;
+constexpr size_t marley::SystematicUniverses::NUM_CLASSES_;
+
+namespace {
+
+  // Keys used in the "width_scales" object for each emitted particle (in the
+  // same order as SystematicUniverses::emitted_pdgs())
+  const std::array<std::string, marley::SystematicUniverses::NUM_EMITTED_>
+    emitted_names = { "gamma", "n", "p", "d", "t", "he3", "alpha" };
+
+  // Number of CoulombMode values
+  constexpr size_t NUM_COULOMB_MODES = 6u;
+
+  // Seed used for random universes if none is given
+  constexpr uint_fast64_t DEFAULT_THROW_SEED = 1u;
+
+  double get_scale( const marley::JSON& json, const std::string& key,
+    const std::string& name )
+  {
+    bool ok = false;
+    double scale = json.at( key ).to_double( ok );
+    if ( !ok || !std::isfinite(scale) || scale < 0. ) throw marley::Error(
+      "Invalid value " + json.at(key).dump_string() + " given for the \""
+      + key + "\" key in the systematic universe \"" + name + "\". A"
+      " nonnegative number is required.");
+    return scale;
+  }
+
+  double get_slope( const marley::JSON& json, const std::string& key,
+    const std::string& name )
+  {
+    bool ok = false;
+    double slope = json.at( key ).to_double( ok );
+    if ( !ok || !std::isfinite(slope) ) throw marley::Error(
+      "Invalid value " + json.at(key).dump_string() + " given for the \""
+      + key + "\" key in the systematic universe \"" + name + "\". A"
+      " number is required.");
+    return slope;
+  }
+
+  size_t emitted_index( const std::string& key, const std::string& name ) {
+    for ( size_t i = 0u; i < emitted_names.size(); ++i ) {
+      if ( emitted_names[i] == key ) return i;
+    }
+    throw marley::Error("Unrecognized particle \"" + key + "\" given in the"
+      " \"width_scales\" object for the systematic universe \"" + name
+      + "\". Allowed values are \"gamma\", \"n\", \"p\", \"d\", \"t\","
+      " \"he3\", and \"alpha\".");
+  }
+
+}
+
+marley::SystematicUniverses::SystematicUniverses( const marley::JSON& json )
+{
+  if ( !json.is_array() ) throw marley::Error("The systematic universes"
+    " must be given as a JSON array");
+
+  for ( const auto& el : json.array_range() ) {
+    if ( !el.is_object() ) throw marley::Error("Invalid systematic universe "
+      + el.dump_string() + ". Each element of the \"universes\" array must"
+      " be a JSON object.");
+
+    if ( el.has_key("throws") ) this->add_throws( el );
+    else this->add_universe( el, universes_.size() );
+  }
+
+  // The names are written to the headers of some output formats, so they
+  // must be unique and may not contain whitespace
+  for ( size_t u = 0u; u < universes_.size(); ++u ) {
+    const std::string& name = universes_.at( u ).name;
+    bool bad = name.empty() || std::any_of( name.cbegin(), name.cend(),
+      [](char c) { return std::isspace( static_cast<unsigned char>(c) ); } );
+    if ( bad ) throw marley::Error("Invalid systematic universe name \""
+      + name + "\". Names must be nonempty and may not contain whitespace.");
+
+    for ( size_t v = 0u; v < u; ++v ) {
+      if ( universes_.at(v).name == name ) throw marley::Error("The"
+        " systematic universe name \"" + name + "\" was used more than"
+        " once");
+    }
+  }
+
+  // Precompute the overall width scale factor for each exit channel class
+  channel_scales_.reserve( NUM_CLASSES_ * universes_.size() );
+  for ( const auto& u : universes_ ) {
+    for ( size_t i = 0u; i < NUM_EMITTED_; ++i ) {
+      // Discrete level, then continuum (see channel_class())
+      channel_scales_.push_back( u.width_scales[i] );
+      channel_scales_.push_back( u.width_scales[i] * u.continuum_scale );
+    }
+    slopes_.push_back( u.level_density_slope );
+    if ( u.level_density_slope != 0. ) has_slopes_ = true;
+  }
+}
+
+void marley::SystematicUniverses::add_universe( const marley::JSON& json,
+  size_t index )
+{
+  Universe u;
+  u.name = "universe_" + std::to_string( index );
+  if ( json.has_key("name") ) u.name = json.at( "name" ).to_string();
+
+  if ( json.has_key("gt_scale") ) {
+    u.gt_scale = get_scale( json, "gt_scale", u.name );
+  }
+  if ( json.has_key("fermi_scale") ) {
+    u.fermi_scale = get_scale( json, "fermi_scale", u.name );
+  }
+  if ( json.has_key("continuum_scale") ) {
+    u.continuum_scale = get_scale( json, "continuum_scale", u.name );
+  }
+  if ( json.has_key("level_density_slope") ) {
+    u.level_density_slope = get_slope( json, "level_density_slope", u.name );
+  }
+
+  if ( json.has_key("coulomb_mode") ) {
+    u.has_coulomb_mode = true;
+    u.coulomb_mode = marley::NuclearReaction::coulomb_mode_from_string(
+      json.at("coulomb_mode").to_string() );
+  }
+
+  if ( json.has_key("width_scales") ) {
+    const auto& ws = json.at( "width_scales" );
+    if ( !ws.is_object() ) throw marley::Error("The \"width_scales\" key"
+      " for the systematic universe \"" + u.name + "\" must have a JSON"
+      " object as its value");
+    for ( const auto& pair : ws.object_range() ) {
+      u.width_scales[ emitted_index(pair.first, u.name) ]
+        = get_scale( ws, pair.first, u.name );
+    }
+  }
+
+  universes_.push_back( u );
+}
+
+void marley::SystematicUniverses::add_throws( const marley::JSON& json )
+{
+  std::string name = "random";
+  if ( json.has_key("name") ) name = json.at( "name" ).to_string();
+
+  bool ok = false;
+  long num_throws = json.at( "throws" ).to_long( ok );
+  if ( !ok || num_throws < 1 ) throw marley::Error("Invalid number of"
+    " throws " + json.at("throws").dump_string() + " given for the"
+    " systematic universes \"" + name + "\"");
+
+  uint_fast64_t seed = DEFAULT_THROW_SEED;
+  if ( json.has_key("seed") ) {
+    seed = static_cast<uint_fast64_t>( json.at("seed").to_long(ok) );
+    if ( !ok ) throw marley::Error("Invalid seed "
+      + json.at("seed").dump_string() + " given for the systematic"
+      " universes \"" + name + "\"");
+  }
+
+  // Each scale factor is drawn from a normal distribution centered on one,
+  // and the level density slope from one centered on zero. A standard
+  // deviation of zero (the default) keeps the nominal value.
+  double sigma_gt = 0.;
+  double sigma_fermi = 0.;
+  double sigma_continuum = 0.;
+  double sigma_slope = 0.;
+  std::array<double, NUM_EMITTED_> sigma_widths;
+  sigma_widths.fill( 0. );
+
+  if ( json.has_key("sigma") ) {
+    const auto& sigma = json.at( "sigma" );
+    if ( !sigma.is_object() ) throw marley::Error("The \"sigma\" key for"
+      " the systematic universes \"" + name + "\" must have a JSON object"
+      " as its value");
+
+    if ( sigma.has_key("gt_scale") ) {
+      sigma_gt = get_scale( sigma, "gt_scale", name );
+    }
+    if ( sigma.has_key("fermi_scale") ) {
+      sigma_fermi = get_scale( sigma, "fermi_scale", name );
+    }
+    if ( sigma.has_key("continuum_scale") ) {
+      sigma_continuum = get_scale( sigma, "continuum_scale", name );
+    }
+    if ( sigma.has_key("level_density_slope") ) {
+      sigma_slope = get_scale( sigma, "level_density_slope", name );
+    }
+    if ( sigma.has_key("width_scales") ) {
+      const auto& ws = sigma.at( "width_scales" );
+      if ( !ws.is_object() ) throw marley::Error("The \"width_scales\" key"
+        " for the systematic universes \"" + name + "\" must have a JSON"
+        " object as its value");
+      for ( const auto& pair : ws.object_range() ) {
+        sigma_widths[ emitted_index(pair.first, name) ]
+          = get_scale( ws, pair.first, name );
+      }
+    }
+  }
+
+  // Negative scale factors are unphysical, so clamp them to zero
+  std::mt19937_64 rng( seed );
+  std::normal_distribution<double> gaus( 0., 1. );
+  auto draw = [&rng, &gaus]( double sigma ) -> double {
+    return std::max( 0., 1. + sigma * gaus(rng) );
+  };
+
+  for ( long t = 0; t < num_throws; ++t ) {
+    Universe u;
+    u.name = name + '_' + std::to_string( t );
+
+    // Always draw every parameter in the same order so that each throw
+    // depends only on the seed and its index
+    u.gt_scale = draw( sigma_gt );
+    u.fermi_scale = draw( sigma_fermi );
+    for ( size_t i = 0u; i < NUM_EMITTED_; ++i ) {
+      u.width_scales[i] = draw( sigma_widths[i] );
+    }
+    u.continuum_scale = draw( sigma_continuum );
+    u.level_density_slope = sigma_slope * gaus( rng );
+
+    if ( json.has_key("coulomb_mode") ) {
+      u.has_coulomb_mode = true;
+      u.coulomb_mode = marley::NuclearReaction::coulomb_mode_from_string(
+        json.at("coulomb_mode").to_string() );
+    }
+
+    universes_.push_back( u );
+  }
+}
+
+std::vector<std::string> marley::SystematicUniverses::names() const {
+  std::vector<std::string> result;
+  for ( const auto& u : universes_ ) result.push_back( u.name );
+  return result;
+}
+
+const std::array<int, marley::SystematicUniverses::NUM_EMITTED_>&
+  marley::SystematicUniverses::emitted_pdgs()
+{
+  static const std::array<int, NUM_EMITTED_> pdgs = { marley_utils::PHOTON,
+    marley_utils::NEUTRON, marley_utils::PROTON, marley_utils::DEUTERON,
+    marley_utils::TRITON, marley_utils::HELION, marley_utils::ALPHA };
+  return pdgs;
+}
+
+size_t marley::SystematicUniverses::channel_class(
+  const marley::ExitChannel& ec )
+{
+  const auto& pdgs = emitted_pdgs();
+  int pdg = ec.emitted_particle_pdg();
+  for ( size_t i = 0u; i < NUM_EMITTED_; ++i ) {
+    if ( pdgs[i] == pdg ) return 2u*i + ( ec.is_continuum() ? 1u : 0u );
+  }
+  throw marley::Error("Unrecognized emitted particle PDG code "
+    + std::to_string(pdg) + " encountered in marley::SystematicUniverses::"
+    "channel_class()");
+}
+
+void marley::SystematicUniverses::weight_transition(
+  const marley::NuclearReaction& nr, const marley::MatrixElement& me,
+  double beta_rel_cd, std::vector<double>& weights ) const
+{
+  if ( weights.size() != universes_.size() ) throw marley::Error("Weight"
+    " vector size mismatch encountered in marley::SystematicUniverses::"
+    "weight_transition()");
+
+  ProcType pt = nr.process_type();
+  bool cc = ( pt == ProcType::NeutrinoCC || pt == ProcType::AntiNeutrinoCC );
+
+  // Coulomb correction factors depend only on the mode, so compute each
+  // one at most once and share it between universes. A negative entry
+  // marks a factor that has not been computed yet.
+  std::array<double, NUM_COULOMB_MODES> factors;
+  factors.fill( -1. );
+  auto coulomb_factor = [&]( CMode mode ) -> double {
+    double& factor = factors.at( static_cast<size_t>(mode) );
+    if ( factor < 0. ) {
+      // The pure (M)EMA correction is undefined when the Coulomb potential
+      // pulls the event below threshold. The transition is then forbidden
+      // in a universe that uses it.
+      try { factor = nr.coulomb_correction_factor( beta_rel_cd, mode ); }
+      catch ( const marley::Error& ) { factor = 0.; }
+    }
+    return factor;
+  };
+
+  double nominal_factor = cc ? coulomb_factor( nr.coulomb_mode() ) : 1.;
+  bool fermi = ( me.type() == ME_Type::FERMI );
+
+  for ( size_t u = 0u; u < universes_.size(); ++u ) {
+    const Universe& uni = universes_[u];
+    double ratio = fermi ? uni.fermi_scale : uni.gt_scale;
+    if ( cc && uni.has_coulomb_mode && nominal_factor > 0. ) {
+      ratio *= coulomb_factor( uni.coulomb_mode ) / nominal_factor;
+    }
+    weights[u] *= ratio;
+  }
+}
+
+void marley::SystematicUniverses::weight_decay(
+  const marley::HauserFeshbachDecay& hfd, const marley::ExitChannel& chosen,
+  double Exf, std::vector<double>& weights ) const
+{
+  if ( weights.size() != universes_.size() ) throw marley::Error("Weight"
+    " vector size mismatch encountered in marley::SystematicUniverses::"
+    "weight_decay()");
+
+  // Sum the partial widths within each exit channel class once. Every
+  // universe scales all of the channels in a class by the same factor, so
+  // these sums are all that is needed to renormalize the branching ratios.
+  std::array<double, NUM_CLASSES_> class_widths;
+  class_widths.fill( 0. );
+
+  // Universes with a nonzero level density slope also reshape the spectrum
+  // of each continuum channel, so they need their own sums (stored
+  // universe by universe)
+  std::vector<double> slope_class_widths;
+  std::vector<double> tilted;
+  if ( has_slopes_ ) slope_class_widths.assign( NUM_CLASSES_
+    * universes_.size(), 0. );
+
+  for ( const auto& ec : hfd.exit_channels() ) {
+    size_t c = channel_class( *ec );
+    class_widths[ c ] += ec->width();
+    if ( !has_slopes_ ) continue;
+
+    const auto* cec = dynamic_cast<const marley::ContinuumExitChannel*>(
+      ec.get() );
+    if ( cec ) cec->tilted_widths( slopes_, tilted );
+    else tilted.assign( universes_.size(), ec->width() );
+    for ( size_t u = 0u; u < universes_.size(); ++u ) {
+      slope_class_widths[ u*NUM_CLASSES_ + c ] += tilted[ u ];
+    }
+  }
+
+  // Add up the total width in the same order as below so that a universe
+  // with nominal widths gets a weight of exactly one
+  double total_width = 0.;
+  for ( double width : class_widths ) total_width += width;
+
+  size_t chosen_class = channel_class( chosen );
+
+  // Offset of the sampled excitation energy from the onset of the continuum
+  double dEx = 0.;
+  const auto* chosen_cec = dynamic_cast<const marley::ContinuumExitChannel*>(
+    &chosen );
+  if ( chosen_cec ) dEx = Exf - chosen_cec->E_c_min();
+
+  for ( size_t u = 0u; u < universes_.size(); ++u ) {
+    const double* scales = channel_scales_.data() + u*NUM_CLASSES_;
+    const double* widths = class_widths.data();
+    double ratio = scales[ chosen_class ];
+    if ( slopes_[u] != 0. ) {
+      widths = slope_class_widths.data() + u*NUM_CLASSES_;
+      if ( chosen_cec ) ratio *= std::exp( slopes_[u] * dEx );
+    }
+
+    double scaled_total = 0.;
+    for ( size_t c = 0u; c < NUM_CLASSES_; ++c ) {
+      scaled_total += scales[c] * widths[c];
+    }
+    if ( scaled_total > 0. ) weights[u] *= ratio * total_width / scaled_total;
+    else weights[u] = 0.;
+  }
+}
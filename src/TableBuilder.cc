@@ -0,0 +1,99 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// POSIX includes
+#include "pthread.h"
+#include "sched.h"
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/TableBuilder.hh"
+
+marley::TableBuilder::TableBuilder( int num_threads ) : stop_( false ),
+  num_submitted_( 0u ), num_built_( 0u ), num_failed_( 0u )
+{
+  if ( num_threads < 1 ) throw marley::Error( "Invalid number of table"
+    " builder threads " + std::to_string(num_threads) + " requested" );
+
+  for ( int t = 0; t < num_threads; ++t ) {
+    threads_.emplace_back( [this]() { this->run_worker(); } );
+  }
+}
+
+marley::TableBuilder::~TableBuilder() {
+  {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    stop_ = true;
+    jobs_.clear();
+  }
+  job_cv_.notify_all();
+  for ( auto& thread : threads_ ) thread.join();
+}
+
+void marley::TableBuilder::submit( Job job ) {
+  {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    jobs_.push_back( std::move(job) );
+    ++num_submitted_;
+  }
+  job_cv_.notify_one();
+}
+
+void marley::TableBuilder::wait() {
+  std::unique_lock<std::mutex> lock( mutex_ );
+  done_cv_.wait( lock, [this]() {
+    return num_built_ + num_failed_ == num_submitted_;
+  } );
+}
+
+void marley::TableBuilder::run_worker() {
+
+  // Only use CPU time that would otherwise be idle. If the scheduling policy
+  // can't be changed, just run the jobs at normal priority.
+#ifdef SCHED_IDLE
+  sched_param param;
+  param.sched_priority = 0;
+  pthread_setschedparam( pthread_self(), SCHED_IDLE, &param );
+#endif
+
+  while ( true ) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock( mutex_ );
+      job_cv_.wait( lock, [this]() { return stop_ || !jobs_.empty(); } );
+      if ( stop_ ) return;
+      job = std::move( jobs_.front() );
+      jobs_.pop_front();
+    }
+
+    // A job that throws simply leaves the direct calculation in use
+    bool built = false;
+    try {
+      built = job();
+    }
+    catch ( ... ) {
+      built = false;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock( mutex_ );
+      if ( built ) ++num_built_;
+      else ++num_failed_;
+    }
+    done_cv_.notify_all();
+  }
+}
@@ -0,0 +1,310 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <regex>
+#include <sstream>
+
+#include "marley/Error.hh"
+#include "marley/TabulatedLevelDensityModel.hh"
+
+namespace {
+
+  // Contents of one block of a level density table file
+  struct TableBlock {
+    // +1 or -1 for a single parity, 0 for a parity-summed block
+    int parity = 0;
+    std::vector<double> Us; // excitation energies (MeV)
+    std::vector<double> totals; // RHOOBS column (MeV^(-1))
+    std::vector< std::vector<double> > rhos; // spin columns (MeV^(-1))
+  };
+
+}
+
+marley::TabulatedLevelDensityModel::TabulatedLevelDensityModel(
+  const std::string& file_name, int Z, int A) : Z_(Z), A_(A),
+  fallback_(Z, A)
+{
+  std::ifstream file_in( file_name );
+  if ( !file_in.good() ) throw marley::Error( "Could not read from the level"
+    " density table file " + file_name );
+
+  // Each block of the file begins with a line like
+  // " Z=  18 A=  40: Positive-Parity"
+  static const std::regex rx_header( "Z=\\s*([0-9]+)\\s+A=\\s*([0-9]+)" );
+
+  std::vector<TableBlock> blocks;
+  TableBlock* current = nullptr;
+
+  std::string line;
+  std::smatch match;
+  while ( std::getline(file_in, line) ) {
+
+    if ( std::regex_search(line, match, rx_header) ) {
+      // Skip blocks that belong to other nuclides
+      current = nullptr;
+      if ( std::stoi(match[1]) != Z_ || std::stoi(match[2]) != A_ ) continue;
+
+      blocks.emplace_back();
+      current = &blocks.back();
+      if ( line.find("Positive") != std::string::npos ) current->parity = 1;
+      else if ( line.find("Negative") != std::string::npos ) {
+        current->parity = -1;
+      }
+      continue;
+    }
+
+    if ( !current ) continue;
+
+    // Rows of the table contain only numbers. Skip anything else (column
+    // headings, separators, etc.)
+    std::istringstream iss( line );
+    std::vector<double> values;
+    double value;
+    while ( iss >> value ) values.push_back( value );
+    if ( !iss.eof() || values.empty() ) continue;
+
+    // U, T, NCUMUL, RHOOBS, RHOTOT, and at least one spin column
+    if ( values.size() < 6u ) throw marley::Error( "Too few columns in the"
+      " row \"" + line + "\" of the level density table file " + file_name );
+
+    current->Us.push_back( values.front() );
+    current->totals.push_back( values.at(3) );
+    current->rhos.emplace_back( values.cbegin() + 5, values.cend() );
+  }
+
+  const TableBlock* positive = nullptr;
+  const TableBlock* negative = nullptr;
+  const TableBlock* summed = nullptr;
+  for ( const auto& b : blocks ) {
+    if ( b.Us.empty() ) continue;
+    if ( b.parity > 0 ) positive = &b;
+    else if ( b.parity < 0 ) negative = &b;
+    else summed = &b;
+  }
+
+  std::string nuc_description = "Z = " + std::to_string( Z_ ) + ", A = "
+    + std::to_string( A_ );
+
+  if ( !(positive && negative) && !summed ) throw marley::Error( "Could not"
+    " find a complete level density table for the nuclide with "
+    + nuc_description + " in the file " + file_name );
+
+  // Prefer the parity-dependent tables when both kinds are present
+  if ( positive && negative ) {
+    if ( positive->Us != negative->Us ) throw marley::Error( "Mismatched"
+      " excitation energies in the positive- and negative-parity level"
+      " density tables for " + nuc_description + " in the file "
+      + file_name );
+  }
+  else {
+    positive = summed;
+    negative = summed;
+  }
+
+  const std::vector<double>& Us = positive->Us;
+  size_t num_rows = Us.size();
+  if ( num_rows < 2u ) throw marley::Error( "At least two excitation energies"
+    " are needed in the level density table for " + nuc_description
+    + " in the file " + file_name );
+
+  num_spins_ = 0;
+  for ( size_t r = 0u; r < num_rows; ++r ) {
+    num_spins_ = std::max( num_spins_, static_cast<int>(
+      positive->rhos.at(r).size()) );
+    num_spins_ = std::max( num_spins_, static_cast<int>(
+      negative->rhos.at(r).size()) );
+  }
+  stride_ = 1u + 2u*static_cast<size_t>( num_spins_ );
+
+  // Logarithms of the level densities at the original energies, using the
+  // same layout as the resampled table. Spins missing from a row are
+  // treated as having a vanishing level density.
+  constexpr double LOG_ZERO = -std::numeric_limits<double>::infinity();
+  double parity_factor = ( summed == positive ) ? 0.5 : 1.;
+
+  std::vector<double> ln_rows( num_rows * stride_, LOG_ZERO );
+  double min_spacing = std::numeric_limits<double>::max();
+  for ( size_t r = 0u; r < num_rows; ++r ) {
+
+    if ( r > 0u ) {
+      double spacing = Us.at( r ) - Us.at( r - 1 );
+      if ( !(spacing > 0.) ) throw marley::Error( "Excitation energies in the"
+        " level density table for " + nuc_description + " in the file "
+        + file_name + " are not strictly increasing" );
+      if ( spacing < min_spacing ) min_spacing = spacing;
+    }
+
+    double* row = ln_rows.data() + r*stride_;
+
+    // The parity-dependent RHOOBS columns each cover a single parity
+    double total = positive->totals.at( r );
+    if ( summed != positive ) total += negative->totals.at( r );
+    if ( !std::isfinite(total) || total < 0. ) throw marley::Error( "Invalid"
+      " total level density in the table for " + nuc_description
+      + " in the file " + file_name );
+    row[ 0 ] = std::log( total );
+
+    for ( size_t p = 0u; p < 2u; ++p ) {
+      const auto& rhos = ( p == 0u ? positive : negative )->rhos.at( r );
+      for ( size_t k = 0u; k < rhos.size(); ++k ) {
+        double rho = parity_factor * rhos.at( k );
+        if ( !std::isfinite(rho) || rho < 0. ) throw marley::Error( "Invalid"
+          " level density in the table for " + nuc_description
+          + " in the file " + file_name );
+        row[ 1u + p*num_spins_ + k ] = std::log( rho );
+      }
+    }
+  }
+
+  // Resample the table onto a uniform grid
+  Ex_min_ = Us.front();
+  Ex_max_ = Us.back();
+  double range = Ex_max_ - Ex_min_;
+  num_nodes_ = static_cast<size_t>( std::lround(range / min_spacing) ) + 1u;
+  if ( num_nodes_ > MAX_NODES ) num_nodes_ = MAX_NODES;
+  double dEx = range / ( num_nodes_ - 1u );
+  inv_dEx_ = 1. / dEx;
+
+  ln_rhos_.resize( num_nodes_ * stride_ );
+  size_t r = 0u;
+  for ( size_t n = 0u; n < num_nodes_; ++n ) {
+    double Ex = ( n + 1u == num_nodes_ ) ? Ex_max_ : Ex_min_ + n*dEx;
+    while ( r + 2u < num_rows && Us.at(r + 1) <= Ex ) ++r;
+
+    const double* lower = ln_rows.data() + r*stride_;
+    const double* upper = lower + stride_;
+    double* node = ln_rhos_.data() + n*stride_;
+
+    double t = ( Ex - Us.at(r) ) / ( Us.at(r + 1) - Us.at(r) );
+    for ( size_t c = 0u; c < stride_; ++c ) {
+      if ( t == 0. ) node[ c ] = lower[ c ];
+      else if ( t == 1. ) node[ c ] = upper[ c ];
+      else node[ c ] = std::log( interpolate(lower[c], upper[c], t) );
+    }
+  }
+}
+
+double marley::TabulatedLevelDensityModel::interpolate(double ln_rho_0,
+  double ln_rho_1, double t)
+{
+  if ( std::isinf(ln_rho_0) || std::isinf(ln_rho_1) ) {
+    return (1. - t)*std::exp( ln_rho_0 ) + t*std::exp( ln_rho_1 );
+  }
+  return std::exp( ln_rho_0 + t*(ln_rho_1 - ln_rho_0) );
+}
+
+bool marley::TabulatedLevelDensityModel::locate(double Ex, size_t& i,
+  double& t) const
+{
+  if ( !(Ex >= Ex_min_ && Ex <= Ex_max_) ) return false;
+
+  double x = ( Ex - Ex_min_ ) * inv_dEx_;
+  i = static_cast<size_t>( x );
+  if ( i + 1u >= num_nodes_ ) i = num_nodes_ - 2u;
+  t = x - i;
+  return true;
+}
+
+int marley::TabulatedLevelDensityModel::spin_column(int two_J,
+  marley::Parity Pi) const
+{
+  // Odd-A nuclides have half-integer spins
+  int two_J_offset = A_ % 2;
+  int diff = two_J - two_J_offset;
+  if ( diff < 0 || diff % 2 != 0 ) return -1;
+
+  int k = diff / 2;
+  if ( k >= num_spins_ ) return -1;
+
+  return 1 + k + ( Pi == marley::Parity(true) ? 0 : num_spins_ );
+}
+
+double marley::TabulatedLevelDensityModel::untabulated_level_density(
+  double Ex, int two_J, marley::Parity Pi) const
+{
+  // Odd-A nuclides have half-integer spins, and even-A nuclides have
+  // integer ones
+  if ( two_J < 0 || (two_J + A_) % 2 != 0 ) return 0.;
+  return fallback_.level_density( Ex, two_J, Pi );
+}
+
+double marley::TabulatedLevelDensityModel::level_density(double Ex) const
+{
+  size_t i;
+  double t;
+  if ( !locate(Ex, i, t) ) return fallback_.level_density( Ex );
+
+  const double* lower = ln_rhos_.data() + i*stride_;
+  return interpolate( lower[0], lower[stride_], t );
+}
+
+double marley::TabulatedLevelDensityModel::level_density(double Ex,
+  int two_J) const
+{
+  size_t i;
+  double t;
+  if ( !locate(Ex, i, t) ) return fallback_.level_density( Ex, two_J );
+
+  const double* lower = ln_rhos_.data() + i*stride_;
+  double rho = 0.;
+  for ( bool positive : { true, false } ) {
+    marley::Parity Pi( positive );
+    int c = spin_column( two_J, Pi );
+    if ( c >= 0 ) rho += interpolate( lower[c], lower[stride_ + c], t );
+    else rho += untabulated_level_density( Ex, two_J, Pi );
+  }
+  return rho;
+}
+
+double marley::TabulatedLevelDensityModel::level_density(double Ex,
+  int two_J, marley::Parity Pi) const
+{
+  size_t i;
+  double t;
+  if ( !locate(Ex, i, t) ) return fallback_.level_density( Ex, two_J, Pi );
+
+  // Callers may divide by this level density, so spins beyond the table
+  // should not be given a vanishing one
+  int c = spin_column( two_J, Pi );
+  if ( c < 0 ) return untabulated_level_density( Ex, two_J, Pi );
+
+  const double* lower = ln_rhos_.data() + i*stride_;
+  return interpolate( lower[c], lower[stride_ + c], t );
+}
+
+void marley::TabulatedLevelDensityModel::level_densities(double Ex,
+  int two_J_min, size_t num_spins, marley::Parity Pi, double* rhos) const
+{
+  size_t i;
+  double t;
+  if ( !locate(Ex, i, t) ) {
+    fallback_.level_densities( Ex, two_J_min, num_spins, Pi, rhos );
+    return;
+  }
+
+  const double* lower = ln_rhos_.data() + i*stride_;
+  for ( size_t k = 0u; k < num_spins; ++k ) {
+    int two_J = two_J_min + 2*static_cast<int>( k );
+    int c = spin_column( two_J, Pi );
+    rhos[ k ] = ( c < 0 ) ? untabulated_level_density( Ex, two_J, Pi )
+      : interpolate( lower[c], lower[stride_ + c], t );
+  }
+}
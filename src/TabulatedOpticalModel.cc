@@ -0,0 +1,293 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#include "marley/Error.hh"
+#include "marley/Fragment.hh"
+#include "marley/StructureDatabase.hh"
+#include "marley/TableBuilder.hh"
+#include "marley/TabulatedOpticalModel.hh"
+
+constexpr size_t marley::TabulatedOpticalModel::INITIAL_CELLS;
+constexpr size_t marley::TabulatedOpticalModel::MAX_CELLS;
+constexpr double marley::TabulatedOpticalModel::MIN_ENERGY;
+constexpr double marley::TabulatedOpticalModel::MIN_RELEVANT_T;
+
+namespace {
+
+  // Interpolates logarithmically between two transmission coefficients,
+  // falling back to linear interpolation when either one vanishes
+  inline double interpolate( double ln_T_0, double ln_T_1, double t ) {
+    if ( std::isinf(ln_T_0) || std::isinf(ln_T_1) ) {
+      return (1. - t)*std::exp( ln_T_0 ) + t*std::exp( ln_T_1 );
+    }
+    return std::exp( ln_T_0 + t*(ln_T_1 - ln_T_0) );
+  }
+
+}
+
+marley::TabulatedOpticalModel::TabulatedOpticalModel(
+  std::unique_ptr<marley::OpticalModel> direct, marley::TableBuilder& builder,
+  int l_max, double E_max, double tolerance )
+  : OpticalModel( direct->Z(), direct->A() ), direct_( std::move(direct) ),
+  builder_( builder ), l_max_( l_max ), E_max_( E_max ),
+  tolerance_( tolerance )
+{
+  if ( l_max_ < 0 ) throw marley::Error( "Negative maximum orbital angular"
+    " momentum passed to the constructor of marley::TabulatedOpticalModel" );
+
+  if ( !(E_max_ > MIN_ENERGY) ) throw marley::Error( "Invalid maximum energy"
+    " passed to the constructor of marley::TabulatedOpticalModel" );
+
+  if ( !(tolerance_ > 0.) ) throw marley::Error( "Nonpositive tolerance"
+    " passed to the constructor of marley::TabulatedOpticalModel" );
+
+  for ( const auto& pair : marley::StructureDatabase::fragments() ) {
+    entries_.emplace_back( std::make_unique<Entry>() );
+    entries_.back()->fragment_pdg = pair.first;
+    entries_.back()->two_s = pair.second.get_two_s();
+  }
+}
+
+std::complex<double> marley::TabulatedOpticalModel::optical_model_potential(
+  double r, double fragment_KE_lab, int fragment_pdg, int two_j, int l,
+  int two_s, int target_charge, Workspace& ws) const
+{
+  return direct_->optical_model_potential( r, fragment_KE_lab, fragment_pdg,
+    two_j, l, two_s, target_charge, ws );
+}
+
+double marley::TabulatedOpticalModel::total_cross_section(
+  double fragment_KE_lab, int fragment_pdg, int two_s, size_t l_max,
+  int target_charge, Workspace& ws) const
+{
+  return direct_->total_cross_section( fragment_KE_lab, fragment_pdg, two_s,
+    l_max, target_charge, ws );
+}
+
+const marley::TabulatedOpticalModel::Table*
+  marley::TabulatedOpticalModel::find_table( int fragment_pdg, int two_s,
+  int target_charge ) const
+{
+  if ( target_charge != 0 ) return nullptr;
+
+  for ( const auto& entry : entries_ ) {
+    if ( entry->fragment_pdg != fragment_pdg ) continue;
+    if ( entry->two_s != two_s ) return nullptr;
+
+    const Table* table = entry->published.load( std::memory_order_acquire );
+    if ( table ) return table;
+
+    // Ask for the table to be built the first time that it is needed
+    if ( !entry->requested.exchange(true) ) {
+      Entry* e = entry.get();
+      builder_.submit( [this, e]() { return this->build_table( *e ); } );
+    }
+    return nullptr;
+  }
+
+  return nullptr;
+}
+
+bool marley::TabulatedOpticalModel::has_table( int fragment_pdg ) const {
+  return this->num_cells( fragment_pdg ) > 0u;
+}
+
+size_t marley::TabulatedOpticalModel::num_cells( int fragment_pdg ) const {
+  for ( const auto& entry : entries_ ) {
+    if ( entry->fragment_pdg != fragment_pdg ) continue;
+    const Table* table = entry->published.load( std::memory_order_acquire );
+    return table ? table->num_cells : 0u;
+  }
+  return 0u;
+}
+
+int marley::TabulatedOpticalModel::slot( int two_j, int l, int two_s ) const
+{
+  if ( l < 0 || l > l_max_ ) return -1;
+
+  int diff = two_j - 2*l + two_s;
+  if ( diff < 0 || diff > 2*two_s || diff % 2 != 0 ) return -1;
+
+  return l*( two_s + 1 ) + diff / 2;
+}
+
+bool marley::TabulatedOpticalModel::locate( const Table& table,
+  double total_KE_CM, size_t& k, double& t ) const
+{
+  if ( !(total_KE_CM >= MIN_ENERGY && total_KE_CM <= E_max_) ) return false;
+
+  double x = std::log( total_KE_CM / MIN_ENERGY ) * table.inv_du;
+  if ( x < 0. ) x = 0.;
+  k = static_cast<size_t>( x );
+  if ( k >= table.num_cells ) k = table.num_cells - 1u;
+  t = x - k;
+  return true;
+}
+
+bool marley::TabulatedOpticalModel::lookup( const Table& table, size_t k,
+  double t, int s, size_t stride, double& T ) const
+{
+  if ( s < 0 || table.use_direct[ k*stride + s ] ) return false;
+
+  const double* lower = table.ln_Ts.data() + k*stride;
+  T = interpolate( lower[s], lower[stride + s], t );
+  return true;
+}
+
+double marley::TabulatedOpticalModel::transmission_coefficient(
+  double total_KE_CM, int fragment_pdg, int two_j, int l, int two_s,
+  int target_charge, Workspace& ws) const
+{
+  const Table* table = this->find_table( fragment_pdg, two_s, target_charge );
+  size_t k;
+  double t, T;
+  if ( table && this->locate(*table, total_KE_CM, k, t)
+    && this->lookup(*table, k, t, this->slot(two_j, l, two_s),
+    this->num_slots(two_s), T) )
+  {
+    return T;
+  }
+
+  return direct_->transmission_coefficient( total_KE_CM, fragment_pdg, two_j,
+    l, two_s, target_charge, ws );
+}
+
+void marley::TabulatedOpticalModel::transmission_coefficients(
+  double total_KE_CM, int fragment_pdg, int two_s, const int* two_js,
+  const int* ls, size_t num_waves, int target_charge, double* Ts,
+  Workspace& ws) const
+{
+  const Table* table = this->find_table( fragment_pdg, two_s, target_charge );
+  size_t k;
+  double t;
+  if ( !table || !this->locate(*table, total_KE_CM, k, t) ) {
+    direct_->transmission_coefficients( total_KE_CM, fragment_pdg, two_s,
+      two_js, ls, num_waves, target_charge, Ts, ws );
+    return;
+  }
+
+  size_t stride = this->num_slots( two_s );
+  for ( size_t w = 0u; w < num_waves; ++w ) {
+    int s = this->slot( two_js[w], ls[w], two_s );
+    if ( !this->lookup(*table, k, t, s, stride, Ts[w]) ) {
+      Ts[ w ] = direct_->transmission_coefficient( total_KE_CM,
+        fragment_pdg, two_js[w], ls[w], two_s, target_charge, ws );
+    }
+  }
+}
+
+bool marley::TabulatedOpticalModel::build_table( Entry& entry ) const {
+
+  const int two_s = entry.two_s;
+  const size_t stride = this->num_slots( two_s );
+
+  // List every physical partial wave up to l_max
+  std::vector<int> two_js, ls, slots;
+  for ( int l = 0; l <= l_max_; ++l ) {
+    for ( int two_j = std::abs(2*l - two_s); two_j <= 2*l + two_s;
+      two_j += 2 )
+    {
+      two_js.push_back( two_j );
+      ls.push_back( l );
+      slots.push_back( this->slot(two_j, l, two_s) );
+    }
+  }
+
+  constexpr double LOG_ZERO = -std::numeric_limits<double>::infinity();
+  Workspace ws;
+  std::vector<double> Ts( two_js.size() );
+
+  // Computes the logarithms of the coefficients at num energies whose
+  // logarithms are u_0, u_0 + du, ... Returns false if the builder is
+  // stopping.
+  auto compute_nodes = [&]( double u_0, double du, size_t num,
+    std::vector<double>& nodes ) -> bool
+  {
+    nodes.assign( num * stride, LOG_ZERO );
+    for ( size_t k = 0u; k < num; ++k ) {
+      if ( builder_.stopping() ) return false;
+      double E = MIN_ENERGY * std::exp( u_0 + k*du );
+      direct_->transmission_coefficients( E, entry.fragment_pdg, two_s,
+        two_js.data(), ls.data(), two_js.size(), 0, Ts.data(), ws );
+      double* node = nodes.data() + k*stride;
+      for ( size_t w = 0u; w < Ts.size(); ++w ) {
+        if ( Ts[w] > 0. ) node[ slots[w] ] = std::log( Ts[w] );
+      }
+    }
+    return true;
+  };
+
+  size_t num_cells = INITIAL_CELLS;
+  double du = std::log( E_max_ / MIN_ENERGY ) / num_cells;
+  std::vector<double> nodes, midpoints, refined;
+  std::vector<unsigned char> failed;
+  if ( !compute_nodes(0., du, num_cells + 1u, nodes) ) return false;
+
+  while ( true ) {
+
+    // Compare the interpolated coefficients to the direct calculation at
+    // the midpoint of each cell
+    if ( !compute_nodes(0.5*du, du, num_cells, midpoints) ) return false;
+
+    failed.assign( num_cells * stride, 0u );
+    bool converged = true;
+    for ( size_t k = 0u; k < num_cells; ++k ) {
+      const double* lower = nodes.data() + k*stride;
+      const double* mid = midpoints.data() + k*stride;
+      for ( int s : slots ) {
+        double T = std::exp( mid[s] );
+        double T_interp = interpolate( lower[s], lower[stride + s], 0.5 );
+        double allowed = tolerance_ * ( T > MIN_RELEVANT_T ? T
+          : MIN_RELEVANT_T );
+        if ( std::abs(T_interp - T) > allowed ) {
+          failed[ k*stride + s ] = 1u;
+          converged = false;
+        }
+      }
+    }
+
+    // Coefficients that still fail the check on the finest grid allowed
+    // will be computed directly
+    if ( converged || 2u*num_cells > MAX_CELLS ) break;
+
+    // Halve the grid spacing, reusing the midpoints as the new nodes
+    refined.resize( (2u*num_cells + 1u) * stride );
+    for ( size_t j = 0u; j <= 2u*num_cells; ++j ) {
+      const double* src = ( j % 2u == 0u ? nodes : midpoints ).data()
+        + (j / 2u)*stride;
+      std::copy( src, src + stride, refined.data() + j*stride );
+    }
+    nodes.swap( refined );
+    num_cells *= 2u;
+    du *= 0.5;
+  }
+
+  auto table = std::make_unique<Table>();
+  table->inv_du = 1. / du;
+  table->num_cells = num_cells;
+  table->ln_Ts = std::move( nodes );
+  table->use_direct = std::move( failed );
+
+  entry.table = std::move( table );
+  entry.published.store( entry.table.get(), std::memory_order_release );
+  return true;
+}
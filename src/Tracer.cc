@@ -0,0 +1,258 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "marley/Error.hh"
+#include "marley/Logger.hh"
+#include "marley/Tracer.hh"
+
+namespace {
+
+  using Clock = std::chrono::steady_clock;
+
+  // A completed span or a set of counter values
+  struct Record {
+    const char* name;
+    Clock::time_point start;
+    Clock::duration duration;
+    size_t num_args;
+    marley::Tracer::Argument args[ marley::Tracer::MAX_ARGUMENTS ];
+    bool is_counter;
+  };
+
+  // Spans recorded by a single thread. Only the owning thread modifies
+  // a buffer while tracing is enabled.
+  struct ThreadBuffer {
+    int tid;
+    std::vector<Record> records;
+    size_t dropped = 0u;
+    long events_seen = 0;
+  };
+
+  // Shared tracing state. The mutex is only needed when a thread registers
+  // its buffer and when the trace is written.
+  std::atomic<bool> tracing_enabled( false );
+  std::mutex buffers_mutex;
+  std::vector< std::unique_ptr<ThreadBuffer> > buffers;
+  std::string trace_file_name;
+  double traced_event_fraction = 1.;
+  size_t max_spans_per_thread = marley::Tracer::DEFAULT_MAX_SPANS;
+  Clock::time_point trace_start_time;
+
+  // Incremented whenever the buffers are discarded so that threads know to
+  // register new ones
+  std::atomic<long> trace_generation( 0 );
+
+  thread_local ThreadBuffer* thread_buffer = nullptr;
+  thread_local long thread_generation = -1;
+  thread_local bool current_event_traced = false;
+
+  ThreadBuffer& get_thread_buffer() {
+    long generation = trace_generation.load( std::memory_order_acquire );
+    if ( !thread_buffer || thread_generation != generation ) {
+      std::lock_guard<std::mutex> lock( buffers_mutex );
+      buffers.push_back( std::make_unique<ThreadBuffer>() );
+      thread_buffer = buffers.back().get();
+      thread_buffer->tid = static_cast<int>( buffers.size() );
+      thread_generation = trace_generation.load();
+    }
+    return *thread_buffer;
+  }
+
+  // Converts a time interval to microseconds (the unit used by the Chrome
+  // trace-event format)
+  inline double to_us( Clock::duration d ) {
+    return std::chrono::duration<double, std::micro>( d ).count();
+  }
+
+  void write_escaped( std::ostream& out, const char* str ) {
+    out << '\"';
+    for ( const char* c = str; *c; ++c ) {
+      if ( *c == '\"' || *c == '\\' ) out << '\\';
+      out << *c;
+    }
+    out << '\"';
+  }
+
+}
+
+constexpr size_t marley::Tracer::MAX_ARGUMENTS;
+constexpr size_t marley::Tracer::DEFAULT_MAX_SPANS;
+
+marley::Tracer::Span::Span( const char* name,
+  std::initializer_list<Argument> args ) : name_( name )
+{
+  if ( !Tracer::event_traced() ) return;
+  for ( const auto& arg : args ) {
+    if ( num_args_ >= MAX_ARGUMENTS ) break;
+    args_[ num_args_++ ] = arg;
+  }
+  this->start();
+}
+
+void marley::Tracer::Span::start() {
+  active_ = true;
+  start_time_ = Clock::now();
+}
+
+void marley::Tracer::Span::stop() {
+  Clock::time_point stop_time = Clock::now();
+  active_ = false;
+
+  // Tracing may have been switched off while this span was open
+  if ( !tracing_enabled.load(std::memory_order_relaxed) ) return;
+
+  ThreadBuffer& buf = get_thread_buffer();
+  if ( buf.records.size() >= max_spans_per_thread ) {
+    ++buf.dropped;
+    return;
+  }
+
+  buf.records.push_back( Record{ name_, start_time_, stop_time - start_time_,
+    num_args_, {}, false } );
+  std::copy( args_, args_ + num_args_, buf.records.back().args );
+}
+
+void marley::Tracer::counter( const char* name,
+  std::initializer_list<Argument> values )
+{
+  if ( !current_event_traced ) return;
+  if ( !tracing_enabled.load(std::memory_order_relaxed) ) return;
+
+  ThreadBuffer& buf = get_thread_buffer();
+  if ( buf.records.size() >= max_spans_per_thread ) {
+    ++buf.dropped;
+    return;
+  }
+
+  size_t num_values = std::min( values.size(), MAX_ARGUMENTS );
+  buf.records.push_back( Record{ name, Clock::now(), Clock::duration(),
+    num_values, {}, true } );
+  std::copy( values.begin(), values.begin() + num_values,
+    buf.records.back().args );
+}
+
+void marley::Tracer::enable( const std::string& file_name,
+  double event_fraction, size_t max_spans )
+{
+  if ( !(event_fraction > 0. && event_fraction <= 1.) ) {
+    throw marley::Error( "Invalid traced event fraction "
+      + std::to_string(event_fraction) + " passed to"
+      " marley::Tracer::enable()" );
+  }
+
+  std::lock_guard<std::mutex> lock( buffers_mutex );
+  trace_file_name = file_name;
+  traced_event_fraction = event_fraction;
+  max_spans_per_thread = max_spans;
+  trace_start_time = Clock::now();
+  buffers.clear();
+  ++trace_generation;
+  tracing_enabled.store( true );
+}
+
+bool marley::Tracer::enabled() {
+  return tracing_enabled.load( std::memory_order_relaxed );
+}
+
+void marley::Tracer::begin_event() {
+  if ( !tracing_enabled.load(std::memory_order_relaxed) ) {
+    current_event_traced = false;
+    return;
+  }
+
+  // Trace the k-th event seen by this thread whenever the running count of
+  // traced events, ceil(k * fraction), increases
+  ThreadBuffer& buf = get_thread_buffer();
+  long k = buf.events_seen++;
+  current_event_traced = std::ceil( k * traced_event_fraction )
+    < std::ceil( (k + 1) * traced_event_fraction );
+}
+
+bool marley::Tracer::event_traced() {
+  return current_event_traced;
+}
+
+size_t marley::Tracer::write() {
+
+  if ( !tracing_enabled.exchange(false) ) return 0u;
+  current_event_traced = false;
+
+  std::lock_guard<std::mutex> lock( buffers_mutex );
+
+  std::ofstream out( trace_file_name );
+  if ( !out ) throw marley::Error( "Could not open the trace file \""
+    + trace_file_name + '\"' );
+
+  out << std::setprecision( 12 );
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+  size_t num_written = 0u;
+  size_t num_dropped = 0u;
+  bool first = true;
+  for ( const auto& buf : buffers ) {
+    if ( !first ) out << ',';
+    first = false;
+    out << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+      << buf->tid << ",\"args\":{\"name\":\"marley thread " << buf->tid
+      << "\"}}";
+
+    for ( const auto& rec : buf->records ) {
+      out << ",\n{\"name\":";
+      write_escaped( out, rec.name );
+      out << ",\"cat\":\"marley\",\"ph\":\"" << ( rec.is_counter ? 'C'
+        : 'X' ) << "\",\"ts\":" << to_us( rec.start - trace_start_time );
+      if ( !rec.is_counter ) out << ",\"dur\":" << to_us( rec.duration );
+      out << ",\"pid\":1,\"tid\":" << buf->tid;
+      if ( rec.num_args > 0u ) {
+        out << ",\"args\":{";
+        for ( size_t a = 0u; a < rec.num_args; ++a ) {
+          if ( a > 0u ) out << ',';
+          write_escaped( out, rec.args[a].name );
+          out << ':' << rec.args[a].value;
+        }
+        out << '}';
+      }
+      out << '}';
+    }
+
+    num_written += buf->records.size();
+    num_dropped += buf->dropped;
+  }
+
+  out << "\n],\"otherData\":{\"event_fraction\":" << traced_event_fraction
+    << ",\"dropped_spans\":" << num_dropped << "}}\n";
+
+  if ( !out ) throw marley::Error( "Failed to write the trace file \""
+    + trace_file_name + '\"' );
+
+  if ( num_dropped > 0u ) MARLEY_LOG_WARNING() << num_dropped << " spans"
+    << " were dropped from the trace file \"" << trace_file_name << "\" after"
+    << " reaching the limit of " << max_spans_per_thread << " per thread";
+
+  buffers.clear();
+  ++trace_generation;
+  return num_written;
+}
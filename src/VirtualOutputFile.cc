@@ -0,0 +1,170 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// standard library includes
+#include <algorithm>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/FileManager.hh"
+#include "marley/Generator.hh"
+#include "marley/Logger.hh"
+#include "marley/PrimaryEventFilter.hh"
+#include "marley/VirtualOutputFile.hh"
+#include "marley/marley_utils.hh"
+
+marley::VirtualOutputFile::VirtualOutputFile(const std::string& name,
+  const std::string& mode, bool force, long events_per_block,
+  const std::vector<std::string>& summary_fields)
+  : marley::OutputFile(name, "virtual", mode, force),
+  events_per_block_(events_per_block), summary_fields_(summary_fields),
+  summary_values_(summary_fields.size())
+{
+  if ( mode_ != Mode::OVERWRITE ) throw marley::Error("The output mode \""
+    + mode + "\" is not allowed for the virtual output file \"" + name
+    + "\". Only \"overwrite\" may be used.");
+
+  if ( events_per_block_ < 1 ) throw marley::Error("Invalid number of"
+    " events per block " + std::to_string(events_per_block_)
+    + " requested for the virtual output file \"" + name + '\"');
+
+  for ( const auto& field : summary_fields_ ) {
+    if ( !marley::PrimaryEventFilter::is_variable(field) ) {
+      throw marley::Error("Unrecognized summary field \"" + field
+        + "\" requested for the virtual output file \"" + name + '\"');
+    }
+  }
+
+  this->open();
+}
+
+void marley::VirtualOutputFile::open() {
+  bool file_exists = check_if_file_exists( name_ );
+  if ( file_exists && !force_ ) {
+    bool overwrite = marley_utils::prompt_yes_no("Overwrite file "
+      + name_);
+    if ( !overwrite ) throw marley::Error("Cancelling overwrite of the"
+      " virtual output file \"" + name_ + '\"');
+  }
+
+  // Nothing is written until the file is closed, but open it now so that
+  // problems are reported before any events are generated
+  stream_.open( name_, std::ios::out | std::ios::trunc );
+  if ( !stream_ ) throw marley::Error("Could not open the virtual output"
+    " file \"" + name_ + '\"');
+}
+
+bool marley::VirtualOutputFile::resume(std::unique_ptr<marley::Generator>&,
+  long&)
+{
+  throw marley::Error("Cannot resume a previous run using the virtual"
+    " output file \"" + name_ + '\"');
+  return false;
+}
+
+void marley::VirtualOutputFile::write_event(const marley::Event* event) {
+  if ( !event ) throw marley::Error("Null pointer passed to"
+    " VirtualOutputFile::write_event()");
+
+  for ( size_t f = 0; f < summary_fields_.size(); ++f ) {
+    summary_values_.at( f ).push_back( marley::PrimaryEventFilter::evaluate(
+      summary_fields_.at(f), *event) );
+  }
+  ++event_count_;
+}
+
+void marley::VirtualOutputFile::write_flux_avg_tot_xsec(double avg_tot_xsec)
+{
+  flux_avg_tot_xsec_ = avg_tot_xsec;
+}
+
+int_fast64_t marley::VirtualOutputFile::bytes_written() {
+  return byte_count_;
+}
+
+void marley::VirtualOutputFile::close(const marley::JSON& json_config,
+  const marley::Generator& gen, const long num_events)
+{
+  this->write_generator_state( json_config, gen, num_events );
+}
+
+void marley::VirtualOutputFile::write_generator_state(
+  const marley::JSON& json_config, const marley::Generator& gen,
+  const long /*num_events*/)
+{
+  // Store the seed that was actually used so that the configuration
+  // reproduces the events even if it did not originally include one
+  marley::JSON config = json_config;
+  config["seed"] = static_cast<long>( gen.get_seed() );
+
+  // Record checksums for every data file that was needed to generate the
+  // events. Files that have since been removed (e.g., temporary files)
+  // are skipped.
+  marley::JSON data_files = marley::JSON::array();
+  const auto& fm = marley::FileManager::Instance();
+  for ( const auto& pair : fm.located_files() ) {
+    if ( !check_if_file_exists(pair.second) ) continue;
+    marley::JSON file = marley::JSON::object();
+    file["file"] = pair.first;
+    file["path"] = pair.second;
+    file["checksum"] = marley_utils::file_checksum( pair.second );
+    data_files.append( file );
+  }
+
+  // Each block of events was generated using its own random number stream
+  marley::JSON blocks = marley::JSON::array();
+  for ( long first = 0, b = 0; first < event_count_;
+    first += events_per_block_, ++b )
+  {
+    marley::JSON block = marley::JSON::object();
+    block["first_event"] = first;
+    block["num_events"] = std::min( events_per_block_, event_count_ - first );
+    block["stream"] = b;
+    blocks.append( block );
+  }
+
+  marley::JSON info = marley::JSON::object();
+  info["marley_version"] = std::string( MARLEY_VERSION );
+  info["config"] = config;
+  info["data_files"] = data_files;
+  info["event_count"] = event_count_;
+  info["events_per_block"] = events_per_block_;
+  info["flux_avg_xsec"] = flux_avg_tot_xsec_;
+  info["blocks"] = blocks;
+
+  if ( !summary_fields_.empty() ) {
+    marley::JSON summary = marley::JSON::object();
+    for ( size_t f = 0; f < summary_fields_.size(); ++f ) {
+      marley::JSON values = marley::JSON::array();
+      for ( double v : summary_values_.at(f) ) values.append( v );
+      summary[ summary_fields_.at(f) ] = values;
+    }
+    info["summary"] = summary;
+  }
+
+  marley::JSON temp = marley::JSON::object();
+  temp["virtual"] = info;
+
+  stream_ << temp.dump_string() << '\n';
+  stream_.flush();
+  if ( !stream_ ) throw marley::Error("Failed to write the virtual output"
+    " file \"" + name_ + '\"');
+
+  byte_count_ = static_cast<int_fast64_t>( stream_.tellp() );
+  stream_.close();
+}
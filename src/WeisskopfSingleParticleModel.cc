@@ -34,14 +34,14 @@ marley::WeisskopfSingleParticleModel::WeisskopfSingleParticleModel(int Z,
 // Computes the partial decay width for a gamma transition under the Weisskopf
 // single-particle approximation.
 double marley::WeisskopfSingleParticleModel::partial_decay_width(TrType type,
-  int l, double e_gamma)
+  int l, double e_gamma) const
 {
   return D0_ * std::pow(e_gamma, 2*l + 1)
     * strength_function(type, l, e_gamma);
 }
 
 double marley::WeisskopfSingleParticleModel::strength_function(TrType type,
-  int l, double /*e_gamma unused*/)
+  int l, double /*e_gamma unused*/) const
 {
   check_multipolarity(l);
 
@@ -83,7 +83,7 @@ double marley::WeisskopfSingleParticleModel::strength_function(TrType type,
 }
 
 double marley::WeisskopfSingleParticleModel::transmission_coefficient(
-  TrType type, int l, double e_gamma)
+  TrType type, int l, double e_gamma) const
 {
   return 2. * marley_utils::pi * strength_function(type, l, e_gamma)
     * std::pow(e_gamma, 2*l + 1);
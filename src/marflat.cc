@@ -0,0 +1,165 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Converts MARLEY events into the flat per-event summary used by marsum,
+// but without any dependence on ROOT. The summary is written to a simple
+// columnar binary file (and optionally to a CSV file). Several input files
+// are read in parallel. See marley::FlatSummaryWriter for a description of
+// the file format.
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef USE_ROOT
+  #include "TROOT.h"
+  #include "marley/RootEventFileReader.hh"
+#else
+  #include "marley/EventFileReader.hh"
+#endif
+
+// MARLEY includes
+#include "marley/FlatSummaryWriter.hh"
+#include "marley/Logger.hh"
+#include "marley/marley_utils.hh"
+
+namespace {
+
+  void print_usage( const std::string& name ) {
+    std::cout << "Usage: " << name << " [-j THREADS] [-b EVENTS_PER_BLOCK]"
+      << " [-c CSV_FILE] [-f] OUTPUT_FILE INPUT_FILE...\n\n"
+      << "  -j  Number of input files to read at once (default: number of"
+      << " CPU cores)\n"
+      << "  -b  Number of events in each block of the output file (default: "
+      << marley::FlatSummaryWriter::DEFAULT_EVENTS_PER_BLOCK << ")\n"
+      << "  -c  Also write the summary to a CSV file\n"
+      << "  -f  Overwrite existing output files without asking\n";
+  }
+
+  // Returns false if the user doesn't want to overwrite an existing file
+  bool check_overwrite( const std::string& file_name, bool force ) {
+    if ( force || !std::ifstream(file_name) ) return true;
+    bool overwrite = marley_utils::prompt_yes_no( "Really overwrite "
+      + file_name + '?' );
+    if ( !overwrite ) std::cout << "Action aborted.\n";
+    return overwrite;
+  }
+}
+
+int main( int argc, char* argv[] ) {
+
+  int num_threads = std::thread::hardware_concurrency();
+  size_t events_per_block
+    = marley::FlatSummaryWriter::DEFAULT_EVENTS_PER_BLOCK;
+  std::string csv_file_name;
+  bool force = false;
+
+  int arg = 1;
+  try {
+    for ( ; arg < argc && argv[arg][0] == '-'; ++arg ) {
+      std::string option( argv[arg] );
+      if ( option == "-f" ) force = true;
+      else if ( (option == "-j" || option == "-b" || option == "-c")
+        && arg + 1 < argc )
+      {
+        std::string value( argv[++arg] );
+        if ( option == "-c" ) csv_file_name = value;
+        else {
+          long number = std::stol( value );
+          if ( number <= 0 ) throw std::invalid_argument( value );
+          if ( option == "-j" ) num_threads = number;
+          else events_per_block = number;
+        }
+      }
+      else {
+        print_usage( argv[0] );
+        return 1;
+      }
+    }
+  }
+  catch ( const std::exception& ) {
+    std::cout << "Invalid value for the option " << argv[arg - 1] << '\n';
+    return 1;
+  }
+
+  // If the user has not supplied enough command-line arguments, display the
+  // standard help message and exit
+  if ( argc - arg < 2 ) {
+    print_usage( argv[0] );
+    return 0;
+  }
+
+  std::string output_file_name( argv[arg] );
+  std::vector<std::string> input_files;
+  for ( int i = arg + 1; i < argc; ++i ) input_files.push_back( argv[i] );
+
+  if ( !check_overwrite(output_file_name, force) ) return 0;
+  if ( !csv_file_name.empty() && !check_overwrite(csv_file_name, force) ) {
+    return 0;
+  }
+
+  std::ofstream out( output_file_name, std::ios::binary );
+  std::ofstream csv;
+  if ( !csv_file_name.empty() ) csv.open( csv_file_name );
+
+  #ifdef USE_ROOT
+    // Allow ROOT files to be read by several threads at once
+    ROOT::EnableThreadSafety();
+    auto make_reader = []( const std::string& file_name ) {
+      return std::make_unique<marley::RootEventFileReader>( file_name );
+    };
+  #else
+    auto make_reader = []( const std::string& file_name ) {
+      return std::make_unique<marley::EventFileReader>( file_name );
+    };
+  #endif
+
+  marley::FlatSummaryWriter writer( input_files, num_threads,
+    events_per_block, make_reader );
+  uint64_t total_events = writer.write( out,
+    csv.is_open() ? &csv : nullptr );
+
+  bool failed = false;
+  for ( size_t file = 0u; file < input_files.size(); ++file ) {
+    const auto& result = writer.file_results().at( file );
+    if ( !result.error.empty() ) {
+      MARLEY_LOG_ERROR() << "Could not convert the file \""
+        << input_files.at( file ) << "\": " << result.error;
+      failed = true;
+    }
+    else std::cout << "Converted " << result.num_events << " events from \""
+      << input_files.at( file ) << "\"\n";
+  }
+
+  out.close();
+  if ( !out ) {
+    MARLEY_LOG_ERROR() << "Could not write the output file \""
+      << output_file_name << '\"';
+    return 1;
+  }
+
+  std::cout << "Wrote " << total_events << " events to \""
+    << output_file_name << "\"\n";
+  if ( csv.is_open() ) std::cout << "Wrote " << total_events
+    << " events to \"" << csv_file_name << "\"\n";
+
+  return failed ? 1 : 0;
+}
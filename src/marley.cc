@@ -14,11 +14,16 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+#include <atomic>
 #include <chrono>
 #include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <new>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -32,10 +37,22 @@
   #include "marley/JSONConfig.hh"
 #endif
 
+#include "marley/Arena.hh"
+#include "marley/Compression.hh"
+#include "marley/DecayOnlyGenerator.hh"
 #include "marley/Generator.hh"
 #include "marley/Event.hh"
+#include "marley/EventProjection.hh"
+#include "marley/JobQueue.hh"
 #include "marley/Logger.hh"
 #include "marley/OutputFile.hh"
+#include "marley/ProjectileStream.hh"
+#include "marley/ShardedOutputFile.hh"
+#include "marley/StartupProfile.hh"
+#include "marley/StoppingRule.hh"
+#include "marley/StructureDatabase.hh"
+#include "marley/Tracer.hh"
+#include "marley/VirtualOutputFile.hh"
 
 #ifdef USE_ROOT
   #include "TFile.h"
@@ -64,6 +81,43 @@ void signal_handler(int)
   interrupted = true;
 }
 
+// Count the memory allocations made by each thread so that they can be
+// reported in the startup profile. A thread-local counter avoids contention
+// between the threads that generate events. The replacement allocation
+// functions below are always linked in, but they only update the counter
+// while the startup profile is enabled.
+namespace {
+  std::atomic<bool> counting_allocations( false );
+  thread_local long num_allocations = 0;
+  long count_allocations() { return num_allocations; }
+
+  void* allocate( std::size_t size ) {
+    if ( counting_allocations.load(std::memory_order_relaxed) ) {
+      ++num_allocations;
+    }
+    if ( size == 0u ) size = 1u;
+    while ( true ) {
+      void* ptr = std::malloc( size );
+      if ( ptr ) return ptr;
+      std::new_handler handler = std::get_new_handler();
+      if ( !handler ) throw std::bad_alloc();
+      handler();
+    }
+  }
+
+  void deallocate( void* ptr ) noexcept {
+    std::free( ptr );
+  }
+}
+
+void* operator new(std::size_t size) { return allocate( size ); }
+void* operator new[](std::size_t size) { return allocate( size ); }
+
+void operator delete(void* ptr) noexcept { deallocate( ptr ); }
+void operator delete[](void* ptr) noexcept { deallocate( ptr ); }
+void operator delete(void* ptr, std::size_t) noexcept { deallocate( ptr ); }
+void operator delete[](void* ptr, std::size_t) noexcept { deallocate( ptr ); }
+
 namespace {
 
   constexpr int DEFAULT_STATUS_UPDATE_INTERVAL = 100;
@@ -136,11 +190,31 @@ namespace {
     return time_str;
   }
 
+  // Reads an optional non-negative integer setting (e.g., for sharded
+  // output) from an output file specification. Returns zero if the key is
+  // not present.
+  long get_shard_setting(const marley::JSON& output_spec,
+    const std::string& key, const std::string& filename)
+  {
+    if ( !output_spec.has_key(key) ) return 0;
+
+    const auto& setting = output_spec.at( key );
+    bool ok;
+    long value = setting.to_long( ok );
+    if ( !ok || value < 0 ) {
+      throw marley::Error( "Invalid value " + setting.dump_string()
+        + " given for the \"" + key + "\" key for the output file \""
+        + filename + '\"' );
+    }
+    return value;
+  }
+
   // Formats the lines of the status display shown at the bottom of the
   // screen when this executable is running
   std::string makeStatusLines(long ev_count, long num_events, long num_old_events,
     std::chrono::system_clock::time_point start_time_point,
-    const std::vector< std::unique_ptr<marley::OutputFile> >& output_files)
+    const std::vector< std::unique_ptr<marley::OutputFile> >& output_files,
+    const marley::TableBuilder* tables)
   {
     std::chrono::system_clock::time_point current_time_point
       = std::chrono::system_clock::now();
@@ -180,6 +254,16 @@ namespace {
         << "\033[K\n";
     }
 
+    // Report the progress of the background table construction (if any)
+    if ( tables ) {
+      size_t built = tables->num_built();
+      size_t failed = tables->num_failed();
+      temp_oss << "Transmission coefficient tables: " << built << " built, "
+        << tables->num_submitted() - built - failed << " in progress";
+      if ( failed > 0u ) temp_oss << ", " << failed << " failed";
+      temp_oss << "\033[K\n";
+    }
+
     std::time_t estimated_end_time = std::chrono::system_clock::to_time_t(
       start_time_point + std::chrono::duration_cast
       <std::chrono::system_clock::duration>( estimated_total_time ));
@@ -191,6 +275,7 @@ namespace {
     // we're displaying the amount of data written to disk for each of them
     // on a separate line.
     for (size_t i = 0; i < output_files.size(); ++i) temp_oss << "\033[F";
+    if ( tables ) temp_oss << "\033[F";
 
     // Move up four lines
     temp_oss << "\033[F\033[F\033[F\033[F";
@@ -206,11 +291,12 @@ namespace {
       StatusInserter(std::streambuf* dest, const long& ev_count,
         const long& num_events, const long& num_old_events,
         const std::chrono::system_clock::time_point& start_time_point,
-        const std::vector<std::unique_ptr<marley::OutputFile> >& output_files)
+        const std::vector<std::unique_ptr<marley::OutputFile> >& output_files,
+        const marley::TableBuilder* tables)
         : std::streambuf(), myDest_( dest ), myIsAtStartOfLine_(true),
         do_status_(true), ev_count_( ev_count ), num_events_( num_events ),
         num_old_events_( num_old_events ), start_time_point_( start_time_point ),
-        output_files_( output_files ) {}
+        output_files_( output_files ), tables_( tables ) {}
 
       inline void set_do_status(bool do_it) { do_status_ = do_it; }
 
@@ -223,13 +309,15 @@ namespace {
       const long& num_old_events_;
       const std::chrono::system_clock::time_point& start_time_point_;
       const std::vector<std::unique_ptr<marley::OutputFile> >& output_files_;
+      const marley::TableBuilder* tables_;
 
       int overflow( int ch ) override {
         int retval = 0;
         if ( ch != traits_type::eof() ) {
           if ( do_status_ && myIsAtStartOfLine_ ) {
             std::string status = makeStatusLines(ev_count_,
-              num_events_, num_old_events_, start_time_point_, output_files_);
+              num_events_, num_old_events_, start_time_point_, output_files_,
+              tables_);
             myDest_->sputn( status.data(), status.size() );
           }
           myIsAtStartOfLine_ = ch == '\n';
@@ -243,6 +331,345 @@ namespace {
       }
   };
 
+  constexpr long DEFAULT_EVENTS_PER_UNIT = 1000;
+  constexpr double DEFAULT_JOB_QUEUE_TIMEOUT = 600.; // s
+
+  // Output file requested for a run that uses a job queue
+  struct QueueOutput {
+    std::string file;
+    std::string format;
+    bool force;
+    marley::EventProjection projection;
+  };
+
+  // Throws an exception if the configuration requests a feature that cannot
+  // be combined with the given execution mode (a job queue or a projectile
+  // stream). Both modes need events that can be reproduced from their random
+  // number streams alone, so the events may not depend on timing (as they
+  // would if transmission tables become ready in the background).
+  void reject_incompatible_settings(const marley::JSON& json,
+    const std::string& mode)
+  {
+    marley::JSON ex_set = json.at( "executable_settings" );
+    for ( const char* key : { "stopping", "trace", "startup_profile" } ) {
+      if ( ex_set.has_key(key) ) throw marley::Error("The \""
+        + std::string( key ) + "\" key may not be used together with "
+        + mode + '.');
+    }
+    if ( marley::DecayOnlyGenerator::is_requested(json) ) {
+      throw marley::Error("Decay-only runs may not use " + mode + '.');
+    }
+    if ( json.has_key("transmission_tables") ) throw marley::Error("The"
+      " \"transmission_tables\" key may not be used together with "
+      + mode + '.');
+  }
+
+  // Generates events together with any other processes that share the job
+  // queue directory. Each work unit is written to its own set of files, and
+  // the last process to finish concatenates them into the requested output
+  // files. Returns the exit code for the executable.
+  int run_job_queue(marley::JSON& json, marley::JSON queue_set) {
+
+    if ( !queue_set.is_object() ) throw marley::Error("The \"job_queue\" key"
+      " in the executable settings must have a value that is a JSON"
+      " object.");
+    if ( !queue_set.has_key("directory") ) throw marley::Error("Missing"
+      " directory for the job queue in the configuration file.");
+
+    std::string directory = queue_set.at( "directory" ).to_string();
+    long events_per_unit = queue_set.get_long( "events_per_unit",
+      DEFAULT_EVENTS_PER_UNIT );
+    double timeout = queue_set.get_double( "timeout",
+      DEFAULT_JOB_QUEUE_TIMEOUT );
+
+    reject_incompatible_settings( json, "a job queue" );
+    marley::JSON ex_set = json.at( "executable_settings" );
+
+    // Only formats that can be merged by simple concatenation are allowed.
+    // This excludes hepmc3 (each file has its own header and footer, and
+    // the events are numbered), json, and root.
+    std::vector<QueueOutput> outputs;
+    if ( ex_set.has_key("output") ) {
+      const marley::JSON& output_set = ex_set.at( "output" );
+      if ( !output_set.is_array() ) throw marley::Error("The"
+        " \"output\" key in the executable settings must have a value that"
+        " is a JSON array.");
+      for ( const auto& el : output_set.array_range() ) {
+        if ( !el.has_key("file") || !el.has_key("format") ) {
+          throw marley::Error("Missing file name or format for an output"
+            " file specification in the configuration file.");
+        }
+        std::string filename = el.at( "file" ).to_string();
+        std::string format = el.at( "format" ).to_string();
+        if ( marley::OutputFile::is_standard_output(filename) ) {
+          throw marley::Error("Events may not be written to the standard"
+            " output by runs that use a job queue.");
+        }
+        if ( format != "ascii" && format != "hepevt" ) throw marley::Error(
+          "The output file \"" + filename + "\" uses the " + format
+          + " format, but only ascii and hepevt files may be written by runs"
+          " that use a job queue. Files in the other formats (including"
+          " hepmc3) cannot be merged by concatenation.");
+        bool force = el.has_key( "force" ) && el.at( "force" ).to_bool();
+        if ( (el.has_key("mode") && el.at("mode").to_string() != "overwrite")
+          || marley::CompressionSettings(el).enabled()
+          || el.has_key("shards") || el.has_key("max_events_per_shard")
+          || el.has_key("max_bytes_per_shard") )
+        {
+          throw marley::Error("The mode, compression, and sharding settings"
+            " may not be used for the output file \"" + filename + "\" in"
+            " a run that uses a job queue.");
+        }
+        outputs.push_back( { filename, format, force,
+          marley::EventProjection(el) } );
+      }
+    }
+    else outputs.push_back( { "events.ascii", "ascii", false,
+      marley::EventProjection() } );
+
+    // Every process must use the same random number seed. If the user did
+    // not choose one, the process that creates the queue picks it.
+    bool seed_given = json.has_key( "seed" );
+    if ( !seed_given ) json[ "seed" ] = static_cast<long>(
+      std::chrono::system_clock::now().time_since_epoch().count() );
+
+    marley::JSON description = marley::JSON::object();
+    description[ "events" ] = ex_set.get_long( "events", 1e3 );
+    description[ "events_per_unit" ] = events_per_unit;
+    description[ "config" ] = json;
+
+    marley::JobQueue queue( directory, description, timeout );
+
+    const marley::JSON& config = queue.description().at( "config" );
+    if ( !seed_given ) json[ "seed" ] = config.at( "seed" );
+    if ( json.dump_string() != config.dump_string() ) {
+      throw marley::Error("The job configuration differs from the one used"
+        " to create the job queue in " + directory);
+    }
+
+    // Refuse to replace existing output files unless the user allows it
+    if ( !queue.merged() ) for ( const auto& out : outputs ) {
+      if ( !out.force && std::ifstream(out.file).good() ) {
+        throw marley::Error("The output file \"" + out.file + "\" already"
+          " exists. Set \"force\" to true to overwrite it.");
+      }
+    }
+
+    #ifdef USE_ROOT
+      marley::RootJSONConfig jc( config );
+    #else
+      marley::JSONConfig jc( config );
+    #endif
+    marley::Generator gen = jc.create_generator();
+    double avg_tot_xs = gen.flux_averaged_total_xs();
+
+    std::signal( SIGINT, signal_handler );
+
+    marley::JobQueue::Unit unit;
+    marley::Event event;
+    long num_units_generated = 0;
+    while ( !interrupted && queue.claim(unit) ) {
+
+      MARLEY_LOG_INFO() << "Generating events " << unit.first_event + 1
+        << " to " << unit.first_event + unit.num_events << " (unit "
+        << unit.index + 1 << " of " << queue.num_units() << ')';
+
+      // Each unit uses its own random number stream, so its events do
+      // not depend on which process generates them
+      gen.start_event_stream( unit.index );
+
+      std::vector<std::unique_ptr<marley::OutputFile> > files;
+      std::vector<long> header_bytes;
+      for ( size_t f = 0u; f < outputs.size(); ++f ) {
+        files.push_back( std::make_unique<marley::TextOutputFile>(
+          queue.unit_output_name(unit, f), outputs.at(f).format, "overwrite",
+          true) );
+        files.back()->set_projection( outputs.at(f).projection );
+        files.back()->set_weight_names( gen.get_universes().names() );
+        files.back()->write_flux_avg_tot_xsec( avg_tot_xs );
+        header_bytes.push_back( files.back()->bytes_written() );
+      }
+
+      auto last_heartbeat = std::chrono::steady_clock::now();
+      long e = 0;
+      for ( ; e < unit.num_events && !interrupted; ++e ) {
+        event = gen.create_event();
+        for ( const auto& file : files ) file->write_event( &event );
+
+        auto now = std::chrono::steady_clock::now();
+        if ( std::chrono::duration<double>(now - last_heartbeat).count()
+          > timeout / 4. )
+        {
+          queue.heartbeat( unit );
+          last_heartbeat = now;
+        }
+      }
+
+      for ( const auto& file : files ) file->close( config, gen, e );
+
+      if ( interrupted ) {
+        for ( size_t f = 0u; f < files.size(); ++f ) {
+          std::remove( queue.unit_output_name(unit, f).c_str() );
+        }
+        queue.release( unit );
+        break;
+      }
+
+      queue.complete( unit, header_bytes );
+      ++num_units_generated;
+    }
+
+    MARLEY_LOG_INFO() << "This process generated " << num_units_generated
+      << " of the " << queue.num_units() << " units in the job queue";
+
+    if ( interrupted ) {
+      MARLEY_LOG_INFO() << "MARLEY was interrupted by the user. Its"
+        << " unfinished unit was returned to the job queue.";
+      return 0;
+    }
+
+    // Units claimed by other processes may still be in progress. The last
+    // process to finish merges the output.
+    if ( !queue.finished() ) {
+      MARLEY_LOG_INFO() << queue.num_done() << " of " << queue.num_units()
+        << " units are done. The output files will be merged by the last"
+        << " process to finish.";
+      return 0;
+    }
+
+    std::vector<std::string> file_names;
+    for ( const auto& out : outputs ) file_names.push_back( out.file );
+    if ( queue.merge(file_names) ) {
+      for ( const auto& name : file_names ) {
+        MARLEY_LOG_INFO() << "Data for " << queue.num_events()
+          << " events written to " << name;
+      }
+    }
+    else MARLEY_LOG_INFO() << "The output files are being merged by another"
+      << " process";
+
+    return 0;
+  }
+
+  // Creates events for projectile records supplied by another program
+  // through the standard input (or a file such as a FIFO). The events are
+  // written in the same order as the records, by default to the standard
+  // output. Returns the exit code for the executable.
+  int run_projectile_stream(const marley::JSON& json,
+    marley::JSON stream_set)
+  {
+    if ( !stream_set.is_object() ) throw marley::Error("The"
+      " \"projectile_stream\" key in the executable settings must have a"
+      " value that is a JSON object.");
+
+    reject_incompatible_settings( json, "a projectile stream" );
+    marley::JSON ex_set = json.at( "executable_settings" );
+
+    std::string input = stream_set.get_string( "input", "stdin" );
+    auto format = marley::ProjectileStream::parse_format(
+      stream_set.get_string("format", "text") );
+
+    long num_threads = stream_set.get_long( "threads", 0 );
+    if ( num_threads < 0 ) throw marley::Error("The number of threads for"
+      " the projectile stream may not be negative");
+
+    long batch_size = stream_set.get_long( "batch_size",
+      marley::ProjectileStream::DEFAULT_BATCH_SIZE );
+    if ( batch_size < 1 ) throw marley::Error("The batch size for the"
+      " projectile stream must be positive");
+
+    // Events are written to the standard output unless the user asks for
+    // something else. Output that has to be finished by regenerating or
+    // reopening files is not supported.
+    marley::JSON output_set = marley::JSON::array();
+    if ( ex_set.has_key("output") ) output_set = ex_set.at( "output" );
+    else output_set.append( marley::JSON::object() );
+    if ( !output_set.is_array() ) throw marley::Error("The"
+      " \"output\" key in the executable settings must have a value that"
+      " is a JSON array.");
+
+    bool uses_stdout = false;
+    std::vector<std::unique_ptr<marley::OutputFile> > output_files;
+    for ( auto& el : output_set.array_range() ) {
+      std::string filename = el.get_string( "file", "stdout" );
+      std::string format_name = el.get_string( "format", "ascii" );
+      if ( format_name == "virtual" || el.has_key("shards")
+        || el.has_key("max_events_per_shard")
+        || el.has_key("max_bytes_per_shard")
+        || (el.has_key("mode") && el.at("mode").to_string() != "overwrite") )
+      {
+        throw marley::Error("The output file \"" + filename + "\" uses a"
+          " format, mode, or sharding setting that may not be used with a"
+          " projectile stream.");
+      }
+      bool is_stdout = marley::OutputFile::is_standard_output( filename );
+      uses_stdout = uses_stdout || is_stdout;
+
+      // The standard input may hold the projectile records, so don't
+      // prompt the user before replacing existing files
+      bool force = el.has_key( "force" ) && el.at( "force" ).to_bool();
+      if ( !is_stdout && !force && std::ifstream(filename).good() ) {
+        throw marley::Error("The output file \"" + filename + "\" already"
+          " exists. Set \"force\" to true to overwrite it.");
+      }
+
+      if ( format_name == "root" ) {
+        #ifdef USE_ROOT
+          if ( is_stdout ) throw marley::Error("ROOT files may not be"
+            " written to the standard output");
+          output_files.push_back( std::make_unique<marley::RootOutputFile>(
+            filename, format_name, "overwrite", true) );
+        #else
+          throw marley::Error("MARLEY must be built with ROOT support to"
+            " write the ROOT output file \"" + filename + '\"');
+        #endif
+      }
+      else output_files.push_back( std::make_unique<marley::TextOutputFile>(
+        filename, format_name, "overwrite", true, el.get_long("indent", -1),
+        marley::CompressionSettings(el)) );
+      output_files.back()->set_projection( marley::EventProjection(el) );
+    }
+
+    #ifdef USE_ROOT
+      marley::RootJSONConfig jc( json );
+    #else
+      marley::JSONConfig jc( json );
+    #endif
+
+    // Log messages would corrupt events written to the standard output, so
+    // send them to the standard error by default
+    auto& logger = marley::Logger::Instance();
+    if ( uses_stdout && logger.has_stream(std::cout) ) {
+      if ( json.has_key("log") ) throw marley::Error("Log messages may not"
+        " be written to the standard output when events are written there");
+      logger.clear_streams();
+      logger.add_stream( std::cerr, marley::Logger::LogLevel::INFO );
+    }
+
+    marley::ProjectileStream stream( jc,
+      marley::ProjectileStream::open_input(input, format), format,
+      num_threads, batch_size );
+
+    double avg_tot_xs = stream.generator().flux_averaged_total_xs();
+    for ( auto& file : output_files ) {
+      file->set_weight_names( stream.generator().get_universes().names() );
+      file->write_flux_avg_tot_xsec( avg_tot_xs );
+    }
+
+    marley::Event event;
+    while ( stream.next_event(event) ) {
+      for ( const auto& file : output_files ) file->write_event( &event );
+    }
+
+    for ( const auto& file : output_files ) {
+      file->close( json, stream.generator(), stream.num_events() );
+    }
+
+    MARLEY_LOG_INFO() << "Created " << stream.num_events() << " events for"
+      << " the projectile records from " << input;
+    return 0;
+  }
+
 }
 
 int main(int argc, char* argv[]) {
@@ -300,8 +727,42 @@ int main(int argc, char* argv[]) {
       }
     }
 
-    // Parse the objects from the JSON-based configuration file
+    // Parse the objects from the JSON-based configuration file. The time
+    // spent doing this is included in the startup profile (if one was
+    // requested). Allocations are counted while parsing since we don't yet
+    // know whether a profile will be needed.
+    marley::StartupProfile::set_allocation_counter( count_allocations );
+    counting_allocations.store( true );
+    auto parse_start = marley::StartupProfile::sample();
     marley::JSON json = marley::JSON::load_file(config_file_name);
+    auto parse_stop = marley::StartupProfile::sample();
+
+    marley::JSON ex_set = json.get_object("executable_settings");
+    if ( !ex_set.has_key("startup_profile") ) {
+      counting_allocations.store( false );
+    }
+
+    // Runs that share their work with other processes through a job queue
+    // are handled separately
+    if ( ex_set.has_key("job_queue") ) {
+      return run_job_queue( json, ex_set.at("job_queue") );
+    }
+
+    // So are runs that create events for projectile records supplied by
+    // another program
+    if ( ex_set.has_key("projectile_stream") ) {
+      return run_projectile_stream( json, ex_set.at("projectile_stream") );
+    }
+
+    // Record the resources used by each phase of the job start-up if the
+    // user asked for it
+    std::string profile_file_name;
+    if ( ex_set.has_key("startup_profile") ) {
+      profile_file_name = ex_set.at( "startup_profile" ).to_string();
+      marley::StartupProfile::enable();
+      marley::StartupProfile::record( "Parse job configuration", parse_start,
+        parse_stop );
+    }
 
     // Process them to get the generator configuration. Enable ROOT support if
     // it is available.
@@ -323,8 +784,6 @@ int main(int argc, char* argv[]) {
 
     long num_old_events = 0;
 
-    marley::JSON ex_set = json.get_object("executable_settings");
-
     // Desired number of events to be generated in this run. This
     // will be read back from the ROOT file and overwritten
     // if we're doing a continuation run.
@@ -365,6 +824,11 @@ int main(int argc, char* argv[]) {
         std::string filename = el.at("file").to_string();
         std::string format = el.at("format").to_string();
 
+        if (marley::OutputFile::is_standard_output(filename)) {
+          throw marley::Error("Events may be written to the standard output"
+            " only by runs that use a projectile stream");
+        }
+
         std::string mode("overwrite"); // default mode is "overwrite"
         if (el.has_key("mode")) mode = el.at("mode").to_string();
 
@@ -386,15 +850,89 @@ int main(int argc, char* argv[]) {
           }
         }
 
-        #ifdef USE_ROOT
-          if (format == "root") output_files.push_back(
-            std::make_unique<marley::RootOutputFile>(filename, format, mode, force));
-          else output_files.push_back(std::make_unique<marley::TextOutputFile>(
-            filename, format, mode, force, indent));
-        #else
-          output_files.push_back(std::make_unique<marley::TextOutputFile>(filename,
-            format, mode, force, indent));
-        #endif
+        // Settings for compressing the file contents
+        marley::CompressionSettings compression(el);
+        if (format == "root" && compression.enabled()) {
+          throw marley::Error("The \"compression\" setting may not be used"
+            " for the ROOT output file \"" + filename + "\". ROOT files are"
+            " already compressed.");
+        }
+
+        // Virtual output files store only the information needed to
+        // regenerate the events
+        if (format == "virtual") {
+          if (compression.enabled() || el.has_key("shards")
+            || el.has_key("max_events_per_shard")
+            || el.has_key("max_bytes_per_shard"))
+          {
+            throw marley::Error("The compression and sharding settings may"
+              " not be used for the virtual output file \"" + filename
+              + '\"');
+          }
+
+          long events_per_block = get_shard_setting(el, "events_per_block",
+            filename);
+          if (!el.has_key("events_per_block")) events_per_block
+            = marley::VirtualOutputFile::DEFAULT_EVENTS_PER_BLOCK;
+
+          std::vector<std::string> summary_fields;
+          if (el.has_key("summary")) {
+            const auto& summary = el.at("summary");
+            if (!summary.is_array()) throw marley::Error("The \"summary\""
+              " key for the virtual output file \"" + filename + "\" must"
+              " have a value that is a JSON array of field names");
+            for (const auto& field : summary.array_range()) {
+              summary_fields.push_back(field.to_string());
+            }
+          }
+
+          output_files.push_back(std::make_unique<marley::VirtualOutputFile>(
+            filename, mode, force, events_per_block, summary_fields));
+          output_files.back()->set_projection( marley::EventProjection(el) );
+          continue;
+        }
+
+        // Settings for splitting the events among several shard files
+        long num_shards = get_shard_setting(el, "shards", filename);
+        long max_events = get_shard_setting(el, "max_events_per_shard",
+          filename);
+        long max_bytes = get_shard_setting(el, "max_bytes_per_shard",
+          filename);
+
+        if (el.has_key("shards") || max_events > 0 || max_bytes > 0) {
+          if (!el.has_key("shards")) num_shards = 1;
+
+          marley::ShardedOutputFile::ShardFactory factory
+            = [format, force, indent, compression](
+              const std::string& shard_name)
+            -> std::unique_ptr<marley::OutputFile>
+          {
+            #ifdef USE_ROOT
+              if (format == "root") return std::make_unique<
+                marley::RootOutputFile>(shard_name, format, "overwrite", force);
+            #endif
+            return std::make_unique<marley::TextOutputFile>(shard_name,
+              format, "overwrite", force, indent, compression);
+          };
+
+          output_files.push_back(std::make_unique<marley::ShardedOutputFile>(
+            filename, format, mode, force, factory, num_shards, max_events,
+            max_bytes));
+        }
+        else {
+          #ifdef USE_ROOT
+            if (format == "root") output_files.push_back(
+              std::make_unique<marley::RootOutputFile>(filename, format, mode, force));
+            else output_files.push_back(std::make_unique<marley::TextOutputFile>(
+              filename, format, mode, force, indent, compression));
+          #else
+            output_files.push_back(std::make_unique<marley::TextOutputFile>(filename,
+              format, mode, force, indent, compression));
+          #endif
+        }
+
+        // Select the event fields to write (all of them by default)
+        output_files.back()->set_projection( marley::EventProjection(el) );
       }
     }
     else {
@@ -404,6 +942,35 @@ int main(int argc, char* argv[]) {
         "ascii", "overwrite", false));
     }
 
+    // If the user supplied precision targets, the run will end as soon as
+    // they are all met. The requested number of events and the time
+    // limit (if any) then act as upper bounds.
+    marley::StoppingRule stopping_rule;
+    if ( ex_set.has_key("stopping") ) {
+      stopping_rule = marley::StoppingRule( ex_set.at("stopping") );
+    }
+    bool targets_met = false;
+    bool out_of_time = false;
+
+    // Record a timeline of the event generation stages if the user asked
+    // for one
+    std::string trace_file_name;
+    if ( ex_set.has_key("trace") ) {
+      marley::JSON trace_set = ex_set.at( "trace" );
+      if ( !trace_set.is_object() ) throw marley::Error("The \"trace\" key"
+        " in the executable settings must have a value that is a JSON"
+        " object.");
+
+      trace_file_name = trace_set.get_string( "file", "marley_trace.json" );
+      double fraction = trace_set.get_double( "event_fraction", 1. );
+      long max_spans = trace_set.get_long( "max_spans",
+        marley::Tracer::DEFAULT_MAX_SPANS );
+      if ( max_spans <= 0 ) throw marley::Error("The \"max_spans\" value"
+        " for the trace file must be positive");
+
+      marley::Tracer::enable( trace_file_name, fraction, max_spans );
+    }
+
     // This std::unique_ptr to a Generator object will be initialized below
     // with the proper configuration.
     std::unique_ptr<marley::Generator> gen;
@@ -429,6 +996,60 @@ int main(int argc, char* argv[]) {
     if (!need_to_resume) gen = std::make_unique<marley::Generator>(
       jc.create_generator());
 
+    // Decay-only jobs simulate de-excitations of user-specified initial
+    // nuclear states instead of neutrino-nucleus reactions
+    std::unique_ptr<marley::DecayOnlyGenerator> decay_gen;
+    if ( marley::DecayOnlyGenerator::is_requested(json) ) {
+      if ( need_to_resume ) throw marley::Error("Decay-only runs cannot be"
+        " resumed from a previous output file.");
+
+      int num_threads = 0; // Use all available hardware threads by default
+      if ( ex_set.has_key("threads") ) {
+        const auto& threads = ex_set.at( "threads" );
+        bool ok;
+        num_threads = threads.to_long( ok );
+        if ( !ok || num_threads < 0 ) {
+          throw marley::Error( "Invalid value " + threads.dump_string()
+            + " given for the \"threads\" key in the job configuration"
+            " file" );
+        }
+      }
+
+      marley::StartupProfile::Phase phase( "Create decay-only generator" );
+      decay_gen = std::make_unique<marley::DecayOnlyGenerator>( jc,
+        num_threads );
+    }
+
+    // Events written to virtual output files are generated in blocks, each
+    // of which uses its own random number stream
+    long events_per_block = 0;
+    for (const auto& file : output_files) {
+      const auto* vf = dynamic_cast<const marley::VirtualOutputFile*>(
+        file.get() );
+      if ( !vf ) continue;
+      if ( need_to_resume || decay_gen ) throw marley::Error("The virtual"
+        " output file \"" + vf->name() + "\" may not be used for resumed"
+        " or decay-only runs.");
+      // Each block must be reproducible from its own random number stream,
+      // but events change slightly when background tables become ready
+      if ( json.has_key("transmission_tables") ) throw marley::Error("The"
+        " virtual output file \"" + vf->name() + "\" may not be used"
+        " together with transmission coefficient tables.");
+      if ( events_per_block > 0 && vf->events_per_block() != events_per_block )
+      {
+        throw marley::Error("All virtual output files must use the same"
+          " number of events per block");
+      }
+      events_per_block = vf->events_per_block();
+    }
+
+    // Sharded output files save the generator state whenever they roll over
+    // to a new shard, so they need access to the generator
+    for (auto& file : output_files) {
+      auto* sharded = dynamic_cast<marley::ShardedOutputFile*>( file.get() );
+      if ( sharded ) sharded->set_generator( json, *gen );
+    }
+
     // Use the signal handler defined above to deal with
     // SIGINT signals (e.g., ctrl+c interruptions initiated
     // by the user). This will allow us to terminate the
@@ -443,18 +1064,31 @@ int main(int argc, char* argv[]) {
     // Make std::cout use our "status inserter" std::streambuf
     // object so that the status lines get automatically updated
     // with every newline
+    // Background table construction is reported in the status display.
+    // Decay-only runs use the structure databases owned by their workers.
+    const marley::TableBuilder* tables = nullptr;
+    if ( !decay_gen ) tables = gen->get_structure_db().table_builder();
+
     StatusInserter my_status_inserter(cout_default_buf, ev_count,
-      num_events, num_old_events, start_time_point, output_files);
+      num_events, num_old_events, start_time_point, output_files, tables);
     std::cout.rdbuf( &my_status_inserter );
     std::cerr.rdbuf( &my_status_inserter );
 
     // Compute the flux-averaged total cross section for all
-    // enabled reactions
-    double avg_tot_xs = gen->flux_averaged_total_xs(); // MeV^(-2)
+    // enabled reactions. Decay-only runs don't involve any reactions,
+    // so just use zero for them.
+    double avg_tot_xs = 0.; // MeV^(-2)
+    if ( !decay_gen ) {
+      marley::StartupProfile::Phase phase( "Flux-averaged total cross"
+        " section" );
+      avg_tot_xs = gen->flux_averaged_total_xs();
+    }
 
     // Write the flux-averaged total cross section to the output
-    // files (if needed)
+    // files (if needed). Name the systematic weights first so that any
+    // file headers will describe them.
     for (auto& file : output_files) {
+      file->set_weight_names( gen->get_universes().names() );
       file->write_flux_avg_tot_xsec( avg_tot_xs );
     }
 
@@ -464,15 +1098,56 @@ int main(int argc, char* argv[]) {
     start_time_point = std::chrono::system_clock::now();
     start_time = std::chrono::system_clock::to_time_t( start_time_point );
 
-    for (; ev_count <= num_events && !interrupted; ++ev_count) {
+    for (; ev_count <= num_events && !interrupted && !targets_met
+      && !out_of_time; ++ev_count)
+    {
+
+      // Start a new random number stream at the beginning of each block of
+      // events written to virtual output files
+      if ( events_per_block > 0 && (ev_count - 1) % events_per_block == 0 ) {
+        gen->start_event_stream( (ev_count - 1) / events_per_block );
+      }
+
+      // Create an event using the generator object. The first one is
+      // included in the startup profile since some one-time work (e.g.,
+      // finding the maximum of the neutrino energy PDF) is done lazily.
+      {
+        std::unique_ptr<marley::StartupProfile::Phase> first_phase;
+        if ( ev_count == 1 + num_old_events ) first_phase
+          = std::make_unique<marley::StartupProfile::Phase>( "Generate first"
+          " event" );
+
+        if ( decay_gen ) *event = decay_gen->create_event();
+        else *event = gen->create_event();
+      }
 
-      // Create an event using the generator object
-      *event = gen->create_event();
+      if ( ev_count == 1 + num_old_events
+        && marley::StartupProfile::enabled() )
+      {
+        marley::StartupProfile::disable();
+        marley::StartupProfile::write( profile_file_name );
+      }
 
       for (const auto& file : output_files) {
+        marley::Tracer::Span span( "OutputFile::write_event" );
         file->write_event(event.get());
       }
 
+      // Update the precision estimates and periodically check whether
+      // the run is finished
+      if ( !stopping_rule.empty() ) {
+        stopping_rule.add_event( *event );
+        if ( (ev_count - num_old_events) % stopping_rule.check_interval()
+          == 0 )
+        {
+          targets_met = stopping_rule.targets_met();
+          double elapsed = std::chrono::duration<double>(
+            std::chrono::system_clock::now() - start_time_point ).count();
+          double max_time = stopping_rule.max_time();
+          out_of_time = ( max_time > 0. && elapsed >= max_time );
+        }
+      }
+
       // Print status messages about simulation progress after every
       // status_update_interval events have been generated
       if ( (ev_count - num_old_events) % status_update_interval == 1
@@ -485,7 +1160,7 @@ int main(int argc, char* argv[]) {
 
         // Print a status message showing the current number of events
         std::cout << makeStatusLines(ev_count, num_events, num_old_events,
-          start_time_point, output_files);
+          start_time_point, output_files, tables);
 
         // Re-enable the auto-printing of the status lines now that we've
         // printed them manually
@@ -506,6 +1181,65 @@ int main(int argc, char* argv[]) {
         << "\033[K\n";
     }
 
+    // Report how often primary events passed the cuts (if any were used)
+    if ( !decay_gen && !gen->get_primary_filter().empty() ) {
+      long sampled = gen->primary_events_sampled();
+      long accepted = gen->primary_events_accepted();
+      MARLEY_LOG_INFO() << "Primary event cuts accepted " << accepted
+        << " of " << sampled << " sampled events (estimated efficiency "
+        << gen->cut_efficiency() << ')';
+    }
+
+    // Report the precision achieved for the user's targets
+    if ( !stopping_rule.empty() ) {
+      if ( targets_met ) MARLEY_LOG_INFO() << "All precision targets were"
+        << " met";
+      else if ( out_of_time ) MARLEY_LOG_INFO() << "The time limit of "
+        << stopping_rule.max_time() << " s was reached before all precision"
+        << " targets were met";
+      MARLEY_LOG_INFO() << stopping_rule.summary();
+    }
+
+    // Report how much scratch memory the de-excitation cascades used on all
+    // threads
+    size_t arena_threads = 0u;
+    auto arena_stats = marley::Arena::combined_statistics( &arena_threads );
+    if ( arena_stats.resets > 0 ) {
+      MARLEY_LOG_INFO() << "Cascade memory arenas (" << arena_threads
+        << ( arena_threads == 1u ? " thread): " : " threads): " )
+        << arena_stats.resets << " cascades, "
+        << marley_utils::num_bytes_to_string( arena_stats.bytes_per_reset() )
+        << " per cascade, " << marley_utils::num_bytes_to_string(
+        arena_stats.peak_bytes ) << " peak, "
+        << marley_utils::num_bytes_to_string( arena_stats.capacity )
+        << " reserved";
+    }
+
+    // Summarize the outcomes of a decay-only run
+    if ( decay_gen ) {
+      std::ostringstream br_oss;
+      decay_gen->print_branching_ratios( br_oss );
+      MARLEY_LOG_INFO() << br_oss.str();
+    }
+
+    // Show the startup profile (it was written to the output file right
+    // after the first event)
+    if ( !profile_file_name.empty() ) {
+      std::ostringstream profile_oss;
+      marley::StartupProfile::print( profile_oss );
+      MARLEY_LOG_INFO() << "Startup profile:\n" << profile_oss.str();
+      MARLEY_LOG_INFO() << "Wrote the startup profile to \""
+        << profile_file_name << '\"';
+    }
+
+    // Write the timeline trace once any worker threads have stopped
+    if ( marley::Tracer::enabled() ) {
+      decay_gen.reset();
+      size_t num_spans = marley::Tracer::write();
+      MARLEY_LOG_INFO() << "Wrote " << num_spans << " spans to the trace"
+        << " file \"" << trace_file_name << '\"';
+    }
+
     // Display the time that the program terminated
     std::chrono::system_clock::time_point end_time_point
       = std::chrono::system_clock::now();
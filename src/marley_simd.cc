@@ -0,0 +1,327 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#include <atomic>
+#include <cstdlib>
+
+#include "marley/Error.hh"
+#include "marley/marley_simd.hh"
+
+// The vectorized kernels use compiler intrinsics together with function
+// attributes that enable the needed instruction set extensions for just those
+// functions. The rest of the library is still compiled for the baseline
+// architecture.
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+  #define MARLEY_SIMD_X86
+  #include <immintrin.h>
+#endif
+
+// Only the barycentric sums used by ChebyshevInterpolatingFunction are
+// dispatched here. The other hot loops are deliberately left alone:
+//   - The Numerov recurrences used for the optical model transmission
+//     coefficients are sequential in the radial step, and each partial
+//     wave depends on the previous one.
+//   - The batch InterpolationGrid::interpolate() loops are simple enough for
+//     the compiler to vectorize at the baseline architecture.
+//   - The functions in marley_kinematics act on one particle at a time, and
+//     no batch kinematics path exists to vectorize.
+//   - Random numbers are drawn one at a time in a data-dependent order.
+//     Filling buffers ahead of time would change the generated events.
+//   - The time spent in batch Generator::total_xs() calls is dominated by
+//     scalar work (Coulomb corrections and kinematics) done separately for
+//     each energy.
+
+// Fused multiply-add contractions would make the results depend on which
+// parts of a kernel are vectorized, so they are disabled in this file
+#if defined(__GNUC__) && !defined(__clang__)
+  #pragma GCC optimize ("fp-contract=off")
+#endif
+
+using Level = marley_simd::Level;
+
+namespace {
+
+  using BarycentricKernel = size_t (*)( const double*, const double*,
+    const double*, size_t, double, double&, double& );
+
+  // Sums the terms sequentially, in the same order as the scalar loop used
+  // by MARLEY before the vectorized kernels were added
+  size_t barycentric_generic( const double* xs, const double* ws,
+    const double* fs, size_t n, double x, double& numer, double& denom )
+  {
+    numer = 0.;
+    denom = 0.;
+    for ( size_t j = 0u; j < n; ++j ) {
+      if ( xs[j] == x ) return j;
+      double t = ws[j] / ( x - xs[j] );
+      denom += t;
+      numer += t * fs[j];
+    }
+    return n;
+  }
+
+  #ifdef MARLEY_SIMD_X86
+
+  // Number of partial sums used by the vectorized barycentric kernels. Term
+  // j is always added to partial sum j % LANES, and the partial sums are
+  // combined in a fixed order at the end. This makes all of the vectorized
+  // variants produce identical results. The order differs from the single
+  // sequential sum used by the generic kernel, so the last few bits of an
+  // interpolated value may differ between the two. Adding the terms
+  // sequentially in the vectorized kernels makes the loop latency-bound,
+  // which removes nearly all of the speedup (about 2.3x with AVX2 for 65 to
+  // 257 grid points).
+  constexpr size_t LANES = 8u;
+
+  // Handles the terms left over after the vectorized loop (if any), then
+  // combines the partial sums
+  size_t finish_barycentric( const double* xs, const double* ws,
+    const double* fs, size_t n, double x, size_t j, double* num_lanes,
+    double* den_lanes, bool match, double& numer, double& denom )
+  {
+    for ( ; j < n; ++j ) {
+      if ( xs[j] == x ) match = true;
+      double t = ws[j] / ( x - xs[j] );
+      double tf = t * fs[j];
+      den_lanes[ j % LANES ] += t;
+      num_lanes[ j % LANES ] += tf;
+    }
+
+    if ( match ) {
+      for ( size_t k = 0u; k < n; ++k ) if ( xs[k] == x ) return k;
+    }
+
+    numer = 0.;
+    denom = 0.;
+    for ( size_t l = 0u; l < LANES; ++l ) {
+      numer += num_lanes[l];
+      denom += den_lanes[l];
+    }
+    return n;
+  }
+
+  __attribute__(( target("sse4.2") ))
+  size_t barycentric_sse42( const double* xs, const double* ws,
+    const double* fs, size_t n, double x, double& numer, double& denom )
+  {
+    constexpr size_t W = 2u; // doubles per register
+    __m128d vx = _mm_set1_pd( x );
+    __m128d num[ LANES / W ], den[ LANES / W ];
+    __m128d eq = _mm_setzero_pd();
+    for ( size_t r = 0u; r < LANES / W; ++r ) {
+      num[r] = _mm_setzero_pd();
+      den[r] = _mm_setzero_pd();
+    }
+
+    size_t j = 0u;
+    for ( ; j + LANES <= n; j += LANES ) {
+      for ( size_t r = 0u; r < LANES / W; ++r ) {
+        __m128d vxj = _mm_loadu_pd( xs + j + W*r );
+        eq = _mm_or_pd( eq, _mm_cmpeq_pd(vxj, vx) );
+        __m128d t = _mm_div_pd( _mm_loadu_pd(ws + j + W*r),
+          _mm_sub_pd(vx, vxj) );
+        den[r] = _mm_add_pd( den[r], t );
+        num[r] = _mm_add_pd( num[r],
+          _mm_mul_pd(t, _mm_loadu_pd(fs + j + W*r)) );
+      }
+    }
+
+    double num_lanes[ LANES ], den_lanes[ LANES ];
+    for ( size_t r = 0u; r < LANES / W; ++r ) {
+      _mm_storeu_pd( num_lanes + W*r, num[r] );
+      _mm_storeu_pd( den_lanes + W*r, den[r] );
+    }
+    bool match = _mm_movemask_pd( eq ) != 0;
+
+    return finish_barycentric( xs, ws, fs, n, x, j, num_lanes, den_lanes,
+      match, numer, denom );
+  }
+
+  __attribute__(( target("avx2") ))
+  size_t barycentric_avx2( const double* xs, const double* ws,
+    const double* fs, size_t n, double x, double& numer, double& denom )
+  {
+    constexpr size_t W = 4u; // doubles per register
+    __m256d vx = _mm256_set1_pd( x );
+    __m256d num[ LANES / W ], den[ LANES / W ];
+    __m256d eq = _mm256_setzero_pd();
+    for ( size_t r = 0u; r < LANES / W; ++r ) {
+      num[r] = _mm256_setzero_pd();
+      den[r] = _mm256_setzero_pd();
+    }
+
+    size_t j = 0u;
+    for ( ; j + LANES <= n; j += LANES ) {
+      for ( size_t r = 0u; r < LANES / W; ++r ) {
+        __m256d vxj = _mm256_loadu_pd( xs + j + W*r );
+        eq = _mm256_or_pd( eq, _mm256_cmp_pd(vxj, vx, _CMP_EQ_OQ) );
+        __m256d t = _mm256_div_pd( _mm256_loadu_pd(ws + j + W*r),
+          _mm256_sub_pd(vx, vxj) );
+        den[r] = _mm256_add_pd( den[r], t );
+        num[r] = _mm256_add_pd( num[r],
+          _mm256_mul_pd(t, _mm256_loadu_pd(fs + j + W*r)) );
+      }
+    }
+
+    double num_lanes[ LANES ], den_lanes[ LANES ];
+    for ( size_t r = 0u; r < LANES / W; ++r ) {
+      _mm256_storeu_pd( num_lanes + W*r, num[r] );
+      _mm256_storeu_pd( den_lanes + W*r, den[r] );
+    }
+    bool match = _mm256_movemask_pd( eq ) != 0;
+
+    // Avoid AVX-SSE transition penalties in the (non-VEX) scalar code
+    _mm256_zeroupper();
+
+    return finish_barycentric( xs, ws, fs, n, x, j, num_lanes, den_lanes,
+      match, numer, denom );
+  }
+
+  __attribute__(( target("avx512f") ))
+  size_t barycentric_avx512( const double* xs, const double* ws,
+    const double* fs, size_t n, double x, double& numer, double& denom )
+  {
+    static_assert( LANES == 8u, "The AVX-512 barycentric kernel assumes"
+      " eight partial sums" );
+
+    __m512d vx = _mm512_set1_pd( x );
+    __m512d num = _mm512_setzero_pd();
+    __m512d den = _mm512_setzero_pd();
+    __mmask8 eq = 0;
+
+    size_t j = 0u;
+    for ( ; j + LANES <= n; j += LANES ) {
+      __m512d vxj = _mm512_loadu_pd( xs + j );
+      eq |= _mm512_cmp_pd_mask( vxj, vx, _CMP_EQ_OQ );
+      __m512d t = _mm512_div_pd( _mm512_loadu_pd(ws + j),
+        _mm512_sub_pd(vx, vxj) );
+      den = _mm512_add_pd( den, t );
+      num = _mm512_add_pd( num, _mm512_mul_pd(t, _mm512_loadu_pd(fs + j)) );
+    }
+
+    double num_lanes[ LANES ], den_lanes[ LANES ];
+    _mm512_storeu_pd( num_lanes, num );
+    _mm512_storeu_pd( den_lanes, den );
+    _mm256_zeroupper();
+
+    return finish_barycentric( xs, ws, fs, n, x, j, num_lanes, den_lanes,
+      eq != 0, numer, denom );
+  }
+
+  #endif
+
+  BarycentricKernel barycentric_kernel( Level level ) {
+    #ifdef MARLEY_SIMD_X86
+    switch ( level ) {
+      case Level::AVX512: return barycentric_avx512;
+      case Level::AVX2: return barycentric_avx2;
+      case Level::SSE4_2: return barycentric_sse42;
+      default: break;
+    }
+    #endif
+    return barycentric_generic;
+  }
+
+  bool level_supported( Level level ) {
+    #ifdef MARLEY_SIMD_X86
+    __builtin_cpu_init();
+    switch ( level ) {
+      case Level::AVX512: return __builtin_cpu_supports( "avx512f" );
+      case Level::AVX2: return __builtin_cpu_supports( "avx2" );
+      case Level::SSE4_2: return __builtin_cpu_supports( "sse4.2" );
+      default: break;
+    }
+    #endif
+    return level == Level::GENERIC;
+  }
+
+  // Kernels selected for the active Level. A null pointer indicates that
+  // no selection has been made yet.
+  std::atomic<int> active_level_index( -1 );
+  std::atomic<BarycentricKernel> active_barycentric( nullptr );
+
+  void select_level( Level level ) {
+    active_barycentric.store( barycentric_kernel(level) );
+    active_level_index.store( static_cast<int>(level) );
+  }
+
+  // Chooses the Level to use when none has been selected yet. The generic
+  // kernel is the default so that results do not change unless the
+  // vectorized kernels are requested.
+  void select_initial_level() {
+    const char* env = std::getenv( "MARLEY_SIMD" );
+    if ( env && *env ) marley_simd::set_level(
+      marley_simd::level_from_name(env) );
+    else select_level( Level::GENERIC );
+  }
+
+}
+
+Level marley_simd::detected_level() {
+  static const Level detected = []() {
+    for ( Level level : { Level::AVX512, Level::AVX2, Level::SSE4_2 } ) {
+      if ( level_supported(level) ) return level;
+    }
+    return Level::GENERIC;
+  }();
+  return detected;
+}
+
+Level marley_simd::active_level() {
+  if ( active_level_index.load() < 0 ) select_initial_level();
+  return static_cast<Level>( active_level_index.load() );
+}
+
+void marley_simd::set_level( Level level ) {
+  if ( !level_supported(level) ) throw marley::Error( "The "
+    + level_name(level) + " instruction set extensions are not supported"
+    " on this machine" );
+  select_level( level );
+}
+
+std::string marley_simd::level_name( Level level ) {
+  switch ( level ) {
+    case Level::AVX512: return "avx512";
+    case Level::AVX2: return "avx2";
+    case Level::SSE4_2: return "sse4.2";
+    default: return "generic";
+  }
+}
+
+Level marley_simd::level_from_name( const std::string& name ) {
+  if ( name == "native" ) return detected_level();
+  for ( Level level : { Level::GENERIC, Level::SSE4_2, Level::AVX2,
+    Level::AVX512 } )
+  {
+    if ( name == level_name(level) ) return level;
+  }
+  throw marley::Error( "Unrecognized SIMD level \"" + name + "\". Valid"
+    " choices are \"generic\", \"sse4.2\", \"avx2\", \"avx512\", and"
+    " \"native\"." );
+}
+
+size_t marley_simd::barycentric_sums( const double* xs, const double* ws,
+  const double* fs, size_t n, double x, double& numer, double& denom )
+{
+  BarycentricKernel kernel = active_barycentric.load(
+    std::memory_order_relaxed );
+  if ( !kernel ) {
+    select_initial_level();
+    kernel = active_barycentric.load();
+  }
+  return kernel( xs, ws, fs, n, x, numer, denom );
+}
@@ -19,11 +19,14 @@
 #include <cfloat>
 #include <cmath>
 #include <complex>
+#include <cstdint>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <map>
 #include <random>
 #include <regex>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -431,6 +434,31 @@ std::string marley_utils::get_file_contents(std::string filename) {
   throw marley::Error("Could not read from file " + filename);
 }
 
+std::string marley_utils::file_checksum(const std::string& filename) {
+
+  std::ifstream in( filename, std::ios::in | std::ios::binary );
+  if ( !in ) throw marley::Error("Could not read from file " + filename);
+
+  // Hash the file contents in chunks using the 64-bit FNV-1a algorithm
+  constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+  constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+  uint64_t hash = FNV_OFFSET_BASIS;
+
+  std::vector<char> buffer( 1 << 16 );
+  while ( in ) {
+    in.read( buffer.data(), buffer.size() );
+    std::streamsize count = in.gcount();
+    for ( std::streamsize i = 0; i < count; ++i ) {
+      hash ^= static_cast<unsigned char>( buffer[i] );
+      hash *= FNV_PRIME;
+    }
+  }
+
+  std::ostringstream oss;
+  oss << std::hex << std::setfill('0') << std::setw(16) << hash;
+  return oss.str();
+}
+
 // Advance to the next line of an ifstream that either matches (match == true)
 // or does not match (match == false) a given regular expression
 std::string marley_utils::get_next_line(std::ifstream &file_in,
@@ -0,0 +1,118 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Arena.hh"
+#include "marley/ChebyshevInterpolatingFunction.hh"
+
+TEST_CASE( "Arena allocations are aligned and recycled on reset", "[arena]" )
+{
+  marley::Arena arena( 64 );
+
+  std::vector<void*> ptrs;
+  for ( size_t b = 1; b < 200; b += 7 ) {
+    void* p = arena.allocate( b );
+    REQUIRE( reinterpret_cast<std::uintptr_t>(p)
+      % alignof(std::max_align_t) == 0u );
+    REQUIRE( arena.owns(p) );
+    ptrs.push_back( p );
+  }
+
+  // Live allocations prevent a reset
+  CHECK_FALSE( arena.reset() );
+
+  for ( void* p : ptrs ) arena.deallocate( p );
+  CHECK( arena.reset() );
+
+  // After a reset, the chunks are coalesced so that the same pattern of
+  // allocations fits without growing the arena
+  size_t capacity = arena.statistics().capacity;
+  for ( size_t b = 1; b < 200; b += 7 ) arena.deallocate( arena.allocate(b) );
+  CHECK( arena.statistics().capacity == capacity );
+  CHECK( arena.reset() );
+  CHECK( arena.statistics().resets == 2 );
+
+  int on_stack = 0;
+  CHECK_FALSE( arena.owns(&on_stack) );
+}
+
+TEST_CASE( "ArenaAllocator only uses the arena inside a scope", "[arena]" )
+{
+  auto& arena = marley::Arena::thread_arena();
+  REQUIRE_FALSE( marley::Arena::scope_active() );
+
+  std::vector<double, marley::ArenaAllocator<double> > heap_vec( 10, 1. );
+  CHECK_FALSE( arena.owns(heap_vec.data()) );
+
+  {
+    marley::Arena::Scope scope;
+    std::vector<double, marley::ArenaAllocator<double> > arena_vec( 10, 2. );
+    CHECK( arena.owns(arena_vec.data()) );
+
+    // Inactive scopes have no effect
+    marley::Arena::Scope inactive( false );
+    CHECK( marley::Arena::scope_active() );
+  }
+
+  CHECK_FALSE( marley::Arena::scope_active() );
+  CHECK( arena.reset() );
+}
+
+TEST_CASE( "Thread arena statistics are combined across threads", "[arena]" )
+{
+  size_t threads_before = 0u;
+  auto before = marley::Arena::combined_statistics( &threads_before );
+
+  // Chebyshev approximations built inside a scope keep their grids in the
+  // arena of the thread that built them
+  constexpr int NUM_CYCLES = 3;
+  bool in_arena = false;
+  std::thread worker( [&in_arena]() {
+    auto& arena = marley::Arena::thread_arena();
+    for ( int c = 0; c < NUM_CYCLES; ++c ) {
+      {
+        marley::Arena::Scope scope;
+        auto cheb = std::make_unique<marley::ChebyshevInterpolatingFunction>(
+          [](double x) -> double { return std::exp(x); }, 0., 1., 16 );
+        in_arena = arena.owns( cheb.get() )
+          && arena.owns( cheb->Xs().data() );
+      }
+      arena.reset();
+    }
+  } );
+  worker.join();
+
+  CHECK( in_arena );
+
+  // The worker has exited, but its statistics are still included
+  size_t threads_after = 0u;
+  auto after = marley::Arena::combined_statistics( &threads_after );
+  CHECK( threads_after == threads_before + 1u );
+  CHECK( after.resets == before.resets + NUM_CYCLES );
+  CHECK( after.total_bytes > before.total_bytes );
+  CHECK( after.capacity > before.capacity );
+}
@@ -0,0 +1,82 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+
+// Standard library includes
+#include <cmath>
+#include <map>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Event.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/marley_utils.hh"
+
+TEST_CASE( "Composite sources sample neutrino types jointly with energies",
+  "[composite]" )
+{
+  constexpr int NUM_EVENTS = 3000;
+
+  marley::JSON config = marley::JSON::load( "{\"seed\": 321,"
+    " \"reactions\": [\"ve40ArCC_Bhattacharya2009.react\", \"ES.react\"],"
+    " \"source\": {\"type\": \"composite\", \"components\": ["
+    " {\"type\": \"fermi-dirac\", \"neutrino\": \"ve\", \"Emin\": 0,"
+    " \"Emax\": 50, \"temperature\": 3.5},"
+    " {\"weight\": 3, \"type\": \"fermi-dirac\", \"neutrino\": \"vu\","
+    " \"Emin\": 0, \"Emax\": 50, \"temperature\": 6}]}}" );
+
+  marley::JSONConfig jc( config );
+  marley::Generator gen = jc.create_generator();
+
+  const auto& source = gen.get_source();
+  REQUIRE( source.get_pids().size() == 2u );
+
+  // The flavor components should add up to the full spectrum and total
+  // cross section
+  for ( double E : { 5., 12.5, 30. } ) {
+    CHECK( source.flavor_pdf(marley_utils::ELECTRON_NEUTRINO, E)
+      + source.flavor_pdf(marley_utils::MUON_NEUTRINO, E)
+      == Approx(source.pdf(E)) );
+  }
+
+  double total_xs = gen.flux_averaged_total_xs();
+  std::map<int, double> fractions;
+  double sum = 0.;
+  for ( int pdg : source.get_pids() ) {
+    fractions[ pdg ] = gen.flux_averaged_total_xs( pdg ) / total_xs;
+    sum += fractions.at( pdg );
+  }
+  CHECK( sum == Approx(1.).epsilon(1e-4) );
+
+  // The fraction of events initiated by each neutrino type should agree with
+  // the expectation within statistical errors
+  std::map<int, int> counts;
+  for ( int e = 0; e < NUM_EVENTS; ++e ) {
+    marley::Event ev = gen.create_event();
+    ++counts[ ev.projectile().pdg_code() ];
+  }
+
+  for ( const auto& pair : fractions ) {
+    double expected = pair.second * NUM_EVENTS;
+    double sigma = std::sqrt( expected * (1. - pair.second) );
+    CHECK( std::abs(counts[pair.first] - expected) < 5.*sigma );
+  }
+}
@@ -0,0 +1,81 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Compression.hh"
+#include "marley/JSON.hh"
+
+TEST_CASE( "Block-compressed files can be read back and seeked", "[io]" )
+{
+  if ( !marley::CompressionSettings::available() ) return;
+
+  const std::string file_name( "marley_compression_test.gz" );
+
+  // Use small blocks so that the file contains many of them
+  marley::CompressionSettings settings( marley::JSON::load(
+    "{\"compression\": \"gzip\", \"compression_block_size\": 1000,"
+    " \"compression_threads\": 3}") );
+  REQUIRE( settings.enabled() );
+
+  std::ostringstream expected;
+  {
+    std::ofstream out( file_name, std::ios::out | std::ios::binary );
+    marley::GzipOutputBuffer buf( out, settings );
+    std::ostream gz_out( &buf );
+    for ( int i = 0; i < 5000; ++i ) {
+      gz_out << "record " << i << '\n';
+      expected << "record " << i << '\n';
+      buf.end_record();
+    }
+    buf.finish();
+  }
+
+  REQUIRE( marley::GzipInputBuffer::is_gzip_file(file_name) );
+
+  const std::string& text = expected.str();
+
+  marley::GzipInputBuffer buf( file_name, 2 );
+  std::istream in( &buf );
+  std::ostringstream contents;
+  contents << in.rdbuf();
+  CHECK( contents.str() == text );
+
+  // Seek backward and forward across block boundaries
+  for ( size_t pos : { size_t(40000), size_t(17), size_t(0), text.size() - 5 } )
+  {
+    in.clear();
+    in.seekg( pos );
+    REQUIRE( in );
+    CHECK( static_cast<size_t>(in.tellg()) == pos );
+    std::string word;
+    in >> word;
+    std::istringstream expected_in( text.substr(pos) );
+    std::string expected_word;
+    expected_in >> expected_word;
+    CHECK( word == expected_word );
+  }
+
+  std::remove( file_name.c_str() );
+}
@@ -0,0 +1,103 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#ifdef USE_ROOT
+  #include "marley/RootJSONConfig.hh"
+#else
+  #include "marley/JSONConfig.hh"
+#endif
+#include "marley/DecayOnlyGenerator.hh"
+#include "marley/Event.hh"
+#include "marley/JSON.hh"
+
+namespace {
+
+  std::vector<std::string> make_events( const marley::JSON& config,
+    int num_threads, int num_events, long& total_count )
+  {
+    #ifdef USE_ROOT
+      marley::RootJSONConfig jc( config );
+    #else
+      marley::JSONConfig jc( config );
+    #endif
+
+    marley::DecayOnlyGenerator dg( jc, num_threads );
+
+    std::vector<std::string> events;
+    for ( int e = 0; e < num_events; ++e ) {
+      marley::Event ev = dg.create_event();
+
+      // The target is the initial excited nucleus. Its energy should be
+      // shared among the final-state particles (neglecting the dummy
+      // ejectile).
+      double E_final = 0.;
+      const auto& finals = ev.get_final_particles();
+      for ( size_t i = 1; i < finals.size(); ++i ) {
+        E_final += finals.at( i )->total_energy();
+      }
+      CHECK( E_final == Approx(ev.target().total_energy()).epsilon(1e-8) );
+
+      std::ostringstream temp;
+      temp << ev;
+      events.push_back( temp.str() );
+    }
+
+    total_count = 0;
+    for ( const auto& pair : dg.channel_counts() ) total_count += pair.second;
+
+    return events;
+  }
+
+}
+
+TEST_CASE( "Decay-only runs are reproducible", "[decay]" )
+{
+  // Unbound 40K, plus a state just below 1 MeV that should be moved to
+  // the closest discrete level
+  marley::JSON config = marley::JSON::load( "{\"seed\": 123,"
+    " \"initial_states\": ["
+    " {\"nuclide\": 1000190400, \"Ex\": 15.0, \"twoJ\": 2, \"parity\": \"+\"},"
+    " {\"nuclide\": 1000190400, \"Ex\": [0.75, 0.85], \"twoJ\": 2,"
+    " \"parity\": -1, \"weight\": 0.5}]}" );
+
+  constexpr int NUM_EVENTS = 200;
+  long count1 = 0, count2 = 0;
+
+  auto events1 = make_events( config, 2, NUM_EVENTS, count1 );
+  auto events2 = make_events( config, 2, NUM_EVENTS, count2 );
+
+  CHECK( events1 == events2 );
+  CHECK( count1 == NUM_EVENTS );
+  CHECK( count2 == NUM_EVENTS );
+
+  // The single-threaded mode produces the same events as the first worker
+  // thread of a multithreaded run
+  long count3 = 0;
+  auto events3 = make_events( config, 1, NUM_EVENTS / 2, count3 );
+  for ( int e = 0; e < NUM_EVENTS / 2; ++e ) {
+    CHECK( events3.at(e) == events1.at(2*e) );
+  }
+}
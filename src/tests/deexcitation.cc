@@ -0,0 +1,137 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#ifdef USE_ROOT
+  #include "marley/RootJSONConfig.hh"
+#else
+  #include "marley/JSONConfig.hh"
+#endif
+#include "marley/Event.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+
+namespace {
+
+  marley::Generator make_generator( const std::string& extra_config ) {
+    marley::JSON config = marley::JSON::load( "{\"seed\": 123,"
+      " \"reactions\": [\"ve40ArCC_Bhattacharya2009.react\"],"
+      " \"source\": {\"type\": \"monoenergetic\", \"neutrino\": \"ve\","
+      " \"energy\": 15.0}" + extra_config + "}" );
+
+    #ifdef USE_ROOT
+      marley::RootJSONConfig jc( config );
+    #else
+      marley::JSONConfig jc( config );
+    #endif
+
+    return jc.create_generator();
+  }
+
+  std::string to_string( const marley::Event& ev ) {
+    std::ostringstream temp;
+    temp << ev;
+    return temp.str();
+  }
+
+}
+
+TEST_CASE( "Deferred de-excitations reproduce the full events",
+  "[deexcitation]" )
+{
+  constexpr double KE_MIN = 8.; // MeV
+  constexpr int NUM_EVENTS = 200;
+
+  const std::string cuts = ", \"primary_cuts\":"
+    " {\"ejectile_KE\": [8.0, null], \"pilot_events\": 2000}";
+  marley::Generator full_gen = make_generator( "" );
+  marley::Generator cut_gen = make_generator( cuts );
+  marley::Generator ref_gen = make_generator( cuts );
+
+  double eff = cut_gen.cut_efficiency();
+  CHECK( eff > 0. );
+  CHECK( eff < 1. );
+  CHECK( cut_gen.flux_averaged_total_xs()
+    == Approx(eff * full_gen.flux_averaged_total_xs()) );
+
+  // Complete events from an identically configured generator
+  std::vector<std::string> expected;
+  for ( int e = 0; e < NUM_EVENTS; ++e ) {
+    marley::Event ev = ref_gen.create_event();
+    CHECK( !ev.deexcitation_pending() );
+    CHECK( ev.ejectile().kinetic_energy() >= KE_MIN );
+    expected.push_back( to_string(ev) );
+  }
+
+  // Create all of the primary events first, then de-excite them in reverse
+  // order. The results should not depend on when the de-excitations are
+  // simulated.
+  std::vector<marley::Event> primaries;
+  for ( size_t e = 0; e < expected.size(); ++e ) {
+    primaries.push_back( cut_gen.create_primary_event() );
+    CHECK( primaries.back().ejectile().kinetic_energy() >= KE_MIN );
+  }
+  CHECK( cut_gen.primary_events_sampled()
+    == ref_gen.primary_events_sampled() );
+  CHECK( cut_gen.primary_events_sampled() > NUM_EVENTS );
+  CHECK( cut_gen.primary_events_accepted()
+    == static_cast<long>(expected.size()) );
+
+  for ( auto iter = primaries.rbegin(); iter != primaries.rend(); ++iter ) {
+    cut_gen.resolve_deexcitation( *iter );
+    CHECK( !iter->deexcitation_pending() );
+  }
+
+  for ( size_t e = 0; e < expected.size(); ++e ) {
+    CHECK( to_string(primaries.at(e)) == expected.at(e) );
+  }
+}
+
+TEST_CASE( "Cuts select the events from a run without cuts when"
+  " de-excitations are disabled", "[deexcitation]" )
+{
+  constexpr double KE_MIN = 8.; // MeV
+  constexpr int NUM_EVENTS = 200;
+
+  // With de-excitations enabled, the cascade for an accepted event uses its
+  // own random number sub-stream, so only the primary events can be
+  // compared with a run without cuts
+  const std::string no_deex = ", \"do_deexcitations\": false";
+  marley::Generator full_gen = make_generator( no_deex );
+  marley::Generator cut_gen = make_generator( no_deex + ", \"primary_cuts\":"
+    " {\"ejectile_KE\": [8.0, null], \"pilot_events\": 2000}" );
+
+  int sampled = 0;
+  for ( int e = 0; e < NUM_EVENTS; ++e ) {
+    marley::Event full_ev;
+    do {
+      full_ev = full_gen.create_event();
+      ++sampled;
+    } while ( full_ev.ejectile().kinetic_energy() < KE_MIN );
+
+    CHECK( to_string(cut_gen.create_event()) == to_string(full_ev) );
+  }
+  CHECK( cut_gen.primary_events_sampled() == sampled );
+}
@@ -0,0 +1,225 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Event.hh"
+#include "marley/FlatSummaryWriter.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/OutputFile.hh"
+#include "marley/Particle.hh"
+
+#ifdef USE_ROOT
+  #include "marley/RootJSONConfig.hh"
+#else
+  #include "marley/JSONConfig.hh"
+#endif
+
+namespace {
+
+  template <typename T> T read_value( const std::string& data,
+    size_t offset )
+  {
+    T value;
+    REQUIRE( offset + sizeof(T) <= data.size() );
+    std::memcpy( &value, data.data() + offset, sizeof(T) );
+    return value;
+  }
+
+  size_t column_index( const std::vector<std::string>& names,
+    const std::string& name )
+  {
+    auto iter = std::find( names.cbegin(), names.cend(), name );
+    REQUIRE( iter != names.cend() );
+    return std::distance( names.cbegin(), iter );
+  }
+
+}
+
+TEST_CASE( "Flat summaries keep the input order across blocks", "[io]" )
+{
+  marley::JSON config = marley::JSON::load( "{\"seed\": 321,"
+    " \"reactions\": [\"ve40ArCC_Bhattacharya2009.react\"],"
+    " \"source\": {\"type\": \"monoenergetic\", \"neutrino\": \"ve\","
+    " \"energy\": 20.0}}" );
+
+  #ifdef USE_ROOT
+    marley::RootJSONConfig jc( config );
+  #else
+    marley::JSONConfig jc( config );
+  #endif
+
+  marley::Generator gen = jc.create_generator();
+
+  // Two event files that each span several blocks, followed by one that
+  // does not exist
+  const std::vector<std::string> input_files = { "marley_flat_test_1.ascii",
+    "marley_flat_test_2.ascii", "marley_flat_test_missing.ascii" };
+  const std::vector<int> file_events = { 7, 5 };
+  constexpr size_t EVENTS_PER_BLOCK = 3u;
+
+  std::vector<marley::Event> events;
+  for ( size_t f = 0u; f < file_events.size(); ++f ) {
+    marley::TextOutputFile out( input_files.at(f), "ascii", "overwrite",
+      true );
+    out.write_flux_avg_tot_xsec( gen.flux_averaged_total_xs() );
+    for ( int e = 0; e < file_events.at(f); ++e ) {
+      events.push_back( gen.create_event() );
+      out.write_event( &events.back() );
+    }
+    out.close( config, gen, file_events.at(f) );
+  }
+
+  std::ostringstream out;
+  std::ostringstream csv;
+  marley::FlatSummaryWriter writer( input_files, 2, EVENTS_PER_BLOCK );
+  CHECK( writer.write(out, &csv) == events.size() );
+
+  const auto& results = writer.file_results();
+  REQUIRE( results.size() == input_files.size() );
+  CHECK( results.at(0).num_events == 7u );
+  CHECK( results.at(0).error.empty() );
+  CHECK( results.at(1).num_events == 5u );
+  CHECK( results.at(1).error.empty() );
+  CHECK( results.at(2).num_events == 0u );
+  CHECK( !results.at(2).error.empty() );
+
+  // Check the magic strings and read the footer
+  const std::string data = out.str();
+  REQUIRE( data.size() > 24u );
+  CHECK( data.substr(0, 8) == "MARFLAT1" );
+  CHECK( data.substr(data.size() - 8) == "MARFLAT1" );
+  uint64_t footer_size = read_value<uint64_t>( data, data.size() - 16 );
+  REQUIRE( footer_size < data.size() - 24u );
+  marley::JSON footer = marley::JSON::load( data.substr(data.size() - 16
+    - footer_size, footer_size) );
+  CHECK( footer.at("num_events").to_long() == 12 );
+
+  // Blocks never span two input files
+  const std::vector<uint64_t> expected_block_events = { 3, 3, 1, 3, 2 };
+  const auto& blocks = footer.at( "blocks" );
+  REQUIRE( blocks.length() == expected_block_events.size() );
+
+  const auto& columns = footer.at( "columns" );
+  std::vector<std::string> names;
+  for ( const auto& col : columns.array_range() ) {
+    names.push_back( col.at("name").to_string() );
+  }
+
+  size_t event_index = 0u;
+  uint64_t expected_offset = 8u;
+  for ( size_t b = 0u; b < expected_block_events.size(); ++b ) {
+    const auto& block = blocks.at( b );
+    uint64_t offset = block.at( "offset" ).to_long();
+    CHECK( offset == expected_offset );
+    expected_offset += block.at( "size" ).to_long();
+
+    uint64_t num_events = read_value<uint64_t>( data, offset );
+    uint64_t num_products = read_value<uint64_t>( data, offset + 8 );
+    REQUIRE( num_events == expected_block_events.at(b) );
+    CHECK( block.at("events").to_long() == static_cast<long>(num_events) );
+    CHECK( block.at("products").to_long()
+      == static_cast<long>(num_products) );
+
+    // Find where each column of this block begins
+    std::vector<size_t> column_offsets;
+    size_t pos = offset + 16u;
+    for ( const auto& col : columns.array_range() ) {
+      column_offsets.push_back( pos );
+      bool per_product = col.at( "length" ).to_string() == "products";
+      pos += col.at( "value_size" ).to_long()
+        * ( per_product ? num_products : num_events );
+    }
+    CHECK( pos == offset + block.at("size").to_long() );
+
+    auto column = [&names, &column_offsets]( const std::string& name ) {
+      return column_offsets.at( column_index(names, name) );
+    };
+
+    size_t product = 0u;
+    for ( size_t e = 0u; e < num_events; ++e, ++event_index ) {
+      const auto& ev = events.at( event_index );
+      CHECK( read_value<int32_t>(data, column("pdgv") + 4*e)
+        == ev.projectile().pdg_code() );
+      CHECK( read_value<double>(data, column("Ev") + 8*e)
+        == Approx(ev.projectile().total_energy()) );
+      CHECK( read_value<int32_t>(data, column("pdgl") + 4*e)
+        == ev.ejectile().pdg_code() );
+      CHECK( read_value<double>(data, column("pzl") + 8*e)
+        == Approx(ev.ejectile().pz()) );
+      CHECK( read_value<double>(data, column("Ex") + 8*e)
+        == Approx(ev.Ex()) );
+      CHECK( read_value<int32_t>(data, column("twoJ") + 4*e) == ev.twoJ() );
+
+      const auto& fparts = ev.get_final_particles();
+      int32_t np = read_value<int32_t>( data, column("np") + 4*e );
+      REQUIRE( np == static_cast<int32_t>(fparts.size()) - 2 );
+      for ( int32_t p = 0; p < np; ++p, ++product ) {
+        const auto* fp = fparts.at( p + 2 );
+        CHECK( read_value<int32_t>(data, column("pdgp") + 4*product)
+          == fp->pdg_code() );
+        CHECK( read_value<double>(data, column("KEp") + 8*product)
+          == Approx(fp->kinetic_energy()) );
+      }
+    }
+    CHECK( product == num_products );
+  }
+  CHECK( event_index == events.size() );
+  CHECK( expected_offset == data.size() - 16 - footer_size );
+
+  // The CSV copy has a header line with the column names followed by one
+  // row per event
+  auto split = []( const std::string& line ) {
+    std::vector<std::string> fields;
+    std::istringstream temp( line );
+    std::string field;
+    while ( std::getline(temp, field, ',') ) fields.push_back( field );
+    return fields;
+  };
+
+  std::istringstream csv_in( csv.str() );
+  std::string line;
+  REQUIRE( std::getline(csv_in, line) );
+  CHECK( split(line) == names );
+  size_t ex_column = column_index( names, "Ex" );
+  size_t rows = 0u;
+  while ( std::getline(csv_in, line) ) {
+    REQUIRE( rows < events.size() );
+    auto fields = split( line );
+    REQUIRE( fields.size() == names.size() );
+    CHECK( std::stod(fields.at(ex_column)) == Approx(events.at(rows).Ex()) );
+    ++rows;
+  }
+  CHECK( rows == events.size() );
+
+  for ( size_t f = 0u; f < file_events.size(); ++f ) {
+    std::remove( input_files.at(f).c_str() );
+  }
+}
@@ -0,0 +1,166 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/NeutrinoSource.hh"
+#include "marley/marley_utils.hh"
+
+namespace {
+
+  // Unnormalized Fermi-Dirac spectrum with a temperature of 3.5 MeV
+  double fermi_dirac(double E) {
+    return E * E / ( 1. + std::exp(E / 3.5) );
+  }
+
+}
+
+TEST_CASE( "Flux file sources read, integrate, and sample tabulated fluxes",
+  "[flux_file]" )
+{
+  constexpr size_t NUM_POINTS = 20001u;
+  constexpr double EMAX = 50.;
+  const std::string text_name( "flux_file_test.dat" );
+  const std::string binary_name( "flux_file_test.bin" );
+
+  // Write the same spectrum in both formats. The text file has an extra
+  // leading column and a comment line.
+  {
+    std::ofstream text_file( text_name );
+    std::ofstream binary_file( binary_name, std::ios::binary );
+    text_file << "# index, energy (MeV), flux\n";
+    text_file.precision( 17 );
+    for ( size_t j = 0u; j < NUM_POINTS; ++j ) {
+      double E = EMAX * j / ( NUM_POINTS - 1u );
+      double flux = fermi_dirac( E );
+      text_file << j << ", " << E << ", " << flux << '\n';
+      binary_file.write( reinterpret_cast<const char*>(&E), sizeof(double) );
+      binary_file.write( reinterpret_cast<const char*>(&flux),
+        sizeof(double) );
+    }
+  }
+
+  using Format = marley::FluxFileNeutrinoSource::Format;
+  using Method = marley::FluxFileNeutrinoSource::Method;
+
+  marley::FluxFileNeutrinoSource text_source( text_name,
+    marley_utils::ELECTRON_NEUTRINO, Format::Text, Method::LinearLinear,
+    1u, 2u );
+  marley::FluxFileNeutrinoSource binary_source( binary_name,
+    marley_utils::ELECTRON_NEUTRINO, Format::Binary );
+
+  REQUIRE( text_source.num_points() == NUM_POINTS );
+  REQUIRE( binary_source.num_points() == NUM_POINTS );
+  CHECK( text_source.total_flux() == binary_source.total_flux() );
+  for ( double E : { 1., 7.3, 20., 49.9 } ) {
+    CHECK( text_source.pdf(E) == binary_source.pdf(E) );
+  }
+
+  // The tabulated moments should agree with quadrature over the grid
+  auto unit = [](double) -> double { return 1.; };
+  auto energy = [](double E) -> double { return E; };
+  CHECK( binary_source.integrate(unit) == Approx(1.).epsilon(1e-12) );
+
+  double mean_E = binary_source.integrate( energy );
+  CHECK( mean_E == Approx( marley_utils::num_integrate( [&](double E)
+    -> double { return E * binary_source.pdf(E); }, 0., EMAX ) ) );
+
+  // The flux-averaged cross section should match the one obtained for the
+  // analytic spectrum
+  marley::JSON config = marley::JSON::load( "{\"seed\": 123,"
+    " \"reactions\": [\"ES.react\"], \"source\": {\"type\": \"file\","
+    " \"neutrino\": \"ve\", \"file\": \"" + binary_name + "\","
+    " \"format\": \"binary\"}}" );
+  marley::JSONConfig jc( config );
+  marley::Generator gen = jc.create_generator();
+
+  marley::FermiDiracNeutrinoSource fd_source(
+    marley_utils::ELECTRON_NEUTRINO, 0., EMAX, 3.5, 0. );
+  double fd_xs = marley_utils::num_integrate( [&](double E) -> double
+    { return fd_source.pdf(E) * gen.total_xs(
+    marley_utils::ELECTRON_NEUTRINO, E); }, 0., EMAX );
+
+  CHECK( gen.flux_averaged_total_xs() == Approx(fd_xs).epsilon(1e-4) );
+
+  // Sampled incident energies should reproduce the tabulated mean
+  constexpr int NUM_SAMPLES = 20000;
+  double sum = 0.;
+  double sum2 = 0.;
+  for ( int s = 0; s < NUM_SAMPLES; ++s ) {
+    int pdg = 0;
+    double E = binary_source.sample_incident_neutrino( pdg, gen );
+    REQUIRE( pdg == marley_utils::ELECTRON_NEUTRINO );
+    REQUIRE( E >= 0. );
+    REQUIRE( E <= EMAX );
+    sum += E;
+    sum2 += E * E;
+  }
+  double sample_mean = sum / NUM_SAMPLES;
+  double sample_sigma = std::sqrt( (sum2 / NUM_SAMPLES
+    - sample_mean * sample_mean) / NUM_SAMPLES );
+  CHECK( std::abs(sample_mean - mean_E) < 5. * sample_sigma );
+
+  // Energies that are not strictly increasing should be rejected
+  {
+    std::ofstream bad_file( text_name );
+    bad_file << "1. 1.\n2. 1.\n2. 1.\n";
+  }
+  CHECK_THROWS_AS( marley::FluxFileNeutrinoSource(text_name),
+    marley::Error );
+
+  std::remove( text_name.c_str() );
+  std::remove( binary_name.c_str() );
+}
+
+TEST_CASE( "Flux file sources integrate coarse tables accurately",
+  "[flux_file]" )
+{
+  const std::string text_name( "flux_file_coarse_test.dat" );
+  {
+    std::ofstream text_file( text_name );
+    text_file << "0. 0.\n10. 2.\n30. 1.\n50. 0.\n";
+  }
+
+  marley::FluxFileNeutrinoSource source( text_name );
+  REQUIRE( source.num_points() == 4u );
+
+  // A weight that is far from linear within each of the wide bins
+  auto weight = [](double E) -> double { return E * E * E; };
+  double expected = marley_utils::num_integrate( [&](double E) -> double
+    { return weight(E) * source.pdf(E); }, 0., 10. )
+    + marley_utils::num_integrate( [&](double E) -> double
+    { return weight(E) * source.pdf(E); }, 10., 30. )
+    + marley_utils::num_integrate( [&](double E) -> double
+    { return weight(E) * source.pdf(E); }, 30., 50. );
+
+  CHECK( source.integrate(weight) == Approx(expected).epsilon(1e-5) );
+
+  std::remove( text_name.c_str() );
+}
@@ -0,0 +1,126 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+
+// Standard library includes
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#ifdef USE_ROOT
+  #include "marley/RootJSONConfig.hh"
+#else
+  #include "marley/JSONConfig.hh"
+#endif
+
+#include "marley/Event.hh"
+#include "marley/EventFileReader.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/OutputFile.hh"
+
+TEST_CASE( "HepMC3 event files can be read back", "[io]" )
+{
+  marley::JSON config = marley::JSON::load( "{\"seed\": 456,"
+    " \"reactions\": [\"ve40ArCC_Bhattacharya2009.react\"],"
+    " \"source\": {\"type\": \"monoenergetic\", \"neutrino\": \"ve\","
+    " \"energy\": 15.0}}" );
+
+  #ifdef USE_ROOT
+    marley::RootJSONConfig jc( config );
+  #else
+    marley::JSONConfig jc( config );
+  #endif
+
+  marley::Generator gen = jc.create_generator();
+  double xsec = gen.flux_averaged_total_xs();
+
+  const std::string file_name( "marley_hepmc3_test.hepmc3" );
+  constexpr int NUM_EVENTS = 5;
+  std::vector<marley::Event> events;
+  {
+    marley::TextOutputFile out( file_name, "hepmc3", "overwrite", true );
+    out.write_flux_avg_tot_xsec( xsec );
+    for ( int e = 0; e < NUM_EVENTS; ++e ) {
+      events.push_back( gen.create_event() );
+      out.write_event( &events.back() );
+    }
+    out.close( config, gen, NUM_EVENTS );
+  }
+
+  // Check the overall layout of the file
+  {
+    std::ifstream in( file_name );
+    std::string line, last_line;
+    std::getline( in, line );
+    CHECK( line.compare(0, 15, "HepMC::Version ") == 0 );
+    std::getline( in, line );
+    CHECK( line == "HepMC::Asciiv3-START_EVENT_LISTING" );
+
+    int num_event_lines = 0;
+    while ( std::getline(in, line) ) {
+      if ( line.compare(0, 2, "E ") == 0 ) ++num_event_lines;
+      if ( !line.empty() ) last_line = line;
+    }
+    CHECK( num_event_lines == NUM_EVENTS );
+    CHECK( last_line == "HepMC::Asciiv3-END_EVENT_LISTING" );
+  }
+
+  marley::EventFileReader efr( file_name );
+  CHECK( efr.flux_averaged_xsec(true) == xsec );
+
+  marley::Event ev;
+  size_t count = 0;
+  while ( efr >> ev ) {
+    REQUIRE( count < events.size() );
+    const marley::Event& orig = events.at( count );
+    CHECK( ev.Ex() == orig.Ex() );
+    CHECK( ev.twoJ() == orig.twoJ() );
+    CHECK( ev.parity() == orig.parity() );
+    CHECK( ev.projectile().pdg_code() == orig.projectile().pdg_code() );
+    CHECK( ev.target().pdg_code() == orig.target().pdg_code() );
+    REQUIRE( ev.final_particle_count() == orig.final_particle_count() );
+    for ( size_t f = 0; f < ev.final_particle_count(); ++f ) {
+      const auto& p = orig.final_particle( f );
+      const auto& rp = ev.final_particle( f );
+      CHECK( rp.pdg_code() == p.pdg_code() );
+      CHECK( rp.px() == Approx(p.px()) );
+      CHECK( rp.py() == Approx(p.py()) );
+      CHECK( rp.pz() == Approx(p.pz()) );
+      CHECK( rp.total_energy() == Approx(p.total_energy()) );
+      CHECK( rp.mass() == Approx(p.mass()) );
+    }
+    ++count;
+  }
+  CHECK( count == events.size() );
+
+  // The GenCrossSection attribute of each event also holds the cross
+  // section (in pb)
+  {
+    std::ifstream in( file_name );
+    double event_xsec = 0.;
+    REQUIRE( ev.read_hepmc3(in, &event_xsec) );
+    CHECK( event_xsec == Approx(xsec) );
+  }
+
+  std::remove( file_name.c_str() );
+}
@@ -0,0 +1,164 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/InterpolationGrid.hh"
+
+using Grid = marley::InterpolationGrid<double>;
+using IMethod = Grid::InterpolationMethod;
+using EMethod = Grid::ExtrapolationMethod;
+
+namespace {
+
+  // Checks that the constant-time lookups and the batch interpolation
+  // routine give exactly the same results as the original binary search
+  void check_grid_agreement(const std::vector<double>& xs,
+    const std::vector<double>& ys, Grid::Spacing expected_spacing)
+  {
+    std::mt19937_64 gen( 123456 );
+    double x_min = xs.front();
+    double x_max = xs.back();
+    double width = x_max - x_min;
+    std::uniform_real_distribution<double> udist( x_min - 0.1*width,
+      x_max + 0.1*width );
+
+    std::vector<double> test_xs( xs );
+    for ( size_t k = 0; k < 5000; ++k ) test_xs.push_back( udist(gen) );
+
+    for ( auto im : { IMethod::Constant, IMethod::LinearLinear,
+      IMethod::LinearLog, IMethod::LogLinear, IMethod::LogLog } )
+    {
+      for ( auto em : { EMethod::Zero, EMethod::Endpoint, EMethod::Continue } )
+      {
+        Grid fast( xs, ys, im, em );
+        REQUIRE( fast.spacing() == expected_spacing );
+
+        // Calling at() disables the lookup tables, so this grid uses the
+        // original binary search for every point
+        Grid slow( xs, ys, im, em );
+        slow.at( 0 );
+
+        std::vector<double> batch_ys = fast.interpolate( test_xs );
+        for ( size_t k = 0; k < test_xs.size(); ++k ) {
+          double x = test_xs.at( k );
+          double expected = slow.interpolate( x );
+          double scalar = fast.interpolate( x );
+          double batch = batch_ys.at( k );
+          // NaN results (e.g., from logarithms of negative numbers) should
+          // also agree
+          if ( std::isnan(expected) ) {
+            CHECK( std::isnan(scalar) );
+            CHECK( std::isnan(batch) );
+          }
+          else {
+            CHECK( scalar == expected );
+            CHECK( batch == expected );
+          }
+        }
+      }
+    }
+  }
+
+}
+
+TEST_CASE( "Interpolation grid lookups agree with binary search",
+  "[interpolation]" )
+{
+  std::vector<double> xs, ys;
+
+  SECTION( "Uniform spacing" ) {
+    for ( size_t j = 0; j <= 100; ++j ) {
+      double x = 0.5 + 0.37*j;
+      xs.push_back( x );
+      ys.push_back( 2. + std::sin(x) );
+    }
+    check_grid_agreement( xs, ys, Grid::Spacing::Uniform );
+  }
+
+  SECTION( "Logarithmic spacing" ) {
+    for ( size_t j = 0; j <= 100; ++j ) {
+      double x = 1e-3 * std::pow(10., 0.05*j);
+      xs.push_back( x );
+      ys.push_back( 1. / (1. + x) );
+    }
+    check_grid_agreement( xs, ys, Grid::Spacing::LogUniform );
+  }
+
+  SECTION( "Irregular spacing" ) {
+    double x = 0.1;
+    for ( size_t j = 0; j <= 100; ++j ) {
+      x += 0.01 + 0.05*(j % 7);
+      xs.push_back( x );
+      ys.push_back( std::exp(-0.1*x) );
+    }
+    check_grid_agreement( xs, ys, Grid::Spacing::Irregular );
+  }
+
+  SECTION( "Irregular spacing with discontinuities" ) {
+    double x = 0.1;
+    for ( size_t j = 0; j <= 100; ++j ) {
+      x += 0.02 + 0.03*(j % 5);
+      xs.push_back( x );
+      ys.push_back( 1. + 0.1*j );
+      // Repeat some of the x values with a different y value
+      if ( j % 9 == 4 ) {
+        xs.push_back( x );
+        ys.push_back( 2. + 0.1*j );
+      }
+    }
+    check_grid_agreement( xs, ys, Grid::Spacing::Irregular );
+  }
+}
+
+TEST_CASE( "Interpolation grid lookups stay current as points are inserted",
+  "[interpolation]" )
+{
+  Grid grid;
+  grid.insert( 0., 0. );
+  grid.insert( 1., 2. );
+  CHECK( grid.interpolate(0.5) == 1. );
+  CHECK( grid.spacing() == Grid::Spacing::Uniform );
+
+  // Each insertion should be reflected in the next lookup
+  grid.insert( 3., 2. );
+  CHECK( grid.interpolate(2.) == 2. );
+  CHECK( grid.spacing() == Grid::Spacing::Irregular );
+
+  grid.insert( 2., 4. );
+  CHECK( grid.interpolate(1.5) == 3. );
+  CHECK( grid.spacing() == Grid::Spacing::Uniform );
+
+  // Changing the interpolation method also refreshes the lookup tables
+  grid.set_interpolationMethod( IMethod::Constant );
+  CHECK( grid.interpolate(1.5) == 2. );
+  grid.set_interpolationMethod( IMethod::LinearLinear );
+  std::vector<double> ys = grid.interpolate( std::vector<double>{ 2.5 } );
+  CHECK( ys.front() == 3. );
+
+  // Copies rebuild their own lookup tables
+  Grid copy( grid );
+  copy.insert( 4., 0. );
+  CHECK( copy.interpolate(3.5) == 1. );
+  CHECK( grid.interpolate(3.5) == 0. );
+}
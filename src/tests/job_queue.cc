@@ -0,0 +1,148 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+
+// Standard library includes
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// POSIX includes
+#include "ftw.h"
+#include "utime.h"
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/JobQueue.hh"
+#include "marley/JSON.hh"
+
+namespace {
+
+  int remove_entry( const char* path, const struct stat*, int, struct FTW* )
+  {
+    return std::remove( path );
+  }
+
+  // Creates an empty scratch directory for a job queue
+  std::string make_queue_directory() {
+    char name[] = "/tmp/marley_job_queue_XXXXXX";
+    REQUIRE( ::mkdtemp(name) );
+    return name;
+  }
+
+  void remove_queue_directory( const std::string& directory ) {
+    ::nftw( directory.c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS );
+  }
+
+  marley::JSON make_description( long events, long events_per_unit ) {
+    marley::JSON description = marley::JSON::object();
+    description[ "events" ] = events;
+    description[ "events_per_unit" ] = events_per_unit;
+    description[ "config" ] = marley::JSON( "test" );
+    return description;
+  }
+
+  void write_unit( const marley::JobQueue& queue,
+    const marley::JobQueue::Unit& unit )
+  {
+    std::ofstream out( queue.unit_output_name(unit, 0u) );
+    out << "header\n";
+    for ( long e = 0; e < unit.num_events; ++e ) {
+      out << unit.first_event + e << '\n';
+    }
+    out.close();
+    queue.complete( unit, { 7 } );
+  }
+}
+
+TEST_CASE( "JobQueue hands out each unit once", "[job_queue]" )
+{
+  std::string directory = make_queue_directory();
+
+  marley::JobQueue queue( directory, make_description(5, 2), 60. );
+  CHECK( queue.num_units() == 3 );
+
+  // A second process uses the stored description
+  marley::JobQueue other( directory, make_description(100, 10), 60. );
+  CHECK( other.num_events() == 5 );
+  CHECK( other.description().at("config").to_string() == "test" );
+
+  marley::JobQueue::Unit a, b, c, d;
+  REQUIRE( queue.claim(a) );
+  REQUIRE( other.claim(b) );
+  REQUIRE( queue.claim(c) );
+  CHECK( a.index == 0 );
+  CHECK( b.index == 1 );
+  CHECK( c.index == 2 );
+  CHECK( c.first_event == 4 );
+  CHECK( c.num_events == 1 );
+
+  // Nothing is left, and none of the claimed units has timed out
+  CHECK_FALSE( other.claim(d) );
+
+  // Released units can be claimed again
+  queue.release( c );
+  REQUIRE( other.claim(d) );
+  CHECK( d.index == 2 );
+
+  // Make unit 1 look abandoned
+  std::ostringstream claimed;
+  claimed << directory << "/job/claimed/unit_0000000001." << other.owner();
+  struct utimbuf old_times = { 0, 0 };
+  REQUIRE( ::utime(claimed.str().c_str(), &old_times) == 0 );
+
+  REQUIRE( queue.claim(b) );
+  CHECK( b.index == 1 );
+
+  write_unit( queue, a );
+  write_unit( queue, b );
+  CHECK( queue.num_done() == 2 );
+  CHECK_FALSE( queue.finished() );
+  CHECK_THROWS( queue.merge({ directory + "/merged.txt" }) );
+
+  remove_queue_directory( directory );
+}
+
+TEST_CASE( "JobQueue merges the unit output files", "[job_queue]" )
+{
+  std::string directory = make_queue_directory();
+  std::string merged_name = directory + "/merged.txt";
+
+  marley::JobQueue queue( directory, make_description(5, 2), 60. );
+  marley::JobQueue::Unit unit;
+  while ( queue.claim(unit) ) write_unit( queue, unit );
+  REQUIRE( queue.finished() );
+  CHECK_FALSE( queue.merged() );
+
+  REQUIRE( queue.merge({ merged_name }) );
+  CHECK( queue.merged() );
+
+  // Only the first unit keeps its header
+  std::ifstream in( merged_name );
+  std::stringstream contents;
+  contents << in.rdbuf();
+  CHECK( contents.str() == "header\n0\n1\n2\n3\n4\n" );
+
+  // The merge is only done once
+  CHECK_FALSE( queue.merge({ merged_name }) );
+
+  remove_queue_directory( directory );
+}
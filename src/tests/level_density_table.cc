@@ -0,0 +1,161 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+
+// Standard library includes
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/BackshiftedFermiGasModel.hh"
+#include "marley/Error.hh"
+#include "marley/GammaStrengthFunctionModel.hh"
+#include "marley/OpticalModel.hh"
+#include "marley/StructureDatabase.hh"
+#include "marley/TabulatedLevelDensityModel.hh"
+#include "marley/marley_utils.hh"
+
+namespace {
+
+  constexpr int NUM_SPINS = 4;
+
+  // Synthetic level density for each parity. The highest spin vanishes at
+  // the lowest excitation energy.
+  double table_rho(double U, int k, bool positive) {
+    if ( k == NUM_SPINS - 1 && U < 0.3 ) return 0.;
+    return ( positive ? 1. : 0.5 ) * ( k + 1 ) * std::exp( 1.5*U );
+  }
+
+  void write_block(std::ofstream& out, int Z, int A, bool positive,
+    const std::vector<double>& Us)
+  {
+    out << " Z=" << Z << " A=" << A << ": "
+      << ( positive ? "Positive" : "Negative" ) << "-Parity\n";
+    out << " ********************\n";
+    out << "  U[MeV]  T[MeV]  NCUMUL   RHOOBS   RHOTOT";
+    for ( int k = 0; k < NUM_SPINS; ++k ) out << "  J=" << k;
+    out << "\n ********************\n";
+    out.precision( 17 );
+    for ( double U : Us ) {
+      double total = 0.;
+      for ( int k = 0; k < NUM_SPINS; ++k ) total += table_rho( U, k,
+        positive );
+      out << U << " 0.5 1.0 " << total << ' ' << total;
+      for ( int k = 0; k < NUM_SPINS; ++k ) {
+        out << ' ' << table_rho( U, k, positive );
+      }
+      out << '\n';
+    }
+    out << '\n';
+  }
+
+}
+
+TEST_CASE( "Tabulated level densities are interpolated from RIPL-style"
+  " tables", "[level_density_table]" )
+{
+  const std::string file_name( "level_density_table_test.tab" );
+
+  // Non-uniform energy nodes that all lie on a 0.25 MeV grid
+  const std::vector<double> Us = { 0.25, 0.5, 0.75, 1., 1.5, 2., 3., 5. };
+  {
+    std::ofstream out( file_name );
+    // A block for a different nuclide that should be ignored
+    write_block( out, 17, 40, true, { 1., 2. } );
+    write_block( out, 17, 39, true, Us );
+    write_block( out, 17, 39, false, Us );
+  }
+
+  // 39Cl has half-integer spins
+  const marley::TabulatedLevelDensityModel ldm( file_name, 17, 39 );
+  const marley::BackshiftedFermiGasModel bfm( 17, 39 );
+  const marley::Parity plus( true ), minus( false );
+
+  REQUIRE( ldm.num_spins() == NUM_SPINS );
+  REQUIRE( ldm.num_nodes() == 20u );
+
+  // The table is reproduced at its nodes
+  for ( double U : Us ) {
+    double total = 0.;
+    for ( int k = 0; k < NUM_SPINS; ++k ) {
+      double rho_p = table_rho( U, k, true );
+      double rho_m = table_rho( U, k, false );
+      total += rho_p + rho_m;
+      CHECK( ldm.level_density(U, 2*k + 1, plus) == Approx(rho_p) );
+      CHECK( ldm.level_density(U, 2*k + 1, minus) == Approx(rho_m) );
+      CHECK( ldm.level_density(U, 2*k + 1) == Approx(rho_p + rho_m) );
+    }
+    CHECK( ldm.level_density(U) == Approx(total) );
+  }
+
+  // Interpolation is logarithmic between nonvanishing nodes and linear
+  // otherwise
+  double rho_2 = table_rho( 2., 1, true );
+  double rho_3 = table_rho( 3., 1, true );
+  CHECK( ldm.level_density(2.5, 3, plus)
+    == Approx(std::sqrt(rho_2 * rho_3)) );
+  CHECK( ldm.level_density(0.375, 2*NUM_SPINS - 1, plus)
+    == Approx(0.5 * table_rho(0.5, NUM_SPINS - 1, true)) );
+
+  // Spins that cannot occur have a vanishing level density. Spins beyond
+  // the table use the back-shifted Fermi gas model.
+  CHECK( ldm.level_density(1., 2, plus) == 0. );
+  CHECK( ldm.level_density(1., 2*NUM_SPINS + 1, minus)
+    == bfm.level_density(1., 2*NUM_SPINS + 1, minus) );
+  CHECK( ldm.level_density(1., 2*NUM_SPINS + 1, minus) > 0. );
+
+  // The back-shifted Fermi gas model is used outside of the table
+  CHECK( ldm.level_density(0.1, 1, plus) == bfm.level_density(0.1, 1, plus) );
+  CHECK( ldm.level_density(7.) == bfm.level_density(7.) );
+
+  // Batches agree with single evaluations
+  for ( double Ex : { 0.3, 1.2, 4.9, 6. } ) {
+    for ( const auto& Pi : { plus, minus } ) {
+      std::vector<double> rhos( NUM_SPINS + 2 );
+      ldm.level_densities( Ex, 1, rhos.size(), Pi, rhos.data() );
+      for ( size_t k = 0u; k < rhos.size(); ++k ) {
+        CHECK( rhos.at(k) == ldm.level_density(Ex,
+          2*static_cast<int>(k) + 1, Pi) );
+      }
+    }
+  }
+
+  // Missing nuclides are reported
+  CHECK_THROWS_AS( marley::TabulatedLevelDensityModel(file_name, 18, 40),
+    marley::Error );
+
+  // Tabulated models may be added to the structure database only before a
+  // model for the same nuclide has been created
+  marley::StructureDatabase sdb;
+  int pdg = marley_utils::get_nucleus_pid( 17, 39 );
+  sdb.add_level_density_model( pdg,
+    std::make_unique<marley::TabulatedLevelDensityModel>(file_name, 17, 39) );
+  CHECK( sdb.get_level_density_model(pdg).level_density(2., 3, plus)
+    == Approx(rho_2) );
+  CHECK_THROWS_AS( sdb.add_level_density_model(pdg,
+    std::make_unique<marley::BackshiftedFermiGasModel>(17, 39)),
+    marley::Error );
+
+  std::remove( file_name.c_str() );
+}
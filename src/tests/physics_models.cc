@@ -0,0 +1,94 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <thread>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/BackshiftedFermiGasModel.hh"
+#include "marley/KoningDelarocheOpticalModel.hh"
+#include "marley/marley_utils.hh"
+
+TEST_CASE( "Physics models may be shared and evaluated in batches",
+  "[models]" )
+{
+  // 39Cl, the remnant after proton emission from 40Ar
+  const marley::KoningDelarocheOpticalModel om( 17, 39 );
+  const marley::BackshiftedFermiGasModel ldm( 17, 39 );
+
+  constexpr int TWO_S = 1;
+  constexpr int L_MAX = 4;
+  std::vector<int> two_js, ls;
+  for ( int l = 0; l <= L_MAX; ++l ) {
+    for ( int two_j = std::abs(2*l - TWO_S); two_j <= 2*l + TWO_S;
+      two_j += 2 )
+    {
+      two_js.push_back( two_j );
+      ls.push_back( l );
+    }
+  }
+
+  const std::vector<double> energies = { 0.5, 2., 7.5 };
+
+  // The batch entry points should reproduce the single evaluations exactly
+  marley::OpticalModel::Workspace ws;
+  std::vector<double> expected;
+  for ( double E : energies ) {
+    std::vector<double> Ts( two_js.size() );
+    om.transmission_coefficients( E, marley_utils::PROTON, TWO_S,
+      two_js.data(), ls.data(), two_js.size(), 0, Ts.data(), ws );
+    for ( size_t w = 0u; w < Ts.size(); ++w ) {
+      double T = om.transmission_coefficient( E, marley_utils::PROTON,
+        two_js[ w ], ls[ w ], TWO_S );
+      CHECK( Ts[ w ] == T );
+      expected.push_back( T );
+    }
+
+    constexpr size_t NUM_SPINS = 8u;
+    double rhos[ NUM_SPINS ];
+    ldm.level_densities( E, 1, NUM_SPINS, marley::Parity(true), rhos );
+    for ( size_t k = 0u; k < NUM_SPINS; ++k ) {
+      CHECK( rhos[ k ] == ldm.level_density(E, 1 + 2*static_cast<int>(k),
+        marley::Parity(true)) );
+    }
+  }
+
+  // Several threads using the same model objects (each with its own
+  // Workspace) should obtain the same results as the serial calculation
+  constexpr int NUM_THREADS = 4;
+  std::vector< std::vector<double> > results( NUM_THREADS );
+  std::vector< std::thread > threads;
+  for ( int t = 0; t < NUM_THREADS; ++t ) {
+    threads.emplace_back( [&, t]() {
+      marley::OpticalModel::Workspace thread_ws;
+      for ( double E : energies ) {
+        for ( size_t w = 0u; w < two_js.size(); ++w ) {
+          results[ t ].push_back( om.transmission_coefficient( E,
+            marley_utils::PROTON, two_js[ w ], ls[ w ], TWO_S, 0,
+            thread_ws ) );
+        }
+      }
+    } );
+  }
+  for ( auto& thread : threads ) thread.join();
+
+  for ( const auto& result : results ) CHECK( result == expected );
+}
@@ -0,0 +1,182 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/ProjectileStream.hh"
+
+namespace {
+
+  using Format = marley::ProjectileStream::Format;
+
+  constexpr int AR40_ATOM = 1000180400;
+
+  std::string to_string( const marley::Event& ev ) {
+    std::ostringstream temp;
+    temp << ev;
+    return temp.str();
+  }
+
+  // Returns a text stream with records for electron neutrinos of
+  // various energies and directions
+  std::string make_records( int num_records ) {
+    std::ostringstream out;
+    out << "# pdg_a KEa pdg_atom dir_x dir_y dir_z time\n";
+    for ( int r = 0; r < num_records; ++r ) {
+      out << "12 " << 10. + 0.5*r << ' ' << AR40_ATOM << ' ' << r % 3
+        << " 1 " << -r << ( r % 2 ? " 1.5\n" : "\n" );
+      if ( r % 5 == 0 ) out << '\n';
+    }
+    return out.str();
+  }
+
+  std::vector<std::string> stream_events( const marley::JSONConfig& jc,
+    const std::string& input, int num_threads, size_t batch_size )
+  {
+    marley::ProjectileStream stream( jc,
+      std::make_unique<std::istringstream>(input), Format::TEXT,
+      num_threads, batch_size );
+
+    std::vector<std::string> result;
+    marley::Event ev;
+    while ( stream.next_event(ev) ) result.push_back( to_string(ev) );
+    CHECK( stream.num_events() == static_cast<long>(result.size()) );
+    return result;
+  }
+
+}
+
+TEST_CASE( "Projectile records are parsed in both formats", "[stream]" )
+{
+  std::istringstream text( "# comment\n\n12 15.5 1000180400 0 0 1\n"
+    "  -12 20 1000060120 1 0 0 3.25\n12 15 1000180400 0 0\n" );
+
+  marley::ProjectileStream::Record rec;
+  long line = 0;
+  REQUIRE( marley::ProjectileStream::read_record(text, Format::TEXT, rec,
+    line) );
+  CHECK( rec.pdg_a == 12 );
+  CHECK( rec.KEa == 15.5 );
+  CHECK( rec.pdg_atom == AR40_ATOM );
+  CHECK( rec.dir_vec[2] == 1. );
+  CHECK( rec.time == 0. );
+  CHECK( line == 3 );
+
+  REQUIRE( marley::ProjectileStream::read_record(text, Format::TEXT, rec,
+    line) );
+  CHECK( rec.pdg_a == -12 );
+  CHECK( rec.pdg_atom == 1000060120 );
+  CHECK( rec.time == 3.25 );
+
+  // Missing direction component
+  CHECK_THROWS_AS( marley::ProjectileStream::read_record(text, Format::TEXT,
+    rec, line), marley::Error );
+  CHECK( !marley::ProjectileStream::read_record(text, Format::TEXT, rec,
+    line) );
+
+  // Null direction
+  std::istringstream null_dir( "12 15 1000180400 0 0 0\n" );
+  CHECK_THROWS_AS( marley::ProjectileStream::read_record(null_dir,
+    Format::TEXT, rec, line), marley::Error );
+
+  // Binary records, including a truncated one at the end
+  std::string binary;
+  for ( int r = 0; r < 2; ++r ) {
+    int32_t pdgs[ 2 ] = { 14, AR40_ATOM };
+    double values[ 5 ] = { 30. + r, 0., 1., 0., 7. };
+    binary.append( reinterpret_cast<const char*>(pdgs), sizeof(pdgs) );
+    binary.append( reinterpret_cast<const char*>(values), sizeof(values) );
+  }
+  REQUIRE( binary.size() == 2*marley::ProjectileStream::RECORD_BYTES );
+  binary.append( "abc" );
+
+  std::istringstream bin_in( binary );
+  line = 0;
+  for ( int r = 0; r < 2; ++r ) {
+    REQUIRE( marley::ProjectileStream::read_record(bin_in, Format::BINARY,
+      rec, line) );
+    CHECK( rec.pdg_a == 14 );
+    CHECK( rec.pdg_atom == AR40_ATOM );
+    CHECK( rec.KEa == 30. + r );
+    CHECK( rec.dir_vec[1] == 1. );
+    CHECK( rec.time == 7. );
+  }
+  CHECK_THROWS_AS( marley::ProjectileStream::read_record(bin_in,
+    Format::BINARY, rec, line), marley::Error );
+}
+
+TEST_CASE( "Projectile streams preserve the input order", "[stream]" )
+{
+  constexpr int NUM_RECORDS = 40;
+  constexpr size_t BATCH_SIZE = 6;
+
+  marley::JSON config = marley::JSON::load( "{\"seed\": 789,"
+    " \"reactions\": [\"ve40ArCC_Bhattacharya2009.react\"]}" );
+  marley::JSONConfig jc( config );
+
+  // Create the expected events directly, starting a new random number
+  // stream for each batch
+  std::string input = make_records( NUM_RECORDS );
+  std::vector<std::string> expected;
+  {
+    marley::Generator gen = jc.create_generator();
+    std::istringstream in( input );
+    marley::ProjectileStream::Record rec;
+    long line = 0;
+    for ( int r = 0; marley::ProjectileStream::read_record(in, Format::TEXT,
+      rec, line); ++r )
+    {
+      if ( r % BATCH_SIZE == 0 ) gen.start_event_stream( r / BATCH_SIZE );
+      marley::Event ev = gen.create_event( rec.pdg_a, rec.KEa, rec.pdg_atom,
+        rec.dir_vec );
+      expected.push_back( to_string(ev) );
+    }
+  }
+  REQUIRE( expected.size() == NUM_RECORDS );
+
+  for ( int num_threads : { 1, 3 } ) {
+    CHECK( stream_events(jc, input, num_threads, BATCH_SIZE) == expected );
+  }
+
+  // A record that cannot be used ends the stream only after the earlier
+  // events have been returned
+  std::string bad_input = input + "12 0.5 1000180400 0 0 1\n"
+    + make_records( 3 );
+  marley::ProjectileStream stream( jc,
+    std::make_unique<std::istringstream>(bad_input), Format::TEXT, 2,
+    BATCH_SIZE );
+  marley::Event ev;
+  long count = 0;
+  CHECK_THROWS_AS( [&]() { while ( stream.next_event(ev) ) ++count; }(),
+    marley::Error );
+  CHECK( count == NUM_RECORDS );
+}
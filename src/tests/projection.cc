@@ -0,0 +1,136 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Event.hh"
+#include "marley/EventFileReader.hh"
+#include "marley/EventProjection.hh"
+#include "marley/JSON.hh"
+#include "marley/MassTable.hh"
+#include "marley/marley_utils.hh"
+
+namespace {
+
+  // Builds a simple event resembling charged-current scattering on 40Ar
+  marley::Event make_test_event() {
+    const auto& mt = marley::MassTable::Instance();
+    double m_e = mt.get_particle_mass( marley_utils::ELECTRON );
+    double m_Ar = mt.get_atomic_mass( 18, 40 );
+    double m_K = mt.get_atomic_mass( 19, 40 ) - m_e;
+
+    marley::Particle nu( marley_utils::ELECTRON_NEUTRINO, 15., 0., 0., 15.,
+      0. );
+    marley::Particle ar( marley_utils::get_nucleus_pid(18, 40), m_Ar, 0 );
+    marley::Particle e( marley_utils::ELECTRON, 1.25, -3.5, 7.125, m_e );
+    marley::Particle k( marley_utils::get_nucleus_pid(19, 40), -1.25, 3.5,
+      7.875, m_K, 1 );
+
+    marley::Event ev( nu, ar, e, k, 2.5, 2, marley::Parity(false) );
+    ev.add_final_particle( marley::Particle(22, 0.5, 0.25, -0.125, 0.) );
+    return ev;
+  }
+
+}
+
+TEST_CASE( "Projected event files can be read back", "[io]" )
+{
+  using Field = marley::EventProjection::Field;
+
+  marley::JSON spec = marley::JSON::load( "{\"event_fields\": [\"Ex\"],"
+    " \"particle_fields\": [\"pdg\", \"px\", \"py\", \"pz\"],"
+    " \"initial_particles\": false }" );
+  marley::EventProjection proj( spec );
+
+  REQUIRE( proj.has(Field::Ex) );
+  REQUIRE( !proj.has(Field::twoJ) );
+  REQUIRE( !proj.has(Field::mass) );
+  REQUIRE( proj.drops_fields() );
+
+  // The JSON representation of the projection should survive a round trip
+  marley::EventProjection proj2( proj.to_json() );
+  REQUIRE( proj2.to_json().dump_string() == proj.to_json().dump_string() );
+
+  marley::Event ev = make_test_event();
+
+  // Checks that the fields kept by the projection are unchanged and that
+  // sensible defaults were used for the rest
+  auto check_event = [&ev]( const marley::Event& read_ev ) {
+    CHECK( read_ev.Ex() == ev.Ex() );
+    CHECK( read_ev.twoJ() == 0 );
+    CHECK( read_ev.initial_particle_count() == 2u );
+    CHECK( read_ev.projectile().pdg_code() == 0 );
+    REQUIRE( read_ev.final_particle_count() == ev.final_particle_count() );
+    for ( size_t f = 0; f < ev.final_particle_count(); ++f ) {
+      const auto& p = ev.final_particle( f );
+      const auto& rp = read_ev.final_particle( f );
+      CHECK( rp.pdg_code() == p.pdg_code() );
+      CHECK( rp.px() == p.px() );
+      CHECK( rp.py() == p.py() );
+      CHECK( rp.pz() == p.pz() );
+      // The 40K atom in the test event has a charge of +1, but the
+      // default charge for an ion is that of the bare nucleus
+      CHECK( rp.charge() == marley_utils::get_particle_charge(p.pdg_code()) );
+      CHECK( rp.total_energy() == Approx( std::sqrt(std::pow(rp.mass(), 2)
+        + std::pow(rp.momentum_magnitude(), 2)) ) );
+    }
+    CHECK( read_ev.ejectile().mass() == Approx( ev.ejectile().mass() ) );
+  };
+
+  SECTION( "JSON format" ) {
+    marley::Event read_ev;
+    read_ev.from_json( ev.to_json(proj), proj );
+    check_event( read_ev );
+
+    // Without the projection, the missing keys should be reported
+    CHECK_THROWS_AS( read_ev.from_json(ev.to_json(proj)), marley::Error );
+  }
+
+  SECTION( "ASCII format" ) {
+    // Write a file in the same way as marley::TextOutputFile
+    const std::string file_name( "marley_projection_test.ascii" );
+    {
+      std::ofstream out( file_name );
+      out << '#' << proj.to_json().dump_string() << '\n';
+      out << "1.5e-20\n";
+      ev.print( out, proj );
+      ev.print( out, proj );
+    }
+
+    marley::EventFileReader efr( file_name );
+    REQUIRE( efr.projection().to_json().dump_string()
+      == proj.to_json().dump_string() );
+    REQUIRE( efr.flux_averaged_xsec(true) == 1.5e-20 );
+
+    marley::Event read_ev;
+    int count = 0;
+    while ( efr >> read_ev ) {
+      check_event( read_ev );
+      ++count;
+    }
+    CHECK( count == 2 );
+
+    std::remove( file_name.c_str() );
+  }
+}
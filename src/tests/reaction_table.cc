@@ -0,0 +1,109 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <cmath>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Event.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/marley_utils.hh"
+
+namespace {
+
+  marley::Generator make_generator( const std::string& reactions,
+    const std::string& extra_config )
+  {
+    marley::JSON config = marley::JSON::load( "{\"seed\": 246,"
+      " \"reactions\": [" + reactions + "], \"do_deexcitations\": false,"
+      " \"source\": {\"type\": \"fermi-dirac\", \"neutrino\": \"ve\","
+      " \"Emin\": 0, \"Emax\": 50, \"temperature\": 3.5}"
+      + extra_config + "}" );
+
+    marley::JSONConfig jc( config );
+    return jc.create_generator();
+  }
+
+}
+
+TEST_CASE( "Reaction tables sample energies and reactions jointly",
+  "[reaction_table]" )
+{
+  constexpr int NUM_EVENTS = 20000;
+  constexpr int NUM_BINS = 10;
+  constexpr double E_MAX = 50.; // MeV
+  constexpr int K40 = 1000190400;
+
+  const std::string both = "\"ve40ArCC_Bhattacharya2009.react\","
+    " \"ES.react\"";
+  marley::Generator gen = make_generator( both,
+    ", \"reaction_table_bins\": 40" );
+  marley::Generator ref_gen = make_generator( both, "" );
+  marley::Generator cc_gen = make_generator(
+    "\"ve40ArCC_Bhattacharya2009.react\"", "" );
+
+  CHECK( gen.reaction_table_bins() == 40 );
+  CHECK( ref_gen.reaction_table_bins() == 0 );
+
+  // The table does not change the flux-averaged total cross section
+  CHECK( gen.flux_averaged_total_xs()
+    == Approx(ref_gen.flux_averaged_total_xs()) );
+
+  // Expected fraction of the events in each energy bin and expected
+  // fraction of the events due to the charged-current reaction
+  std::vector<double> expected_fractions;
+  double width = E_MAX / NUM_BINS;
+  for ( int b = 0; b < NUM_BINS; ++b ) {
+    expected_fractions.push_back( marley_utils::num_integrate(
+      [&ref_gen]( double E ) -> double { return ref_gen.E_pdf( E ); },
+      b * width, (b + 1) * width ) );
+  }
+  double cc_fraction = cc_gen.flux_averaged_total_xs()
+    / ref_gen.flux_averaged_total_xs();
+  REQUIRE( cc_fraction > 0. );
+  REQUIRE( cc_fraction < 1. );
+
+  std::vector<int> counts( NUM_BINS, 0 );
+  int cc_count = 0;
+  for ( int e = 0; e < NUM_EVENTS; ++e ) {
+    marley::Event ev = gen.create_event();
+    double E = ev.projectile().total_energy();
+    int b = static_cast<int>( E / width );
+    REQUIRE( b >= 0 );
+    REQUIRE( b < NUM_BINS );
+    ++counts.at( b );
+    if ( ev.residue().pdg_code() == K40 ) ++cc_count;
+  }
+
+  auto check_count = []( int count, double fraction ) {
+    double expected = fraction * NUM_EVENTS;
+    double sigma = std::sqrt( expected * (1. - fraction) );
+    CHECK( std::abs(count - expected) < 5.*sigma + 1. );
+  };
+
+  for ( int b = 0; b < NUM_BINS; ++b ) {
+    check_count( counts.at(b), expected_fractions.at(b) );
+  }
+  check_count( cc_count, cc_fraction );
+}
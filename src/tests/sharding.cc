@@ -0,0 +1,126 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#ifdef USE_ROOT
+  #include "marley/RootJSONConfig.hh"
+#else
+  #include "marley/JSONConfig.hh"
+#endif
+#include "marley/Event.hh"
+#include "marley/EventFileReader.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/OutputFile.hh"
+#include "marley/ShardedOutputFile.hh"
+
+TEST_CASE( "Sharded output files can be read as one dataset", "[io]" )
+{
+  marley::JSON config = marley::JSON::load( "{\"seed\": 123,"
+    " \"reactions\": [\"ve40ArCC_Bhattacharya2009.react\"],"
+    " \"source\": {\"type\": \"monoenergetic\", \"neutrino\": \"ve\","
+    " \"energy\": 15.0}}" );
+
+  #ifdef USE_ROOT
+    marley::RootJSONConfig jc( config );
+  #else
+    marley::JSONConfig jc( config );
+  #endif
+
+  marley::Generator gen = jc.create_generator();
+
+  auto factory = []( const std::string& name )
+    -> std::unique_ptr<marley::OutputFile>
+  {
+    return std::make_unique<marley::TextOutputFile>( name, "ascii",
+      "overwrite", true );
+  };
+
+  // Two lanes that each roll over after three events
+  constexpr int NUM_EVENTS = 10;
+  marley::ShardedOutputFile out( "marley_sharding_test.ascii", "ascii",
+    "overwrite", true, factory, 2, 3 );
+  out.set_generator( config, gen );
+  out.write_flux_avg_tot_xsec( gen.flux_averaged_total_xs() );
+
+  std::vector<std::string> events;
+  for ( int e = 0; e < NUM_EVENTS; ++e ) {
+    marley::Event ev = gen.create_event();
+    out.write_event( &ev );
+    std::ostringstream temp;
+    temp << ev;
+    events.push_back( temp.str() );
+  }
+  out.close( config, gen, NUM_EVENTS );
+
+  // Events alternate between the lanes, so the shards hold the events
+  // {0, 2, 4}, {1, 3, 5}, {6, 8}, and {7, 9}
+  const std::vector<long> expected_first = { 0, 1, 6, 7 };
+  const std::vector<long> expected_count = { 3, 3, 2, 2 };
+
+  std::ifstream manifest_file( out.manifest_name() );
+  marley::JSON manifest = marley::JSON::load( manifest_file );
+  const auto& shards = manifest.at( "manifest" ).at( "shards" );
+  REQUIRE( shards.length() == 4 );
+  for ( int s = 0; s < 4; ++s ) {
+    CHECK( shards.at(s).at("first_event").to_long() == expected_first.at(s) );
+    CHECK( shards.at(s).at("stride").to_long() == 2 );
+    CHECK( shards.at(s).at("num_events").to_long() == expected_count.at(s) );
+  }
+
+  // The reader should restore the original order of the events
+  marley::EventFileReader efr( out.manifest_name() );
+  CHECK( efr.flux_averaged_xsec(true) == gen.flux_averaged_total_xs() );
+
+  marley::Event ev;
+  size_t count = 0;
+  while ( efr >> ev ) {
+    REQUIRE( count < events.size() );
+    std::ostringstream temp;
+    temp << ev;
+    CHECK( temp.str() == events.at(count) );
+    ++count;
+  }
+  CHECK( count == events.size() );
+
+  // Every shard entry must give its stride
+  std::string bad_manifest = manifest.dump_string();
+  size_t stride_pos = bad_manifest.find( "\"stride\"" );
+  REQUIRE( stride_pos != std::string::npos );
+  bad_manifest.replace( stride_pos, 8, "\"spacing\"" );
+  const std::string bad_name = "marley_sharding_test_bad.ascii.manifest";
+  {
+    std::ofstream bad_file( bad_name );
+    bad_file << bad_manifest;
+  }
+  marley::EventFileReader bad_efr( bad_name );
+  CHECK_THROWS( bad_efr >> ev );
+
+  for ( size_t s = 0; s < 4; ++s ) std::remove( out.shard_name(s).c_str() );
+  std::remove( out.manifest_name().c_str() );
+  std::remove( bad_name.c_str() );
+}
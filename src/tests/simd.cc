@@ -0,0 +1,118 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/ChebyshevInterpolatingFunction.hh"
+#include "marley/marley_simd.hh"
+
+namespace {
+
+  // The barycentric formula evaluated by the scalar loop used before the
+  // SIMD kernels were added
+  double sequential_evaluate( const marley::ChebyshevInterpolatingFunction&
+    cheb, double x )
+  {
+    double numer = 0.;
+    double denom = 0.;
+    double w_j = -1.;
+    for ( int j = 0; j <= cheb.N(); ++j ) {
+      w_j = -w_j;
+      double x_j = cheb.Xs().at( j );
+      double f_j = cheb.Fs().at( j );
+      if ( x_j == x ) return f_j;
+      double temp = w_j / ( x - x_j );
+      if ( j == 0 || j == cheb.N() ) temp /= 2.;
+      denom += temp;
+      numer += temp * f_j;
+    }
+    return numer / denom;
+  }
+
+}
+
+TEST_CASE( "SIMD kernel variants give identical results", "[simd]" )
+{
+  using Level = marley_simd::Level;
+  const Level selected = marley_simd::active_level();
+
+  // Use grid sizes that do and do not fill the vectorized loop evenly
+  for ( size_t N : { 5u, 64u, 101u } ) {
+
+    marley::ChebyshevInterpolatingFunction cheb( [](double x) -> double
+      { return std::sin(x) * std::exp(-x); }, 0., 3., N );
+
+    std::vector<double> xs;
+    for ( int k = 0; k <= 1000; ++k ) xs.push_back( 3. * k / 1000. );
+    xs.insert( xs.end(), cheb.Xs().cbegin(), cheb.Xs().cend() );
+
+    // The generic kernel reproduces the sequential sums exactly, while the
+    // vectorized kernels agree exactly with each other
+    std::vector<double> vectorized;
+    for ( Level level : { Level::GENERIC, Level::SSE4_2, Level::AVX2,
+      Level::AVX512 } )
+    {
+      if ( level > marley_simd::detected_level() ) break;
+      marley_simd::set_level( level );
+
+      std::vector<double> values;
+      for ( double x : xs ) values.push_back( cheb.evaluate(x) );
+
+      if ( level == Level::GENERIC ) {
+        std::vector<double> sequential;
+        for ( double x : xs ) sequential.push_back(
+          sequential_evaluate(cheb, x) );
+        CHECK( values == sequential );
+      }
+      else if ( vectorized.empty() ) vectorized = values;
+      else CHECK( values == vectorized );
+
+      // Grid points reproduce the stored function values exactly
+      for ( int j = 0; j <= cheb.N(); ++j ) {
+        CHECK( cheb.evaluate(cheb.Xs().at(j)) == cheb.Fs().at(j) );
+      }
+
+      if ( N == 64u ) {
+        for ( double x : xs ) {
+          CHECK( cheb.evaluate(x) == Approx(std::sin(x) * std::exp(-x))
+            .margin(1e-12) );
+        }
+      }
+    }
+  }
+
+  marley_simd::set_level( selected );
+}
+
+TEST_CASE( "The generic SIMD level is used by default", "[simd]" )
+{
+  using Level = marley_simd::Level;
+  const char* env = std::getenv( "MARLEY_SIMD" );
+  if ( !env || !*env ) {
+    CHECK( marley_simd::active_level() == Level::GENERIC );
+  }
+  CHECK( marley_simd::level_from_name("native")
+    == marley_simd::detected_level() );
+  CHECK_THROWS( marley_simd::level_from_name("sse9") );
+}
@@ -0,0 +1,69 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/JSON.hh"
+#include "marley/StartupProfile.hh"
+
+TEST_CASE( "StartupProfile records nested phases", "[startup]" )
+{
+  size_t num_old = marley::StartupProfile::records().size();
+
+  // Phases are ignored while the profile is disabled
+  { marley::StartupProfile::Phase ignored( "ignored" ); }
+  CHECK( marley::StartupProfile::records().size() == num_old );
+
+  marley::StartupProfile::enable();
+  auto start = marley::StartupProfile::sample();
+  {
+    marley::StartupProfile::Phase outer( "outer" );
+    marley::StartupProfile::Phase inner( "inner" );
+    std::vector<double> work( 100000, 1. );
+    CHECK( work.back() == 1. );
+  }
+  auto stop = marley::StartupProfile::sample();
+  marley::StartupProfile::record( "recorded", start, stop );
+  marley::StartupProfile::disable();
+
+  auto recs = marley::StartupProfile::records();
+  REQUIRE( recs.size() == num_old + 3u );
+
+  const auto& outer = recs.at( num_old );
+  const auto& inner = recs.at( num_old + 1u );
+  const auto& recorded = recs.at( num_old + 2u );
+  CHECK( outer.name == "outer" );
+  CHECK( outer.depth == 0 );
+  CHECK( inner.name == "inner" );
+  CHECK( inner.depth == 1 );
+  CHECK( recorded.depth == 0 );
+  CHECK( outer.wall >= inner.wall );
+  CHECK( recorded.wall >= outer.wall );
+
+  // No allocation counter was supplied
+  CHECK( outer.allocations == -1 );
+
+  marley::JSON json = marley::StartupProfile::to_json();
+  CHECK( json.length() == static_cast<int>(recs.size()) );
+  CHECK( json.at(num_old + 1u).at("name").to_string() == "inner" );
+  CHECK_FALSE( json.at(num_old).has_key("allocations") );
+}
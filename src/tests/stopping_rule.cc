@@ -0,0 +1,89 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <cmath>
+#include <random>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Event.hh"
+#include "marley/JSON.hh"
+#include "marley/Particle.hh"
+#include "marley/StoppingRule.hh"
+#include "marley/marley_utils.hh"
+
+TEST_CASE( "Merged accumulators match a single pass", "[stopping]" )
+{
+  std::mt19937_64 rng( 42 );
+  std::normal_distribution<double> dist( 3., 2. );
+
+  marley::StoppingRule::Accumulator all, first, second;
+  for ( int k = 0; k < 1000; ++k ) {
+    double x = dist( rng );
+    all.add( x );
+    if ( k < 300 ) first.add( x );
+    else second.add( x );
+  }
+  first.merge( second );
+
+  CHECK( first.count == all.count );
+  CHECK( first.mean == Approx(all.mean) );
+  CHECK( first.variance() == Approx(all.variance()) );
+  CHECK( all.relative_error() == Approx(std::sqrt(all.variance() / 1000.)
+    / all.mean) );
+}
+
+TEST_CASE( "Precision targets are checked against event estimates",
+  "[stopping]" )
+{
+  marley::StoppingRule rule( marley::JSON::load(
+    "{\"targets\": [{\"observable\": \"fraction\", \"particle\": 2112,"
+    " \"precision\": 0.05}, {\"observable\": \"fraction\","
+    " \"variable\": \"Ex\", \"range\": [0, 5], \"precision\": 0.05}],"
+    " \"check_interval\": 10}" ) );
+
+  CHECK( rule.check_interval() == 10 );
+  CHECK( rule.max_time() == 0. );
+
+  // Half of the events have a neutron, and a quarter have Ex <= 5 MeV
+  marley::Particle neutron( marley_utils::NEUTRON, 939.565 );
+  for ( int k = 0; k < 4000; ++k ) {
+    marley::Event ev( k % 4 == 0 ? 2. : 10. );
+    if ( k % 2 == 0 ) ev.add_final_particle( neutron );
+    rule.add_event( ev );
+    if ( k == 50 ) CHECK_FALSE( rule.targets_met() );
+  }
+
+  // Relative errors: sqrt(0.5*0.5/4000)/0.5 = 0.016 and
+  // sqrt(0.25*0.75/4000)/0.25 = 0.027
+  CHECK( rule.num_events() == 4000 );
+  CHECK( rule.targets_met() );
+
+  marley::StoppingRule copy( rule );
+  copy.merge( rule );
+  CHECK( copy.num_events() == 8000 );
+
+  CHECK_THROWS( marley::StoppingRule(marley::JSON::load(
+    "{\"targets\": [{\"observable\": \"mean\", \"variable\": \"bogus\","
+    " \"precision\": 0.1}]}")) );
+
+  CHECK_THROWS( marley::StoppingRule(marley::JSON::load(
+    "{\"targets\": []}")) );
+}
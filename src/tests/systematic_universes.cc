@@ -0,0 +1,289 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/EventProjection.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/MassTable.hh"
+#include "marley/SystematicUniverses.hh"
+#include "marley/marley_utils.hh"
+
+namespace {
+
+  // Job configuration used by the tests below (with an optional array of
+  // universes)
+  marley::JSON make_config( const std::string& universes ) {
+    std::string config = "{\"seed\": 4321,"
+      " \"reactions\": [\"ve40ArCC_Bhattacharya2009.react\"],"
+      " \"source\": {\"type\": \"fermi-dirac\", \"neutrino\": \"ve\","
+      " \"Emin\": 0, \"Emax\": 50, \"temperature\": 5}";
+    if ( !universes.empty() ) config += ", \"universes\": " + universes;
+    return marley::JSON::load( config + '}' );
+  }
+
+  // Creates a set of universes from the text of a JSON array
+  marley::SystematicUniverses make_universes( const std::string& array ) {
+    marley::JSON json = marley::JSON::load( "{\"universes\": " + array
+      + '}' );
+    return marley::SystematicUniverses( json.at("universes") );
+  }
+
+}
+
+TEST_CASE( "Systematic universes are configured using JSON", "[universes]" )
+{
+  marley::SystematicUniverses su = make_universes( "["
+    " {\"name\": \"gt_up\", \"gt_scale\": 1.1},"
+    " {\"coulomb_mode\": \"Fermi\", \"width_scales\": {\"n\": 1.5},"
+    "  \"continuum_scale\": 0.5},"
+    " {\"throws\": 4, \"seed\": 5, \"sigma\": {\"fermi_scale\": 0.1}},"
+    " {\"name\": \"hot\", \"level_density_slope\": -0.25} ]" );
+
+  REQUIRE( su.size() == 7u );
+  std::vector<std::string> expected_names = { "gt_up", "universe_1",
+    "random_0", "random_1", "random_2", "random_3", "hot" };
+  CHECK( su.names() == expected_names );
+
+  const auto& u1 = su.universes().at( 1 );
+  CHECK( u1.has_coulomb_mode );
+  CHECK( u1.width_scales.at(1) == 1.5 );
+  CHECK( u1.continuum_scale == 0.5 );
+  CHECK( u1.level_density_slope == 0. );
+  CHECK( su.universes().at(6).level_density_slope == -0.25 );
+
+  // Only the parameters with a nonzero standard deviation should vary
+  const auto& thrown = su.universes().at( 2 );
+  CHECK( thrown.gt_scale == 1. );
+  CHECK( thrown.fermi_scale != 1. );
+
+  // The throws depend only on the seed
+  marley::SystematicUniverses su2 = make_universes( "[ {\"throws\": 4,"
+    " \"seed\": 5, \"sigma\": {\"fermi_scale\": 0.1}} ]" );
+  CHECK( su2.universes().at(3).fermi_scale
+    == su.universes().at(5).fermi_scale );
+
+  // Thrown level density slopes are centered on zero
+  marley::SystematicUniverses su3 = make_universes( "[ {\"throws\": 20,"
+    " \"sigma\": {\"level_density_slope\": 0.1}} ]" );
+  bool negative = false;
+  bool positive = false;
+  for ( const auto& u : su3.universes() ) {
+    if ( u.level_density_slope < 0. ) negative = true;
+    if ( u.level_density_slope > 0. ) positive = true;
+  }
+  CHECK( negative );
+  CHECK( positive );
+
+  CHECK_THROWS( make_universes("[ {\"gt_scale\": -1} ]") );
+  CHECK_THROWS( make_universes("[ {\"level_density_slope\": \"x\"} ]") );
+  CHECK_THROWS( make_universes("[ {\"width_scales\": {\"x\": 2}} ]") );
+  CHECK_THROWS( make_universes("[ {\"name\": \"a\"}, {\"name\": \"a\"} ]") );
+  CHECK_THROWS( make_universes("[ {\"name\": \"a b\"} ]") );
+  CHECK_THROWS( make_universes("{\"gt_scale\": 2}") );
+}
+
+TEST_CASE( "Systematic weights leave the sampled events unchanged",
+  "[universes]" )
+{
+  constexpr int NUM_EVENTS = 300;
+
+  marley::JSONConfig jc_nominal( make_config("") );
+  marley::Generator gen_nominal = jc_nominal.create_generator();
+
+  // Scaling every partial width by the same factor does not change the
+  // branching ratios, so the "uniform" universe should always give a
+  // weight of one
+  marley::JSONConfig jc( make_config("[ {\"name\": \"same\"},"
+    " {\"name\": \"uniform\", \"width_scales\": {\"gamma\": 2, \"n\": 2,"
+    " \"p\": 2, \"d\": 2, \"t\": 2, \"he3\": 2, \"alpha\": 2}},"
+    " {\"name\": \"gt\", \"gt_scale\": 1.5},"
+    " {\"name\": \"no_coulomb\", \"coulomb_mode\": \"none\"},"
+    " {\"name\": \"neutrons\", \"width_scales\": {\"n\": 2}},"
+    " {\"name\": \"hot\", \"level_density_slope\": -0.25} ]") );
+  marley::Generator gen = jc.create_generator();
+
+  REQUIRE( gen.get_universes().size() == 6u );
+
+  double sum_n = 0.;
+  double sum_n2 = 0.;
+  double sum_hot = 0.;
+  double sum_hot2 = 0.;
+  bool hot_reweighted = false;
+  for ( int e = 0; e < NUM_EVENTS; ++e ) {
+    marley::Event ev_nominal = gen_nominal.create_event();
+    marley::Event ev = gen.create_event();
+
+    std::ostringstream out_nominal, out;
+    out_nominal << ev_nominal;
+    out << ev;
+    CHECK( out.str() == out_nominal.str() );
+
+    CHECK( ev_nominal.weights().empty() );
+
+    const auto& w = ev.weights();
+    REQUIRE( w.size() == 6u );
+    CHECK( w.at(0) == 1. );
+    CHECK( w.at(1) == Approx(1.) );
+    CHECK( ( w.at(2) == 1. || w.at(2) == Approx(1.5) ) );
+
+    // The Fermi function exceeds one for an outgoing electron
+    CHECK( w.at(3) > 0. );
+    CHECK( w.at(3) < 1. );
+
+    CHECK( std::isfinite(w.at(4)) );
+    CHECK( w.at(4) > 0. );
+    sum_n += w.at( 4 );
+    sum_n2 += std::pow( w.at(4), 2 );
+
+    CHECK( std::isfinite(w.at(5)) );
+    CHECK( w.at(5) > 0. );
+    if ( w.at(5) != 1. ) hot_reweighted = true;
+    sum_hot += w.at( 5 );
+    sum_hot2 += std::pow( w.at(5), 2 );
+  }
+
+  // The mean weight for a universe that changes only the branching ratios
+  // or the shape of the continuum spectrum should be one within
+  // statistical errors
+  auto check_mean = []( double sum, double sum2 ) {
+    double mean = sum / NUM_EVENTS;
+    double std_dev = std::sqrt( sum2 / NUM_EVENTS - mean*mean );
+    CHECK( std::abs(mean - 1.) <= 5. * std_dev / std::sqrt(NUM_EVENTS)
+      + 1e-12 );
+  };
+  check_mean( sum_n, sum_n2 );
+  check_mean( sum_hot, sum_hot2 );
+  CHECK( hot_reweighted );
+}
+
+TEST_CASE( "Systematic weights are written to every text format",
+  "[universes]" )
+{
+  const auto& mt = marley::MassTable::Instance();
+  double m_e = mt.get_particle_mass( marley_utils::ELECTRON );
+  double m_Ar = mt.get_atomic_mass( 18, 40 );
+  double m_K = mt.get_atomic_mass( 19, 40 ) - m_e;
+
+  marley::Particle nu( marley_utils::ELECTRON_NEUTRINO, 15., 0., 0., 15.,
+    0. );
+  marley::Particle ar( marley_utils::get_nucleus_pid(18, 40), m_Ar, 0 );
+  marley::Particle e( marley_utils::ELECTRON, 1.25, -3.5, 7.125, m_e );
+  marley::Particle k( marley_utils::get_nucleus_pid(19, 40), -1.25, 3.5,
+    7.875, m_K, 1 );
+
+  marley::Event ev( nu, ar, e, k, 2.5, 2, marley::Parity(false) );
+  ev.weights() = { 1.25, 0.5, 2., 0.75, 1., 3.5 };
+
+  marley::EventProjection proj;
+  proj.set_weight_names( { "a", "b", "c", "d", "e", "f" } );
+  REQUIRE( !proj.is_complete() );
+
+  // Native ASCII format (via the projection, which is also stored in the
+  // file header)
+  {
+    marley::EventProjection proj2( proj.to_json() );
+    REQUIRE( proj2.weight_names() == proj.weight_names() );
+
+    std::stringstream temp;
+    ev.print( temp, proj );
+    marley::Event read_ev;
+    read_ev.read( temp, proj2 );
+    CHECK( read_ev.weights() == ev.weights() );
+    CHECK( read_ev.Ex() == ev.Ex() );
+  }
+
+  // HEPEVT records have no place for the weights. Only the particles and
+  // the usual MARLEY dummy particle are counted in the header.
+  {
+    std::stringstream temp;
+    ev.write_hepevt( 0, 1e-20, temp, proj );
+    CHECK( temp.str().find("\n12 ") == std::string::npos );
+    int event_num, num_particles;
+    temp >> event_num >> num_particles;
+    CHECK( static_cast<size_t>(num_particles) == 1
+      + ev.initial_particle_count() + ev.final_particle_count() );
+    temp.seekg( 0 );
+    marley::Event read_ev;
+    REQUIRE( read_ev.read_hepevt(temp) );
+    CHECK( read_ev.weights().empty() );
+    CHECK( read_ev.final_particle_count() == ev.final_particle_count() );
+  }
+
+  // Weight entries in HEPEVT records are still read, but their indices must
+  // fit within the record
+  {
+    std::ostringstream temp;
+    ev.write_hepevt( 0, 1e-20, temp, proj );
+    std::string record = temp.str();
+    std::string header = record.substr( 0, record.find('\n') + 1 );
+    std::string body = record.substr( header.size() );
+    int num_particles = std::stoi( header.substr(header.find(' ') + 1) );
+
+    auto with_weights = [&]( const std::string& weight_line ) {
+      return "0 " + std::to_string( num_particles + 1 ) + '\n'
+        + weight_line + body;
+    };
+
+    std::istringstream good( with_weights("12 0 2 3 0 0 1.5 0.25 2. 0. 0."
+      " 0. 0. 0. 0.\n") );
+    marley::Event read_ev;
+    REQUIRE( read_ev.read_hepevt(good) );
+    CHECK( read_ev.weights() == std::vector<double>({ 0., 0., 1.5, 0.25,
+      2. }) );
+
+    std::istringstream bad( with_weights("12 0 2000000000 1 0 0 1.5 0. 0."
+      " 0. 0. 0. 0. 0. 0.\n") );
+    CHECK_THROWS_AS( read_ev.read_hepevt(bad), marley::Error );
+  }
+
+  // HepMC3
+  {
+    std::stringstream temp;
+    ev.write_hepmc3( 0, 1e-20, temp, proj );
+    marley::Event read_ev;
+    REQUIRE( read_ev.read_hepmc3(temp) );
+    CHECK( read_ev.weights() == ev.weights() );
+  }
+
+  // JSON
+  {
+    marley::Event read_ev;
+    read_ev.from_json( ev.to_json(proj), proj );
+    CHECK( read_ev.weights() == ev.weights() );
+  }
+
+  // Events without weights should keep the original layouts
+  marley::Event unweighted( ev );
+  unweighted.weights().clear();
+  std::ostringstream hepevt;
+  unweighted.write_hepevt( 0, 1e-20, hepevt, marley::EventProjection() );
+  CHECK( hepevt.str().find("\n12 ") == std::string::npos );
+  CHECK( !unweighted.to_json().has_key("weights") );
+}
@@ -0,0 +1,95 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+
+// Standard library includes
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/marley_utils.hh"
+
+TEST_CASE( "Batch total cross sections match single-energy values",
+  "[total_xs]" )
+{
+  marley::JSON config = marley::JSON::load( "{\"seed\": 123,"
+    " \"target\": {\"nuclides\": [1000180400, 1000060120],"
+    " \"atom_fractions\": [0.7, 0.3]},"
+    " \"reactions\": [\"ve40ArCC_Bhattacharya2009.react\", \"ES.react\","
+    " \"CEvNS40Ar.react\"],"
+    " \"source\": {\"type\": \"monoenergetic\", \"neutrino\": \"ve\","
+    " \"energy\": 15.0}}" );
+
+  marley::JSONConfig jc( config );
+  const marley::Generator gen = jc.create_generator();
+
+  const auto& fractions = gen.get_target().atom_fraction_map();
+  size_t num_atoms = fractions.size();
+  size_t num_reacts = gen.get_reactions().size();
+  REQUIRE( num_atoms == 2u );
+
+  // Include energies below threshold and unphysical values
+  std::vector<double> energies = { -1., 0., 1e-3, 2., 5.5, 10., 25., 80. };
+  std::vector<int> pdgs = { marley_utils::ELECTRON_NEUTRINO,
+    marley_utils::ELECTRON_ANTINEUTRINO, marley_utils::MUON_NEUTRINO };
+  size_t num_energies = energies.size();
+
+  std::vector<double> total( num_energies );
+  std::vector<double> per_reaction( num_energies * num_reacts );
+  std::vector<double> per_target( num_energies * num_atoms );
+
+  for ( int pdg : pdgs ) {
+    gen.total_xs( pdg, energies.data(), num_energies, total.data(),
+      per_reaction.data(), per_target.data() );
+
+    for ( size_t i = 0u; i < num_energies; ++i ) {
+      CHECK( total.at(i) == gen.total_xs(pdg, energies.at(i)) );
+      for ( size_t j = 0u; j < num_reacts; ++j ) {
+        CHECK( per_reaction.at(i*num_reacts + j)
+          == gen.get_reactions().at(j)->total_xs(pdg, energies.at(i)) );
+      }
+      size_t k = 0u;
+      for ( const auto& pair : fractions ) {
+        CHECK( per_target.at(i*num_atoms + k) == gen.total_xs(pdg,
+          energies.at(i), pair.first.pdg()) );
+        ++k;
+      }
+    }
+  }
+
+  // The mixed-projectile overload should agree with the fixed one
+  std::vector<int> mixed_pdgs;
+  std::vector<double> mixed_energies;
+  for ( int pdg : pdgs ) {
+    mixed_pdgs.insert( mixed_pdgs.end(), num_energies, pdg );
+    mixed_energies.insert( mixed_energies.end(), energies.begin(),
+      energies.end() );
+  }
+  std::vector<double> mixed_total( mixed_energies.size() );
+  gen.total_xs( mixed_pdgs.data(), mixed_energies.data(),
+    mixed_energies.size(), mixed_total.data() );
+
+  for ( size_t i = 0u; i < mixed_energies.size(); ++i ) {
+    CHECK( mixed_total.at(i) == gen.total_xs(mixed_pdgs.at(i),
+      mixed_energies.at(i)) );
+  }
+}
@@ -0,0 +1,59 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <cstdio>
+#include <string>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/JSON.hh"
+#include "marley/Tracer.hh"
+
+TEST_CASE( "Tracer records spans for the sampled events", "[tracer]" )
+{
+  const std::string file_name( "test_trace.json" );
+  marley::Tracer::enable( file_name, 0.25 );
+
+  int traced = 0;
+  for ( int e = 0; e < 100; ++e ) {
+    marley::Tracer::begin_event();
+    if ( marley::Tracer::event_traced() ) ++traced;
+    marley::Tracer::Span outer( "outer" );
+    marley::Tracer::Span inner( "inner", { {"event", double(e)} } );
+  }
+  CHECK( traced == 25 );
+
+  // Two spans per traced event
+  CHECK( marley::Tracer::write() == 50u );
+  CHECK_FALSE( marley::Tracer::enabled() );
+
+  const marley::JSON trace = marley::JSON::load_file( file_name );
+  const auto& events = trace.at( "traceEvents" );
+  // One metadata record for the thread name, then the spans
+  CHECK( events.length() == 51 );
+  CHECK( events.at(1u).at("name").to_string() == "inner" );
+  CHECK( events.at(1u).at("args").at("event").to_double() == 0. );
+
+  std::remove( file_name.c_str() );
+
+  // Spans are ignored while tracing is disabled
+  marley::Tracer::begin_event();
+  CHECK_FALSE( marley::Tracer::event_traced() );
+}
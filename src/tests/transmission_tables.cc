@@ -0,0 +1,111 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+
+// Standard library includes
+#include <memory>
+#include <random>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/GammaStrengthFunctionModel.hh"
+#include "marley/KoningDelarocheOpticalModel.hh"
+#include "marley/LevelDensityModel.hh"
+#include "marley/StructureDatabase.hh"
+#include "marley/TableBuilder.hh"
+#include "marley/TabulatedOpticalModel.hh"
+#include "marley/marley_utils.hh"
+
+TEST_CASE( "Transmission coefficient tables are built in the background",
+  "[transmission_tables]" )
+{
+  constexpr int L_MAX = 3;
+  constexpr double E_MAX = 30.; // MeV
+  constexpr double TOLERANCE = 1e-3;
+  constexpr int TWO_S = 1;
+  const int pdg = marley_utils::PROTON;
+
+  marley::TableBuilder builder( 1 );
+
+  // 39Ar, the remnant after proton emission from 40K
+  const marley::KoningDelarocheOpticalModel direct( 18, 39 );
+  const marley::TabulatedOpticalModel om(
+    std::make_unique<marley::KoningDelarocheOpticalModel>(18, 39), builder,
+    L_MAX, E_MAX, TOLERANCE );
+
+  // Until the table is published, the direct calculation is used
+  CHECK( om.transmission_coefficient(5., pdg, 1, 0, TWO_S)
+    == direct.transmission_coefficient(5., pdg, 1, 0, TWO_S) );
+  CHECK( builder.num_submitted() == 1u );
+
+  builder.wait();
+  REQUIRE( builder.num_built() == 1u );
+  REQUIRE( om.has_table(pdg) );
+  CHECK( om.num_cells(pdg) >= marley::TabulatedOpticalModel::INITIAL_CELLS );
+  CHECK( !om.has_table(marley_utils::NEUTRON) );
+
+  std::vector<int> two_js, ls;
+  for ( int l = 0; l <= L_MAX + 1; ++l ) {
+    for ( int two_j = std::abs(2*l - TWO_S); two_j <= 2*l + TWO_S;
+      two_j += 2 )
+    {
+      two_js.push_back( two_j );
+      ls.push_back( l );
+    }
+  }
+
+  // The tabulated values agree with the direct calculation. The tolerance
+  // is checked at the cell midpoints, so allow a bit of extra room
+  // elsewhere.
+  std::mt19937_64 gen( 12345 );
+  std::uniform_real_distribution<double> E_dist( 0.5, E_MAX );
+  std::vector<double> Ts( two_js.size() );
+  marley::OpticalModel::Workspace ws;
+  for ( int trial = 0; trial < 200; ++trial ) {
+    double E = E_dist( gen );
+    om.transmission_coefficients( E, pdg, TWO_S, two_js.data(), ls.data(),
+      two_js.size(), 0, Ts.data(), ws );
+    for ( size_t w = 0u; w < two_js.size(); ++w ) {
+      double T = direct.transmission_coefficient( E, pdg, two_js[w], ls[w],
+        TWO_S );
+      CHECK( Ts[w] == om.transmission_coefficient(E, pdg, two_js[w], ls[w],
+        TWO_S) );
+      // Waves above the maximum orbital angular momentum are not tabulated
+      if ( ls[w] > L_MAX ) CHECK( Ts[w] == T );
+      else CHECK( std::abs(Ts[w] - T) <= 2. * TOLERANCE
+        * std::max(T, marley::TabulatedOpticalModel::MIN_RELEVANT_T) );
+    }
+  }
+
+  // Energies beyond the table also use the direct calculation
+  CHECK( om.transmission_coefficient(40., pdg, 1, 0, TWO_S)
+    == direct.transmission_coefficient(40., pdg, 1, 0, TWO_S) );
+
+  // Optical models already wrapped by a StructureDatabase refer to its
+  // TableBuilder, so the tables may only be enabled once
+  marley::StructureDatabase sdb;
+  sdb.enable_transmission_tables( TOLERANCE, E_MAX, 1 );
+  const auto* sdb_builder = sdb.table_builder();
+  CHECK( sdb_builder != nullptr );
+  CHECK_THROWS_AS( sdb.enable_transmission_tables(TOLERANCE, E_MAX, 1),
+    marley::Error );
+  CHECK( sdb.table_builder() == sdb_builder );
+}
@@ -0,0 +1,115 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+// Standard library includes
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Event.hh"
+#include "marley/EventFileReader.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/VirtualOutputFile.hh"
+
+namespace {
+
+  std::string to_string( const marley::Event& ev ) {
+    std::ostringstream temp;
+    temp << ev;
+    return temp.str();
+  }
+
+}
+
+TEST_CASE( "Virtual event files regenerate the original events",
+  "[virtual]" )
+{
+  constexpr long NUM_EVENTS = 30;
+  constexpr long EVENTS_PER_BLOCK = 7;
+  const std::string file_name = "test_virtual_events.json";
+
+  marley::JSON config = marley::JSON::load( "{\"seed\": 456,"
+    " \"reactions\": [\"ve40ArCC_Bhattacharya2009.react\"],"
+    " \"source\": {\"type\": \"monoenergetic\", \"neutrino\": \"ve\","
+    " \"energy\": 15.0}}" );
+
+  marley::JSONConfig jc( config );
+  marley::Generator gen = jc.create_generator();
+
+  std::vector<std::string> expected;
+  std::vector<double> expected_Ex;
+  {
+    marley::VirtualOutputFile vf( file_name, "overwrite", true,
+      EVENTS_PER_BLOCK, { "Ex" } );
+    vf.write_flux_avg_tot_xsec( gen.flux_averaged_total_xs() );
+
+    for ( long e = 0; e < NUM_EVENTS; ++e ) {
+      if ( e % EVENTS_PER_BLOCK == 0 ) {
+        gen.start_event_stream( e / EVENTS_PER_BLOCK );
+      }
+      marley::Event ev = gen.create_event();
+      expected.push_back( to_string(ev) );
+      expected_Ex.push_back( ev.Ex() );
+      vf.write_event( &ev );
+    }
+    vf.close( config, gen, NUM_EVENTS );
+  }
+
+  marley::EventFileReader reader( file_name );
+  reader.set_num_threads( 2 );
+
+  CHECK( reader.flux_averaged_xsec(true)
+    == Approx(gen.flux_averaged_total_xs()) );
+
+  const auto& Ex = reader.summary().at( "Ex" );
+  REQUIRE( Ex.length() == NUM_EVENTS );
+  for ( long e = 0; e < NUM_EVENTS; ++e ) {
+    CHECK( Ex.at(e).to_double() == Approx(expected_Ex.at(e)) );
+  }
+
+  marley::Event ev;
+  long count = 0;
+  while ( reader.next_event(ev) ) {
+    REQUIRE( count < NUM_EVENTS );
+    CHECK( to_string(ev) == expected.at(count) );
+    ++count;
+  }
+  CHECK( count == NUM_EVENTS );
+
+  // The stream operator should also deliver every event
+  REQUIRE( reader.seek_event(0) );
+  count = 0;
+  while ( reader >> ev ) ++count;
+  CHECK( count == NUM_EVENTS );
+
+  // Seek backwards into the middle of a block, then across blocks
+  for ( long index : { 17l, 3l, 29l } ) {
+    REQUIRE( reader.seek_event(index) );
+    REQUIRE( reader.next_event(ev) );
+    CHECK( to_string(ev) == expected.at(index) );
+  }
+  CHECK( !reader.seek_event(NUM_EVENTS + 1) );
+
+  std::remove( file_name.c_str() );
+}